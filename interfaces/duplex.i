@@ -164,5 +164,12 @@ std::vector<duplex_list_t>  aliduplex_subopt(std::vector<std::string> alignment1
 %ignore duplex_subopt;
 %ignore aliduplexfold;
 %ignore aliduplex_subopt;
+%ignore vrna_duplex_context_s;
+%ignore vrna_duplex_context_init;
+%ignore vrna_duplex_context_free;
+%ignore vrna_duplexfold;
+%ignore vrna_duplex_subopt;
+%ignore vrna_aliduplexfold;
+%ignore vrna_aliduplex_subopt;
 
 %include <ViennaRNA/duplex.h>
@@ -37,6 +37,8 @@ typedef struct {
   double  sfact;
   int     rtype[8];
   short   alias[MAXALPHA+1];
+  int     num_threads;
+  int     pf_float;
 } vrna_md_t;
 
 /* make a nice object oriented interface to vrna_md_t */
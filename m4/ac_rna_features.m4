@@ -452,10 +452,13 @@ Please consider using the successor option --enable-simd instead.
 
   AS_IF([test "x$enable_simd" != "xno"],[
     ## Check for all supported SIMD features first
+    ## Floating point contractions (FMA) are disabled for all SIMD
+    ## implementations to keep their results identical to the default
+    ## implementation
     AC_MSG_CHECKING([compiler support for AVX 512 instructions])
 
     ac_save_CFLAGS="$CFLAGS"
-    CFLAGS="$ac_save_CFLAGS -Werror -mavx512f"
+    CFLAGS="$ac_save_CFLAGS -Werror -mavx512f -ffp-contract=off"
     AC_LANG_PUSH([C])
 
     AC_COMPILE_IFELSE(
@@ -478,7 +481,39 @@ Please consider using the successor option --enable-simd instead.
       AC_MSG_RESULT([yes])
       AC_DEFINE([VRNA_WITH_SIMD_AVX512], [1], [use AVX 512 implementations])
       ac_simd_capability_avx512f=yes
-      SIMD_AVX512_FLAGS="-mavx512f"
+      SIMD_AVX512_FLAGS="-mavx512f -ffp-contract=off"
+    ],
+    [
+      AC_MSG_RESULT([no])
+    ])
+
+    AC_LANG_POP([C])
+    CFLAGS="$ac_save_CFLAGS"
+
+    AC_MSG_CHECKING([compiler support for AVX 2 instructions])
+
+    ac_save_CFLAGS="$CFLAGS"
+    CFLAGS="$ac_save_CFLAGS -Werror -mavx2 -ffp-contract=off"
+    AC_LANG_PUSH([C])
+
+    AC_COMPILE_IFELSE(
+    [
+      AC_LANG_PROGRAM([[
+                        #include <immintrin.h>
+                        #include <limits.h>
+                      ]],
+                        [[__m256i a = _mm256_set1_epi32(INT_MAX);
+                          __m256i b = _mm256_set1_epi32(INT_MIN);
+                          __m256d c = _mm256_set1_pd(1.);
+                          b = _mm256_min_epi32(a, b);
+                          c = _mm256_mul_pd(c, c);
+                      ]])
+    ],
+    [
+      AC_MSG_RESULT([yes])
+      AC_DEFINE([VRNA_WITH_SIMD_AVX2], [1], [use AVX 2 implementations])
+      ac_simd_capability_avx2=yes
+      SIMD_AVX2_FLAGS="-mavx2 -ffp-contract=off"
     ],
     [
       AC_MSG_RESULT([no])
@@ -490,7 +525,7 @@ Please consider using the successor option --enable-simd instead.
     AC_MSG_CHECKING([compiler support for SSE 4.1 instructions])
 
     ac_save_CFLAGS="$CFLAGS"
-    CFLAGS="$ac_save_CFLAGS -Werror -msse4.1"
+    CFLAGS="$ac_save_CFLAGS -Werror -msse4.1 -ffp-contract=off"
     AC_LANG_PUSH([C])
 
     AC_COMPILE_IFELSE(
@@ -508,7 +543,7 @@ Please consider using the successor option --enable-simd instead.
       AC_MSG_RESULT([yes])
       AC_DEFINE([VRNA_WITH_SIMD_SSE41], [1], [use SSE 4.1 implementations])
       ac_simd_capability_sse41=yes
-      SIMD_SSE41_FLAGS="-msse4.1"
+      SIMD_SSE41_FLAGS="-msse4.1 -ffp-contract=off"
     ],
     [
       AC_MSG_RESULT([no])
@@ -519,8 +554,10 @@ Please consider using the successor option --enable-simd instead.
   ])
 
   AC_SUBST(SIMD_AVX512_FLAGS)
+  AC_SUBST(SIMD_AVX2_FLAGS)
   AC_SUBST(SIMD_SSE41_FLAGS)
   AM_CONDITIONAL(VRNA_AM_SWITCH_SIMD_AVX512, test "x$ac_simd_capability_avx512f" = "xyes")
+  AM_CONDITIONAL(VRNA_AM_SWITCH_SIMD_AVX2, test "x$ac_simd_capability_avx2" = "xyes")
   AM_CONDITIONAL(VRNA_AM_SWITCH_SIMD_SSE41, test "x$ac_simd_capability_sse41" = "xyes")
 ])
 
@@ -32,6 +32,8 @@
 #define MYTURN 1
 #define SAME_STRAND(I,J) (((I)>=cut_point)||((J)<cut_point))
 #define ORDER(x,y) if ((x)->nummer>(y)->nummer) {tempb=x; x=y; y=tempb;}
+/* group of neighbors of the loop closed by x (0 for the exterior loop) */
+#define LOOP(x) ((x)->nummer+1)
 
 /* item of structure ringlist */
 typedef struct _baum {
@@ -53,8 +55,14 @@ static baum *rl = NULL;         /* ringlist */
 static baum *wurzl = NULL;      /* virtualroot of ringlist-tree */
 static char **ptype = NULL;
 
+/* concurrent simulations keep their own ringlist-tree */
+#ifdef _OPENMP
+#pragma omp threadprivate(pairList, typeList, aliasList, rl, wurzl, ptype)
+#endif
+
 static int comp_struc(const void *A, const void *B);
 /* PUBLIC FUNCTIONES */
+void ini_start_stop (void);
 void ini_or_reset_rl (void);
 void move_it (void);
 void update_tree (int i, int j);
@@ -73,6 +81,7 @@ static void inb_nolp (baum *root);
 static void dnb (baum *rli);
 static void dnb_nolp (baum *rli);
 static void fnb (baum *rli);
+static void mark_loop (baum *root);
 static void make_ptypes(const short *S);
 /* debugging tool(s) */
 #if 0
@@ -204,6 +213,67 @@ static void ini_ringlist(void) {
 
 }
 
+/* energies of start and stop structure(s), needed once for all simulations */
+void ini_start_stop(void) {
+
+#if HAVE_LIBRNA_API3
+  GSV.currE = GSV.startE = vrna_eval_structure(GAV.vc, GAV.startform);
+#else
+  GSV.currE = GSV.startE = energy_of_structure(GAV.farbe, GAV.startform, 0);
+#endif
+
+  /* stop structure(s) */
+  if ( GTV.stop )  {
+    int i;
+
+    qsort(GAV.stopform, GSV.maxS, sizeof(char *), comp_struc);
+#if HAVE_LIBRNA_API3
+    /*
+      note that we need to hack the full length into GAV.vc again,
+      in case it was shortened due to chain growth simulation
+    */
+    unsigned int n, tmp_n;
+    n     = strlen(GAV.farbe_full);
+    tmp_n = GAV.vc->length;
+    GAV.vc->length = n;
+    for (i = 0; i< GSV.maxS; i++)
+      GAV.sE[i] = vrna_eval_structure(GAV.vc, GAV.stopform[i]);
+    GAV.vc->length = tmp_n;
+#else
+    for (i = 0; i< GSV.maxS; i++)
+      GAV.sE[i] = energy_of_structure(GAV.farbe_full, GAV.stopform[i], 0);
+#endif
+  }
+  else {
+#if HAVE_LIBRNA_API3
+    /* fold sequence to get Minimum free energy structure (Mfe) */
+    /*
+      note that we need to hack the full length into GAV.vc again,
+      in case it was shortened due to chain growth simulation
+    */
+    unsigned int n, tmp_n;
+    n     = strlen(GAV.farbe_full);
+    tmp_n = GAV.vc->length;
+    GAV.vc->length = n;
+    GAV.sE[0] = vrna_mfe_dimer(GAV.vc, GAV.stopform[0]);
+    vrna_mx_mfe_free(GAV.vc);
+    /* revaluate energy of Mfe (maye differ if --logML=logarthmic */
+    GAV.sE[0] = vrna_eval_structure(GAV.vc, GAV.stopform[0]);
+    GAV.vc->length = tmp_n;
+#else
+    if(GTV.noLP)
+      noLonelyPairs=1;
+    initialize_cofold(GSV.len);
+    /* fold sequence to get Minimum free energy structure (Mfe) */
+    GAV.sE[0] = cofold(GAV.farbe_full, GAV.stopform[0]);
+    free_arrays();
+    /* revaluate energy of Mfe (maye differ if --logML=logarthmic */
+    GAV.sE[0] = energy_of_structure(GAV.farbe_full, GAV.stopform[0], 0);
+#endif
+  }
+  GSV.stopE = GAV.sE[0];
+}
+
 /**/
 void ini_or_reset_rl(void) {
 
@@ -219,57 +289,7 @@ void ini_or_reset_rl(void) {
     GSV.currE = GSV.startE = energy_of_structure(GAV.farbe, GAV.startform, 0);
 #endif
 
-    /* stop structure(s) */
-    if ( GTV.stop )  {
-      int i;
-
-      qsort(GAV.stopform, GSV.maxS, sizeof(char *), comp_struc);
-#if HAVE_LIBRNA_API3
-      /*
-        note that we need to hack the full length into GAV.vc again,
-        in case it was shortened due to chain growth simulation
-      */
-      unsigned int n, tmp_n;
-      n     = strlen(GAV.farbe_full);
-      tmp_n = GAV.vc->length;
-      GAV.vc->length = n;
-      for (i = 0; i< GSV.maxS; i++)
-        GAV.sE[i] = vrna_eval_structure(GAV.vc, GAV.stopform[i]);
-      GAV.vc->length = tmp_n;
-#else
-      for (i = 0; i< GSV.maxS; i++)
-	GAV.sE[i] = energy_of_structure(GAV.farbe_full, GAV.stopform[i], 0);
-#endif
-    }
-    else {
-#if HAVE_LIBRNA_API3
-      /* fold sequence to get Minimum free energy structure (Mfe) */
-      /*
-        note that we need to hack the full length into GAV.vc again,
-        in case it was shortened due to chain growth simulation
-      */
-      unsigned int n, tmp_n;
-      n     = strlen(GAV.farbe_full);
-      tmp_n = GAV.vc->length;
-      GAV.vc->length = n;
-      GAV.sE[0] = vrna_mfe_dimer(GAV.vc, GAV.stopform[0]);
-      vrna_mx_mfe_free(GAV.vc);
-      /* revaluate energy of Mfe (maye differ if --logML=logarthmic */
-      GAV.sE[0] = vrna_eval_structure(GAV.vc, GAV.stopform[0]);
-      GAV.vc->length = tmp_n;
-#else
-      if(GTV.noLP)
-	noLonelyPairs=1;
-      initialize_cofold(GSV.len);
-      /* fold sequence to get Minimum free energy structure (Mfe) */
-      GAV.sE[0] = cofold(GAV.farbe_full, GAV.stopform[0]);
-      free_arrays();
-      /* revaluate energy of Mfe (maye differ if --logML=logarthmic */
-      GAV.sE[0] = energy_of_structure(GAV.farbe_full, GAV.stopform[0], 0);
-#endif
-    }
-    GSV.stopE = GAV.sE[0];
-    ini_nbList(strlen(GAV.farbe_full)*strlen(GAV.farbe_full));
+    ini_nbList(strlen(GAV.farbe_full)+1);
   }
   else {
     /* reset ringlist-tree to start conditions */
@@ -279,6 +299,9 @@ void ini_or_reset_rl(void) {
       GSV.currE = GSV.startE;
     }
   }
+
+  /* neighbors have to be generated from scratch */
+  mark_nbGroup(-1);
 }
 
 /**/
@@ -290,6 +313,7 @@ static void reset_ringlist(void) {
     GAV.prevform[i] = 'x';
     pairList[i+1] = 0;
     rl[i].typ = 'u';
+    rl[i].loop_energy = 0;
     rl[i].next = &rl[i + 1];
     rl[i].prev = ((i == 0) ? &rl[GSV.len] : &rl[i - 1]);
     rl[i].up = rl[i].down = NULL;
@@ -297,6 +321,13 @@ static void reset_ringlist(void) {
   rl[i].next = &rl[0];
   rl[i].prev = &rl[i-1];
   rl[i].up = wurzl;
+
+  /* loop energies of the previous simulation are stale */
+#if HAVE_LIBRNA_API3
+  wurzl->loop_energy = vrna_eval_loop_pt(GAV.vc, 0, pairList);
+#else
+  wurzl->loop_energy = loop_energy(pairList, typeList, aliasList, 0);
+#endif
 }
 
 /* update ringlist-tree */
@@ -747,9 +778,11 @@ static void fnb(baum *rli) {
 }
 
 /* for a given tree (structure),
-   generate all neighbours according to moveset */
+   generate all neighbours according to moveset
+   (only the ones of loops marked by update_tree()) */
 void move_it (void) {
-  int i;
+  int g;
+  baum *rli;
   
 #if HAVE_LIBRNA_API3
   GSV.currE = (float)vrna_eval_structure_pt(GAV.vc, pairList)/100.;
@@ -757,30 +790,44 @@ void move_it (void) {
   GSV.currE =
     energy_of_struct_pt_par(GAV.farbe, pairList, typeList, aliasList, GAV.params, 0)/100.;
 #endif
-  
-  if ( GTV.noLP ) { /* canonical neighbours only */
-    inb_nolp(wurzl);
-    for (i = 0; i < GSV.len; i++) {
-      
-      if (pairList[i+1]>i+1) {
-	inb_nolp(rl+i);      /* insert pair neighbours */
-	dnb_nolp(rl+i);  /* delete pair neighbour */
-      }
+
+  /* canonical neighbours depend on the adjacent loops as well */
+  if ( GTV.noLP ) mark_nbGroup(-1);
+
+  while ((g = next_nbGroup()) >= 0) {
+    if (g == 0) { /* exterior loop */
+      if ( GTV.noLP ) inb_nolp(wurzl);
+      else inb(wurzl);
+      continue;
     }
-  }
-  else { /* all neighbours */
-    inb(wurzl);
-    for (i = 0; i < GSV.len; i++) {
-      
-      if (pairList[i+1]>i+1) {
-	inb(rl+i); 	 /* insert pair neighbours */
-	dnb(rl+i);  /* delete pair neighbour */
-	if ( GTV.noShift == 0 ) fnb(rl+i);
-      }
+    if (g > GSV.len) continue;
+    rli = rl + g - 1;
+    if (rli->typ != 'p') continue; /* base pair was opened */
+
+    if ( GTV.noLP ) { /* canonical neighbours only */
+      inb_nolp(rli);      /* insert pair neighbours */
+      dnb_nolp(rli);  /* delete pair neighbour */
+    }
+    else { /* all neighbours */
+      inb(rli); 	 /* insert pair neighbours */
+      dnb(rli);  /* delete pair neighbour */
+      if ( GTV.noShift == 0 ) fnb(rli);
     }
   }
 }
 
+/*
+  moves in the loop closed by root and moves of the base pairs
+  in this loop depend on the energy of the loop
+*/
+static void mark_loop(baum *root) {
+  baum *stop, *rli;
+
+  mark_nbGroup(LOOP(root));
+  stop = root->down;
+  for (rli = stop->next; rli != stop; rli = rli->next)
+    if (rli->typ == 'p') mark_nbGroup(LOOP(rli));
+}
 
 /**/
 void clean_up_rl(void) {
@@ -790,8 +837,10 @@ void clean_up_rl(void) {
   free(aliasList); aliasList = NULL;
   free(rl); rl=NULL;
   free(wurzl);  wurzl=NULL;
-  for (i=0; i<=GSV.len; i++)
-    free(ptype[i]);
+  /* GSV.len may have changed due to chain growth simulation */
+  if (ptype)
+    for (i=0; ptype[i]; i++)
+      free(ptype[i]);
   free(ptype);
   ptype=NULL;
 }
@@ -866,6 +915,9 @@ static void close_bp_en (baum *i, baum *j) {
 #else
   r->up->loop_energy = loop_energy(pairList,typeList,aliasList,r->up->nummer+1);
 #endif
+
+  mark_loop(i);
+  mark_loop(r->up);
 };
 
 static void open_bp_en (baum *i) {
@@ -879,4 +931,7 @@ static void open_bp_en (baum *i) {
 #else
   r->up->loop_energy = loop_energy(pairList,typeList,aliasList,r->up->nummer+1);
 #endif
+
+  mark_nbGroup(LOOP(i));
+  mark_loop(r->up);
 };
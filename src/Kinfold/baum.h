@@ -10,6 +10,7 @@
 #define BAUM_H
 
 /* used in main.c */
+extern void ini_start_stop(void);
 extern void ini_or_reset_rl(void);
 extern void move_it(void);
 extern void clean_up_rl(void);
@@ -11,6 +11,11 @@
 #include <stdlib.h>
 #include <math.h>
 #include <string.h>
+#include <stdint.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 #if HAVE_LIBRNA_API3
 #include <ViennaRNA/utils.h>
@@ -27,119 +32,337 @@
 #endif
 
 /*
-  modify cache_f(), cache_comp() and the typedef of cache_entry
-  in cache_utils.h to suit your application
+  The cache maps structures to their neighborhoods. Structures are
+  stored as packed keys with 2 bits per position. The entries of the
+  cache are kept in a list ordered by their last use, and the least
+  recently used ones are evicted as soon as the memory limit is
+  exceeded. To allow for concurrent simulations, the cache is split
+  into independently locked shards, each of which receives an equal
+  share of the memory limit.
 */
 
+typedef struct _cache_node {
+  uint64_t hash;
+  int len;                    /* length of the structure */
+  size_t size;                /* memory occupied by this entry */
+  cache_entry *data;
+  struct _cache_node *chain;  /* next entry in the same bucket */
+  struct _cache_node *prev;   /* neighbors in the list of recently used entries */
+  struct _cache_node *next;
+  uint64_t key[1];            /* packed structure, KEY_CHARS positions per word */
+} cache_node;
+
+typedef struct {
+  cache_node **table;
+  unsigned long mask;         /* number of buckets - 1 */
+  unsigned long num;          /* number of entries */
+  size_t bytes;               /* memory occupied by the entries */
+  cache_node lru;             /* lru.next is the most, lru.prev the least recently used entry */
+#ifdef _OPENMP
+  omp_lock_t lock;
+#endif
+} cache_shard;
+
 /* PUBLIC FUNCTIONES */
-cache_entry *lookup_cache (char *x);
-int write_cache (cache_entry *x);
-/*  void delete_cache (cache_entry *x); */
+int lookup_cache (char *x, void (*get)(cache_entry *c));
+int write_cache (char *x, cache_entry *c);
+void initialize_cache(size_t max_bytes, int threads);
 void kill_cache();
-void initialize_cache();
 
 /* PRIVATE FUNCTIONES */
-/*  static int cache_comp(cache_entry *x, cache_entry *y); */
-INLINE static unsigned cache_f (char *x);
-
-/* #define CACHESIZE 67108864 -1 */ /* 2^26 -1   must be power of 2 -1 */
-/* #define CACHESIZE 33554432 -1 */ /* 2^25 -1   must be power of 2 -1 */
-/* #define CACHESIZE 16777216 -1 */ /* 2^24 -1   must be power of 2 -1 */ 
-/* #define CACHESIZE  4194304 -1 */ /* 2^22 -1   must be power of 2 -1 */
-#define CACHESIZE  1048576 -1  /* 2^20 -1   must be power of 2 -1 */
-/* #define CACHESIZE   262144 -1 */ /* 2^18 -1   must be power of 2 -1 */
-/* next is default */
-/* #define CACHESIZE    65536 -1 */ /* 2^16 -1   must be power of 2 -1 */
-/* #define CACHESIZE    16384 -1 */ /* 2^14 -1   must be power of 2 -1 */
-/* #define CACHESIZE     4096 -1 */ /* 2^12 -1   must be power of 2 -1 */
-
-static cache_entry *cachetab[CACHESIZE+1];
+INLINE static uint64_t key_word (const char *x, int len, int w);
+INLINE static uint64_t cache_f (const char *x, int len);
+static cache_node *find_node (cache_shard *s, const char *x, int len, uint64_t hash);
+static void insert_node (cache_shard *s, cache_node *c);
+static void remove_node (cache_shard *s, cache_node *c);
+static void free_node (cache_node *c);
+static void free_entry (cache_entry *c);
+static void grow_table (cache_shard *s);
+
+#define KEY_CHARS  32    /* positions per key word */
+#define BUCKETS    1024  /* initial number of buckets per shard, must be power of 2 */
+#define MAX_SHARDS 256   /* must be power of 2 */
+#define BUCKET(s,h) (((h) >> 8) & (s)->mask)
+
+static cache_shard *shards = NULL;
+static int num_shards = 0;
+static size_t shard_bytes = 0;  /* memory limit per shard */
 static char UNUSED rcsid[] ="$Id: cache.c,v 1.3 2006/10/04 12:45:12 xtof Exp $";
-unsigned long collisions=0;
-
-/* stolen from perl source */
-char coeff[] = {
-                61,59,53,47,43,41,37,31,29,23,17,13,11,7,3,1,
-                61,59,53,47,43,41,37,31,29,23,17,13,11,7,3,1,
-                61,59,53,47,43,41,37,31,29,23,17,13,11,7,3,1,
-                61,59,53,47,43,41,37,31,29,23,17,13,11,7,3,1,
-                61,59,53,47,43,41,37,31,29,23,17,13,11,7,3,1,
-                61,59,53,47,43,41,37,31,29,23,17,13,11,7,3,1,
-                61,59,53,47,43,41,37,31,29,23,17,13,11,7,3,1,
-                61,59,53,47,43,41,37,31,29,23,17,13,11,7,3,1};
-
-/* key must not be longer than 128 */
-INLINE static unsigned cache_f(char *x) { 
-  register char *s;
-  register int i;
-  register unsigned cache;
-
-  s = x;
-
-  for (i=0,    cache = 0;
-       /* while */ *s;
-       s++,           i++ , cache *= 5 ) {
-    cache += *s * coeff[i];
+
+/* pack positions w*KEY_CHARS to (w+1)*KEY_CHARS-1 of structure x */
+INLINE static uint64_t key_word(const char *x, int len, int w) {
+  register int i, first;
+  register uint64_t word;
+
+  first = w * KEY_CHARS;
+  i = first + KEY_CHARS;
+  if (i > len) i = len;
+
+  for (word = 0; --i >= first; ) {
+    word <<= 2;
+    if (x[i] == '(') word |= 1;
+    else if (x[i] == ')') word |= 2;
   }
 
-   /* divide through CACHESIZE for normalization */
-  return ((cache) & (CACHESIZE));
+  return word;
 }
 
+INLINE static uint64_t cache_f(const char *x, int len) {
+  int w;
+  uint64_t cache;
+
+  for (w = 0, cache = (uint64_t)len; w * KEY_CHARS < len; w++) {
+    cache ^= key_word(x, len, w);
+    cache *= 0xff51afd7ed558ccdULL;
+    cache ^= cache >> 32;
+  }
 
-/* returns NULL unless x is in the cache */
-cache_entry *lookup_cache (char *x) {
-  int cacheval;
-  cache_entry *c;
+  cache ^= cache >> 33;
+  cache *= 0xc4ceb9fe1a85ec53ULL;
+  cache ^= cache >> 33;
 
-  cacheval=cache_f(x);
-  if ((c=cachetab[cacheval]))
-    if (strcmp(c->structure,x)==0) return c;
-  
-  return NULL;
+  return cache;
 }
 
-/* returns 1 if x already was in the cache */
-int write_cache (cache_entry *x) {
-  int cacheval;
-  cache_entry *c;
-  
-  cacheval=cache_f(x->structure);
-  if ((c=cachetab[cacheval])) {
-    free(c->structure);
-    free(c->neighbors);
-    free(c->rates);
-    free(c->energies);
-    free(c);
+/* returns 0 unless x is in the cache, otherwise its entry is passed to get() */
+int lookup_cache (char *x, void (*get)(cache_entry *c)) {
+  int len, found = 0;
+  uint64_t hash;
+  cache_shard *s;
+  cache_node *c;
+
+  if (shards == NULL) return 0;
+
+  len = strlen(x);
+  hash = cache_f(x, len);
+  s = shards + (hash & (num_shards - 1));
+
+#ifdef _OPENMP
+  omp_set_lock(&(s->lock));
+#endif
+
+  if ((c = find_node(s, x, len, hash))) {
+    /* move entry to the front of the list */
+    c->prev->next = c->next;
+    c->next->prev = c->prev;
+    c->next = s->lru.next;
+    c->prev = &(s->lru);
+    s->lru.next->prev = c;
+    s->lru.next = c;
+    get(c->data);
+    found = 1;
   }
-  cachetab[cacheval]=x;
-  return 0;
+
+#ifdef _OPENMP
+  omp_unset_lock(&(s->lock));
+#endif
+
+  return found;
+}
+
+/* returns 1 if x already was in the cache, c is taken over in any case */
+int write_cache (char *x, cache_entry *c) {
+  int w, len, words, found = 0;
+  size_t size;
+  uint64_t hash;
+  cache_shard *s;
+  cache_node *n;
+
+  len = strlen(x);
+  words = (len + KEY_CHARS - 1) / KEY_CHARS;
+  size = sizeof(cache_node) + words * sizeof(uint64_t) + sizeof(cache_entry) +
+         c->groups * sizeof(int) +
+         c->top * (2 * sizeof(short) + sizeof(float) + sizeof(int));
+
+  /* entry does not fit into the cache at all */
+  if ((shards == NULL) || (size > shard_bytes)) {
+    free_entry(c);
+    return 0;
+  }
+
+  if ((n = (cache_node *) malloc(sizeof(cache_node) + words * sizeof(uint64_t)))==NULL) {
+    fprintf(stderr, "out of memory\n"); exit(255);
+  }
+
+  hash = cache_f(x, len);
+  n->hash = hash;
+  n->len = len;
+  n->size = size;
+  n->data = c;
+  for (w = 0; w < words; w++)
+    n->key[w] = key_word(x, len, w);
+
+  s = shards + (hash & (num_shards - 1));
+
+#ifdef _OPENMP
+  omp_set_lock(&(s->lock));
+#endif
+
+  /* another simulation may have stored x in the meantime */
+  if (find_node(s, x, len, hash)) {
+    found = 1;
+  }
+  else {
+    /* make room by evicting the least recently used entries */
+    while (s->bytes + size > shard_bytes) {
+      cache_node *last = s->lru.prev;
+      remove_node(s, last);
+      free_node(last);
+    }
+    insert_node(s, n);
+  }
+
+#ifdef _OPENMP
+  omp_unset_lock(&(s->lock));
+#endif
+
+  if (found) free_node(n);
+
+  return found;
 }
 
 /**/
-void initialize_cache () { }
+void initialize_cache (size_t max_bytes, int threads) {
+  int i;
+
+  kill_cache();
+
+  /* a cache size of 0 turns caching off */
+  if (max_bytes == 0) return;
+
+  /* use more shards than threads to keep contention low */
+  num_shards = 1;
+  if (threads > 1)
+    while ((num_shards < 8 * threads) && (num_shards < MAX_SHARDS)) num_shards *= 2;
+
+  shard_bytes = max_bytes / num_shards;
+  shards = (cache_shard *) calloc(num_shards, sizeof(cache_shard));
+  if (shards == NULL) {
+    fprintf(stderr, "out of memory\n"); exit(255);
+  }
+
+  for (i = 0; i < num_shards; i++) {
+    shards[i].table = (cache_node **) calloc(BUCKETS, sizeof(cache_node *));
+    if (shards[i].table == NULL) {
+      fprintf(stderr, "out of memory\n"); exit(255);
+    }
+    shards[i].mask = BUCKETS - 1;
+    shards[i].lru.next = shards[i].lru.prev = &(shards[i].lru);
+#ifdef _OPENMP
+    omp_init_lock(&(shards[i].lock));
+#endif
+  }
+}
 
 /**/
 void kill_cache () {
   int i;
-  
-  for (i=0;i<CACHESIZE+1;i++) {
-    if ( cachetab[i] ) {
-      free (cachetab[i]->structure);
-      free (cachetab[i]->neighbors);
-      free (cachetab[i]->rates);
-      free (cachetab[i]->energies);
-      free (cachetab[i]);
+  cache_node *c, *next;
+
+  if (shards == NULL) return;
+
+  for (i = 0; i < num_shards; i++) {
+    for (c = shards[i].lru.next; c != &(shards[i].lru); c = next) {
+      next = c->next;
+      free_node(c);
     }
-    cachetab[i]=NULL;
+    free(shards[i].table);
+#ifdef _OPENMP
+    omp_destroy_lock(&(shards[i].lock));
+#endif
   }
+
+  free(shards);
+  shards = NULL;
+  num_shards = 0;
 }
 
-#if 0
 /**/
-static int cache_comp(cache_entry *x, cache_entry *y) {
-  return strcmp(((cache_entry *)x)->structure, ((cache_entry *)y)->structure);
+static cache_node *find_node (cache_shard *s, const char *x, int len, uint64_t hash) {
+  int w;
+  cache_node *c;
+
+  for (c = s->table[BUCKET(s, hash)]; c; c = c->chain) {
+    if ((c->hash != hash) || (c->len != len)) continue;
+    for (w = 0; (w * KEY_CHARS < len) && (c->key[w] == key_word(x, len, w)); w++);
+    if (w * KEY_CHARS >= len) return c;
+  }
+
+  return NULL;
+}
+
+/* insert new entry at the front of the list */
+static void insert_node (cache_shard *s, cache_node *c) {
+  cache_node **b;
+
+  b = s->table + BUCKET(s, c->hash);
+  c->chain = *b;
+  *b = c;
+
+  c->next = s->lru.next;
+  c->prev = &(s->lru);
+  s->lru.next->prev = c;
+  s->lru.next = c;
+
+  s->num++;
+  s->bytes += c->size;
+
+  if (s->num > 2 * (s->mask + 1)) grow_table(s);
+}
+
+/**/
+static void remove_node (cache_shard *s, cache_node *c) {
+  cache_node **b;
+
+  for (b = s->table + BUCKET(s, c->hash); *b != c; b = &((*b)->chain));
+  *b = c->chain;
+
+  c->prev->next = c->next;
+  c->next->prev = c->prev;
+
+  s->num--;
+  s->bytes -= c->size;
+}
+
+/**/
+static void free_node (cache_node *c) {
+  free_entry(c->data);
+  free(c);
+}
+
+/**/
+static void free_entry (cache_entry *c) {
+  free(c->sizes);
+  free(c->neighbors);
+  free(c->rates);
+  free(c->deltas);
+  free(c);
+}
+
+/* double the number of buckets of a shard */
+static void grow_table (cache_shard *s) {
+  unsigned long i;
+  cache_node **old, *c, *next, **b;
+
+  old = s->table;
+  s->table = (cache_node **) calloc(2 * (s->mask + 1), sizeof(cache_node *));
+  if (s->table == NULL) {
+    /* keep the current buckets */
+    s->table = old;
+    return;
+  }
+
+  for (i = 0; i <= s->mask; i++) {
+    for (c = old[i]; c; c = next) {
+      next = c->chain;
+      b = s->table + (((c->hash) >> 8) & (2 * s->mask + 1));
+      c->chain = *b;
+      *b = c;
+    }
+  }
+
+  s->mask = 2 * s->mask + 1;
+  free(old);
 }
-#endif
 
 /* End of file */
@@ -9,25 +9,28 @@
 #ifndef CACHE_UTIL_H
 #define CACHE_UTIL_H
 
+#include <stddef.h>
+
 #ifdef __GNUC__
 #define UNUSED __attribute__ ((unused))
 #else
 #define UNUSED
 #endif
 
+/* the structure an entry belongs to is stored (packed) by the cache itself */
 typedef struct {
-  char *structure;
   int top;           /* number of neighbors */
-  int lmin;          /* is a local minimum ? */
-  double flux;       /* sum of rates */
+  int groups;        /* number of loops */
   double energy;     /* energy of this structure */
-  short *neighbors;  
+  int *sizes;        /* number of neighbors per loop */
+  short *neighbors;
   float *rates;
-  double *energies;
+  int *deltas;       /* energy differences in dcal/mol */
 } cache_entry;
 
-extern cache_entry *lookup_cache (char *x);
-extern int write_cache (cache_entry *x);
+extern int lookup_cache (char *x, void (*get)(cache_entry *c));
+extern int write_cache (char *x, cache_entry *c);
+void initialize_cache(size_t max_bytes, int threads);
 void kill_cache(void);
 
 #endif
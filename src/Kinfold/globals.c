@@ -40,6 +40,11 @@ static void process_options_gg (int argc, char *argv[]);
 static const char *costring(const char *str);
 
 static char UNUSED rcsid[] ="$Id: globals.c,v 1.8 2008/10/07 09:03:14 ivo Exp $";
+
+GlobVars GSV;
+GlobArrays GAV;
+GlobToggles GTV;
+
 #define MAXMSG 8
 static char msg[MAXMSG][60] =
 {{"off"},
@@ -370,6 +375,24 @@ static void process_options_gg (int argc, char *argv[]) {
   GSV.glen = args_info.glen_arg;
   GTV.lmin = args_info.lmin_flag;
   GTV.fpt  = args_info.fpt_flag;
+
+  if (args_info.numThreads_arg < 1) {
+    fprintf(stderr, "Value of --numThreads must be > 0 >%d<\n", args_info.numThreads_arg);
+    exit(EXIT_FAILURE);
+  }
+  GSV.threads = args_info.numThreads_arg;
+#if !defined(_OPENMP) || !HAVE_LIBRNA_API3
+  if (GSV.threads > 1) {
+    fprintf(stderr, "WARNING: Concurrent simulations are not supported, using 1 thread\n");
+    GSV.threads = 1;
+  }
+#endif
+
+  if (args_info.cacheSize_arg < 0) {
+    fprintf(stderr, "Value of --cacheSize must be >= 0 >%d<\n", args_info.cacheSize_arg);
+    exit(EXIT_FAILURE);
+  }
+  GSV.cachesize = args_info.cacheSize_arg;
   cmdline_parser_free(&args_info);
 }
 /**/
@@ -550,6 +573,8 @@ static void ini_gvars(void) {
   GSV.phi = 1.0;
   GSV.simTime = 0.0;
   GSV.glen = 15;
+  GSV.threads = 1;
+  GSV.cachesize = 1024;
 }
 
 /**/
@@ -40,6 +40,8 @@ typedef struct _GlobVars {
   double time;
   double phi;
   double simTime;
+  int    threads;   /* number of trajectories simulated concurrently */
+  int    cachesize; /* memory limit of the neighborhood cache in MB */
 } GlobVars;
 
 typedef struct _GlobArrays {
@@ -88,9 +90,17 @@ void clean_up_globals(void);
 void log_prog_params(FILE *FP);
 void log_start_stop(FILE *FP);
 
-GlobVars GSV;
-GlobArrays GAV;
-GlobToggles GTV;
+extern GlobVars GSV;
+extern GlobArrays GAV;
+extern GlobToggles GTV;
+
+/*
+  concurrent simulations keep their own copies of variables and arrays,
+  the toggles are shared
+*/
+#ifdef _OPENMP
+#pragma omp threadprivate(GSV, GAV)
+#endif
 
 #endif
 
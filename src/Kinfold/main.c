@@ -13,6 +13,11 @@
 #include <assert.h>
 #include <ctype.h>
 #include <unistd.h>
+#include <stdint.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 #if HAVE_LIBRNA_API3
 #include <ViennaRNA/data_structures.h>
@@ -38,11 +43,16 @@ extern void get_from_cache(cache_entry *c);
 static void ini_energy_model(void);
 static void read_data(void);
 static void clean_up(void);
+static void simulate(char *start);
+static void simulate_serial(void);
+#if defined(_OPENMP) && HAVE_LIBRNA_API3
+static void simulate_parallel(void);
+static void trajectory_seed(int i, unsigned short seed[3]);
+#endif
 
 /**/
 int main(int argc, char *argv[]) {
-  int i;
-  char * start, *tmp;
+  char *tmp;
   
   /*
     process command-line optiones
@@ -70,64 +80,207 @@ int main(int argc, char *argv[]) {
   free(tmp);
 #endif
 
+  /*
+    evaluate start and stop structure(s) and log initial condition
+  */
+  ini_start_stop();
+  ini_log();
+  initialize_cache((size_t)GSV.cachesize * 1024 * 1024, GSV.threads);
+
   /*
     perform GSV.num simulations
   */
-    
-  start = strdup(GAV.startform); /* remember startform for next run */
-  for (i = 0; i < GSV.num; i++) {
+#if defined(_OPENMP) && HAVE_LIBRNA_API3
+  if (GSV.threads > 1) simulate_parallel();
+  else
+#endif
+  simulate_serial();
 
-    /*
-      initialize or reset ringlist to start conditions
-    */
-    ini_or_reset_rl();
-    if (GSV.grow>0) {
-      if (strlen(GAV.farbe)>GSV.glen) {
-	start[GSV.glen] = '\0';
-	GAV.farbe[GSV.glen] = '\0';
-	strcpy(GAV.startform,start);
-	strcpy(GAV.currform,start);
-	GSV.len=GSV.glen;
+  /*
+    clean up memory
+  */
+  clean_up();
+  return(0);
+}
+
+/* perform a single simulation */
+static void simulate(char *start) {
+
+  /*
+    initialize or reset ringlist to start conditions
+  */
+  ini_or_reset_rl();
+  if (GSV.grow>0) {
+    if (strlen(GAV.farbe)>GSV.glen) {
+      start[GSV.glen] = '\0';
+      GAV.farbe[GSV.glen] = '\0';
+      strcpy(GAV.startform,start);
+      strcpy(GAV.currform,start);
+      GSV.len=GSV.glen;
 
 #if HAVE_LIBRNA_API3
-        GAV.vc->length = GSV.len;
+      GAV.vc->length = GSV.len;
 #endif
-      }
-      clean_up_rl();
-      ini_or_reset_rl();
     }
+    clean_up_rl();
+    ini_or_reset_rl();
+  }
+
+  /*
+    perform simulation
+  */
+  for (GSV.steps = 1;; GSV.steps++) {
 
     /*
-      perform simulation
+      take neighbourhood of current structure from cache if there
+      else generate it from scratch
     */
-    for (GSV.steps = 1;; GSV.steps++) {
-      cache_entry *c;
+    if ( !lookup_cache(GAV.currform, get_from_cache) ) move_it();
+
+    /*
+      select a structure from neighbourhood of current structure
+      and make it to the new current structure.
+      stop simulation if stop condition is met.
+    */
+    if ( sel_nb() > 0 ) break;
+
+    /* if (GSV.grow>0) grow_chain(); */
+  }
+}
+
+/* all simulations draw from a single stream of random numbers */
+static void simulate_serial(void) {
+  int i;
+  char *start;
+  unsigned short seed[3];
+
+  start = strdup(GAV.startform); /* remember startform for next run */
+  set_random_state(GAV.subi);
+
+  for (i = 0; i < GSV.num; i++) {
+    simulate(start);
+    get_random_state(seed);
+    log_seed(seed);
+  }
+
+  free(start);
+}
+
+#if defined(_OPENMP) && HAVE_LIBRNA_API3
+/*
+  each simulation draws from its own stream of random numbers, such that
+  the results do not depend on the number of threads. Output is written
+  in the order of the simulations
+*/
+static void simulate_parallel(void) {
+  int next;
+  char *done;
+  FILE **outbuf, **logbuf;
+
+  omp_set_dynamic(0);
+
+  /* output of finished simulations that waits for its predecessors */
+  next = 0;
+  done = (char *)calloc(GSV.num, sizeof(char));
+  assert(done != NULL);
+  outbuf = (FILE **)calloc(GSV.num, sizeof(FILE *));
+  assert(outbuf != NULL);
+  logbuf = (FILE **)calloc(GSV.num, sizeof(FILE *));
+  assert(logbuf != NULL);
+
+#pragma omp parallel num_threads(GSV.threads) copyin(GSV, GAV)
+  {
+    int i, copy;
+    char *start, *tmp;
+    unsigned short seed[3];
+
+    /*
+      all but the master thread need their own copies of the
+      arrays that are modified during the simulation
+    */
+    copy = (omp_get_thread_num() != 0);
+    if (copy) {
+      GAV.farbe = strdup(GAV.farbe);
+      GAV.startform = strdup(GAV.startform);
+      GAV.currform = (char *)calloc(GSV.len + 1, sizeof(char));
+      assert(GAV.currform != NULL);
+      GAV.prevform = (char *)calloc(GSV.len + 1, sizeof(char));
+      assert(GAV.prevform != NULL);
+      tmp = vrna_cut_point_insert(GAV.farbe, cut_point);
+      GAV.vc = vrna_fold_compound(tmp, &(GAV.md), VRNA_OPTION_DEFAULT);
+      free(tmp);
+    }
+
+    /* the master thread must not modify its arrays before all copies are made */
+#pragma omp barrier
+
+    start = strdup(GAV.startform); /* remember startform for next run */
+
+#pragma omp for schedule(dynamic, 1)
+    for (i = 0; i < GSV.num; i++) {
+      buffer_output();
+      trajectory_seed(i, seed);
+      set_random_state(seed);
+      simulate(start);
+      trajectory_seed(i + 1, seed);
+      log_seed(seed);
+      release_output(&(outbuf[i]), &(logbuf[i]));
 
       /*
-	take neighbourhood of current structure from cache if there
-	else generate it from scratch
-      */
-      if ( (c = lookup_cache(GAV.currform)) ) get_from_cache(c);
-      else move_it();
-	
-      /*
-	select a structure from neighbourhood of current structure
-	and make it to the new current structure.
-	stop simulation if stop condition is met.
+        write all simulations that are complete up to here, a thread
+        never waits for simulations still running on other threads
       */
-      if ( sel_nb() > 0 ) break;
+#pragma omp critical (kinfold_output)
+      {
+        done[i] = 1;
+        while ((next < GSV.num) && (done[next])) {
+          write_output(outbuf[next], logbuf[next]);
+          next++;
+        }
+      }
+    }
+
+    free(start);
 
-      /* if (GSV.grow>0) grow_chain(); */
+    if (copy) {
+      clean_up_rl();
+      clean_up_nbList();
+      vrna_fold_compound_free(GAV.vc);
+      free(GAV.farbe);
+      free(GAV.startform);
+      free(GAV.currform);
+      free(GAV.prevform);
     }
   }
-  
-  /*
-    clean up memory
-  */
-  free(start);
-  clean_up();
-  return(0);
+
+  free(done);
+  free(outbuf);
+  free(logbuf);
+}
+
+/*
+  the first simulation uses the seed itself, all other seeds are
+  derived from the seed and the number of the simulation
+*/
+static void trajectory_seed(int i, unsigned short seed[3]) {
+  uint64_t z;
+
+  if (i == 0) {
+    memcpy(seed, GAV.subi, 3*sizeof(unsigned short));
+    return;
+  }
+
+  z = ((uint64_t)GAV.subi[0] | ((uint64_t)GAV.subi[1] << 16) | ((uint64_t)GAV.subi[2] << 32)) +
+      (uint64_t)i * 0x9e3779b97f4a7c15ULL;
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  z ^= (z >> 31);
+
+  seed[0] = (unsigned short)z;
+  seed[1] = (unsigned short)(z >> 16);
+  seed[2] = (unsigned short)(z >> 32);
 }
+#endif
 
 /**/
 static void ini_energy_model(void) {
@@ -258,5 +411,6 @@ void clean_up(void) {
   clean_up_globals();
   clean_up_rl();
   clean_up_nbList();
+  close_log();
   kill_cache();
 }
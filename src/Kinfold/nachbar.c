@@ -29,9 +29,33 @@
 
 static char UNUSED rcsid[]="$Id: nachbar.c,v 1.8 2008/06/03 21:55:11 ivo Exp $";
 
-/* arrays */
-static short *neighbor_list=NULL;
-static float *bmf=NULL; /* boltzmann weight of structure */
+/*
+  neighbors of the current structure, grouped by the loop that is
+  modified by the move. Group 0 holds the moves in the exterior loop,
+  group k the moves of the base pair opened at position k. A move of
+  the simulation only changes the energies of a few loops, such that
+  only the groups depending on them have to be recomputed.
+*/
+typedef struct {
+  int num;         /* number of neighbors */
+  int size;        /* allocated number of neighbors */
+  short *moves;    /* move coding */
+  float *rates;    /* transition rates */
+  int *deltas;     /* energy differences to current structure in dcal/mol */
+  double *cumul;   /* partial sums of rates */
+  long dsum;       /* sum of energy differences */
+  int down;        /* number of neighbors with lower energy */
+  int flat;        /* number of neighbors with equal energy */
+} nb_group;
+
+static nb_group *groups=NULL;
+static int num_groups = 0;
+static double *flux_tree=NULL; /* sum tree of the total rates of the groups */
+static int leaves = 0;         /* first leaf of sum tree */
+static int *marked=NULL;       /* groups to be recomputed */
+static char *is_marked=NULL;
+static int num_marked = 0;
+static int curr_group = -1;    /* group update_nbList() adds neighbors to */
 static const char *costring(const char *str);
 
 /* globals for laplace stuff */
@@ -41,7 +65,7 @@ static double sumT = 0.0;
 static double sumK = 0.0;
 static double sumKK = 0.0;
 static double sumD = 0.0;
-static double *energies=NULL; /* energies of neighbors */
+static long sum_deltas = 0;    /* energy differences to all neighbors */
 
 /* variables */
 /*  static double highestE = -1000.0; */
@@ -49,6 +73,8 @@ static double *energies=NULL; /* energies of neighbors */
 /*  static char *highestS, *OhighestS; */
 static int lmin = 1;
 static int top = 0;
+static int num_down = 0;
+static int num_flat = 0;
 static int is_from_cache = 0;
 /*  static double meanE = 0.0; */
 static double totalflux = 0.0;
@@ -56,68 +82,188 @@ static double Zeit = 0.0;
 static double zeitInc = 0.0;
 static double _RT = 0.6;
 
+/* output goes to these streams */
+static FILE *outFP=NULL;
+static FILE *logFP=NULL;
+
+/* state of random number generator */
+static unsigned short rstate[3];
+
+/* concurrent simulations keep their own neighbor list and state */
+#ifdef _OPENMP
+#pragma omp threadprivate(groups, num_groups, flux_tree, leaves, marked, \
+                          is_marked, num_marked, curr_group, L, D, sumT, \
+                          sumK, sumKK, sumD, sum_deltas, lmin, top, num_down, \
+                          num_flat, is_from_cache, totalflux, Zeit, zeitInc, \
+                          _RT, outFP, logFP, rstate)
+#endif
+
+/* the log file is shared */
+static FILE *logFile=NULL;
+
 /* public functiones */
-void ini_nbList(int chords);
+void ini_nbList(int loops);
 void update_nbList(int i, int j, int iE);
+void mark_nbGroup(int g);
+int next_nbGroup(void);
 int sel_nb(void);
 void clean_up_nbList(void);
+void ini_log(void);
+void log_seed(const unsigned short seed[3]);
+void close_log(void);
+void buffer_output(void);
+void release_output(FILE **out, FILE **log);
+void write_output(FILE *out, FILE *log);
+void set_random_state(const unsigned short seed[3]);
+void get_random_state(unsigned short seed[3]);
 extern void update_tree(int i, int j);
 
 /* privat functiones */
-static void reset_nbList(void);
-static void grow_chain(void);
-static FILE *logFP=NULL;
+static void reserve_nbGroup(nb_group *G, int n);
+static void finish_nbGroup(int g);
+static void empty_nbGroup(int g);
+static int select_nb(double schwelle, short *move);
+static int grow_chain(void);
+static double rand_uniform(void);
+static void copy_stream(FILE *from, FILE *to);
 
 /**/
-void ini_nbList(int chords) {
-  char logFN[256];
+void ini_nbList(int loops) {
 
   _RT = (((temperature + K0) * GASCONST) / 1000.0);
-  if (neighbor_list!=NULL) return;
+  if (groups!=NULL) return;
   /*
-    list for move coding
-    make room for 2*chords neighbors (safe bet)
+    one group of neighbors per loop, the
+    lists of moves grow on demand
   */
-  if (chords == 0) chords = 1;
-  neighbor_list = (short *)calloc(4*chords, sizeof(short));
-  assert(neighbor_list != NULL);
+  num_groups = loops;
+  groups = (nb_group *)calloc(num_groups, sizeof(nb_group));
+  assert(groups != NULL);
+  marked = (int *)calloc(num_groups, sizeof(int));
+  assert(marked != NULL);
+  is_marked = (char *)calloc(num_groups, sizeof(char));
+  assert(is_marked != NULL);
   /*
-    list for Boltzmann-factors
+    sum tree over the total rates of the groups
   */
-  bmf = (float *)calloc(2*chords, sizeof(double));
-  assert(bmf != NULL);
+  for (leaves = 1; leaves < num_groups; leaves *= 2);
+  flux_tree = (double *)calloc(2*leaves, sizeof(double));
+  assert(flux_tree != NULL);
+}
 
-  /* list of neighbor energies */
-  energies = (double*)calloc(2*chords, sizeof(double));
-  assert(energies != NULL);
-  
-  /* open log-file */
-  logFP = fopen(strcat(strcpy(logFN, GAV.BaseName), ".log"), "a+");
-  assert(logFP != NULL);
+/* open log-file and log initial condition */
+void ini_log(void) {
+  char logFN[256];
+
+  logFile = fopen(strcat(strcpy(logFN, GAV.BaseName), ".log"), "a+");
+  assert(logFile != NULL);
+
+  log_prog_params(logFile);
+  log_start_stop(logFile);
+
+  outFP = stdout;
+  logFP = logFile;
+}
+
+/* log the seed of the next trajectory */
+void log_seed(const unsigned short seed[3]) {
+  fprintf(logFP, "(%5hu %5hu %5hu)", seed[0], seed[1], seed[2]);
+  fflush(logFP);
+}
+
+/**/
+void close_log(void) {
+  fprintf(logFile,"\n");
+  fclose(logFile);
+}
+
+/*
+  collect output of the current trajectory in temporary files,
+  such that concurrent trajectories can be written in order
+*/
+void buffer_output(void) {
+  outFP = tmpfile();
+  logFP = tmpfile();
+  assert((outFP != NULL) && (logFP != NULL));
+}
+
+/* hand over the temporary files and write directly again */
+void release_output(FILE **out, FILE **log) {
+  *out = outFP;
+  *log = logFP;
+  outFP = stdout;
+  logFP = logFile;
+}
 
-  /* log initial condition */
-  log_prog_params(logFP);
-  log_start_stop(logFP);
+/* write output collected by buffer_output() and close the temporary files */
+void write_output(FILE *out, FILE *log) {
+  copy_stream(out, stdout);
+  copy_stream(log, logFile);
+  fclose(out);
+  fclose(log);
+}
+
+/**/
+static void copy_stream(FILE *from, FILE *to) {
+  char buf[4096];
+  size_t k;
+
+  rewind(from);
+  while ((k = fread(buf, 1, sizeof(buf), from)) > 0)
+    fwrite(buf, 1, k, to);
+  fflush(to);
+}
+
+/**/
+void set_random_state(const unsigned short seed[3]) {
+  memcpy(rstate, seed, 3*sizeof(unsigned short));
+}
+
+/**/
+void get_random_state(unsigned short seed[3]) {
+  memcpy(seed, rstate, 3*sizeof(unsigned short));
+}
+
+/**/
+static double rand_uniform(void) {
+#if HAVE_ERAND48
+  return erand48(rstate);
+#else
+  /* the linear congruential generator of erand48() on our own state */
+  unsigned long long x;
+
+  x = (unsigned long long)rstate[0] |
+      ((unsigned long long)rstate[1] << 16) |
+      ((unsigned long long)rstate[2] << 32);
+  x = (0x5DEECE66DULL * x + 0xBULL) & 0xFFFFFFFFFFFFULL;
+
+  rstate[0] = (unsigned short)x;
+  rstate[1] = (unsigned short)(x >> 16);
+  rstate[2] = (unsigned short)(x >> 32);
+
+  return ldexp((double)x, -48);
+#endif
 }
 
 /**/
 void update_nbList(int i, int j, int iE) {
-  double E, dE, p;
+  int delta;
+  double dE, p;
+  nb_group *G;
 
-  E = (double)iE/100.;
-  neighbor_list[2*top] = (short )i;
-  neighbor_list[2*top+1] = (short )j;
-  
-  /* compute rates and some statistics */
-  /*    meanE += E; */
-  dE = E-GSV.currE;
+  G = groups + curr_group;
+  reserve_nbGroup(G, G->num + 1);
+  G->moves[2*G->num] = (short )i;
+  G->moves[2*G->num+1] = (short )j;
+
+  /*
+    compute rates and some statistics from the energy difference in
+    dcal/mol, such that the rates do not depend on the energy of the
+    structure the neighbors were generated for
+  */
+  delta = iE - (int) (GSV.currE*100 + ((GSV.currE<0)?-0.4:0.4));
+  dE = (double)delta/100.;
 
-  /* laplace stuff */
-  energies[top] = E;
-  L += GSV.currE-E;
-  D++;
-  /* fprintf(stderr, ">>%g %g<<\n", L, D); */
-  
   if( GTV.mc ) {
     /* metropolis rule */
     if (dE < 0) p = 1;
@@ -126,45 +272,186 @@ void update_nbList(int i, int j, int iE) {
   else  /* kawasaki rule */
     p = exp(-0.5 * (dE / _RT*GSV.phi));
 
-  totalflux += p;
-  bmf[top++] = (float )p;
-  if (dE < 0) lmin = 0;
-  if ((dE == 0) && (lmin==1)) lmin = 2;
+  G->rates[G->num] = (float )p;
+  G->deltas[G->num++] = delta;
+  G->dsum += delta;
+  if (delta < 0) G->down++;
+  else if (delta == 0) G->flat++;
+}
+
+/* neighbors of group g have to be recomputed (all groups if g < 0) */
+void mark_nbGroup(int g) {
+  if (g < 0) {
+    for (g = 0; g < num_groups; g++) mark_nbGroup(g);
+    return;
+  }
+  if (is_marked[g]) return;
+  is_marked[g] = 1;
+  marked[num_marked++] = g;
+}
+
+/*
+  finish the group update_nbList() added neighbors to, and return the
+  next marked group after removing its neighbors (-1 if there is none)
+*/
+int next_nbGroup(void) {
+  if (curr_group >= 0) finish_nbGroup(curr_group);
+  if (num_marked == 0) return (curr_group = -1);
+  curr_group = marked[--num_marked];
+  is_marked[curr_group] = 0;
+  empty_nbGroup(curr_group);
+  return curr_group;
+}
+
+/**/
+static void reserve_nbGroup(nb_group *G, int n) {
+  if (n <= G->size) return;
+  while (G->size < n) G->size = (G->size) ? 2*G->size : 16;
+  G->moves = (short *)realloc(G->moves, 2*G->size*sizeof(short));
+  G->rates = (float *)realloc(G->rates, G->size*sizeof(float));
+  G->deltas = (int *)realloc(G->deltas, G->size*sizeof(int));
+  G->cumul = (double *)realloc(G->cumul, G->size*sizeof(double));
+  if (!G->moves || !G->rates || !G->deltas || !G->cumul) {
+    fprintf(stderr, "out of memory\n"); exit(255);
+  }
+}
+
+/**/
+static void empty_nbGroup(int g) {
+  nb_group *G;
+
+  G = groups + g;
+  top -= G->num;
+  sum_deltas -= G->dsum;
+  num_down -= G->down;
+  num_flat -= G->flat;
+  G->num = G->down = G->flat = 0;
+  G->dsum = 0;
+}
+
+/* sum up the rates of group g and update the sum tree */
+static void finish_nbGroup(int g) {
+  int k;
+  double sum = 0.0;
+  nb_group *G;
+
+  G = groups + g;
+  for (k = 0; k < G->num; k++)
+    G->cumul[k] = (sum += G->rates[k]);
+
+  top += G->num;
+  sum_deltas += G->dsum;
+  num_down += G->down;
+  num_flat += G->flat;
+
+  k = leaves + g;
+  flux_tree[k] = sum;
+  for (k /= 2; k > 0; k /= 2)
+    flux_tree[k] = flux_tree[2*k] + flux_tree[2*k+1];
+}
+
+/*
+  choose the neighbor at which the partial sum of the rates exceeds
+  schwelle, in the order the neighbors were generated in
+*/
+static int select_nb(double schwelle, short *move) {
+  int k, lo, hi, mid;
+  nb_group *G;
+
+  if (top == 0) return -1;
+
+  /* find the group in the sum tree ... */
+  for (k = 1; k < leaves; ) {
+    k *= 2;
+    if ((schwelle >= flux_tree[k]) && (flux_tree[k+1] > 0)) {
+      schwelle -= flux_tree[k];
+      k++;
+    }
+  }
+  G = groups + (k - leaves);
+
+  /* ... and the neighbor within the group */
+  for (lo = 0, hi = G->num - 1; lo < hi; ) {
+    mid = (lo + hi) / 2;
+    if (G->cumul[mid] > schwelle) hi = mid;
+    else lo = mid + 1;
+  }
+
+  move[0] = G->moves[2*lo];
+  move[1] = G->moves[2*lo+1];
+  return lo;
 }
 
 /**/
 void get_from_cache(cache_entry *c) {
-  top = c->top;
-  totalflux = c->flux;
+  int g, k, n;
+  short *moves;
+  float *rates;
+  int *deltas;
+  nb_group *G;
+
   GSV.currE = c->energy;
-  lmin = c->lmin;
-  memcpy(neighbor_list, c->neighbors, 2*top*sizeof(short));
-  memcpy(bmf, c->rates, top*sizeof(float));
-  memcpy(energies, c->energies, top*sizeof(double));
+  moves = c->neighbors;
+  rates = c->rates;
+  deltas = c->deltas;
+
+  /* the entry holds the neighbors of all groups */
+  while (num_marked > 0) is_marked[marked[--num_marked]] = 0;
+
+  for (g = 0; g < num_groups; g++) {
+    G = groups + g;
+    empty_nbGroup(g);
+    n = (g < c->groups) ? c->sizes[g] : 0;
+    if (n > 0) {
+      reserve_nbGroup(G, n);
+      memcpy(G->moves, moves, 2*n*sizeof(short));
+      memcpy(G->rates, rates, n*sizeof(float));
+      memcpy(G->deltas, deltas, n*sizeof(int));
+      for (k = 0; k < n; k++) {
+        G->dsum += deltas[k];
+        if (deltas[k] < 0) G->down++;
+        else if (deltas[k] == 0) G->flat++;
+      }
+      G->num = n;
+      moves += 2*n;
+      rates += n;
+      deltas += n;
+    }
+    finish_nbGroup(g);
+  }
+
   is_from_cache = 1;
 }
 
 /**/
 void put_in_cache(void) {
+  int g, n, k;
   cache_entry *c;
 
   if ((c = (cache_entry *) malloc(sizeof(cache_entry)))==NULL) {
     fprintf(stderr, "out of memory\n"); exit(255);
   }
-/*    c->structure = strdup(GAV.currform); */
-  c->structure = (char *) calloc(GSV.len+1, sizeof(char));
-  strcpy(c->structure, GAV.currform);
+  /* groups of loops beyond the current length are empty */
+  c->groups = GSV.len + 1;
+  c->sizes = (int *) malloc(c->groups*sizeof(int));
   c->neighbors = (short *) malloc(top*2*sizeof(short));
-  memcpy(c->neighbors,neighbor_list,top*2*sizeof(short));
   c->rates = (float *) malloc(top*sizeof(float));
-  memcpy(c->rates, bmf, top*sizeof(float));
-  c->energies = (double*)malloc(top*sizeof(double));
-  memcpy(c->energies, energies, top*sizeof(double));
+  c->deltas = (int *) malloc(top*sizeof(int));
+  if (!c->sizes || (top && (!c->neighbors || !c->rates || !c->deltas))) {
+    fprintf(stderr, "out of memory\n"); exit(255);
+  }
+  for (k = g = 0; g < c->groups; g++) {
+    n = groups[g].num;
+    c->sizes[g] = n;
+    if (n == 0) continue;
+    memcpy(c->neighbors + 2*k, groups[g].moves, 2*n*sizeof(short));
+    memcpy(c->rates + k, groups[g].rates, n*sizeof(float));
+    memcpy(c->deltas + k, groups[g].deltas, n*sizeof(int));
+    k += n;
+  }
   c->top = top;
-  c->lmin = lmin;
-  c->flux = totalflux;
   c->energy = GSV.currE;
-  write_cache(c);
+  write_cache(GAV.currform, c);
 }
 
 /*============*/
@@ -172,24 +459,30 @@ void put_in_cache(void) {
 int sel_nb(void) {
 
   char trans, **s;
-  int next, i;
-  double pegel = 0.0, schwelle = 0.0, zufall = 0.0;
+  int next, num_nb, grown = 0;
+  short move[2] = {0, 0};
+  double schwelle = 0.0, zufall = 0.0;
   int found_stop=0;
 
   /* before we select a move, store current conformation in cache */
   /* ... unless it just came from there */
   if ( !is_from_cache ) put_in_cache();
-  else
-    /* laplace stuff */
-    for (i=0; i<top; i++) {
-      L += (GSV.currE - energies[i]);
-      D++;
-    }
   is_from_cache = 0;
 
+  /* laplace stuff */
+  L -= (double)sum_deltas/100.;
+  D += top;
+
+  /* is current structure a local minimum ? */
+  if (num_down > 0) lmin = 0;
+  else if (num_flat > 0) lmin = 2;
+  else lmin = 1;
+
+  totalflux = flux_tree[1];
+
   /* draw 2 different a random number */
-  schwelle = urn();
-  while ( zufall==0 ) zufall = urn();
+  schwelle = rand_uniform();
+  while ( zufall==0 ) zufall = rand_uniform();
 
   /* advance internal clock */
   if (totalflux>0)
@@ -206,21 +499,21 @@ int sel_nb(void) {
   sumKK += L*L*zeitInc;
   sumD  += D*zeitInc;
   
-  if (GSV.grow>0 && GSV.len < strlen(GAV.farbe_full)) grow_chain();
+  if (GSV.grow>0 && GSV.len < strlen(GAV.farbe_full)) grown = grow_chain();
 
   /* meanE /= (double)top; */
 
   /* normalize boltzmann weights */
   schwelle *=totalflux;
 
-  /* and choose a neighbour structure next */
-  for (next = 0; next < top; next++) {
-    pegel += bmf[next];
-    if (pegel > schwelle) break;
-  }
+  /* and choose a neighbour structure next (no structure move if chain grew) */
+  next = (grown) ? -1 : select_nb(schwelle, move);
+
+  /* a move is selected whenever the chain did not grow and there are neighbors */
+  assert(grown || (top == 0) || ((next >= 0) && (move[0] != 0)));
 
-  /* in case of rounding errors */
-  if (next==top) next=top-1;
+  /* no neighbors are available once the chain grew */
+  num_nb = (grown) ? 0 : top;
 
   /*
     process termination contitiones
@@ -246,19 +539,19 @@ int sel_nb(void) {
     
     /* this goes to stdout */
     if ( !GTV.silent ) {
-      printf("%s %6.2f %10.3f", costring(GAV.currform), GSV.currE, Zeit);
+      fprintf(outFP, "%s %6.2f %10.3f", costring(GAV.currform), GSV.currE, Zeit);
 
       /* laplace stuff*/
-      if (GTV.phi) printf(" %8.3f %8.3f %3g", zeitInc, L, D); 
+      if (GTV.phi) fprintf(outFP, " %8.3f %8.3f %3g", zeitInc, L, D); 
 
-      if (GTV.verbose) printf(" %4d _ %d", top, lmin);
-      if (found_stop) printf(" X%d\n", found_stop);/* found a stop structure */
-      else printf(" O\n"); /* time for simulation is exceeded */
+      if (GTV.verbose) fprintf(outFP, " %4d _ %d", num_nb, lmin);
+      if (found_stop) fprintf(outFP, " X%d\n", found_stop);/* found a stop structure */
+      else fprintf(outFP, " O\n"); /* time for simulation is exceeded */
 
       /* laplace stuff */
-      if (GTV.phi) printf("Curvature fluctuation sigma = %7.5f\n", sigma);
+      if (GTV.phi) fprintf(outFP, "Curvature fluctuation sigma = %7.5f\n", sigma);
 
-      fflush(stdout);
+      fflush(outFP);
     }
 
     /* this goes to log */
@@ -279,12 +572,8 @@ int sel_nb(void) {
 
       fprintf(logFP," %d %s\n", lmin, costring(GAV.currform));
     }
-    GAV.subi[0] = xsubi[0];
-    GAV.subi[1] = xsubi[1];
-    GAV.subi[2] = xsubi[2];
-    fprintf(logFP, "(%5hu %5hu %5hu)", GAV.subi[0], GAV.subi[1], GAV.subi[2]);
     fflush(logFP);
-    
+
     Zeit = 0.0;
 
     /* reset laplace stuff for next trajectory */
@@ -296,7 +585,6 @@ int sel_nb(void) {
     D = 0.0;
     
     /*  highestE = OhighestE = -1000.0; */
-    reset_nbList();
     costring(NULL);
     return(1);
   }
@@ -309,12 +597,12 @@ int sel_nb(void) {
 	char format[64];
 	flag = 1;
 	sprintf(format, "%%-%ds %%6.2f %%10.3f", strlen(GAV.farbe_full)+1);
-	printf(format, costring(GAV.currform), GSV.currE, Zeit);
+	fprintf(outFP, format, costring(GAV.currform), GSV.currE, Zeit);
       }
 
       /* laplace stuff */
       if (GTV.phi) {
-	printf(" %8.3f %8.3f %3g", zeitInc, L, D);
+	fprintf(outFP, " %8.3f %8.3f %3g", zeitInc, L, D);
 	L = D = 0.0; /* reset L and D for next structure */
       }
 
@@ -322,8 +610,8 @@ int sel_nb(void) {
 	int ii, jj;
 	if (next<0) trans='g'; /* growth */
 	else {
-	  ii = neighbor_list[2*next];
-	  jj = neighbor_list[2*next+1];
+	  ii = move[0];
+	  jj = move[1];
 	  if (abs(ii) < GSV.len) {
 	    if ((ii > 0) && (jj > 0)) trans = 'i';
 	    else if ((ii < 0) && (jj < 0)) trans = 'd';
@@ -334,9 +622,9 @@ int sel_nb(void) {
 	    else trans = 'D';
 	  }
 	}
-	printf(" %4d %c %d", top, trans, lmin);
+	fprintf(outFP, " %4d %c %d", num_nb, trans, lmin);
       }
-      if (flag) printf("\n");
+      if (flag) fprintf(outFP, "\n");
     }
   }
 
@@ -373,42 +661,47 @@ int sel_nb(void) {
   }
 #endif
 
-  if (next>=0) update_tree(neighbor_list[2*next], neighbor_list[2*next+1]);
+  /* the move marks the groups of neighbors that have to be recomputed */
+  if (next>=0) update_tree(move[0], move[1]);
   else {
     clean_up_rl(); ini_or_reset_rl();
   }
 
-  reset_nbList();
   return(0);
 }
 
-/*==========================*/
-static void reset_nbList(void) {
-
-  top = 0;
-  totalflux = 0.0;
-  /*    meanE = 0.0; */
-  lmin = 1;
-}
-
 /*======================*/
 void clean_up_nbList(void){
+  int g;
 
-  free(neighbor_list);
-  free(bmf);
-  free(energies);
-  fprintf(logFP,"\n");
-  fclose(logFP);
+  for (g = 0; g < num_groups; g++) {
+    free(groups[g].moves);
+    free(groups[g].rates);
+    free(groups[g].deltas);
+    free(groups[g].cumul);
+  }
+  free(groups);
+  free(marked);
+  free(is_marked);
+  free(flux_tree);
+  groups = NULL;
+  marked = NULL;
+  is_marked = NULL;
+  flux_tree = NULL;
+  num_groups = num_marked = 0;
+  curr_group = -1;
+  top = num_down = num_flat = 0;
+  sum_deltas = 0;
 }
 
 /*======================*/
-static void grow_chain(void){
+/* returns 1 if the chain grew, which prevents a structure move in sel_nb */
+static int grow_chain(void){
   int newl;
   /* note Zeit=0 corresponds to chain length GSV.glen */
-  if (Zeit<(GSV.len+1-GSV.glen) * GSV.grow) return;
+  if (Zeit<(GSV.len+1-GSV.glen) * GSV.grow) return 0;
   newl = GSV.len+1;
   Zeit = (newl-GSV.glen) * GSV.grow;
-  top=0; /* prevent structure move in sel_nb */
 
   if (GSV.len<newl) {
     strncpy(GAV.farbe, GAV.farbe_full, newl);
@@ -422,11 +715,15 @@ static void grow_chain(void){
     GAV.vc->length = newl;
 #endif
   }
+  return 1;
 }
 
 static const char *costring(const char *str) {
   static char* buffer=NULL;
   static int size=0;
+#ifdef _OPENMP
+#pragma omp threadprivate(buffer, size)
+#endif
   int n;
   if (str==NULL) {
     if (buffer) {
@@ -10,12 +10,20 @@
 #define NACHBAR_H
 
 /* used in baum.c */
-extern void ini_nbList(int chords);
+extern void ini_nbList(int loops);
 extern void update_nbList(int i,int j, int iE);
+extern void mark_nbGroup(int g);
+extern int next_nbGroup(void);
 
 /* used in main.c */
 extern int sel_nb(void);
 extern void clean_up_nbList(void);
-
-extern void grow_chain(void);
+extern void ini_log(void);
+extern void log_seed(const unsigned short seed[3]);
+extern void close_log(void);
+extern void buffer_output(void);
+extern void release_output(FILE **out, FILE **log);
+extern void write_output(FILE *out, FILE *log);
+extern void set_random_state(const unsigned short seed[3]);
+extern void get_random_state(unsigned short seed[3]);
 #endif
@@ -4,6 +4,7 @@
 */
 
 #include <algorithm>
+#include <cmath>
 #include <iostream>
 #include <iterator>
 #include <utility>
@@ -32,6 +33,7 @@ std::string Node::front_structure;
 double Node::front_energy;
 std::string Node::mfe_structure;
 double Node::mfe;
+vrna_cotrans_t* Node::cotrans=NULL;
 double Node::energy_barrier;
 double Node::max_barrier;
 std::vector<std::vector<bool> > Node::front =std::vector<std::vector<bool> >();
@@ -581,12 +583,12 @@ void
 Node::FindLocalExtrema()
 {
   int *f5, *c, *fML, *fM1, *indx; char *ptype;
-  export_fold_arrays(&f5,&c,&fML,&fM1,&indx,&ptype);
+  if(!Node::cotrans) export_fold_arrays(&f5,&c,&fML,&fM1,&indx,&ptype);
   if(verbose>=2) Cout("#extrema: "+Str((int)extrema.size())+"\n");
   int n = matrix_size;
   for (int i=1; i<=n-TURN-1; i++) {
     for (int j=i+TURN+1; j<=n; j++) {
-      double val = c[indx[j]+i];
+      double val = Node::cotrans ? vrna_cotrans_mfe_pair(Node::cotrans,i,j,NULL) : c[indx[j]+i];
       //i and j pair AND no lonely pair
       if(val < INF) {
         //Node node=Node(i, j,val);
@@ -596,7 +598,7 @@ Node::FindLocalExtrema()
     }
   }
 
-  double energy = f5[Node::sequence.size()];
+  double energy = Node::cotrans ? floor(Node::mfe*100.+0.5) : f5[Node::sequence.size()];
   // (1,n) is in general not a pair. You can't include it in the list
   //Node node2=Node(1,n,energy);
   extrema.push_back(new Node(1,n,energy));//& node2);
@@ -901,9 +903,17 @@ void Node::BacktrackFront(std::pair<double,std::string> & ret,std::string node_s
 
 std::string Node::BacktrackNode(Node* n){
   if(n->IsMfE()) {
-    Node::CalculateMfe();
+    if(!Node::cotrans) Node::CalculateMfe();
     return Node::mfe_structure;
   }
+  else if(Node::cotrans) {
+    //the substructure only extends to j, which is already transcribed
+    std::vector<char> s(n->j+1);
+    vrna_cotrans_mfe_pair(Node::cotrans, n->i, n->j, &s[0]);
+    std::string ss(&s[0]);
+    ss.resize(Node::transcribed,'.');
+    return ss;
+  }
   else {
     char *s = backtrack_fold_from_pair(const_cast<char*>(Node::sequence.c_str()),
                                        n->i, n->j);
@@ -913,13 +923,24 @@ std::string Node::BacktrackNode(Node* n){
   }
 }
 
+/**
+ * Folds the sequence. The matrices are kept in an incremental fold
+ * compound, such that backtracking a Node or the MfE later on does not
+ * require to fold the sequence again.
+ */
 void Node::CalculateMfe(){
  
   char *sequence  = new char[Node::matrix_size+1];
   char *structure = new char[Node::matrix_size+1];
   strcpy(sequence, Node::sequence.c_str());
   //  if(fold_constrained)  strcpy(structure,Node::constraint_string.c_str()); 
-  Node::mfe = fold(sequence, structure);
+  if(!Node::cotrans){
+    vrna_md_t md;
+    set_model_details(&md);
+    Node::cotrans = vrna_cotrans_init(sequence, &md, VRNA_OPTION_MFE);
+  }
+  if(Node::cotrans) Node::mfe = vrna_cotrans_mfe(Node::cotrans, Node::matrix_size, structure);
+  else Node::mfe = fold(sequence, structure);
   Node::mfe_structure=std::string(structure);
   // clean up memory
   delete[] sequence;
@@ -1057,6 +1078,8 @@ void Node::CleanUpNode(void)
   delete [] pair_table;
   delete [] S;
   delete [] S1;
+  vrna_cotrans_free(Node::cotrans);
+  Node::cotrans=NULL;
 }
 
 
@@ -35,6 +35,7 @@ extern "C" {
   #include "energy_const.h"
   #include "utils.h"
   #include "fold_vars.h"
+  #include "cotranscriptional.h"
 }
 #include "Energy.h"
 #include "MorganHiggs.h"
@@ -81,6 +82,7 @@ set of time and structure pairs
   static std::string front_structure;
   static std::string mfe_structure;
   static double mfe;
+  static vrna_cotrans_t* cotrans;
   static int lookahead;
   static int matrix_size;
   static double energy_barrier;
@@ -454,18 +454,46 @@ int main(int argc, char **argv)
       }
 
       // findpath:
-      for (set<int>::iterator it=to_findpath.begin(); it!=to_findpath.end(); it++) {
-        set<int>::iterator it2=it;
-        it2++;
-        for (; it2!=to_findpath.end(); it2++) {
-          if (args_info.pseudoknots_flag) energy_barr[(*it2)*num+(*it)] = energy_barr[(*it)*num+(*it2)] = find_saddle_pk(seq, output_str[*it].c_str(), output_str[*it2].c_str(), args_info.depth_arg)/100.0;
-          else energy_barr[(*it2)*num+(*it)] = energy_barr[(*it)*num+(*it2)] = find_saddle(seq, output_str[*it].c_str(), output_str[*it2].c_str(), args_info.depth_arg)/100.0;
-          findpath_barr[(*it2)*num+(*it)] = findpath_barr[(*it)*num+(*it2)] = true;
-          if (args_info.verbose_lvl_arg>0 && findpath %10000==0){
-            fprintf(stderr, "Findpath:%7d/%7d\n", findpath, (int)(to_findpath.size()*(to_findpath.size()-1)/2));
+      if (args_info.pseudoknots_flag) {
+        for (set<int>::iterator it=to_findpath.begin(); it!=to_findpath.end(); it++) {
+          set<int>::iterator it2=it;
+          it2++;
+          for (; it2!=to_findpath.end(); it2++) {
+            energy_barr[(*it2)*num+(*it)] = energy_barr[(*it)*num+(*it2)] = find_saddle_pk(seq, output_str[*it].c_str(), output_str[*it2].c_str(), args_info.depth_arg)/100.0;
+            findpath_barr[(*it2)*num+(*it)] = findpath_barr[(*it)*num+(*it2)] = true;
+            if (args_info.verbose_lvl_arg>0 && findpath %10000==0){
+              fprintf(stderr, "Findpath:%7d/%7d\n", findpath, (int)(to_findpath.size()*(to_findpath.size()-1)/2));
+            }
+            findpath++;
+          }
+        }
+      } else {
+        // all pairs at once, such that the library may process them in parallel
+        vector<int> ids(to_findpath.begin(), to_findpath.end());
+        vector<const char*> strs;
+        for (unsigned int i=0; i<ids.size(); i++) strs.push_back(output_str[ids[i]].c_str());
+        strs.push_back(NULL);
+
+        vrna_md_t md;
+        set_model_details(&md);
+        md.num_threads = args_info.numThreads_arg;
+
+        char *sequence = vrna_cut_point_insert(seq, cut_point);
+        vrna_fold_compound_t *fc = vrna_fold_compound(sequence, &md, VRNA_OPTION_EVAL_ONLY);
+        int *saddles = vrna_path_findpath_saddle_batch(fc, &strs[0], args_info.depth_arg);
+
+        int k = ids.size();
+        for (int i=0; i<k; i++) {
+          for (int j=i+1; j<k; j++) {
+            energy_barr[ids[j]*num+ids[i]] = energy_barr[ids[i]*num+ids[j]] = saddles[i*k+j]/100.0;
+            findpath_barr[ids[j]*num+ids[i]] = findpath_barr[ids[i]*num+ids[j]] = true;
           }
-          findpath++;
         }
+        findpath += k*(k-1)/2;
+
+        free(saddles);
+        vrna_fold_compound_free(fc);
+        free(sequence);
       }
 
       // debug output
@@ -64,6 +64,57 @@ typedef struct {
   double      **pUH;
 } helper_arrays;
 
+/*
+ *  Minimum number of iterations of the 5' -> 3' scan a single chunk of the
+ *  chunked (parallel) or streaming computation is responsible for, given as multiple of
+ *  the overlap to its upstream neighbor. The actual number is limited by
+ *  the memory required to keep the results of a chunk until they are handed
+ *  over to the user-defined callback
+ */
+#define PROBS_CHUNK_MIN_FACTOR    2
+#define PROBS_CHUNK_MAX_FACTOR    8
+#define PROBS_CHUNK_MAX_ENTRIES   (1 << 22)
+
+/*
+ *  A single call of the user-defined callback that has been recorded by a
+ *  chunk of the parallel computation. The values are copied from the array
+ *  passed to the callback, where values[0] corresponds to index shift
+ */
+typedef struct {
+  FLT_OR_DBL    *values;
+  int           shift;
+  int           size;
+  int           i;
+  int           max;
+  unsigned int  type;
+} probs_record;
+
+/*
+ *  A chunk of the parallel computation, i.e. the subsequence starting after
+ *  position offset, and the iterations (in coordinates of the subsequence)
+ *  the chunk is responsible for
+ */
+typedef struct {
+  int           offset;
+  int           length;
+  int           pair_size;
+  int           j_first;
+  int           j_last;
+  int           success;
+  probs_record  *records;
+  unsigned int  num_records;
+  unsigned int  max_records;
+} probs_chunk;
+
+/* a plain string as source of a sequence stream */
+typedef struct {
+  const char    *string;
+  unsigned int  length;
+  unsigned int  position;
+} sequence_source;
+
+#include "ViennaRNA/sequence_stream.inc"
+
 /* soft constraint contributions function (interior-loops) */
 typedef FLT_OR_DBL (sc_int)(vrna_fold_compound_t *,
                             int,
@@ -107,6 +158,96 @@ PRIVATE int                   backward_compat           = 0;
  #################################
  */
 
+PRIVATE int
+probs_window(vrna_fold_compound_t       *vc,
+             int                        ulength,
+             unsigned int               options,
+             vrna_probs_window_callback *cb,
+             void                       *data,
+             int                        j_first,
+             int                        j_last);
+
+
+PRIVATE void
+discard_callback(FLT_OR_DBL   *pr,
+                 int          pr_size,
+                 int          i,
+                 int          max,
+                 unsigned int type,
+                 void         *data);
+
+
+PRIVATE int
+probs_chunk_overlap(int window_size,
+                    int ulength);
+
+
+PRIVATE int
+probs_chunk_length(int  window_size,
+                   int  ulength);
+
+
+PRIVATE void
+record_callback(FLT_OR_DBL    *pr,
+                int           pr_size,
+                int           i,
+                int           max,
+                unsigned int  type,
+                void          *data);
+
+
+PRIVATE vrna_exp_param_t *
+probs_chunk_params(const char *sequence,
+                   int        length,
+                   vrna_md_t  *md);
+
+
+PRIVATE void
+probs_chunk_fold(const char       *sequence,
+                 vrna_exp_param_t *params,
+                 int              ulength,
+                 unsigned int     options,
+                 probs_chunk      *chunk);
+
+
+PRIVATE void
+probs_chunk_free(probs_chunk *chunk);
+
+
+PRIVATE int
+probs_window_blocks(sequence_stream             *stream,
+                    vrna_md_t                   *md,
+                    vrna_exp_param_t            *params,
+                    int                         ulength,
+                    unsigned int                options,
+                    vrna_probs_window_callback  *cb,
+                    void                        *data);
+
+
+PRIVATE unsigned int
+sequence_source_read(char         *buffer,
+                     unsigned int size,
+                     void         *data);
+
+
+#ifdef _OPENMP
+
+PRIVATE int
+chunked_probs_possible(vrna_fold_compound_t *fc,
+                       int                  ulength);
+
+
+PRIVATE int
+probs_window_chunked(vrna_fold_compound_t       *fc,
+                     int                        ulength,
+                     unsigned int               options,
+                     vrna_probs_window_callback *cb,
+                     void                       *data);
+
+
+#endif
+
+
 PRIVATE void
 alloc_helper_arrays(vrna_fold_compound_t  *vc,
                     int                   ulength,
@@ -489,6 +630,7 @@ allocate_dp_matrices(vrna_fold_compound_t *vc,
 
 PRIVATE INLINE void
 free_dp_matrices(vrna_fold_compound_t *vc,
+                 int                  j,
                  unsigned int         options)
 {
   char          **ptype;
@@ -509,7 +651,10 @@ free_dp_matrices(vrna_fold_compound_t *vc,
   hc      = vc->hc;
   sc      = vc->sc;
 
-  for (i = MAX2(1, n - (winSize + MAXLOOP)); i <= n; i++) {
+  /* rows that are still allocated after the last iteration j, see rotate_dp_matrices() */
+  for (i = MAX2(1, j - (2 * winSize + MAXLOOP));
+       i <= MIN2(n, MAX2(j + 1, 2 * winSize + MAXLOOP + 2));
+       i++) {
     free(pR[i] + i);
     free(q[i] + i);
     free(qb[i] + i);
@@ -673,21 +818,6 @@ vrna_probs_window(vrna_fold_compound_t        *vc,
                   vrna_probs_window_callback  *cb,
                   void                        *data)
 {
-  unsigned char       hc_decompose;
-  int                 n, i, j, k, maxl, ov, winSize, pairSize, turn;
-  FLT_OR_DBL          temp, Qmax, qbt1, **q, **qb, **qm, **qm2, **pR;
-  double              max_real, *Fwindow;
-  vrna_exp_param_t    *pf_params;
-  vrna_md_t           *md;
-  vrna_mx_pf_t        *matrices;
-  vrna_hc_t           *hc;
-  helper_arrays       aux_arrays;
-  vrna_mx_pf_aux_el_t aux_mx_el;
-  vrna_mx_pf_aux_ml_t aux_mx_ml;
-
-  ov    = 0;
-  Qmax  = 0;
-
   if ((!vc) || (!cb))
     return 0; /* failure */
 
@@ -697,6 +827,85 @@ vrna_probs_window(vrna_fold_compound_t        *vc,
     return 0; /* failure */
   }
 
+#ifdef _OPENMP
+  if (chunked_probs_possible(vc, ulength))
+    return probs_window_chunked(vc, ulength, options, cb, data);
+
+#endif
+
+  return probs_window(vc, ulength, options, cb, data, 1, (int)vc->length + vc->window_size);
+}
+
+
+PUBLIC int
+vrna_probs_window_stream(vrna_md_t                      *md_p,
+                         int                            ulength,
+                         unsigned int                   options,
+                         vrna_sequence_stream_callback  *read,
+                         void                           *read_data,
+                         vrna_probs_window_callback     *cb,
+                         void                           *data)
+{
+  int             success;
+  vrna_md_t       md;
+  sequence_stream stream;
+
+  if ((!read) || (!cb))
+    return 0; /* failure */
+
+  if (md_p)
+    vrna_md_copy(&md, md_p);
+  else
+    vrna_md_set_default(&md);
+
+  if (md.window_size <= 0) {
+    vrna_message_warning("vrna_probs_window_stream: "
+                         "Window size must be set in the model details");
+    return 0; /* failure */
+  }
+
+  sequence_stream_init(&stream, read, read_data);
+
+  success = probs_window_blocks(&stream, &md, NULL, ulength, options, cb, data);
+
+  sequence_stream_free(&stream);
+
+  return success;
+}
+
+
+/*
+ *  The actual 5' -> 3' scan. Only iterations j_first...j_last are reported
+ *  to the callback, and the final output for the 3' end of the sequence is
+ *  only produced if the scan is not stopped early, i.e. j_last = n + winSize
+ */
+PRIVATE int
+probs_window(vrna_fold_compound_t       *vc,
+             int                        ulength,
+             unsigned int               options,
+             vrna_probs_window_callback *cb,
+             void                       *data,
+             int                        j_first,
+             int                        j_last)
+{
+  unsigned char               hc_decompose;
+  int                         n, i, j, k, maxl, ov, ov_discarded, *ov_j, winSize, pairSize,
+                              turn;
+  FLT_OR_DBL                  temp, Qmax, qbt1, **q, **qb, **qm, **qm2, **pR;
+  double                      max_real, *Fwindow;
+  vrna_exp_param_t            *pf_params;
+  vrna_md_t                   *md;
+  vrna_mx_pf_t                *matrices;
+  vrna_hc_t                   *hc;
+  helper_arrays               aux_arrays;
+  vrna_mx_pf_aux_el_t         aux_mx_el;
+  vrna_mx_pf_aux_ml_t         aux_mx_ml;
+  vrna_probs_window_callback  *cb_j;
+
+  ov            = 0;
+  ov_discarded  = 0;
+  Qmax          = 0;
+
   /* here space for initializing everything */
 
   n         = vc->length;
@@ -756,7 +965,11 @@ vrna_probs_window(vrna_fold_compound_t        *vc,
   max_real = (sizeof(FLT_OR_DBL) == sizeof(float)) ? FLT_MAX : DBL_MAX;
 
   /* start recursions */
-  for (j = turn + 2; j <= n + winSize; j++) {
+  for (j = turn + 2; j <= j_last; j++) {
+    /* iterations before j_first only prepare the DP matrices for the following ones */
+    cb_j  = (j < j_first) ? &discard_callback : cb;
+    ov_j  = (j < j_first) ? &ov_discarded : &ov;
+
     if (j <= n) {
       vrna_exp_E_ext_fast_update(vc, j, aux_mx_el);
       for (i = j - turn - 1; i >= MAX2(1, (j - winSize + 1)); i--) {
@@ -830,7 +1043,7 @@ vrna_probs_window(vrna_fold_compound_t        *vc,
           Fwindow[i] = (double)(-log(q[i][j]) - (j - i + 1) * log(pf_params->pf_scale)) *
                        pf_params->kT / 1000.0;
 
-        cb(Fwindow, j, start, winSize, VRNA_PROBS_WINDOW_PF, data);
+        cb_j(Fwindow, j, start, winSize, VRNA_PROBS_WINDOW_PF, data);
         Fwindow += start;
       }
 
@@ -854,21 +1067,21 @@ vrna_probs_window(vrna_fold_compound_t        *vc,
     }
 
     if (j > winSize) {
-      compute_probs(vc, j, &aux_arrays, ulength, cb, data, options, &ov);
+      compute_probs(vc, j, &aux_arrays, ulength, cb_j, data, options, ov_j);
 
       if ((options & VRNA_PROBS_WINDOW_UP) && (j > winSize + MAXLOOP + 1))
-        compute_pU(vc, j - winSize - MAXLOOP - 1, ulength, &aux_arrays, cb, data, options);
+        compute_pU(vc, j - winSize - MAXLOOP - 1, ulength, &aux_arrays, cb_j, data, options);
 
       if (j > 2 * winSize + MAXLOOP + 1) {
         int start = j - (2 * winSize + MAXLOOP + 1);
         probability_correction(vc, start);
         if (options & VRNA_PROBS_WINDOW_BPP) {
-          cb(pR[start],
-             MIN2(start + winSize, n),
-             start,
-             winSize,
-             VRNA_PROBS_WINDOW_BPP,
-             data);
+          cb_j(pR[start],
+               MIN2(start + winSize, n),
+               start,
+               winSize,
+               VRNA_PROBS_WINDOW_BPP,
+               data);
         }
 
         if (options & VRNA_PROBS_WINDOW_STACKP) {
@@ -876,12 +1089,12 @@ vrna_probs_window(vrna_fold_compound_t        *vc,
           if (start > 1) {
             FLT_OR_DBL *stack_probs = compute_stack_probabilities(vc, start);
             stack_probs -= start + 1;
-            cb(stack_probs,
-               MIN2(n - start + turn, pairSize),
-               start,
-               winSize,
-               VRNA_PROBS_WINDOW_STACKP,
-               data);
+            cb_j(stack_probs,
+                 MIN2(n - start + turn, pairSize),
+                 start,
+                 winSize,
+                 VRNA_PROBS_WINDOW_STACKP,
+                 data);
             stack_probs += start + 1;
             free(stack_probs);
           }
@@ -893,35 +1106,37 @@ vrna_probs_window(vrna_fold_compound_t        *vc,
     } /* end if (do_backtrack) */
   }   /* end for j */
 
-  /* finish output */
-  if (options & VRNA_PROBS_WINDOW_UP)
-    for (j = MAX2(1, n - MAXLOOP); j <= n; j++)
-      compute_pU(vc, j, ulength, &aux_arrays, cb, data, options);
-
-  for (j = MAX2(n - winSize - MAXLOOP, 1); j <= n; j++) {
-    probability_correction(vc, j);
-    if (options & VRNA_PROBS_WINDOW_BPP) {
-      cb(pR[j],
-         MIN2(j + winSize, n),
-         j,
-         winSize,
-         VRNA_PROBS_WINDOW_BPP,
-         data);
-    }
-
-    if ((options & VRNA_PROBS_WINDOW_STACKP) && j < n) {
-      int start = j;
-      if (start > 1) {
-        FLT_OR_DBL *stack_probs = compute_stack_probabilities(vc, start);
-        stack_probs -= start + 1;
-        cb(stack_probs,
-           MIN2(n - start + turn, pairSize),
-           start,
+  /* finish output, unless the scan has been stopped early */
+  if (j_last == n + winSize) {
+    if (options & VRNA_PROBS_WINDOW_UP)
+      for (j = MAX2(1, n - MAXLOOP); j <= n; j++)
+        compute_pU(vc, j, ulength, &aux_arrays, cb, data, options);
+
+    for (j = MAX2(n - winSize - MAXLOOP, 1); j <= n; j++) {
+      probability_correction(vc, j);
+      if (options & VRNA_PROBS_WINDOW_BPP) {
+        cb(pR[j],
+           MIN2(j + winSize, n),
+           j,
            winSize,
-           VRNA_PROBS_WINDOW_STACKP,
+           VRNA_PROBS_WINDOW_BPP,
            data);
-        stack_probs += start + 1;
-        free(stack_probs);
+      }
+
+      if ((options & VRNA_PROBS_WINDOW_STACKP) && j < n) {
+        int start = j;
+        if (start > 1) {
+          FLT_OR_DBL *stack_probs = compute_stack_probabilities(vc, start);
+          stack_probs -= start + 1;
+          cb(stack_probs,
+             MIN2(n - start + turn, pairSize),
+             start,
+             winSize,
+             VRNA_PROBS_WINDOW_STACKP,
+             data);
+          stack_probs += start + 1;
+          free(stack_probs);
+        }
       }
     }
   }
@@ -934,7 +1149,7 @@ vrna_probs_window(vrna_fold_compound_t        *vc,
                          pf_params->pf_scale);
   }
 
-  free_dp_matrices(vc, options);
+  free_dp_matrices(vc, j_last, options);
   free_helper_arrays(vc, ulength, &aux_arrays, options);
 
   /* free memory occupied by auxiliary arrays for fast exterior/multibranch loops */
@@ -2061,6 +2276,413 @@ backward_compat_callback(FLT_OR_DBL   *pr,
 }
 
 
+PRIVATE void
+discard_callback(FLT_OR_DBL   *pr,
+                 int          pr_size,
+                 int          i,
+                 int          max,
+                 unsigned int type,
+                 void         *data)
+{
+  return;
+}
+
+
+/*
+ *  Number of nucleotides upstream of the first iteration a chunk is
+ *  responsible for. Every output at iteration j refers to positions of at
+ *  least j - (2 * winSize + MAXLOOP + 1) and all probabilities within the
+ *  first winSize nucleotides of a subsequence suffer from its artificial 5'
+ *  end, which in turn may affect pairs up to another winSize nucleotides
+ *  downstream
+ */
+PRIVATE int
+probs_chunk_overlap(int window_size,
+                    int ulength)
+{
+  return 4 * window_size + 2 * MAX2(MAXLOOP, ulength) + 16;
+}
+
+
+PRIVATE int
+probs_chunk_length(int  window_size,
+                   int  ulength)
+{
+  int overlap;
+
+  overlap = probs_chunk_overlap(window_size, ulength);
+
+  return MAX2(PROBS_CHUNK_MIN_FACTOR * overlap,
+              MIN2(PROBS_CHUNK_MAX_FACTOR * overlap,
+                   PROBS_CHUNK_MAX_ENTRIES / (window_size + 1)));
+}
+
+
+/*
+ *  Record a callback execution of a chunk and translate the positions
+ *  into coordinates of the full sequence
+ */
+PRIVATE void
+record_callback(FLT_OR_DBL    *pr,
+                int           pr_size,
+                int           i,
+                int           max,
+                unsigned int  type,
+                void          *data)
+{
+  int           first, last;
+  probs_chunk   *chunk;
+  probs_record  *rec;
+
+  chunk = (probs_chunk *)data;
+
+  if (type & VRNA_PROBS_WINDOW_PF) {
+    first = i;
+    last  = pr_size;
+  } else if (type & VRNA_PROBS_WINDOW_BPP) {
+    first = i;
+    last  = i + max;
+  } else if (type & VRNA_PROBS_WINDOW_UP) {
+    first = 0;
+    last  = MAX2(MAXLOOP, max) + 1;
+  } else if (type & VRNA_PROBS_WINDOW_STACKP) {
+    first = i + 1;
+    last  = MIN2(i + chunk->pair_size, chunk->length);
+  } else {
+    return;
+  }
+
+  if (chunk->num_records == chunk->max_records) {
+    chunk->max_records  = (chunk->max_records) ? 2 * chunk->max_records : 1024;
+    chunk->records      = (probs_record *)vrna_realloc(chunk->records,
+                                                       sizeof(probs_record) *
+                                                       chunk->max_records);
+  }
+
+  rec         = chunk->records + chunk->num_records++;
+  rec->values = (FLT_OR_DBL *)vrna_alloc(sizeof(FLT_OR_DBL) * (MAX2(last - first, 0) + 1));
+  if (last >= first)
+    memcpy(rec->values, pr + first, sizeof(FLT_OR_DBL) * (last - first + 1));
+
+  rec->shift  = first;
+  rec->size   = pr_size;
+  rec->i      = i + chunk->offset;
+  rec->max    = max;
+  rec->type   = type;
+
+  /* the size argument of partition functions and pair probabilities is a position as well */
+  if (type & (VRNA_PROBS_WINDOW_PF | VRNA_PROBS_WINDOW_BPP))
+    rec->size += chunk->offset;
+
+  /* unpaired probabilities are indexed by length rather than position */
+  if (!(type & VRNA_PROBS_WINDOW_UP))
+    rec->shift += chunk->offset;
+}
+
+
+/*
+ *  Boltzmann factors shared by all chunks of a streaming computation, with
+ *  the model settings sanitized in the same way as for the fold compound of
+ *  a chunk. Note, that the scaling factor does not depend on the sequence
+ *  length under the sliding window approach
+ */
+PRIVATE vrna_exp_param_t *
+probs_chunk_params(const char *sequence,
+                   int        length,
+                   vrna_md_t  *md)
+{
+  char                  *subsequence;
+  vrna_exp_param_t      *P;
+  vrna_fold_compound_t  *sub;
+
+  P           = NULL;
+  subsequence = (char *)vrna_alloc(sizeof(char) * (length + 1));
+  memcpy(subsequence, sequence, sizeof(char) * length);
+
+  sub = vrna_fold_compound(subsequence, md, VRNA_OPTION_PF | VRNA_OPTION_WINDOW);
+
+  if (sub) {
+    if (vrna_fold_compound_prepare(sub, VRNA_OPTION_PF | VRNA_OPTION_WINDOW))
+      P = vrna_exp_params_copy(sub->exp_params);
+
+    vrna_fold_compound_free(sub);
+  }
+
+  free(subsequence);
+
+  return P;
+}
+
+
+/*
+ *  Compute the output of a chunk, where sequence points to the first
+ *  nucleotide of its subsequence
+ */
+PRIVATE void
+probs_chunk_fold(const char       *sequence,
+                 vrna_exp_param_t *params,
+                 int              ulength,
+                 unsigned int     options,
+                 probs_chunk      *chunk)
+{
+  char                  *subsequence;
+  vrna_md_t             md;
+  vrna_fold_compound_t  *sub;
+
+  subsequence = (char *)vrna_alloc(sizeof(char) * (chunk->length + 1));
+  memcpy(subsequence, sequence, sizeof(char) * chunk->length);
+
+  vrna_md_copy(&md, &(params->model_details));
+  md.num_threads = 1;
+
+  sub               = vrna_fold_compound(subsequence, &md, VRNA_OPTION_PF | VRNA_OPTION_WINDOW);
+  chunk->pair_size  = md.max_bp_span;
+  chunk->success    = 0;
+
+  if (sub) {
+    /* use exactly the same Boltzmann factors, including the scaling factor, as the parent */
+    vrna_exp_params_subst(sub, params);
+
+    if (vrna_fold_compound_prepare(sub, VRNA_OPTION_PF | VRNA_OPTION_WINDOW))
+      chunk->success = probs_window(sub,
+                                    ulength,
+                                    options,
+                                    &record_callback,
+                                    (void *)chunk,
+                                    chunk->j_first,
+                                    MIN2(chunk->j_last, (int)sub->length + sub->window_size));
+
+    vrna_fold_compound_free(sub);
+  }
+
+  free(subsequence);
+}
+
+
+PRIVATE void
+probs_chunk_free(probs_chunk *chunk)
+{
+  unsigned int k;
+
+  for (k = 0; k < chunk->num_records; k++)
+    free(chunk->records[k].values);
+
+  free(chunk->records);
+  chunk->records      = NULL;
+  chunk->num_records  = 0;
+  chunk->max_records  = 0;
+}
+
+
+/*
+ *  Block-wise variant of the sliding window scan for single sequences that
+ *  are read from a stream. The iterations of the 5' -> 3' scan are split
+ *  into consecutive blocks, and each block is computed for a subsequence
+ *  that extends far enough up- and downstream to reproduce the probabilities
+ *  of the serial scan. Batches of blocks are computed in parallel and their
+ *  output is passed to the callback in the same order as in the serial scan.
+ *  If params is NULL, the Boltzmann factors are derived from the model
+ *  settings md
+ */
+PRIVATE int
+probs_window_blocks(sequence_stream             *stream,
+                    vrna_md_t                   *md,
+                    vrna_exp_param_t            *params,
+                    int                         ulength,
+                    unsigned int                options,
+                    vrna_probs_window_callback  *cb,
+                    void                        *data)
+{
+  int               n, t, cnt, done, success, num_threads, window_size, overlap, body,
+                    margin, j_done, j_last, start, end;
+  unsigned int      k;
+  probs_chunk       *chunks, *chunk;
+  probs_record      *rec;
+  vrna_exp_param_t  *P;
+
+  /* empty sequence */
+  if (sequence_stream_fill(stream, 1) == 0)
+    return 1;
+
+#ifdef _OPENMP
+  num_threads = MAX2(1, md->num_threads);
+#else
+  num_threads = 1;
+#endif
+
+  window_size = md->window_size;
+  overlap     = probs_chunk_overlap(window_size, ulength);
+  body        = probs_chunk_length(window_size, ulength);
+  margin      = window_size + MAX2(MAXLOOP, ulength) + 2;
+  chunks      = (probs_chunk *)vrna_alloc(sizeof(probs_chunk) * num_threads);
+  P           = params;
+  j_done      = 0;
+  done        = 0;
+  success     = 1;
+
+  while ((!done) && (success)) {
+    /* release all nucleotides that are not required by the next batch anymore */
+    sequence_stream_discard(stream, MAX2(1, j_done + 1 - overlap));
+
+    /* prepare the next batch of chunks */
+    for (cnt = 0; (cnt < num_threads) && (!done); cnt++) {
+      chunk   = chunks + cnt;
+      j_last  = j_done + body;
+      n       = sequence_stream_fill(stream, j_last + margin + 1);
+
+      /* let the last chunk finish the scan */
+      if (j_last + margin >= n) {
+        j_last  = n + window_size;
+        done    = 1;
+      }
+
+      start = MAX2(1, j_done + 1 - overlap);
+      end   = (done) ? n : j_last + margin;
+
+      memset(chunk, 0, sizeof(probs_chunk));
+      chunk->offset   = start - 1;
+      chunk->length   = end - start + 1;
+      chunk->j_first  = j_done + 1 - chunk->offset;
+      chunk->j_last   = j_last - chunk->offset;
+
+      j_done = j_last;
+    }
+
+    if (!P) {
+      P = probs_chunk_params(stream->string + chunks[0].offset - stream->offset,
+                             chunks[0].length,
+                             md);
+      if (!P) {
+        success = 0;
+        break;
+      }
+    }
+
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(num_threads) schedule(dynamic, 1)
+#endif
+    for (t = 0; t < cnt; t++)
+      probs_chunk_fold(stream->string + chunks[t].offset - stream->offset,
+                       P,
+                       ulength,
+                       options,
+                       &(chunks[t]));
+
+    /* hand over the recorded output in order, until the first failure */
+    for (t = 0; t < cnt; t++) {
+      chunk = chunks + t;
+
+      if ((success) && (chunk->success)) {
+        for (k = 0; k < chunk->num_records; k++) {
+          rec = chunk->records + k;
+          cb(rec->values - rec->shift, rec->size, rec->i, rec->max, rec->type, data);
+        }
+      } else {
+        success = 0;
+      }
+
+      probs_chunk_free(chunk);
+    }
+  }
+
+  if (P != params)
+    free(P);
+
+  free(chunks);
+
+  return success;
+}
+
+
+PRIVATE unsigned int
+sequence_source_read(char         *buffer,
+                     unsigned int size,
+                     void         *data)
+{
+  unsigned int    r;
+  sequence_source *source;
+
+  source  = (sequence_source *)data;
+  r       = MIN2(size, source->length - source->position);
+
+  memcpy(buffer, source->string + source->position, sizeof(char) * r);
+  source->position += r;
+
+  return r;
+}
+
+
+#ifdef _OPENMP
+
+PRIVATE int
+chunked_probs_possible(vrna_fold_compound_t *fc,
+                       int                  ulength)
+{
+  vrna_md_t *md;
+  vrna_hc_t *hc;
+
+  md  = &(fc->exp_params->model_details);
+  hc  = fc->hc;
+
+  /*
+   *  Splitting the scan into independent chunks only reproduces the serial
+   *  results if all Boltzmann weights solely depend on the sequence. Thus,
+   *  we refuse to do so in the presence of soft constraints, user-defined
+   *  hard constraints, or extensions of the grammar
+   */
+  if ((md->num_threads < 2) ||
+      (fc->type != VRNA_FC_TYPE_SINGLE) ||
+      (fc->sc) ||
+      (hc->up_storage) ||
+      (hc->bp_storage) ||
+      (hc->f) ||
+      (fc->domains_up) ||
+      (fc->aux_grammar))
+    return 0;
+
+  return ((int)fc->length >= 2 * probs_chunk_length(fc->window_size, ulength)) ? 1 : 0;
+}
+
+
+/*
+ *  Chunked variant of the sliding window scan for long single sequences,
+ *  i.e. the block-wise scan with the sequence of the fold compound as
+ *  source
+ */
+PRIVATE int
+probs_window_chunked(vrna_fold_compound_t       *fc,
+                     int                        ulength,
+                     unsigned int               options,
+                     vrna_probs_window_callback *cb,
+                     void                       *data)
+{
+  int             success;
+  sequence_source source;
+  sequence_stream stream;
+
+  source.string   = fc->sequence;
+  source.length   = fc->length;
+  source.position = 0;
+
+  sequence_stream_init(&stream, &sequence_source_read, (void *)&source);
+
+  success = probs_window_blocks(&stream,
+                                &(fc->exp_params->model_details),
+                                fc->exp_params,
+                                ulength,
+                                options,
+                                cb,
+                                data);
+
+  sequence_stream_free(&stream);
+
+  return success;
+}
+
+
+#endif
+
+
 #ifndef VRNA_DISABLE_BACKWARD_COMPATIBILITY
 
 /*
@@ -62,6 +62,12 @@ PRIVATE char *wrap_get_ptypes(const short *S,
                               vrna_md_t   *md);                 /* provides backward compatibility for old ptypes array in pf computations */
 
 
+PRIVATE char *get_ptypes_col_wise(const short   *S,
+                                  unsigned int  length,
+                                  vrna_md_t     *md,
+                                  unsigned int  span);          /* ptypes array for (possibly banded) column-wise index */
+
+
 /*
  #################################
  # BEGIN OF FUNCTION DEFINITIONS #
@@ -70,7 +76,12 @@ PRIVATE char *wrap_get_ptypes(const short *S,
 PUBLIC unsigned int
 vrna_sequence_length_max(unsigned int options)
 {
-  if (options & VRNA_OPTION_WINDOW)
+  /*
+   *  sliding window and banded matrices never address pairs beyond
+   *  the maximum base pair span, and their recursions do not read
+   *  the sequence length from the encoded sequence
+   */
+  if (options & (VRNA_OPTION_WINDOW | VRNA_OPTION_BANDED))
     return (unsigned int)INT_MAX;
 
   /*
@@ -169,8 +180,10 @@ vrna_ptypes_prepare(vrna_fold_compound_t  *fc,
             (char **)vrna_realloc(fc->ptype_local, sizeof(char *) * (fc->length + 1));
         } else {
           if (!fc->ptype)
-            fc->ptype = vrna_ptypes(fc->sequence_encoding2,
-                                    &(fc->params->model_details));
+            fc->ptype = get_ptypes_col_wise(fc->sequence_encoding2,
+                                            fc->length,
+                                            &(fc->params->model_details),
+                                            fc->jindx_span);
         }
 
         break;
@@ -191,11 +204,14 @@ vrna_ptypes_prepare(vrna_fold_compound_t  *fc,
             (char **)vrna_realloc(fc->ptype_local, sizeof(char *) * (fc->length + 1));
         } else {
           if (!fc->ptype)
-            fc->ptype = vrna_ptypes(fc->sequence_encoding2, &(fc->exp_params->model_details));
+            fc->ptype = get_ptypes_col_wise(fc->sequence_encoding2,
+                                            fc->length,
+                                            &(fc->exp_params->model_details),
+                                            fc->jindx_span);
 
 #ifndef VRNA_DISABLE_BACKWARD_COMPATIBILITY
-          /* backward compatibility ptypes */
-          if (!fc->ptype_pf_compat)
+          /* backward compatibility ptypes, not available for banded matrices */
+          if ((!fc->ptype_pf_compat) && (!fc->jindx_span))
             fc->ptype_pf_compat = get_ptypes(fc->sequence_encoding2,
                                              &(fc->exp_params->model_details),
                                              1);
@@ -219,11 +235,7 @@ PUBLIC char *
 vrna_ptypes(const short *S,
             vrna_md_t   *md)
 {
-  char  *ptype;
-  int   n, i, j, k, l, *idx;
-  int   min_loop_size = md->min_loop_size;
-
-  n = S[0];
+  int n = S[0];
 
   if ((unsigned int)n > vrna_sequence_length_max(VRNA_OPTION_DEFAULT)) {
     vrna_message_warning("vrna_ptypes@alphabet.c: sequence length of %d exceeds addressable range",
@@ -231,8 +243,32 @@ vrna_ptypes(const short *S,
     return NULL;
   }
 
-  ptype = (char *)vrna_alloc(sizeof(char) * ((n * (n + 1)) / 2 + 2));
-  idx   = vrna_idx_col_wise(n);
+  return get_ptypes_col_wise(S, (unsigned int)n, md, 0);
+}
+
+
+PRIVATE char *
+get_ptypes_col_wise(const short   *S,
+                    unsigned int  length,
+                    vrna_md_t     *md,
+                    unsigned int  span)
+{
+  char  *ptype;
+  int   n, i, j, k, l, max_d, *idx;
+  int   min_loop_size = md->min_loop_size;
+
+  n = (int)length;
+
+  if (span) {
+    /* only pairs within the band are addressable */
+    ptype = (char *)vrna_alloc(sizeof(char) * (n + 1) * (span + 3));
+    idx   = vrna_idx_col_wise_banded(n, span);
+    max_d = (int)span + 1;
+  } else {
+    ptype = (char *)vrna_alloc(sizeof(char) * ((n * (n + 1)) / 2 + 2));
+    idx   = vrna_idx_col_wise(n);
+    max_d = n;
+  }
 
   for (k = 1; k < n - min_loop_size; k++)
     for (l = 1; l <= 2; l++) {
@@ -243,7 +279,7 @@ vrna_ptypes(const short *S,
         continue;
 
       type = md->pair[S[i]][S[j]];
-      while ((i >= 1) && (j <= n)) {
+      while ((i >= 1) && (j <= n) && (j - i <= max_d)) {
         if ((i > 1) && (j < n))
           ntype = md->pair[S[i - 1]][S[j + 1]];
 
@@ -11,10 +11,15 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
 #include <string.h>
 #include <float.h>
 #include <math.h>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 #include "ViennaRNA/utils/basic.h"
 #include "ViennaRNA/params/default.h"
 #include "ViennaRNA/fold_vars.h"
@@ -50,6 +55,17 @@
 #endif
 
 
+/*
+ *  Number of samples each thread draws in one round of parallel Boltzmann
+ *  sampling before the samples are passed to the callback in input order
+ */
+#define PARALLEL_SAMPLES_PER_THREAD   1024
+
+/* state of a random number stream used for seeded, reproducible sampling */
+struct bs_rng {
+  uint64_t state;
+};
+
 /* combination of soft constraint wrappers */
 struct sc_wrappers {
   struct sc_wrapper_exp_ext sc_wrapper_ext;
@@ -57,6 +73,12 @@ struct sc_wrappers {
   struct sc_wrapper_exp_ml  sc_wrapper_ml;
 };
 
+/* buffer that collects samples of a single thread */
+struct sample_buffer {
+  unsigned int  num;
+  char          **list;
+};
+
 /*
  * In the following:
  * - q_remain is a pointer to value of sum of Boltzmann factors of still accessible solutions at that point
@@ -109,6 +131,30 @@ PRIVATE char  *info_no_circ =
  #################################
  */
 
+PRIVATE int
+sampling_prerequisites(vrna_fold_compound_t *fc,
+                       unsigned int         length);
+
+
+PRIVATE void
+prepare_q1k_qln(vrna_fold_compound_t *fc);
+
+
+PRIVATE void
+rng_init(struct bs_rng  *rng,
+         unsigned int   seed,
+         unsigned int   stream);
+
+
+PRIVATE INLINE double
+bs_urn(struct bs_rng *rng);
+
+
+PRIVATE void
+store_sample_buffer(const char  *structure,
+                    void        *data);
+
+
 PRIVATE struct vrna_pbacktrack_memory_s *
 nr_init(vrna_fold_compound_t *fc);
 
@@ -127,7 +173,8 @@ wrap_pbacktrack(vrna_fold_compound_t              *vc,
                 unsigned int                      num_samples,
                 vrna_boltzmann_sampling_callback  *bs_cb,
                 void                              *data,
-                struct vrna_pbacktrack_memory_s   *nr_mem);
+                struct vrna_pbacktrack_memory_s   *nr_mem,
+                struct bs_rng                     *rng);
 
 
 PRIVATE int
@@ -136,6 +183,7 @@ backtrack(int                             i,
           char                            *pstruc,
           vrna_fold_compound_t            *vc,
           struct sc_wrappers              *sc_wrap,
+          struct bs_rng                   *rng,
           struct vrna_pbacktrack_memory_s *nr_mem);
 
 
@@ -145,6 +193,7 @@ backtrack_ext_loop(int                              init_val,
                    vrna_fold_compound_t             *vc,
                    int                              length,
                    struct sc_wrappers               *sc_wrap,
+                   struct bs_rng                    *rng,
                    struct vrna_pbacktrack_memory_s  *nr_mem);
 
 
@@ -154,6 +203,7 @@ backtrack_qm(int                              i,
              char                             *pstruc,
              vrna_fold_compound_t             *vc,
              struct sc_wrappers               *sc_wrap,
+             struct bs_rng                    *rng,
              struct vrna_pbacktrack_memory_s  *nr_mem);
 
 
@@ -163,6 +213,7 @@ backtrack_qm1(int                             i,
               char                            *pstruc,
               vrna_fold_compound_t            *vc,
               struct sc_wrappers              *sc_wrap,
+              struct bs_rng                   *rng,
               struct vrna_pbacktrack_memory_s *nr_mem);
 
 
@@ -171,14 +222,16 @@ backtrack_qm2(int                   u,
               int                   n,
               char                  *pstruc,
               vrna_fold_compound_t  *vc,
-              struct sc_wrappers    *sc_wrap);
+              struct sc_wrappers    *sc_wrap,
+              struct bs_rng         *rng);
 
 
 PRIVATE unsigned int
 pbacktrack_circ(vrna_fold_compound_t              *fc,
                 unsigned int                      num_samples,
                 vrna_boltzmann_sampling_callback  *bs_cb,
-                void                              *data);
+                void                              *data,
+                struct bs_rng                     *rng);
 
 
 /*
@@ -197,21 +250,8 @@ vrna_pbacktrack5_resume_cb(vrna_fold_compound_t             *fc,
 {
   unsigned int i = 0;
 
-  if (fc) {
-    vrna_mx_pf_t *matrices = fc->exp_matrices;
-
-    if (length > fc->length) {
-      vrna_message_warning("vrna_pbacktrack5*(): length exceeds sequence length");
-    } else if (length == 0) {
-      vrna_message_warning("vrna_pbacktrack5*(): length too small");
-    } else if ((!matrices) || (!matrices->q) || (!matrices->qb) || (!matrices->qm) ||
-               (!fc->exp_params)) {
-      vrna_message_warning("vrna_pbacktrack*(): %s", info_call_pf);
-    } else if ((!fc->exp_params->model_details.uniq_ML) || (!matrices->qm1)) {
-      vrna_message_warning("vrna_pbacktrack*(): %s", info_set_uniq_ml);
-    } else if ((fc->exp_params->model_details.circ) && (length < fc->length)) {
-      vrna_message_warning("vrna_pbacktrack5*(): %s", info_no_circ);
-    } else if (options & VRNA_PBACKTRACK_NON_REDUNDANT) {
+  if ((fc) && (sampling_prerequisites(fc, length))) {
+    if (options & VRNA_PBACKTRACK_NON_REDUNDANT) {
       if (fc->exp_params->model_details.circ) {
         vrna_message_warning("vrna_pbacktrack5*(): %s", info_no_circ);
       } else if (!nr_mem) {
@@ -220,7 +260,7 @@ vrna_pbacktrack5_resume_cb(vrna_fold_compound_t             *fc,
         if (*nr_mem == NULL)
           *nr_mem = nr_init(fc);
 
-        i = wrap_pbacktrack(fc, length, num_samples, bs_cb, data, *nr_mem);
+        i = wrap_pbacktrack(fc, length, num_samples, bs_cb, data, *nr_mem, NULL);
 
         /* print warning if we've aborted backtracking too early */
         if ((i > 0) && (i < num_samples)) {
@@ -231,13 +271,13 @@ vrna_pbacktrack5_resume_cb(vrna_fold_compound_t             *fc,
                                i,
                                100. *
                                return_node_weight((*nr_mem)->root_node) /
-                               fc->exp_matrices->q[fc->iindx[1] - length]);
+                               fc->exp_matrices->q1k[length]);
         }
       }
     } else if (fc->exp_params->model_details.circ) {
-      i = pbacktrack_circ(fc, num_samples, bs_cb, data);
+      i = pbacktrack_circ(fc, num_samples, bs_cb, data, NULL);
     } else {
-      i = wrap_pbacktrack(fc, length, num_samples, bs_cb, data, NULL);
+      i = wrap_pbacktrack(fc, length, num_samples, bs_cb, data, NULL, NULL);
     }
   }
 
@@ -245,6 +285,125 @@ vrna_pbacktrack5_resume_cb(vrna_fold_compound_t             *fc,
 }
 
 
+PUBLIC unsigned int
+vrna_pbacktrack5_parallel_cb(vrna_fold_compound_t             *fc,
+                             unsigned int                     num_samples,
+                             unsigned int                     length,
+                             unsigned int                     seed,
+                             vrna_boltzmann_sampling_callback *bs_cb,
+                             void                             *data,
+                             unsigned int                     options)
+{
+  int                   t, num_threads, circ, *failed;
+  unsigned int          i, k, done, round, chunk;
+  struct bs_rng         *rng;
+  struct sample_buffer  *buffers;
+
+  i = 0;
+
+  if ((!fc) || (!sampling_prerequisites(fc, length)))
+    return i;
+
+  circ        = fc->exp_params->model_details.circ;
+  num_threads = fc->exp_params->model_details.num_threads;
+  num_threads = (num_threads > 1) ? num_threads : 1;
+
+  if (options & VRNA_PBACKTRACK_NON_REDUNDANT) {
+    /* non-redundant sampling depends on all previous samples, so we draw them sequentially */
+    struct vrna_pbacktrack_memory_s *nr_mem;
+    struct bs_rng                   single_rng;
+
+    if (circ) {
+      vrna_message_warning("vrna_pbacktrack5*(): %s", info_no_circ);
+    } else {
+      rng_init(&single_rng, seed, 0);
+      nr_mem  = nr_init(fc);
+      i       = wrap_pbacktrack(fc, length, num_samples, bs_cb, data, nr_mem, &single_rng);
+      vrna_pbacktrack_mem_free(nr_mem);
+    }
+
+    return i;
+  }
+
+  if (!circ)
+    prepare_q1k_qln(fc);
+
+  chunk   = PARALLEL_SAMPLES_PER_THREAD;
+  rng     = (struct bs_rng *)vrna_alloc(sizeof(struct bs_rng) * num_threads);
+  buffers = (struct sample_buffer *)vrna_alloc(sizeof(struct sample_buffer) * num_threads);
+  failed  = (int *)vrna_alloc(sizeof(int) * num_threads);
+
+  for (t = 0; t < num_threads; t++) {
+    rng_init(&(rng[t]), seed, (unsigned int)t);
+    buffers[t].list = (char **)vrna_alloc(sizeof(char *) * chunk);
+  }
+
+  /*
+   *  Each thread draws samples from its own random number stream. Samples are
+   *  generated in rounds of at most 'chunk' samples per thread and are passed to
+   *  the callback in thread order after each round. This keeps memory requirements
+   *  bounded and yields reproducible results for a given seed and number of threads
+   */
+  for (done = 0; done < num_samples; done += round) {
+    round = MIN2(num_samples - done, chunk * num_threads);
+
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(num_threads) if (num_threads > 1) schedule(static, 1)
+#endif
+    for (t = 0; t < num_threads; t++) {
+      unsigned int first, cnt, got;
+
+      first           = (unsigned int)t * chunk;
+      cnt             = (round > first) ? MIN2(chunk, round - first) : 0;
+      buffers[t].num  = 0;
+      got             = 0;
+
+      if (cnt > 0) {
+        if (circ)
+          got = pbacktrack_circ(fc, cnt, &store_sample_buffer, (void *)&(buffers[t]), &(rng[t]));
+        else
+          got = wrap_pbacktrack(fc,
+                                length,
+                                cnt,
+                                &store_sample_buffer,
+                                (void *)&(buffers[t]),
+                                NULL,
+                                &(rng[t]));
+      }
+
+      failed[t] = (got < cnt) ? 1 : 0;
+    }
+
+    /* pass samples to the callback in deterministic order */
+    for (t = 0; t < num_threads; t++) {
+      for (k = 0; k < buffers[t].num; k++) {
+        if (bs_cb)
+          bs_cb(buffers[t].list[k], data);
+
+        free(buffers[t].list[k]);
+        i++;
+      }
+    }
+
+    for (t = 0; t < num_threads; t++)
+      if (failed[t])
+        break;
+
+    if (t < num_threads)
+      break;
+  }
+
+  for (t = 0; t < num_threads; t++)
+    free(buffers[t].list);
+
+  free(buffers);
+  free(rng);
+  free(failed);
+
+  return i; /* actual number of structures backtraced */
+}
+
+
 PUBLIC void
 vrna_pbacktrack_mem_free(struct vrna_pbacktrack_memory_s *s)
 {
@@ -264,6 +423,110 @@ vrna_pbacktrack_mem_free(struct vrna_pbacktrack_memory_s *s)
  # BEGIN OF STATIC HELPER FUNCTIONS  #
  #####################################
  */
+PRIVATE int
+sampling_prerequisites(vrna_fold_compound_t *fc,
+                       unsigned int         length)
+{
+  vrna_mx_pf_t *matrices = fc->exp_matrices;
+
+  if (length > fc->length) {
+    vrna_message_warning("vrna_pbacktrack5*(): length exceeds sequence length");
+  } else if (length == 0) {
+    vrna_message_warning("vrna_pbacktrack5*(): length too small");
+  } else if ((!matrices) || (!matrices->q) || (!matrices->qb) || (!matrices->qm) ||
+             (!fc->exp_params)) {
+    vrna_message_warning("vrna_pbacktrack*(): %s", info_call_pf);
+  } else if ((!fc->exp_params->model_details.uniq_ML) || (!matrices->qm1)) {
+    vrna_message_warning("vrna_pbacktrack*(): %s", info_set_uniq_ml);
+  } else if ((fc->exp_params->model_details.circ) && (length < fc->length)) {
+    vrna_message_warning("vrna_pbacktrack5*(): %s", info_no_circ);
+  } else {
+    return 1;
+  }
+
+  return 0;
+}
+
+
+/* prepare the exterior loop arrays q1k and qln if not already present */
+PRIVATE void
+prepare_q1k_qln(vrna_fold_compound_t *fc)
+{
+  unsigned int  i, n;
+  int           *my_iindx;
+  FLT_OR_DBL    *q;
+  vrna_mx_pf_t  *matrices;
+
+  n         = fc->length;
+  my_iindx  = fc->iindx;
+  matrices  = fc->exp_matrices;
+  q         = matrices->q;
+
+  if (!(matrices->q1k && matrices->qln)) {
+    free(matrices->q1k);
+    free(matrices->qln);
+    matrices->q1k = (FLT_OR_DBL *)vrna_alloc(sizeof(FLT_OR_DBL) * (n + 1));
+    matrices->qln = (FLT_OR_DBL *)vrna_alloc(sizeof(FLT_OR_DBL) * (n + 2));
+
+    if (fc->jindx_span) {
+      /* banded matrices lack the segments [1, j] and [i, n] */
+      vrna_exp_E_ext_loop_5(fc);
+      vrna_exp_E_ext_loop_3(fc);
+    } else {
+      for (i = 1; i <= n; i++) {
+        matrices->q1k[i]  = q[my_iindx[1] - i];
+        matrices->qln[i]  = q[my_iindx[i] - n];
+      }
+      matrices->q1k[0]      = 1.0;
+      matrices->qln[n + 1]  = 1.0;
+    }
+  }
+}
+
+
+/* SplitMix64 finalizer */
+PRIVATE INLINE uint64_t
+rng_mix(uint64_t z)
+{
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+
+/* initialize an independent random number stream for a given seed and stream number */
+PRIVATE void
+rng_init(struct bs_rng  *rng,
+         unsigned int   seed,
+         unsigned int   stream)
+{
+  rng->state = rng_mix(((uint64_t)seed << 32) ^ rng_mix((uint64_t)stream + 1));
+}
+
+
+/* uniform random number in [0,1) from the stream rng, or from vrna_urn() if rng is NULL */
+PRIVATE INLINE double
+bs_urn(struct bs_rng *rng)
+{
+  if (rng) {
+    rng->state += 0x9e3779b97f4a7c15ULL;
+    return (double)(rng_mix(rng->state) >> 11) * (1.0 / 9007199254740992.0);
+  }
+
+  return vrna_urn();
+}
+
+
+PRIVATE void
+store_sample_buffer(const char  *structure,
+                    void        *data)
+{
+  struct sample_buffer *b = (struct sample_buffer *)data;
+
+  b->list[b->num++] = (structure) ? strdup(structure) : NULL;
+}
+
+
 PRIVATE struct sc_wrappers *
 sc_init(vrna_fold_compound_t *fc)
 {
@@ -297,7 +560,9 @@ nr_init(vrna_fold_compound_t *fc)
 
   s = (struct vrna_pbacktrack_memory_s *)vrna_alloc(
     sizeof(struct vrna_pbacktrack_memory_s));
-  pf          = fc->exp_matrices->q[fc->iindx[1] - fc->length];
+  /* banded matrices lack the segment [1, n], see prepare_q1k_qln() */
+  prepare_q1k_qln(fc);
+  pf          = fc->exp_matrices->q1k[fc->length];
   block_size  = 5000 * sizeof(NR_NODE);
 
   s->memory_dat = NULL;
@@ -323,38 +588,19 @@ wrap_pbacktrack(vrna_fold_compound_t              *vc,
                 unsigned int                      num_samples,
                 vrna_boltzmann_sampling_callback  *bs_cb,
                 void                              *data,
-                struct vrna_pbacktrack_memory_s   *nr_mem)
+                struct vrna_pbacktrack_memory_s   *nr_mem,
+                struct bs_rng                     *rng)
 {
   char                *pstruc;
-  unsigned int        i, n;
-  int                 ret, pf_overflow, is_dup, *my_iindx;
-  FLT_OR_DBL          *q1k, *qln, *q;
-  vrna_mx_pf_t        *matrices;
+  unsigned int        i;
+  int                 ret, pf_overflow, is_dup;
   struct sc_wrappers  *sc_wrap;
 
   i           = 0;
   pf_overflow = 0;
   sc_wrap     = sc_init(vc);
 
-  n         = vc->length;
-  my_iindx  = vc->iindx;
-  matrices  = vc->exp_matrices;
-  q         = matrices->q;
-  q1k       = matrices->q1k;
-  qln       = matrices->qln;
-
-  if (!(q1k && qln)) {
-    matrices->q1k = (FLT_OR_DBL *)vrna_alloc(sizeof(FLT_OR_DBL) * (n + 1));
-    matrices->qln = (FLT_OR_DBL *)vrna_alloc(sizeof(FLT_OR_DBL) * (n + 2));
-    q1k           = matrices->q1k;
-    qln           = matrices->qln;
-    for (i = 1; i <= n; i++) {
-      q1k[i]  = q[my_iindx[1] - i];
-      qln[i]  = q[my_iindx[i] - n];
-    }
-    q1k[0]      = 1.0;
-    qln[n + 1]  = 1.0;
-  }
+  prepare_q1k_qln(vc);
 
   for (i = 0; i < num_samples; i++) {
     is_dup  = 1;
@@ -363,12 +609,12 @@ wrap_pbacktrack(vrna_fold_compound_t              *vc,
     memset(pstruc, '.', sizeof(char) * length);
 
     if (nr_mem)
-      nr_mem->q_remain = vc->exp_matrices->q[vc->iindx[1] - length];
+      nr_mem->q_remain = vc->exp_matrices->q1k[length];
 
 #ifdef VRNA_WITH_BOUSTROPHEDON
-    ret = backtrack_ext_loop(length, pstruc, vc, length, sc_wrap, nr_mem);
+    ret = backtrack_ext_loop(length, pstruc, vc, length, sc_wrap, rng, nr_mem);
 #else
-    ret = backtrack_ext_loop(1, pstruc, vc, length, sc_wrap, nr_mem);
+    ret = backtrack_ext_loop(1, pstruc, vc, length, sc_wrap, rng, nr_mem);
 #endif
 
     if (nr_mem) {
@@ -419,9 +665,9 @@ backtrack_ext_loop(int                              init_val,
                    vrna_fold_compound_t             *vc,
                    int                              length,
                    struct sc_wrappers               *sc_wrap,
+                   struct bs_rng                    *rng,
                    struct vrna_pbacktrack_memory_s  *nr_mem)
 {
-  unsigned char             *hard_constraints;
   short                     *S1, *S2, **S, **S5, **S3;
   unsigned int              **a2s, s, n_seq;
   int                       ret, i, j, ij, n, k, u, type, *my_iindx, hc_decompose, *hc_up_ext;
@@ -482,7 +728,6 @@ backtrack_ext_loop(int                              init_val,
     a2s   = vc->a2s;
   }
 
-  hard_constraints  = hc->mx;
   hc_up_ext         = hc->up_ext;
   sc_wrapper_ext    = &(sc_wrap->sc_wrapper_ext);
 
@@ -525,7 +770,7 @@ backtrack_ext_loop(int                              init_val,
             return 0;
         }
 
-        r       = vrna_urn() * (q1k[j] - fbd);
+        r       = bs_urn(rng) * (q1k[j] - fbd);
         q_temp  = q1k[j - 1] * scale[1];
 
         if (sc_wrapper_ext->red_ext)
@@ -573,7 +818,7 @@ backtrack_ext_loop(int                              init_val,
             (*q_remain);
     }
 
-    r = vrna_urn() * (q1k[j] - q_temp - fbd);
+    r = bs_urn(rng) * (q1k[j] - q_temp - fbd);
     u = j - 1;
     i = 2;
 
@@ -582,7 +827,7 @@ backtrack_ext_loop(int                              init_val,
       i = (int)(1 + (u - 1) * ((k - 1) % 2)) +
           (int)((1 - (2 * ((k - 1) % 2))) * ((k - 1) / 2));
       ij            = my_iindx[i] - j;
-      hc_decompose  = hard_constraints[n * j + i];
+      hc_decompose  = vrna_hc_mx_get(hc, j, i);
       if (hc_decompose & VRNA_CONSTRAINT_CONTEXT_EXT_LOOP) {
         qkl = qb[ij] *
               q1k[i - 1];
@@ -656,9 +901,9 @@ backtrack_ext_loop(int                              init_val,
       }
     }
 
-    backtrack(i, j, pstruc, vc, sc_wrap, nr_mem);
+    backtrack(i, j, pstruc, vc, sc_wrap, rng, nr_mem);
     j   = i - 1;
-    ret = backtrack_ext_loop(j, pstruc, vc, length, sc_wrap, nr_mem);
+    ret = backtrack_ext_loop(j, pstruc, vc, length, sc_wrap, rng, nr_mem);
   }
 
 #else
@@ -673,7 +918,7 @@ backtrack_ext_loop(int                              init_val,
                 (*q_remain);
         }
 
-        r       = vrna_urn() * (qln[i] - fbd);
+        r       = bs_urn(rng) * (qln[i] - fbd);
         q_temp  = qln[i + 1] * scale[1];
 
         if (sc_wrapper_ext->red_ext)
@@ -721,10 +966,10 @@ backtrack_ext_loop(int                              init_val,
             (*q_remain);
     }
 
-    r = vrna_urn() * (qln[i] - q_temp - fbd);
+    r = bs_urn(rng) * (qln[i] - q_temp - fbd);
     for (qt = 0, j = i + 1; j <= length; j++) {
       ij            = my_iindx[i] - j;
-      hc_decompose  = hard_constraints[n * i + j];
+      hc_decompose  = vrna_hc_mx_get(hc, i, j);
       if (hc_decompose & VRNA_CONSTRAINT_CONTEXT_EXT_LOOP) {
         qkl = qb[ij];
         if (vc->type == VRNA_FC_TYPE_SINGLE) {
@@ -800,11 +1045,11 @@ backtrack_ext_loop(int                              init_val,
     }
 
     start = j + 1;
-    ret   = backtrack(i, j, pstruc, vc, sc_wrap, nr_mem);
+    ret   = backtrack(i, j, pstruc, vc, sc_wrap, rng, nr_mem);
     if (!ret)
       return ret;
 
-    ret = backtrack_ext_loop(start, pstruc, vc, length, sc_wrap, nr_mem);
+    ret = backtrack_ext_loop(start, pstruc, vc, length, sc_wrap, rng, nr_mem);
   }
 
 #endif
@@ -820,6 +1065,7 @@ backtrack_qm(int                              i,
              char                             *pstruc,
              vrna_fold_compound_t             *vc,
              struct sc_wrappers               *sc_wrap,
+             struct bs_rng                    *rng,
              struct vrna_pbacktrack_memory_s  *nr_mem)
 {
   /* divide multiloop into qm and qm1  */
@@ -887,7 +1133,7 @@ backtrack_qm(int                              i,
             (*q_remain);
     }
 
-    r = vrna_urn() * (qm[my_iindx[i] - j] - fbd);
+    r = bs_urn(rng) * (qm[my_iindx[i] - j] - fbd);
     if (current_node) {
       fbds = NR_GET_WEIGHT(*current_node, memorized_node_cur, NRT_QM_UNPAIR, i, 0) *
              qm[my_iindx[i] - j] /
@@ -1008,7 +1254,7 @@ backtrack_qm(int                              i,
     if (cnt > j)
       return 0;
 
-    ret = backtrack_qm1(k, j, pstruc, vc, sc_wrap, nr_mem);
+    ret = backtrack_qm1(k, j, pstruc, vc, sc_wrap, rng, nr_mem);
 
     if (ret == 0)
       return ret;
@@ -1018,7 +1264,7 @@ backtrack_qm(int                              i,
 
     if (!is_unpaired) {
       /* if we've chosen creating a branch in [i..k-1] */
-      ret = backtrack_qm(i, k - 1, pstruc, vc, sc_wrap, nr_mem);
+      ret = backtrack_qm(i, k - 1, pstruc, vc, sc_wrap, rng, nr_mem);
 
       if (ret == 0)
         return ret;
@@ -1035,13 +1281,13 @@ backtrack_qm1(int                             i,
               char                            *pstruc,
               vrna_fold_compound_t            *vc,
               struct sc_wrappers              *sc_wrap,
+              struct bs_rng                   *rng,
               struct vrna_pbacktrack_memory_s *nr_mem)
 {
   /* i is paired to l, i<l<j; backtrack in qm1 to find l */
-  unsigned char             *hard_constraints;
   char                      *ptype;
   short                     *S1, **S, **S5, **S3;
-  unsigned int              n, s, n_seq;
+  unsigned int              s, n_seq;
   int                       ii, l, il, type, turn, u, *my_iindx, *jindx, *hc_up_ml;
   FLT_OR_DBL                qt, fbd, fbds, r, q_temp, *qm1, *qb, *expMLbase;
   double                    *q_remain;
@@ -1071,7 +1317,6 @@ backtrack_qm1(int                             i,
   NR_NODE *memorized_node_cur   = NULL;           /* remembers actual node in linked list */
 #endif
 
-  n                 = vc->length;
   fbd               = 0.;
   fbds              = 0.;
   pf_params         = vc->exp_params;
@@ -1080,7 +1325,6 @@ backtrack_qm1(int                             i,
   jindx             = vc->jindx;
   hc                = vc->hc;
   hc_up_ml          = hc->up_ml;
-  hard_constraints  = hc->mx;
   sc_wrapper_ml     = &(sc_wrap->sc_wrapper_ml);
 
   matrices  = vc->exp_matrices;
@@ -1119,11 +1363,11 @@ backtrack_qm1(int                             i,
           (*q_remain);
   }
 
-  r   = vrna_urn() * (qm1[jindx[j] + i] - fbd);
+  r   = bs_urn(rng) * (qm1[jindx[j] + i] - fbd);
   ii  = my_iindx[i];
   for (qt = 0., l = j; l > i + turn; l--) {
     il = jindx[l] + i;
-    if (hard_constraints[n * i + l] & VRNA_CONSTRAINT_CONTEXT_MB_LOOP_ENC) {
+    if (vrna_hc_mx_get(hc, i, l) & VRNA_CONSTRAINT_CONTEXT_MB_LOOP_ENC) {
       u = j - l;
       if (hc_up_ml[l + 1] >= u) {
         q_temp = qb[ii - l] *
@@ -1191,7 +1435,7 @@ backtrack_qm1(int                             i,
     }
   }
 
-  return backtrack(i, l, pstruc, vc, sc_wrap, nr_mem);
+  return backtrack(i, l, pstruc, vc, sc_wrap, rng, nr_mem);
 }
 
 
@@ -1200,7 +1444,8 @@ backtrack_qm2(int                   k,
               int                   n,
               char                  *pstruc,
               vrna_fold_compound_t  *vc,
-              struct sc_wrappers    *sc_wrap)
+              struct sc_wrappers    *sc_wrap,
+              struct bs_rng         *rng)
 {
   int                       u, turn, *jindx;
   FLT_OR_DBL                qom2t, r, *qm1, *qm2;
@@ -1212,7 +1457,7 @@ backtrack_qm2(int                   k,
   turn          = vc->exp_params->model_details.min_loop_size;
   sc_wrapper_ml = &(sc_wrap->sc_wrapper_ml);
 
-  r = vrna_urn() * qm2[k];
+  r = bs_urn(rng) * qm2[k];
   /* we have to search for our barrier u between qm1 and qm1  */
   if (sc_wrapper_ml->decomp_ml) {
     for (qom2t = 0., u = k + turn + 1; u < n - turn - 1; u++) {
@@ -1234,8 +1479,8 @@ backtrack_qm2(int                   k,
   if (u == n - turn)
     vrna_message_error("backtrack failed in qm2");
 
-  backtrack_qm1(k, u, pstruc, vc, sc_wrap, NULL);
-  backtrack_qm1(u + 1, n, pstruc, vc, sc_wrap, NULL);
+  backtrack_qm1(k, u, pstruc, vc, sc_wrap, rng, NULL);
+  backtrack_qm1(u + 1, n, pstruc, vc, sc_wrap, rng, NULL);
 }
 
 
@@ -1245,12 +1490,13 @@ backtrack(int                             i,
           char                            *pstruc,
           vrna_fold_compound_t            *vc,
           struct sc_wrappers              *sc_wrap,
+          struct bs_rng                   *rng,
           struct vrna_pbacktrack_memory_s *nr_mem)
 {
-  unsigned char             *hard_constraints, hc_decompose;
+  unsigned char             hc_decompose;
   char                      *ptype;
   short                     *S1, **S, **S5, **S3;
-  unsigned int              **a2s, s, n_seq, n, type, type_2, *types, u1_local, u2_local;
+  unsigned int              **a2s, s, n_seq, type, type_2, *types, u1_local, u2_local;
   int                       *my_iindx, *jindx, *hc_up_int, ret, *pscore, turn, *rtype,
                             k, l, kl, u1, u2, max_k, min_l, ii, jj;
   FLT_OR_DBL                *qb, *qm, *qm1, *scale, r, fbd, fbds, qbt1, qbr, qt, q_temp,
@@ -1289,7 +1535,6 @@ backtrack(int                             i,
   qbt1    = 0.;
   q_temp  = 0.;
 
-  n         = vc->length;
   pf_params = vc->exp_params;
   kTn       = pf_params->kT / 10.;
   md        = &(pf_params->model_details);
@@ -1324,7 +1569,6 @@ backtrack(int                             i,
 
   hc                = vc->hc;
   hc_up_int         = hc->up_int;
-  hard_constraints  = hc->mx;
   sc_wrapper_int    = &(sc_wrap->sc_wrapper_int);
   sc_wrapper_ml     = &(sc_wrap->sc_wrapper_ml);
 
@@ -1342,7 +1586,7 @@ backtrack(int                             i,
 
 #endif
 
-  hc_decompose = hard_constraints[n * j + i];
+  hc_decompose = vrna_hc_mx_get(hc, j, i);
 
   do {
     k = i;
@@ -1364,10 +1608,10 @@ backtrack(int                             i,
     pstruc[i - 1] = '(';
     pstruc[j - 1] = ')';
 
-    r     = vrna_urn() * (qbr - fbd);
+    r     = bs_urn(rng) * (qbr - fbd);
     qbt1  = 0.;
 
-    hc_decompose = hard_constraints[n * i + j];
+    hc_decompose = vrna_hc_mx_get(hc, i, j);
 
     /* hairpin contribution */
     q_temp = vrna_exp_E_hp_loop(vc, i, j);
@@ -1423,7 +1667,7 @@ backtrack(int                             i,
           if (hc_up_int[l + 1] < u2)
             break;
 
-          if (hard_constraints[n * k + l] & VRNA_CONSTRAINT_CONTEXT_INT_LOOP_ENC) {
+          if (vrna_hc_mx_get(hc, k, l) & VRNA_CONSTRAINT_CONTEXT_INT_LOOP_ENC) {
             q_temp = qb[kl]
                      * scale[u1 + u2 + 2];
 
@@ -1501,7 +1745,7 @@ backtrack(int                             i,
 
         free(types);
 
-        return backtrack(k, l, pstruc, vc, sc_wrap, nr_mem); /* found the interior loop, repeat for inside */
+        return backtrack(k, l, pstruc, vc, sc_wrap, rng, nr_mem); /* found the interior loop, repeat for inside */
       } else {
         /* interior loop contributions did not exceed threshold, so we break */
         break;
@@ -1513,7 +1757,7 @@ backtrack(int                             i,
   } while (1);
 
   /* backtrack in multi-loop */
-  if (hard_constraints[n * j + i] & VRNA_CONSTRAINT_CONTEXT_MB_LOOP) {
+  if (vrna_hc_mx_get(hc, j, i) & VRNA_CONSTRAINT_CONTEXT_MB_LOOP) {
     closingPair = expMLclosing *
                   scale[2];
 
@@ -1621,7 +1865,7 @@ backtrack(int                             i,
 #endif
     }
 
-    ret = backtrack_qm1(k, j, pstruc, vc, sc_wrap, nr_mem);
+    ret = backtrack_qm1(k, j, pstruc, vc, sc_wrap, rng, nr_mem);
 
     if (ret == 0) {
       free(types);
@@ -1630,7 +1874,7 @@ backtrack(int                             i,
 
     j = k - 1;
 
-    ret = backtrack_qm(i, j, pstruc, vc, sc_wrap, nr_mem);
+    ret = backtrack_qm(i, j, pstruc, vc, sc_wrap, rng, nr_mem);
   }
 
   free(types);
@@ -1643,9 +1887,10 @@ PRIVATE unsigned int
 pbacktrack_circ(vrna_fold_compound_t              *vc,
                 unsigned int                      num_samples,
                 vrna_boltzmann_sampling_callback  *bs_cb,
-                void                              *data)
+                void                              *data,
+                struct bs_rng                     *rng)
 {
-  unsigned char             *hc_mx, eval_loop;
+  unsigned char             eval_loop;
   char                      *pstruc;
   short                     *S1, *S2, **S, **S5, **S3;
   unsigned int              type, type2, *tt, s, n_seq, **a2s, u1_local,
@@ -1654,6 +1899,7 @@ pbacktrack_circ(vrna_fold_compound_t              *vc,
                             ln1, ln2, ln3, lstart;
   FLT_OR_DBL                r, qt, q_temp, qo, qmo, *scale, *qb, *qm, *qm2,
                             qb_ij, expMLclosing;
+  vrna_hc_t                 *hc;
   vrna_exp_param_t          *pf_params;
   vrna_md_t                 *md;
   vrna_mx_pf_t              *matrices;
@@ -1677,7 +1923,7 @@ pbacktrack_circ(vrna_fold_compound_t              *vc,
   qm2   = matrices->qm2;
   scale = matrices->scale;
 
-  hc_mx = vc->hc->mx;
+  hc    = vc->hc;
   hc_up = vc->hc->up_int;
 
   sc_wrap         = sc_init(vc);
@@ -1719,7 +1965,7 @@ pbacktrack_circ(vrna_fold_compound_t              *vc,
     if (sc_wrapper_ext->red_up)
       qt *= sc_wrapper_ext->red_up(1, n, sc_wrapper_ext);
 
-    r = vrna_urn() * qo;
+    r = bs_urn(rng) * qo;
 
     /* open chain? */
     if (qt > r)
@@ -1739,12 +1985,12 @@ pbacktrack_circ(vrna_fold_compound_t              *vc,
 
         /* found a hairpin? so backtrack in the enclosed part and we're done  */
         if (qt > r) {
-          backtrack(i, j, pstruc, vc, sc_wrap, NULL);
+          backtrack(i, j, pstruc, vc, sc_wrap, rng, NULL);
           goto pbacktrack_circ_loop_end;
         }
 
         /* 2. search for (k,l) with which we can close an interior loop  */
-        if (hc_mx[n * i + j] & VRNA_CONSTRAINT_CONTEXT_INT_LOOP) {
+        if (vrna_hc_mx_get(hc, i, j) & VRNA_CONSTRAINT_CONTEXT_INT_LOOP) {
           if (vc->type == VRNA_FC_TYPE_SINGLE)
             type = vrna_get_ptype_md(S2[j], S2[i], md);
           else
@@ -1773,7 +2019,7 @@ pbacktrack_circ(vrna_fold_compound_t              *vc,
               if ((ln1 + ln2 + ln3) > MAXLOOP)
                 continue;
 
-              eval_loop = hc_mx[n * k + l] & VRNA_CONSTRAINT_CONTEXT_INT_LOOP;
+              eval_loop = vrna_hc_mx_get(hc, k, l) & VRNA_CONSTRAINT_CONTEXT_INT_LOOP;
 
               if (eval_loop) {
                 q_temp = qb_ij *
@@ -1821,8 +2067,8 @@ pbacktrack_circ(vrna_fold_compound_t              *vc,
                  * forward and backtracking the both enclosed parts and we're done
                  */
                 if (qt > r) {
-                  backtrack(i, j, pstruc, vc, sc_wrap, NULL);
-                  backtrack(k, l, pstruc, vc, sc_wrap, NULL);
+                  backtrack(i, j, pstruc, vc, sc_wrap, rng, NULL);
+                  backtrack(k, l, pstruc, vc, sc_wrap, rng, NULL);
                   goto pbacktrack_circ_loop_end;
                 }
               }
@@ -1834,7 +2080,7 @@ pbacktrack_circ(vrna_fold_compound_t              *vc,
     {
       /* as we reach this part, we have to search for our barrier between qm and qm2  */
       qt  = 0.;
-      r   = vrna_urn() * qmo;
+      r   = bs_urn(rng) * qmo;
       if (sc_wrapper_ml->decomp_ml) {
         for (k = turn + 2; k < n - 2 * turn - 3; k++) {
           qt += qm[my_iindx[1] - k] *
@@ -1849,8 +2095,8 @@ pbacktrack_circ(vrna_fold_compound_t              *vc,
 
           /* backtrack in qm and qm2 if we've found a valid barrier k  */
           if (qt > r) {
-            backtrack_qm(1, k, pstruc, vc, sc_wrap, NULL);
-            backtrack_qm2(k + 1, n, pstruc, vc, sc_wrap);
+            backtrack_qm(1, k, pstruc, vc, sc_wrap, rng, NULL);
+            backtrack_qm2(k + 1, n, pstruc, vc, sc_wrap, rng);
             goto pbacktrack_circ_loop_end;
           }
         }
@@ -1861,8 +2107,8 @@ pbacktrack_circ(vrna_fold_compound_t              *vc,
                 expMLclosing;
           /* backtrack in qm and qm2 if we've found a valid barrier k  */
           if (qt > r) {
-            backtrack_qm(1, k, pstruc, vc, sc_wrap, NULL);
-            backtrack_qm2(k + 1, n, pstruc, vc, sc_wrap);
+            backtrack_qm(1, k, pstruc, vc, sc_wrap, rng, NULL);
+            backtrack_qm2(k + 1, n, pstruc, vc, sc_wrap, rng);
             goto pbacktrack_circ_loop_end;
           }
         }
@@ -388,6 +388,52 @@ vrna_pbacktrack5_resume_cb(vrna_fold_compound_t             *fc,
                            unsigned int                     options);
 
 
+/**
+ *  @brief Obtain a set of secondary structure samples for a subsequence in parallel using seeded random number streams
+ *
+ *  This function draws @p num_samples secondary structures of the subsequence of length
+ *  @p length starting at the 5' end from the Boltzmann ensemble, just like vrna_pbacktrack5_cb().
+ *  However, the samples are drawn by up to vrna_md_t.num_threads threads that share the
+ *  (read-only) partition function matrices of @p fc. Instead of the global random number
+ *  generator used by vrna_urn(), each thread uses its own random number stream derived from
+ *  @p seed. Samples are passed to the callback @p cb in the calling thread and in
+ *  deterministic order, such that the same seed and number of threads always yields the same
+ *  sample sequence.
+ *
+ *  @pre    Unique multiloop decomposition has to be active upon creation of @p fc with vrna_fold_compound()
+ *          or similar. This can be done easily by passing vrna_fold_compound() a model details parameter
+ *          with vrna_md_t.uniq_ML = 1.
+ *  @pre    vrna_pf() has to be called first to fill the partition function matrices
+ *
+ *  @note This function is polymorphic. It accepts #vrna_fold_compound_t of type
+ *        #VRNA_FC_TYPE_SINGLE, and #VRNA_FC_TYPE_COMPARATIVE.
+ *
+ *  @note Non-redundant sampling (#VRNA_PBACKTRACK_NON_REDUNDANT) requires knowledge of all previous
+ *        samples. In this mode, samples are always drawn sequentially from a single seeded random
+ *        number stream.
+ *
+ *  @see  vrna_pbacktrack5_cb(), vrna_pbacktrack_parallel_cb(), vrna_pbacktrack_parallel_num(),
+ *        #vrna_md_t.num_threads, #VRNA_PBACKTRACK_DEFAULT, #VRNA_PBACKTRACK_NON_REDUNDANT
+ *
+ *  @param  fc            The fold compound data structure
+ *  @param  num_samples   The size of the sample set, i.e. number of structures
+ *  @param  length        The length of the subsequence to consider (starting with 5' end)
+ *  @param  seed          The seed for the random number streams
+ *  @param  cb            The callback that receives the sampled structure
+ *  @param  data          A data structure passed through to the callback @p cb
+ *  @param  options       A bitwise OR-flag indicating the backtracing mode.
+ *  @return               The number of structures actually backtraced
+ */
+unsigned int
+vrna_pbacktrack5_parallel_cb(vrna_fold_compound_t             *fc,
+                             unsigned int                     num_samples,
+                             unsigned int                     length,
+                             unsigned int                     seed,
+                             vrna_boltzmann_sampling_callback *cb,
+                             void                             *data,
+                             unsigned int                     options);
+
+
 /**
  *  @brief Sample a secondary structure from the Boltzmann ensemble according its probability
  *
@@ -681,6 +727,52 @@ vrna_pbacktrack_resume_cb(vrna_fold_compound_t              *fc,
                           unsigned int                      options);
 
 
+/**
+ *  @brief Obtain a set of secondary structure samples in parallel using seeded random number streams
+ *
+ *  This is a convenience wrapper for vrna_pbacktrack5_parallel_cb() that samples structures
+ *  of the entire sequence.
+ *
+ *  @see  vrna_pbacktrack5_parallel_cb(), vrna_pbacktrack_parallel_num(), vrna_pbacktrack_cb()
+ *
+ *  @param  fc            The fold compound data structure
+ *  @param  num_samples   The size of the sample set, i.e. number of structures
+ *  @param  seed          The seed for the random number streams
+ *  @param  cb            The callback that receives the sampled structure
+ *  @param  data          A data structure passed through to the callback @p cb
+ *  @param  options       A bitwise OR-flag indicating the backtracing mode.
+ *  @return               The number of structures actually backtraced
+ */
+unsigned int
+vrna_pbacktrack_parallel_cb(vrna_fold_compound_t              *fc,
+                            unsigned int                      num_samples,
+                            unsigned int                      seed,
+                            vrna_boltzmann_sampling_callback  *cb,
+                            void                              *data,
+                            unsigned int                      options);
+
+
+/**
+ *  @brief Obtain a list of secondary structure samples in parallel using seeded random number streams
+ *
+ *  This is a convenience wrapper for vrna_pbacktrack5_parallel_cb() that samples structures
+ *  of the entire sequence and returns them as a list.
+ *
+ *  @see  vrna_pbacktrack5_parallel_cb(), vrna_pbacktrack_parallel_cb(), vrna_pbacktrack_num()
+ *
+ *  @param  fc            The fold compound data structure
+ *  @param  num_samples   The size of the sample set, i.e. number of structures
+ *  @param  seed          The seed for the random number streams
+ *  @param  options       A bitwise OR-flag indicating the backtracing mode.
+ *  @return               A set of secondary structure samples in dot-bracket notation terminated by NULL (or NULL on error)
+ */
+char **
+vrna_pbacktrack_parallel_num(vrna_fold_compound_t *fc,
+                             unsigned int         num_samples,
+                             unsigned int         seed,
+                             unsigned int         options);
+
+
 /**
  *  @brief  Release memory occupied by a Boltzmann sampling memory data structure
  *
@@ -273,6 +273,66 @@ vrna_pbacktrack_resume_cb(vrna_fold_compound_t              *fc,
 }
 
 
+PUBLIC unsigned int
+vrna_pbacktrack_parallel_cb(vrna_fold_compound_t              *fc,
+                            unsigned int                      num_samples,
+                            unsigned int                      seed,
+                            vrna_boltzmann_sampling_callback  *bs_cb,
+                            void                              *data,
+                            unsigned int                      options)
+{
+  if (fc) {
+    return vrna_pbacktrack5_parallel_cb(fc,
+                                        num_samples,
+                                        fc->length,
+                                        seed,
+                                        bs_cb,
+                                        data,
+                                        options);
+  }
+
+  return 0;
+}
+
+
+PUBLIC char **
+vrna_pbacktrack_parallel_num(vrna_fold_compound_t *fc,
+                             unsigned int         num_samples,
+                             unsigned int         seed,
+                             unsigned int         options)
+{
+  unsigned int          i;
+  struct structure_list data;
+
+  if (fc) {
+    data.num      = 0;
+    data.list     = (char **)vrna_alloc(sizeof(char *) * (num_samples + 1));
+    data.list[0]  = NULL;
+
+    i = vrna_pbacktrack5_parallel_cb(fc,
+                                     num_samples,
+                                     fc->length,
+                                     seed,
+                                     &store_sample_list,
+                                     (void *)&data,
+                                     options);
+
+    if (i > 0) {
+      /* re-allocate memory */
+      data.list           = (char **)vrna_realloc(data.list, sizeof(char *) * (data.num + 1));
+      data.list[data.num] = NULL;
+    } else {
+      free(data.list);
+      return NULL;
+    }
+
+    return data.list;
+  }
+
+  return NULL;
+}
+
+
 /*
  #####################################
  # BEGIN OF STATIC HELPER FUNCTIONS  #
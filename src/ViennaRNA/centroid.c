@@ -133,7 +133,7 @@ PUBLIC char *
 vrna_centroid(vrna_fold_compound_t  *vc,
               double                *dist)
 {
-  int               i, j, k, length, turn;
+  int               i, j, k, length, turn, max_d;
   FLT_OR_DBL        p;
   char              *centroid;
   short             *S;
@@ -161,13 +161,14 @@ vrna_centroid(vrna_fold_compound_t  *vc,
   matrices  = vc->exp_matrices;
   probs     = matrices->probs;
   turn      = pf_params->model_details.min_loop_size;
+  max_d     = (vc->jindx_span) ? (int)vc->jindx_span + 1 : length;
 
   *dist     = 0.;
   centroid  = (char *)vrna_alloc((length + 1) * sizeof(char));
   for (i = 0; i < length; i++)
     centroid[i] = '.';
   for (i = 1; i <= length; i++)
-    for (j = i + turn + 1; j <= length; j++) {
+    for (j = i + turn + 1; j <= MIN2(length, i + max_d); j++) {
       if ((p = probs[my_iindx[i] - j]) > 0.5) {
         if (pf_params->model_details.gquad) {
           /* check for presence of gquadruplex */
@@ -193,7 +193,7 @@ fill_arrays(vrna_fold_compound_t  *vc,
   unsigned int  strands, *sn, *ss, *se, *so;
   int           i, j, length, energy;
   int           uniq_ML;
-  int           no_close, type, maxj, *indx;
+  int           no_close, type, maxj, max_d, *indx;
   int           *my_f5, *my_c, *my_fML, *my_fM1, *my_fc;
   int           *cc, *cc1;  /* auxilary arrays for canonical structures     */
   int           *Fmi;       /* holds row i of fML (avoids jumps in memory)  */
@@ -203,7 +203,6 @@ fill_arrays(vrna_fold_compound_t  *vc,
 
   int           dangle_model, noGUclosure, noLP, hc_decompose, turn;
   char          *ptype;
-  unsigned char *hard_constraints;
   vrna_param_t  *P;
   vrna_mx_mfe_t *matrices;
   vrna_hc_t     *hc;
@@ -222,7 +221,6 @@ fill_arrays(vrna_fold_compound_t  *vc,
   se                = vc->strand_end;
   so                = vc->strand_order;
   hc                = vc->hc;
-  hard_constraints  = hc->mx;
   matrices          = vc->matrices;
   my_f5             = matrices->f5;
   my_c              = matrices->c;
@@ -230,6 +228,7 @@ fill_arrays(vrna_fold_compound_t  *vc,
   my_fM1            = matrices->fM1;
   my_fc             = matrices->fc;
   turn              = P->model_details.min_loop_size;
+  max_d             = (vc->jindx_span) ? (int)vc->jindx_span + 1 : length;
 
   /* allocate memory for all helper arrays */
   cc    = (int *)vrna_alloc(sizeof(int) * (length + 2));
@@ -249,7 +248,7 @@ fill_arrays(vrna_fold_compound_t  *vc,
   }
 
   for (j = 1; j <= length; j++)
-    for (i = 1; i <= j; i++) {
+    for (i = MAX2(1, j - max_d); i <= j; i++) {
       my_c[indx[j] + i] = my_fML[indx[j] + i] = INF;
       if (uniq_ML)
         my_fM1[indx[j] + i] = INF;
@@ -259,11 +258,11 @@ fill_arrays(vrna_fold_compound_t  *vc,
     /* i,j in [1..length] */
 
     maxj = (zuker) ? (MIN2(i + se[so[0]], length)) : length;
-    for (j = i + turn + 1; j <= maxj; j++) {
+    for (j = i + turn + 1; (j <= maxj) && (j - i <= max_d); j++) {
       int ij;
       ij            = indx[j] + i;
       type          = vrna_get_ptype(ij, ptype);
-      hc_decompose  = hard_constraints[length * i + j];
+      hc_decompose  = vrna_hc_mx_get(hc, i, j);
       energy        = INF;
 
       no_close = (((type == 3) || (type == 4)) && noGUclosure);
@@ -572,7 +571,6 @@ free_end(int                  *array,
   vrna_param_t  *P;
   short         *S1;
   char          *ptype;
-  unsigned char *hard_constraints;
   vrna_mx_mfe_t *matrices;
   vrna_hc_t     *hc;
   vrna_sc_t     *sc;
@@ -592,7 +590,6 @@ free_end(int                  *array,
   ggg               = matrices->ggg;
   hc                = vc->hc;
   sc                = vc->sc;
-  hard_constraints  = hc->mx;
 
   if (hc->up_ext[i]) {
     if (i == start)
@@ -634,7 +631,7 @@ free_end(int                  *array,
       jj  = j;
     }                           /* inc<0 */
 
-    if (hard_constraints[length * ii + jj] & VRNA_CONSTRAINT_CONTEXT_EXT_LOOP) {
+    if (vrna_hc_mx_get(hc, ii, jj) & VRNA_CONSTRAINT_CONTEXT_EXT_LOOP) {
       type    = vrna_get_ptype(indx[jj] + ii, ptype);
       si      = ((ii > 1) && (sn[ii - 1] == sn[ii])) ? S1[ii - 1] : -1;
       sj      = ((jj < length) && (sn[jj] == sn[jj + 1])) ? S1[jj + 1] : -1;
@@ -713,7 +710,7 @@ free_end(int                  *array,
         jj  = j;
       }                             /* inc<0 */
 
-      if (!(hard_constraints[length * ii + jj] & VRNA_CONSTRAINT_CONTEXT_EXT_LOOP))
+      if (!(vrna_hc_mx_get(hc, ii, jj) & VRNA_CONSTRAINT_CONTEXT_EXT_LOOP))
         continue;
 
       type    = vrna_get_ptype(indx[jj] + ii, ptype);
@@ -828,7 +825,8 @@ doubleseq(vrna_fold_compound_t *vc)
   free(vc->iindx);
   vc->iindx = vrna_idx_row_wise(vc->length);
   free(vc->jindx);
-  vc->jindx = vrna_idx_col_wise(vc->length);
+  vc->jindx       = vrna_idx_col_wise(vc->length);
+  vc->jindx_span  = 0; /* the dimer recursions require full matrices */
 
   vrna_hc_init(vc);
 
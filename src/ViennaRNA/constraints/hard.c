@@ -55,6 +55,44 @@ default_pair_constraint(vrna_fold_compound_t  *fc,
                         int                   j);
 
 
+PRIVATE INLINE unsigned int
+hc_matrix_idx(unsigned int  i,
+              unsigned int  j);
+
+
+PRIVATE INLINE int
+hc_bp_in_band(vrna_fold_compound_t  *fc,
+              int                   i,
+              int                   j);
+
+
+PRIVATE INLINE unsigned char *
+hc_mx_ptr(vrna_hc_t     *hc,
+          unsigned int  i,
+          unsigned int  j);
+
+
+PRIVATE INLINE void
+hc_mx_set(vrna_hc_t     *hc,
+          unsigned int  i,
+          unsigned int  j,
+          unsigned char constraint);
+
+
+PRIVATE INLINE void
+hc_mx_and(vrna_hc_t     *hc,
+          unsigned int  i,
+          unsigned int  j,
+          unsigned char mask);
+
+
+PRIVATE INLINE void
+hc_mx_or(vrna_hc_t      *hc,
+         unsigned int   i,
+         unsigned int   j,
+         unsigned char  type);
+
+
 PRIVATE void
 hc_init_up_storage(vrna_hc_t *hc);
 
@@ -183,8 +221,17 @@ vrna_hc_init(vrna_fold_compound_t *vc)
   hc          = (vrna_hc_t *)vrna_alloc(sizeof(vrna_hc_t));
   hc->type    = VRNA_HC_DEFAULT;
   hc->n       = n;
-  hc->matrix  = (unsigned char *)vrna_alloc(sizeof(unsigned char) * ((n * (n + 1)) / 2 + 2));
-  hc->mx      = (unsigned char *)vrna_alloc(sizeof(unsigned char) * ((n + 1) * (n + 1)));
+  hc->mx_span = vc->jindx_span;
+
+  if (hc->mx_span) {
+    /* banded matrix, the (deprecated) upper triangular matrix is not available */
+    hc->matrix  = NULL;
+    hc->mx      = (unsigned char *)vrna_alloc(sizeof(unsigned char) * ((n + 1) * (2 * hc->mx_span + 1)));
+  } else {
+    hc->matrix  = (unsigned char *)vrna_alloc(sizeof(unsigned char) * ((n * (n + 1)) / 2 + 2));
+    hc->mx      = (unsigned char *)vrna_alloc(sizeof(unsigned char) * ((n + 1) * (n + 1)));
+  }
+
   hc->up_ext  = (int *)vrna_alloc(sizeof(int) * (n + 2));
   hc->up_hp   = (int *)vrna_alloc(sizeof(int) * (n + 2));
   hc->up_int  = (int *)vrna_alloc(sizeof(int) * (n + 2));
@@ -369,30 +416,27 @@ vrna_hc_add_bp_nonspecific(vrna_fold_compound_t *vc,
         if (option & VRNA_CONSTRAINT_CONTEXT_NO_REMOVE) {
           /* only allow for possibly non-canonical pairs, do not enforce them */
           for (p = 1; p < i; p++) {
-            hc->matrix[vc->jindx[i] + p]  |= t1;
-            hc->mx[n * i + p]             |= t1;
-            hc->mx[n * p + i]             |= t1;
+            if (!hc_bp_in_band(vc, p, i))
+              continue;
+
+            hc_mx_or(hc, p, i, t1);
           }
           for (p = i + 1; p <= vc->length; p++) {
-            hc->matrix[vc->jindx[p] + i]  |= t2;
-            hc->mx[n * i + p]             |= t2;
-            hc->mx[n * p + i]             |= t2;
+            if (!hc_bp_in_band(vc, i, p))
+              break;
+
+            hc_mx_or(hc, i, p, t2);
           }
         } else {
           /* force pairing direction */
-          for (p = 1; p < i; p++) {
-            hc->matrix[vc->jindx[i] + p]  &= t1;
-            hc->mx[n * i + p]             &= t1;
-            hc->mx[n * p + i]             &= t1;
-          }
-          for (p = i + 1; p <= vc->length; p++) {
-            hc->matrix[vc->jindx[p] + i]  &= t2;
-            hc->mx[n * i + p]             &= t2;
-            hc->mx[n * p + i]             &= t2;
-          }
+          for (p = 1; p < i; p++)
+            hc_mx_and(hc, p, i, t1);
+
+          for (p = i + 1; p <= vc->length; p++)
+            hc_mx_and(hc, i, p, t2);
+
           /* nucleotide mustn't be unpaired */
-          hc->matrix[vc->jindx[i] + i]  = VRNA_CONSTRAINT_CONTEXT_NONE;
-          hc->mx[n * i + i]             = VRNA_CONSTRAINT_CONTEXT_NONE;
+          hc_mx_set(hc, i, i, VRNA_CONSTRAINT_CONTEXT_NONE);
         }
 
         hc_update_up(vc);
@@ -408,7 +452,6 @@ vrna_hc_add_bp(vrna_fold_compound_t *vc,
                int                  j,
                unsigned char        option)
 {
-  unsigned int  n;
   int           k, l;
   vrna_hc_t     *hc;
 
@@ -424,10 +467,16 @@ vrna_hc_add_bp(vrna_fold_compound_t *vc,
           j,
           vc->params->model_details.min_loop_size);
         return;
+      } else if (!hc_bp_in_band(vc, i, j)) {
+        vrna_message_warning(
+          "vrna_hc_add_bp: Pairing partners (%d, %d) exceed maximum base pair span of %dnt, omitting constraint",
+          i,
+          j,
+          (int)vc->jindx_span);
+        return;
       }
 
       hc  = vc->hc;
-      n   = hc->n;
 
       if (hc->type == VRNA_HC_WINDOW) {
         hc_init_bp_storage(hc);
@@ -460,18 +509,12 @@ vrna_hc_add_bp(vrna_fold_compound_t *vc,
       } else {
         /* reset ptype in case (i,j) is a non-canonical pair */
         if ((vc->type == VRNA_FC_TYPE_SINGLE) && (option & VRNA_CONSTRAINT_CONTEXT_ALL_LOOPS)) {
-          if (hc->matrix[vc->jindx[j] + i])
-            if (vc->ptype[vc->jindx[j] + i] == 0)
-              vc->ptype[vc->jindx[j] + i] = 7;
-
-          if (hc->mx[n * i + j])
+          if (vrna_hc_mx_get(hc, i, j))
             if (vc->ptype[vc->jindx[j] + i] == 0)
               vc->ptype[vc->jindx[j] + i] = 7;
         }
 
-        hc->matrix[vc->jindx[j] + i]  = option & VRNA_CONSTRAINT_CONTEXT_ALL_LOOPS;
-        hc->mx[n * i + j]             = option & VRNA_CONSTRAINT_CONTEXT_ALL_LOOPS;
-        hc->mx[n * j + i]             = option & VRNA_CONSTRAINT_CONTEXT_ALL_LOOPS;
+        hc_mx_set(hc, i, j, option & VRNA_CONSTRAINT_CONTEXT_ALL_LOOPS);
 
         if (!(option & VRNA_CONSTRAINT_CONTEXT_NO_REMOVE)) {
           /*
@@ -479,55 +522,29 @@ vrna_hc_add_bp(vrna_fold_compound_t *vc,
            * with any other nucleotide k
            */
           for (k = 1; k < i; k++) {
-            hc->matrix[vc->jindx[i] + k]  = VRNA_CONSTRAINT_CONTEXT_NONE;
-            hc->matrix[vc->jindx[j] + k]  = VRNA_CONSTRAINT_CONTEXT_NONE;
+            hc_mx_set(hc, k, i, VRNA_CONSTRAINT_CONTEXT_NONE);
+            hc_mx_set(hc, k, j, VRNA_CONSTRAINT_CONTEXT_NONE);
 
-            hc->mx[n * i + k] = VRNA_CONSTRAINT_CONTEXT_NONE;
-            hc->mx[n * k + i] = VRNA_CONSTRAINT_CONTEXT_NONE;
-            hc->mx[n * j + k] = VRNA_CONSTRAINT_CONTEXT_NONE;
-            hc->mx[n * k + j] = VRNA_CONSTRAINT_CONTEXT_NONE;
-
-            for (l = i + 1; l < j; l++) {
-              hc->matrix[vc->jindx[l] + k] = VRNA_CONSTRAINT_CONTEXT_NONE;
-
-              hc->mx[n * k + l] = VRNA_CONSTRAINT_CONTEXT_NONE;
-              hc->mx[n * l + k] = VRNA_CONSTRAINT_CONTEXT_NONE;
-            }
+            for (l = i + 1; l < j; l++)
+              hc_mx_set(hc, k, l, VRNA_CONSTRAINT_CONTEXT_NONE);
           }
           for (k = i + 1; k < j; k++) {
-            hc->matrix[vc->jindx[k] + i]  = VRNA_CONSTRAINT_CONTEXT_NONE;
-            hc->matrix[vc->jindx[j] + k]  = VRNA_CONSTRAINT_CONTEXT_NONE;
+            hc_mx_set(hc, i, k, VRNA_CONSTRAINT_CONTEXT_NONE);
+            hc_mx_set(hc, k, j, VRNA_CONSTRAINT_CONTEXT_NONE);
 
-            hc->mx[n * i + k] = VRNA_CONSTRAINT_CONTEXT_NONE;
-            hc->mx[n * k + i] = VRNA_CONSTRAINT_CONTEXT_NONE;
-            hc->mx[n * j + k] = VRNA_CONSTRAINT_CONTEXT_NONE;
-            hc->mx[n * k + j] = VRNA_CONSTRAINT_CONTEXT_NONE;
-
-            for (l = j + 1; l <= vc->length; l++) {
-              hc->matrix[vc->jindx[l] + k] = VRNA_CONSTRAINT_CONTEXT_NONE;
-
-              hc->mx[n * k + l] = VRNA_CONSTRAINT_CONTEXT_NONE;
-              hc->mx[n * l + k] = VRNA_CONSTRAINT_CONTEXT_NONE;
-            }
+            for (l = j + 1; l <= vc->length; l++)
+              hc_mx_set(hc, k, l, VRNA_CONSTRAINT_CONTEXT_NONE);
           }
           for (k = j + 1; k <= vc->length; k++) {
-            hc->matrix[vc->jindx[k] + i]  = VRNA_CONSTRAINT_CONTEXT_NONE;
-            hc->matrix[vc->jindx[k] + j]  = VRNA_CONSTRAINT_CONTEXT_NONE;
-
-            hc->mx[n * i + k] = VRNA_CONSTRAINT_CONTEXT_NONE;
-            hc->mx[n * k + i] = VRNA_CONSTRAINT_CONTEXT_NONE;
-            hc->mx[n * j + k] = VRNA_CONSTRAINT_CONTEXT_NONE;
-            hc->mx[n * k + j] = VRNA_CONSTRAINT_CONTEXT_NONE;
+            hc_mx_set(hc, i, k, VRNA_CONSTRAINT_CONTEXT_NONE);
+            hc_mx_set(hc, j, k, VRNA_CONSTRAINT_CONTEXT_NONE);
           }
         }
 
         if (option & VRNA_CONSTRAINT_CONTEXT_ENFORCE) {
           /* do not allow i,j to be unpaired */
-          hc->matrix[vc->jindx[i] + i]  = VRNA_CONSTRAINT_CONTEXT_NONE;
-          hc->matrix[vc->jindx[j] + j]  = VRNA_CONSTRAINT_CONTEXT_NONE;
-
-          hc->mx[n * i + i] = VRNA_CONSTRAINT_CONTEXT_NONE;
-          hc->mx[n * j + j] = VRNA_CONSTRAINT_CONTEXT_NONE;
+          hc_mx_set(hc, i, i, VRNA_CONSTRAINT_CONTEXT_NONE);
+          hc_mx_set(hc, j, j, VRNA_CONSTRAINT_CONTEXT_NONE);
 
           hc_update_up(vc);
         }
@@ -658,6 +675,9 @@ default_pair_constraint(vrna_fold_compound_t  *fc,
   md          = &(fc->params->model_details);
   constraint  = VRNA_CONSTRAINT_CONTEXT_NONE;
 
+  if (!hc_bp_in_band(fc, i, j))
+    return constraint;
+
   switch (fc->type) {
     case VRNA_FC_TYPE_SINGLE:
       S = fc->sequence_encoding2;
@@ -748,6 +768,111 @@ default_pair_constraint(vrna_fold_compound_t  *fc,
 }
 
 
+/*
+ *  The (deprecated) hc->matrix is always addressed as full upper
+ *  triangular matrix. It is only available if hc->mx is not banded
+ */
+PRIVATE INLINE unsigned int
+hc_matrix_idx(unsigned int  i,
+              unsigned int  j)
+{
+  return ((j * (j - 1)) / 2) + i;
+}
+
+
+/*
+ *  Check whether the DP matrices of a fold compound are able to
+ *  store pair (i,j), i.e. whether it lies within the band of a
+ *  span-limited global fold compound
+ */
+PRIVATE INLINE int
+hc_bp_in_band(vrna_fold_compound_t  *fc,
+              int                   i,
+              int                   j)
+{
+  /* the band of hc->mx is the only definition of the pairs a banded compound may form */
+  if ((fc->hc) && (fc->hc->type != VRNA_HC_WINDOW) && (fc->hc->mx_span))
+    return (vrna_hc_mx_index(fc->hc, (unsigned int)i, (unsigned int)j) < 0) ? 0 : 1;
+
+  return 1;
+}
+
+
+/*
+ *  Address of pair (i,j), or unpaired nucleotide i = j, in hc->mx.
+ *  Returns NULL for pairs beyond the band of a banded matrix
+ */
+PRIVATE INLINE unsigned char *
+hc_mx_ptr(vrna_hc_t     *hc,
+          unsigned int  i,
+          unsigned int  j)
+{
+  long idx = vrna_hc_mx_index(hc, i, j);
+
+  return (idx < 0) ? NULL : hc->mx + idx;
+}
+
+
+/*
+ *  Set the hard constraint of pair (i,j), or unpaired nucleotide
+ *  i = j, in both orientations of hc->mx and in the (deprecated)
+ *  hc->matrix. Pairs beyond the band of a banded matrix are silently
+ *  skipped, since they are never allowed anyway
+ */
+PRIVATE INLINE void
+hc_mx_set(vrna_hc_t     *hc,
+          unsigned int  i,
+          unsigned int  j,
+          unsigned char constraint)
+{
+  unsigned char *p;
+
+  if (hc->matrix)
+    hc->matrix[(i < j) ? hc_matrix_idx(i, j) : hc_matrix_idx(j, i)] = constraint;
+
+  if ((p = hc_mx_ptr(hc, i, j))) {
+    *p                    = constraint;
+    *hc_mx_ptr(hc, j, i)  = constraint;
+  }
+}
+
+
+PRIVATE INLINE void
+hc_mx_and(vrna_hc_t     *hc,
+          unsigned int  i,
+          unsigned int  j,
+          unsigned char mask)
+{
+  unsigned char *p;
+
+  if (hc->matrix)
+    hc->matrix[(i < j) ? hc_matrix_idx(i, j) : hc_matrix_idx(j, i)] &= mask;
+
+  if ((p = hc_mx_ptr(hc, i, j))) {
+    *p                    &= mask;
+    *hc_mx_ptr(hc, j, i)  &= mask;
+  }
+}
+
+
+PRIVATE INLINE void
+hc_mx_or(vrna_hc_t      *hc,
+         unsigned int   i,
+         unsigned int   j,
+         unsigned char  type)
+{
+  unsigned char *p;
+
+  if (hc->matrix)
+    hc->matrix[(i < j) ? hc_matrix_idx(i, j) : hc_matrix_idx(j, i)] |= type;
+
+  if ((p = hc_mx_ptr(hc, i, j))) {
+    *p                    |= type;
+    *hc_mx_ptr(hc, j, i)  |= type;
+  }
+}
+
+
 PRIVATE void
 hc_init_up_storage(vrna_hc_t *hc)
 {
@@ -923,10 +1048,7 @@ populate_hc_bp(vrna_fold_compound_t *fc,
     if (hc->type == VRNA_HC_WINDOW) {
       hc->matrix_local[i][j - i] = constraint;
     } else {
-      hc->matrix[fc->jindx[j] + i] = constraint;
-
-      hc->mx[n * i + j] = constraint;
-      hc->mx[n * j + i] = constraint;
+      hc_mx_set(hc, i, j, constraint);
     }
   }
 }
@@ -981,47 +1103,29 @@ hc_add_up(vrna_fold_compound_t  *vc,
       /* force nucleotide to appear unpaired within a certain type of loop */
       /* do not allow i to be paired with any other nucleotide */
       if (!(option & VRNA_CONSTRAINT_CONTEXT_NO_REMOVE)) {
-        for (j = 1; j < i; j++) {
-          hc->matrix[vc->jindx[i] + j] = VRNA_CONSTRAINT_CONTEXT_NONE;
-
-          hc->mx[n * i + j] = VRNA_CONSTRAINT_CONTEXT_NONE;
-          hc->mx[n * j + i] = VRNA_CONSTRAINT_CONTEXT_NONE;
-        }
-        for (j = i + 1; j <= n; j++) {
-          hc->matrix[vc->jindx[j] + i] = VRNA_CONSTRAINT_CONTEXT_NONE;
+        for (j = 1; j < i; j++)
+          hc_mx_set(hc, j, i, VRNA_CONSTRAINT_CONTEXT_NONE);
 
-          hc->mx[n * i + j] = VRNA_CONSTRAINT_CONTEXT_NONE;
-          hc->mx[n * j + i] = VRNA_CONSTRAINT_CONTEXT_NONE;
-        }
+        for (j = i + 1; j <= n; j++)
+          hc_mx_set(hc, i, j, VRNA_CONSTRAINT_CONTEXT_NONE);
       }
 
       type = option & VRNA_CONSTRAINT_CONTEXT_ALL_LOOPS;
 
-      hc->matrix[vc->jindx[i] + i] = type;
-
-      hc->mx[n * i + i] = type;
+      hc_mx_set(hc, i, i, type);
     } else {
       type = option & VRNA_CONSTRAINT_CONTEXT_ALL_LOOPS;
 
       /* do not allow i to be paired with any other nucleotide (in context type) */
       if (!(option & VRNA_CONSTRAINT_CONTEXT_NO_REMOVE)) {
-        for (j = 1; j < i; j++) {
-          hc->matrix[vc->jindx[i] + j] &= ~type;
-
-          hc->mx[n * i + j] &= ~type;
-          hc->mx[n * j + i] &= ~type;
-        }
-        for (j = i + 1; j <= n; j++) {
-          hc->matrix[vc->jindx[j] + i] &= ~type;
+        for (j = 1; j < i; j++)
+          hc_mx_and(hc, j, i, ~type);
 
-          hc->mx[n * i + j] &= ~type;
-          hc->mx[n * j + i] &= ~type;
-        }
+        for (j = i + 1; j <= n; j++)
+          hc_mx_and(hc, i, j, ~type);
       }
 
-      hc->matrix[vc->jindx[i] + i] = VRNA_CONSTRAINT_CONTEXT_ALL_LOOPS;
-
-      hc->mx[n * i + i] = VRNA_CONSTRAINT_CONTEXT_ALL_LOOPS;
+      hc_mx_set(hc, i, i, VRNA_CONSTRAINT_CONTEXT_ALL_LOOPS);
     }
   }
 }
@@ -1386,34 +1490,27 @@ db_constraints_exit:
 PRIVATE void
 hc_reset_to_default(vrna_fold_compound_t *vc)
 {
-  unsigned int  i, j, ij, n;
-  int           *idx;
+  unsigned int  i, j, i_min, n;
   vrna_hc_t     *hc;
 
   n   = vc->length;
   hc  = vc->hc;
-  idx = vc->jindx;
 
   /* ######################### */
   /* fill with default values  */
   /* ######################### */
 
   /* 1. unpaired nucleotides are allowed in all contexts */
-  for (i = 1; i <= n; i++) {
-    hc->matrix[idx[i] + i] = VRNA_CONSTRAINT_CONTEXT_ALL_LOOPS;
-
-    hc->mx[n * i + i] = VRNA_CONSTRAINT_CONTEXT_ALL_LOOPS;
-  }
+  for (i = 1; i <= n; i++)
+    hc_mx_set(hc, i, i, VRNA_CONSTRAINT_CONTEXT_ALL_LOOPS);
 
   /* 2. base pairs follow default rules, i.e. canonical pairs, maybe without isolated pairs (if noLP) */
   for (j = n; j > 1; j--) {
-    ij = idx[j] + 1;
-    for (i = 1; i < j; i++, ij++) {
-      hc->matrix[ij] = default_pair_constraint(vc, i, j);
+    /* a banded matrix doesn't store anything beyond its band */
+    i_min = ((hc->mx_span) && (j > hc->mx_span)) ? j - hc->mx_span + 1 : 1;
 
-      hc->mx[n * i + j] = default_pair_constraint(vc, i, j);
-      hc->mx[n * j + i] = hc->mx[n * i + j];
-    }
+    for (i = i_min; i < j; i++)
+      hc_mx_set(hc, i, j, default_pair_constraint(vc, i, j));
   }
 
   /* should we reset the generalized hard constraint feature here? */
@@ -1462,19 +1559,19 @@ hc_update_up(vrna_fold_compound_t *vc)
     }
   } else {
     for (hc->up_ext[n + 1] = 0, i = n; i > 0; i--) /* unpaired stretch in exterior loop */
-      hc->up_ext[i] = (hc->mx[n * i + i] & VRNA_CONSTRAINT_CONTEXT_EXT_LOOP) ? 1 +
+      hc->up_ext[i] = (vrna_hc_mx_get(hc, i, i) & VRNA_CONSTRAINT_CONTEXT_EXT_LOOP) ? 1 +
                       hc->up_ext[i + 1] : 0;
 
     for (hc->up_hp[n + 1] = 0, i = n; i > 0; i--)  /* unpaired stretch in hairpin loop */
-      hc->up_hp[i] = (hc->mx[n * i + i] & VRNA_CONSTRAINT_CONTEXT_HP_LOOP) ? 1 +
+      hc->up_hp[i] = (vrna_hc_mx_get(hc, i, i) & VRNA_CONSTRAINT_CONTEXT_HP_LOOP) ? 1 +
                      hc->up_hp[i + 1] : 0;
 
     for (hc->up_int[n + 1] = 0, i = n; i > 0; i--) /* unpaired stretch in interior loop */
-      hc->up_int[i] = (hc->mx[n * i + i] & VRNA_CONSTRAINT_CONTEXT_INT_LOOP) ? 1 +
+      hc->up_int[i] = (vrna_hc_mx_get(hc, i, i) & VRNA_CONSTRAINT_CONTEXT_INT_LOOP) ? 1 +
                       hc->up_int[i + 1] : 0;
 
     for (hc->up_ml[n + 1] = 0, i = n; i > 0; i--)  /* unpaired stretch in multibranch loop */
-      hc->up_ml[i] = (hc->mx[n * i + i] & VRNA_CONSTRAINT_CONTEXT_MB_LOOP) ? 1 +
+      hc->up_ml[i] = (vrna_hc_mx_get(hc, i, i) & VRNA_CONSTRAINT_CONTEXT_MB_LOOP) ? 1 +
                      hc->up_ml[i + 1] : 0;
 
     /*
@@ -1482,40 +1579,40 @@ hc_update_up(vrna_fold_compound_t *vc)
      *  be unpaired (needed for circular folding)
      */
 
-    if (hc->mx[n + 1] & VRNA_CONSTRAINT_CONTEXT_EXT_LOOP) {
+    if (vrna_hc_mx_get(hc, 1, 1) & VRNA_CONSTRAINT_CONTEXT_EXT_LOOP) {
       hc->up_ext[n + 1] = hc->up_ext[1];
       for (i = n; i > 0; i--) {
-        if (hc->mx[n * i + i] & VRNA_CONSTRAINT_CONTEXT_EXT_LOOP)
+        if (vrna_hc_mx_get(hc, i, i) & VRNA_CONSTRAINT_CONTEXT_EXT_LOOP)
           hc->up_ext[i] = MIN2(n, 1 + hc->up_ext[i + 1]);
         else
           break;
       }
     }
 
-    if (hc->mx[n + 1] & VRNA_CONSTRAINT_CONTEXT_HP_LOOP) {
+    if (vrna_hc_mx_get(hc, 1, 1) & VRNA_CONSTRAINT_CONTEXT_HP_LOOP) {
       hc->up_hp[n + 1] = hc->up_hp[1];
       for (i = n; i > 0; i--) {
-        if (hc->mx[n * i + i] & VRNA_CONSTRAINT_CONTEXT_HP_LOOP)
+        if (vrna_hc_mx_get(hc, i, i) & VRNA_CONSTRAINT_CONTEXT_HP_LOOP)
           hc->up_hp[i] = MIN2(n, 1 + hc->up_hp[i + 1]);
         else
           break;
       }
     }
 
-    if (hc->mx[n + 1] & VRNA_CONSTRAINT_CONTEXT_INT_LOOP) {
+    if (vrna_hc_mx_get(hc, 1, 1) & VRNA_CONSTRAINT_CONTEXT_INT_LOOP) {
       hc->up_int[n + 1] = hc->up_int[1];
       for (i = n; i > 0; i--) {
-        if (hc->mx[n * i + i] & VRNA_CONSTRAINT_CONTEXT_INT_LOOP)
+        if (vrna_hc_mx_get(hc, i, i) & VRNA_CONSTRAINT_CONTEXT_INT_LOOP)
           hc->up_int[i] = MIN2(n, 1 + hc->up_int[i + 1]);
         else
           break;
       }
     }
 
-    if (hc->mx[n + 1] & VRNA_CONSTRAINT_CONTEXT_MB_LOOP) {
+    if (vrna_hc_mx_get(hc, 1, 1) & VRNA_CONSTRAINT_CONTEXT_MB_LOOP) {
       hc->up_ml[n + 1] = hc->up_ml[1];
       for (i = n; i > 0; i--) {
-        if (hc->mx[n * i + i] & VRNA_CONSTRAINT_CONTEXT_MB_LOOP)
+        if (vrna_hc_mx_get(hc, i, i) & VRNA_CONSTRAINT_CONTEXT_MB_LOOP)
           hc->up_ml[i] = MIN2(n, 1 + hc->up_ml[i + 1]);
         else
           break;
@@ -13,6 +13,12 @@
 # define DEPRECATED(func, msg) func
 #endif
 
+#ifdef __GNUC__
+# define INLINE inline
+#else
+# define INLINE
+#endif
+
 
 /**
  *  @file       constraints/hard.h
@@ -379,8 +385,18 @@ struct vrna_hc_s {
 #endif
       unsigned char *matrix;     /**<  @brief  Upper triangular matrix that encodes where a
                                   *            base pair or unpaired nucleotide is allowed
+                                  *    @note   This matrix is not allocated, i.e. @em NULL, if
+                                  *            vrna_hc_s.mx is banded (vrna_hc_s.mx_span > 0).
+                                  *            Callers must check for @em NULL, or use
+                                  *            vrna_hc_mx_get() instead.
+                                  */
+      unsigned char *mx;         /**<  @brief  Symmetric matrix that encodes where a base pair
+                                  *            or unpaired nucleotide is allowed
+                                  *
+                                  *    For span-limited global fold compounds only a band of
+                                  *    width vrna_hc_s.mx_span around the diagonal is stored.
+                                  *    Use vrna_hc_mx_get() to access this matrix.
                                   */
-      unsigned char *mx;
 #ifndef VRNA_DISABLE_C11_FEATURES
     };
     struct {
@@ -425,6 +441,13 @@ struct vrna_hc_s {
                                            *    memory, the user may use this pointer to free
                                            *    memory occupied by auxiliary data.
                                            */
+
+  unsigned int                mx_span;    /**<  @brief  Width of the band stored in vrna_hc_s.mx, i.e.
+                                           *            only pairs with @f$ |j - i| < mx\_span @f$ are
+                                           *            stored (0 if mx is a full
+                                           *            @f$ (n + 1) \times (n + 1) @f$ matrix)
+                                           *    @see    vrna_hc_mx_index(), vrna_hc_mx_get()
+                                           */
 };
 
 /**
@@ -437,6 +460,68 @@ struct vrna_hc_up_s {
   unsigned char options;  /**<  @brief The hard constraint option       */
 };
 
+
+/**
+ *  @brief  Get the position of a base pair or an unpaired nucleotide in the hard constraints matrix
+ *
+ *  Computes the offset of pair @f$ (i,j) @f$, or of unpaired nucleotide @f$ i = j @f$, within
+ *  vrna_hc_s.mx. The order of @p i and @p j is irrelevant. For the banded matrix of a
+ *  span-limited global fold compound, only pairs with @f$ |j - i| < @f$ vrna_hc_s.mx_span are
+ *  stored. This is the only definition of the band, i.e. all pairs beyond it are never allowed.
+ *
+ *  @ingroup  hard_constraints
+ *
+ *  @param  hc  The hard constraints data structure (of type #VRNA_HC_DEFAULT)
+ *  @param  i   The first nucleotide
+ *  @param  j   The second nucleotide
+ *  @return     The offset of @f$ (i,j) @f$ within vrna_hc_s.mx, or -1 if the pair is beyond the band
+ */
+static INLINE long
+vrna_hc_mx_index(const vrna_hc_t  *hc,
+                 unsigned int     i,
+                 unsigned int     j)
+{
+  unsigned int w = hc->mx_span;
+
+  if (w == 0)
+    return (long)hc->n * i + j;
+
+  if ((i >= j + w) || (j >= i + w))
+    return -1;
+
+  return 2 * (long)w * i + w + j;
+}
+
+
+/**
+ *  @brief  Get the hard constraint for a base pair or an unpaired nucleotide
+ *
+ *  Retrieves the loop contexts a base pair @f$ (i,j) @f$ may appear in, or,
+ *  if @f$ i = j @f$, the loop contexts nucleotide @f$ i @f$ may stay unpaired
+ *  in, from the hard constraints matrix vrna_hc_s.mx. The order of @p i and
+ *  @p j is irrelevant. For the banded matrix of a span-limited global fold
+ *  compound, pairs beyond the band are never allowed.
+ *
+ *  @ingroup  hard_constraints
+ *
+ *  @see    vrna_hc_mx_index()
+ *
+ *  @param  hc  The hard constraints data structure (of type #VRNA_HC_DEFAULT)
+ *  @param  i   The first nucleotide
+ *  @param  j   The second nucleotide
+ *  @return     The hard constraint of pair @f$ (i,j) @f$, or unpaired nucleotide @f$ i @f$
+ */
+static INLINE unsigned char
+vrna_hc_mx_get(const vrna_hc_t  *hc,
+               unsigned int     i,
+               unsigned int     j)
+{
+  long idx = vrna_hc_mx_index(hc, i, j);
+
+  return (idx < 0) ? VRNA_CONSTRAINT_CONTEXT_NONE : hc->mx[idx];
+}
+
+
 /**
  *  @brief Print a help message for pseudo dot-bracket structure constraint characters to stdout.
  *  (constraint support is specified by option parameter)
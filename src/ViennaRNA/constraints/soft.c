@@ -1150,11 +1150,20 @@ prepare_sc_bp_mfe(vrna_fold_compound_t  *vc,
               sc->energy_bp_local =
                 (int **)vrna_realloc(sc->energy_bp_local, sizeof(int *) * (n + 2));
             } else {
-              sc->energy_bp =
-                (int *)vrna_realloc(sc->energy_bp, sizeof(int) * (((n + 1) * (n + 2)) / 2));
-
-              for (i = 1; i < n; i++)
-                populate_sc_bp_mfe(vc, i, n);
+              if (vc->jindx_span) {
+                /* banded storage, see vrna_idx_col_wise_banded() */
+                sc->energy_bp =
+                  (int *)vrna_realloc(sc->energy_bp, sizeof(int) * (n + 1) * (vc->jindx_span + 3));
+
+                for (i = 1; i < n; i++)
+                  populate_sc_bp_mfe(vc, i, vc->jindx_span + 2);
+              } else {
+                sc->energy_bp =
+                  (int *)vrna_realloc(sc->energy_bp, sizeof(int) * (((n + 1) * (n + 2)) / 2));
+
+                for (i = 1; i < n; i++)
+                  populate_sc_bp_mfe(vc, i, n);
+              }
             }
 
             sc->state &= ~STATE_DIRTY_BP_MFE;
@@ -1194,12 +1203,22 @@ prepare_sc_bp_pf(vrna_fold_compound_t *vc,
                 (FLT_OR_DBL **)vrna_realloc(sc->exp_energy_bp_local,
                                             sizeof(FLT_OR_DBL *) * (n + 2));
             } else {
-              sc->exp_energy_bp =
-                (FLT_OR_DBL *)vrna_realloc(sc->exp_energy_bp,
-                                           sizeof(FLT_OR_DBL) * (((n + 1) * (n + 2)) / 2));
-
-              for (i = 1; i < n; i++)
-                populate_sc_bp_pf(vc, i, n);
+              if (vc->jindx_span) {
+                /* banded storage, see vrna_idx_col_wise_banded() */
+                sc->exp_energy_bp =
+                  (FLT_OR_DBL *)vrna_realloc(sc->exp_energy_bp,
+                                             sizeof(FLT_OR_DBL) * (n + 1) * (vc->jindx_span + 3));
+
+                for (i = 1; i < n; i++)
+                  populate_sc_bp_pf(vc, i, vc->jindx_span + 2);
+              } else {
+                sc->exp_energy_bp =
+                  (FLT_OR_DBL *)vrna_realloc(sc->exp_energy_bp,
+                                             sizeof(FLT_OR_DBL) * (((n + 1) * (n + 2)) / 2));
+
+                for (i = 1; i < n; i++)
+                  populate_sc_bp_pf(vc, i, n);
+              }
             }
 
             sc->state &= ~STATE_DIRTY_BP_PF;
@@ -0,0 +1,746 @@
+/*
+ *                Incremental (co-transcriptional) folding
+ *
+ *                Minimum free energy and partition function matrices
+ *                of a sequence that grows at its 3' end, filled column-wise
+ *                such that appending a nucleotide only adds a single column
+ *
+ *                Vienna RNA package
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "ViennaRNA/utils/basic.h"
+#include "ViennaRNA/utils/structures.h"
+#include "ViennaRNA/params/basic.h"
+#include "ViennaRNA/fold_compound.h"
+#include "ViennaRNA/gquad.h"
+#include "ViennaRNA/loops/all.h"
+#include "ViennaRNA/mfe.h"
+#include "ViennaRNA/part_func.h"
+#include "ViennaRNA/equilibrium_probs.h"
+#include "ViennaRNA/cotranscriptional.h"
+
+/*
+ *  Maximum deviation of the logarithm of the scaled partition function of
+ *  the current prefix from 0 before all scaled entries are adapted
+ */
+#ifdef USE_FLOAT_PF
+#define COTRANS_RESCALE_THRESHOLD   20.
+#else
+#define COTRANS_RESCALE_THRESHOLD   100.
+#endif
+
+#define MAXSECTORS                  500   /* dimension for a backtrack array */
+
+/*
+ #################################
+ # PRIVATE DATA STRUCTURES       #
+ #################################
+ */
+
+/*
+ *  The dynamic programming matrices are those of a regular fold compound for
+ *  the current sequence, filled by the same recursions as vrna_mfe() and vrna_pf().
+ *  Columns j < n of the current sequence with length n only depend on the
+ *  nucleotides up to j + 1. Thus, they are copied into the fold compound of the
+ *  elongated sequence, and only the columns from n onwards are filled. The
+ *  prefix of length m is folded in a fold compound of its own that receives the
+ *  columns j < m from the current fold compound, and re-computes column m, where
+ *  the prefix ends.
+ */
+struct vrna_cotrans_s {
+  unsigned int          options;
+  vrna_md_t             md;
+  char                  *sequence;
+  unsigned int          length;     /* number of nucleotides appended so far */
+  vrna_fold_compound_t  *fc;        /* fold compound of the current sequence */
+  vrna_fold_compound_t  *prefix;    /* fold compound of the prefix requested last */
+
+  /* minimum free energy, stored like the matrix c, see vrna_mfe_fill_column() */
+  int                   *DML;       /* multibranch loop split minima */
+  int                   *cc;        /* canonical helper values for lonely pair restrictions */
+
+  /* partition function */
+  double                pf_scale;
+  int                   pf_overflow;  /* scaling failed, the partition function is out of range */
+  vrna_mx_pf_aux_el_t   aux_mx_el;    /* auxiliary arrays of columns n - 1 and n */
+  vrna_mx_pf_aux_ml_t   aux_mx_ml;
+};
+
+/*
+ #################################
+ # PRIVATE FUNCTION DECLARATIONS #
+ #################################
+ */
+PRIVATE vrna_fold_compound_t *
+new_fold_compound(vrna_cotrans_t  *ct,
+                  unsigned int    length);
+
+
+PRIVATE void
+copy_columns(vrna_fold_compound_t *src,
+             vrna_fold_compound_t *dst,
+             unsigned int         m);
+
+
+PRIVATE void
+fill_mfe_columns(vrna_cotrans_t       *ct,
+                 vrna_fold_compound_t *fc,
+                 unsigned int         from,
+                 unsigned int         to,
+                 int                  *DML,
+                 int                  *cc);
+
+
+PRIVATE void
+fill_pf_columns(vrna_cotrans_t       *ct,
+                vrna_fold_compound_t *fc,
+                unsigned int         from,
+                unsigned int         to,
+                vrna_mx_pf_aux_el_t  aux_mx_el,
+                vrna_mx_pf_aux_ml_t  aux_mx_ml);
+
+
+PRIVATE void
+init_pf_aux(vrna_fold_compound_t  *fc,
+            unsigned int          last,
+            vrna_mx_pf_aux_el_t   *aux_mx_el,
+            vrna_mx_pf_aux_ml_t   *aux_mx_ml);
+
+
+PRIVATE int
+rescale_pf(vrna_cotrans_t       *ct,
+           vrna_fold_compound_t *fc,
+           unsigned int         m);
+
+
+PRIVATE vrna_fold_compound_t *
+get_prefix(vrna_cotrans_t *ct,
+           unsigned int   length);
+
+
+/*
+ #################################
+ # BEGIN OF FUNCTION DEFINITIONS #
+ #################################
+ */
+PUBLIC vrna_cotrans_t *
+vrna_cotrans_init(const char    *sequence,
+                  vrna_md_t     *md_p,
+                  unsigned int  options)
+{
+  vrna_cotrans_t *ct;
+
+  ct = (vrna_cotrans_t *)vrna_alloc(sizeof(vrna_cotrans_t));
+
+  if (md_p)
+    ct->md = *md_p;
+  else
+    vrna_md_set_default(&(ct->md));
+
+  /* the 5' and 3' ends of a circular RNA are not known until transcription is complete */
+  if (ct->md.circ) {
+    vrna_message_warning("vrna_cotrans_init: "
+                         "unsupported model setting circ (circular RNAs)");
+    free(ct);
+    return NULL;
+  }
+
+  options &= VRNA_OPTION_MFE | VRNA_OPTION_PF;
+  if (!options)
+    options = VRNA_OPTION_MFE;
+
+  /* base pair probabilities require the regular, double precision matrices */
+  if (options & VRNA_OPTION_PF)
+    ct->md.compute_bpp = 1;
+
+  vrna_md_update(&(ct->md));
+
+  ct->options   = options;
+  ct->sequence  = (char *)vrna_alloc(sizeof(char));
+  ct->length    = 0;
+
+  if ((sequence) && (!vrna_cotrans_append(ct, sequence)) && (*sequence)) {
+    vrna_cotrans_free(ct);
+    return NULL;
+  }
+
+  return ct;
+}
+
+
+PUBLIC void
+vrna_cotrans_free(vrna_cotrans_t *ct)
+{
+  if (ct) {
+    vrna_fold_compound_free(ct->fc);
+    vrna_fold_compound_free(ct->prefix);
+    vrna_exp_E_ext_fast_free(ct->aux_mx_el);
+    vrna_exp_E_ml_fast_free(ct->aux_mx_ml);
+    free(ct->DML);
+    free(ct->cc);
+    free(ct->sequence);
+    free(ct);
+  }
+}
+
+
+PUBLIC unsigned int
+vrna_cotrans_append(vrna_cotrans_t  *ct,
+                    const char      *nucleotides)
+{
+  unsigned int          n, n_new, size;
+  vrna_fold_compound_t  *fc;
+
+  if ((!ct) || (!nucleotides))
+    return 0;
+
+  n     = ct->length;
+  n_new = n + (unsigned int)strlen(nucleotides);
+
+  if (n_new == n)
+    return n;
+
+  ct->sequence = (char *)vrna_realloc(ct->sequence, sizeof(char) * (n_new + 1));
+  memcpy(ct->sequence + n, nucleotides, sizeof(char) * (n_new - n + 1));
+
+  fc = new_fold_compound(ct, n_new);
+  if (!fc) {
+    ct->sequence[n] = '\0';
+    return 0;
+  }
+
+  /* column n is re-computed below, since nucleotide n + 1 is available now */
+  if (ct->fc)
+    copy_columns(ct->fc, fc, n);
+
+  if (ct->options & VRNA_OPTION_MFE) {
+    size    = (unsigned int)fc->jindx[n_new] + n_new + 1;
+    ct->DML = (int *)vrna_realloc(ct->DML, sizeof(int) * size);
+    if (ct->md.noLP)
+      ct->cc = (int *)vrna_realloc(ct->cc, sizeof(int) * size);
+
+    fill_mfe_columns(ct, fc, MAX2(n, 1), n_new, ct->DML, ct->cc);
+  }
+
+  if ((ct->options & VRNA_OPTION_PF) && (!ct->pf_overflow)) {
+    if (ct->aux_mx_el) {
+      vrna_exp_E_ext_fast_resize(fc, ct->aux_mx_el);
+      vrna_exp_E_ml_fast_resize(fc, ct->aux_mx_ml);
+    } else {
+      init_pf_aux(fc, (n > 0) ? n - 1 : 0, &(ct->aux_mx_el), &(ct->aux_mx_ml));
+    }
+
+    fill_pf_columns(ct, fc, MAX2(n, 1), n_new, ct->aux_mx_el, ct->aux_mx_ml);
+  }
+
+  vrna_fold_compound_free(ct->fc);
+  ct->fc      = fc;
+  ct->length  = n_new;
+
+  return n_new;
+}
+
+
+PUBLIC unsigned int
+vrna_cotrans_length(vrna_cotrans_t *ct)
+{
+  return (ct) ? ct->length : 0;
+}
+
+
+PUBLIC float
+vrna_cotrans_mfe(vrna_cotrans_t *ct,
+                 unsigned int   length,
+                 char           *structure)
+{
+  vrna_fold_compound_t *fc;
+
+  if ((!ct) || (!(ct->options & VRNA_OPTION_MFE)) || (length > ct->length)) {
+    vrna_message_warning("vrna_cotrans_mfe: "
+                         "MFE matrices not available or prefix length exceeds the sequence length");
+    return (float)(INF / 100.);
+  }
+
+  if (length == 0) {
+    if (structure)
+      structure[0] = '\0';
+
+    return 0.;
+  }
+
+  fc = get_prefix(ct, length);
+  if (!fc)
+    return (float)(INF / 100.);
+
+  /* a failed backtracking leaves the structure empty, but not the energy */
+  if ((structure) && (vrna_backtrack5(fc, length, structure) >= (float)(INF / 100.))) {
+    vrna_message_warning("vrna_cotrans_mfe: "
+                         "backtracking failed for prefix with length %u",
+                         length);
+    structure[0] = '\0';
+  }
+
+  return (float)fc->matrices->f5[length] / 100.;
+}
+
+
+PUBLIC int
+vrna_cotrans_mfe_pair(vrna_cotrans_t  *ct,
+                      unsigned int    i,
+                      unsigned int    j,
+                      char            *structure)
+{
+  char                  *ss;
+  int                   e;
+  sect                  bt_stack[MAXSECTORS];
+  vrna_bp_stack_t       *bp;
+  vrna_fold_compound_t  *fc;
+
+  if ((!ct) || (!(ct->options & VRNA_OPTION_MFE)) || (i < 1) || (i >= j) ||
+      (j > ct->length))
+    return INF;
+
+  fc  = ct->fc;
+  e   = fc->matrices->c[fc->jindx[j] + i];
+
+  if (structure) {
+    memset(structure, '.', sizeof(char) * j);
+    structure[j] = '\0';
+
+    if (e != INF) {
+      bp = (vrna_bp_stack_t *)vrna_alloc(sizeof(vrna_bp_stack_t) * (4 * (1 + j / 2)));
+
+      bt_stack[1].i   = (int)i;
+      bt_stack[1].j   = (int)j;
+      bt_stack[1].ml  = 2;
+
+      if (vrna_backtrack_from_intervals(fc, bp, bt_stack, 1)) {
+        ss = vrna_db_from_bp_stack(bp, j);
+        memcpy(structure, ss, sizeof(char) * j);
+        free(ss);
+      } else {
+        vrna_message_warning("vrna_cotrans_mfe_pair: backtracking failed");
+      }
+
+      free(bp);
+    }
+  }
+
+  return e;
+}
+
+
+PUBLIC double
+vrna_cotrans_pf(vrna_cotrans_t  *ct,
+                unsigned int    length)
+{
+  FLT_OR_DBL            Q;
+  vrna_fold_compound_t  *fc;
+
+  if ((!ct) || (!(ct->options & VRNA_OPTION_PF)) || (length > ct->length)) {
+    vrna_message_warning("vrna_cotrans_pf: "
+                         "partition function matrices not available or prefix length exceeds the sequence length");
+    return (double)(INF / 100.);
+  }
+
+  if (length == 0)
+    return 0.;
+
+  fc  = get_prefix(ct, length);
+  Q   = ((!fc) || (ct->pf_overflow)) ? 0. : fc->exp_matrices->q[fc->iindx[1] - length];
+
+  if ((Q <= 0.) || (!isfinite(Q))) {
+    vrna_message_warning("vrna_cotrans_pf: "
+                         "partition function of prefix with length %u out of range",
+                         length);
+    return (double)(INF / 100.);
+  }
+
+  return (-log(Q) - (double)length * log(fc->exp_params->pf_scale)) *
+         fc->exp_params->kT /
+         1000.;
+}
+
+
+PUBLIC vrna_ep_t *
+vrna_cotrans_bpp(vrna_cotrans_t *ct,
+                 unsigned int   length,
+                 double         cutoff)
+{
+  unsigned int          k;
+  int                   *iidx;
+  FLT_OR_DBL            *q, *q1k, *qln;
+  vrna_fold_compound_t  *fc;
+
+  if ((!ct) || (!(ct->options & VRNA_OPTION_PF)) || (length > ct->length)) {
+    vrna_message_warning("vrna_cotrans_bpp: "
+                         "partition function matrices not available or prefix length exceeds the sequence length");
+    return NULL;
+  }
+
+  if (length == 0)
+    return (vrna_ep_t *)vrna_alloc(sizeof(vrna_ep_t));
+
+  if (vrna_cotrans_pf(ct, length) >= (double)(INF / 100.))
+    return NULL;
+
+  fc    = get_prefix(ct, length);
+  iidx  = fc->iindx;
+  q     = fc->exp_matrices->q;
+  q1k   = fc->exp_matrices->q1k;
+  qln   = fc->exp_matrices->qln;
+
+  /* prefill linear qln, q1k arrays as vrna_pf() does */
+  for (k = 1; k <= length; k++) {
+    q1k[k]  = q[iidx[1] - k];
+    qln[k]  = q[iidx[k] - length];
+  }
+  q1k[0]          = 1.0;
+  qln[length + 1] = 1.0;
+
+  if (!vrna_pairing_probs(fc, NULL))
+    return NULL;
+
+  return vrna_plist_from_probs(fc, cutoff);
+}
+
+
+/*
+ #####################################
+ # BEGIN OF STATIC HELPER FUNCTIONS  #
+ #####################################
+ */
+
+/* create a fold compound for the prefix of the current sequence with the given length */
+PRIVATE vrna_fold_compound_t *
+new_fold_compound(vrna_cotrans_t  *ct,
+                  unsigned int    length)
+{
+  char                  c;
+  vrna_fold_compound_t  *fc;
+
+  c                     = ct->sequence[length];
+  ct->sequence[length]  = '\0';
+  fc                    = vrna_fold_compound(ct->sequence, &(ct->md), ct->options);
+  ct->sequence[length]  = c;
+
+  if ((fc) && (ct->options & VRNA_OPTION_PF)) {
+    /* all prefixes share the same scaling, such that columns can be exchanged */
+    if (ct->pf_scale > 0.) {
+      fc->exp_params->pf_scale = ct->pf_scale;
+      vrna_exp_params_rescale(fc, NULL);
+    } else {
+      ct->pf_scale = fc->exp_params->pf_scale;
+    }
+
+    if (ct->md.gquad)
+      fc->exp_matrices->G = get_gquad_pf_matrix(fc->sequence_encoding2,
+                                                fc->exp_matrices->scale,
+                                                fc->exp_params);
+  }
+
+  return fc;
+}
+
+
+/* copy the entries of all columns j <= m */
+PRIVATE void
+copy_columns(vrna_fold_compound_t *src,
+             vrna_fold_compound_t *dst,
+             unsigned int         m)
+{
+  unsigned int  i;
+  size_t        size;
+  vrna_mx_mfe_t *mx;
+  vrna_mx_pf_t  *exp_mx;
+
+  if (m == 0)
+    return;
+
+  /* column-wise matrices share the same layout for all sequence lengths */
+  size = (size_t)src->jindx[m] + m + 1;
+
+  if ((src->matrices) && (dst->matrices)) {
+    mx = src->matrices;
+    memcpy(dst->matrices->c, mx->c, sizeof(int) * size);
+    memcpy(dst->matrices->fML, mx->fML, sizeof(int) * size);
+    if ((mx->fM1) && (dst->matrices->fM1))
+      memcpy(dst->matrices->fM1, mx->fM1, sizeof(int) * size);
+  }
+
+  if ((src->exp_matrices) && (dst->exp_matrices)) {
+    exp_mx = src->exp_matrices;
+
+    /* row-wise matrices store the segments [i, j] of row i in reverse order */
+    for (i = 1; i <= m; i++) {
+      memcpy(dst->exp_matrices->q + dst->iindx[i] - m,
+             exp_mx->q + src->iindx[i] - m,
+             sizeof(FLT_OR_DBL) * (m - i + 1));
+      memcpy(dst->exp_matrices->qb + dst->iindx[i] - m,
+             exp_mx->qb + src->iindx[i] - m,
+             sizeof(FLT_OR_DBL) * (m - i + 1));
+      memcpy(dst->exp_matrices->qm + dst->iindx[i] - m,
+             exp_mx->qm + src->iindx[i] - m,
+             sizeof(FLT_OR_DBL) * (m - i + 1));
+    }
+
+    if ((exp_mx->qm1) && (dst->exp_matrices->qm1))
+      memcpy(dst->exp_matrices->qm1, exp_mx->qm1, sizeof(FLT_OR_DBL) * size);
+  }
+}
+
+
+/*
+ *  fill the MFE matrices of the columns [from, to], and the exterior loop of
+ *  the entire sequence. The helper values are stored like the matrix c
+ */
+PRIVATE void
+fill_mfe_columns(vrna_cotrans_t       *ct,
+                 vrna_fold_compound_t *fc,
+                 unsigned int         from,
+                 unsigned int         to,
+                 int                  *DML,
+                 int                  *cc)
+{
+  unsigned int  j;
+  int           *indx, *DMLj[3], *ccj[2];
+
+  indx = fc->jindx;
+
+  for (j = from; j <= to; j++) {
+    DMLj[0] = DML + indx[j];
+    DMLj[1] = (j > 1) ? DML + indx[j - 1] : NULL;
+    DMLj[2] = (j > 2) ? DML + indx[j - 2] : NULL;
+
+    if (ct->md.noLP) {
+      ccj[0]  = cc + indx[j];
+      ccj[1]  = (j > 1) ? cc + indx[j - 1] : NULL;
+    }
+
+    (void)vrna_mfe_fill_column(fc, j, DMLj, (ct->md.noLP) ? ccj : NULL);
+  }
+
+  (void)vrna_E_ext_loop_5(fc);
+}
+
+
+/*
+ *  fill the partition function matrices of the columns [from, to], given
+ *  the auxiliary arrays of column from - 1. The auxiliary arrays are
+ *  not rotated after the last column, i.e. they remain at column to - 1
+ *  such that column to can be re-computed once the sequence is elongated
+ */
+PRIVATE void
+fill_pf_columns(vrna_cotrans_t       *ct,
+                vrna_fold_compound_t *fc,
+                unsigned int         from,
+                unsigned int         to,
+                vrna_mx_pf_aux_el_t  aux_mx_el,
+                vrna_mx_pf_aux_ml_t  aux_mx_ml)
+{
+  unsigned int j, turn;
+
+  turn = ct->md.min_loop_size;
+
+  for (j = from; j <= to; j++) {
+    /* shorter prefixes can not form any base pair, see vrna_exp_E_ext_fast_init() */
+    if (j >= turn + 2) {
+      if (!vrna_pf_fill_column(fc, j, aux_mx_el, aux_mx_ml)) {
+        ct->pf_overflow = 1;
+        return;
+      }
+
+      if (j < to) {
+        vrna_exp_E_ext_fast_rotate(aux_mx_el);
+        vrna_exp_E_ml_fast_rotate(aux_mx_ml);
+      }
+    }
+
+    /* adapt the scaling to the prefix, which invalidates the auxiliary arrays */
+    if (rescale_pf(ct, fc, j)) {
+      vrna_exp_E_ext_fast_free(ct->aux_mx_el);
+      vrna_exp_E_ml_fast_free(ct->aux_mx_ml);
+      init_pf_aux(fc,
+                  ((j < to) && (j >= turn + 2)) ? j : j - 1,
+                  &(ct->aux_mx_el),
+                  &(ct->aux_mx_ml));
+      aux_mx_el = ct->aux_mx_el;
+      aux_mx_ml = ct->aux_mx_ml;
+    }
+  }
+}
+
+
+/*
+ *  initialize the auxiliary arrays of the partition function recursions, and
+ *  advance them to column last, given that all columns up to last are available
+ */
+PRIVATE void
+init_pf_aux(vrna_fold_compound_t  *fc,
+            unsigned int          last,
+            vrna_mx_pf_aux_el_t   *aux_mx_el,
+            vrna_mx_pf_aux_ml_t   *aux_mx_ml)
+{
+  int i, j, turn;
+
+  turn        = fc->exp_params->model_details.min_loop_size;
+  *aux_mx_el  = vrna_exp_E_ext_fast_init(fc);
+  *aux_mx_ml  = vrna_exp_E_ml_fast_init(fc);
+
+  for (j = turn + 2; j <= (int)last; j++) {
+    for (i = j - turn - 1; i >= 1; i--) {
+      vrna_exp_E_ml_fast_aux(fc, i, j, *aux_mx_ml);
+      vrna_exp_E_ext_fast_aux(fc, i, j, *aux_mx_el);
+    }
+
+    vrna_exp_E_ext_fast_rotate(*aux_mx_el);
+    vrna_exp_E_ml_fast_rotate(*aux_mx_ml);
+  }
+}
+
+
+/*
+ *  adapt the scaling to the partition function of the prefix with length m,
+ *  if it drifts too far away from 1. Returns 1 if all entries were rescaled
+ */
+PRIVATE int
+rescale_pf(vrna_cotrans_t       *ct,
+           vrna_fold_compound_t *fc,
+           unsigned int         m)
+{
+  unsigned int  i, j, n;
+  int           *iidx, *jindx;
+  double        lq, r, *rp;
+  FLT_OR_DBL    q, *qm1;
+
+  n     = fc->length;
+  iidx  = fc->iindx;
+  jindx = fc->jindx;
+  qm1   = fc->exp_matrices->qm1;
+  q     = fc->exp_matrices->q[iidx[1] - m];
+
+  if ((q <= 0.) || (!isfinite(q))) {
+    vrna_message_warning("vrna_cotrans_append: "
+                         "partition function of prefix with length %u out of range",
+                         m);
+    ct->pf_overflow = 1;
+    return 0;
+  }
+
+  lq = log(q);
+  if (fabs(lq) < COTRANS_RESCALE_THRESHOLD)
+    return 0;
+
+  /* a segment of length l is rescaled by r^l, such that q[1, m] becomes 1 */
+  r = exp(-lq / (double)m);
+
+  /* vrna_exp_params_rescale() does not support scaling factors below 1 */
+  if (ct->pf_scale / r < 1.)
+    r = ct->pf_scale;
+
+  if (r == 1.)
+    return 0;
+
+  ct->pf_scale /= r;
+
+  rp    = (double *)vrna_alloc(sizeof(double) * (n + 1));
+  rp[0] = 1.;
+  for (i = 1; i <= n; i++)
+    rp[i] = rp[i - 1] * r;
+
+  /* columns beyond m only hold unpaired segments so far */
+  for (j = 1; j <= n; j++)
+    for (i = 1; i <= j; i++) {
+      fc->exp_matrices->q[iidx[i] - j]  *= rp[j - i + 1];
+      fc->exp_matrices->qb[iidx[i] - j] *= rp[j - i + 1];
+      fc->exp_matrices->qm[iidx[i] - j] *= rp[j - i + 1];
+      if (qm1)
+        qm1[jindx[j] + i] *= rp[j - i + 1];
+    }
+
+  free(rp);
+
+  fc->exp_params->pf_scale = ct->pf_scale;
+  vrna_exp_params_rescale(fc, NULL);
+
+  if (ct->md.gquad) {
+    free(fc->exp_matrices->G);
+    fc->exp_matrices->G = get_gquad_pf_matrix(fc->sequence_encoding2,
+                                              fc->exp_matrices->scale,
+                                              fc->exp_params);
+  }
+
+  return 1;
+}
+
+
+/*
+ *  get the fold compound of the prefix with the given length, where the
+ *  last column, and the exterior loop treat the prefix end as 3' end
+ */
+PRIVATE vrna_fold_compound_t *
+get_prefix(vrna_cotrans_t *ct,
+           unsigned int   length)
+{
+  int                   *indx, *DML, *cc, *DMLj[3], *ccj[2];
+  vrna_fold_compound_t  *fc;
+  vrna_mx_pf_aux_el_t   aux_mx_el;
+  vrna_mx_pf_aux_ml_t   aux_mx_ml;
+
+  if (length == ct->length)
+    return ct->fc;
+
+  if ((ct->prefix) && (ct->prefix->length == length))
+    return ct->prefix;
+
+  vrna_fold_compound_free(ct->prefix);
+  ct->prefix = NULL;
+
+  fc = new_fold_compound(ct, length);
+  if (!fc)
+    return NULL;
+
+  copy_columns(ct->fc, fc, length);
+
+  if (ct->options & VRNA_OPTION_MFE) {
+    indx    = fc->jindx;
+    DML     = (int *)vrna_alloc(sizeof(int) * (length + 2));
+    cc      = (int *)vrna_alloc(sizeof(int) * (length + 2));
+    DMLj[0] = DML;
+    DMLj[1] = (length > 1) ? ct->DML + indx[length - 1] : NULL;
+    DMLj[2] = (length > 2) ? ct->DML + indx[length - 2] : NULL;
+    ccj[0]  = cc;
+    ccj[1]  = ((ct->md.noLP) && (length > 1)) ? ct->cc + indx[length - 1] : NULL;
+
+    (void)vrna_mfe_fill_column(fc, length, DMLj, (ct->md.noLP) ? ccj : NULL);
+    (void)vrna_E_ext_loop_5(fc);
+
+    free(DML);
+    free(cc);
+  }
+
+  if ((ct->options & VRNA_OPTION_PF) && (!ct->pf_overflow)) {
+    init_pf_aux(fc, length - 1, &aux_mx_el, &aux_mx_ml);
+
+    if (!vrna_pf_fill_column(fc, length, aux_mx_el, aux_mx_ml))
+      vrna_message_warning("vrna_cotrans_pf: "
+                           "partition function of prefix with length %u out of range",
+                           length);
+
+    vrna_exp_E_ext_fast_free(aux_mx_el);
+    vrna_exp_E_ml_fast_free(aux_mx_ml);
+  }
+
+  ct->prefix = fc;
+
+  return fc;
+}
@@ -0,0 +1,181 @@
+#ifndef VIENNA_RNA_PACKAGE_COTRANSCRIPTIONAL_H
+#define VIENNA_RNA_PACKAGE_COTRANSCRIPTIONAL_H
+
+#include <ViennaRNA/datastructures/basic.h>
+#include <ViennaRNA/model.h>
+#include <ViennaRNA/fold_compound.h>
+#include <ViennaRNA/utils/structures.h>
+
+/**
+ *  @file     cotranscriptional.h
+ *  @ingroup  cotranscriptional
+ *  @brief    Incremental MFE and partition function computations for growing sequence prefixes
+ */
+
+/**
+ *  @addtogroup cotranscriptional
+ *  @{
+ *
+ *  @brief  Fold all prefixes of an RNA while it is elongated nucleotide by nucleotide
+ *
+ *  The functions in this module maintain the dynamic programming matrices of a
+ *  sequence that grows at its 3' end, as is the case during transcription. The
+ *  matrices are those of a regular #vrna_fold_compound_t filled by the recursions
+ *  of vrna_mfe() and vrna_pf(). Apart from the last one, matrix columns do not depend
+ *  on the 3' end of the sequence. Thus, appending a nucleotide @f$ n+1 @f$ only requires
+ *  to re-compute column @f$ n @f$, that may depend on the new nucleotide, e.g. through
+ *  dangling ends or lonely pair restrictions, and to compute column @f$ n+1 @f$. Once a
+ *  sequence of length @f$ n @f$ has been appended, the minimum free energy, an MFE
+ *  structure, the ensemble free energy, and the base pair probabilities of any prefix
+ *  of length @f$ m \leq n @f$ are available by re-computing column @f$ m @f$ only.
+ *  Hence, folding all prefixes of a sequence takes @f$ O(n^3) @f$ time rather than the
+ *  @f$ O(n^4) @f$ time required by independent predictions for each prefix.
+ *
+ *  All model settings of vrna_mfe() and vrna_pf() are supported, except for circular
+ *  RNAs, whose exterior loop is not known until transcription is complete.
+ *  vrna_cotrans_init() refuses circular RNAs rather than producing results that differ
+ *  from vrna_mfe() and vrna_pf().
+ */
+
+/**
+ *  @brief  A data structure for incremental (co-transcriptional) folding
+ *
+ *  @see  vrna_cotrans_init(), vrna_cotrans_append(), vrna_cotrans_free()
+ */
+typedef struct vrna_cotrans_s vrna_cotrans_t;
+
+
+/**
+ *  @brief  Create a data structure for incremental (co-transcriptional) folding
+ *
+ *  The @p options determine which matrices are maintained, i.e. #VRNA_OPTION_MFE for
+ *  minimum free energy and MFE structure predictions, #VRNA_OPTION_PF for partition
+ *  function and base pair probability computations, or both. #VRNA_OPTION_DEFAULT is
+ *  equivalent to #VRNA_OPTION_MFE.
+ *
+ *  Since the final length is not known in advance, the partition function matrices are
+ *  scaled with an estimate of the free energy per nucleotide that is adapted to the
+ *  ensemble free energy of the prefixes as the sequence grows.
+ *
+ *  @see  vrna_cotrans_append(), vrna_cotrans_free()
+ *
+ *  @param  sequence  The initial sequence (may be @em NULL)
+ *  @param  md_p      The model details to use (may be @em NULL to use default settings)
+ *  @param  options   The matrices to maintain
+ *  @return           A new data structure for incremental folding, or @em NULL upon any failure,
+ *                    e.g. if @p md_p specifies circular RNAs
+ */
+vrna_cotrans_t *
+vrna_cotrans_init(const char  *sequence,
+                  vrna_md_t   *md_p,
+                  unsigned int options);
+
+
+/**
+ *  @brief  Free all memory occupied by a data structure for incremental folding
+ *
+ *  @param  ct  The data structure to free
+ */
+void
+vrna_cotrans_free(vrna_cotrans_t *ct);
+
+
+/**
+ *  @brief  Append nucleotides to the 3' end of the sequence
+ *
+ *  For each appended nucleotide, exactly one additional column of each dynamic
+ *  programming matrix is computed.
+ *
+ *  @param  ct          The data structure for incremental folding
+ *  @param  nucleotides The nucleotides to append
+ *  @return             The length of the sequence after appending the nucleotides, or 0 upon failure
+ */
+unsigned int
+vrna_cotrans_append(vrna_cotrans_t  *ct,
+                    const char      *nucleotides);
+
+
+/**
+ *  @brief  Get the current length of the sequence
+ *
+ *  @param  ct  The data structure for incremental folding
+ *  @return     The number of nucleotides appended so far
+ */
+unsigned int
+vrna_cotrans_length(vrna_cotrans_t *ct);
+
+
+/**
+ *  @brief  Compute the minimum free energy and an MFE structure of a prefix
+ *
+ *  @param  ct        The data structure for incremental folding
+ *  @param  length    The length of the prefix (at most vrna_cotrans_length())
+ *  @param  structure A pointer to a char array of at least size @p length + 1 for the MFE structure (may be @em NULL),
+ *                    which is left empty if backtracking fails
+ *  @return           The minimum free energy of the prefix in kcal/mol, or (float)(#INF / 100.) upon any failure
+ */
+float
+vrna_cotrans_mfe(vrna_cotrans_t *ct,
+                 unsigned int   length,
+                 char           *structure);
+
+
+/**
+ *  @brief  Compute the lowest free energy of a substructure enclosed by a base pair
+ *
+ *  This function yields the entry of the matrix @f$ C_{ij} @f$ of the minimum free
+ *  energy recursions, i.e. the free energy of the optimal substructure on the
+ *  segment @f$ [i:j] @f$ that is closed by the base pair @f$ (i,j) @f$. Since it
+ *  only depends on the nucleotides @f$ i, \ldots, j @f$, it is the same for all
+ *  prefixes of length @f$ m \geq j @f$. If @p structure is not @em NULL, the
+ *  corresponding substructure is written to @p structure in dot-bracket notation,
+ *  where all nucleotides outside of @f$ [i:j] @f$ remain unpaired.
+ *
+ *  @param  ct        The data structure for incremental folding
+ *  @param  i         The 5' position of the base pair
+ *  @param  j         The 3' position of the base pair (at most vrna_cotrans_length())
+ *  @param  structure A pointer to a char array of at least size @p j + 1 for the substructure (may be @em NULL)
+ *  @return           The free energy in dcal/mol, or #INF if @p i and @p j can not form a base pair
+ */
+int
+vrna_cotrans_mfe_pair(vrna_cotrans_t  *ct,
+                      unsigned int    i,
+                      unsigned int    j,
+                      char            *structure);
+
+
+/**
+ *  @brief  Compute the ensemble free energy of a prefix
+ *
+ *  @param  ct      The data structure for incremental folding
+ *  @param  length  The length of the prefix (at most vrna_cotrans_length())
+ *  @return         The ensemble free energy of the prefix in kcal/mol, or (float)(#INF / 100.) upon any failure
+ */
+double
+vrna_cotrans_pf(vrna_cotrans_t  *ct,
+                unsigned int    length);
+
+
+/**
+ *  @brief  Compute the base pair probabilities of a prefix
+ *
+ *  The probabilities are obtained by an outside recursion restricted to the prefix,
+ *  which requires @f$ O(m^3) @f$ time for a prefix of length @f$ m @f$.
+ *
+ *  @param  ct      The data structure for incremental folding
+ *  @param  length  The length of the prefix (at most vrna_cotrans_length())
+ *  @param  cutoff  The minimum probability of a base pair to be included in the list
+ *  @return         A list of base pairs and their probabilities, terminated by an entry with @p i = @p j = 0,
+ *                  or @em NULL upon any failure
+ */
+vrna_ep_t *
+vrna_cotrans_bpp(vrna_cotrans_t *ct,
+                 unsigned int   length,
+                 double         cutoff);
+
+
+/**
+ * @}
+ */
+
+#endif
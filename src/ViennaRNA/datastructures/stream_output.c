@@ -32,8 +32,10 @@ struct vrna_ordered_stream_s {
   void                        **data;     /* actual data passed to the callback */
   unsigned char               *provided;  /* for simplicity we use unsigned char instead of single bits per element */
   void                        *auxdata;   /* auxiliary data passed to the callback */
+  unsigned int                window;     /* maximum number of pending elements, 0 = unlimited */
 #if VRNA_WITH_PTHREADS
   pthread_mutex_t             mtx;        /* semaphore to provide concurrent access */
+  pthread_cond_t              window_cnd; /* signals that the start of the queue has moved */
 #endif
 };
 
@@ -41,7 +43,9 @@ struct vrna_ordered_stream_s {
 PRIVATE INLINE void
 flush_output(struct vrna_ordered_stream_s *queue)
 {
-  unsigned int j;
+  unsigned int j, old_start;
+
+  old_start = queue->start;
 
   /* flush all consecutive blocks available from the start of queue */
 
@@ -59,6 +63,12 @@ flush_output(struct vrna_ordered_stream_s *queue)
     queue->provided[queue->start] = 0;
     queue->end                    = queue->start;
   }
+
+#if VRNA_WITH_PTHREADS
+  /* 4. wake up producers waiting for a free slot in the reorder window */
+  if (queue->start != old_start)
+    pthread_cond_broadcast(&queue->window_cnd);
+#endif
 }
 
 
@@ -76,11 +86,13 @@ vrna_ostream_init(vrna_callback_stream_output *output,
   queue->shift    = 0;
   queue->output   = output;
   queue->auxdata  = auxdata;
+  queue->window   = 0;
   queue->data     = (void **)vrna_alloc(sizeof(void *) * QUEUE_OVERHEAD);
   queue->provided = (unsigned char *)vrna_alloc(sizeof(unsigned char) * QUEUE_OVERHEAD);
 
 #if VRNA_WITH_PTHREADS
   pthread_mutex_init(&queue->mtx, NULL);
+  pthread_cond_init(&queue->window_cnd, NULL);
 #endif
 
   return queue;
@@ -99,6 +111,8 @@ vrna_ostream_free(struct vrna_ordered_stream_s *queue)
 
 #if VRNA_WITH_PTHREADS
     pthread_mutex_unlock(&queue->mtx);
+    pthread_mutex_destroy(&queue->mtx);
+    pthread_cond_destroy(&queue->window_cnd);
 #endif
 
     /* free remaining memory */
@@ -124,6 +138,25 @@ vrna_ostream_threadsafe(void)
 }
 
 
+PUBLIC void
+vrna_ostream_set_window(struct vrna_ordered_stream_s  *queue,
+                        unsigned int                  window)
+{
+  if (queue) {
+#if VRNA_WITH_PTHREADS
+    pthread_mutex_lock(&queue->mtx);
+#endif
+
+    queue->window = window;
+
+#if VRNA_WITH_PTHREADS
+    pthread_cond_broadcast(&queue->window_cnd);
+    pthread_mutex_unlock(&queue->mtx);
+#endif
+  }
+}
+
+
 PUBLIC void
 vrna_ostream_request(struct vrna_ordered_stream_s *queue,
                      unsigned int                 num)
@@ -133,6 +166,15 @@ vrna_ostream_request(struct vrna_ordered_stream_s *queue,
   if (queue) {
 #if VRNA_WITH_PTHREADS
     pthread_mutex_lock(&queue->mtx);
+
+    /*
+     *  Block until the requested index fits into the reorder window,
+     *  i.e. until enough preceding elements have been flushed
+     */
+    while ((queue->window > 0) &&
+           (num >= queue->start + queue->window))
+      pthread_cond_wait(&queue->window_cnd, &queue->mtx);
+
 #endif
     if (num >= queue->end) {
       /* check whether we have to increase memory */
@@ -212,6 +254,9 @@ vrna_ostream_provide(struct vrna_ordered_stream_s *queue,
         i,
         queue->start,
         queue->end);
+#if VRNA_WITH_PTHREADS
+      pthread_mutex_unlock(&queue->mtx);
+#endif
       return;
     }
 
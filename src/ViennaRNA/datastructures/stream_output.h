@@ -64,12 +64,40 @@ int
 vrna_ostream_threadsafe(void);
 
 
+/**
+ *  @brief  Limit the reorder window of an ordered output stream
+ *
+ *  By default, an ordered output stream accepts requests for arbitrary
+ *  index numbers and buffers all data that can not yet be passed to the
+ *  output callback. This function limits the number of pending elements,
+ *  i.e. elements that have been requested but not yet flushed. If set,
+ *  vrna_ostream_request() blocks the calling thread until the requested
+ *  index lies within @p window elements from the start of the stream.
+ *
+ *  @note   Blocking only takes place if the library has been compiled with
+ *          POSIX threads support (see vrna_ostream_threadsafe()). Since the
+ *          start of the stream only moves when data is provided for it, a
+ *          window limit must only be used if data is provided concurrently,
+ *          i.e. by other threads than the one that requests new indices.
+ *
+ *  @see vrna_ostream_init(), vrna_ostream_request()
+ *
+ *  @param  dat     The output stream
+ *  @param  window  The maximum number of pending elements (0 = unlimited)
+ */
+void
+vrna_ostream_set_window(vrna_ostream_t  dat,
+                        unsigned int    window);
+
+
 /**
  *  @brief  Request index in ordered output stream
  *
  *  This function must be called prior to vrna_ostream_provide() to
  *  indicate that data associted with a certain index number is expected
- *  to be inserted into the stream in the future.
+ *  to be inserted into the stream in the future. If a reorder window has
+ *  been set using vrna_ostream_set_window(), this function blocks until
+ *  @p num fits into the window.
  *
  *  @see vrna_ostream_init(), vrna_ostream_provide(), vrna_ostream_free()
  *
@@ -46,6 +46,7 @@
 #define ALLOC_CIRC        1024
 #define ALLOC_HYBRID      2048
 #define ALLOC_UNIQ        4096
+#define ALLOC_NARROW      8192
 
 
 #define ALLOC_MFE_DEFAULT         (ALLOC_F5 | ALLOC_C | ALLOC_FML)
@@ -149,6 +150,11 @@ PRIVATE vrna_mx_mfe_t *get_mfe_matrices_alloc(unsigned int    n,
                                               unsigned int    alloc_vector);
 
 
+PRIVATE unsigned int    get_mx_pf_alloc_vector(vrna_fold_compound_t *vc,
+                                               vrna_mx_type_e       mx_type,
+                                               unsigned int         options);
+
+
 PRIVATE vrna_mx_pf_t *get_pf_matrices_alloc(unsigned int    n,
                                             unsigned int    m,
                                             vrna_mx_type_e  type,
@@ -234,6 +240,31 @@ vrna_mx_pf_free(vrna_fold_compound_t *vc)
 }
 
 
+PUBLIC int
+vrna_mx_pf_index(const vrna_fold_compound_t *vc,
+                 int                        i,
+                 int                        j)
+{
+  if ((vc->jindx_span) &&
+      ((j - i > (int)vc->jindx_span + 1) || (j < i - 1)))
+    return -1;
+
+  return vc->iindx[i] - j;
+}
+
+
+PUBLIC FLT_OR_DBL
+vrna_mx_pf_get(const vrna_fold_compound_t *vc,
+               const FLT_OR_DBL           *mx,
+               int                        i,
+               int                        j)
+{
+  int idx = vrna_mx_pf_index(vc, i, j);
+
+  return (idx < 0) ? 0. : mx[idx];
+}
+
+
 PUBLIC int
 vrna_mx_add(vrna_fold_compound_t  *vc,
             vrna_mx_type_e        mx_type,
@@ -284,9 +315,7 @@ vrna_mx_pf_add(vrna_fold_compound_t *vc,
   unsigned int mx_alloc_vector;
 
   if (vc->exp_params) {
-    mx_alloc_vector = get_mx_alloc_vector(&(vc->exp_params->model_details),
-                                          mx_type,
-                                          options | VRNA_OPTION_PF);
+    mx_alloc_vector = get_mx_pf_alloc_vector(vc, mx_type, options);
     vrna_mx_pf_free(vc);
     return add_pf_matrices(vc, mx_type, mx_alloc_vector);
   }
@@ -355,11 +384,10 @@ vrna_mx_prepare(vrna_fold_compound_t  *vc,
           (vc->exp_matrices->length < vc->length)) {
         realloc = 1;
       } else {
-        mx_alloc_vector = get_mx_alloc_vector(&(vc->exp_params->model_details),
-                                              mx_type,
-                                              options);
+        mx_alloc_vector         = get_mx_pf_alloc_vector(vc, mx_type, options);
         mx_alloc_vector_current = get_mx_pf_alloc_vector_current(vc->exp_matrices, mx_type);
-        if ((mx_alloc_vector & mx_alloc_vector_current) != mx_alloc_vector)
+        if (((mx_alloc_vector & mx_alloc_vector_current) != mx_alloc_vector) ||
+            ((mx_alloc_vector ^ mx_alloc_vector_current) & ALLOC_NARROW))
           realloc = 1;
       }
 
@@ -435,15 +463,18 @@ get_mx_pf_alloc_vector_current(vrna_mx_pf_t   *mx,
   if (mx) {
     switch (mx_type) {
       case VRNA_MX_DEFAULT:
-        if (mx->q)
+        if ((mx->q) || (mx->q_flt))
           mx_alloc_vector |= ALLOC_F;
 
-        if (mx->qb)
+        if ((mx->qb) || (mx->qb_flt))
           mx_alloc_vector |= ALLOC_C;
 
-        if (mx->qm)
+        if ((mx->qm) || (mx->qm_flt))
           mx_alloc_vector |= ALLOC_FML;
 
+        if ((mx->q_flt) || (mx->qb_flt) || (mx->qm_flt))
+          mx_alloc_vector |= ALLOC_NARROW;
+
         if (mx->qm1)
           mx_alloc_vector |= ALLOC_UNIQ;
 
@@ -482,7 +513,7 @@ add_pf_matrices(vrna_fold_compound_t  *vc,
         break;
       default:
         vc->exp_matrices = get_pf_matrices_alloc(vc->length,
-                                                 vc->length,
+                                                 (vc->jindx_span) ? vc->jindx_span : vc->length,
                                                  mx_type,
                                                  alloc_vector);
         break;
@@ -522,7 +553,10 @@ add_mfe_matrices(vrna_fold_compound_t *vc,
         vc->matrices = get_mfe_matrices_alloc(vc->length, vc->window_size, mx_type, alloc_vector);
         break;
       default:
-        vc->matrices = get_mfe_matrices_alloc(vc->length, vc->length, mx_type, alloc_vector);
+        vc->matrices = get_mfe_matrices_alloc(vc->length,
+                                              (vc->jindx_span) ? vc->jindx_span : vc->length,
+                                              mx_type,
+                                              alloc_vector);
         break;
     }
 
@@ -627,7 +661,7 @@ get_pf_matrices_alloc(unsigned int    n,
 
   switch (type) {
     case VRNA_MX_DEFAULT:
-      pf_matrices_alloc_default(vars, n, alloc_vector);
+      pf_matrices_alloc_default(vars, m, alloc_vector);
       break;
 
     case VRNA_MX_WINDOW:
@@ -687,6 +721,40 @@ get_mx_alloc_vector(vrna_md_t       *md_p,
 }
 
 
+/*
+ *  Partition function matrices are stored in single precision only if
+ *  the single precision fill is requested and nothing else but the
+ *  partition function itself is computed from them, see vrna_md_t.pf_float
+ */
+PRIVATE unsigned int
+get_mx_pf_alloc_vector(vrna_fold_compound_t *vc,
+                       vrna_mx_type_e       mx_type,
+                       unsigned int         options)
+{
+  unsigned int  v;
+  vrna_md_t     *md;
+
+  md  = &(vc->exp_params->model_details);
+  v   = get_mx_alloc_vector(md, mx_type, options | VRNA_OPTION_PF);
+
+  if ((md->pf_float) &&
+      (sizeof(FLT_OR_DBL) == sizeof(double)) &&
+      (mx_type == VRNA_MX_DEFAULT) &&
+      (vc->type == VRNA_FC_TYPE_SINGLE) &&
+      (!(v & (ALLOC_PROBS | ALLOC_HYBRID | ALLOC_CIRC | ALLOC_UNIQ))) &&
+      (!md->gquad) &&
+      (md->backtrack_type == 'F'))
+    v |= ALLOC_NARROW | ALLOC_AUX;
+
+  /* banded matrices provide the exterior loop only via q1k and qln */
+  if ((mx_type == VRNA_MX_DEFAULT) &&
+      (vc->jindx_span))
+    v |= ALLOC_AUX;
+
+  return v;
+}
+
+
 PRIVATE void
 mfe_matrices_alloc_default(vrna_mx_mfe_t  *vars,
                            unsigned int   m,
@@ -695,9 +763,13 @@ mfe_matrices_alloc_default(vrna_mx_mfe_t  *vars,
   unsigned int n, size, lin_size;
 
   n         = vars->length;
-  size      = ((n + 1) * (m + 2)) / 2;
   lin_size  = n + 2;
 
+  if (m < n) /* banded matrices for a maximum base pair span m, see vrna_idx_col_wise_banded() */
+    size = (n + 1) * (m + 3);
+  else
+    size = ((n + 1) * (m + 2)) / 2;
+
   vars->f5  = NULL;
   vars->f3  = NULL;
   vars->fc  = NULL;
@@ -1283,32 +1355,58 @@ pf_matrices_alloc_default(vrna_mx_pf_t  *vars,
                           unsigned int  m,
                           unsigned int  alloc_vector)
 {
-  unsigned int n, size, lin_size;
+  unsigned int n, size, size_j, lin_size;
 
   n         = vars->length;
-  size      = ((n + 1) * (n + 2)) / 2;
   lin_size  = n + 2;
 
-  vars->q     = NULL;
-  vars->qb    = NULL;
-  vars->qm    = NULL;
-  vars->qm1   = NULL;
-  vars->qm2   = NULL;
-  vars->probs = NULL;
-  vars->q1k   = NULL;
-  vars->qln   = NULL;
+  /*
+   *  banded matrices for a maximum base pair span m, see vrna_idx_row_wise_banded()
+   *  and vrna_idx_col_wise_banded()
+   */
+  if (m < n) {
+    size    = (n + 2) * (m + 3);
+    size_j  = (n + 1) * (m + 3);
+  } else {
+    size    = ((n + 1) * (n + 2)) / 2;
+    size_j  = size;
+  }
 
-  if (alloc_vector & ALLOC_F)
-    vars->q = (FLT_OR_DBL *)vrna_alloc(sizeof(FLT_OR_DBL) * size);
+  vars->q       = NULL;
+  vars->qb      = NULL;
+  vars->qm      = NULL;
+  vars->qm1     = NULL;
+  vars->qm2     = NULL;
+  vars->probs   = NULL;
+  vars->q1k     = NULL;
+  vars->qln     = NULL;
+  vars->q_flt   = NULL;
+  vars->qb_flt  = NULL;
+  vars->qm_flt  = NULL;
+
+  if (alloc_vector & ALLOC_NARROW) {
+    /* single precision storage, see vrna_md_t.pf_float */
+    if (alloc_vector & ALLOC_F)
+      vars->q_flt = (float *)vrna_alloc(sizeof(float) * size);
+
+    if (alloc_vector & ALLOC_C)
+      vars->qb_flt = (float *)vrna_alloc(sizeof(float) * size);
+
+    if (alloc_vector & ALLOC_FML)
+      vars->qm_flt = (float *)vrna_alloc(sizeof(float) * size);
+  } else {
+    if (alloc_vector & ALLOC_F)
+      vars->q = (FLT_OR_DBL *)vrna_alloc(sizeof(FLT_OR_DBL) * size);
 
-  if (alloc_vector & ALLOC_C)
-    vars->qb = (FLT_OR_DBL *)vrna_alloc(sizeof(FLT_OR_DBL) * size);
+    if (alloc_vector & ALLOC_C)
+      vars->qb = (FLT_OR_DBL *)vrna_alloc(sizeof(FLT_OR_DBL) * size);
 
-  if (alloc_vector & ALLOC_FML)
-    vars->qm = (FLT_OR_DBL *)vrna_alloc(sizeof(FLT_OR_DBL) * size);
+    if (alloc_vector & ALLOC_FML)
+      vars->qm = (FLT_OR_DBL *)vrna_alloc(sizeof(FLT_OR_DBL) * size);
+  }
 
   if (alloc_vector & ALLOC_UNIQ)
-    vars->qm1 = (FLT_OR_DBL *)vrna_alloc(sizeof(FLT_OR_DBL) * size);
+    vars->qm1 = (FLT_OR_DBL *)vrna_alloc(sizeof(FLT_OR_DBL) * size_j);
 
   if (alloc_vector & ALLOC_CIRC)
     vars->qm2 = (FLT_OR_DBL *)vrna_alloc(sizeof(FLT_OR_DBL) * lin_size);
@@ -1335,6 +1433,9 @@ pf_matrices_free_default(vrna_mx_pf_t *self)
   free(self->G);
   free(self->q1k);
   free(self->qln);
+  free(self->q_flt);
+  free(self->qb_flt);
+  free(self->qm_flt);
 }
 
 
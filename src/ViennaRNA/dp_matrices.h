@@ -355,6 +355,21 @@ struct {
 };
 };
 #endif
+
+  /** @name Single precision PF matrices
+   *  @note These data fields replace vrna_mx_pf_t.q, vrna_mx_pf_t.qb, and vrna_mx_pf_t.qm
+   *        if the partition function is computed in single precision (see #vrna_md_t.pf_float)
+   *        and neither base pair probabilities nor stochastic backtracking require the double
+   *        precision matrices. The partition functions of the prefixes [1, j] are then
+   *        available in double precision via vrna_mx_pf_t.q1k only.
+   *  @{
+   */
+  float *q_flt;
+  float *qb_flt;
+  float *qm_flt;
+  /**
+   *  @}
+   */
 };
 
 /**
@@ -431,6 +446,49 @@ void
 vrna_mx_pf_free(vrna_fold_compound_t *vc);
 
 
+/**
+ *  @brief  Get the index of a segment @f$[i,j]@f$ in the Partition Function (PF) Dynamic Programming (DP) matrices
+ *
+ *  Computes the position of the segment @f$[i,j]@f$ with @f$i \leq j + 1@f$ in the
+ *  @p vc->iindx addressed matrices vrna_mx_pf_t.q, vrna_mx_pf_t.qb, vrna_mx_pf_t.qm,
+ *  and vrna_mx_pf_t.probs. For banded matrices (see vrna_fold_compound_t.jindx_span),
+ *  segments beyond the band are not stored at all.
+ *
+ *  @see vrna_mx_pf_get(), vrna_hc_mx_index()
+ *
+ *  @param  vc  The #vrna_fold_compound_t storing the PF DP matrices
+ *  @param  i   The 5' end of the segment
+ *  @param  j   The 3' end of the segment
+ *  @return     The index of the segment @f$[i,j]@f$, or -1 if the segment is beyond the band
+ */
+int
+vrna_mx_pf_index(const vrna_fold_compound_t *vc,
+                 int                        i,
+                 int                        j);
+
+
+/**
+ *  @brief  Get an entry of the Partition Function (PF) Dynamic Programming (DP) matrices
+ *
+ *  Retrieves the entry of segment @f$[i,j]@f$ from one of the @p vc->iindx addressed
+ *  matrices, e.g. the base pair probabilities vrna_mx_pf_t.probs. Segments beyond
+ *  the band of banded matrices are never paired, hence, their entries are 0.
+ *
+ *  @see vrna_mx_pf_index()
+ *
+ *  @param  vc  The #vrna_fold_compound_t storing the PF DP matrices
+ *  @param  mx  The matrix to read from
+ *  @param  i   The 5' end of the segment
+ *  @param  j   The 3' end of the segment
+ *  @return     The entry of segment @f$[i,j]@f$, or 0 if the segment is beyond the band
+ */
+FLT_OR_DBL
+vrna_mx_pf_get(const vrna_fold_compound_t *vc,
+               const FLT_OR_DBL           *mx,
+               int                        i,
+               int                        j);
+
+
 /**
  *  @}
  */
@@ -21,7 +21,8 @@
 #include "ViennaRNA/params/default.h"
 #include "ViennaRNA/fold_vars.h"
 #include "ViennaRNA/fold.h"
-#include "ViennaRNA/pair_mat.h"
+#include "ViennaRNA/model.h"
+#include "ViennaRNA/alphabet.h"
 #include "ViennaRNA/params/basic.h"
 #include "ViennaRNA/alifold.h"
 #include "ViennaRNA/subopt.h"
@@ -46,21 +47,34 @@
  # GLOBAL VARIABLES              #
  #################################
  */
+
 /*
  #################################
  # PRIVATE VARIABLES             #
  #################################
  */
-PRIVATE vrna_param_t  *P = NULL;
-PRIVATE int           **c = NULL;     /* energy array, given that i-j pair */
-PRIVATE short         *S1 = NULL, *SS1 = NULL, *S2 = NULL, *SS2 = NULL;
-PRIVATE int           n1, n2;         /* sequence lengths */
+struct vrna_duplex_context_s {
+  vrna_param_t  *P;
+  int           (*pair)[MAXALPHA + 1];
+  int           *rtype;
+  int           **c;                  /* energy array, given that i-j pair */
+  short         *S1, *SS1, *S2, *SS2;
+  int           n1, n2;               /* sequence lengths */
+};
+
+#ifndef VRNA_DISABLE_BACKWARD_COMPATIBILITY
+
+/* contexts used by the old API, re-created whenever the global model settings change */
+PRIVATE vrna_duplex_context_t backward_compat_ctx = NULL;
+PRIVATE vrna_md_t             backward_compat_md;
 
 #ifdef _OPENMP
 
 /* NOTE: all variables are assumed to be uninitialized if they are declared as threadprivate
  */
-#pragma omp threadprivate(P, c, S1, SS1, S2, SS2, n1, n2)
+#pragma omp threadprivate(backward_compat_ctx, backward_compat_md)
+
+#endif
 
 #endif
 
@@ -69,28 +83,56 @@ PRIVATE int           n1, n2;         /* sequence lengths */
  # PRIVATE FUNCTION DECLARATIONS #
  #################################
  */
-PRIVATE duplexT
-duplexfold_cu(const char  *s1,
-              const char  *s2,
-              int         clean_up);
+PRIVATE void
+duplex_fill(vrna_duplex_context_t ctx,
+            const char            *s1,
+            const char            *s2,
+            duplexT               *mfe);
 
 
-PRIVATE duplexT
-aliduplexfold_cu(const char *s1[],
-                 const char *s2[],
-                 int        clean_up);
+PRIVATE duplexT *
+duplex_subopt_list(vrna_duplex_context_t  ctx,
+                   const char             *s1,
+                   const char             *s2,
+                   int                    delta,
+                   int                    w,
+                   int                    sorted);
+
+
+PRIVATE void
+aliduplex_fill(vrna_duplex_context_t  ctx,
+               const char             *s1[],
+               const char             *s2[],
+               short                  ***S1_p,
+               short                  ***S2_p,
+               duplexT                *mfe);
+
+
+PRIVATE duplexT *
+aliduplex_subopt_list(vrna_duplex_context_t ctx,
+                      const char            *s1[],
+                      const char            *s2[],
+                      int                   delta,
+                      int                   w,
+                      int                   sorted);
+
+
+PRIVATE void
+free_dp_arrays(vrna_duplex_context_t ctx);
 
 
 PRIVATE char *
-backtrack(int i,
-          int j);
+backtrack(vrna_duplex_context_t ctx,
+          int                   i,
+          int                   j);
 
 
 PRIVATE char *
-alibacktrack(int          i,
-             int          j,
-             const short  **S1,
-             const short  **S2);
+alibacktrack(vrna_duplex_context_t  ctx,
+             int                    i,
+             int                    j,
+             const short            **S1,
+             const short            **S2);
 
 
 PRIVATE int
@@ -99,53 +141,190 @@ compare(const void  *sub1,
 
 
 PRIVATE int
-covscore(const int  *types,
-         int        n_seq);
+covscore(vrna_duplex_context_t  ctx,
+         const int              *types,
+         int                    n_seq);
+
 
+#ifndef VRNA_DISABLE_BACKWARD_COMPATIBILITY
+
+PRIVATE vrna_duplex_context_t
+get_backward_compat_ctx(void);
+
+
+#endif
 
 /*
  #################################
  # BEGIN OF FUNCTION DEFINITIONS #
  #################################
  */
+PUBLIC vrna_duplex_context_t
+vrna_duplex_context_init(const vrna_md_t *md_p)
+{
+  vrna_md_t             md;
+  vrna_duplex_context_t ctx;
+
+  if (md_p)
+    md = *md_p;
+  else
+    vrna_md_set_default(&md);
+
+  ctx         = (vrna_duplex_context_t)vrna_alloc(sizeof(struct vrna_duplex_context_s));
+  ctx->P      = vrna_params(&md);
+  ctx->pair   = ctx->P->model_details.pair;
+  ctx->rtype  = &(ctx->P->model_details.rtype[0]);
+
+  return ctx;
+}
+
+
+PUBLIC void
+vrna_duplex_context_free(vrna_duplex_context_t ctx)
+{
+  if (ctx) {
+    free_dp_arrays(ctx);
+    free(ctx->P);
+    free(ctx);
+  }
+}
+
+
 PUBLIC duplexT
-duplexfold(const char *s1,
-           const char *s2)
+vrna_duplexfold(vrna_duplex_context_t ctx,
+                const char            *s1,
+                const char            *s2)
 {
-  return duplexfold_cu(s1, s2, 1);
+  duplexT mfe;
+
+  mfe.i         = 0;
+  mfe.j         = 0;
+  mfe.energy    = (float)INF / 100.;
+  mfe.structure = NULL;
+
+  if ((ctx) && (s1) && (s2)) {
+    duplex_fill(ctx, s1, s2, &mfe);
+    free_dp_arrays(ctx);
+  }
+
+  return mfe;
 }
 
 
-PRIVATE duplexT
-duplexfold_cu(const char  *s1,
-              const char  *s2,
-              int         clean_up)
+PUBLIC duplexT *
+vrna_duplex_subopt(vrna_duplex_context_t  ctx,
+                   const char             *s1,
+                   const char             *s2,
+                   int                    delta,
+                   int                    w)
 {
-  int       i, j, Emin = INF, i_min = 0, j_min = 0;
-  char      *struc;
-  duplexT   mfe;
-  vrna_md_t md;
+  if ((ctx) && (s1) && (s2))
+    return duplex_subopt_list(ctx, s1, s2, delta, w, 1);
 
-  n1  = (int)strlen(s1);
-  n2  = (int)strlen(s2);
+  return NULL;
+}
 
-  set_model_details(&md);
-  if ((!P) || (fabs(P->temperature - temperature) > 1e-6)) {
-    if (P)
-      free(P);
 
-    P = vrna_params(&md);
-    make_pair_matrix();
+PUBLIC duplexT
+vrna_aliduplexfold(vrna_duplex_context_t  ctx,
+                   const char             *s1[],
+                   const char             *s2[])
+{
+  int     s;
+  short   **S1, **S2;
+  duplexT mfe;
+
+  mfe.i         = 0;
+  mfe.j         = 0;
+  mfe.energy    = (float)INF / 100.;
+  mfe.structure = NULL;
+
+  if ((ctx) && (s1) && (s2)) {
+    S1  = NULL;
+    S2  = NULL;
+    aliduplex_fill(ctx, s1, s2, &S1, &S2, &mfe);
+    free_dp_arrays(ctx);
+
+    for (s = 0; S1[s] != NULL; s++) {
+      free(S1[s]);
+      free(S2[s]);
+    }
+    free(S1);
+    free(S2);
+  }
+
+  return mfe;
+}
+
+
+PUBLIC duplexT *
+vrna_aliduplex_subopt(vrna_duplex_context_t ctx,
+                      const char            *s1[],
+                      const char            *s2[],
+                      int                   delta,
+                      int                   w)
+{
+  if ((ctx) && (s1) && (s2))
+    return aliduplex_subopt_list(ctx, s1, s2, delta, w, 1);
+
+  return NULL;
+}
+
+
+PRIVATE void
+free_dp_arrays(vrna_duplex_context_t ctx)
+{
+  int i;
+
+  if (ctx->c) {
+    for (i = 1; i <= ctx->n1; i++)
+      free(ctx->c[i]);
+    free(ctx->c);
   }
 
-  c = (int **)vrna_alloc(sizeof(int *) * (n1 + 1));
+  free(ctx->S1);
+  free(ctx->S2);
+  free(ctx->SS1);
+  free(ctx->SS2);
+
+  ctx->c    = NULL;
+  ctx->S1   = NULL;
+  ctx->S2   = NULL;
+  ctx->SS1  = NULL;
+  ctx->SS2  = NULL;
+}
+
+
+PRIVATE void
+duplex_fill(vrna_duplex_context_t ctx,
+            const char            *s1,
+            const char            *s2,
+            duplexT               *mfe)
+{
+  int           i, j, n1, n2, Emin = INF, i_min = 0, j_min = 0;
+  int           **c, (*pair)[MAXALPHA + 1], *rtype;
+  short         *S1, *S2, *SS1, *SS2;
+  char          *struc;
+  vrna_param_t  *P;
+  vrna_md_t     *md;
+
+  free_dp_arrays(ctx);
+
+  P     = ctx->P;
+  md    = &(P->model_details);
+  pair  = ctx->pair;
+  rtype = ctx->rtype;
+  n1    = ctx->n1 = (int)strlen(s1);
+  n2    = ctx->n2 = (int)strlen(s2);
+
+  c = ctx->c = (int **)vrna_alloc(sizeof(int *) * (n1 + 1));
   for (i = 1; i <= n1; i++)
     c[i] = (int *)vrna_alloc(sizeof(int) * (n2 + 1));
 
-  S1  = encode_sequence(s1, 0);
-  S2  = encode_sequence(s2, 0);
-  SS1 = encode_sequence(s1, 1);
-  SS2 = encode_sequence(s2, 1);
+  S1  = ctx->S1 = vrna_seq_encode_simple(s1, md);
+  S2  = ctx->S2 = vrna_seq_encode_simple(s2, md);
+  SS1 = ctx->SS1 = vrna_seq_encode(s1, md);
+  SS2 = ctx->SS2 = vrna_seq_encode(s2, md);
 
   for (i = 1; i <= n1; i++) {
     for (j = n2; j > 0; j--) {
@@ -180,50 +359,51 @@ duplexfold_cu(const char  *s1,
     }
   }
 
-  struc = backtrack(i_min, j_min);
+  struc = backtrack(ctx, i_min, j_min);
   if (i_min < n1)
     i_min++;
 
   if (j_min > 1)
     j_min--;
 
-  mfe.i         = i_min;
-  mfe.j         = j_min;
-  mfe.energy    = (float)Emin / 100.;
-  mfe.structure = struc;
-  if (clean_up) {
-    for (i = 1; i <= n1; i++)
-      free(c[i]);
-    free(c);
-    free(S1);
-    free(S2);
-    free(SS1);
-    free(SS2);
-  }
-
-  return mfe;
+  mfe->i          = i_min;
+  mfe->j          = j_min;
+  mfe->energy     = (float)Emin / 100.;
+  mfe->structure  = struc;
 }
 
 
-PUBLIC duplexT *
-duplex_subopt(const char  *s1,
-              const char  *s2,
-              int         delta,
-              int         w)
+PRIVATE duplexT *
+duplex_subopt_list(vrna_duplex_context_t  ctx,
+                   const char             *s1,
+                   const char             *s2,
+                   int                    delta,
+                   int                    w,
+                   int                    sorted)
 {
-  int     i, j, n1, n2, thresh, E, n_subopt = 0, n_max;
-  char    *struc;
-  duplexT mfe;
-  duplexT *subopt;
+  int           i, j, n1, n2, thresh, E, n_subopt = 0, n_max;
+  int           **c, (*pair)[MAXALPHA + 1];
+  short         *S1, *S2, *SS1, *SS2;
+  char          *struc;
+  duplexT       mfe;
+  duplexT       *subopt;
+  vrna_param_t  *P;
 
   n_max   = 16;
   subopt  = (duplexT *)vrna_alloc(n_max * sizeof(duplexT));
-  mfe     = duplexfold_cu(s1, s2, 0);
+  duplex_fill(ctx, s1, s2, &mfe);
   free(mfe.structure);
 
+  P       = ctx->P;
+  pair    = ctx->pair;
+  c       = ctx->c;
+  S1      = ctx->S1;
+  S2      = ctx->S2;
+  SS1     = ctx->SS1;
+  SS2     = ctx->SS2;
   thresh  = (int)mfe.energy * 100 + 0.1 + delta;
-  n1      = strlen(s1);
-  n2      = strlen(s2);
+  n1      = ctx->n1;
+  n2      = ctx->n2;
   for (i = n1; i > 0; i--) {
     for (j = 1; j <= n2; j++) {
       int type, ii, jj, Ed;
@@ -250,7 +430,7 @@ duplex_subopt(const char  *s1,
       if (!type)
         continue;
 
-      struc = backtrack(i, j);
+      struc = backtrack(ctx, i, j);
       vrna_message_info(stderr, "%d %d %d", i, j, E);
       if (n_subopt + 1 >= n_max) {
         n_max   *= 2;
@@ -263,16 +443,9 @@ duplex_subopt(const char  *s1,
       subopt[n_subopt++].structure  = struc;
     }
   }
-  /* free all static globals */
-  for (i = 1; i <= n1; i++)
-    free(c[i]);
-  free(c);
-  free(S1);
-  free(S2);
-  free(SS1);
-  free(SS2);
+  free_dp_arrays(ctx);
 
-  if (subopt_sorted)
+  if (sorted)
     qsort(subopt, n_subopt, sizeof(duplexT), compare);
 
   subopt[n_subopt].i          = 0;
@@ -283,13 +456,28 @@ duplex_subopt(const char  *s1,
 
 
 PRIVATE char *
-backtrack(int i,
-          int j)
+backtrack(vrna_duplex_context_t ctx,
+          int                   i,
+          int                   j)
 {
   /* backtrack structure going backwards from i, and forwards from j
    * return structure in bracket notation with & as separator */
-  int   k, l, type, type2, E, traced, i0, j0;
-  char  *st1, *st2, *struc;
+  int           k, l, type, type2, E, traced, i0, j0, n1, n2;
+  int           **c, (*pair)[MAXALPHA + 1], *rtype;
+  short         *S1, *S2, *SS1, *SS2;
+  char          *st1, *st2, *struc;
+  vrna_param_t  *P;
+
+  P     = ctx->P;
+  pair  = ctx->pair;
+  rtype = ctx->rtype;
+  c     = ctx->c;
+  S1    = ctx->S1;
+  S2    = ctx->S2;
+  SS1   = ctx->SS1;
+  SS2   = ctx->SS2;
+  n1    = ctx->n1;
+  n2    = ctx->n2;
 
   st1 = (char *)vrna_alloc(sizeof(char) * (n1 + 1));
   st2 = (char *)vrna_alloc(sizeof(char) * (n2 + 1));
@@ -387,28 +575,30 @@ compare(const void  *sub1,
 
 /*---------------------------------------------------------------------------*/
 
-PUBLIC duplexT
-aliduplexfold(const char  *s1[],
-              const char  *s2[])
+PRIVATE void
+aliduplex_fill(vrna_duplex_context_t  ctx,
+               const char             *s1[],
+               const char             *s2[],
+               short                  ***S1_p,
+               short                  ***S2_p,
+               duplexT                *mfe)
 {
-  return aliduplexfold_cu(s1, s2, 1);
-}
-
-
-PRIVATE duplexT
-aliduplexfold_cu(const char *s1[],
-                 const char *s2[],
-                 int        clean_up)
-{
-  int       i, j, s, n_seq, Emin = INF, i_min = 0, j_min = 0;
-  char      *struc;
-  duplexT   mfe;
-  short     **S1, **S2;
-  int       *type;
-  vrna_md_t md;
-
-  n1  = (int)strlen(s1[0]);
-  n2  = (int)strlen(s2[0]);
+  int           i, j, s, n1, n2, n_seq, Emin = INF, i_min = 0, j_min = 0;
+  int           **c, (*pair)[MAXALPHA + 1], *rtype;
+  char          *struc;
+  short         **S1, **S2;
+  int           *type;
+  vrna_param_t  *P;
+  vrna_md_t     *md;
+
+  free_dp_arrays(ctx);
+
+  P     = ctx->P;
+  md    = &(P->model_details);
+  pair  = ctx->pair;
+  rtype = ctx->rtype;
+  n1    = ctx->n1 = (int)strlen(s1[0]);
+  n2    = ctx->n2 = (int)strlen(s2[0]);
 
   for (s = 0; s1[s] != NULL; s++);
   n_seq = s;
@@ -416,16 +606,7 @@ aliduplexfold_cu(const char *s1[],
   if (n_seq != s)
     vrna_message_error("unequal number of sequences in aliduplexfold()\n");
 
-  set_model_details(&md);
-  if ((!P) || (fabs(P->temperature - temperature) > 1e-6)) {
-    if (P)
-      free(P);
-
-    P = vrna_params(&md);
-    make_pair_matrix();
-  }
-
-  c = (int **)vrna_alloc(sizeof(int *) * (n1 + 1));
+  c = ctx->c = (int **)vrna_alloc(sizeof(int *) * (n1 + 1));
   for (i = 1; i <= n1; i++)
     c[i] = (int *)vrna_alloc(sizeof(int) * (n2 + 1));
 
@@ -438,8 +619,8 @@ aliduplexfold_cu(const char *s1[],
     if (strlen(s2[s]) != n2)
       vrna_message_error("uneqal seqence lengths");
 
-    S1[s] = encode_sequence(s1[s], 0);
-    S2[s] = encode_sequence(s2[s], 0);
+    S1[s] = vrna_seq_encode_simple(s1[s], md);
+    S2[s] = vrna_seq_encode_simple(s2[s], md);
   }
   type = (int *)vrna_alloc(n_seq * sizeof(int));
 
@@ -448,7 +629,7 @@ aliduplexfold_cu(const char *s1[],
       int k, l, E, psc;
       for (s = 0; s < n_seq; s++)
         type[s] = pair[S1[s][i]][S2[s][j]];
-      psc = covscore(type, n_seq);
+      psc = covscore(ctx, type, n_seq);
       for (s = 0; s < n_seq; s++)
         if (type[s] == 0)
           type[s] = 7;
@@ -499,70 +680,55 @@ aliduplexfold_cu(const char *s1[],
     }
   }
 
-  struc = alibacktrack(i_min, j_min, (const short **)S1, (const short **)S2);
+  struc = alibacktrack(ctx, i_min, j_min, (const short **)S1, (const short **)S2);
   if (i_min < n1)
     i_min++;
 
   if (j_min > 1)
     j_min--;
 
-  mfe.i         = i_min;
-  mfe.j         = j_min;
-  mfe.energy    = (float)(Emin / (100. * n_seq));
-  mfe.structure = struc;
-  if (clean_up) {
-    for (i = 1; i <= n1; i++)
-      free(c[i]);
-    free(c);
-  }
+  mfe->i          = i_min;
+  mfe->j          = j_min;
+  mfe->energy     = (float)(Emin / (100. * n_seq));
+  mfe->structure  = struc;
 
-  for (s = 0; s < n_seq; s++) {
-    free(S1[s]);
-    free(S2[s]);
-  }
-  free(S1);
-  free(S2);
+  *S1_p = S1;
+  *S2_p = S2;
   free(type);
-  return mfe;
 }
 
 
-PUBLIC duplexT *
-aliduplex_subopt(const char *s1[],
-                 const char *s2[],
-                 int        delta,
-                 int        w)
+PRIVATE duplexT *
+aliduplex_subopt_list(vrna_duplex_context_t ctx,
+                      const char            *s1[],
+                      const char            *s2[],
+                      int                   delta,
+                      int                   w,
+                      int                   sorted)
 {
-  int     i, j, n1, n2, thresh, E, n_subopt = 0, n_max, s, n_seq, *type;
-  char    *struc;
-  duplexT mfe;
-  duplexT *subopt;
-  short   **S1, **S2;
+  int           i, j, n1, n2, thresh, E, n_subopt = 0, n_max, s, n_seq, *type;
+  int           **c, (*pair)[MAXALPHA + 1];
+  char          *struc;
+  duplexT       mfe;
+  duplexT       *subopt;
+  short         **S1, **S2;
+  vrna_param_t  *P;
 
   n_max   = 16;
   subopt  = (duplexT *)vrna_alloc(n_max * sizeof(duplexT));
-  mfe     = aliduplexfold_cu(s1, s2, 0);
+  aliduplex_fill(ctx, s1, s2, &S1, &S2, &mfe);
   free(mfe.structure);
 
   for (s = 0; s1[s] != NULL; s++);
   n_seq = s;
 
+  P       = ctx->P;
+  pair    = ctx->pair;
+  c       = ctx->c;
   thresh  = (int)((mfe.energy * 100. + delta) * n_seq + 0.1);
-  n1      = strlen(s1[0]);
-  n2      = strlen(s2[0]);
-  S1      = (short **)vrna_alloc((n_seq + 1) * sizeof(short *));
-  S2      = (short **)vrna_alloc((n_seq + 1) * sizeof(short *));
-  for (s = 0; s < n_seq; s++) {
-    if (strlen(s1[s]) != n1)
-      vrna_message_error("uneqal seqence lengths");
-
-    if (strlen(s2[s]) != n2)
-      vrna_message_error("uneqal seqence lengths");
-
-    S1[s] = encode_sequence(s1[s], 0);
-    S2[s] = encode_sequence(s2[s], 0);
-  }
-  type = (int *)vrna_alloc(n_seq * sizeof(int));
+  n1      = ctx->n1;
+  n2      = ctx->n2;
+  type    = (int *)vrna_alloc(n_seq * sizeof(int));
 
   for (i = n1; i > 0; i--) {
     for (j = 1; j <= n2; j++) {
@@ -570,7 +736,7 @@ aliduplex_subopt(const char *s1[],
 
       for (s = 0; s < n_seq; s++)
         type[s] = pair[S2[s][j]][S1[s][i]];
-      psc = covscore(type, n_seq);
+      psc = covscore(ctx, type, n_seq);
       for (s = 0; s < n_seq; s++)
         if (type[s] == 0)
           type[s] = 7;
@@ -599,7 +765,7 @@ aliduplex_subopt(const char *s1[],
       if (skip)
         continue;
 
-      struc = alibacktrack(i, j, (const short **)S1, (const short **)S2);
+      struc = alibacktrack(ctx, i, j, (const short **)S1, (const short **)S2);
       vrna_message_info(stderr, "%d %d %d", i, j, E);
       if (n_subopt + 1 >= n_max) {
         n_max   *= 2;
@@ -613,9 +779,7 @@ aliduplex_subopt(const char *s1[],
     }
   }
 
-  for (i = 1; i <= n1; i++)
-    free(c[i]);
-  free(c);
+  free_dp_arrays(ctx);
   for (s = 0; s < n_seq; s++) {
     free(S1[s]);
     free(S2[s]);
@@ -624,7 +788,7 @@ aliduplex_subopt(const char *s1[],
   free(S2);
   free(type);
 
-  if (subopt_sorted)
+  if (sorted)
     qsort(subopt, n_subopt, sizeof(duplexT), compare);
 
   subopt[n_subopt].i          = 0;
@@ -635,18 +799,25 @@ aliduplex_subopt(const char *s1[],
 
 
 PRIVATE char *
-alibacktrack(int          i,
-             int          j,
-             const short  **S1,
-             const short  **S2)
+alibacktrack(vrna_duplex_context_t  ctx,
+             int                    i,
+             int                    j,
+             const short            **S1,
+             const short            **S2)
 {
   /* backtrack structure going backwards from i, and forwards from j
    * return structure in bracket notation with & as separator */
-  int   k, l, *type, type2, E, traced, i0, j0, s, n_seq;
-  char  *st1, *st2, *struc;
-
-  n1  = (int)S1[0][0];
-  n2  = (int)S2[0][0];
+  int           k, l, *type, type2, E, traced, i0, j0, s, n_seq, n1, n2;
+  int           **c, (*pair)[MAXALPHA + 1], *rtype;
+  char          *st1, *st2, *struc;
+  vrna_param_t  *P;
+
+  P     = ctx->P;
+  pair  = ctx->pair;
+  rtype = ctx->rtype;
+  c     = ctx->c;
+  n1    = (int)S1[0][0];
+  n2    = (int)S2[0][0];
 
   for (s = 0; S1[s] != NULL; s++);
   n_seq = s;
@@ -669,7 +840,7 @@ alibacktrack(int          i,
     st2[j - 1]  = ')';
     for (s = 0; s < n_seq; s++)
       type[s] = pair[S1[s][i]][S2[s][j]];
-    psc = covscore(type, n_seq);
+    psc = covscore(ctx, type, n_seq);
     for (s = 0; s < n_seq; s++)
       if (type[s] == 0)
         type[s] = 7;
@@ -740,8 +911,9 @@ alibacktrack(int          i,
 
 
 PRIVATE int
-covscore(const int  *types,
-         int        n_seq)
+covscore(vrna_duplex_context_t  ctx,
+         const int              *types,
+         int                    n_seq)
 {
   /*
    * calculate co-variance bonus for a pair depending on
@@ -776,7 +948,73 @@ covscore(const int  *types,
       score += pfreq[k] * pfreq[l] * dm[k][l];
 
   /* counter examples score -1, gap-gap scores -0.25   */
-  pscore = cv_fact *
-           ((UNIT * score) / n_seq - nc_fact * UNIT * (pfreq[0] + pfreq[7] * 0.25));
+  pscore = ctx->P->model_details.cv_fact *
+           ((UNIT * score) / n_seq - ctx->P->model_details.nc_fact * UNIT *
+            (pfreq[0] + pfreq[7] * 0.25));
   return pscore;
 }
+
+
+/*
+ *###########################################
+ *# deprecated functions below              #
+ *###########################################
+ */
+
+#ifndef VRNA_DISABLE_BACKWARD_COMPATIBILITY
+
+PUBLIC duplexT
+duplexfold(const char *s1,
+           const char *s2)
+{
+  return vrna_duplexfold(get_backward_compat_ctx(), s1, s2);
+}
+
+
+PUBLIC duplexT *
+duplex_subopt(const char  *s1,
+              const char  *s2,
+              int         delta,
+              int         w)
+{
+  return duplex_subopt_list(get_backward_compat_ctx(), s1, s2, delta, w, subopt_sorted);
+}
+
+
+PUBLIC duplexT
+aliduplexfold(const char  *s1[],
+              const char  *s2[])
+{
+  return vrna_aliduplexfold(get_backward_compat_ctx(), s1, s2);
+}
+
+
+PUBLIC duplexT *
+aliduplex_subopt(const char *s1[],
+                 const char *s2[],
+                 int        delta,
+                 int        w)
+{
+  return aliduplex_subopt_list(get_backward_compat_ctx(), s1, s2, delta, w, subopt_sorted);
+}
+
+
+PRIVATE vrna_duplex_context_t
+get_backward_compat_ctx(void)
+{
+  vrna_md_t md;
+
+  set_model_details(&md);
+
+  if ((!backward_compat_ctx) ||
+      (memcmp(&md, &backward_compat_md, sizeof(vrna_md_t)))) {
+    vrna_duplex_context_free(backward_compat_ctx);
+    backward_compat_ctx = vrna_duplex_context_init(&md);
+    memcpy(&backward_compat_md, &md, sizeof(vrna_md_t));
+  }
+
+  return backward_compat_ctx;
+}
+
+
+#endif
@@ -2,8 +2,7 @@
 #define VIENNA_RNA_PACKAGE_DUPLEX_H
 
 #include <ViennaRNA/datastructures/basic.h>
-
-#ifndef VRNA_DISABLE_BACKWARD_COMPATIBILITY
+#include <ViennaRNA/model.h>
 
 /**
  *  @file     duplex.h
@@ -12,6 +11,115 @@
  */
 
 
+/**
+ *  @brief  A reentrant context for RNA-RNA duplex predictions
+ *
+ *  The context holds the energy parameters and the dynamic programming
+ *  matrices of a duplex prediction. Different contexts may be used
+ *  concurrently from different threads, while a single context must
+ *  not be shared between threads at the same time.
+ *
+ *  @see  vrna_duplex_context_init(), vrna_duplex_context_free(),
+ *        vrna_duplexfold(), vrna_duplex_subopt(), vrna_aliduplexfold(),
+ *        vrna_aliduplex_subopt()
+ */
+typedef struct vrna_duplex_context_s *vrna_duplex_context_t;
+
+
+/**
+ *  @brief  Create a new duplex prediction context
+ *
+ *  @param  md  The model details to use, or NULL to use default settings
+ *  @return     A new duplex prediction context
+ */
+vrna_duplex_context_t
+vrna_duplex_context_init(const vrna_md_t *md);
+
+
+/**
+ *  @brief  Release all memory occupied by a duplex prediction context
+ *
+ *  @param  ctx The duplex prediction context to free
+ */
+void
+vrna_duplex_context_free(vrna_duplex_context_t ctx);
+
+
+/**
+ *  @brief  Compute the minimum free energy duplex of two RNA strands
+ *
+ *  Only inter-molecular base pairs are allowed.
+ *
+ *  @param  ctx The duplex prediction context
+ *  @param  s1  The first sequence
+ *  @param  s2  The second sequence
+ *  @return     The MFE duplex structure, its energy and the interaction coordinates
+ */
+duplexT
+vrna_duplexfold(vrna_duplex_context_t ctx,
+                const char            *s1,
+                const char            *s2);
+
+
+/**
+ *  @brief  Compute suboptimal duplexes of two RNA strands
+ *
+ *  Suboptimal duplexes within @p delta dcal/mol of the MFE are returned, where
+ *  hits that are dominated by a better one within @p w nucleotides are skipped.
+ *  The list is sorted by free energy and terminated by an entry with
+ *  duplexT.structure set to NULL.
+ *
+ *  @param  ctx   The duplex prediction context
+ *  @param  s1    The first sequence
+ *  @param  s2    The second sequence
+ *  @param  delta The energy range in dcal/mol
+ *  @param  w     The minimal distance between suboptimal duplexes
+ *  @return       A list of suboptimal duplexes
+ */
+duplexT *
+vrna_duplex_subopt(vrna_duplex_context_t  ctx,
+                   const char             *s1,
+                   const char             *s2,
+                   int                    delta,
+                   int                    w);
+
+
+/**
+ *  @brief  Compute the minimum free energy duplex of two sequence alignments
+ *
+ *  @param  ctx The duplex prediction context
+ *  @param  s1  The first alignment (NULL-terminated)
+ *  @param  s2  The second alignment (NULL-terminated)
+ *  @return     The MFE duplex structure, its energy and the interaction coordinates
+ */
+duplexT
+vrna_aliduplexfold(vrna_duplex_context_t  ctx,
+                   const char             *s1[],
+                   const char             *s2[]);
+
+
+/**
+ *  @brief  Compute suboptimal duplexes of two sequence alignments
+ *
+ *  @see  vrna_duplex_subopt()
+ *
+ *  @param  ctx   The duplex prediction context
+ *  @param  s1    The first alignment (NULL-terminated)
+ *  @param  s2    The second alignment (NULL-terminated)
+ *  @param  delta The energy range in dcal/mol
+ *  @param  w     The minimal distance between suboptimal duplexes
+ *  @return       A list of suboptimal duplexes
+ */
+duplexT *
+vrna_aliduplex_subopt(vrna_duplex_context_t ctx,
+                      const char            *s1[],
+                      const char            *s2[],
+                      int                   delta,
+                      int                   w);
+
+
+#ifndef VRNA_DISABLE_BACKWARD_COMPATIBILITY
+
 duplexT duplexfold(const char *s1,
                    const char *s2);
 
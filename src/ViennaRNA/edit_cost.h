@@ -12,8 +12,6 @@ PRIVATE char  *coding = "Null:U:P:H:B:I:M:S:E:R";
 
 typedef int CostMatrix[10][10];
 
-PRIVATE CostMatrix *EditCost;  /* will point to UsualCost or ShapiroCost */
-
 PRIVATE CostMatrix  UsualCost =
 {
 
@@ -110,7 +110,8 @@ PRIVATE double
 wrap_mean_bp_distance(FLT_OR_DBL  *p,
                       int         length,
                       int         *index,
-                      int         turn);
+                      int         turn,
+                      int         max_d);
 
 
 typedef struct {
@@ -118,6 +119,10 @@ typedef struct {
   FLT_OR_DBL  *prm_l1;
   FLT_OR_DBL  *prml;
 
+  FLT_OR_DBL  *prmt;      /* contributions of enclosing pairs (i, j > l + 1) per i */
+  FLT_OR_DBL  *prmt1;     /* contributions of enclosing pairs (i, l + 1) per i */
+  FLT_OR_DBL  *prm_MLb;   /* prm_MLb per k for the current column l */
+
   int         ud_max_size;
   FLT_OR_DBL  **pmlu;
   FLT_OR_DBL  *prm_MLbu;
@@ -202,6 +207,14 @@ contrib_ext_pair_comparative(vrna_fold_compound_t *fc,
                              unsigned int         j);
 
 
+PRIVATE FLT_OR_DBL
+get_Q(vrna_fold_compound_t *fc);
+
+
+PRIVATE char *
+db_from_probs_banded(vrna_fold_compound_t *fc);
+
+
 /*
  #################################
  # BEGIN OF FUNCTION DEFINITIONS #
@@ -211,7 +224,8 @@ PUBLIC double
 vrna_pr_structure(vrna_fold_compound_t  *fc,
                   const char            *structure)
 {
-  if (fc && fc->exp_params && fc->exp_matrices && fc->exp_matrices->q) {
+  if (fc && fc->exp_params && fc->exp_matrices &&
+      ((fc->exp_matrices->q) || (fc->exp_matrices->q_flt))) {
     unsigned int      n;
     double            e, kT, Q, dG, p;
     vrna_exp_param_t  *params = fc->exp_params;
@@ -228,7 +242,7 @@ vrna_pr_structure(vrna_fold_compound_t  *fc,
     }
 
     kT  = params->kT / 1000.;
-    Q   = params->model_details.circ ? fc->exp_matrices->qo : fc->exp_matrices->q[fc->iindx[1] - n];
+    Q   = get_Q(fc);
 
     dG = (-log(Q) - n * log(params->pf_scale)) * kT;
 
@@ -253,14 +267,15 @@ PUBLIC double
 vrna_pr_energy(vrna_fold_compound_t *fc,
                double               e)
 {
-  if (fc && fc->exp_params && fc->exp_matrices && fc->exp_matrices->q) {
+  if (fc && fc->exp_params && fc->exp_matrices &&
+      ((fc->exp_matrices->q) || (fc->exp_matrices->q_flt))) {
     unsigned int      n;
     double            kT, Q, dG, p;
     vrna_exp_param_t  *params = fc->exp_params;
     n = fc->length;
 
     kT  = params->kT / 1000.;
-    Q   = params->model_details.circ ? fc->exp_matrices->qo : fc->exp_matrices->q[fc->iindx[1] - n];
+    Q   = get_Q(fc);
 
     dG = (-log(Q) - n * log(params->pf_scale)) * kT;
 
@@ -307,7 +322,7 @@ vrna_mean_bp_distance_pr(int        length,
     return (double)INF / 100.;
   }
 
-  d = wrap_mean_bp_distance(p, length, index, TURN);
+  d = wrap_mean_bp_distance(p, length, index, TURN, length);
 
   free(index);
   return d;
@@ -327,7 +342,8 @@ vrna_mean_bp_distance(vrna_fold_compound_t *vc)
     return wrap_mean_bp_distance(vc->exp_matrices->probs,
                                  vc->length,
                                  vc->iindx,
-                                 vc->exp_params->model_details.min_loop_size);
+                                 vc->exp_params->model_details.min_loop_size,
+                                 (vc->jindx_span) ? vc->jindx_span + 1 : vc->length);
   }
 
   return (double)INF / 100.;
@@ -338,7 +354,7 @@ PUBLIC double
 vrna_ensemble_defect(vrna_fold_compound_t *fc,
                      const char           *structure)
 {
-  unsigned int  i, j, n;
+  unsigned int  i, j, n, max_d;
   int           ii;
   double        ed = -1.;
 
@@ -354,23 +370,25 @@ vrna_ensemble_defect(vrna_fold_compound_t *fc,
     int         *idx    = fc->iindx;
     ed = 0.;
 
+    max_d = (fc->jindx_span) ? fc->jindx_span + 1 : n;
+
     for (i = 1; i < n; i++) {
       ii = idx[i];
       double pi;
 
       /* compute probability to be paired */
-      for (pi = 0., j = 1; j < i; j++)
+      for (pi = 0., j = (i > max_d) ? i - max_d : 1; j < i; j++)
         pi += probs[idx[j] - i];
 
-      for (j = i + 1; j <= n; j++)
+      for (j = i + 1; j <= MIN2(n, i + max_d); j++)
         pi += probs[ii - j];
 
       if (pt[i] == 0)
         ed += pi;
       else if (pt[i] > i)
-        ed += 1 - probs[ii - pt[i]];
+        ed += 1 - vrna_mx_pf_get(fc, probs, i, pt[i]);
       else
-        ed += 1 - probs[idx[pt[i]] - i];
+        ed += 1 - vrna_mx_pf_get(fc, probs, pt[i], i);
     }
 
     ed /= (double)n;
@@ -390,7 +408,7 @@ vrna_positional_entropy(vrna_fold_compound_t *fc)
   if ((fc) &&
       (fc->exp_matrices) &&
       (fc->exp_matrices->probs)) {
-    unsigned int  i, j, n;
+    unsigned int  i, j, n, max_d;
     int           *my_iindx, ii, turn;
     FLT_OR_DBL    *probs;
     double        log2, a, p, *pp;
@@ -400,6 +418,7 @@ vrna_positional_entropy(vrna_fold_compound_t *fc)
     my_iindx  = fc->iindx;
     probs     = fc->exp_matrices->probs;
     turn      = fc->exp_params->model_details.min_loop_size;
+    max_d     = (fc->jindx_span) ? fc->jindx_span + 1 : n;
     pos_ent   = (double *)vrna_alloc(sizeof(double) * (n + 1));
     pp        = (double *)vrna_alloc(sizeof(double) * (n + 1));
 
@@ -407,7 +426,7 @@ vrna_positional_entropy(vrna_fold_compound_t *fc)
 
     for (i = 1; i <= n; i++) {
       ii = my_iindx[i];
-      for (j = i + turn + 1; j <= n; j++) {
+      for (j = i + turn + 1; j <= MIN2(n, i + max_d); j++) {
         p = (double)probs[ii - j];
         a = (p > 0.) ? p * log(p) : 0.;
         pos_ent[i] += a;
@@ -434,7 +453,7 @@ vrna_stack_prob(vrna_fold_compound_t  *vc,
                 double                cutoff)
 {
   vrna_ep_t         *pl;
-  int               i, j, plsize, turn, length, *index, *jindx, *rtype, num;
+  int               i, j, plsize, turn, max_d, length, *index, *jindx, *rtype, num;
   char              *ptype;
   FLT_OR_DBL        *qb, *probs, *scale, p;
   vrna_exp_param_t  *pf_params;
@@ -456,11 +475,12 @@ vrna_stack_prob(vrna_fold_compound_t  *vc,
     probs     = matrices->probs;
     scale     = matrices->scale;
     turn      = pf_params->model_details.min_loop_size;
+    max_d     = (vc->jindx_span) ? (int)vc->jindx_span + 1 : length;
 
     pl = (vrna_ep_t *)vrna_alloc(plsize * sizeof(vrna_ep_t));
 
     for (i = 1; i < length; i++)
-      for (j = i + turn + 3; j <= length; j++) {
+      for (j = i + turn + 3; j <= MIN2(length, i + max_d); j++) {
         if ((p = probs[index[i] - j]) < cutoff)
           continue;
 
@@ -559,7 +579,7 @@ PRIVATE int
 pf_create_bppm(vrna_fold_compound_t *vc,
                char                 *structure)
 {
-  int               n, i, j, l, ij, *pscore, *jindx, ov = 0;
+  int               n, i, j, l, ij, max_d, *pscore, *jindx, ov = 0;
   FLT_OR_DBL        Qmax = 0;
   FLT_OR_DBL        *qb, *G, *probs;
   FLT_OR_DBL        *q1k, *qln;
@@ -583,6 +603,8 @@ pf_create_bppm(vrna_fold_compound_t *vc,
   circular    = md->circ;
   with_gquad  = md->gquad;
   turn        = md->min_loop_size;
+  /* banded matrices only store pairs up to a maximum span */
+  max_d       = (vc->jindx_span) ? (int)vc->jindx_span + 1 : n;
 
   hc  = vc->hc;
   sc  = vc->sc;
@@ -695,12 +717,12 @@ pf_create_bppm(vrna_fold_compound_t *vc,
 
       if (sc && sc->f && sc->bt) {
         for (i = 1; i <= n; i++)
-          for (j = i + turn + 1; j <= n; j++) {
+          for (j = i + turn + 1; j <= MIN2(n, i + max_d); j++) {
             ij = my_iindx[i] - j;
             /*  search for possible auxiliary base pairs in hairpin loop motifs to store
              *  the corresponding probability corrections
              */
-            if (hc->mx[i * n + j] & VRNA_CONSTRAINT_CONTEXT_HP_LOOP) {
+            if (vrna_hc_mx_get(hc, i, j) & VRNA_CONSTRAINT_CONTEXT_HP_LOOP) {
               vrna_basepair_t *ptr, *aux_bps;
               aux_bps = sc->bt(i, j, i, j, VRNA_DECOMP_PAIR_HP, sc->data);
               if (aux_bps) {
@@ -724,7 +746,10 @@ pf_create_bppm(vrna_fold_compound_t *vc,
          *  as augmented by the generalized soft constraints feature
          */
         for (i = 0; i < corr_cnt; i++) {
-          ij = my_iindx[bp_correction[i].i] - bp_correction[i].j;
+          ij = vrna_mx_pf_index(vc, bp_correction[i].i, bp_correction[i].j);
+          if (ij < 0)
+            continue;
+
           /* printf("correcting pair %d, %d by %f\n", bp_correction[i].i, bp_correction[i].j, bp_correction[i].p); */
           probs[ij] += bp_correction[i].p / qb[ij];
         }
@@ -732,7 +757,7 @@ pf_create_bppm(vrna_fold_compound_t *vc,
     }
 
     for (i = 1; i <= n; i++)
-      for (j = i + turn + 1; j <= n; j++) {
+      for (j = i + turn + 1; j <= MIN2(n, i + max_d); j++) {
         ij = my_iindx[i] - j;
 
         if (with_gquad) {
@@ -757,7 +782,9 @@ pf_create_bppm(vrna_fold_compound_t *vc,
       }
 
     if (structure != NULL) {
-      char *s = vrna_db_from_probs(probs, (unsigned int)n);
+      char *s = (vc->jindx_span) ?
+                db_from_probs_banded(vc) :
+                vrna_db_from_probs(probs, (unsigned int)n);
       memcpy(structure, s, n);
       structure[n] = '\0';
       free(s);
@@ -799,6 +826,9 @@ get_ml_helper_arrays(vrna_fold_compound_t *fc)
   ml_helpers->prm_l   = (FLT_OR_DBL *)vrna_alloc(sizeof(FLT_OR_DBL) * (n + 2));
   ml_helpers->prm_l1  = (FLT_OR_DBL *)vrna_alloc(sizeof(FLT_OR_DBL) * (n + 2));
   ml_helpers->prml    = (FLT_OR_DBL *)vrna_alloc(sizeof(FLT_OR_DBL) * (n + 2));
+  ml_helpers->prmt    = (FLT_OR_DBL *)vrna_alloc(sizeof(FLT_OR_DBL) * (n + 2));
+  ml_helpers->prmt1   = (FLT_OR_DBL *)vrna_alloc(sizeof(FLT_OR_DBL) * (n + 2));
+  ml_helpers->prm_MLb = (FLT_OR_DBL *)vrna_alloc(sizeof(FLT_OR_DBL) * (n + 2));
 
   ml_helpers->ud_max_size = 0;
   ml_helpers->pmlu        = NULL;
@@ -835,6 +865,9 @@ free_ml_helper_arrays(helper_arrays *ml_helpers)
   free(ml_helpers->prm_l);
   free(ml_helpers->prm_l1);
   free(ml_helpers->prml);
+  free(ml_helpers->prmt);
+  free(ml_helpers->prmt1);
+  free(ml_helpers->prm_MLb);
 
   if (ml_helpers->pmlu) {
     for (u = 0; u <= ml_helpers->ud_max_size; u++)
@@ -888,7 +921,7 @@ rotate_ml_helper_arrays_inner(helper_arrays *ml_helpers)
 PRIVATE void
 compute_bpp_external(vrna_fold_compound_t *fc)
 {
-  unsigned int      i, j, n, turn;
+  unsigned int      i, j, n, turn, max_d;
   int               circular, *my_iindx, ij;
   FLT_OR_DBL        *probs, *q1k, *qln, *qb;
   vrna_exp_param_t  *pf_params;
@@ -910,6 +943,7 @@ compute_bpp_external(vrna_fold_compound_t *fc)
   qln       = matrices->qln;
   circular  = md->circ;
   turn      = md->min_loop_size;
+  max_d     = (fc->jindx_span) ? fc->jindx_span + 1 : n;
 
   contrib_f = (fc->type == VRNA_FC_TYPE_SINGLE) ? &contrib_ext_pair : &contrib_ext_pair_comparative;
 
@@ -920,7 +954,7 @@ compute_bpp_external(vrna_fold_compound_t *fc)
     vrna_callback_hc_evaluate *evaluate = prepare_hc_default(fc, &hc_dat_local);
 
     for (i = 1; i <= n; i++) {
-      for (j = i + turn + 1; j <= n; j++) {
+      for (j = i + turn + 1; j <= MIN2(n, i + max_d); j++) {
         ij        = my_iindx[i] - j;
         probs[ij] = 0.;
 
@@ -1034,7 +1068,7 @@ compute_bpp_internal(vrna_fold_compound_t *fc,
   short             *S1;
   unsigned int      *sn;
   int               i, j, k, n, ij, kl, u1, u2, *my_iindx, *jindx, *rtype,
-                    turn, with_ud, *hc_up_int;
+                    turn, max_d, with_ud, *hc_up_int, num_threads;
   FLT_OR_DBL        temp, tmp2, *qb, *probs, *scale;
   double            max_real;
   vrna_exp_param_t  *pf_params;
@@ -1052,6 +1086,7 @@ compute_bpp_internal(vrna_fold_compound_t *fc,
   pf_params   = fc->exp_params;
   md          = &(pf_params->model_details);
   turn        = md->min_loop_size;
+  max_d       = (fc->jindx_span) ? (int)fc->jindx_span + 1 : n;
   rtype       = &(md->rtype[0]);
   hc          = fc->hc;
   sc          = fc->sc;
@@ -1065,14 +1100,26 @@ compute_bpp_internal(vrna_fold_compound_t *fc,
 
   max_real = (sizeof(FLT_OR_DBL) == sizeof(float)) ? FLT_MAX : DBL_MAX;
 
+  /*
+   *  all pairs (k,l) of this column only depend on pairs (i,j) with j > l,
+   *  so they can be processed concurrently. Collecting probability corrections
+   *  for auxiliary base pairs, however, requires sequential processing. User-
+   *  defined unstructured domain callbacks are never called concurrently
+   */
+  num_threads = (((sc) && (sc->exp_f) && (sc->bt)) || (with_ud)) ? 1 : md->num_threads;
+
   /* 2. bonding k,l as substem of 2:loop enclosed by i,j */
-  for (k = 1; k < l - turn; k++) {
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(num_threads) if (num_threads > 1) schedule(dynamic, 8) \
+  private(type, type_2, i, j, ij, kl, u1, u2, temp, tmp2)
+#endif
+  for (k = MAX2(1, l - max_d); k < l - turn; k++) {
     kl = my_iindx[k] - l;
 
     if (qb[kl] == 0.)
       continue;
 
-    if (hc->mx[l * n + k] & VRNA_CONSTRAINT_CONTEXT_INT_LOOP_ENC) {
+    if (vrna_hc_mx_get(hc, l, k) & VRNA_CONSTRAINT_CONTEXT_INT_LOOP_ENC) {
       type_2 = rtype[vrna_get_ptype(jindx[l] + k, ptype)];
 
       for (i = MAX2(1, k - MAXLOOP - 1); i <= k - 1; i++) {
@@ -1080,7 +1127,7 @@ compute_bpp_internal(vrna_fold_compound_t *fc,
         if (hc_up_int[i + 1] < u1)
           continue;
 
-        for (j = l + 1; j <= MIN2(l + MAXLOOP - k + i + 2, n); j++) {
+        for (j = l + 1; j <= MIN2(MIN2(l + MAXLOOP - k + i + 2, n), i + max_d); j++) {
           ij = my_iindx[i] - j;
 
           if (probs[ij] == 0.)
@@ -1091,7 +1138,7 @@ compute_bpp_internal(vrna_fold_compound_t *fc,
           if (hc_up_int[l + 1] < u2)
             break;
 
-          if (hc->mx[i * n + j] & VRNA_CONSTRAINT_CONTEXT_INT_LOOP) {
+          if (vrna_hc_mx_get(hc, i, j) & VRNA_CONSTRAINT_CONTEXT_INT_LOOP) {
             int jij = jindx[j] + i;
             type = vrna_get_ptype(jij, ptype);
 
@@ -1178,6 +1225,14 @@ compute_bpp_internal(vrna_fold_compound_t *fc,
         }
       }
     }
+  }
+
+  /* check for overflows */
+  for (k = MAX2(1, l - max_d); k < l - turn; k++) {
+    kl = my_iindx[k] - l;
+
+    if (qb[kl] == 0.)
+      continue;
 
     if (probs[kl] > (*Qmax)) {
       (*Qmax) = probs[kl];
@@ -1208,7 +1263,8 @@ compute_bpp_internal_comparative(vrna_fold_compound_t *fc,
 {
   short             **SS, **S5, **S3;
   unsigned int      type, *tt, s, n_seq, **a2s;
-  int               i, j, k, n, ij, kl, u1, u2, *my_iindx, *jindx, turn, *pscore;
+  int               i, j, k, n, ij, kl, u1, u2, *my_iindx, *jindx, turn, max_d, *pscore,
+                    num_threads;
   FLT_OR_DBL        temp, q_temp, *qb, *probs, *scale;
   double            max_real, kTn;
   vrna_exp_param_t  *pf_params;
@@ -1228,6 +1284,7 @@ compute_bpp_internal_comparative(vrna_fold_compound_t *fc,
   pf_params = fc->exp_params;
   md        = &(pf_params->model_details);
   turn      = md->min_loop_size;
+  max_d     = (fc->jindx_span) ? (int)fc->jindx_span + 1 : n;
   hc        = fc->hc;
   scs       = fc->scs;
 
@@ -1237,91 +1294,113 @@ compute_bpp_internal_comparative(vrna_fold_compound_t *fc,
 
   kTn       = pf_params->kT / 10.;   /* kT in cal/mol  */
   max_real  = (sizeof(FLT_OR_DBL) == sizeof(float)) ? FLT_MAX : DBL_MAX;
-  tt        = (unsigned int *)vrna_alloc(sizeof(unsigned int) * n_seq);
 
-  /* 2. bonding k,l as substem of 2:loop enclosed by i,j */
-  for (k = 1; k < l - turn; k++) {
-    kl = my_iindx[k] - l;
+  num_threads = md->num_threads;
 
-    if (qb[kl] == 0.)
-      continue;
+  /* 2. bonding k,l as substem of 2:loop enclosed by i,j */
+#ifdef _OPENMP
+#pragma omp parallel num_threads(num_threads) if (num_threads > 1) \
+  private(type, tt, s, i, j, ij, kl, u1, u2, temp, q_temp)
+#endif
+  {
+    tt = (unsigned int *)vrna_alloc(sizeof(unsigned int) * n_seq);
 
-    if (hc->mx[l * n + k] & VRNA_CONSTRAINT_CONTEXT_INT_LOOP_ENC) {
-      temp = 0.;
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic, 8)
+#endif
+    for (k = MAX2(1, l - max_d); k < l - turn; k++) {
+      kl = my_iindx[k] - l;
 
-      for (s = 0; s < n_seq; s++)
-        tt[s] = vrna_get_ptype_md(SS[s][l], SS[s][k], md);
+      if (qb[kl] == 0.)
+        continue;
 
-      for (i = MAX2(1, k - MAXLOOP - 1); i <= k - 1; i++) {
-        u1 = k - i - 1;
-        if (hc->up_int[i + 1] < u1)
-          continue;
+      if (vrna_hc_mx_get(hc, l, k) & VRNA_CONSTRAINT_CONTEXT_INT_LOOP_ENC) {
+        temp = 0.;
 
-        for (j = l + 1; j <= MIN2(l + MAXLOOP - k + i + 2, n); j++) {
-          ij = my_iindx[i] - j;
+        for (s = 0; s < n_seq; s++)
+          tt[s] = vrna_get_ptype_md(SS[s][l], SS[s][k], md);
 
-          if (probs[ij] == 0.)
+        for (i = MAX2(1, k - MAXLOOP - 1); i <= k - 1; i++) {
+          u1 = k - i - 1;
+          if (hc->up_int[i + 1] < u1)
             continue;
 
-          u2 = j - l - 1;
+          for (j = l + 1; j <= MIN2(MIN2(l + MAXLOOP - k + i + 2, n), i + max_d); j++) {
+            ij = my_iindx[i] - j;
 
-          if (hc->up_int[k + 1] < u2)
-            continue;
+            if (probs[ij] == 0.)
+              continue;
 
-          if (hc->mx[i * n + j] & VRNA_CONSTRAINT_CONTEXT_INT_LOOP) {
-            q_temp = 1.;
-
-            for (s = 0; s < n_seq; s++) {
-              int u1_loc  = a2s[s][k - 1] - a2s[s][i];
-              int u2_loc  = a2s[s][j - 1] - a2s[s][l];
-              type    = vrna_get_ptype_md(SS[s][i], SS[s][j], md);
-              q_temp  *= exp_E_IntLoop(u1_loc,
-                                       u2_loc,
-                                       type,
-                                       tt[s],
-                                       S3[s][i],
-                                       S5[s][j],
-                                       S5[s][k],
-                                       S3[s][l],
-                                       pf_params);
-            }
+            u2 = j - l - 1;
+
+            if (hc->up_int[k + 1] < u2)
+              continue;
+
+            if (vrna_hc_mx_get(hc, i, j) & VRNA_CONSTRAINT_CONTEXT_INT_LOOP) {
+              q_temp = 1.;
 
-            if (scs) {
               for (s = 0; s < n_seq; s++) {
-                if (scs[s]) {
-                  if (scs[s]->exp_energy_up)
-                    q_temp *= scs[s]->exp_energy_up[a2s[s][i + 1]][u1] *
-                              scs[s]->exp_energy_up[a2s[s][l + 1]][u2];
+                int u1_loc  = a2s[s][k - 1] - a2s[s][i];
+                int u2_loc  = a2s[s][j - 1] - a2s[s][l];
+                type    = vrna_get_ptype_md(SS[s][i], SS[s][j], md);
+                q_temp  *= exp_E_IntLoop(u1_loc,
+                                         u2_loc,
+                                         type,
+                                         tt[s],
+                                         S3[s][i],
+                                         S5[s][j],
+                                         S5[s][k],
+                                         S3[s][l],
+                                         pf_params);
+              }
 
-                  if (scs[s]->exp_energy_bp)
-                    q_temp *= scs[s]->exp_energy_bp[jindx[j] + i];
-
-                  if (scs[s]->exp_energy_stack) {
-                    if ((a2s[s][k - 1] == a2s[s][i]) && (a2s[s][j - 1] == a2s[s][l])) {
-                      q_temp *= scs[s]->exp_energy_stack[a2s[s][i]] *
-                                scs[s]->exp_energy_stack[a2s[s][j]] *
-                                scs[s]->exp_energy_stack[a2s[s][k]] *
-                                scs[s]->exp_energy_stack[a2s[s][l]];
+              if (scs) {
+                for (s = 0; s < n_seq; s++) {
+                  if (scs[s]) {
+                    if (scs[s]->exp_energy_up)
+                      q_temp *= scs[s]->exp_energy_up[a2s[s][i + 1]][u1] *
+                                scs[s]->exp_energy_up[a2s[s][l + 1]][u2];
+
+                    if (scs[s]->exp_energy_bp)
+                      q_temp *= scs[s]->exp_energy_bp[jindx[j] + i];
+
+                    if (scs[s]->exp_energy_stack) {
+                      if ((a2s[s][k - 1] == a2s[s][i]) && (a2s[s][j - 1] == a2s[s][l])) {
+                        q_temp *= scs[s]->exp_energy_stack[a2s[s][i]] *
+                                  scs[s]->exp_energy_stack[a2s[s][j]] *
+                                  scs[s]->exp_energy_stack[a2s[s][k]] *
+                                  scs[s]->exp_energy_stack[a2s[s][l]];
+                      }
                     }
-                  }
 
-                  if (scs[s]->exp_f)
-                    q_temp *= scs[s]->exp_f(i, j, k, l, VRNA_DECOMP_PAIR_IL, scs[s]->data);
+                    if (scs[s]->exp_f)
+                      q_temp *= scs[s]->exp_f(i, j, k, l, VRNA_DECOMP_PAIR_IL, scs[s]->data);
+                  }
                 }
               }
-            }
 
-            temp += probs[ij] *
-                    q_temp *
-                    scale[u1 + u2 + 2];
+              temp += probs[ij] *
+                      q_temp *
+                      scale[u1 + u2 + 2];
+            }
           }
         }
-      }
 
-      probs[kl] += temp *
-                   exp(pscore[jindx[l] + k] / kTn);
+        probs[kl] += temp *
+                     exp(pscore[jindx[l] + k] / kTn);
+      }
     }
 
+    free(tt);
+  }
+
+  /* check for overflows */
+  for (k = MAX2(1, l - max_d); k < l - turn; k++) {
+    kl = my_iindx[k] - l;
+
+    if (qb[kl] == 0.)
+      continue;
+
     if (probs[kl] > (*Qmax)) {
       (*Qmax) = probs[kl];
       if ((*Qmax) > max_real / 10.)
@@ -1335,8 +1414,6 @@ compute_bpp_internal_comparative(vrna_fold_compound_t *fc,
     }
   }
 
-  free(tt);
-
   if (md->gquad)
     compute_gquad_prob_internal_comparative(fc, l);
 }
@@ -1353,8 +1430,8 @@ compute_bpp_multibranch(vrna_fold_compound_t  *fc,
   char              *ptype;
   short             *S, *S1, s5, s3;
   unsigned int      *sn;
-  int               cnt, i, j, k, n, u, ii, ij, kl, lj, turn, *my_iindx, *jindx,
-                    *rtype, with_gquad, with_ud;
+  int               cnt, i, j, k, n, u, ij, kl, lj, turn, max_d, *my_iindx, *jindx,
+                    *rtype, with_gquad, with_ud, num_threads;
   FLT_OR_DBL        temp, ppp, prm_MLb, prmt, prmt1, *qb, *probs, *qm, *G, *scale,
                     *expMLbase, expMLclosing, expMLstem;
   double            max_real;
@@ -1373,6 +1450,11 @@ compute_bpp_multibranch(vrna_fold_compound_t  *fc,
   pf_params     = fc->exp_params;
   md            = &(pf_params->model_details);
   turn          = md->min_loop_size;
+  /*
+   *  for banded matrices, the helper arrays are only updated for the pairs
+   *  (i, j) with j > l within the band, the remaining entries are still 0
+   */
+  max_d         = (fc->jindx_span) ? (int)fc->jindx_span + 1 : n;
   rtype         = &(md->rtype[0]);
   ptype         = fc->ptype;
   qb            = fc->exp_matrices->qb;
@@ -1388,6 +1470,8 @@ compute_bpp_multibranch(vrna_fold_compound_t  *fc,
   with_ud       = (domains_up && domains_up->exp_energy_cb) ? 1 : 0;
   with_gquad    = md->gquad;
   expMLstem     = (with_gquad) ? exp_E_MLstem(0, -1, -1, pf_params) : 0;
+  /* user-defined unstructured domain callbacks are never called concurrently */
+  num_threads   = (with_ud) ? 1 : md->num_threads;
 
   prm_MLb   = 0.;
   max_real  = (sizeof(FLT_OR_DBL) == sizeof(float)) ? FLT_MAX : DBL_MAX;
@@ -1397,8 +1481,19 @@ compute_bpp_multibranch(vrna_fold_compound_t  *fc,
     for (i = 0; i <= n; i++)
       ml_helpers->prm_l[i] = 0;
   } else {
-    for (k = 2; k < l - turn; k++) {
-      kl    = my_iindx[k] - l;
+    /*
+     *  The computations for this column are split into three parts:
+     *  (i)   the contributions of all enclosing pairs (i, j) with i = k - 1,
+     *  (ii)  the linear recursions for prm_l, prml and prm_MLb along k, and
+     *  (iii) the contributions where (k, l) is not the left-most stem.
+     *  Parts (i) and (iii) are independent for different k and may be
+     *  computed concurrently, each sum in the same order as before
+     */
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(num_threads) if (num_threads > 1) schedule(dynamic, 8) \
+  private(i, j, ij, lj, s3, tt, ppp, prmt, prmt1)
+#endif
+    for (k = MAX2(2, l - max_d); k < l - turn; k++) {
       i     = k - 1;
       prmt  = prmt1 = 0.0;
 
@@ -1406,8 +1501,8 @@ compute_bpp_multibranch(vrna_fold_compound_t  *fc,
       lj  = my_iindx[l + 1] - (l + 1);
       s3  = S1[i + 1];
       if (sn[k] == sn[i]) {
-        for (j = l + 2; j <= n; j++, ij--, lj--) {
-          if ((hc->mx[i * n + j] & VRNA_CONSTRAINT_CONTEXT_MB_LOOP) &&
+        for (j = l + 2; j <= MIN2(n, i + max_d); j++, ij--, lj--) {
+          if ((vrna_hc_mx_get(hc, i, j) & VRNA_CONSTRAINT_CONTEXT_MB_LOOP) &&
               (sn[j] == sn[j - 1])) {
             tt = vrna_get_ptype_md(S[j], S[i], md);
 
@@ -1436,11 +1531,10 @@ compute_bpp_multibranch(vrna_fold_compound_t  *fc,
           }
         }
 
-        ii  = my_iindx[i];  /* ii-j=[i,j]     */
-        tt  = vrna_get_ptype(jindx[l + 1] + i, ptype);
-        tt  = rtype[tt];
-        if (hc->mx[(l + 1) * n + i] & VRNA_CONSTRAINT_CONTEXT_MB_LOOP) {
-          prmt1 = probs[ii - (l + 1)]
+        if (vrna_hc_mx_get(hc, l + 1, i) & VRNA_CONSTRAINT_CONTEXT_MB_LOOP) {
+          tt    = vrna_get_ptype(jindx[l + 1] + i, ptype);
+          tt    = rtype[tt];
+          prmt1 = probs[my_iindx[i] - (l + 1)]
                   *expMLclosing
                   *exp_E_MLstem(tt,
                                 S1[l],
@@ -1461,9 +1555,16 @@ compute_bpp_multibranch(vrna_fold_compound_t  *fc,
         }
       }
 
-      prmt *= expMLclosing;
+      ml_helpers->prmt[i]   = prmt * expMLclosing;
+      ml_helpers->prmt1[i]  = prmt1;
+    }
+
+    for (k = MAX2(2, l - max_d); k < l - turn; k++) {
+      kl    = my_iindx[k] - l;
+      i     = k - 1;
+      prmt1 = ml_helpers->prmt1[i];
 
-      ml_helpers->prml[i] = prmt;
+      ml_helpers->prml[i] = ml_helpers->prmt[i];
 
       /* l+1 is unpaired */
       if (hc->up_ml[l + 1]) {
@@ -1558,7 +1659,8 @@ compute_bpp_multibranch(vrna_fold_compound_t  *fc,
           ml_helpers->prm_MLbu[0] = ml_helpers->prml[i];
       }
 
-      ml_helpers->prml[i] = ml_helpers->prml[i] + ml_helpers->prm_l[i];
+      ml_helpers->prml[i]   = ml_helpers->prml[i] + ml_helpers->prm_l[i];
+      ml_helpers->prm_MLb[k] = prm_MLb;
 
       tt = ptype[jindx[l] + k];
 
@@ -1570,11 +1672,31 @@ compute_bpp_multibranch(vrna_fold_compound_t  *fc,
           continue;
       }
 
-      if (hc->mx[l * n + k] & VRNA_CONSTRAINT_CONTEXT_MB_LOOP_ENC) {
-        temp = prm_MLb;
+      /* rotate prm_MLbu entries required for unstructured domain feature */
+      rotate_ml_helper_arrays_inner(ml_helpers);
+    } /* end for (k=..) */
+
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(num_threads) if (num_threads > 1) schedule(dynamic, 8) \
+  private(i, kl, s5, s3, tt, temp)
+#endif
+    for (k = MAX2(2, l - max_d); k < l - turn; k++) {
+      kl  = my_iindx[k] - l;
+      tt  = ptype[jindx[l] + k];
+
+      if (with_gquad) {
+        if ((!tt) && (G[kl] == 0.))
+          continue;
+      } else {
+        if (qb[kl] == 0.)
+          continue;
+      }
+
+      if (vrna_hc_mx_get(hc, l, k) & VRNA_CONSTRAINT_CONTEXT_MB_LOOP_ENC) {
+        temp = ml_helpers->prm_MLb[k];
 
         if (sn[k] == sn[k - 1]) {
-          for (i = 1; i <= k - 2; i++)
+          for (i = MAX2(1, l - max_d - 1); i <= k - 2; i++)
             if (sn[i + 1] == sn[i])
               temp += ml_helpers->prml[i] *
                       qm[my_iindx[i + 1] - (k - 1)];
@@ -1601,6 +1723,20 @@ compute_bpp_multibranch(vrna_fold_compound_t  *fc,
 
         probs[kl] += temp;
       }
+    }
+
+    /* check for overflows */
+    for (k = MAX2(2, l - max_d); k < l - turn; k++) {
+      kl  = my_iindx[k] - l;
+      tt  = ptype[jindx[l] + k];
+
+      if (with_gquad) {
+        if ((!tt) && (G[kl] == 0.))
+          continue;
+      } else {
+        if (qb[kl] == 0.)
+          continue;
+      }
 
       if (probs[kl] > (*Qmax)) {
         (*Qmax) = probs[kl];
@@ -1613,10 +1749,7 @@ compute_bpp_multibranch(vrna_fold_compound_t  *fc,
         (*ov)++;
         probs[kl] = FLT_MAX;
       }
-
-      /* rotate prm_MLbu entries required for unstructured domain feature */
-      rotate_ml_helper_arrays_inner(ml_helpers);
-    } /* end for (k=..) */
+    }
   }
 
   rotate_ml_helper_arrays_outer(ml_helpers);
@@ -1633,7 +1766,8 @@ compute_bpp_multibranch_comparative(vrna_fold_compound_t  *fc,
   unsigned char     tt;
   short             **S, **S5, **S3;
   unsigned int      **a2s, s, n_seq;
-  int               i, j, k, n, ii, kl, ll, turn, *my_iindx, *jindx, *pscore, with_gquad;
+  int               i, j, k, n, ii, kl, ll, turn, max_d, *my_iindx, *jindx, *pscore, with_gquad,
+                    num_threads;
   FLT_OR_DBL        temp, pp, prm_MLb, prmt, prmt1, *qb, *probs, *qm, *G, *scale,
                     *expMLbase, expMLclosing, expMLstem;
   double            max_real, kTn;
@@ -1654,6 +1788,7 @@ compute_bpp_multibranch_comparative(vrna_fold_compound_t  *fc,
   pf_params     = fc->exp_params;
   md            = &(pf_params->model_details);
   turn          = md->min_loop_size;
+  max_d         = (fc->jindx_span) ? (int)fc->jindx_span + 1 : n;
   qb            = fc->exp_matrices->qb;
   qm            = fc->exp_matrices->qm;
   G             = fc->exp_matrices->G;
@@ -1665,6 +1800,7 @@ compute_bpp_multibranch_comparative(vrna_fold_compound_t  *fc,
   hc            = fc->hc;
   scs           = fc->scs;
   expMLstem     = (with_gquad) ? (FLT_OR_DBL)pow(exp_E_MLstem(0, -1, -1, pf_params), (double)n_seq) : 0;
+  num_threads   = md->num_threads;
 
   prm_MLb   = 0.;
   max_real  = (sizeof(FLT_OR_DBL) == sizeof(float)) ? FLT_MAX : DBL_MAX;
@@ -1674,116 +1810,160 @@ compute_bpp_multibranch_comparative(vrna_fold_compound_t  *fc,
   /* 3. bonding k,l as substem of multi-loop enclosed by i,j */
   prm_MLb = 0.;
 
-  for (k = 2; k < l - turn; k++) {
+  /*
+   *  contributions of all enclosing pairs (k - 1, j) are independent
+   *  for different k, see compute_bpp_multibranch()
+   */
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(num_threads) if (num_threads > 1) schedule(dynamic, 8) \
+  private(i, j, s, ii, ll, tt, pp, prmt, prmt1)
+#endif
+  for (k = MAX2(2, l - max_d); k < l - turn; k++) {
     i     = k - 1;
     prmt  = prmt1 = 0.;
 
-    if (1 /* hard_constraints[l * n + k] & VRNA_CONSTRAINT_CONTEXT_MB_LOOP_ENC */) {
-      ii  = my_iindx[i];      /* ii-j=[i,j]     */
-      ll  = my_iindx[l + 1];  /* ll-j=[l+1,j-1] */
-      if (hc->mx[(l + 1) * n + i] & VRNA_CONSTRAINT_CONTEXT_MB_LOOP) {
-        prmt1 = probs[ii - (l + 1)];
-        for (s = 0; s < n_seq; s++) {
-          tt    = vrna_get_ptype_md(S[s][l + 1], S[s][i], md);
-          prmt1 *= exp_E_MLstem(tt, S5[s][l + 1], S3[s][i], pf_params) * expMLclosing;
-        }
+    ii  = my_iindx[i];      /* ii-j=[i,j]     */
+    ll  = my_iindx[l + 1];  /* ll-j=[l+1,j-1] */
+    if (vrna_hc_mx_get(hc, l + 1, i) & VRNA_CONSTRAINT_CONTEXT_MB_LOOP) {
+      prmt1 = probs[ii - (l + 1)];
+      for (s = 0; s < n_seq; s++) {
+        tt    = vrna_get_ptype_md(S[s][l + 1], S[s][i], md);
+        prmt1 *= exp_E_MLstem(tt, S5[s][l + 1], S3[s][i], pf_params) * expMLclosing;
+      }
 
-        if (scs) {
-          for (s = 0; s < n_seq; s++) {
-            if (scs[s])
-              if (scs[s]->exp_energy_bp)
-                prmt1 *= scs[s]->exp_energy_bp[jindx[l + 1] + i];
-          }
+      if (scs) {
+        for (s = 0; s < n_seq; s++) {
+          if (scs[s])
+            if (scs[s]->exp_energy_bp)
+              prmt1 *= scs[s]->exp_energy_bp[jindx[l + 1] + i];
         }
       }
+    }
 
-      for (j = l + 2; j <= n; j++) {
-        pp = 1.;
-        if (probs[ii - j] == 0)
-          continue;
+    for (j = l + 2; j <= MIN2(n, i + max_d); j++) {
+      pp = 1.;
+      if (probs[ii - j] == 0)
+        continue;
 
-        if (!(hc->mx[i * n + j] & VRNA_CONSTRAINT_CONTEXT_MB_LOOP))
-          continue;
+      if (!(vrna_hc_mx_get(hc, i, j) & VRNA_CONSTRAINT_CONTEXT_MB_LOOP))
+        continue;
+
+      for (s = 0; s < n_seq; s++) {
+        tt  = vrna_get_ptype_md(S[s][j], S[s][i], md);
+        pp  *= exp_E_MLstem(tt, S5[s][j], S3[s][i], pf_params) * expMLclosing;
+      }
 
+      if (scs) {
         for (s = 0; s < n_seq; s++) {
-          tt  = vrna_get_ptype_md(S[s][j], S[s][i], md);
-          pp  *= exp_E_MLstem(tt, S5[s][j], S3[s][i], pf_params) * expMLclosing;
+          if (scs[s])
+            if (scs[s]->exp_energy_bp)
+              pp *= scs[s]->exp_energy_bp[jindx[j] + i];
         }
+      }
 
-        if (scs) {
-          for (s = 0; s < n_seq; s++) {
-            if (scs[s])
-              if (scs[s]->exp_energy_bp)
-                pp *= scs[s]->exp_energy_bp[jindx[j] + i];
-          }
-        }
+      prmt += probs[ii - j] * pp * qm[ll - (j - 1)];
+    }
 
-        prmt += probs[ii - j] * pp * qm[ll - (j - 1)];
-      }
-      kl = my_iindx[k] - l;
+    ml_helpers->prmt[i]   = prmt;
+    ml_helpers->prmt1[i]  = prmt1;
+  }
 
-      ml_helpers->prml[i] = prmt;
+  for (k = MAX2(2, l - max_d); k < l - turn; k++) {
+    i     = k - 1;
+    prmt1 = ml_helpers->prmt1[i];
+    kl    = my_iindx[k] - l;
 
-      pp = 0.;
-      if (hc->up_ml[l + 1]) {
-        pp = ml_helpers->prm_l1[i] * expMLbase[1];
-        if (scs) {
-          for (s = 0; s < n_seq; s++) {
-            if (scs[s])
-              if (scs[s]->exp_energy_up)
-                pp *= scs[s]->exp_energy_up[a2s[s][l + 1]][1];
-          }
+    ml_helpers->prml[i] = ml_helpers->prmt[i];
+
+    pp = 0.;
+    if (hc->up_ml[l + 1]) {
+      pp = ml_helpers->prm_l1[i] * expMLbase[1];
+      if (scs) {
+        for (s = 0; s < n_seq; s++) {
+          if (scs[s])
+            if (scs[s]->exp_energy_up)
+              pp *= scs[s]->exp_energy_up[a2s[s][l + 1]][1];
         }
       }
+    }
 
-      ml_helpers->prm_l[i] = pp + prmt1; /* expMLbase[1]^n_seq */
+    ml_helpers->prm_l[i] = pp + prmt1; /* expMLbase[1]^n_seq */
 
-      pp = 0.;
-      if (hc->up_ml[i]) {
-        pp = prm_MLb * expMLbase[1];
-        if (scs) {
-          for (s = 0; s < n_seq; s++) {
-            if (scs[s])
-              if (scs[s]->exp_energy_up)
-                pp *= scs[s]->exp_energy_up[a2s[s][i]][1];
-          }
+    pp = 0.;
+    if (hc->up_ml[i]) {
+      pp = prm_MLb * expMLbase[1];
+      if (scs) {
+        for (s = 0; s < n_seq; s++) {
+          if (scs[s])
+            if (scs[s]->exp_energy_up)
+              pp *= scs[s]->exp_energy_up[a2s[s][i]][1];
         }
       }
+    }
 
-      prm_MLb = pp + ml_helpers->prml[i];
+    prm_MLb = pp + ml_helpers->prml[i];
 
-      /* same as:    prm_MLb = 0;
-       * for (i=1; i<=k-1; i++) prm_MLb += prml[i]*expMLbase[k-i-1]; */
+    /* same as:    prm_MLb = 0;
+     * for (i=1; i<=k-1; i++) prm_MLb += prml[i]*expMLbase[k-i-1]; */
 
-      ml_helpers->prml[i] = ml_helpers->prml[i] + ml_helpers->prm_l[i];
+    ml_helpers->prml[i]     = ml_helpers->prml[i] + ml_helpers->prm_l[i];
+    ml_helpers->prm_MLb[k]  = prm_MLb;
 
-      if (with_gquad) {
-        if ((qb[kl] == 0.) && (G[kl] == 0.))
-          continue;
-      } else {
-        if (qb[kl] == 0.)
-          continue;
-      }
+    if (with_gquad) {
+      if ((qb[kl] == 0.) && (G[kl] == 0.))
+        continue;
+    } else {
+      if (qb[kl] == 0.)
+        continue;
+    }
+
+    /* rotate prm_MLbu entries required for unstructured domain feature */
+    rotate_ml_helper_arrays_inner(ml_helpers);
+  } /* end for (k=2..) */
+
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(num_threads) if (num_threads > 1) schedule(dynamic, 8) \
+  private(i, s, kl, tt, temp)
+#endif
+  for (k = MAX2(2, l - max_d); k < l - turn; k++) {
+    kl = my_iindx[k] - l;
 
-      temp = prm_MLb;
+    if (with_gquad) {
+      if ((qb[kl] == 0.) && (G[kl] == 0.))
+        continue;
+    } else {
+      if (qb[kl] == 0.)
+        continue;
+    }
 
-      for (i = 1; i <= k - 2; i++)
-        temp += ml_helpers->prml[i] * qm[my_iindx[i + 1] - (k - 1)];
+    temp = ml_helpers->prm_MLb[k];
 
-      if ((with_gquad) && (qb[kl] == 0.)) {
-        temp *= G[kl] *
-                expMLstem;
-      } else {
-        for (s = 0; s < n_seq; s++) {
-          tt    = vrna_get_ptype_md(S[s][k], S[s][l], md);
-          temp  *= exp_E_MLstem(tt, S5[s][k], S3[s][l], pf_params);
-        }
+    for (i = MAX2(1, l - max_d - 1); i <= k - 2; i++)
+      temp += ml_helpers->prml[i] * qm[my_iindx[i + 1] - (k - 1)];
+
+    if ((with_gquad) && (qb[kl] == 0.)) {
+      temp *= G[kl] *
+              expMLstem;
+    } else {
+      for (s = 0; s < n_seq; s++) {
+        tt    = vrna_get_ptype_md(S[s][k], S[s][l], md);
+        temp  *= exp_E_MLstem(tt, S5[s][k], S3[s][l], pf_params);
       }
+    }
+
+    probs[kl] += temp * scale[2] * exp(pscore[jindx[l] + k] / kTn);
+  }
 
-      probs[kl] += temp * scale[2] * exp(pscore[jindx[l] + k] / kTn);
+  /* check for overflows */
+  for (k = MAX2(2, l - max_d); k < l - turn; k++) {
+    kl = my_iindx[k] - l;
+
+    if (with_gquad) {
+      if ((qb[kl] == 0.) && (G[kl] == 0.))
+        continue;
     } else {
-      /* (k,l) not allowed to be substem of multiloop closed by (i,j) */
-      ml_helpers->prml[i] = ml_helpers->prm_l[i] = ml_helpers->prm_l1[i] = 0.;
+      if (qb[kl] == 0.)
+        continue;
     }
 
     if (probs[kl] > (*Qmax)) {
@@ -1797,10 +1977,7 @@ compute_bpp_multibranch_comparative(vrna_fold_compound_t  *fc,
       (*ov)++;
       probs[kl] = FLT_MAX;
     }
-
-    /* rotate prm_MLbu entries required for unstructured domain feature */
-    rotate_ml_helper_arrays_inner(ml_helpers);
-  } /* end for (k=2..) */
+  }
 
   rotate_ml_helper_arrays_outer(ml_helpers);
 }
@@ -2336,13 +2513,12 @@ ud_outside_ext_loops(vrna_fold_compound_t *vc)
 PRIVATE INLINE void
 ud_outside_hp_loops(vrna_fold_compound_t *vc)
 {
-  int         i, j, k, l, kl, *my_iindx, u, n, cnt, *motif_list, *hc_up;
+  int         i, j, k, l, kl, u, n, cnt, *motif_list, *hc_up;
   FLT_OR_DBL  temp, outside, exp_motif_en, *probs, q1, q2;
 
   vrna_ud_t   *domains_up, *ud_bak;
 
   n           = vc->length;
-  my_iindx    = vc->iindx;
   probs       = vc->exp_matrices->probs;
   hc_up       = vc->hc->up_hp;
   domains_up  = vc->domains_up;
@@ -2370,8 +2546,8 @@ ud_outside_hp_loops(vrna_fold_compound_t *vc)
              */
             for (k = 1; k < i; k++)
               for (l = j + 1; l <= n; l++) {
-                kl = my_iindx[k] - l;
-                if (probs[kl] > 0.) {
+                kl = vrna_mx_pf_index(vc, k, l);
+                if ((kl >= 0) && (probs[kl] > 0.)) {
                   ud_bak          = vc->domains_up;
                   vc->domains_up  = NULL;
                   temp            = vrna_exp_E_hp_loop(vc, k, l);
@@ -2517,14 +2693,13 @@ ud_outside_hp_loops2(vrna_fold_compound_t *vc)
 PRIVATE INLINE void
 ud_outside_int_loops(vrna_fold_compound_t *vc)
 {
-  int         i, j, k, l, p, q, pq, kl, u, n, cnt, *motif_list, *my_iindx,
+  int         i, j, k, l, p, q, pq, kl, u, n, cnt, *motif_list,
               *hc_up, kmin, pmax, qmin, lmax, turn;
   FLT_OR_DBL  temp, q1, q2, q3, exp_motif_en, outside,
               *probs, *qb;
   vrna_ud_t   *domains_up, *ud_bak;
 
   n           = vc->length;
-  my_iindx    = vc->iindx;
   qb          = vc->exp_matrices->qb;
   probs       = vc->exp_matrices->probs;
   hc_up       = vc->hc->up_int;
@@ -2557,15 +2732,15 @@ ud_outside_int_loops(vrna_fold_compound_t *vc)
               pmax  = MIN2(pmax, n);
               for (p = j + 1; p < n; p++)
                 for (q = p + turn + 1; q < n; q++) {
-                  pq = my_iindx[p] - q;
-                  if (qb[pq] == 0)
+                  pq = vrna_mx_pf_index(vc, p, q);
+                  if ((pq < 0) || (qb[pq] == 0))
                     continue;
 
                   lmax  = k + MAXLOOP + q - p + 2;
                   lmax  = MIN2(lmax, n);
                   for (l = q + 1; l <= lmax; l++) {
-                    kl = my_iindx[k] - l;
-                    if (probs[kl] > 0.) {
+                    kl = vrna_mx_pf_index(vc, k, l);
+                    if ((kl >= 0) && (probs[kl] > 0.)) {
                       ud_bak          = vc->domains_up;
                       vc->domains_up  = NULL;
                       temp            = vrna_exp_E_interior_loop(vc, k, l, p, q);
@@ -2617,15 +2792,15 @@ ud_outside_int_loops(vrna_fold_compound_t *vc)
                 qmin  = p + j - k - MAXLOOP - 1;
                 qmin  = MAX2(qmin, p + turn + 1);
                 for (q = i - 1; q >= qmin; q--) {
-                  pq = my_iindx[p] - q;
-                  if (qb[pq] == 0.)
+                  pq = vrna_mx_pf_index(vc, p, q);
+                  if ((pq < 0) || (qb[pq] == 0.))
                     continue;
 
                   lmax  = k + q - p + MAXLOOP + 2;
                   lmax  = MIN2(lmax, n);
                   for (l = j + 1; l < lmax; l++) {
-                    kl = my_iindx[k] - l;
-                    if (probs[kl] > 0.) {
+                    kl = vrna_mx_pf_index(vc, k, l);
+                    if ((kl >= 0) && (probs[kl] > 0.)) {
                       ud_bak          = vc->domains_up;
                       vc->domains_up  = NULL;
                       temp            = vrna_exp_E_interior_loop(vc, k, l, p, q);
@@ -2695,19 +2870,19 @@ ud_outside_int_loops(vrna_fold_compound_t *vc)
 PRIVATE INLINE void
 ud_outside_int_loops2(vrna_fold_compound_t *vc)
 {
-  unsigned char *hard_constraints;
   int           i, j, k, l, p, q, pq, kl, u, n, *my_iindx, pmax, qmin, turn,
                 u1, u2, uu1, uu2, u2_max, m;
   FLT_OR_DBL    temp, q5, q3, exp_motif_en, outside,
                 *probs, *qb, qq1, qq2, *qqk, *qql, *qqp, **qq_ud, **pp_ud, temp5,
                 temp3;
+  vrna_hc_t     *hc;
   vrna_ud_t     *domains_up, *ud_bak;
 
   n                 = vc->length;
   my_iindx          = vc->iindx;
   qb                = vc->exp_matrices->qb;
   probs             = vc->exp_matrices->probs;
-  hard_constraints  = vc->hc->mx;
+  hc                = vc->hc;
   domains_up        = vc->domains_up;
   turn              = vc->exp_params->model_details.min_loop_size;
 
@@ -2744,7 +2919,7 @@ ud_outside_int_loops2(vrna_fold_compound_t *vc)
       if (probs[kl] == 0.)
         continue;
 
-      if (hard_constraints[k * n + l] & VRNA_CONSTRAINT_CONTEXT_INT_LOOP) {
+      if (vrna_hc_mx_get(hc, k, l) & VRNA_CONSTRAINT_CONTEXT_INT_LOOP) {
         for (i = l - 1; i > MAX2(k, l - MAXLOOP - 1); i--) {
           qql[i] = domains_up->exp_energy_cb(vc,
                                              i, l - 1,
@@ -2773,7 +2948,7 @@ ud_outside_int_loops2(vrna_fold_compound_t *vc)
           for (q = qmin; q < l; q++) {
             pq = my_iindx[p] - q;
 
-            if (hard_constraints[p * n + q] & VRNA_CONSTRAINT_CONTEXT_INT_LOOP_ENC) {
+            if (vrna_hc_mx_get(hc, p, q) & VRNA_CONSTRAINT_CONTEXT_INT_LOOP_ENC) {
               u2              = l - q - 1;
               ud_bak          = vc->domains_up;
               vc->domains_up  = NULL;
@@ -2862,7 +3037,6 @@ ud_outside_int_loops2(vrna_fold_compound_t *vc)
 PRIVATE INLINE void
 ud_outside_mb_loops(vrna_fold_compound_t *vc)
 {
-  unsigned char     *hc;
   char              *ptype;
   short             *S;
   int               i, j, k, l, kl, jkl, *my_iindx, u, n, cnt, *motif_list,
@@ -2871,6 +3045,7 @@ ud_outside_mb_loops(vrna_fold_compound_t *vc)
                     *expMLbase, *qmli, exp_motif_ml_left, exp_motif_ml_right;
   vrna_exp_param_t  *pf_params;
   vrna_md_t         *md;
+  vrna_hc_t         *hc;
   vrna_sc_t         *sc;
   vrna_ud_t         *domains_up;
 
@@ -2886,7 +3061,7 @@ ud_outside_mb_loops(vrna_fold_compound_t *vc)
   probs         = vc->exp_matrices->probs;
   scale         = vc->exp_matrices->scale;
   hc_up         = vc->hc->up_ml;
-  hc            = vc->hc->matrix;
+  hc            = vc->hc;
   domains_up    = vc->domains_up;
   sc            = vc->sc;
   turn          = md->min_loop_size;
@@ -2926,16 +3101,16 @@ ud_outside_mb_loops(vrna_fold_compound_t *vc)
             /* 4.1 Motif [i:j] is somewhere in between branching stems */
             for (l = j + turn + 1; l <= n; l++) {
               for (k = i - turn - 1; k > 0; k--) {
-                kl = my_iindx[k] - l;
-                if (probs[kl] > 0.) {
+                kl = vrna_mx_pf_index(vc, k, l);
+                if ((kl >= 0) && (probs[kl] > 0.)) {
                   jkl = jindx[l] + k;
-                  if (hc[jkl] & VRNA_CONSTRAINT_CONTEXT_MB_LOOP) {
+                  if (vrna_hc_mx_get(hc, l, k) & VRNA_CONSTRAINT_CONTEXT_MB_LOOP) {
                     /* respect hard constraints */
                     FLT_OR_DBL qqq;
                     tt  = rtype[vrna_get_ptype(jkl, ptype)];
                     qqq = probs[kl]
-                          * qm[my_iindx[k + 1] - (i - 1)]
-                          * qm[my_iindx[j + 1] - (l - 1)]
+                          * vrna_mx_pf_get(vc, qm, k + 1, i - 1)
+                          * vrna_mx_pf_get(vc, qm, j + 1, l - 1)
                           * exp_E_MLstem(tt, S[l - 1], S[k + 1], pf_params)
                           * expMLclosing
                           * scale[2];
@@ -2967,7 +3142,7 @@ ud_outside_mb_loops(vrna_fold_compound_t *vc)
               for (k = i - 1; k > 0; k--) {
                 up  = i - k - 1;
                 kl  = my_iindx[k] - l;
-                if ((hc[jindx[l] + k] & VRNA_CONSTRAINT_CONTEXT_MB_LOOP) && (probs[kl] > 0.) &&
+                if ((vrna_hc_mx_get(hc, l, k) & VRNA_CONSTRAINT_CONTEXT_MB_LOOP) && (probs[kl] > 0.) &&
                     (hc_up[k + 1] >= up)) {
                   int jkl = jindx[l] + k;
                   tt    = rtype[vrna_get_ptype(jkl, ptype)];
@@ -3026,15 +3201,15 @@ ud_outside_mb_loops(vrna_fold_compound_t *vc)
                 }
 
                 /* 3rd, l - 1 pairs with u */
-                if (hc[jindx[l - 1] + u] & VRNA_CONSTRAINT_CONTEXT_MB_LOOP_ENC) {
+                if (vrna_hc_mx_get(hc, l - 1, u) & VRNA_CONSTRAINT_CONTEXT_MB_LOOP_ENC) {
                   tt    = vrna_get_ptype(jindx[l - 1] + u, ptype);
-                  temp  = qb[my_iindx[u] - (l - 1)]
+                  temp  = vrna_mx_pf_get(vc, qb, u, l - 1)
                           * exp_E_MLstem(tt, S[u - 1], S[l], pf_params);
 
                   qm1ui[0][u] += temp;
                 }
 
-                rqq += qm[my_iindx[j + 1] - (u - 1)] * qm1ui[0][u];
+                rqq += vrna_mx_pf_get(vc, qm, j + 1, u - 1) * qm1ui[0][u];
               }
 
               /* finally, compose contribution */
@@ -3065,10 +3240,10 @@ ud_outside_mb_loops(vrna_fold_compound_t *vc)
               /* update qmli[k] = qm1[k,i-1] */
               for (qmli[k] = 0., u = k + turn + 1; u < i; u++) {
                 /* respect hard constraints */
-                if (hc[jindx[u] + k] & VRNA_CONSTRAINT_CONTEXT_MB_LOOP_ENC) {
+                if (vrna_hc_mx_get(hc, u, k) & VRNA_CONSTRAINT_CONTEXT_MB_LOOP_ENC) {
                   up = (i - 1) - (u + 1) + 1;
                   if (hc_up[u + 1] >= up) {
-                    temp = qb[my_iindx[k] - u]
+                    temp = vrna_mx_pf_get(vc, qb, k, u)
                            * expMLbase[up];
 
                     /* add soft constraints */
@@ -3089,12 +3264,12 @@ ud_outside_mb_loops(vrna_fold_compound_t *vc)
               }
 
               for (u = k + turn; u < i - turn; u++)
-                lqq += qm[my_iindx[k + 1] - (u - 1)]
+                lqq += vrna_mx_pf_get(vc, qm, k + 1, u - 1)
                        * qmli[u];
 
               for (l = j + 1; l <= n; l++) {
-                kl = my_iindx[k] - l;
-                if (hc[jindx[l] + k] & VRNA_CONSTRAINT_CONTEXT_MB_LOOP) {
+                kl = vrna_mx_pf_index(vc, k, l);
+                if (vrna_hc_mx_get(hc, l, k) & VRNA_CONSTRAINT_CONTEXT_MB_LOOP) {
                   int up, jkl;
                   jkl = jindx[l] + k;
                   tt  = rtype[vrna_get_ptype(jkl, ptype)];
@@ -3155,7 +3330,6 @@ ud_outside_mb_loops(vrna_fold_compound_t *vc)
 PRIVATE INLINE void
 ud_outside_mb_loops2(vrna_fold_compound_t *vc)
 {
-  unsigned char     *hc;
   char              *ptype;
   short             *S;
   int               i, j, k, l, kl, jkl, *my_iindx, u, n, cnt, *motif_list,
@@ -3165,6 +3339,7 @@ ud_outside_mb_loops2(vrna_fold_compound_t *vc)
                     exp_motif_ml_right, *qqi, *qqj, *qqmi, *qqmj;
   vrna_exp_param_t  *pf_params;
   vrna_md_t         *md;
+  vrna_hc_t         *hc;
   vrna_sc_t         *sc;
   vrna_ud_t         *domains_up;
 
@@ -3180,7 +3355,7 @@ ud_outside_mb_loops2(vrna_fold_compound_t *vc)
   probs         = vc->exp_matrices->probs;
   scale         = vc->exp_matrices->scale;
   hc_up         = vc->hc->up_ml;
-  hc            = vc->hc->matrix;
+  hc            = vc->hc;
   domains_up    = vc->domains_up;
   sc            = vc->sc;
   turn          = md->min_loop_size;
@@ -3241,7 +3416,7 @@ ud_outside_mb_loops2(vrna_fold_compound_t *vc)
                 kl = my_iindx[k] - l;
                 if (probs[kl] > 0.) {
                   jkl = jindx[l] + k;
-                  if (hc[l * n + k] & VRNA_CONSTRAINT_CONTEXT_MB_LOOP) {
+                  if (vrna_hc_mx_get(hc, l, k) & VRNA_CONSTRAINT_CONTEXT_MB_LOOP) {
                     /* respect hard constraints */
                     FLT_OR_DBL qqq;
                     tt  = rtype[vrna_get_ptype(jkl, ptype)];
@@ -3279,7 +3454,7 @@ ud_outside_mb_loops2(vrna_fold_compound_t *vc)
               for (k = i - 1; k > 0; k--) {
                 up  = i - k - 1;
                 kl  = my_iindx[k] - l;
-                if ((hc[l * n + k] & VRNA_CONSTRAINT_CONTEXT_MB_LOOP) && (probs[kl] > 0.) &&
+                if ((vrna_hc_mx_get(hc, l, k) & VRNA_CONSTRAINT_CONTEXT_MB_LOOP) && (probs[kl] > 0.) &&
                     (hc_up[k + 1] >= up)) {
                   int jkl = jindx[l] + k;
                   tt    = rtype[vrna_get_ptype(jkl, ptype)];
@@ -3336,7 +3511,7 @@ ud_outside_mb_loops2(vrna_fold_compound_t *vc)
 
                 /* 3rd, l - 1 pairs with u */
                 int ul = my_iindx[u] - (l - 1);
-                if (hc[(l - 1) * n + u] & VRNA_CONSTRAINT_CONTEXT_MB_LOOP_ENC) {
+                if (vrna_hc_mx_get(hc, l - 1, u) & VRNA_CONSTRAINT_CONTEXT_MB_LOOP_ENC) {
                   tt    = vrna_get_ptype(jindx[l - 1] + u, ptype);
                   temp  = qb[ul]
                           * exp_E_MLstem(tt, S[u - 1], S[l], pf_params);
@@ -3376,7 +3551,7 @@ ud_outside_mb_loops2(vrna_fold_compound_t *vc)
               for (qmli[k] = 0., u = k + turn + 1; u < i; u++) {
                 int ku = my_iindx[k] - u;
                 /* respect hard constraints */
-                if (hc[k * n + u] & VRNA_CONSTRAINT_CONTEXT_MB_LOOP_ENC) {
+                if (vrna_hc_mx_get(hc, k, u) & VRNA_CONSTRAINT_CONTEXT_MB_LOOP_ENC) {
                   up = (i - 1) - (u + 1) + 1;
                   if (hc_up[u + 1] >= up) {
                     temp = qb[ku]
@@ -3402,7 +3577,7 @@ ud_outside_mb_loops2(vrna_fold_compound_t *vc)
 
               for (l = j + 1; l <= n; l++) {
                 kl = my_iindx[k] - l;
-                if (hc[k * n + l] & VRNA_CONSTRAINT_CONTEXT_MB_LOOP) {
+                if (vrna_hc_mx_get(hc, k, l) & VRNA_CONSTRAINT_CONTEXT_MB_LOOP) {
                   int up, jkl;
                   jkl = jindx[l] + k;
                   tt  = rtype[vrna_get_ptype(jkl, ptype)];
@@ -3490,7 +3665,7 @@ bppm_circ(vrna_fold_compound_t *vc)
 {
   unsigned char     type;
   char              *ptype;
-  unsigned char     *hard_constraints, eval;
+  unsigned char     eval;
   short             *S, *S1;
   int               n, i, j, k, l, ij, *rtype, *my_iindx, *jindx, turn;
   FLT_OR_DBL        tmp, tmp2, expMLclosing, *qb, *qm, *qm1, *probs, *scale, *expMLbase, qo;
@@ -3522,7 +3697,6 @@ bppm_circ(vrna_fold_compound_t *vc)
   scale             = matrices->scale;
   expMLbase         = matrices->expMLbase;
   qo                = matrices->qo;
-  hard_constraints  = hc->mx;
 
   expMLclosing  = pf_params->expMLclosing;
   rtype         = &(pf_params->model_details.rtype[0]);
@@ -3556,7 +3730,7 @@ bppm_circ(vrna_fold_compound_t *vc)
         /* 1.1. Exterior Hairpin Contribution */
         tmp2 = vrna_exp_E_hp_loop(vc, j, i);
 
-        if (hard_constraints[i * n + j] & VRNA_CONSTRAINT_CONTEXT_INT_LOOP) {
+        if (vrna_hc_mx_get(hc, i, j) & VRNA_CONSTRAINT_CONTEXT_INT_LOOP) {
           /* 1.2. Exterior Interior Loop Contribution                     */
           /* 1.2.1. i,j  delimtis the "left" part of the interior loop    */
           /* (j,i) is "outer pair"                                        */
@@ -3585,7 +3759,7 @@ bppm_circ(vrna_fold_compound_t *vc)
               if ((ln1 + ln2 + ln3) > MAXLOOP)
                 continue;
 
-              eval = (hard_constraints[k * n + l] & VRNA_CONSTRAINT_CONTEXT_INT_LOOP) ? 1 : 0;
+              eval = (vrna_hc_mx_get(hc, k, l) & VRNA_CONSTRAINT_CONTEXT_INT_LOOP) ? 1 : 0;
               if (hc->f)
                 eval = hc->f(k, l, i, j, VRNA_DECOMP_PAIR_IL, hc->data);
 
@@ -3652,7 +3826,7 @@ bppm_circ(vrna_fold_compound_t *vc)
               if ((ln1 + ln2 + ln3) > MAXLOOP)
                 continue;
 
-              eval = (hard_constraints[k * n + l] & VRNA_CONSTRAINT_CONTEXT_INT_LOOP) ? 1 : 0;
+              eval = (vrna_hc_mx_get(hc, k, l) & VRNA_CONSTRAINT_CONTEXT_INT_LOOP) ? 1 : 0;
               if (hc->f)
                 eval = hc->f(i, j, k, l, VRNA_DECOMP_PAIR_IL, hc->data) ? eval : 0;
 
@@ -3694,7 +3868,7 @@ bppm_circ(vrna_fold_compound_t *vc)
         }
 
         /* 1.3 Exterior multiloop decomposition */
-        if (hard_constraints[i * n + j] & VRNA_CONSTRAINT_CONTEXT_MB_LOOP) {
+        if (vrna_hc_mx_get(hc, i, j) & VRNA_CONSTRAINT_CONTEXT_MB_LOOP) {
           /* 1.3.1 Middle part                    */
           if ((i > turn + 2) && (j < n - turn - 1)) {
             tmp = 0;
@@ -3930,7 +4104,6 @@ bppm_circ(vrna_fold_compound_t *vc)
 PRIVATE INLINE void
 bppm_circ_comparative(vrna_fold_compound_t *vc)
 {
-  unsigned char     *hard_constraints;
   short             **S, **S5, **S3;
   unsigned int      s, n_seq, *type, **a2s;
   int               i, j, k, l, n, ij, turn, *my_iindx, *jindx, *pscore, *rtype;
@@ -3965,7 +4138,6 @@ bppm_circ_comparative(vrna_fold_compound_t *vc)
   kTn               = pf_params->kT / 10.;   /* kT in cal/mol  */
   hc                = vc->hc;
   scs               = vc->scs;
-  hard_constraints  = hc->mx;
 
   type = (unsigned int *)vrna_alloc(sizeof(unsigned int) * n_seq);
 
@@ -3985,7 +4157,7 @@ bppm_circ_comparative(vrna_fold_compound_t *vc)
         tmp2 += vrna_exp_E_hp_loop(vc, j, i);
         /* 1.2. Exterior Interior Loop Contribution */
         /* recycling of k and l... */
-        if (hard_constraints[i * n + j] & VRNA_CONSTRAINT_CONTEXT_INT_LOOP) {
+        if (vrna_hc_mx_get(hc, i, j) & VRNA_CONSTRAINT_CONTEXT_INT_LOOP) {
           /* 1.2.1. first we calc exterior loop energy with constraint, that i,j  */
           /* delimtis the "right" part of the interior loop                       */
           /* (l,k) is "outer pair"                                                */
@@ -4012,7 +4184,7 @@ bppm_circ_comparative(vrna_fold_compound_t *vc)
               if (hc->up_int[l + 1] < ln2)
                 continue;
 
-              if (!(hard_constraints[k * n + l] & VRNA_CONSTRAINT_CONTEXT_INT_LOOP))
+              if (!(vrna_hc_mx_get(hc, k, l) & VRNA_CONSTRAINT_CONTEXT_INT_LOOP))
                 continue;
 
               FLT_OR_DBL qloop = 1.;
@@ -4092,7 +4264,7 @@ bppm_circ_comparative(vrna_fold_compound_t *vc)
               if (hc->up_int[l + 1] < ln2)
                 continue;
 
-              if (!(hard_constraints[k * n + l] & VRNA_CONSTRAINT_CONTEXT_INT_LOOP))
+              if (!(vrna_hc_mx_get(hc, k, l) & VRNA_CONSTRAINT_CONTEXT_INT_LOOP))
                 continue;
 
               FLT_OR_DBL qloop = 1.;
@@ -4144,7 +4316,7 @@ bppm_circ_comparative(vrna_fold_compound_t *vc)
         }
 
         /* 1.3 Exterior multiloop decomposition */
-        if (hard_constraints[i * n + j] & VRNA_CONSTRAINT_CONTEXT_MB_LOOP) {
+        if (vrna_hc_mx_get(hc, i, j) & VRNA_CONSTRAINT_CONTEXT_MB_LOOP) {
           /* 1.3.1 Middle part                    */
           if ((i > turn + 2) && (j < n - turn - 1)) {
             for (tmp3 = 1, s = 0; s < n_seq; s++)
@@ -4219,7 +4391,8 @@ PRIVATE double
 wrap_mean_bp_distance(FLT_OR_DBL  *p,
                       int         length,
                       int         *index,
-                      int         turn)
+                      int         turn,
+                      int         max_d)
 {
   int     i, j;
   double  d = 0.;
@@ -4230,8 +4403,62 @@ wrap_mean_bp_distance(FLT_OR_DBL  *p,
    * <d> = \sum_{ij} p_{ij}(1-p_{ij}) */
 
   for (i = 1; i <= length; i++)
-    for (j = i + turn + 1; j <= length; j++)
+    for (j = i + turn + 1; j <= MIN2(length, i + max_d); j++)
       d += p[index[i] - j] * (1 - p[index[i] - j]);
 
   return 2 * d;
 }
+
+
+/* the partition function of the entire sequence */
+PRIVATE FLT_OR_DBL
+get_Q(vrna_fold_compound_t *fc)
+{
+  vrna_mx_pf_t *matrices = fc->exp_matrices;
+
+  if (fc->exp_params->model_details.circ)
+    return matrices->qo;
+
+  /*
+   *  single precision storage keeps the exterior loop prefixes only, see vrna_md_t.pf_float,
+   *  and banded matrices lack the segment [1, n]
+   */
+  if ((!matrices->q) || (fc->jindx_span))
+    return matrices->q1k[fc->length];
+
+  return matrices->q[fc->iindx[1] - fc->length];
+}
+
+
+/* same as vrna_db_from_probs() but for banded matrices */
+PRIVATE char *
+db_from_probs_banded(vrna_fold_compound_t *fc)
+{
+  int         i, j, n, max_d, *index;
+  float       P[3]; /* P[][0] unpaired, P[][1] upstream p, P[][2] downstream p */
+  char        *s;
+  FLT_OR_DBL  *probs;
+
+  n     = (int)fc->length;
+  max_d = (int)fc->jindx_span + 1;
+  index = fc->iindx;
+  probs = fc->exp_matrices->probs;
+  s     = (char *)vrna_alloc(sizeof(char) * (n + 1));
+
+  for (j = 1; j <= n; j++) {
+    P[0]  = 1.0;
+    P[1]  = P[2] = 0.0;
+    for (i = MAX2(1, j - max_d); i < j; i++) {
+      P[2]  += (float)probs[index[i] - j];  /* j is paired downstream */
+      P[0]  -= (float)probs[index[i] - j];  /* j is unpaired */
+    }
+    for (i = j + 1; i <= MIN2(n, j + max_d); i++) {
+      P[1]  += (float)probs[index[j] - i];  /* j is paired upstream */
+      P[0]  -= (float)probs[index[j] - i];  /* j is unpaired */
+    }
+    s[j - 1] = vrna_bpp_symbol(P);
+  }
+  s[n] = '\0';
+
+  return s;
+}
@@ -535,7 +535,12 @@ wrap_eval_structure(vrna_fold_compound_t  *vc,
   int   res, gq, L, l[3];
   float energy;
 
-  energy                          = (float)INF / 100.;
+  energy = (float)INF / 100.;
+
+  /* structures beyond the length limit of pair tables can not be evaluated */
+  if (!pt)
+    return energy;
+
   gq                              = vc->params->model_details.gquad;
   vc->params->model_details.gquad = 0;
 
@@ -1427,7 +1432,7 @@ energy_of_ml_pt(vrna_fold_compound_t  *vc,
       if (i != 0) {
         /* (i,j) is closing pair of multibranch loop, add soft constraints */
         if (sc)
-          if (sc->energy_bp)
+          if ((sc->energy_bp) && ((!vc->jindx_span) || (j - i <= (int)vc->jindx_span + 1)))
             bonus += sc->energy_bp[idx[j] + i];
       }
 
@@ -1445,7 +1450,8 @@ energy_of_ml_pt(vrna_fold_compound_t  *vc,
         /* (i,j) is closing pair of multibranch loop, add soft constraints */
         if (scs) {
           for (ss = 0; ss < n_seq; ss++)
-            if (scs[ss] && scs[ss]->energy_bp)
+            if ((scs[ss]) && (scs[ss]->energy_bp) &&
+                ((!vc->jindx_span) || (j - i <= (int)vc->jindx_span + 1)))
               bonus += scs[ss]->energy_bp[idx[j] + i];
         }
       }
@@ -2374,15 +2380,25 @@ covar_en_corr_of_loop_gquad(vrna_fold_compound_t  *vc,
 }
 
 
+PRIVATE INLINE int
+get_pscore(vrna_fold_compound_t *vc,
+           int                  i,
+           int                  j)
+{
+  /* pairs beyond the band of span-limited fold compounds are forbidden */
+  if ((vc->jindx_span) && (j - i > (int)vc->jindx_span + 1))
+    return -10000; /* same score as for all other forbidden pairs */
+
+  return vc->pscore[vc->jindx[j] + i];
+}
+
+
 PRIVATE int
 stack_energy_covar_pt(vrna_fold_compound_t  *vc,
                       int                   i,
                       const short           *pt)
 {
   /* calculate energy of substructure enclosed by (i,j) */
-  int *indx   = vc->jindx;                      /* index for moving in the triangle matrices c[] and fMl[]*/
-  int *pscore = vc->pscore;                     /* precomputed array of pair types */
-
   int energy = 0;
   int j, p, q;
 
@@ -2396,7 +2412,7 @@ stack_energy_covar_pt(vrna_fold_compound_t  *vc,
     if ((pt[q] != (short)p) || (p > q))
       break;
 
-    energy  += pscore[indx[j] + i];
+    energy  += get_pscore(vc, i, j);
     i       = p;
     j       = q;
   }  /* end while */
@@ -2405,12 +2421,12 @@ stack_energy_covar_pt(vrna_fold_compound_t  *vc,
 
   if (p > q) {
     /* hairpin case */
-    energy += pscore[indx[j] + i];
+    energy += get_pscore(vc, i, j);
     return energy;
   }
 
   /* (i,j) is exterior pair of multiloop */
-  energy += pscore[indx[j] + i];
+  energy += get_pscore(vc, i, j);
   while (p < j) {
     /* add up the contributions of the substructures of the ML */
     energy  += stack_energy_covar_pt(vc, p, pt);
@@ -39,6 +39,7 @@
 #include "ViennaRNA/cofold.h"
 #include "ViennaRNA/mm.h"
 #include "ViennaRNA/alphabet.h"
+#include "ViennaRNA/grammar.h"
 #include "ViennaRNA/fold_compound.h"
 
 /*
@@ -49,6 +50,7 @@
 
 #define WITH_PTYPE          1L    /* passed to set_fold_compound() to indicate that we need to set fc->ptype */
 #define WITH_PTYPE_COMPAT   2L    /* passed to set_fold_compound() to indicate that we need to set fc->ptype_compat */
+#define WITH_BANDED_INDEX   4L    /* passed to set_fold_compound() to indicate that jindx may be banded */
 
 /*
  #################################
@@ -77,6 +79,12 @@ PRIVATE void
 make_pscores(vrna_fold_compound_t *fc);
 
 
+PRIVATE unsigned int
+banded_span(vrna_fold_compound_t  *fc,
+            unsigned int          length,
+            int                   max_bp_span);
+
+
 PRIVATE void
 sanitize_bp_span(vrna_fold_compound_t *fc,
                  unsigned int         options);
@@ -242,13 +250,21 @@ vrna_fold_compound(const char   *sequence,
     }
   } else {
     /* regular global structure prediction */
-    aux_options |= WITH_PTYPE;
+    aux_options |= WITH_PTYPE | WITH_BANDED_INDEX;
 
     if (options & VRNA_OPTION_PF)
       aux_options |= WITH_PTYPE_COMPAT;
 
     set_fold_compound(fc, options, aux_options);
 
+    if (!fc->jindx) {
+      vrna_message_warning("vrna_fold_compound@data_structures.c: "
+                           "sequence length of %d exceeds addressable range of non-banded matrices",
+                           length);
+      vrna_fold_compound_free(fc);
+      return NULL;
+    }
+
     if (!(options & VRNA_OPTION_EVAL_ONLY)) {
       /* add default hard constraints */
       vrna_hc_init(fc);
@@ -262,6 +278,139 @@ vrna_fold_compound(const char   *sequence,
 }
 
 
+PUBLIC int
+vrna_fold_compound_reset_sequence(vrna_fold_compound_t  *fc,
+                                  const char            *sequence)
+{
+  unsigned int  length, span, with_ptype, with_ptype_compat;
+  vrna_md_t     md_old, *md;
+
+  if ((!fc) || (!sequence))
+    return 0;
+
+  if ((fc->type != VRNA_FC_TYPE_SINGLE) ||
+      (fc->strands != 1) ||
+      (fc->window_size > 0) ||
+      (fc->reference_pt1) ||
+      (strchr(sequence, '&'))) {
+    vrna_message_warning("vrna_fold_compound_reset_sequence@fold_compound.c: "
+                         "Only global single strand fold compounds can be re-used for single sequences");
+    return 0;
+  }
+
+  length = strlen(sequence);
+  if (length == 0) {
+    vrna_message_warning("vrna_fold_compound_reset_sequence@fold_compound.c: "
+                         "sequence length must be greater 0");
+    return 0;
+  }
+
+  /* the band of the new sequence, i.e. after adapting the base pair span to its length */
+  span = 0;
+  if (fc->hc)
+    span = banded_span(fc,
+                       length,
+                       ((fc->bp_span_request <= 0) || (fc->bp_span_request > (int)length)) ?
+                       (int)length :
+                       fc->bp_span_request);
+
+  if (length > vrna_sequence_length_max((span) ? VRNA_OPTION_BANDED : VRNA_OPTION_DEFAULT)) {
+    vrna_message_warning("vrna_fold_compound_reset_sequence@fold_compound.c: "
+                         "sequence length of %d exceeds addressable range",
+                         length);
+    return 0;
+  }
+
+  with_ptype        = (fc->ptype) ? 1 : 0;
+  with_ptype_compat = (fc->ptype_pf_compat) ? 1 : 0;
+
+  /* remove everything that depends on the previous sequence */
+  vrna_sc_remove(fc);
+  vrna_ud_remove(fc);
+  vrna_gr_reset(fc);
+
+  /* user-defined data most likely refers to the previous sequence as well */
+  if (fc->free_auxdata)
+    fc->free_auxdata(fc->auxdata);
+
+  fc->auxdata       = NULL;
+  fc->free_auxdata  = NULL;
+  fc->stat_cb       = NULL;
+  vrna_sequence_remove_all(fc);
+  free(fc->ptype);
+  free(fc->ptype_pf_compat);
+  free(fc->iindx);
+  free(fc->jindx);
+  fc->ptype           = NULL;
+  fc->ptype_pf_compat = NULL;
+  fc->iindx           = NULL;
+  fc->jindx           = NULL;
+
+  /* add the new sequence, this re-uses the sequence and encoding buffers */
+  fc->length = 0;
+  vrna_sequence_add(fc, sequence, VRNA_SEQUENCE_RNA);
+  vrna_sequence_prepare(fc);
+
+  /* adapt the base pair span to the new sequence length */
+  md              = &(fc->params->model_details);
+  md_old          = *md;
+  md->max_bp_span = fc->bp_span_request;
+  sanitize_bp_span(fc, VRNA_OPTION_DEFAULT);
+
+  /* keep Boltzmann factors consistent with the energy parameters */
+  if (fc->exp_params) {
+    if (memcmp(&md_old, &(fc->exp_params->model_details), sizeof(vrna_md_t)) == 0) {
+      (void)vrna_md_copy(&(fc->exp_params->model_details), md);
+      fc->exp_params->pf_scale = -1.;
+    } else {
+      free(fc->exp_params);
+      fc->exp_params = NULL;
+    }
+  }
+
+  /* banded matrices must be re-allocated if the band changes */
+  if (span != fc->jindx_span) {
+    vrna_mx_mfe_free(fc);
+    vrna_mx_pf_free(fc);
+    fc->jindx_span = span;
+  }
+
+  if (fc->jindx_span) {
+    fc->iindx = vrna_idx_row_wise_banded(length, fc->jindx_span);
+    fc->jindx = vrna_idx_col_wise_banded(length, fc->jindx_span);
+  } else {
+    fc->iindx = vrna_idx_row_wise(length);
+    fc->jindx = vrna_idx_col_wise(length);
+  }
+
+  if (with_ptype)
+    vrna_ptypes_prepare(fc, VRNA_OPTION_MFE);
+
+  if ((with_ptype_compat) && (!fc->jindx_span))
+    fc->ptype_pf_compat = get_ptypes(fc->sequence_encoding2, md, 1);
+
+  /* reset hard constraints to default */
+  if (fc->hc)
+    vrna_hc_init(fc);
+
+  /* G-quadruplex contributions are stored along with the MFE matrices */
+  if ((fc->matrices) && (md->gquad)) {
+    free(fc->matrices->ggg);
+    fc->matrices->ggg = get_gquad_matrix(fc->sequence_encoding2, fc->params);
+  }
+
+  /* update scaling arrays of present partition function matrices */
+  if (fc->exp_matrices) {
+    if ((fc->exp_matrices->length < length) || (!fc->exp_params))
+      vrna_mx_pf_free(fc);
+    else
+      vrna_exp_params_rescale(fc, NULL);
+  }
+
+  return 1;
+}
+
+
 PUBLIC vrna_fold_compound_t *
 vrna_fold_compound_comparative(const char   **sequences,
                                vrna_md_t    *md_p,
@@ -305,7 +454,7 @@ vrna_fold_compound_comparative2(const char                **sequences,
   if (length == 0) {
     vrna_message_warning("vrna_fold_compound_comparative: "
                          "sequence length must be greater 0");
-  } else if (length > vrna_sequence_length_max(options)) {
+  } else if (length > vrna_sequence_length_max(options & ~VRNA_OPTION_BANDED)) {
     vrna_message_warning("vrna_fold_compound_comparative: "
                          "sequence length of %d exceeds addressable range",
                          length);
@@ -366,7 +515,7 @@ vrna_fold_compound_comparative2(const char                **sequences,
   } else {
     /* regular global structure prediction */
 
-    aux_options |= WITH_PTYPE;
+    aux_options |= WITH_PTYPE | WITH_BANDED_INDEX;
 
     if (options & VRNA_OPTION_PF)
       aux_options |= WITH_PTYPE_COMPAT;
@@ -409,7 +558,7 @@ vrna_fold_compound_TwoD(const char    *sequence,
     vrna_message_warning("vrna_fold_compound_TwoD: "
                          "sequence length must be greater 0");
     return NULL;
-  } else if (length > vrna_sequence_length_max(options)) {
+  } else if (length > vrna_sequence_length_max(options & ~VRNA_OPTION_BANDED)) {
     vrna_message_warning("vrna_fold_compound_TwoD: "
                          "sequence length of %d exceeds addressable range",
                          length);
@@ -506,7 +655,7 @@ vrna_fold_compound_prepare(vrna_fold_compound_t *fc,
   int ret = 1; /* success */
 
   /* check maximum sequence length restrictions */
-  if (fc->length > vrna_sequence_length_max(options)) {
+  if (fc->length > vrna_sequence_length_max(options | ((fc->jindx_span) ? VRNA_OPTION_BANDED : 0))) {
     vrna_message_warning(
       "vrna_fold_compound_prepare@data_structures.c: sequence length of %d exceeds addressable range",
       fc->length);
@@ -582,6 +731,8 @@ sanitize_bp_span(vrna_fold_compound_t *fc,
 
   md = &(fc->params->model_details);
 
+  fc->bp_span_request = md->max_bp_span;
+
   /* make sure that min_loop_size, max_bp_span, and window_size are sane */
   if (options & VRNA_OPTION_WINDOW) {
     if (md->window_size <= 0)
@@ -666,13 +817,6 @@ set_fold_compound(vrna_fold_compound_t  *fc,
           md_p->min_loop_size = 0;                              /* is it safe to set this here? */
       }
 
-      if (!(options & VRNA_OPTION_EVAL_ONLY)) {
-        fc->ptype = (aux & WITH_PTYPE) ? vrna_ptypes(fc->sequence_encoding2, md_p) : NULL;
-        /* backward compatibility ptypes */
-        fc->ptype_pf_compat =
-          (aux & WITH_PTYPE_COMPAT) ? get_ptypes(fc->sequence_encoding2, md_p, 1) : NULL;
-      }
-
       break;
 
     case VRNA_FC_TYPE_COMPARATIVE:
@@ -683,7 +827,6 @@ set_fold_compound(vrna_fold_compound_t  *fc,
       fc->cons_seq  = vrna_aln_consensus_sequence((const char **)sequences, md_p);
       fc->S_cons    = vrna_seq_encode_simple(fc->cons_seq, md_p);
 
-      fc->pscore = vrna_alloc(sizeof(int) * ((length * (length + 1)) / 2 + 2));
       /* backward compatibility ptypes */
       fc->pscore_pf_compat =
         (aux & WITH_PTYPE_COMPAT) ? vrna_alloc(sizeof(int) *
@@ -720,13 +863,79 @@ set_fold_compound(vrna_fold_compound_t  *fc,
 
   vrna_sequence_prepare(fc);
 
-  if (!(options & VRNA_OPTION_WINDOW) && (fc->length <= vrna_sequence_length_max(options))) {
-    fc->iindx = vrna_idx_row_wise(fc->length);
-    fc->jindx = vrna_idx_col_wise(fc->length);
+  if (!(options & VRNA_OPTION_WINDOW)) {
+    if ((aux & WITH_BANDED_INDEX) && (!(options & VRNA_OPTION_EVAL_ONLY))) {
+      fc->band_request  = (options & VRNA_OPTION_BANDED) ? 1 : 0;
+      fc->jindx_span    = banded_span(fc, fc->length, md_p->max_bp_span);
+    }
+
+    /* sequences beyond the default maximum length are addressable through banded indices only */
+    if (fc->length <= vrna_sequence_length_max((fc->jindx_span) ? VRNA_OPTION_BANDED : VRNA_OPTION_DEFAULT)) {
+      if (fc->jindx_span) {
+        fc->iindx = vrna_idx_row_wise_banded(fc->length, fc->jindx_span);
+        fc->jindx = vrna_idx_col_wise_banded(fc->length, fc->jindx_span);
+      } else {
+        fc->iindx = vrna_idx_row_wise(fc->length);
+        fc->jindx = vrna_idx_col_wise(fc->length);
+      }
+    }
+  }
+
+  switch (fc->type) {
+    case VRNA_FC_TYPE_SINGLE:
+      if ((!(options & VRNA_OPTION_EVAL_ONLY)) && (fc->jindx)) {
+        if (aux & WITH_PTYPE)
+          vrna_ptypes_prepare(fc, VRNA_OPTION_MFE);
+
+        /* backward compatibility ptypes, not available for banded matrices */
+        fc->ptype_pf_compat =
+          ((aux & WITH_PTYPE_COMPAT) && (!fc->jindx_span)) ?
+          get_ptypes(fc->sequence_encoding2, md_p, 1) :
+          NULL;
+      }
+
+      break;
+
+    case VRNA_FC_TYPE_COMPARATIVE:
+      if (fc->jindx_span)
+        fc->pscore = vrna_alloc(sizeof(int) * (fc->length + 1) * (fc->jindx_span + 3));
+      else
+        fc->pscore = vrna_alloc(sizeof(int) * ((fc->length * (fc->length + 1)) / 2 + 2));
+
+      break;
+
+    default:
+      break;
   }
 }
 
 
+/*
+ *  Decide whether the span-limited matrices of a global fold compound
+ *  may be stored in banded form. We only do this on request, for plain
+ *  single stranded predictions, where all recursions stay within the
+ *  maximum base pair span, and where we actually save memory.
+ */
+PRIVATE unsigned int
+banded_span(vrna_fold_compound_t  *fc,
+            unsigned int          length,
+            int                   max_bp_span)
+{
+  vrna_md_t *md = &(fc->params->model_details);
+
+  if ((!fc->band_request) ||
+      (fc->strands > 1) ||
+      (md->circ) ||
+      (md->gquad) ||
+      (md->backtrack_type != 'F') ||
+      (max_bp_span <= md->min_loop_size + 1) ||
+      (2 * ((double)max_bp_span + 3) >= (double)length))
+    return 0;
+
+  return (unsigned int)max_bp_span;
+}
+
+
 PRIVATE void
 make_pscores(vrna_fold_compound_t *fc)
 {
@@ -738,7 +947,7 @@ make_pscores(vrna_fold_compound_t *fc)
 
 #define NONE -10000 /* score for forbidden pairs */
 
-  int       i, j, k, l, s, max_span, turn;
+  int       i, j, k, l, s, max_span, max_d, turn;
   float     **dm;
   int       olddm[7][7] = { { 0, 0, 0, 0, 0, 0, 0 }, /* hamming distance between pairs */
                             { 0, 0, 2, 2, 1, 2, 2 } /* CG */,
@@ -779,10 +988,13 @@ make_pscores(vrna_fold_compound_t *fc)
   if ((max_span < turn + 2) || (max_span > n))
     max_span = n;
 
+  /* largest distance j - i that is addressable in pscore */
+  max_d = (fc->jindx_span) ? (int)fc->jindx_span + 1 : n;
+
   for (i = 1; i < n; i++) {
     for (j = i + 1; (j < i + turn + 1) && (j <= n); j++)
       pscore[indx[j] + i] = NONE;
-    for (j = i + turn + 1; j <= n; j++) {
+    for (j = i + turn + 1; (j <= n) && (j - i <= max_d); j++) {
       int     pfreq[8] = {
         0, 0, 0, 0, 0, 0, 0, 0
       };
@@ -829,9 +1041,9 @@ make_pscores(vrna_fold_compound_t *fc)
         i     = k;
         j     = i + turn + l;
         type  = pscore[indx[j] + i];
-        while ((i >= 1) && (j <= n)) {
+        while ((i >= 1) && (j <= n) && (j - i <= max_d)) {
           if ((i > 1) && (j < n))
-            ntype = pscore[indx[j + 1] + i - 1];
+            ntype = (j - i + 2 <= max_d) ? pscore[indx[j + 1] + i - 1] : NONE;
 
           if ((otype < md->cv_fact * MINPSCORE) && (ntype < md->cv_fact * MINPSCORE)) /* too many counterexamples */
             pscore[indx[j] + i] = NONE;                                               /* i.j can only form isolated pairs */
@@ -853,7 +1065,8 @@ make_pscores(vrna_fold_compound_t *fc)
   if (fc->pscore_pf_compat) {
     for (i = 1; i < n; i++)
       for (j = i; j <= n; j++)
-        fc->pscore_pf_compat[my_iindx[i] - j] = (short)pscore[indx[j] + i];
+        fc->pscore_pf_compat[my_iindx[i] - j] =
+          (j - i <= max_d) ? (short)pscore[indx[j] + i] : NONE;
   }
 }
 
@@ -913,6 +1126,10 @@ nullify(vrna_fold_compound_t *fc)
     fc->exp_params    = NULL;
     fc->iindx         = NULL;
     fc->jindx         = NULL;
+    fc->jindx_span    = 0;
+    fc->band_request  = 0;
+
+    fc->bp_span_request = -1;
 
     fc->stat_cb       = NULL;
     fc->auxdata       = NULL;
@@ -335,6 +335,39 @@ struct {
   /**
    *  @}
    */
+
+  /**
+   *  @name Additional data fields for span-limited global folding
+   *
+   *  These data fields are appended to keep the layout of all previous data fields unchanged
+   *  @{
+   */
+  unsigned int  jindx_span;       /**<  @brief  Maximum base pair span addressable via jindx (0 if jindx covers the full triangle)
+                                   *    @note   If non-zero, all pair-indexed DP matrices, the hard constraints matrix
+                                   *            vrna_hc_t.mx, and the base pair probabilities are banded. Only the
+                                   *            exterior loop arrays vrna_mx_pf_t.q1k and vrna_mx_pf_t.qln keep
+                                   *            their full length.
+                                   *    @see    vrna_idx_col_wise_banded(), vrna_idx_row_wise_banded(), vrna_hc_mx_get(),
+                                   *            vrna_mx_pf_get()
+                                   */
+  unsigned int  band_request;     /**<  @brief  Whether banded matrices have been requested via #VRNA_OPTION_BANDED
+                                   *    @see    vrna_fold_compound_reset_sequence()
+                                   */
+  /**
+   *  @}
+   */
+
+  /**
+   *  @name Additional data fields for re-used fold compounds
+   *  @{
+   */
+  int           bp_span_request;  /**<  @brief  Maximum base pair span as requested by the model details, i.e. before
+                                   *            it has been limited to the sequence length
+                                   *    @see    vrna_fold_compound_reset_sequence()
+                                   */
+  /**
+   *  @}
+   */
 };
 
 
@@ -382,6 +415,33 @@ struct {
  */
 #define VRNA_OPTION_WINDOW          16U
 
+/**
+ *  @brief  Option flag to request banded DP matrices for span-limited global structure prediction
+ *
+ *  Use this flag to store the DP matrices of a global structure prediction in banded form, i.e.
+ *  only for pairs @f$ (i,j) @f$ with @f$ j - i @f$ not exceeding the maximum base pair span
+ *  #vrna_md_t.max_bp_span. The band is applied only if the model details permit it, i.e. for
+ *  single stranded, linear RNAs without G-Quadruplexes that use the default exterior loop
+ *  backtracking, and if the band actually saves memory. Otherwise, the flag is silently ignored
+ *  and full matrices are used.
+ *
+ *  For the partition function, the band applies to the matrices vrna_mx_pf_t.q, vrna_mx_pf_t.qb,
+ *  vrna_mx_pf_t.qm, and the base pair probabilities vrna_mx_pf_t.probs. The full length exterior
+ *  loop arrays vrna_mx_pf_t.q1k and vrna_mx_pf_t.qln are then filled directly by the recursions.
+ *  Since banded matrices never address pairs beyond the maximum base pair span, the maximum
+ *  sequence length of single sequence fold compounds is no longer limited to that of the full
+ *  matrices, see vrna_sequence_length_max(). Evaluating structures of such sequences with the
+ *  pair table based functions, e.g. vrna_eval_structure(), is still limited.
+ *
+ *  @note Banding changes the layout of the DP matrices and of the hard constraints matrix
+ *        vrna_hc_t.mx. Use vrna_fold_compound_t.jindx_span to check whether the band has been
+ *        applied and accessor functions, e.g. vrna_hc_mx_get() or vrna_mx_pf_get(), to read the
+ *        matrices.
+ *
+ *  @see vrna_fold_compound(), vrna_fold_compound_comparative(), vrna_idx_col_wise_banded()
+ */
+#define VRNA_OPTION_BANDED          32U
+
 /**
  *  @brief  Retrieve a #vrna_fold_compound_t data structure for single sequences and hybridizing sequences
  *
@@ -399,6 +459,7 @@ struct {
  *  * #VRNA_OPTION_MFE      - @copybrief #VRNA_OPTION_MFE
  *  * #VRNA_OPTION_PF       - @copybrief #VRNA_OPTION_PF
  *  * #VRNA_OPTION_WINDOW   - @copybrief #VRNA_OPTION_WINDOW
+ *  * #VRNA_OPTION_BANDED   - @copybrief #VRNA_OPTION_BANDED
  *
  *  The above options may be OR-ed together.
  *
@@ -441,6 +502,7 @@ vrna_fold_compound(const char   *sequence,
  *  * #VRNA_OPTION_MFE      - @copybrief #VRNA_OPTION_MFE
  *  * #VRNA_OPTION_PF       - @copybrief #VRNA_OPTION_PF
  *  * #VRNA_OPTION_WINDOW   - @copybrief #VRNA_OPTION_WINDOW
+ *  * #VRNA_OPTION_BANDED   - @copybrief #VRNA_OPTION_BANDED
  *
  *  The above options may be OR-ed together.
  *
@@ -486,6 +548,39 @@ vrna_fold_compound_TwoD(const char    *sequence,
                         unsigned int  options);
 
 
+/**
+ *  @brief  Replace the sequence of an existing #vrna_fold_compound_t
+ *
+ *  This function re-targets a #vrna_fold_compound_t obtained from vrna_fold_compound() to a new
+ *  single sequence. In contrast to creating a new #vrna_fold_compound_t for each sequence, the
+ *  energy parameters (and Boltzmann factors), as well as the DP matrices are re-used, such that
+ *  predictions for many (short) sequences with the same model details avoid most of the setup
+ *  costs. DP matrices are only re-allocated if the new sequence does not fit into the memory that
+ *  is already present.
+ *
+ *  All sequence dependent data, i.e. pair type arrays, and index arrays are updated accordingly.
+ *  Hard constraints are reset to their default values, while soft constraints, unstructured
+ *  domains, and extensions of the grammar are removed. Auxiliary data attached via
+ *  vrna_fold_compound_add_auxdata() is released through its free callback, and the recursion
+ *  status callback is removed as well. Subsequent predictions are identical to those obtained
+ *  with a new #vrna_fold_compound_t for the same sequence and model details.
+ *
+ *  @note This function only applies to #vrna_fold_compound_t of type #VRNA_FC_TYPE_SINGLE that
+ *        have been created for a single strand and global structure prediction, i.e. without
+ *        option #VRNA_OPTION_WINDOW. The new sequence must not contain multiple strands either.
+ *        The fold compound remains untouched if any of these conditions is violated.
+ *
+ *  @see  vrna_fold_compound(), vrna_fold_compound_free()
+ *
+ *  @param  fc        The #vrna_fold_compound_t that is to be re-used
+ *  @param  sequence  The new (uppercase) sequence
+ *  @return           1 on success, 0 otherwise
+ */
+int
+vrna_fold_compound_reset_sequence(vrna_fold_compound_t  *fc,
+                                  const char            *sequence);
+
+
 int
 vrna_fold_compound_prepare(vrna_fold_compound_t *fc,
                            unsigned int         options);
@@ -0,0 +1,559 @@
+/*
+ *                Heat Capacity of RNA molecule
+ *
+ *                c Ivo Hofacker and Peter Stadler
+ *                Vienna RNA package
+ *
+ *
+ *          calculates specific heat using C = - T d^2/dT^2 G(T)
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "ViennaRNA/utils/basic.h"
+#include "ViennaRNA/params/constants.h"
+#include "ViennaRNA/params/basic.h"
+#include "ViennaRNA/alphabet.h"
+#include "ViennaRNA/loops/all.h"
+#include "ViennaRNA/constraints/hard.h"
+#include "ViennaRNA/mfe.h"
+#include "ViennaRNA/part_func.h"
+#include "ViennaRNA/heat_capacity.h"
+
+#define MAXPOINTS  100
+
+/* number of temperatures whose partition functions are computed within a single sweep */
+#define LANES       4
+
+/*
+ #################################
+ # PRIVATE DATA STRUCTURES       #
+ #################################
+ */
+struct store_results {
+  vrna_heat_capacity_t  *result;
+  unsigned int          num;
+  unsigned int          size;
+};
+
+/*
+ #################################
+ # PRIVATE FUNCTION DECLARATIONS #
+ #################################
+ */
+PRIVATE float
+ddiff(float f[],
+      float h,
+      int   m);
+
+
+PRIVATE void
+store_results_cb(float  temp,
+                 float  heat_capacity,
+                 void   *data);
+
+
+PRIVATE void
+sweep_segment(vrna_fold_compound_t  *fc,
+              vrna_md_t             *md,
+              double                *temps,
+              float                 *F,
+              float                 h,
+              int                   start,
+              int                   end,
+              int                   with_lanes);
+
+
+PRIVATE int
+lanes_possible(vrna_fold_compound_t *fc);
+
+
+PRIVATE int
+sweep_lanes(vrna_fold_compound_t  *fc,
+            vrna_md_t             *md,
+            double                *temps,
+            int                   num,
+            double                min_en,
+            float                 h,
+            float                 *F);
+
+
+#ifdef _OPENMP
+
+PRIVATE int
+parallel_sweep_possible(vrna_fold_compound_t *fc);
+
+
+PRIVATE vrna_fold_compound_t *
+segment_fold_compound(vrna_fold_compound_t  *fc,
+                      vrna_md_t             *md);
+
+
+#endif
+
+/*
+ #################################
+ # BEGIN OF FUNCTION DEFINITIONS #
+ #################################
+ */
+PUBLIC vrna_heat_capacity_t *
+vrna_heat_capacity(vrna_fold_compound_t *fc,
+                   float                T_min,
+                   float                T_max,
+                   float                T_increment,
+                   unsigned int         mpoints)
+{
+  struct store_results  d;
+
+  d.num     = 0;
+  d.size    = 128;
+  d.result  = (vrna_heat_capacity_t *)vrna_alloc(sizeof(vrna_heat_capacity_t) * (d.size + 1));
+
+  if (!vrna_heat_capacity_cb(fc,
+                             T_min,
+                             T_max,
+                             T_increment,
+                             mpoints,
+                             &store_results_cb,
+                             (void *)&d)) {
+    free(d.result);
+    return NULL;
+  }
+
+  d.result                      = (vrna_heat_capacity_t *)vrna_realloc(d.result,
+                                                                       sizeof(vrna_heat_capacity_t) *
+                                                                       (d.num + 1));
+  d.result[d.num].temperature   = T_min - 1.;
+  d.result[d.num].heat_capacity = 0.;
+
+  return d.result;
+}
+
+
+PUBLIC int
+vrna_heat_capacity_cb(vrna_fold_compound_t        *fc,
+                      float                       T_min,
+                      float                       T_max,
+                      float                       T_increment,
+                      unsigned int                mpoints,
+                      vrna_heat_capacity_callback *cb,
+                      void                        *data)
+{
+  int       m, j, num, size, segments, with_lanes, chunk, blocks;
+  float     *F, h, T_bound;
+  double    *temps;
+  vrna_md_t md, md_orig;
+
+  if ((!fc) || (!cb))
+    return 0;
+
+  if (T_increment <= 0.) {
+    vrna_message_warning("vrna_heat_capacity*(): Temperature increment must be positive!");
+    return 0;
+  }
+
+  h = T_increment;
+  m = (int)MAX2(1, MIN2(mpoints, MAXPOINTS));
+
+  md_orig = fc->params->model_details;
+  md      = md_orig;
+
+  /* required for vrna_exp_param_rescale() in subsequent calls */
+  md.sfact        = 1.;
+  md.backtrack    = 0;
+  md.compute_bpp  = 0;
+
+  /*
+   *  Prepare the temperatures of all partition functions we require. Each
+   *  heat capacity is derived from 2 * m + 1 adjacent free energies, and the
+   *  last window is centered around the first temperature exceeding T_max
+   */
+  size  = 2 * m + 128;
+  temps = (double *)vrna_alloc(sizeof(double) * size);
+
+  temps[0] = T_min - m * h;
+  for (j = 1; j < 2 * m + 1; j++)
+    temps[j] = temps[j - 1] + h;
+
+  T_bound = T_max + m * h + h;
+
+  /* the j-th heat capacity is centered at temps[m + j] */
+  for (num = 0; temps[2 * m + num] + h <= T_bound; num++) {
+    if (2 * m + num + 1 >= size) {
+      size  *= 2;
+      temps = (double *)vrna_realloc(temps, sizeof(double) * size);
+    }
+
+    temps[2 * m + num + 1] = temps[2 * m + num] + h;
+  }
+
+  if (num == 0) {
+    free(temps);
+    return 1;
+  }
+
+  /* free energies of the ensemble for temps[0] to temps[2 * m + num - 1] */
+  F           = (float *)vrna_alloc(sizeof(float) * (2 * m + num));
+  with_lanes  = lanes_possible(fc);
+  chunk       = (with_lanes) ? LANES : 1;
+  blocks      = (2 * m + num + chunk - 1) / chunk;
+  segments    = 1;
+
+#ifdef _OPENMP
+  if (parallel_sweep_possible(fc))
+    segments = MIN2(md.num_threads, blocks);
+#endif
+
+  if (segments > 1) {
+#ifdef _OPENMP
+    int                   s;
+    vrna_fold_compound_t  **fcs;
+
+    /*
+     *  Split the temperatures into consecutive segments of entire blocks
+     *  of lanes, each of which is swept by a separate thread. Additional
+     *  fold compounds are created upfront, since the hard constraints of fc
+     *  must not be accessed while fc itself is in use
+     */
+    md.num_threads  = 1;
+    fcs             = (vrna_fold_compound_t **)vrna_alloc(sizeof(vrna_fold_compound_t *) * segments);
+    fcs[0]          = fc;
+
+    for (s = 1; s < segments; s++)
+      fcs[s] = segment_fold_compound(fc, &md);
+
+    omp_set_dynamic(0);
+
+#pragma omp parallel for schedule(static, 1) num_threads(segments)
+    for (s = 0; s < segments; s++) {
+      vrna_md_t md_local = md;
+      sweep_segment(fcs[s],
+                    &md_local,
+                    temps,
+                    F,
+                    h,
+                    MIN2(2 * m + num, chunk * (int)(((long)s * blocks) / segments)),
+                    MIN2(2 * m + num, chunk * (int)(((long)(s + 1) * blocks) / segments)),
+                    with_lanes);
+    }
+
+    for (s = 1; s < segments; s++)
+      vrna_fold_compound_free(fcs[s]);
+
+    free(fcs);
+#endif
+  } else {
+    sweep_segment(fc, &md, temps, F, h, 0, 2 * m + num, with_lanes);
+  }
+
+  for (j = 0; j < num; j++)
+    cb((float)(temps[2 * m + j + 1] - m * h - h),
+       -ddiff(F + j, h, m) * (temps[2 * m + j + 1] + K0 - m * h - h),
+       data);
+
+  /* restore energy parameters */
+  vrna_params_reset(fc, &md_orig);
+
+  if (fc->exp_params)
+    vrna_exp_params_rescale(fc, NULL);
+
+  free(F);
+  free(temps);
+
+  return 1;
+}
+
+
+/*
+ #####################################
+ # BEGIN OF STATIC HELPER FUNCTIONS  #
+ #####################################
+ */
+
+/*
+ *  Compute the ensemble free energies F[start] to F[end - 1] for the
+ *  temperatures temps[start] to temps[end - 1]. The partition function
+ *  of each temperature is scaled according to the ensemble free energy
+ *  of the preceding one, and the first one according to its MFE. If
+ *  with_lanes is set, blocks of LANES temperatures are processed within
+ *  a single sweep of the recursions, until the first block exceeds the
+ *  range of FLT_OR_DBL
+ */
+PRIVATE void
+sweep_segment(vrna_fold_compound_t  *fc,
+              vrna_md_t             *md,
+              double                *temps,
+              float                 *F,
+              float                 h,
+              int                   start,
+              int                   end,
+              int                   with_lanes)
+{
+  int     i, n, num;
+  double  min_en;
+
+  if (start >= end)
+    return;
+
+  n = (int)fc->length;
+
+  md->temperature = temps[start];
+  vrna_params_reset(fc, md);
+
+  min_en  = (double)vrna_mfe(fc, NULL);
+  min_en  *= md->sfact;
+
+  for (i = start; i < end; i += num) {
+    num = 0;
+
+    if (with_lanes) {
+      num = sweep_lanes(fc, md, temps + i, MIN2(LANES, end - i), min_en, h, F + i);
+
+      /*
+       *  neighboring temperatures most likely exceed the range as well,
+       *  so the remainder of the segment is processed one by one
+       */
+      if (num == 0)
+        with_lanes = 0;
+    }
+
+    if (num == 0) {
+      /* reset all energy parameters according to temperature changes */
+      if (i > start) {
+        md->temperature = temps[i];
+        vrna_params_reset(fc, md);
+      }
+
+      vrna_exp_params_rescale(fc, &min_en);
+
+      F[i]  = vrna_pf(fc, NULL);
+      num   = 1;
+    }
+
+    min_en = F[i + num - 1] + h * 0.00727 * n;
+  }
+}
+
+
+PRIVATE int
+lanes_possible(vrna_fold_compound_t *fc)
+{
+  vrna_md_t *md = &(fc->params->model_details);
+
+  /* the lanes implement plain single sequence recursions only */
+  if ((fc->type != VRNA_FC_TYPE_SINGLE) ||
+      (fc->strands > 1) ||
+      (!fc->hc) ||
+      (fc->hc->type == VRNA_HC_WINDOW) ||
+      (fc->hc->f) ||
+      (fc->sc) ||
+      ((fc->domains_up) && (fc->domains_up->exp_energy_cb)) ||
+      (fc->aux_grammar) ||
+      (md->gquad) ||
+      (md->circ) ||
+      (md->backtrack_type != 'F'))
+    return 0;
+
+  return 1;
+}
+
+
+#define PF_FILL_FUN     fill_lanes
+#define PF_FILL_T       FLT_OR_DBL
+#define PF_FILL_LANES   LANES
+#define PF_FILL_MAX     ((sizeof(FLT_OR_DBL) == sizeof(float)) ? FLT_MAX : DBL_MAX)
+#define PF_FILL_MIN     0.
+#include "part_func_fill.inc"
+
+
+/*
+ *  Compute the ensemble free energies F[0] to F[num - 1] for the
+ *  temperatures temps[0] to temps[num - 1] within a single sweep of the
+ *  partition function recursions of part_func_fill.inc, one lane per
+ *  temperature. Lanes beyond num repeat the last temperature. The
+ *  Boltzmann factors of each lane are computed without the energy
+ *  parameter cache, since every temperature is requested only once.
+ *  Returns num on success, or 0 if any of the partition functions
+ *  exceeds the range of FLT_OR_DBL
+ */
+PRIVATE int
+sweep_lanes(vrna_fold_compound_t  *fc,
+            vrna_md_t             *md,
+            double                *temps,
+            int                   num,
+            double                min_en,
+            float                 h,
+            float                 *F)
+{
+  int               n, i, t, u, ret;
+  size_t            size;
+  FLT_OR_DBL        *qb, *qm, *scale, *expMLbase;
+  double            *q5, pf_scale[LANES], e;
+  vrna_md_t         md_lane;
+  vrna_exp_param_t  *P[LANES];
+
+  n     = (int)fc->length;
+  size  = (fc->jindx_span) ?
+          ((size_t)n + 2) * ((size_t)fc->jindx_span + 3) :
+          (((size_t)n + 1) * ((size_t)n + 2)) / 2;
+
+  qb        = (FLT_OR_DBL *)vrna_alloc(sizeof(FLT_OR_DBL) * size * LANES);
+  qm        = (FLT_OR_DBL *)vrna_alloc(sizeof(FLT_OR_DBL) * size * LANES);
+  scale     = (FLT_OR_DBL *)vrna_alloc(sizeof(FLT_OR_DBL) * (n + 2) * LANES);
+  expMLbase = (FLT_OR_DBL *)vrna_alloc(sizeof(FLT_OR_DBL) * (n + 2) * LANES);
+  q5        = (double *)vrna_alloc(sizeof(double) * (n + 2) * LANES);
+
+  /* Boltzmann factors and scaling, see vrna_exp_params_rescale() */
+  for (t = 0; t < LANES; t++) {
+    u                     = MIN2(t, num - 1);
+    md_lane               = *md;
+    md_lane.temperature   = temps[u];
+    P[t]                  = vrna_exp_params_uncached(&md_lane);
+    e                     = (min_en + u * h * 0.00727 * n) * 1000. / n;
+    pf_scale[t]           = MAX2(1., exp(-(md->sfact * e) / P[t]->kT));
+    scale[t]              = 1.;
+    scale[LANES + t]      = (FLT_OR_DBL)(1. / pf_scale[t]);
+    expMLbase[t]          = 1.;
+    expMLbase[LANES + t]  = (FLT_OR_DBL)(P[t]->expMLbase / pf_scale[t]);
+    for (i = 2; i <= n; i++) {
+      scale[LANES * i + t]      = scale[LANES * (i / 2) + t] *
+                                  scale[LANES * (i - (i / 2)) + t];
+      expMLbase[LANES * i + t]  = (FLT_OR_DBL)pow(P[t]->expMLbase, (double)i) *
+                                  scale[LANES * i + t];
+    }
+  }
+
+  ret = (fill_lanes(fc, P, scale, expMLbase, NULL, qb, qm, NULL, q5, NULL)) ? num : 0;
+
+  /* ensemble free energies in kcal/mol */
+  for (t = 0; (ret) && (t < num); t++)
+    F[t] = (float)((-log(q5[LANES * n + t]) - n * log(pf_scale[t])) *
+                   P[t]->kT /
+                   1000.0);
+
+  for (t = 0; t < LANES; t++)
+    free(P[t]);
+
+  free(qb);
+  free(qm);
+  free(scale);
+  free(expMLbase);
+  free(q5);
+
+  return ret;
+}
+
+
+#ifdef _OPENMP
+
+PRIVATE int
+parallel_sweep_possible(vrna_fold_compound_t *fc)
+{
+  vrna_md_t *md = &(fc->params->model_details);
+
+  /*
+   *  Additional fold compounds only receive a copy of the default hard
+   *  constraints, thus we refuse to process anything beyond that
+   */
+  if ((md->num_threads < 2) ||
+      (fc->type != VRNA_FC_TYPE_SINGLE) ||
+      (fc->strands > 1) ||
+      (fc->sc) ||
+      (fc->domains_up) ||
+      (fc->aux_grammar) ||
+      ((fc->hc) && ((fc->hc->type != VRNA_HC_DEFAULT) || (fc->hc->f))))
+    return 0;
+
+  return 1;
+}
+
+
+PRIVATE vrna_fold_compound_t *
+segment_fold_compound(vrna_fold_compound_t  *fc,
+                      vrna_md_t             *md)
+{
+  unsigned int          n;
+  vrna_fold_compound_t  *fc_seg;
+  vrna_hc_t             *hc, *hc_seg;
+
+  n       = fc->length;
+  fc_seg  = vrna_fold_compound(fc->sequence,
+                               md,
+                               (fc->band_request) ? VRNA_OPTION_BANDED : VRNA_OPTION_DEFAULT);
+
+  /* transfer (possibly user-defined) hard constraints */
+  hc      = fc->hc;
+  hc_seg  = fc_seg->hc;
+
+  if ((hc) && (hc_seg) && (hc->mx_span == hc_seg->mx_span)) {
+    if (hc->mx_span) {
+      memcpy(hc_seg->mx, hc->mx, sizeof(unsigned char) * ((n + 1) * (2 * hc->mx_span + 1)));
+    } else {
+      if ((hc->matrix) && (hc_seg->matrix))
+        memcpy(hc_seg->matrix, hc->matrix, sizeof(unsigned char) * ((n * (n + 1)) / 2 + 2));
+
+      memcpy(hc_seg->mx, hc->mx, sizeof(unsigned char) * ((n + 1) * (n + 1)));
+    }
+
+    memcpy(hc_seg->up_ext, hc->up_ext, sizeof(int) * (n + 2));
+    memcpy(hc_seg->up_hp, hc->up_hp, sizeof(int) * (n + 2));
+    memcpy(hc_seg->up_int, hc->up_int, sizeof(int) * (n + 2));
+    memcpy(hc_seg->up_ml, hc->up_ml, sizeof(int) * (n + 2));
+  }
+
+  return fc_seg;
+}
+
+
+#endif
+
+
+PRIVATE void
+store_results_cb(float  temp,
+                 float  heat_capacity,
+                 void   *data)
+{
+  struct store_results *d = (struct store_results *)data;
+
+  if (d->num == d->size) {
+    d->size   *= 2;
+    d->result = (vrna_heat_capacity_t *)vrna_realloc(d->result,
+                                                     sizeof(vrna_heat_capacity_t) * (d->size + 1));
+  }
+
+  d->result[d->num].temperature   = temp;
+  d->result[d->num].heat_capacity = heat_capacity;
+  d->num++;
+}
+
+
+PRIVATE float
+ddiff(float f[],
+      float h,
+      int   m)
+{
+  int   i;
+  float fp, A, B;
+
+  A = (float)(m * (m + 1) * (2 * m + 1) / 3);                                     /* 2*sum(x^2) */
+  B = (float)(m * (m + 1) * (2 * m + 1)) * (float)(3 * m * m + 3 * m - 1) / 15.;  /* 2*sum(x^4) */
+
+  fp = 0.;
+  for (i = 0; i < 2 * m + 1; i++)
+    fp += f[i] * (A - (float)((2 * m + 1) * (i - m) * (i - m)));
+
+  fp /= ((A * A - B * ((float)(2 * m + 1))) * h * h / 2.);
+  return (float)fp;
+}
@@ -0,0 +1,143 @@
+#ifndef VIENNA_RNA_PACKAGE_HEAT_CAPACITY_H
+#define VIENNA_RNA_PACKAGE_HEAT_CAPACITY_H
+
+#include <ViennaRNA/fold_compound.h>
+
+/**
+ *  @file     heat_capacity.h
+ *  @ingroup  thermodynamics
+ *  @brief    Compute heat capacity for an RNA
+ *
+ *  This file includes the interface to all functions related to predicting the heat capacity
+ *  for an RNA molecule.
+ */
+
+/**
+ *  @addtogroup thermodynamics
+ *  @{
+ *
+ *  @brief  Compute thermodynamic properties from the temperature dependence of the ensemble
+ */
+
+
+/**
+ *  @brief  The callback for heat capacity predictions
+ *
+ *  @callback
+ *  @parblock
+ *  This function will be called for each evaluated temperature in the heat capacity prediction.
+ *  @endparblock
+ *  @see vrna_heat_capacity_cb()
+ *
+ *  @param  temp            The current temperature this results corresponds to in &deg;C
+ *  @param  heat_capacity   The heat capacity in Kcal/(Mol * K)
+ *  @param  data            Some arbitrary data pointer passed through by the function executing the callback
+ */
+typedef void (vrna_heat_capacity_callback)(float  temp,
+                                           float  heat_capacity,
+                                           void   *data);
+
+
+/**
+ *  @brief  A single result from heat capacity computations
+ *
+ *  @see  vrna_heat_capacity()
+ */
+typedef struct vrna_heat_capacity_s vrna_heat_capacity_t;
+
+
+/**
+ *  @brief  A single result from heat capacity computations
+ *
+ *  This is a convenience typedef for #vrna_heat_capacity_t, i.e. results as obtained from vrna_heat_capacity()
+ */
+struct vrna_heat_capacity_s {
+  float temperature;    /**< @brief   The temperature in &deg;C */
+  float heat_capacity;  /**< @brief   The specific heat at this temperature in Kcal/(Mol * K) */
+};
+
+
+/**
+ *  @brief  Compute the specific heat for an RNA
+ *
+ *  This function computes an RNAs specific heat in a given temperature range
+ *  from the partition function by numeric differentiation. The result is returned
+ *  as a list of pairs of temperature in &deg;C and specific heat in Kcal/(Mol*K).
+ *
+ *  Users can specify the temperature range for the computation from @p T_min to
+ *  @p T_max, as well as the increment step size @p T_increment. The latter also determines
+ *  how many times the partition function is computed. Finally, the parameter @p mpoints
+ *  determines how smooth the curve should be. The algorithm itself fits a parabola
+ *  to @f$ 2 \cdot mpoints + 1 @f$ data points to calculate 2nd derivatives. Increasing this
+ *  parameter produces a smoother curve.
+ *
+ *  For linear single sequences without soft constraints, hard constraints callback,
+ *  unstructured domains, grammar extensions, and G-Quadruplexes, the partition functions of
+ *  four consecutive temperatures are computed within a single sweep of the recursions. Hard
+ *  constraints, base pair types, and loop decompositions are then evaluated only once for
+ *  all of these temperatures. Otherwise, one partition function is computed per temperature.
+ *
+ *  If #vrna_md_t.num_threads of the fold compound's model details is larger than 1, the
+ *  temperature range is split into consecutive segments whose partition functions are
+ *  computed concurrently. This requires that the fold compound neither has soft constraints,
+ *  nor a hard constraints callback, nor any extension of the grammar attached. Otherwise, the
+ *  entire temperature range is processed by a single thread. Since the partition functions of
+ *  each segment are scaled independently, results of concurrent computations may differ from
+ *  those of the sequential computation by rounding errors only.
+ *
+ *  @note The energy parameters of @p fc are restored to the model details of @p fc upon
+ *        return, although the Boltzmann factors will be re-scaled.
+ *
+ *  @see  vrna_heat_capacity_cb(), #vrna_heat_capacity_t
+ *
+ *  @param  fc            The #vrna_fold_compound_t with the RNA sequence
+ *  @param  T_min         Lowest temperature in &deg;C
+ *  @param  T_max         Highest temperature in &deg;C
+ *  @param  T_increment   Stepsize for temperature incrementation in &deg;C (a reasonable choice might be 1&deg;C)
+ *  @param  mpoints       The number of interpolation points to calculate 2nd derivative (a reasonable choice might be 2, min: 1, max: 100)
+ *  @return               A list of pairs of temperatures and corresponding heat capacity or @em NULL upon any failure.
+ *                        The last entry of the list is indicated by a temperature field set to a value smaller than @p T_min
+ */
+vrna_heat_capacity_t *
+vrna_heat_capacity(vrna_fold_compound_t *fc,
+                   float                T_min,
+                   float                T_max,
+                   float                T_increment,
+                   unsigned int         mpoints);
+
+
+/**
+ *  @brief  Compute the specific heat for an RNA (callback variant)
+ *
+ *  Similar to vrna_heat_capacity(), this function computes an RNAs specific heat in
+ *  a given temperature range from the partition function by numeric differentiation.
+ *  Instead of returning a list of temperature/specific heat pairs, however, this
+ *  function returns the individual results through a callback mechanism. The provided
+ *  function will be called for each result in order of increasing temperature.
+ *
+ *  @see  vrna_heat_capacity(), #vrna_heat_capacity_callback
+ *
+ *  @param  fc            The #vrna_fold_compound_t with the RNA sequence
+ *  @param  T_min         Lowest temperature in &deg;C
+ *  @param  T_max         Highest temperature in &deg;C
+ *  @param  T_increment   Stepsize for temperature incrementation in &deg;C (a reasonable choice might be 1&deg;C)
+ *  @param  mpoints       The number of interpolation points to calculate 2nd derivative (a reasonable choice might be 2, min: 1, max: 100)
+ *  @param  cb            The user-defined callback function that receives the individual results
+ *  @param  data          An arbitrary data structure that will be passed to the callback in conjunction with the results
+ *  @return               Returns 0 upon failure, and non-zero otherwise
+ */
+int
+vrna_heat_capacity_cb(vrna_fold_compound_t        *fc,
+                      float                       T_min,
+                      float                       T_max,
+                      float                       T_increment,
+                      unsigned int                mpoints,
+                      vrna_heat_capacity_callback *cb,
+                      void                        *data);
+
+
+/**
+ * @}
+ */
+
+#endif
@@ -455,6 +455,81 @@ vrna_file_fasta_read_record( char **header,
   return (return_type);
 }
 
+PUBLIC unsigned int
+vrna_file_fasta_read_header(char **header,
+                            FILE *file){
+
+  int   c;
+  char  *line;
+  FILE  *in = (file) ? file : stdin;
+
+  *header = NULL;
+
+  while((c = getc(in)) != EOF){
+    switch(c){
+      case  '@':    /* user abort */
+                    line = vrna_read_line(in);
+                    free(line);
+                    return VRNA_INPUT_QUIT;
+
+      case  '>':    /* fasta header */
+                    line    = vrna_read_line(in);
+                    *header = (char *)vrna_alloc(sizeof(char) * (((line) ? strlen(line) : 0) + 2));
+                    (*header)[0] = '>';
+                    if(line){
+                      strcpy(*header + 1, line);
+                      free(line);
+                    }
+                    elim_trailing_ws(*header);
+                    return VRNA_INPUT_FASTA_HEADER;
+
+      case  '#': case  '%': case  ';': case  '/': case  '*':
+                    /* comments */
+                    line = vrna_read_line(in);
+                    free(line);
+                    break;
+
+      default:      if(!isspace(c)){
+                      /* leave the sequence to vrna_file_fasta_read_sequence() */
+                      ungetc(c, in);
+                      return VRNA_INPUT_SEQUENCE;
+                    }
+                    break;
+    }
+  }
+
+  return VRNA_INPUT_ERROR;
+}
+
+PUBLIC unsigned int
+vrna_file_fasta_read_sequence(char          *buffer,
+                              unsigned int  size,
+                              void          *file){
+
+  int           c;
+  unsigned int  r;
+  FILE          *in = (file) ? (FILE *)file : stdin;
+
+  for(r = 0; r < size; ){
+    c = getc(in);
+
+    if(c == EOF)
+      break;
+
+    /* fasta header of the next record or user abort */
+    if((c == '>') || (c == '@')){
+      ungetc(c, in);
+      break;
+    }
+
+    /* skip line breaks, whitespaces, and anything else that is not a nucleotide */
+    if(isalpha(c))
+      buffer[r++] = (char)c;
+  }
+
+  return r;
+}
+
 PUBLIC char *
 vrna_extract_record_rest_structure( const char **lines,
                                     unsigned int length,
@@ -198,6 +198,53 @@ vrna_file_fasta_read_record(char          **header,
                             unsigned int  options);
 
 
+/**
+ *  @brief  Read the (fasta) header of the next data set from a file or stdin
+ *
+ *  This function is the first step to read a data set piece by piece, e.g. for
+ *  sequences that are too long to be kept in memory. It skips blank lines and comments
+ *  until it encounters either a fasta header, or the first nucleotide of a sequence.
+ *  The sequence itself may then be retrieved with vrna_file_fasta_read_sequence().
+ *
+ *  @note Do not mix calls of this function and vrna_file_fasta_read_record() on the same
+ *        file handle, since the latter buffers input for the next data set.
+ *
+ *  @see vrna_file_fasta_read_sequence(), vrna_file_fasta_read_record()
+ *
+ *  @param  header    A pointer which will be set such that it points to the header (or NULL if there is none)
+ *  @param  file      A file handle to read from (if NULL, this function reads from stdin)
+ *  @return           #VRNA_INPUT_FASTA_HEADER if a header has been read, #VRNA_INPUT_SEQUENCE if a
+ *                    sequence without header follows, #VRNA_INPUT_QUIT on user abort, and
+ *                    #VRNA_INPUT_ERROR if the end of the input has been reached
+ */
+unsigned int
+vrna_file_fasta_read_header(char  **header,
+                            FILE  *file);
+
+
+/**
+ *  @brief  Read the next part of a sequence from a file or stdin
+ *
+ *  This function writes at most @p size nucleotides of the current sequence to @p buffer,
+ *  where all non-alphabetical characters, such as line breaks, are skipped. The sequence ends
+ *  with the fasta header of the next data set, a line starting with '@', or the end of the
+ *  input. Its signature matches #vrna_sequence_stream_callback, i.e. the function may be
+ *  passed along with a file handle to the streaming algorithms vrna_mfe_window_stream() and
+ *  vrna_probs_window_stream().
+ *
+ *  @see vrna_file_fasta_read_header(), #vrna_sequence_stream_callback
+ *
+ *  @param  buffer    The memory the next part of the sequence is written to
+ *  @param  size      The maximum number of nucleotides that may be written to @p buffer
+ *  @param  file      A file handle (FILE *) to read from (if NULL, this function reads from stdin)
+ *  @return           The number of nucleotides written to @p buffer, or 0 at the end of the sequence
+ */
+unsigned int
+vrna_file_fasta_read_sequence(char          *buffer,
+                              unsigned int  size,
+                              void          *file);
+
+
 /** @brief Extract a dot-bracket structure string from (multiline)character array
  *
  * This function extracts a dot-bracket structure string from the 'rest' array as
@@ -8,6 +8,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <limits.h>
+#include <stdint.h>
 
 #include "ViennaRNA/datastructures/basic.h"
 #include "ViennaRNA/model.h"
@@ -21,14 +22,10 @@
 #include "ViennaRNA/landscape/findpath.h"
 
 
-#ifndef VRNA_DISABLE_BACKWARD_COMPATIBILITY
-
 #ifdef _OPENMP
 #include <omp.h>
 #endif
 
-#endif
-
 #define LOOP_EN
 
 #define   PATH_DIRECT_FINDPATH     1U
@@ -44,16 +41,64 @@ typedef struct move {
 } move_t;
 
 /**
- *  @brief
+ *  @brief  A structure reached from the start structure by a series of moves
+ *
+ *  Intermediates only store the last move and a reference to their predecessor.
+ *  Pair tables are only constructed for the intermediates that are kept in the
+ *  search beam.
  */
 typedef struct intermediate {
-  short   *pt;      /**<  @brief  pair table */
-  int     Sen;      /**<  @brief  saddle energy so far */
-  int     curr_en;  /**<  @brief  current energy */
-  move_t  *moves;   /**<  @brief  remaining moves to target */
+  uint64_t  hash;     /**<  @brief  structure hash, i.e. the XOR of the keys of all moves applied so far */
+  int       parent;   /**<  @brief  index of the predecessor in the search arena (-1 for the start structure) */
+  int       move;     /**<  @brief  index of the move that leads from the predecessor to this structure */
+  int       Sen;      /**<  @brief  saddle energy so far */
+  int       curr_en;  /**<  @brief  current energy */
 } intermediate_t;
 
 
+/**
+ *  @brief  An intermediate together with its pair table, used to resolve ties in the beam
+ */
+typedef struct {
+  short           *pt;
+  intermediate_t  state;
+} tie_t;
+
+
+/**
+ *  @brief  The memory of a single breadth-limited search
+ *
+ *  All memory required for the search is allocated once, upon start of the search.
+ */
+typedef struct {
+  int             len;        /**<  @brief  sequence length */
+  int             dist;       /**<  @brief  number of moves, i.e. base pair distance between start and target */
+  int             maxl;       /**<  @brief  maximum number of intermediates kept per distance class (beam width) */
+  move_t          *moves;     /**<  @brief  the moves required to transform the start into the target structure */
+  uint64_t        *keys;      /**<  @brief  random keys of the moves for structure hashing */
+
+  intermediate_t  *arena;     /**<  @brief  all intermediates that ever entered the beam */
+  int             num_arena;  /**<  @brief  number of intermediates in the arena */
+
+  int             beam;       /**<  @brief  arena index of the first intermediate in the beam */
+  int             num_beam;   /**<  @brief  number of intermediates in the beam */
+  short           *pt;        /**<  @brief  pair tables of the intermediates in the beam */
+  char            *done;      /**<  @brief  flags for the moves already applied to the intermediates in the beam */
+  short           *pt_next;   /**<  @brief  pair tables for the next beam */
+  char            *done_next; /**<  @brief  move flags for the next beam */
+
+  intermediate_t  *next;      /**<  @brief  candidates for the next distance class */
+  int             num_next;   /**<  @brief  number of candidates */
+
+  int             *table;     /**<  @brief  hash table of candidates (indices into next) */
+  unsigned int    *stamp;     /**<  @brief  distance class each hash table entry belongs to */
+  unsigned int    table_mask; /**<  @brief  hash table size - 1 */
+
+  tie_t           *ties;      /**<  @brief  scratch space to resolve ties in the beam */
+  short           *ties_pt;   /**<  @brief  scratch space for pair tables of ties */
+} findpath_search_t;
+
+
 struct vrna_path_options_s {
   unsigned int  type;
   unsigned int  method;
@@ -72,10 +117,6 @@ struct vrna_path_options_s {
  # PRIVATE VARIABLES             #
  #################################
  */
-PRIVATE int                   BP_dist;
-PRIVATE move_t                *path = NULL;
-PRIVATE int                   path_fwd; /* 1: s1->s2, else s2 -> s1 */
-
 
 #ifndef VRNA_DISABLE_BACKWARD_COMPATIBILITY
 
@@ -85,7 +126,7 @@ PRIVATE vrna_fold_compound_t  *backward_compat_compound = NULL;
 
 /* NOTE: all variables are assumed to be uninitialized if they are declared as threadprivate
  */
-#pragma omp threadprivate(BP_dist, path, path_fwd, backward_compat_compound)
+#pragma omp threadprivate(backward_compat_compound)
 
 #endif
 
@@ -96,13 +137,45 @@ PRIVATE vrna_fold_compound_t  *backward_compat_compound = NULL;
  # PRIVATE FUNCTION DECLARATIONS #
  #################################
  */
-PRIVATE move_t *
-copy_moves(move_t *mvs);
+PRIVATE uint64_t
+move_key(int m);
+
+
+PRIVATE findpath_search_t *
+search_init(short *pt1,
+            short *pt2,
+            int   maxl);
+
+
+PRIVATE void
+search_free(findpath_search_t *search);
+
+
+PRIVATE void
+add_candidate(findpath_search_t *search,
+              intermediate_t    *cand,
+              unsigned int      d);
+
+
+PRIVATE void
+candidate_ptable(findpath_search_t  *search,
+                 intermediate_t     *cand,
+                 short              *pt);
+
+
+PRIVATE void
+resolve_ties(findpath_search_t  *search,
+             int                num);
+
+
+PRIVATE void
+update_beam(findpath_search_t *search,
+            int               num);
 
 
 PRIVATE int
-compare_ptable(const void *A,
-               const void *B);
+compare_ties(const void *A,
+             const void *B);
 
 
 PRIVATE int
@@ -115,10 +188,6 @@ compare_moves_when(const void *A,
                    const void *B);
 
 
-PRIVATE void
-free_intermediate(intermediate_t *i);
-
-
 #ifdef TEST_FINDPATH
 
 /* TEST_FINDPATH, COFOLD */
@@ -128,20 +197,31 @@ usage(void);
 
 #endif
 
+PRIVATE int
+findpath_saddle(vrna_fold_compound_t  *vc,
+                short                 *pt1,
+                short                 *pt2,
+                int                   width,
+                int                   maxE,
+                move_t                **path,
+                int                   *path_fwd);
+
+
 PRIVATE int
 find_path_once(vrna_fold_compound_t *vc,
                short                *pt1,
                short                *pt2,
                int                  maxl,
-               int                  maxE);
+               int                  maxE,
+               move_t               **path);
 
 
-PRIVATE int
+PRIVATE void
 try_moves(vrna_fold_compound_t  *vc,
-          intermediate_t        c,
+          findpath_search_t     *search,
+          int                   c,
           int                   maxE,
-          intermediate_t        *next,
-          int                   dist);
+          int                   d);
 
 
 /*
@@ -189,53 +269,79 @@ vrna_path_findpath_saddle_ub(vrna_fold_compound_t *vc,
                              int                  width,
                              int                  maxE)
 {
-  int     maxl;
-  short   *ptr, *pt1, *pt2;
-  move_t  *bestpath = NULL;
-  int     dir;
+  short *pt1, *pt2;
 
-  path_fwd  = dir = 0;
-  pt1       = vrna_ptable(s1);
-  pt2       = vrna_ptable(s2);
+  pt1   = vrna_ptable(s1);
+  pt2   = vrna_ptable(s2);
+  maxE  = findpath_saddle(vc, pt1, pt2, width, maxE, NULL, NULL);
 
-  maxl = 1;
-  do {
-    int saddleE;
-    path_fwd = !path_fwd;
-    if (maxl > width)
-      maxl = width;
+  free(pt1);
+  free(pt2);
 
-    if (path)
-      free(path);
+  return maxE;
+}
 
-    saddleE = find_path_once(vc, pt1, pt2, maxl, maxE);
-    if (saddleE < maxE) {
-      maxE = saddleE;
-      if (bestpath)
-        free(bestpath);
 
-      bestpath  = path;
-      path      = NULL;
-      dir       = path_fwd;
-    } else {
-      free(path);
-      path = NULL;
-    }
+PUBLIC int *
+vrna_path_findpath_saddle_batch(vrna_fold_compound_t  *fc,
+                                const char            **structures,
+                                int                   width)
+{
+  return vrna_path_findpath_saddle_batch_ub(fc, structures, width, INT_MAX - 1);
+}
 
-    ptr   = pt1;
-    pt1   = pt2;
-    pt2   = ptr;
-    maxl  *= 2;
-  } while (maxl < 2 * width);
 
-  /* (re)set some globals */
-  path      = bestpath;
-  path_fwd  = dir;
+PUBLIC int *
+vrna_path_findpath_saddle_batch_ub(vrna_fold_compound_t *fc,
+                                   const char           **structures,
+                                   int                  width,
+                                   int                  maxE)
+{
+  int   i, num, *saddles, threads;
+  short **pts;
 
-  free(pt1);
-  free(pt2);
+  if ((!fc) || (!structures))
+    return NULL;
 
-  return maxE;
+  for (num = 0; structures[num]; num++);
+
+  saddles = (int *)vrna_alloc(sizeof(int) * MAX2(1, (size_t)num * num));
+  pts     = (short **)vrna_alloc(sizeof(short *) * MAX2(1, num));
+
+  /*
+   *  Evaluating each structure prior to the actual path searches also prepares
+   *  any soft constraints, such that the fold compound remains unchanged by the
+   *  concurrent path searches below
+   */
+  for (i = 0; i < num; i++) {
+    pts[i]                = vrna_ptable(structures[i]);
+    saddles[i * num + i]  = MIN2(maxE, vrna_eval_structure_pt(fc, pts[i]));
+  }
+
+  threads = 1;
+
+#ifdef _OPENMP
+  threads = MAX2(1, fc->params->model_details.num_threads);
+#endif
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 1) num_threads(threads)
+#endif
+  for (i = 0; i < num - 1; i++) {
+    int j, E;
+    for (j = i + 1; j < num; j++) {
+      E                     = findpath_saddle(fc, pts[i], pts[j], width, maxE, NULL, NULL);
+      saddles[i * num + j]  = E;
+      saddles[j * num + i]  = E;
+    }
+  }
+
+  for (i = 0; i < num; i++)
+    free(pts[i]);
+
+  free(pts);
+
+  return saddles;
 }
 
 
@@ -314,11 +420,19 @@ findpath_method(vrna_fold_compound_t  *fc,
                 int                   maxE,
                 unsigned int          return_type)
 {
-  int         E, d;
+  short       *pt1, *pt2;
+  int         E, d, BP_dist, path_fwd;
   float       last_E;
+  move_t      *path;
   vrna_path_t *route = NULL;
 
-  E = vrna_path_findpath_saddle_ub(fc, s1, s2, width, maxE);
+  pt1     = vrna_ptable(s1);
+  pt2     = vrna_ptable(s2);
+  BP_dist = vrna_bp_distance(s1, s2);
+  E       = findpath_saddle(fc, pt1, pt2, width, maxE, &path, &path_fwd);
+
+  free(pt1);
+  free(pt2);
 
   /* did we find a better path than one with saddle maxE? */
   if (E < maxE) {
@@ -421,7 +535,6 @@ findpath_method(vrna_fold_compound_t  *fc,
   }
 
   free(path);
-  path = NULL;
 
   return route;
 }
@@ -473,47 +586,6 @@ vrna_path_direct_ub(vrna_fold_compound_t        *fc,
 
 #ifdef TEST_FINDPATH
 
-PUBLIC void
-print_path(const char *seq,
-           const char *struc)
-{
-  int   d;
-  char  *s;
-
-  s = strdup(struc);
-  if (cut_point == -1) {
-    printf("%s\n%s\n", seq, s);
-  }
-  /* printf("%s\n%s %6.2f\n", seq, s, vrna_eval_structure_simple(seq,s)); */
-  else {
-    char *pstruct, *pseq;
-    pstruct = vrna_cut_point_insert(s, cut_point);
-    pseq    = vrna_cut_point_insert(seq, cut_point);
-    printf("%s\n%s\n", pseq, pstruct);
-    /* printf("%s\n%s %6.2f\n", pseq, pstruct, vrna_eval_structure_simple(seq,s)); */
-    free(pstruct);
-    free(pseq);
-  }
-
-  qsort(path, BP_dist, sizeof(move_t), compare_moves_when);
-  for (d = 0; d < BP_dist; d++) {
-    int i, j;
-    i = path[d].i;
-    j = path[d].j;
-    if (i < 0) {
-      /* delete */
-      s[(-i) - 1] = s[(-j) - 1] = '.';
-    } else {
-      s[i - 1]  = '(';
-      s[j - 1]  = ')';
-    }
-
-    /* printf("%s %6.2f - %6.2f\n", s, vrna_eval_structure_simple(seq,s), path[d].E/100.0); */
-  }
-  free(s);
-}
-
-
 int
 main(int  argc,
      char *argv[])
@@ -557,13 +629,6 @@ main(int  argc,
   E = find_saddle(seq, s1, s2, maxkeep);
   printf("saddle_energy = %6.2f\n", E / 100.);
   if (verbose) {
-    if (path_fwd)
-      print_path(seq, s1);
-    else
-      print_path(seq, s2);
-
-    free(path);
-    path  = NULL;
     route = get_path(seq, s1, s2, maxkeep);
     for (r = route; r->s; r++) {
       if (cut_point == -1) {
@@ -604,65 +669,121 @@ usage(void)
  # STATIC helper functions below #
  #################################
  */
+
+/*
+ *  Run the breadth-limited search with increasing widths in alternating
+ *  directions, and return the lowest saddle energy found. If path is not
+ *  NULL, the moves of the best path are stored there, and path_fwd indicates
+ *  whether they lead from pt1 to pt2 (1), or vice versa (0)
+ */
 PRIVATE int
+findpath_saddle(vrna_fold_compound_t  *vc,
+                short                 *pt1,
+                short                 *pt2,
+                int                   width,
+                int                   maxE,
+                move_t                **path,
+                int                   *path_fwd)
+{
+  int     maxl, fwd, dir, saddleE;
+  short   *ptr;
+  move_t  *bestpath, *p;
+
+  bestpath  = NULL;
+  fwd       = dir = 0;
+  maxl      = 1;
+
+  do {
+    fwd = !fwd;
+    if (maxl > width)
+      maxl = width;
+
+    saddleE = find_path_once(vc, pt1, pt2, maxl, maxE, (path) ? &p : NULL);
+    if (saddleE < maxE) {
+      maxE = saddleE;
+      if (path) {
+        free(bestpath);
+        bestpath = p;
+      }
+
+      dir = fwd;
+    } else if (path) {
+      free(p);
+    }
+
+    ptr   = pt1;
+    pt1   = pt2;
+    pt2   = ptr;
+    maxl  *= 2;
+  } while (maxl < 2 * width);
+
+  if (path) {
+    *path     = bestpath;
+    *path_fwd = dir;
+  }
+
+  return maxE;
+}
+
+
+PRIVATE void
 try_moves(vrna_fold_compound_t  *vc,
-          intermediate_t        c,
+          findpath_search_t     *search,
+          int                   c,
           int                   maxE,
-          intermediate_t        *next,
-          int                   dist)
+          int                   d)
 {
-  int     *loopidx, len, num_next = 0, en, oldE;
-  move_t  *mv;
-  short   *pt;
-
-  len     = c.pt[0];
-  loopidx = vrna_loopidx_from_ptable(c.pt);
-  oldE    = c.Sen;
-  for (mv = c.moves; mv->i != 0; mv++) {
-    int i, j;
-    if (mv->when > 0)
+  int             *loopidx, m, i, j, en;
+  short           *pt;
+  char            *done;
+  intermediate_t  *state, cand;
+
+  state   = search->arena + search->beam + c;
+  pt      = search->pt + (size_t)c * (search->len + 1);
+  done    = search->done + (size_t)c * search->dist;
+  loopidx = vrna_loopidx_from_ptable(pt);
+
+  for (m = 0; m < search->dist; m++) {
+    if (done[m])
       continue;
 
-    i   = mv->i;
-    j   = mv->j;
-    pt  = (short *)vrna_alloc(sizeof(short) * (len + 1));
-    memcpy(pt, c.pt, (len + 1) * sizeof(short));
+    i = search->moves[m].i;
+    j = search->moves[m].j;
+
+    /* insert moves require i and j to be unpaired and to belong to the same loop */
+    if ((j > 0) &&
+        ((loopidx[i] != loopidx[j]) || (pt[i] != 0) || (pt[j] != 0)))
+      continue; /* llegal move, try next; */
+
+#ifdef LOOP_EN
+    en = state->curr_en + vrna_eval_move_pt(vc, pt, i, j);
+#else
     if (j < 0) {
-      /*it's a delete move */
       pt[-i]  = 0;
       pt[-j]  = 0;
+      en      = vrna_eval_structure_pt(vc, pt);
+      pt[-i]  = -j;
+      pt[-j]  = -i;
     } else {
-      /* insert move */
-      if ((loopidx[i] == loopidx[j]) && /* i and j belong to same loop */
-          (pt[i] == 0) && (pt[j] == 0)  /* ... and are unpaired */
-          ) {
-        pt[i] = j;
-        pt[j] = i;
-      } else {
-        free(pt);
-        continue; /* llegal move, try next; */
-      }
+      pt[i] = j;
+      pt[j] = i;
+      en    = vrna_eval_structure_pt(vc, pt);
+      pt[i] = 0;
+      pt[j] = 0;
     }
 
-#ifdef LOOP_EN
-    en = c.curr_en + vrna_eval_move_pt(vc, c.pt, i, j);
-#else
-    en = vrna_eval_structure_pt(vc, pt);
 #endif
     if (en < maxE) {
-      next[num_next].Sen      = (en > oldE) ? en : oldE;
-      next[num_next].curr_en  = en;
-      next[num_next].pt       = pt;
-      mv->when                = dist;
-      mv->E                   = en;
-      next[num_next++].moves  = copy_moves(c.moves);
-      mv->when                = 0;
-    } else {
-      free(pt);
+      cand.hash     = state->hash ^ search->keys[m];
+      cand.parent   = search->beam + c;
+      cand.move     = m;
+      cand.Sen      = (en > state->Sen) ? en : state->Sen;
+      cand.curr_en  = en;
+
+      add_candidate(search, &cand, (unsigned int)d);
     }
   }
   free(loopidx);
-  return num_next;
 }
 
 
@@ -671,115 +792,309 @@ find_path_once(vrna_fold_compound_t *vc,
                short                *pt1,
                short                *pt2,
                int                  maxl,
-               int                  maxE)
+               int                  maxE,
+               move_t               **path)
 {
-  move_t          *mlist;
-  int             i, len, d, dist = 0, result;
-  short           *pt;
-  intermediate_t  *current, *next;
+  int               d, k, num, result;
+  findpath_search_t *search;
+
+  search = search_init(pt1, pt2, maxl);
+
+  search->arena[0].Sen = search->arena[0].curr_en = vrna_eval_structure_pt(vc, pt1);
+
+  for (d = 1; d <= search->dist; d++) {
+    /* go through the distance classes */
+    search->num_next = 0;
 
-  len = (int)pt1[0];
-  pt  = vrna_ptable_copy(pt1);
+    /* candidates are de-duplicated on-the-fly by their structure hash */
+    for (k = 0; k < search->num_beam; k++)
+      try_moves(vc, search, k, maxE, d);
 
-  mlist = (move_t *)vrna_alloc(sizeof(move_t) * len); /* bp_dist < n */
+    if (search->num_next == 0)
+      break;
+
+    qsort(search->next, search->num_next, sizeof(intermediate_t), compare_energy);
+
+    num = MIN2(maxl, search->num_next);
+    resolve_ties(search, num);
+    update_beam(search, num);
+  }
+
+  if (d <= search->dist) {
+    /* no path with saddle below maxE */
+    if (path)
+      *path = NULL;
+
+    result = INT_MAX;
+  } else {
+    if (path) {
+      /* the best intermediate of the last distance class is the target, so we trace back its moves */
+      *path = (move_t *)vrna_alloc(sizeof(move_t) * (search->dist + 1));
+      memcpy(*path, search->moves, sizeof(move_t) * search->dist);
+
+      for (d = search->dist, k = search->beam; search->arena[k].parent >= 0; d--) {
+        (*path)[search->arena[k].move].when = d;
+        (*path)[search->arena[k].move].E    = search->arena[k].curr_en;
+        k                                   = search->arena[k].parent;
+      }
+    }
 
-  for (i = 1; i <= len; i++) {
-    if (pt[i] != pt2[i]) {
-      if (i < pt[i]) {
+    result = search->arena[search->beam].Sen;
+  }
+
+  search_free(search);
+
+  return result;
+}
+
+
+PRIVATE uint64_t
+move_key(int m)
+{
+  uint64_t z = ((uint64_t)m + 1) * 0x9e3779b97f4a7c15ULL;
+
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+
+PRIVATE findpath_search_t *
+search_init(short *pt1,
+            short *pt2,
+            int   maxl)
+{
+  int               i, dist, len;
+  size_t            num, size;
+  findpath_search_t *search;
+
+  search  = (findpath_search_t *)vrna_alloc(sizeof(findpath_search_t));
+  len     = (int)pt1[0];
+  maxl    = MAX2(maxl, 1);
+
+  search->moves = (move_t *)vrna_alloc(sizeof(move_t) * (len + 1)); /* bp_dist < n */
+
+  for (dist = 0, i = 1; i <= len; i++) {
+    if (pt1[i] != pt2[i]) {
+      if (i < pt1[i]) {
         /* need to delete this pair */
-        mlist[dist].i       = -i;
-        mlist[dist].j       = -pt[i];
-        mlist[dist++].when  = 0;
+        search->moves[dist].i       = -i;
+        search->moves[dist].j       = -pt1[i];
+        search->moves[dist++].when  = 0;
       }
 
       if (i < pt2[i]) {
         /* need to insert this pair */
-        mlist[dist].i       = i;
-        mlist[dist].j       = pt2[i];
-        mlist[dist++].when  = 0;
+        search->moves[dist].i       = i;
+        search->moves[dist].j       = pt2[i];
+        search->moves[dist++].when  = 0;
       }
     }
   }
 
-  BP_dist           = dist;
-  current           = (intermediate_t *)vrna_alloc(sizeof(intermediate_t) * (maxl + 1));
-  current[0].pt     = pt;
-  current[0].Sen    = current[0].curr_en = vrna_eval_structure_pt(vc, pt);
-  current[0].moves  = mlist;
-  next              = (intermediate_t *)vrna_alloc(sizeof(intermediate_t) * (dist * maxl + 1));
+  search->len   = len;
+  search->dist  = dist;
+  search->maxl  = maxl;
+  search->keys  = (uint64_t *)vrna_alloc(sizeof(uint64_t) * (dist + 1));
 
-  for (d = 1; d <= dist; d++) {
-    /* go through the distance classes */
-    int             c, u, num_next = 0;
-    intermediate_t  *cc;
-
-    for (c = 0; current[c].pt != NULL; c++)
-      num_next += try_moves(vc, current[c], maxE, next + num_next, d);
-    if (num_next == 0) {
-      for (cc = current; cc->pt != NULL; cc++)
-        free_intermediate(cc);
-      current[0].Sen = INT_MAX;
-      break;
-    }
+  for (i = 0; i < dist; i++)
+    search->keys[i] = move_key(i);
+
+  /* each distance class contributes at most maxl intermediates to the arena */
+  num                       = (size_t)maxl * dist;
+  search->arena             = (intermediate_t *)vrna_alloc(sizeof(intermediate_t) * (num + 1));
+  search->arena[0].parent   = -1;
+  search->arena[0].move     = -1;
+  search->num_arena         = 1;
+  search->beam              = 0;
+  search->num_beam          = 1;
+
+  search->pt        = (short *)vrna_alloc(sizeof(short) * maxl * (len + 1));
+  search->pt_next   = (short *)vrna_alloc(sizeof(short) * maxl * (len + 1));
+  search->done      = (char *)vrna_alloc(sizeof(char) * maxl * (dist + 1));
+  search->done_next = (char *)vrna_alloc(sizeof(char) * maxl * (dist + 1));
+  memcpy(search->pt, pt1, sizeof(short) * (len + 1));
+
+  /* each intermediate in the beam has less than dist successors */
+  search->next = (intermediate_t *)vrna_alloc(sizeof(intermediate_t) * (num + 1));
+
+  for (size = 16; size < 2 * num; size *= 2);
 
-    /* remove duplicates via sort|uniq
-     * if this becomes a bottleneck we can use a hash instead */
-    qsort(next, num_next, sizeof(intermediate_t), compare_ptable);
-    for (u = 0, c = 1; c < num_next; c++) {
-      if (memcmp(next[u].pt, next[c].pt, sizeof(short) * len) != 0)
-        next[++u] = next[c];
-      else
-        free_intermediate(next + c);
+  search->table       = (int *)vrna_alloc(sizeof(int) * size);
+  search->stamp       = (unsigned int *)vrna_alloc(sizeof(unsigned int) * size);
+  search->table_mask  = (unsigned int)(size - 1);
+
+  return search;
+}
+
+
+PRIVATE void
+search_free(findpath_search_t *search)
+{
+  free(search->moves);
+  free(search->keys);
+  free(search->arena);
+  free(search->pt);
+  free(search->pt_next);
+  free(search->done);
+  free(search->done_next);
+  free(search->next);
+  free(search->table);
+  free(search->stamp);
+  free(search->ties);
+  free(search->ties_pt);
+  free(search);
+}
+
+
+/*
+ *  Add a candidate for distance class d, unless the same structure has already
+ *  been reached with lower saddle (or current) energy. Among equal candidates,
+ *  the first one that was generated is kept.
+ */
+PRIVATE void
+add_candidate(findpath_search_t *search,
+              intermediate_t    *cand,
+              unsigned int      d)
+{
+  unsigned int    h;
+  intermediate_t  *other;
+
+  h = (unsigned int)(cand->hash ^ (cand->hash >> 32)) & search->table_mask;
+
+  while (search->stamp[h] == d) {
+    other = search->next + search->table[h];
+    if (other->hash == cand->hash) {
+      if ((cand->Sen < other->Sen) ||
+          ((cand->Sen == other->Sen) && (cand->curr_en < other->curr_en)))
+        *other = *cand;
+
+      return;
     }
-    num_next = u + 1;
-    qsort(next, num_next, sizeof(intermediate_t), compare_energy);
-    /* free the old stuff */
-    for (cc = current; cc->pt != NULL; cc++)
-      free_intermediate(cc);
-    for (u = 0; u < maxl && u < num_next; u++)
-      current[u] = next[u];
-    for (; u < num_next; u++)
-      free_intermediate(next + u);
-    num_next = 0;
+
+    h = (h + 1) & search->table_mask;
   }
-  free(next);
-  path    = current[0].moves;
-  result  = current[0].Sen;
-  free(current[0].pt);
-  free(current);
-  return result;
+
+  search->stamp[h]                  = d;
+  search->table[h]                  = search->num_next;
+  search->next[search->num_next++]  = *cand;
 }
 
 
 PRIVATE void
-free_intermediate(intermediate_t *i)
+candidate_ptable(findpath_search_t  *search,
+                 intermediate_t     *cand,
+                 short              *pt)
 {
-  free(i->pt);
-  free(i->moves);
-  i->pt     = NULL;
-  i->moves  = NULL;
-  i->Sen    = INT_MAX;
+  int i, j;
+
+  memcpy(pt,
+         search->pt + (size_t)(cand->parent - search->beam) * (search->len + 1),
+         sizeof(short) * (search->len + 1));
+
+  i = search->moves[cand->move].i;
+  j = search->moves[cand->move].j;
+
+  if (i < 0) {
+    /* delete */
+    pt[-i]  = 0;
+    pt[-j]  = 0;
+  } else {
+    pt[i] = j;
+    pt[j] = i;
+  }
 }
 
 
-PRIVATE int
-compare_ptable(const void *A,
-               const void *B)
+/*
+ *  Order candidates of equal energy among the first num ones by
+ *  their pair tables, to obtain a beam that does not depend on the
+ *  order the candidates were generated in
+ */
+PRIVATE void
+resolve_ties(findpath_search_t  *search,
+             int                num)
 {
-  intermediate_t  *a, *b;
-  int             c;
+  int             a, b, k;
+  intermediate_t  *next;
 
-  a = (intermediate_t *)A;
-  b = (intermediate_t *)B;
+  next = search->next;
 
-  c = memcmp(a->pt, b->pt, a->pt[0] * sizeof(short));
-  if (c != 0)
-    return c;
+  for (a = 0; a < num; a = b) {
+    for (b = a + 1;
+         (b < search->num_next) && (compare_energy(next + a, next + b) == 0);
+         b++);
 
-  if ((a->Sen - b->Sen) != 0)
-    return a->Sen - b->Sen;
+    if (b - a > 1) {
+      search->ties    = (tie_t *)vrna_realloc(search->ties, sizeof(tie_t) * (b - a));
+      search->ties_pt = (short *)vrna_realloc(search->ties_pt,
+                                              sizeof(short) * (b - a) * (search->len + 1));
 
-  return a->curr_en - b->curr_en;
+      for (k = 0; k < b - a; k++) {
+        search->ties[k].pt    = search->ties_pt + (size_t)k * (search->len + 1);
+        search->ties[k].state = next[a + k];
+        candidate_ptable(search, next + a + k, search->ties[k].pt);
+      }
+
+      qsort(search->ties, b - a, sizeof(tie_t), compare_ties);
+
+      for (k = 0; k < b - a; k++)
+        next[a + k] = search->ties[k].state;
+    }
+  }
+}
+
+
+/* make the first num candidates the new beam */
+PRIVATE void
+update_beam(findpath_search_t *search,
+            int               num)
+{
+  int             u, parent;
+  size_t          pt_size;
+  short           *pt;
+  char            *done;
+  intermediate_t  *cand;
+
+  pt_size = (size_t)search->len + 1;
+
+  for (u = 0; u < num; u++) {
+    cand    = search->next + u;
+    parent  = cand->parent - search->beam;
+
+    candidate_ptable(search, cand, search->pt_next + u * pt_size);
+
+    memcpy(search->done_next + (size_t)u * search->dist,
+           search->done + (size_t)parent * search->dist,
+           sizeof(char) * search->dist);
+    search->done_next[(size_t)u * search->dist + cand->move] = 1;
+
+    search->arena[search->num_arena + u] = *cand;
+  }
+
+  pt                = search->pt;
+  search->pt        = search->pt_next;
+  search->pt_next   = pt;
+  done              = search->done;
+  search->done      = search->done_next;
+  search->done_next = done;
+
+  search->beam      = search->num_arena;
+  search->num_beam  = num;
+  search->num_arena += num;
+}
+
+
+PRIVATE int
+compare_ties(const void *A,
+             const void *B)
+{
+  tie_t *a, *b;
+
+  a = (tie_t *)A;
+  b = (tie_t *)B;
+
+  return memcmp(a->pt, b->pt, a->pt[0] * sizeof(short));
 }
 
 
@@ -812,17 +1127,6 @@ compare_moves_when(const void *A,
 }
 
 
-PRIVATE move_t *
-copy_moves(move_t *mvs)
-{
-  move_t *new;
-
-  new = (move_t *)vrna_alloc(sizeof(move_t) * (BP_dist + 1));
-  memcpy(new, mvs, sizeof(move_t) * (BP_dist + 1));
-  return new;
-}
-
-
 /*
  *###########################################
  *# deprecated functions below              #
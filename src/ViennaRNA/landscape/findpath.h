@@ -155,6 +155,64 @@ vrna_path_findpath_ub(vrna_fold_compound_t  *fc,
                       int                   maxE);
 
 
+/**
+ *  @brief Find energies of the saddle points between all pairs of structures in a list (search only direct paths)
+ *
+ *  This function computes the saddle energies of the direct refolding paths between all
+ *  pairs of structures in the @p NULL terminated list @p structures, as
+ *  vrna_path_findpath_saddle() does for a single pair. The result is returned as a
+ *  symmetric matrix of size @f$ n \times n @f$ in row-major order, where @f$ n @f$ is the
+ *  number of structures. That is, the saddle energy for the pair of structures @f$ i @f$
+ *  and @f$ j @f$ (0-based) can be found at index @f$ i \cdot n + j @f$. The diagonal
+ *  holds the free energies of the structures themselves. Each pair is searched only once,
+ *  i.e. both entries for @f$ i < j @f$ contain the result of the search from structure
+ *  @f$ i @f$ to structure @f$ j @f$.
+ *
+ *  The path searches for different pairs are independent of each other. If
+ *  #vrna_md_t.num_threads of the fold compound's model details is larger than 1, they are
+ *  performed concurrently (only available when compiled with OpenMP support). The results
+ *  do not depend on the number of threads.
+ *
+ *  @see vrna_path_findpath_saddle_batch_ub(), vrna_path_findpath_saddle(), vrna_fold_compound(), #vrna_fold_compound_t
+ *
+ *  @param fc         The #vrna_fold_compound_t with precomputed sequence encoding and model details
+ *  @param structures A @p NULL terminated list of structures in dot-bracket notation
+ *  @param width      A number specifying how many strutures are being kept at each step during the search
+ *  @returns          The matrix of saddle energies in 10cal/mol (has to be free'd by the caller), or @p NULL on failure
+ */
+int *
+vrna_path_findpath_saddle_batch(vrna_fold_compound_t  *fc,
+                                const char            **structures,
+                                int                   width);
+
+
+/**
+ *  @brief Find energies of the saddle points between all pairs of structures in a list (search only direct paths)
+ *
+ *  This function is the upper-bound variant of vrna_path_findpath_saddle_batch(). The
+ *  upper bound @p maxE is shared by the path searches for all pairs of structures, and
+ *  prunes all intermediate structures with free energy of at least @p maxE from the
+ *  breadth-limited searches.
+ *
+ *  @warning  If no path with @f$E_{saddle} < E_{max}@f$ is found for a pair of structures,
+ *            the corresponding entry of the matrix is @p maxE. The same applies for the
+ *            diagonal entries of structures with free energy of at least @p maxE.
+ *
+ *  @see vrna_path_findpath_saddle_batch(), vrna_path_findpath_saddle_ub(), vrna_fold_compound(), #vrna_fold_compound_t
+ *
+ *  @param fc         The #vrna_fold_compound_t with precomputed sequence encoding and model details
+ *  @param structures A @p NULL terminated list of structures in dot-bracket notation
+ *  @param width      A number specifying how many strutures are being kept at each step during the search
+ *  @param maxE       An upper bound for the saddle point energies in 10cal/mol
+ *  @returns          The matrix of saddle energies in 10cal/mol (has to be free'd by the caller), or @p NULL on failure
+ */
+int *
+vrna_path_findpath_saddle_batch_ub(vrna_fold_compound_t *fc,
+                                   const char           **structures,
+                                   int                  width,
+                                   int                  maxE);
+
+
 #ifndef VRNA_DISABLE_BACKWARD_COMPATIBILITY
 
 /**
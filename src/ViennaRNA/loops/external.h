@@ -144,6 +144,21 @@ struct vrna_mx_pf_aux_el_s *
 vrna_exp_E_ext_fast_init(vrna_fold_compound_t *fc);
 
 
+/**
+ *  @brief  Adapt the auxiliary arrays to a sequence that has been extended at its 3' end
+ *
+ *  Grows the auxiliary arrays to the length of @p fc while keeping all of their
+ *  entries, and initializes the exterior loop contributions of all segments of the
+ *  additional columns that can only be unpaired, as vrna_exp_E_ext_fast_init() does
+ *  for all columns. Hence, the recursions may proceed with the additional columns.
+ *
+ *  @see vrna_exp_E_ext_fast_init(), vrna_cotrans_append()
+ */
+void
+vrna_exp_E_ext_fast_resize(vrna_fold_compound_t       *fc,
+                           struct vrna_mx_pf_aux_el_s *aux_mx);
+
+
 void
 vrna_exp_E_ext_fast_rotate(struct vrna_mx_pf_aux_el_s *aux_mx);
 
@@ -159,12 +174,84 @@ vrna_exp_E_ext_fast(vrna_fold_compound_t        *fc,
                     struct vrna_mx_pf_aux_el_s  *aux_mx);
 
 
+/**
+ *  @brief  Compute the auxiliary array entry of an exterior loop segment
+ *
+ *  This is the first part of vrna_exp_E_ext_fast(). It only stores the Boltzmann
+ *  weight of all exterior loop parts @f$[i,j]@f$ whose leftmost stem starts at
+ *  @f$i@f$ into the auxiliary array of column @f$j@f$.
+ *
+ *  @see vrna_exp_E_ext_fast_split(), vrna_exp_E_ext_fast()
+ */
+void
+vrna_exp_E_ext_fast_aux(vrna_fold_compound_t        *fc,
+                        int                         i,
+                        int                         j,
+                        struct vrna_mx_pf_aux_el_s  *aux_mx);
+
+
+/**
+ *  @brief  Decompose an exterior loop segment using the auxiliary arrays only
+ *
+ *  This is the second part of vrna_exp_E_ext_fast(). It requires that the auxiliary
+ *  array entries of all segments @f$[k,j]@f$ with @f$i \leq k \leq j@f$ have been
+ *  computed by vrna_exp_E_ext_fast_aux() already, and only reads from the auxiliary
+ *  arrays. Hence, once all entries of column @f$j@f$ are available, all segments
+ *  @f$[i,j]@f$ of that column can be decomposed concurrently.
+ *
+ *  @see vrna_exp_E_ext_fast_aux(), vrna_exp_E_ext_fast()
+ */
+FLT_OR_DBL
+vrna_exp_E_ext_fast_split(vrna_fold_compound_t        *fc,
+                          int                         i,
+                          int                         j,
+                          struct vrna_mx_pf_aux_el_s  *aux_mx);
+
+
 void
 vrna_exp_E_ext_fast_update(vrna_fold_compound_t       *fc,
                            int                        j,
                            struct vrna_mx_pf_aux_el_s *aux_mx);
 
 
+/**
+ *  @brief  Compute the partition functions of all prefixes @f$[1,j]@f$ of the sequence
+ *
+ *  Decomposes each prefix by its last stem @f$(i,j')@f$, or an unpaired last
+ *  nucleotide, and stores the partition function of @f$[1,j]@f$ in
+ *  @p fc->exp_matrices->q1k[j]. Only the base pair partition functions in
+ *  @p fc->exp_matrices->qb are read, hence, this function can be used for
+ *  banded matrices (see vrna_fold_compound_t.jindx_span) where the entries
+ *  @f$q_{1,j}@f$ are not available.
+ *
+ *  @note   Auxiliary grammar rules (vrna_gr_aux_t.cb_aux_exp_f) are only
+ *          evaluated for the prefixes @f$[1,j]@f$ themselves.
+ *
+ *  @see vrna_exp_E_ext_loop_3()
+ *
+ *  @param  fc  The fold compound with already filled base pair partition functions
+ *  @return     The partition function of the entire sequence
+ */
+FLT_OR_DBL
+vrna_exp_E_ext_loop_5(vrna_fold_compound_t *fc);
+
+
+/**
+ *  @brief  Compute the partition functions of all suffixes @f$[i,n]@f$ of the sequence
+ *
+ *  This is the counterpart of vrna_exp_E_ext_loop_5() that decomposes each suffix
+ *  by its first stem, or an unpaired first nucleotide, and stores the partition
+ *  function of @f$[i,n]@f$ in @p fc->exp_matrices->qln[i].
+ *
+ *  @see vrna_exp_E_ext_loop_5()
+ *
+ *  @param  fc  The fold compound with already filled base pair partition functions
+ *  @return     The partition function of the entire sequence
+ */
+FLT_OR_DBL
+vrna_exp_E_ext_loop_3(vrna_fold_compound_t *fc);
+
+
 /* End partition function interface */
 /**@}*/
 
@@ -12,6 +12,7 @@
 #include "ViennaRNA/fold_vars.h"
 #include "ViennaRNA/params/default.h"
 #include "ViennaRNA/utils/basic.h"
+#include "ViennaRNA/utils/higher_order_functions.h"
 #include "ViennaRNA/alphabet.h"
 #include "ViennaRNA/constraints/hard.h"
 #include "ViennaRNA/constraints/soft.h"
@@ -32,6 +33,7 @@
 #include "external_sc_pf.inc"
 
 struct vrna_mx_pf_aux_el_s {
+  int         length;   /* sequence length the arrays are allocated for */
   FLT_OR_DBL  *qq;
   FLT_OR_DBL  *qq1;
 
@@ -45,6 +47,13 @@ struct vrna_mx_pf_aux_el_s {
  #################################
  */
 
+PRIVATE INLINE FLT_OR_DBL
+exp_ext_stem_pair(vrna_fold_compound_t  *fc,
+                  int                   i,
+                  int                   j,
+                  FLT_OR_DBL            q);
+
+
 PRIVATE INLINE FLT_OR_DBL
 reduce_ext_ext_fast(vrna_fold_compound_t        *fc,
                     int                         i,
@@ -92,6 +101,26 @@ exp_E_ext_fast(vrna_fold_compound_t       *fc,
                struct vrna_mx_pf_aux_el_s *aux_mx);
 
 
+PRIVATE void
+exp_E_ext_fast_aux(vrna_fold_compound_t       *fc,
+                   int                        i,
+                   int                        j,
+                   struct vrna_mx_pf_aux_el_s *aux_mx,
+                   vrna_callback_hc_evaluate  *evaluate,
+                   struct default_data        *hc_dat_local,
+                   struct sc_wrapper_exp_ext  *sc_wrapper);
+
+
+PRIVATE FLT_OR_DBL
+exp_E_ext_fast_split(vrna_fold_compound_t       *fc,
+                     int                        i,
+                     int                        j,
+                     struct vrna_mx_pf_aux_el_s *aux_mx,
+                     vrna_callback_hc_evaluate  *evaluate,
+                     struct default_data        *hc_dat_local,
+                     struct sc_wrapper_exp_ext  *sc_wrapper);
+
+
 /*
  #################################
  # BEGIN OF FUNCTION DEFINITIONS #
@@ -149,6 +178,7 @@ vrna_exp_E_ext_fast_init(vrna_fold_compound_t *fc)
     /* allocate memory for helper arrays */
     aux_mx =
       (struct vrna_mx_pf_aux_el_s *)vrna_alloc(sizeof(struct vrna_mx_pf_aux_el_s));
+    aux_mx->length    = n;
     aux_mx->qq        = (FLT_OR_DBL *)vrna_alloc(sizeof(FLT_OR_DBL) * (n + 2));
     aux_mx->qq1       = (FLT_OR_DBL *)vrna_alloc(sizeof(FLT_OR_DBL) * (n + 2));
     aux_mx->qqu_size  = 0;
@@ -202,6 +232,56 @@ vrna_exp_E_ext_fast_init(vrna_fold_compound_t *fc)
 }
 
 
+PUBLIC void
+vrna_exp_E_ext_fast_resize(vrna_fold_compound_t       *fc,
+                           struct vrna_mx_pf_aux_el_s *aux_mx)
+{
+  unsigned int              u;
+  int                       i, j, n, n_old, turn, ij, *iidx;
+  FLT_OR_DBL                *q;
+  vrna_callback_hc_evaluate *evaluate;
+  struct default_data       hc_dat_local;
+  struct sc_wrapper_exp_ext sc_wrapper;
+
+  if ((fc) && (aux_mx) && (fc->hc->type != VRNA_HC_WINDOW) &&
+      ((int)fc->length > aux_mx->length)) {
+    n     = (int)fc->length;
+    n_old = aux_mx->length;
+    iidx  = fc->iindx;
+    turn  = fc->exp_params->model_details.min_loop_size;
+    q     = fc->exp_matrices->q;
+
+    /* entries beyond the previous length have never been written, just as after vrna_exp_E_ext_fast_init() */
+    aux_mx->qq  = (FLT_OR_DBL *)vrna_realloc(aux_mx->qq, sizeof(FLT_OR_DBL) * (n + 2));
+    aux_mx->qq1 = (FLT_OR_DBL *)vrna_realloc(aux_mx->qq1, sizeof(FLT_OR_DBL) * (n + 2));
+    memset(aux_mx->qq + n_old + 2, 0, sizeof(FLT_OR_DBL) * (n - n_old));
+    memset(aux_mx->qq1 + n_old + 2, 0, sizeof(FLT_OR_DBL) * (n - n_old));
+
+    for (u = 0; aux_mx->qqu && (u <= (unsigned int)aux_mx->qqu_size); u++) {
+      aux_mx->qqu[u] = (FLT_OR_DBL *)vrna_realloc(aux_mx->qqu[u], sizeof(FLT_OR_DBL) * (n + 2));
+      memset(aux_mx->qqu[u] + n_old + 2, 0, sizeof(FLT_OR_DBL) * (n - n_old));
+    }
+
+    aux_mx->length = n;
+
+    evaluate = prepare_hc_default(fc, &hc_dat_local);
+    init_sc_wrapper_ext(fc, &sc_wrapper);
+
+    /* segments of the additional columns that can only be unpaired */
+    for (j = n_old + 1; j <= n; j++)
+      for (i = MAX2(1, j - turn); i <= j; i++) {
+        ij    = iidx[i] - j;
+        q[ij] = reduce_ext_up_fast(fc, i, j, aux_mx, evaluate, &hc_dat_local, &sc_wrapper);
+
+        if ((fc->aux_grammar) && (fc->aux_grammar->cb_aux_exp_f))
+          q[ij] += fc->aux_grammar->cb_aux_exp_f(fc, i, j, fc->aux_grammar->data);
+      }
+
+    free_sc_wrapper_ext(&sc_wrapper);
+  }
+}
+
+
 PUBLIC void
 vrna_exp_E_ext_fast_rotate(struct vrna_mx_pf_aux_el_s *aux_mx)
 {
@@ -284,6 +364,61 @@ vrna_exp_E_ext_fast(vrna_fold_compound_t        *fc,
 }
 
 
+PUBLIC void
+vrna_exp_E_ext_fast_aux(vrna_fold_compound_t        *fc,
+                        int                         i,
+                        int                         j,
+                        struct vrna_mx_pf_aux_el_s  *aux_mx)
+{
+  vrna_callback_hc_evaluate *evaluate;
+  struct default_data       hc_dat_local;
+  struct sc_wrapper_exp_ext sc_wrapper;
+
+  if ((fc) && (aux_mx)) {
+    if (fc->hc->type == VRNA_HC_WINDOW)
+      evaluate = prepare_hc_default_window(fc, &hc_dat_local);
+    else
+      evaluate = prepare_hc_default(fc, &hc_dat_local);
+
+    init_sc_wrapper_ext(fc, &sc_wrapper);
+
+    exp_E_ext_fast_aux(fc, i, j, aux_mx, evaluate, &hc_dat_local, &sc_wrapper);
+
+    free_sc_wrapper_ext(&sc_wrapper);
+  }
+}
+
+
+PUBLIC FLT_OR_DBL
+vrna_exp_E_ext_fast_split(vrna_fold_compound_t        *fc,
+                          int                         i,
+                          int                         j,
+                          struct vrna_mx_pf_aux_el_s  *aux_mx)
+{
+  FLT_OR_DBL                q;
+  vrna_callback_hc_evaluate *evaluate;
+  struct default_data       hc_dat_local;
+  struct sc_wrapper_exp_ext sc_wrapper;
+
+  q = 0.;
+
+  if ((fc) && (aux_mx)) {
+    if (fc->hc->type == VRNA_HC_WINDOW)
+      evaluate = prepare_hc_default_window(fc, &hc_dat_local);
+    else
+      evaluate = prepare_hc_default(fc, &hc_dat_local);
+
+    init_sc_wrapper_ext(fc, &sc_wrapper);
+
+    q = exp_E_ext_fast_split(fc, i, j, aux_mx, evaluate, &hc_dat_local, &sc_wrapper);
+
+    free_sc_wrapper_ext(&sc_wrapper);
+  }
+
+  return q;
+}
+
+
 PUBLIC void
 vrna_exp_E_ext_fast_update(vrna_fold_compound_t       *fc,
                            int                        j,
@@ -313,6 +448,260 @@ vrna_exp_E_ext_fast_update(vrna_fold_compound_t       *fc,
 }
 
 
+PUBLIC FLT_OR_DBL
+vrna_exp_E_ext_loop_5(vrna_fold_compound_t *fc)
+{
+  int                       n, i, j, u, cnt, turn, max_d, *idx;
+  FLT_OR_DBL                *q1k, *qb, *scale, q_temp, qbt;
+  vrna_ud_t                 *domains_up;
+  vrna_callback_hc_evaluate *evaluate;
+  struct default_data       hc_dat_local;
+  struct sc_wrapper_exp_ext sc_wrapper;
+
+  if ((!fc) || (!fc->exp_matrices) || (!fc->exp_matrices->q1k) ||
+      (fc->hc->type == VRNA_HC_WINDOW))
+    return 0.;
+
+  n           = (int)fc->length;
+  idx         = fc->iindx;
+  turn        = fc->exp_params->model_details.min_loop_size;
+  max_d       = (fc->jindx_span) ? (int)fc->jindx_span + 1 : n;
+  q1k         = fc->exp_matrices->q1k;
+  qb          = fc->exp_matrices->qb;
+  scale       = fc->exp_matrices->scale;
+  domains_up  = fc->domains_up;
+  evaluate    = prepare_hc_default(fc, &hc_dat_local);
+
+  init_sc_wrapper_ext(fc, &sc_wrapper);
+
+  q1k[0] = 1.;
+
+  for (j = 1; j <= n; j++) {
+    qbt = 0.;
+
+    /* nucleotide j is unpaired */
+    if (evaluate(1, j, 1, j - 1, VRNA_DECOMP_EXT_EXT, &hc_dat_local)) {
+      q_temp = q1k[j - 1] * scale[1];
+
+      if (sc_wrapper.red_ext)
+        q_temp *= sc_wrapper.red_ext(1, j, 1, j - 1, &sc_wrapper);
+
+      qbt += q_temp;
+    }
+
+    /* segment [j - u + 1, j] is occupied by an unstructured domain */
+    if ((domains_up) && (domains_up->exp_energy_cb)) {
+      for (cnt = 0; cnt < domains_up->uniq_motif_count; cnt++) {
+        u = domains_up->uniq_motif_size[cnt];
+        if ((j - u >= 0) &&
+            (evaluate(1, j, 1, j - u, VRNA_DECOMP_EXT_EXT, &hc_dat_local))) {
+          q_temp = q1k[j - u] *
+                   domains_up->exp_energy_cb(fc,
+                                             j - u + 1,
+                                             j,
+                                             VRNA_UNSTRUCTURED_DOMAIN_EXT_LOOP | VRNA_UNSTRUCTURED_DOMAIN_MOTIF,
+                                             domains_up->data) *
+                   scale[u];
+
+          if (sc_wrapper.red_ext)
+            q_temp *= sc_wrapper.red_ext(1, j, 1, j - u, &sc_wrapper);
+
+          qbt += q_temp;
+        }
+      }
+    }
+
+    /* nucleotide j pairs with i, all pairs (i, j) are within the band */
+    for (i = j - turn - 1; i >= MAX2(1, j - max_d); i--) {
+      if (qb[idx[i] - j] == 0.)
+        continue;
+
+      if (i == 1) {
+        if (evaluate(1, j, 1, j, VRNA_DECOMP_EXT_STEM, &hc_dat_local)) {
+          q_temp = exp_ext_stem_pair(fc, 1, j, qb[idx[1] - j]);
+
+          if (sc_wrapper.red_stem)
+            q_temp *= sc_wrapper.red_stem(1, j, 1, j, &sc_wrapper);
+
+          qbt += q_temp;
+        }
+      } else if (evaluate(1, j, i - 1, i, VRNA_DECOMP_EXT_EXT_STEM, &hc_dat_local)) {
+        q_temp = q1k[i - 1] *
+                 exp_ext_stem_pair(fc, i, j, qb[idx[i] - j]);
+
+        if (sc_wrapper.red_stem)
+          q_temp *= sc_wrapper.red_stem(i, j, i, j, &sc_wrapper);
+
+        if (sc_wrapper.split)
+          q_temp *= sc_wrapper.split(1, j, i, &sc_wrapper);
+
+        qbt += q_temp;
+      }
+    }
+
+    if ((fc->aux_grammar) && (fc->aux_grammar->cb_aux_exp_f))
+      qbt += fc->aux_grammar->cb_aux_exp_f(fc, 1, j, fc->aux_grammar->data);
+
+    q1k[j] = qbt;
+  }
+
+  free_sc_wrapper_ext(&sc_wrapper);
+
+  return q1k[n];
+}
+
+
+PUBLIC FLT_OR_DBL
+vrna_exp_E_ext_loop_3(vrna_fold_compound_t *fc)
+{
+  int                       n, i, j, u, cnt, turn, max_d, *idx;
+  FLT_OR_DBL                *qln, *qb, *scale, q_temp, qbt;
+  vrna_ud_t                 *domains_up;
+  vrna_callback_hc_evaluate *evaluate;
+  struct default_data       hc_dat_local;
+  struct sc_wrapper_exp_ext sc_wrapper;
+
+  if ((!fc) || (!fc->exp_matrices) || (!fc->exp_matrices->qln) ||
+      (fc->hc->type == VRNA_HC_WINDOW))
+    return 0.;
+
+  n           = (int)fc->length;
+  idx         = fc->iindx;
+  turn        = fc->exp_params->model_details.min_loop_size;
+  max_d       = (fc->jindx_span) ? (int)fc->jindx_span + 1 : n;
+  qln         = fc->exp_matrices->qln;
+  qb          = fc->exp_matrices->qb;
+  scale       = fc->exp_matrices->scale;
+  domains_up  = fc->domains_up;
+  evaluate    = prepare_hc_default(fc, &hc_dat_local);
+
+  init_sc_wrapper_ext(fc, &sc_wrapper);
+
+  qln[n + 1] = 1.;
+
+  for (i = n; i >= 1; i--) {
+    qbt = 0.;
+
+    /* nucleotide i is unpaired */
+    if (evaluate(i, n, i + 1, n, VRNA_DECOMP_EXT_EXT, &hc_dat_local)) {
+      q_temp = qln[i + 1] * scale[1];
+
+      if (sc_wrapper.red_ext)
+        q_temp *= sc_wrapper.red_ext(i, n, i + 1, n, &sc_wrapper);
+
+      qbt += q_temp;
+    }
+
+    /* segment [i, i + u - 1] is occupied by an unstructured domain */
+    if ((domains_up) && (domains_up->exp_energy_cb)) {
+      for (cnt = 0; cnt < domains_up->uniq_motif_count; cnt++) {
+        u = domains_up->uniq_motif_size[cnt];
+        if ((i + u <= n + 1) &&
+            (evaluate(i, n, i + u, n, VRNA_DECOMP_EXT_EXT, &hc_dat_local))) {
+          q_temp = qln[i + u] *
+                   domains_up->exp_energy_cb(fc,
+                                             i,
+                                             i + u - 1,
+                                             VRNA_UNSTRUCTURED_DOMAIN_EXT_LOOP | VRNA_UNSTRUCTURED_DOMAIN_MOTIF,
+                                             domains_up->data) *
+                   scale[u];
+
+          if (sc_wrapper.red_ext)
+            q_temp *= sc_wrapper.red_ext(i, n, i + u, n, &sc_wrapper);
+
+          qbt += q_temp;
+        }
+      }
+    }
+
+    /* nucleotide i pairs with j, all pairs (i, j) are within the band */
+    for (j = i + turn + 1; j <= MIN2(n, i + max_d); j++) {
+      if (qb[idx[i] - j] == 0.)
+        continue;
+
+      if (j == n) {
+        if (evaluate(i, n, i, n, VRNA_DECOMP_EXT_STEM, &hc_dat_local)) {
+          q_temp = exp_ext_stem_pair(fc, i, n, qb[idx[i] - n]);
+
+          if (sc_wrapper.red_stem)
+            q_temp *= sc_wrapper.red_stem(i, n, i, n, &sc_wrapper);
+
+          qbt += q_temp;
+        }
+      } else if (evaluate(i, n, j, j + 1, VRNA_DECOMP_EXT_STEM_EXT, &hc_dat_local)) {
+        q_temp = qln[j + 1] *
+                 exp_ext_stem_pair(fc, i, j, qb[idx[i] - j]);
+
+        if (sc_wrapper.red_stem)
+          q_temp *= sc_wrapper.red_stem(i, j, i, j, &sc_wrapper);
+
+        if (sc_wrapper.split)
+          q_temp *= sc_wrapper.split(i, n, j + 1, &sc_wrapper);
+
+        qbt += q_temp;
+      }
+    }
+
+    if ((fc->aux_grammar) && (fc->aux_grammar->cb_aux_exp_f))
+      qbt += fc->aux_grammar->cb_aux_exp_f(fc, i, n, fc->aux_grammar->data);
+
+    qln[i] = qbt;
+  }
+
+  free_sc_wrapper_ext(&sc_wrapper);
+
+  return qln[1];
+}
+
+
+PRIVATE INLINE FLT_OR_DBL
+exp_ext_stem_pair(vrna_fold_compound_t  *fc,
+                  int                   i,
+                  int                   j,
+                  FLT_OR_DBL            q)
+{
+  short             **S, **S5, **S3, *S1, *S2, s5, s3;
+  unsigned int      type, *sn, n, s, n_seq, **a2s;
+  int               circular;
+  vrna_exp_param_t  *pf_params;
+  vrna_md_t         *md;
+
+  n         = fc->length;
+  sn        = fc->strand_number;
+  pf_params = fc->exp_params;
+  md        = &(pf_params->model_details);
+  circular  = md->circ;
+
+  switch (fc->type) {
+    case VRNA_FC_TYPE_SINGLE:
+      S1    = fc->sequence_encoding;
+      S2    = fc->sequence_encoding2;
+      type  = vrna_get_ptype_md(S2[i], S2[j], md);
+      s5    = (((i > 1) || circular) && (sn[i] == sn[i - 1])) ? S1[i - 1] : -1;
+      s3    = (((j < n) || circular) && (sn[j + 1] == sn[j])) ? S1[j + 1] : -1;
+      q     *= vrna_exp_E_ext_stem(type, s5, s3, pf_params);
+      break;
+
+    case VRNA_FC_TYPE_COMPARATIVE:
+      n_seq = fc->n_seq;
+      S     = fc->S;
+      S5    = fc->S5;
+      S3    = fc->S3;
+      a2s   = fc->a2s;
+      for (s = 0; s < n_seq; s++) {
+        type  = vrna_get_ptype_md(S[s][i], S[s][j], md);
+        q     *= vrna_exp_E_ext_stem(type,
+                                     ((a2s[s][i] > 1) || circular) ? S5[s][i] : -1,
+                                     ((a2s[s][j] < a2s[s][S[0][0]]) || circular) ? S3[s][j] : -1,
+                                     pf_params);
+      }
+      break;
+  }
+
+  return q;
+}
+
+
 PRIVATE INLINE FLT_OR_DBL
 reduce_ext_ext_fast(vrna_fold_compound_t        *fc,
                     int                         i,
@@ -380,20 +769,11 @@ reduce_ext_stem_fast(vrna_fold_compound_t       *fc,
                      struct default_data        *hc_dat_local,
                      struct sc_wrapper_exp_ext  *sc_wrapper)
 {
-  short             **S, **S5, **S3, *S1, *S2, s5, s3;
-  unsigned int      type, *sn, n, s, n_seq, **a2s;
-  int               *idx, circular;
+  int               *idx;
   FLT_OR_DBL        qbt, q_temp, qb;
-  vrna_exp_param_t  *pf_params;
-  vrna_md_t         *md;
   sc_ext_exp_stem   *sc_red_stem;
 
   sc_red_stem = sc_wrapper->red_stem;
-  n           = fc->length;
-  sn          = fc->strand_number;
-  pf_params   = fc->exp_params;
-  md          = &(pf_params->model_details);
-  circular    = md->circ;
   idx         = fc->iindx;
   qb          = (fc->hc->type == VRNA_HC_WINDOW) ?
                 fc->exp_matrices->qb_local[i][j] :
@@ -402,33 +782,7 @@ reduce_ext_stem_fast(vrna_fold_compound_t       *fc,
 
   /* exterior loop part with stem (i, j) */
   if (evaluate(i, j, i, j, VRNA_DECOMP_EXT_STEM, hc_dat_local)) {
-    q_temp = qb;
-
-    switch (fc->type) {
-      case VRNA_FC_TYPE_SINGLE:
-        S1      = fc->sequence_encoding;
-        S2      = fc->sequence_encoding2;
-        type    = vrna_get_ptype_md(S2[i], S2[j], md);
-        s5      = (((i > 1) || circular) && (sn[i] == sn[i - 1])) ? S1[i - 1] : -1;
-        s3      = (((j < n) || circular) && (sn[j + 1] == sn[j])) ? S1[j + 1] : -1;
-        q_temp  *= vrna_exp_E_ext_stem(type, s5, s3, pf_params);
-        break;
-
-      case VRNA_FC_TYPE_COMPARATIVE:
-        n_seq = fc->n_seq;
-        S     = fc->S;
-        S5    = fc->S5;
-        S3    = fc->S3;
-        a2s   = fc->a2s;
-        for (s = 0; s < n_seq; s++) {
-          type    = vrna_get_ptype_md(S[s][i], S[s][j], md);
-          q_temp  *= vrna_exp_E_ext_stem(type,
-                                         ((a2s[s][i] > 1) || circular) ? S5[s][i] : -1,
-                                         ((a2s[s][j] < a2s[s][S[0][0]]) || circular) ? S3[s][j] : -1,
-                                         pf_params);
-        }
-        break;
-    }
+    q_temp = exp_ext_stem_pair(fc, i, j, qb);
 
     if (sc_red_stem)
       q_temp *= sc_red_stem(i, j, i, j, sc_wrapper);
@@ -546,10 +900,15 @@ split_ext_fast(vrna_fold_compound_t       *fc,
    *  strands in hard constraints, we have to think of something else...
    */
   if ((evaluate == &hc_default) || (evaluate == &hc_default_window)) {
-    for (k = j; k > i; k--) {
-      qbt += q[ij1] *
-             qqq[k];
-      ij1 -= factor;
+    if (j > i) {
+      if (factor == 1)
+        qbt += vrna_fun_zip_mul_add_sum(q + i,
+                                        qqq + i + 1,
+                                        j - i);
+      else  /* q[ij1] runs forward in memory while k decreases */
+        qbt += vrna_fun_zip_mul_add_sum_rev(q + ij1,
+                                            qqq + i + 1,
+                                            j - i);
     }
   } else {
     for (k = j; k > i; k--)
@@ -585,23 +944,11 @@ exp_E_ext_fast(vrna_fold_compound_t       *fc,
                int                        j,
                struct vrna_mx_pf_aux_el_s *aux_mx)
 {
-  int                       *iidx, ij, with_ud, with_gquad;
-  FLT_OR_DBL                qbt1, *qq, **qqu, *G, **G_local;
-  vrna_md_t                 *md;
-  vrna_exp_param_t          *pf_params;
-  vrna_ud_t                 *domains_up;
+  FLT_OR_DBL                qbt1;
   vrna_callback_hc_evaluate *evaluate;
   struct default_data       hc_dat_local;
   struct sc_wrapper_exp_ext sc_wrapper;
 
-  qq          = aux_mx->qq;
-  qqu         = aux_mx->qqu;
-  pf_params   = fc->exp_params;
-  md          = &(pf_params->model_details);
-  domains_up  = fc->domains_up;
-  with_gquad  = md->gquad;
-  with_ud     = (domains_up && domains_up->exp_energy_cb);
-
   if (fc->hc->type == VRNA_HC_WINDOW)
     evaluate = prepare_hc_default_window(fc, &hc_dat_local);
   else
@@ -609,12 +956,45 @@ exp_E_ext_fast(vrna_fold_compound_t       *fc,
 
   init_sc_wrapper_ext(fc, &sc_wrapper);
 
+  exp_E_ext_fast_aux(fc, i, j, aux_mx, evaluate, &hc_dat_local, &sc_wrapper);
+
+  qbt1 = exp_E_ext_fast_split(fc, i, j, aux_mx, evaluate, &hc_dat_local, &sc_wrapper);
+
+  free_sc_wrapper_ext(&sc_wrapper);
+
+  return qbt1;
+}
+
+
+/*
+ *  Store the contributions of all exterior loop parts [i,j]
+ *  with leftmost stem starting at i in the auxiliary array qq
+ */
+PRIVATE void
+exp_E_ext_fast_aux(vrna_fold_compound_t       *fc,
+                   int                        i,
+                   int                        j,
+                   struct vrna_mx_pf_aux_el_s *aux_mx,
+                   vrna_callback_hc_evaluate  *evaluate,
+                   struct default_data        *hc_dat_local,
+                   struct sc_wrapper_exp_ext  *sc_wrapper)
+{
+  int         *iidx, ij, with_ud, with_gquad;
+  FLT_OR_DBL  qbt1, *qq, **qqu, *G, **G_local;
+  vrna_ud_t   *domains_up;
+
+  qq          = aux_mx->qq;
+  qqu         = aux_mx->qqu;
+  domains_up  = fc->domains_up;
+  with_gquad  = fc->exp_params->model_details.gquad;
+  with_ud     = (domains_up && domains_up->exp_energy_cb);
+
   qbt1 = 0.;
 
   /* all exterior loop parts [i, j] with exactly one stem (i, u) i < u < j */
-  qbt1 += reduce_ext_ext_fast(fc, i, j, aux_mx, evaluate, &hc_dat_local, &sc_wrapper);
+  qbt1 += reduce_ext_ext_fast(fc, i, j, aux_mx, evaluate, hc_dat_local, sc_wrapper);
   /* exterior loop part with stem (i, j) */
-  qbt1 += reduce_ext_stem_fast(fc, i, j, aux_mx, evaluate, &hc_dat_local, &sc_wrapper);
+  qbt1 += reduce_ext_stem_fast(fc, i, j, aux_mx, evaluate, hc_dat_local, sc_wrapper);
 
   if (with_gquad) {
     if (fc->hc->type == VRNA_HC_WINDOW) {
@@ -632,18 +1012,35 @@ exp_E_ext_fast(vrna_fold_compound_t       *fc,
 
   if (with_ud)
     qqu[0][i] = qbt1;
+}
+
+
+/*
+ *  Decompose exterior loop part [i,j] using the auxiliary array
+ *  entries qq[k] for all i <= k <= j, which must be available already
+ */
+PRIVATE FLT_OR_DBL
+exp_E_ext_fast_split(vrna_fold_compound_t       *fc,
+                     int                        i,
+                     int                        j,
+                     struct vrna_mx_pf_aux_el_s *aux_mx,
+                     vrna_callback_hc_evaluate  *evaluate,
+                     struct default_data        *hc_dat_local,
+                     struct sc_wrapper_exp_ext  *sc_wrapper)
+{
+  FLT_OR_DBL qbt1;
+
+  qbt1 = aux_mx->qq[i];
 
   /* the entire stretch [i,j] is unpaired */
-  qbt1 += reduce_ext_up_fast(fc, i, j, aux_mx, evaluate, &hc_dat_local, &sc_wrapper);
+  qbt1 += reduce_ext_up_fast(fc, i, j, aux_mx, evaluate, hc_dat_local, sc_wrapper);
 
-  qbt1 += split_ext_fast(fc, i, j, aux_mx, evaluate, &hc_dat_local, &sc_wrapper);
+  qbt1 += split_ext_fast(fc, i, j, aux_mx, evaluate, hc_dat_local, sc_wrapper);
 
   /* apply auxiliary grammar rule for exterior loop case */
   if ((fc->aux_grammar) && (fc->aux_grammar->cb_aux_exp_f))
     qbt1 += fc->aux_grammar->cb_aux_exp_f(fc, i, j, fc->aux_grammar->data);
 
-  free_sc_wrapper_ext(&sc_wrapper);
-
   return qbt1;
 }
 
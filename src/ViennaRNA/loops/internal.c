@@ -10,6 +10,7 @@
 #include "ViennaRNA/fold_vars.h"
 #include "ViennaRNA/alphabet.h"
 #include "ViennaRNA/utils/basic.h"
+#include "ViennaRNA/utils/higher_order_functions.h"
 #include "ViennaRNA/constraints/hard.h"
 #include "ViennaRNA/constraints/soft.h"
 #include "ViennaRNA/loops/external.h"
@@ -362,12 +363,13 @@ E_internal_loop(vrna_fold_compound_t  *fc,
                 int                   i,
                 int                   j)
 {
-  unsigned char         sliding_window, hc_decompose, *hc_mx, **hc_mx_local;
+  unsigned char         sliding_window, hc_decompose, **hc_mx_local;
   char                  *ptype, **ptype_local;
   short                 *S, **SS, **S5, **S3;
-  unsigned int          *sn, *ss, **a2s, n_seq, s, n;
+  unsigned int          *sn, *ss, **a2s, n_seq, s;
   int                   e, eee, *idx, ij, *c, *ggg, *rtype, with_ud, with_gquad, noclose,
                         *hc_up, **c_local, **ggg_local;
+  vrna_hc_t             *hc;
   vrna_param_t          *P;
   vrna_md_t             *md;
   vrna_ud_t             *domains_up;
@@ -380,14 +382,13 @@ E_internal_loop(vrna_fold_compound_t  *fc,
 
   e = INF;
 
-  n               = fc->length;
   sliding_window  = (fc->hc->type == VRNA_HC_WINDOW) ? 1 : 0;
   sn              = fc->strand_number;
   ss              = fc->strand_start;
   n_seq           = (fc->type == VRNA_FC_TYPE_SINGLE) ? 1 : fc->n_seq;
   idx             = fc->jindx;
   ij              = (sliding_window) ? 0 : idx[j] + i;
-  hc_mx           = (sliding_window) ? NULL : fc->hc->mx;
+  hc              = fc->hc;
   hc_mx_local     = (sliding_window) ? fc->hc->matrix_local : NULL;
   hc_up           = fc->hc->up_int;
   ptype           = (fc->type == VRNA_FC_TYPE_SINGLE) ? (sliding_window ? NULL : fc->ptype) : NULL;
@@ -409,10 +410,10 @@ E_internal_loop(vrna_fold_compound_t  *fc,
   with_ud     = ((domains_up) && (domains_up->energy_cb)) ? 1 : 0;
   with_gquad  = md->gquad;
 
-  hc_decompose = (sliding_window) ? hc_mx_local[i][j - i] : hc_mx[n * i + j];
+  hc_decompose = (sliding_window) ? hc_mx_local[i][j - i] : vrna_hc_mx_get(hc, i, j);
 
   if (hc_decompose & VRNA_CONSTRAINT_CONTEXT_INT_LOOP) {
-    unsigned int  type, type2, has_nick, *tt;
+    unsigned int  type, type2, has_nick, *tt, plain;
     int           k, l, kl, last_k, first_l, u1, u2, turn, noGUclosure;
 
     has_nick    = sn[i] != sn[j] ? 1 : 0;
@@ -439,7 +440,7 @@ E_internal_loop(vrna_fold_compound_t  *fc,
     l = j - 1;
     if (k < l) {
       kl            = (sliding_window) ? 0 : idx[l] + k;
-      hc_decompose  = (sliding_window) ? hc_mx_local[k][l - k] : hc_mx[n * k + l];
+      hc_decompose  = (sliding_window) ? hc_mx_local[k][l - k] : vrna_hc_mx_get(hc, k, l);
 
       if ((hc_decompose & VRNA_CONSTRAINT_CONTEXT_INT_LOOP_ENC) &&
           (evaluate(i, j, k, l, &hc_dat_local))) {
@@ -506,10 +507,8 @@ E_internal_loop(vrna_fold_compound_t  *fc,
         k   = i + 2;
         kl  = (sliding_window) ? 0 : idx[l] + k;
 
-        hc_mx += n * l;
-
         for (; k <= last_k; k++, u1++, kl++) {
-          hc_decompose = (sliding_window) ? hc_mx_local[k][l - k] : hc_mx[k];
+          hc_decompose = (sliding_window) ? hc_mx_local[k][l - k] : vrna_hc_mx_get(hc, l, k);
 
           if ((hc_decompose & VRNA_CONSTRAINT_CONTEXT_INT_LOOP_ENC) &&
               (evaluate(i, j, k, l, &hc_dat_local))) {
@@ -567,8 +566,6 @@ E_internal_loop(vrna_fold_compound_t  *fc,
             }
           }
         }
-
-        hc_mx -= n * l;
       }
 
       /* handle bulges in 3' side */
@@ -578,15 +575,14 @@ E_internal_loop(vrna_fold_compound_t  *fc,
         if (first_l < j - 1 - MAXLOOP)
           first_l = j - 1 - MAXLOOP;
 
-        u2    = 1;
-        hc_mx += n * k;
+        u2 = 1;
 
         for (l = j - 2; l >= first_l; l--, u2++) {
           if (u2 > hc_up[l + 1])
             break;
 
           kl            = (sliding_window) ? 0 : idx[l] + k;
-          hc_decompose  = (sliding_window) ? hc_mx_local[k][l - k] : hc_mx[l];
+          hc_decompose  = (sliding_window) ? hc_mx_local[k][l - k] : vrna_hc_mx_get(hc, k, l);
 
           if ((hc_decompose & VRNA_CONSTRAINT_CONTEXT_INT_LOOP_ENC) &&
               (evaluate(i, j, k, l, &hc_dat_local))) {
@@ -644,10 +640,18 @@ E_internal_loop(vrna_fold_compound_t  *fc,
             }
           }
         }
-
-        hc_mx -= n * k;
       }
 
+      /*
+       *  for plain single sequence folding, the generic internal loops of each
+       *  row l are reduced with the dispatched zip_add_min() kernel
+       */
+      plain = ((fc->type == VRNA_FC_TYPE_SINGLE) &&
+               (!sliding_window) &&
+               (!has_nick) &&
+               (!with_ud) &&
+               (!sc_wrapper.pair)) ? 1 : 0;
+
       /* last but not least, all other internal loops */
       first_l = i + 2 + turn + 1;
       if (first_l < j - 1 - MAXLOOP)
@@ -670,10 +674,29 @@ E_internal_loop(vrna_fold_compound_t  *fc,
         k   = i + 2;
         kl  = (sliding_window) ? 0 : idx[l] + k;
 
-        hc_mx += n * l;
+        if ((plain) && (k <= last_k)) {
+          int e_loop[MAXLOOP + 1];
+
+          for (; k <= last_k; k++, u1++, kl++) {
+            e_loop[u1 - 1] = INF;
+
+            if ((vrna_hc_mx_get(hc, l, k) & VRNA_CONSTRAINT_CONTEXT_INT_LOOP_ENC) &&
+                (evaluate(i, j, k, l, &hc_dat_local))) {
+              type2 = rtype[vrna_get_ptype(kl, ptype)];
+
+              if ((noGUclosure) && (type2 == 3 || type2 == 4))
+                continue;
+
+              e_loop[u1 - 1] = E_IntLoop(u1, u2, type, type2, S[i + 1], S[j - 1], S[k - 1], S[l + 1], P);
+            }
+          }
+
+          eee = vrna_fun_zip_add_min(c + idx[l] + i + 2, e_loop, u1 - 1);
+          e   = MIN2(e, eee);
+        }
 
         for (; k <= last_k; k++, u1++, kl++) {
-          hc_decompose = (sliding_window) ? hc_mx_local[k][l - k] : hc_mx[k];
+          hc_decompose = (sliding_window) ? hc_mx_local[k][l - k] : vrna_hc_mx_get(hc, l, k);
 
           if ((hc_decompose & VRNA_CONSTRAINT_CONTEXT_INT_LOOP_ENC) &&
               (evaluate(i, j, k, l, &hc_dat_local))) {
@@ -748,8 +771,6 @@ E_internal_loop(vrna_fold_compound_t  *fc,
             }
           }
         }
-
-        hc_mx -= n * l;
       }
 
       if (with_gquad) {
@@ -816,9 +837,10 @@ E_ext_internal_loop(vrna_fold_compound_t  *fc,
 {
   int                 q, p, e, s, u1, u2, qmin, energy,
                       n, *indx, *hc_up, *c, turn, n_seq;
-  unsigned char       *hc, eval_loop;
+  unsigned char       eval_loop;
   unsigned int        *tt;
   short               **SS;
+  vrna_hc_t           *hc;
   vrna_md_t           *md;
   vrna_param_t        *P;
   eval_hc             *evaluate;
@@ -829,7 +851,7 @@ E_ext_internal_loop(vrna_fold_compound_t  *fc,
   SS    = (fc->type == VRNA_FC_TYPE_SINGLE) ? NULL : fc->S;
   indx  = fc->jindx;
   c     = fc->matrices->c;
-  hc    = fc->hc->mx;
+  hc    = fc->hc;
   hc_up = fc->hc->up_int;
   P     = fc->params;
   md    = &(P->model_details);
@@ -841,7 +863,7 @@ E_ext_internal_loop(vrna_fold_compound_t  *fc,
   evaluate = prepare_hc_default(fc, &hc_dat_local);
 
   /* CONSTRAINED INTERIOR LOOP start */
-  if (hc[n * i + j] & VRNA_CONSTRAINT_CONTEXT_INT_LOOP) {
+  if (vrna_hc_mx_get(hc, i, j) & VRNA_CONSTRAINT_CONTEXT_INT_LOOP) {
     /* prepare necessary variables */
     if (fc->type == VRNA_FC_TYPE_COMPARATIVE) {
       tt = (unsigned int *)vrna_alloc(sizeof(unsigned int) * n_seq);
@@ -872,7 +894,7 @@ E_ext_internal_loop(vrna_fold_compound_t  *fc,
 
         int pq = indx[q] + p;
 
-        eval_loop = hc[n * p + q] & VRNA_CONSTRAINT_CONTEXT_INT_LOOP;
+        eval_loop = vrna_hc_mx_get(hc, p, q) & VRNA_CONSTRAINT_CONTEXT_INT_LOOP;
 
         if (eval_loop && evaluate(i, j, p, q, &hc_dat_local)) {
           energy = c[pq];
@@ -904,11 +926,12 @@ E_stack(vrna_fold_compound_t  *fc,
         int                   j)
 {
   unsigned char         sliding_window, hc_decompose_ij, hc_decompose_pq,
-                        *hc_mx, **hc_mx_local, eval_loop;
+                        **hc_mx_local, eval_loop;
   char                  *ptype, **ptype_local;
   short                 *S, **SS;
-  unsigned int          n, *sn, *ss, type, type_2;
+  unsigned int          *sn, *ss, type, type_2;
   int                   e, ij, pq, p, q, s, n_seq, *rtype, *indx;
+  vrna_hc_t             *hc;
   vrna_param_t          *P;
   vrna_md_t             *md;
   eval_hc               *evaluate;
@@ -917,7 +940,6 @@ E_stack(vrna_fold_compound_t  *fc,
 
   e               = INF;
   sliding_window  = (fc->hc->type == VRNA_HC_WINDOW) ? 1 : 0;
-  n               = fc->length;
   p               = i + 1;
   q               = j - 1;
   n_seq           = (fc->type == VRNA_FC_TYPE_SINGLE) ? 1 : fc->n_seq;
@@ -935,7 +957,7 @@ E_stack(vrna_fold_compound_t  *fc,
   md          = &(P->model_details);
   rtype       = &(md->rtype[0]);
   indx        = (sliding_window) ? NULL : fc->jindx;
-  hc_mx       = (sliding_window) ? NULL : fc->hc->mx;
+  hc          = fc->hc;
   hc_mx_local = (sliding_window) ? fc->hc->matrix_local : NULL;
   ij          = (sliding_window) ? 0 : indx[j] + i;
   pq          = (sliding_window) ? 0 : indx[q] + p;
@@ -943,8 +965,8 @@ E_stack(vrna_fold_compound_t  *fc,
 
   init_sc_wrapper(fc, &sc_wrapper);
 
-  hc_decompose_ij = (sliding_window) ? hc_mx_local[i][j - i] : hc_mx[n * i + j];
-  hc_decompose_pq = (sliding_window) ? hc_mx_local[p][q - p] : hc_mx[n * p + q];
+  hc_decompose_ij = (sliding_window) ? hc_mx_local[i][j - i] : vrna_hc_mx_get(hc, i, j);
+  hc_decompose_pq = (sliding_window) ? hc_mx_local[p][q - p] : vrna_hc_mx_get(hc, p, q);
 
   eval_loop = (hc_decompose_ij & VRNA_CONSTRAINT_CONTEXT_INT_LOOP_ENC) &&
               (hc_decompose_pq & VRNA_CONSTRAINT_CONTEXT_INT_LOOP);
@@ -35,6 +35,12 @@
 #include "multibranch_hc.inc"
 #include "multibranch_sc.inc"
 
+/*
+ *  Number of splits of the bonus array in E_ml_stems_fast() that are kept on
+ *  the stack. Only longer segments require a heap allocation
+ */
+#define ML_BONUS_STACK_SIZE   512
+
 /*
  #################################
  # PRIVATE FUNCTION DECLARATIONS #
@@ -1258,44 +1264,51 @@ E_ml_stems_fast(vrna_fold_compound_t  *fc,
     dmli  -= i;
   }
 
-  /* use fmi pointer that we may extend to include hard/soft constraints if necessary */
-  int *fmi_tmp = fmi;
+  /*
+   *  per-split bonus array that holds hard constraints (INF) and soft
+   *  constraint contributions, if necessary. This way, the reduction
+   *  below can still be performed by the dispatched SIMD kernels
+   */
+  int bonus_stack[ML_BONUS_STACK_SIZE], *bonus_mem, *bonus;
 
-  if (hc->f) {
-    fmi_tmp = (int *)vrna_alloc(sizeof(int) * (j - i + 2));
-    fmi_tmp -= i;
+  bonus_mem = NULL;
+  bonus     = NULL;
 
-    /* copy data */
-    for (k = i + 1 + turn; k <= j - 2 - turn; k++)
-      fmi_tmp[k] = fmi[k];
+  if ((hc->f) || (sc_wrapper.decomp_ml)) {
+    if (j - i + 2 <= ML_BONUS_STACK_SIZE) {
+      memset(bonus_stack, 0, sizeof(int) * (j - i + 2));
+      bonus = bonus_stack - i;
+    } else {
+      bonus_mem = (int *)vrna_alloc(sizeof(int) * (j - i + 2));
+      bonus     = bonus_mem - i;
+    }
 
     /* mask unavailable decompositions */
-    for (k = i + 1 + turn; k <= j - 2 - turn; k++)
-      if (!hc->f(i, j, k, k + 1, VRNA_DECOMP_ML_ML_ML, hc->data))
-        fmi_tmp[k] = INF;
-  }
-
-  if (sc_wrapper.decomp_ml) {
-    if (fmi_tmp == fmi) {
-      fmi_tmp = (int *)vrna_alloc(sizeof(int) * (j - i + 2));
-      fmi_tmp -= i;
-
-      /* copy data */
+    if (hc->f) {
       for (k = i + 1 + turn; k <= j - 2 - turn; k++)
-        fmi_tmp[k] = fmi[k];
+        if (!hc->f(i, j, k, k + 1, VRNA_DECOMP_ML_ML_ML, hc->data))
+          bonus[k] = INF;
     }
 
-    for (k = i + 1 + turn; k <= j - 2 - turn; k++)
-      if (fmi_tmp[k] != INF)
-        fmi_tmp[k] += sc_wrapper.decomp_ml(i, j, k, k + 1, &sc_wrapper);
+    if (sc_wrapper.decomp_ml) {
+      for (k = i + 1 + turn; k <= j - 2 - turn; k++)
+        if (bonus[k] != INF)
+          bonus[k] = sc_wrapper.decomp_ml(i, j, k, k + 1, &sc_wrapper);
+    }
   }
 
   /* modular decomposition -------------------------------*/
   if (sliding_window) {
     for (decomp = INF, k = i + 1 + turn; k <= j - 2 - turn; k++) {
-      if ((fmi_tmp[k] != INF) && (fm_local[k + 1][j - (k + 1)] != INF)) {
-        en      = fmi_tmp[k] + fm_local[k + 1][j - (k + 1)];
-        decomp  = MIN2(decomp, en);
+      if ((fmi[k] != INF) && (fm_local[k + 1][j - (k + 1)] != INF)) {
+        if ((bonus) && (bonus[k] == INF))
+          continue;
+
+        en = fmi[k] + fm_local[k + 1][j - (k + 1)];
+        if (bonus)
+          en += bonus[k];
+
+        decomp = MIN2(decomp, en);
       }
     }
   } else {
@@ -1321,8 +1334,12 @@ E_ml_stems_fast(vrna_fold_compound_t  *fc,
 
       const int count = last_nt - k + 1;
 
-      en      = vrna_fun_zip_add_min(fmi_tmp + k, fm + k1j, count);
-      decomp  = MIN2(decomp, en);
+      if (bonus)
+        en = vrna_fun_zip3_add_min(fmi + k, fm + k1j, bonus + k, count);
+      else
+        en = vrna_fun_zip_add_min(fmi + k, fm + k1j, count);
+
+      decomp = MIN2(decomp, en);
 
       /* advance counters by processed subsegment and add 1 for the split point between strands */
       k   += count + 1;
@@ -1335,10 +1352,7 @@ E_ml_stems_fast(vrna_fold_compound_t  *fc,
 
   /* end modular decomposition -------------------------------*/
 
-  if (fmi_tmp != fmi) {
-    fmi_tmp += i;
-    free(fmi_tmp);
-  }
+  free(bonus_mem);
 
   dmli[j] = decomp;               /* store for use in fast ML decompositon */
 
@@ -109,6 +109,18 @@ vrna_mx_pf_aux_ml_t
 vrna_exp_E_ml_fast_init(vrna_fold_compound_t *fc);
 
 
+/**
+ *  @brief  Adapt the auxiliary arrays to a sequence that has been extended at its 3' end
+ *
+ *  The multibranch loop counterpart of vrna_exp_E_ext_fast_resize().
+ *
+ *  @see vrna_exp_E_ml_fast_init(), vrna_cotrans_append()
+ */
+void
+vrna_exp_E_ml_fast_resize(vrna_fold_compound_t *fc,
+                          vrna_mx_pf_aux_ml_t  aux_mx);
+
+
 void
 vrna_exp_E_ml_fast_rotate(vrna_mx_pf_aux_ml_t aux_mx);
 
@@ -132,6 +144,40 @@ vrna_exp_E_ml_fast(vrna_fold_compound_t *fc,
                    vrna_mx_pf_aux_ml_t  aux_mx);
 
 
+/**
+ *  @brief  Compute the auxiliary array entry of a multibranch loop segment
+ *
+ *  This is the first part of vrna_exp_E_ml_fast(). It only stores the Boltzmann
+ *  weight of all multibranch loop parts @f$[i,j]@f$ whose leftmost stem starts at
+ *  @f$i@f$ into the auxiliary array of column @f$j@f$ (see vrna_exp_E_ml_fast_qqm()).
+ *
+ *  @see vrna_exp_E_ml_fast_split(), vrna_exp_E_ml_fast()
+ */
+void
+vrna_exp_E_ml_fast_aux(vrna_fold_compound_t *fc,
+                       int                  i,
+                       int                  j,
+                       vrna_mx_pf_aux_ml_t  aux_mx);
+
+
+/**
+ *  @brief  Decompose a multibranch loop segment using the auxiliary arrays only
+ *
+ *  This is the second part of vrna_exp_E_ml_fast(). It requires that the auxiliary
+ *  array entries of all segments @f$[k,j]@f$ with @f$i \leq k \leq j@f$ have been
+ *  computed by vrna_exp_E_ml_fast_aux() already, and only reads from the auxiliary
+ *  arrays. Hence, once all entries of column @f$j@f$ are available, all segments
+ *  @f$[i,j]@f$ of that column can be decomposed concurrently.
+ *
+ *  @see vrna_exp_E_ml_fast_aux(), vrna_exp_E_ml_fast()
+ */
+FLT_OR_DBL
+vrna_exp_E_ml_fast_split(vrna_fold_compound_t *fc,
+                         int                  i,
+                         int                  j,
+                         vrna_mx_pf_aux_ml_t  aux_mx);
+
+
 /* End partition function interface */
 /**@}*/
 
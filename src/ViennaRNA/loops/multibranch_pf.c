@@ -9,6 +9,7 @@
 #include <ctype.h>
 #include <string.h>
 #include "ViennaRNA/utils/basic.h"
+#include "ViennaRNA/utils/higher_order_functions.h"
 #include "ViennaRNA/fold_vars.h"
 #include "ViennaRNA/alphabet.h"
 #include "ViennaRNA/params/default.h"
@@ -30,6 +31,7 @@
 #include "multibranch_sc_pf.inc"
 
 struct vrna_mx_pf_aux_ml_s {
+  int         length;   /* sequence length the arrays are allocated for */
   FLT_OR_DBL  *qqm;
   FLT_OR_DBL  *qqm1;
 
@@ -58,6 +60,26 @@ exp_E_ml_fast(vrna_fold_compound_t        *fc,
               struct vrna_mx_pf_aux_ml_s  *aux_mx);
 
 
+PRIVATE void
+exp_E_ml_fast_aux(vrna_fold_compound_t        *fc,
+                  int                         i,
+                  int                         j,
+                  struct vrna_mx_pf_aux_ml_s  *aux_mx,
+                  vrna_callback_hc_evaluate   *evaluate,
+                  struct default_data         *hc_dat_local,
+                  struct sc_wrapper_exp_ml    *sc_wrapper);
+
+
+PRIVATE FLT_OR_DBL
+exp_E_ml_fast_split(vrna_fold_compound_t        *fc,
+                    int                         i,
+                    int                         j,
+                    struct vrna_mx_pf_aux_ml_s  *aux_mx,
+                    vrna_callback_hc_evaluate   *evaluate,
+                    struct default_data         *hc_dat_local,
+                    struct sc_wrapper_exp_ml    *sc_wrapper);
+
+
 /*
  #################################
  # BEGIN OF FUNCTION DEFINITIONS #
@@ -93,6 +115,53 @@ vrna_exp_E_ml_fast(vrna_fold_compound_t       *fc,
 }
 
 
+PUBLIC void
+vrna_exp_E_ml_fast_aux(vrna_fold_compound_t       *fc,
+                       int                        i,
+                       int                        j,
+                       struct vrna_mx_pf_aux_ml_s *aux_mx)
+{
+  vrna_callback_hc_evaluate *evaluate;
+  struct default_data       hc_dat_local;
+  struct sc_wrapper_exp_ml  sc_wrapper;
+
+  if ((fc) && (aux_mx)) {
+    evaluate = prepare_hc_default(fc, &hc_dat_local);
+    init_sc_wrapper_ml(fc, &sc_wrapper);
+
+    exp_E_ml_fast_aux(fc, i, j, aux_mx, evaluate, &hc_dat_local, &sc_wrapper);
+
+    free_sc_wrapper_ml(&sc_wrapper);
+  }
+}
+
+
+PUBLIC FLT_OR_DBL
+vrna_exp_E_ml_fast_split(vrna_fold_compound_t       *fc,
+                         int                        i,
+                         int                        j,
+                         struct vrna_mx_pf_aux_ml_s *aux_mx)
+{
+  FLT_OR_DBL                q;
+  vrna_callback_hc_evaluate *evaluate;
+  struct default_data       hc_dat_local;
+  struct sc_wrapper_exp_ml  sc_wrapper;
+
+  q = 0.;
+
+  if ((fc) && (aux_mx)) {
+    evaluate = prepare_hc_default(fc, &hc_dat_local);
+    init_sc_wrapper_ml(fc, &sc_wrapper);
+
+    q = exp_E_ml_fast_split(fc, i, j, aux_mx, evaluate, &hc_dat_local, &sc_wrapper);
+
+    free_sc_wrapper_ml(&sc_wrapper);
+  }
+
+  return q;
+}
+
+
 PUBLIC struct vrna_mx_pf_aux_ml_s *
 vrna_exp_E_ml_fast_init(vrna_fold_compound_t *fc)
 {
@@ -110,6 +179,7 @@ vrna_exp_E_ml_fast_init(vrna_fold_compound_t *fc)
     /* allocate memory for helper arrays */
     aux_mx =
       (struct vrna_mx_pf_aux_ml_s *)vrna_alloc(sizeof(struct vrna_mx_pf_aux_ml_s));
+    aux_mx->length    = n;
     aux_mx->qqm       = (FLT_OR_DBL *)vrna_alloc(sizeof(FLT_OR_DBL) * (n + 2));
     aux_mx->qqm1      = (FLT_OR_DBL *)vrna_alloc(sizeof(FLT_OR_DBL) * (n + 2));
     aux_mx->qqmu_size = 0;
@@ -165,6 +235,47 @@ vrna_exp_E_ml_fast_init(vrna_fold_compound_t *fc)
 }
 
 
+PUBLIC void
+vrna_exp_E_ml_fast_resize(vrna_fold_compound_t       *fc,
+                          struct vrna_mx_pf_aux_ml_s *aux_mx)
+{
+  int         i, j, n, n_old, u, turn, ij, *iidx;
+  FLT_OR_DBL  *qm;
+
+  if ((fc) && (aux_mx) && (fc->hc->type != VRNA_HC_WINDOW) &&
+      ((int)fc->length > aux_mx->length)) {
+    n     = (int)fc->length;
+    n_old = aux_mx->length;
+    iidx  = fc->iindx;
+    turn  = fc->exp_params->model_details.min_loop_size;
+    qm    = fc->exp_matrices->qm;
+
+    /* entries beyond the previous length have never been written, just as after vrna_exp_E_ml_fast_init() */
+    aux_mx->qqm   = (FLT_OR_DBL *)vrna_realloc(aux_mx->qqm, sizeof(FLT_OR_DBL) * (n + 2));
+    aux_mx->qqm1  = (FLT_OR_DBL *)vrna_realloc(aux_mx->qqm1, sizeof(FLT_OR_DBL) * (n + 2));
+    memset(aux_mx->qqm + n_old + 2, 0, sizeof(FLT_OR_DBL) * (n - n_old));
+    memset(aux_mx->qqm1 + n_old + 2, 0, sizeof(FLT_OR_DBL) * (n - n_old));
+
+    for (u = 0; aux_mx->qqmu && (u <= aux_mx->qqmu_size); u++) {
+      aux_mx->qqmu[u] = (FLT_OR_DBL *)vrna_realloc(aux_mx->qqmu[u], sizeof(FLT_OR_DBL) * (n + 2));
+      memset(aux_mx->qqmu[u] + n_old + 2, 0, sizeof(FLT_OR_DBL) * (n - n_old));
+    }
+
+    aux_mx->length = n;
+
+    /* segments of the additional columns that are too short for any stem */
+    for (j = n_old + 1; j <= n; j++)
+      for (i = MAX2(1, j - turn); i <= j; i++) {
+        ij      = iidx[i] - j;
+        qm[ij]  = 0.;
+
+        if ((fc->aux_grammar) && (fc->aux_grammar->cb_aux_exp_m))
+          qm[ij] += fc->aux_grammar->cb_aux_exp_m(fc, i, j, fc->aux_grammar->data);
+      }
+  }
+}
+
+
 PUBLIC void
 vrna_exp_E_ml_fast_rotate(struct vrna_mx_pf_aux_ml_s *aux_mx)
 {
@@ -337,9 +448,10 @@ exp_E_mb_loop_fast(vrna_fold_compound_t       *fc,
     k = i + 2;
 
     if (sliding_window) {
-      for (; k <= j - 1; k++, kl--)
-        temp += qm_local[i + 1][k - 1] *
-                qqm1_tmp[k];
+      if (k <= j - 1)
+        temp += vrna_fun_zip_mul_add_sum(qm_local[i + 1] + k - 1,
+                                         qqm1_tmp + k,
+                                         j - k);
     } else {
       kl = my_iindx[i + 1] - (i + 1);
       /*
@@ -351,9 +463,16 @@ exp_E_mb_loop_fast(vrna_fold_compound_t       *fc,
         /* limit for-loop to last nucleotide of 5' part strand */
         int stop = MIN2(j - 1, se[sn[k - 1]]);
 
-        for (; k <= stop; k++, kl--)
-          temp += qm[kl] *
-                  qqm1_tmp[k];
+        if (k <= stop) {
+          /* qm[kl] runs backwards in memory while k increases */
+          int count = stop - k + 1;
+
+          temp  += vrna_fun_zip_mul_add_sum_rev(qqm1_tmp + k,
+                                                qm + kl - count + 1,
+                                                count);
+          k     += count;
+          kl    -= count;
+        }
 
         k++;
         kl--;
@@ -384,26 +503,50 @@ exp_E_ml_fast(vrna_fold_compound_t        *fc,
               int                         j,
               struct vrna_mx_pf_aux_ml_s  *aux_mx)
 {
-  unsigned char             sliding_window;
-  short                     *S1, *S2, **SS, **S5, **S3;
-  unsigned int              *sn, *ss, *se, n_seq, s;
-  int                       n, *iidx, k, ij, kl, maxk, ii, with_ud, u, circular, with_gquad,
-                            *hc_up_ml, type;
-  FLT_OR_DBL                qbt1, temp, *qm, *qb, *qqm, *qqm1, **qqmu, q_temp, q_temp2, *G,
-                            *expMLbase, **qb_local, **qm_local, **G_local;
-  vrna_md_t                 *md;
-  vrna_exp_param_t          *pf_params;
-  vrna_ud_t                 *domains_up;
-  vrna_hc_t                 *hc;
+  FLT_OR_DBL                q;
   vrna_callback_hc_evaluate *evaluate;
   struct default_data       hc_dat_local;
   struct sc_wrapper_exp_ml  sc_wrapper;
 
+  evaluate = prepare_hc_default(fc, &hc_dat_local);
+
+  init_sc_wrapper_ml(fc, &sc_wrapper);
+
+  exp_E_ml_fast_aux(fc, i, j, aux_mx, evaluate, &hc_dat_local, &sc_wrapper);
+
+  q = exp_E_ml_fast_split(fc, i, j, aux_mx, evaluate, &hc_dat_local, &sc_wrapper);
+
+  free_sc_wrapper_ml(&sc_wrapper);
+
+  return q;
+}
+
+
+/*
+ *  Store the contributions of all multibranch loop parts [i,j]
+ *  with leftmost stem starting at i in the auxiliary array qqm
+ */
+PRIVATE void
+exp_E_ml_fast_aux(vrna_fold_compound_t        *fc,
+                  int                         i,
+                  int                         j,
+                  struct vrna_mx_pf_aux_ml_s  *aux_mx,
+                  vrna_callback_hc_evaluate   *evaluate,
+                  struct default_data         *hc_dat_local,
+                  struct sc_wrapper_exp_ml    *sc_wrapper)
+{
+  unsigned char     sliding_window;
+  short             *S1, *S2, **SS, **S5, **S3;
+  unsigned int      n_seq, s;
+  int               n, *iidx, ij, with_ud, u, circular, with_gquad, type;
+  FLT_OR_DBL        qbt1, *qb, *qqm, *qqm1, **qqmu, q_temp, q_temp2, *G, *expMLbase,
+                    **qb_local, **G_local;
+  vrna_md_t         *md;
+  vrna_exp_param_t  *pf_params;
+  vrna_ud_t         *domains_up;
+
   sliding_window  = (fc->hc->type == VRNA_HC_WINDOW) ? 1 : 0;
   n               = (int)fc->length;
-  sn              = fc->strand_number;
-  ss              = fc->strand_start;
-  se              = fc->strand_end;
   n_seq           = (fc->type == VRNA_FC_TYPE_SINGLE) ? 1 : fc->n_seq;
   SS              = (fc->type == VRNA_FC_TYPE_SINGLE) ? NULL : fc->S;
   S5              = (fc->type == VRNA_FC_TYPE_SINGLE) ? NULL : fc->S5;
@@ -413,36 +556,29 @@ exp_E_ml_fast(vrna_fold_compound_t        *fc,
   qqm             = aux_mx->qqm;
   qqm1            = aux_mx->qqm1;
   qqmu            = aux_mx->qqmu;
-  qm              = (sliding_window) ? NULL : fc->exp_matrices->qm;
   qb              = (sliding_window) ? NULL : fc->exp_matrices->qb;
   G               = (sliding_window) ? NULL : fc->exp_matrices->G;
-  qm_local        = (sliding_window) ? fc->exp_matrices->qm_local : NULL;
   qb_local        = (sliding_window) ? fc->exp_matrices->qb_local : NULL;
   G_local         = (sliding_window) ? fc->exp_matrices->G_local : NULL;
   expMLbase       = fc->exp_matrices->expMLbase;
   pf_params       = fc->exp_params;
   md              = &(pf_params->model_details);
-  hc              = fc->hc;
   domains_up      = fc->domains_up;
   circular        = md->circ;
   with_gquad      = md->gquad;
   with_ud         = (domains_up && domains_up->exp_energy_cb);
-  hc_up_ml        = hc->up_ml;
-  evaluate        = prepare_hc_default(fc, &hc_dat_local);
-
-  init_sc_wrapper_ml(fc, &sc_wrapper);
 
   qbt1    = 0;
   q_temp  = 0.;
 
   qqm[i] = 0.;
 
-  if (evaluate(i, j, i, j - 1, VRNA_DECOMP_ML_ML, &hc_dat_local)) {
+  if (evaluate(i, j, i, j - 1, VRNA_DECOMP_ML_ML, hc_dat_local)) {
     q_temp = qqm1[i] *
              expMLbase[1];
 
-    if (sc_wrapper.red_ml)
-      q_temp *= sc_wrapper.red_ml(i, j, i, j - 1, &sc_wrapper);
+    if (sc_wrapper->red_ml)
+      q_temp *= sc_wrapper->red_ml(i, j, i, j - 1, sc_wrapper);
 
     qqm[i] += q_temp;
   }
@@ -454,7 +590,7 @@ exp_E_ml_fast(vrna_fold_compound_t        *fc,
     for (cnt = 0; cnt < domains_up->uniq_motif_count; cnt++) {
       u = domains_up->uniq_motif_size[cnt];
       if (j - u >= i) {
-        if (evaluate(i, j, i, j - u, VRNA_DECOMP_ML_ML, &hc_dat_local)) {
+        if (evaluate(i, j, i, j - u, VRNA_DECOMP_ML_ML, hc_dat_local)) {
           q_temp2 = qqmu[u][i] *
                     domains_up->exp_energy_cb(fc,
                                               j - u + 1,
@@ -464,8 +600,8 @@ exp_E_ml_fast(vrna_fold_compound_t        *fc,
                                               domains_up->data) *
                     expMLbase[u];
 
-          if (sc_wrapper.red_ml)
-            q_temp2 *= sc_wrapper.red_ml(i, j, i, j - u, &sc_wrapper);
+          if (sc_wrapper->red_ml)
+            q_temp2 *= sc_wrapper->red_ml(i, j, i, j - u, sc_wrapper);
 
           q_temp += q_temp2;
         }
@@ -475,7 +611,7 @@ exp_E_ml_fast(vrna_fold_compound_t        *fc,
     qqm[i] += q_temp;
   }
 
-  if (evaluate(i, j, i, j, VRNA_DECOMP_ML_STEM, &hc_dat_local)) {
+  if (evaluate(i, j, i, j, VRNA_DECOMP_ML_STEM, hc_dat_local)) {
     qbt1 = (sliding_window) ? qb_local[i][j] : qb[ij];
 
     switch (fc->type) {
@@ -504,8 +640,8 @@ exp_E_ml_fast(vrna_fold_compound_t        *fc,
         break;
     }
 
-    if (sc_wrapper.red_stem)
-      qbt1 *= sc_wrapper.red_stem(i, j, i, j, &sc_wrapper);
+    if (sc_wrapper->red_stem)
+      qbt1 *= sc_wrapper->red_stem(i, j, i, j, sc_wrapper);
 
     qqm[i] += qbt1;
   }
@@ -518,6 +654,42 @@ exp_E_ml_fast(vrna_fold_compound_t        *fc,
 
   if (with_ud)
     qqmu[0][i] = qqm[i];
+}
+
+
+/*
+ *  Decompose multibranch loop part [i,j] using the auxiliary array
+ *  entries qqm[k] for all i <= k <= j, which must be available already
+ */
+PRIVATE FLT_OR_DBL
+exp_E_ml_fast_split(vrna_fold_compound_t        *fc,
+                    int                         i,
+                    int                         j,
+                    struct vrna_mx_pf_aux_ml_s  *aux_mx,
+                    vrna_callback_hc_evaluate   *evaluate,
+                    struct default_data         *hc_dat_local,
+                    struct sc_wrapper_exp_ml    *sc_wrapper)
+{
+  unsigned char sliding_window;
+  unsigned int  *sn, *ss, *se;
+  int           *iidx, k, kl, maxk, ii, with_ud, *hc_up_ml;
+  FLT_OR_DBL    temp, *qm, *qqm, *expMLbase, **qm_local;
+  vrna_ud_t     *domains_up;
+  vrna_hc_t     *hc;
+
+  sliding_window  = (fc->hc->type == VRNA_HC_WINDOW) ? 1 : 0;
+  sn              = fc->strand_number;
+  ss              = fc->strand_start;
+  se              = fc->strand_end;
+  iidx            = (sliding_window) ? NULL : fc->iindx;
+  qqm             = aux_mx->qqm;
+  qm              = (sliding_window) ? NULL : fc->exp_matrices->qm;
+  qm_local        = (sliding_window) ? fc->exp_matrices->qm_local : NULL;
+  expMLbase       = fc->exp_matrices->expMLbase;
+  hc              = fc->hc;
+  domains_up      = fc->domains_up;
+  with_ud         = (domains_up && domains_up->exp_energy_cb);
+  hc_up_ml        = hc->up_ml;
 
   /*
    *  construction of qm matrix containing multiple loop
@@ -532,13 +704,13 @@ exp_E_ml_fast(vrna_fold_compound_t        *fc,
 
     for (k = j; k > i; k--) {
       qqm_tmp[k] = qqm[k];
-      if (!evaluate(i, j, k - 1, k, VRNA_DECOMP_ML_ML_ML, &hc_dat_local))
+      if (!evaluate(i, j, k - 1, k, VRNA_DECOMP_ML_ML_ML, hc_dat_local))
         qqm_tmp[k] = 0.;
     }
   }
 
   /* apply soft constraints if necessary */
-  if (sc_wrapper.decomp_ml) {
+  if (sc_wrapper->decomp_ml) {
     if (qqm_tmp == qqm) {
       qqm_tmp = (FLT_OR_DBL *)vrna_alloc(sizeof(FLT_OR_DBL) * (j - i + 2));
       qqm_tmp -= i;
@@ -548,7 +720,7 @@ exp_E_ml_fast(vrna_fold_compound_t        *fc,
     }
 
     for (k = j; k > i; k--)
-      qqm_tmp[k] *= sc_wrapper.decomp_ml(i, j, k - 1, k, &sc_wrapper);
+      qqm_tmp[k] *= sc_wrapper->decomp_ml(i, j, k - 1, k, sc_wrapper);
   }
 
   /* finally, decompose segment */
@@ -556,18 +728,27 @@ exp_E_ml_fast(vrna_fold_compound_t        *fc,
   k     = j;
 
   if (sliding_window) {
-    for (; k > i; k--)
-      temp += qm_local[i][k - 1] *
-              qqm_tmp[k];
+    if (k > i)
+      temp += vrna_fun_zip_mul_add_sum(qm_local[i] + i,
+                                       qqm_tmp + i + 1,
+                                       k - i);
   } else {
     kl = iidx[i] - j + 1; /* ii-k=[i,k-1] */
 
     while (1) {
       /* limit for-loop to first nucleotide of 3' part strand */
       int stop = MAX2(i, ss[sn[k]]);
-      for (; k > stop; k--, kl++)
-        temp += qm[kl] *
-                qqm_tmp[k];
+
+      if (k > stop) {
+        /* qm[kl] runs forward in memory while k decreases */
+        int count = k - stop;
+
+        temp  += vrna_fun_zip_mul_add_sum_rev(qm + kl,
+                                              qqm_tmp + stop + 1,
+                                              count);
+        k     -= count;
+        kl    += count;
+      }
 
       k--;
       kl++;
@@ -605,12 +786,12 @@ exp_E_ml_fast(vrna_fold_compound_t        *fc,
     }
 
     for (k = maxk; k > i; k--)
-      if (!evaluate(i, j, k, j, VRNA_DECOMP_ML_ML, &hc_dat_local))
+      if (!evaluate(i, j, k, j, VRNA_DECOMP_ML_ML, hc_dat_local))
         qqm_tmp[k] = 0.;
   }
 
   /* apply soft constraints if necessary */
-  if (sc_wrapper.red_ml) {
+  if (sc_wrapper->red_ml) {
     if (qqm_tmp == qqm) {
       qqm_tmp = (FLT_OR_DBL *)vrna_alloc(sizeof(FLT_OR_DBL) * (j - i + 2));
       qqm_tmp -= i;
@@ -620,15 +801,14 @@ exp_E_ml_fast(vrna_fold_compound_t        *fc,
     }
 
     for (k = maxk; k > i; k--)
-      qqm_tmp[k] *= sc_wrapper.red_ml(i, j, k, j, &sc_wrapper);
+      qqm_tmp[k] *= sc_wrapper->red_ml(i, j, k, j, sc_wrapper);
   }
 
-  ii = maxk - i; /* length of unpaired stretch */
-
-  /* finally, decompose segment */
-  for (k = maxk; k > i; k--, ii--)
-    temp += expMLbase[ii] *
-            qqm_tmp[k];
+  /* finally, decompose segment (unpaired stretch of length k - i) */
+  if (maxk > i)
+    temp += vrna_fun_zip_mul_add_sum(expMLbase + 1,
+                                     qqm_tmp + i + 1,
+                                     maxk - i);
 
   if (with_ud) {
     ii = maxk - i; /* length of unpaired stretch */
@@ -651,7 +831,5 @@ exp_E_ml_fast(vrna_fold_compound_t        *fc,
   if ((fc->aux_grammar) && (fc->aux_grammar->cb_aux_exp_m))
     temp += fc->aux_grammar->cb_aux_exp_m(fc, i, j, fc->aux_grammar->data);
 
-  free_sc_wrapper_ml(&sc_wrapper);
-
   return temp + qqm[i];
 }
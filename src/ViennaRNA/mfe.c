@@ -37,6 +37,10 @@
 #include "ViennaRNA/alphabet.h"
 #include "ViennaRNA/mfe.h"
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 #ifdef __GNUC__
 # define INLINE inline
 #else
@@ -77,6 +81,15 @@ PRIVATE int
 fill_arrays(vrna_fold_compound_t *fc);
 
 
+#ifdef _OPENMP
+PRIVATE int
+fill_arrays_parallel(vrna_fold_compound_t *fc,
+                     int                  num_threads);
+
+
+#endif
+
+
 PRIVATE int
 postprocess_circular(vrna_fold_compound_t *fc,
                      sect                 bt_stack[],
@@ -265,6 +278,86 @@ vrna_backtrack5(vrna_fold_compound_t  *fc,
 }
 
 
+PUBLIC int
+vrna_mfe_fill_column(vrna_fold_compound_t *fc,
+                     unsigned int         j,
+                     int                  **DML,
+                     int                  **cc)
+{
+  int               i, k, jj, turn, uniq_ML, noLP, max_d, *indx, *c, *fML, *fM1;
+  struct aux_arrays *aux;
+
+  if ((!fc) || (!fc->matrices) || (!fc->matrices->c) || (!DML) ||
+      (fc->hc->type == VRNA_HC_WINDOW) ||
+      (j < 1) || (j > fc->length))
+    return 0;
+
+  jj      = (int)j;
+  indx    = fc->jindx;
+  uniq_ML = fc->params->model_details.uniq_ML;
+  noLP    = fc->params->model_details.noLP;
+  turn    = fc->params->model_details.min_loop_size;
+  c       = fc->matrices->c;
+  fML     = fc->matrices->fML;
+  fM1     = fc->matrices->fM1;
+  max_d   = (fc->jindx_span) ? (int)fc->jindx_span + 1 : (int)fc->length;
+
+  if ((noLP) && (!cc))
+    return 0;
+
+  /* init contributions */
+  for (i = MAX2(1, jj - turn); i <= jj; i++) {
+    c[indx[jj] + i] = fML[indx[jj] + i] = INF;
+    if (uniq_ML)
+      fM1[indx[jj] + i] = INF;
+
+    DML[0][i] = INF;
+    if (noLP)
+      cc[0][i] = INF;
+  }
+
+  aux = get_aux_arrays(fc->length);
+
+  for (i = jj - turn - 1; i >= MAX2(1, jj - max_d); i--) {
+    /* load row-wise helper values of rows i + 1 and i + 2 from the columns j - 1 and j - 2 */
+    aux->DMLi1[jj - 1]  = (i + 1 <= jj - 1) ? DML[1][i + 1] : INF;
+    aux->DMLi1[jj - 2]  = (i + 1 <= jj - 2) ? DML[2][i + 1] : INF;
+    aux->DMLi2[jj - 1]  = (i + 2 <= jj - 1) ? DML[1][i + 2] : INF;
+    aux->DMLi2[jj - 2]  = (i + 2 <= jj - 2) ? DML[2][i + 2] : INF;
+
+    if (noLP) {
+      aux->cc[jj]       = INF;
+      aux->cc1[jj - 1]  = (i + 1 <= jj - 1) ? cc[1][i + 1] : INF;
+    }
+
+    /* decompose subsegment [i, j] with pair (i, j) */
+    c[indx[jj] + i] = decompose_pair(fc, i, jj, aux);
+
+    if (noLP)
+      cc[0][i] = aux->cc[jj];
+
+    /* gather row i of fML matrix */
+    for (k = i; k < jj; k++)
+      aux->Fmi[k] = fML[indx[k] + i];
+
+    /* decompose subsegment [i, j] that is multibranch loop part with at least one branch */
+    fML[indx[jj] + i] = vrna_E_ml_stems_fast(fc, i, jj, aux->Fmi, aux->DMLi);
+    DML[0][i]         = aux->DMLi[jj];
+
+    /* decompose subsegment [i, j] that is multibranch loop part with exactly one branch */
+    if (uniq_ML)
+      fM1[indx[jj] + i] = E_ml_rightmost_stem(i, jj, fc);
+
+    if ((fc->aux_grammar) && (fc->aux_grammar->cb_aux))
+      fc->aux_grammar->cb_aux(fc, i, jj, fc->aux_grammar->data);
+  }
+
+  free_aux_arrays(aux);
+
+  return 1;
+}
+
+
 /*
  #####################################
  # BEGIN OF STATIC HELPER FUNCTIONS  #
@@ -275,7 +368,7 @@ vrna_backtrack5(vrna_fold_compound_t  *fc,
 PRIVATE int
 fill_arrays(vrna_fold_compound_t *fc)
 {
-  int               i, j, ij, length, turn, uniq_ML, *indx, *f5, *c, *fML, *fM1;
+  int               i, j, ij, length, turn, uniq_ML, max_d, *indx, *f5, *c, *fML, *fM1;
   vrna_param_t      *P;
   vrna_mx_mfe_t     *matrices;
   vrna_ud_t         *domains_up;
@@ -292,6 +385,21 @@ fill_arrays(vrna_fold_compound_t *fc)
   fML         = matrices->fML;
   fM1         = matrices->fM1;
   domains_up  = fc->domains_up;
+  /* banded matrices only store entries up to a maximum span */
+  max_d       = (fc->jindx_span) ? (int)fc->jindx_span + 1 : length;
+
+#ifdef _OPENMP
+  /*
+   *  use wavefront fill if requested, but only if neither an auxiliary
+   *  grammar nor unstructured domain callbacks are present, since they
+   *  rely on the sequential order
+   */
+  if ((P->model_details.num_threads > 1) &&
+      (!fc->aux_grammar) &&
+      (!(fc->domains_up && fc->domains_up->energy_cb)))
+    return fill_arrays_parallel(fc, P->model_details.num_threads);
+
+#endif
 
   /* allocate memory for all helper arrays */
   helper_arrays = get_aux_arrays(length);
@@ -321,7 +429,7 @@ fill_arrays(vrna_fold_compound_t *fc)
   }
 
   for (i = length - turn - 1; i >= 1; i--) {
-    for (j = i + turn + 1; j <= length; j++) {
+    for (j = i + turn + 1; (j <= length) && (j - i <= max_d); j++) {
       ij = indx[j] + i;
 
       /* decompose subsegment [i, j] with pair (i, j) */
@@ -352,6 +460,140 @@ fill_arrays(vrna_fold_compound_t *fc)
 }
 
 
+#ifdef _OPENMP
+
+/*
+ *  Fill DP matrices along the anti-diagonals, i.e. all sub-segments [i, j]
+ *  of equal span d = j - i are processed concurrently. Each thread keeps its
+ *  own set of auxiliary arrays. Since the row-wise helper values DMLi and cc
+ *  of the sequential implementation are only accessed at spans d - 2 to d - 4,
+ *  we store them in a small ring buffer of diagonals instead and copy the
+ *  required entries into the thread-local arrays prior to decomposition.
+ */
+#define DIAG_BUFFER_SIZE  5
+
+PRIVATE int
+fill_arrays_parallel(vrna_fold_compound_t *fc,
+                     int                  num_threads)
+{
+  int       i, j, d, k, length, turn, uniq_ML, noLP, max_d, *indx, *f5, *c, *fML, *fM1,
+            **DMLd, **ccd;
+  vrna_ud_t *domains_up;
+
+  length      = (int)fc->length;
+  indx        = fc->jindx;
+  uniq_ML     = fc->params->model_details.uniq_ML;
+  noLP        = fc->params->model_details.noLP;
+  turn        = fc->params->model_details.min_loop_size;
+  f5          = fc->matrices->f5;
+  c           = fc->matrices->c;
+  fML         = fc->matrices->fML;
+  fM1         = fc->matrices->fM1;
+  domains_up  = fc->domains_up;
+  max_d       = (fc->jindx_span) ? (int)fc->jindx_span + 1 : length;
+
+  if ((turn < 0) || (turn > length))
+    turn = length;
+
+  /* pre-processing ligand binding production rule(s) */
+  if (domains_up && domains_up->prod_cb)
+    domains_up->prod_cb(fc, domains_up->data);
+
+  /* prefill matrices with init contributions */
+  for (j = 1; j <= length; j++)
+    for (i = (j > turn ? (j - turn) : 1); i <= j; i++) {
+      c[indx[j] + i] = fML[indx[j] + i] = INF;
+      if (uniq_ML)
+        fM1[indx[j] + i] = INF;
+    }
+
+  if (length <= turn)
+    return 0;
+
+  /* ring buffers for diagonal-wise storage of DMLi and cc values */
+  DMLd  = (int **)vrna_alloc(sizeof(int *) * DIAG_BUFFER_SIZE);
+  ccd   = (int **)vrna_alloc(sizeof(int *) * DIAG_BUFFER_SIZE);
+  for (d = 0; d < DIAG_BUFFER_SIZE; d++) {
+    DMLd[d] = (int *)vrna_alloc(sizeof(int) * (length + 3));
+    ccd[d]  = (int *)vrna_alloc(sizeof(int) * (length + 3));
+    for (i = 0; i <= length + 2; i++)
+      DMLd[d][i] = ccd[d][i] = INF;
+  }
+
+#pragma omp parallel num_threads(num_threads) private(i, j, d, k)
+  {
+    int               *DML0, *DML2, *DML3, *DML4, *cc0, *cc2;
+    struct aux_arrays *aux;
+
+    /* thread-local helper arrays */
+    aux = get_aux_arrays(length);
+
+    for (d = turn + 1; (d < length) && (d <= max_d); d++) {
+      DML0  = DMLd[d % DIAG_BUFFER_SIZE];
+      DML2  = DMLd[(d + DIAG_BUFFER_SIZE - 2) % DIAG_BUFFER_SIZE];
+      DML3  = DMLd[(d + DIAG_BUFFER_SIZE - 3) % DIAG_BUFFER_SIZE];
+      DML4  = DMLd[(d + DIAG_BUFFER_SIZE - 4) % DIAG_BUFFER_SIZE];
+      cc0   = ccd[d % DIAG_BUFFER_SIZE];
+      cc2   = ccd[(d + DIAG_BUFFER_SIZE - 2) % DIAG_BUFFER_SIZE];
+
+#pragma omp for schedule(dynamic, 8)
+      for (i = 1; i <= length - d; i++) {
+        j = i + d;
+
+        /* load row-wise helper values of rows i + 1 and i + 2 */
+        aux->DMLi1[j - 1] = DML2[i + 1];
+        aux->DMLi1[j - 2] = DML3[i + 1];
+        aux->DMLi2[j - 1] = DML3[i + 2];
+        aux->DMLi2[j - 2] = DML4[i + 2];
+
+        if (noLP) {
+          aux->cc[j]      = INF;
+          aux->cc1[j - 1] = cc2[i + 1];
+        }
+
+        /* decompose subsegment [i, j] with pair (i, j) */
+        c[indx[j] + i] = decompose_pair(fc, i, j, aux);
+
+        if (noLP)
+          cc0[i] = aux->cc[j];
+
+        /* gather row i of fML matrix */
+        for (k = i; k < j; k++)
+          aux->Fmi[k] = fML[indx[k] + i];
+
+        /* decompose subsegment [i, j] that is multibranch loop part with at least one branch */
+        fML[indx[j] + i] = vrna_E_ml_stems_fast(fc, i, j, aux->Fmi, aux->DMLi);
+        DML0[i]          = aux->DMLi[j];
+
+        /* decompose subsegment [i, j] that is multibranch loop part with exactly one branch */
+        if (uniq_ML)
+          fM1[indx[j] + i] = E_ml_rightmost_stem(i, j, fc);
+      }
+      /* implicit barrier of the work-sharing construct above */
+    }
+
+    free_aux_arrays(aux);
+  }
+
+  for (d = 0; d < DIAG_BUFFER_SIZE; d++) {
+    free(DMLd[d]);
+    free(ccd[d]);
+  }
+  free(DMLd);
+  free(ccd);
+
+  /* calculate energies of 5' fragments */
+  (void)vrna_E_ext_loop_5(fc);
+
+  return f5[length];
+}
+
+
+#undef DIAG_BUFFER_SIZE
+
+#endif
+
+
 /* post-processing step for circular RNAs */
 PRIVATE int
 postprocess_circular(vrna_fold_compound_t *fc,
@@ -367,7 +609,7 @@ postprocess_circular(vrna_fold_compound_t *fc,
    * fM_d5 = multiloop region with >= 2 stems, extending to pos n-1
    *         (a pair (1,k) will form a 5' dangle with pos n)
    */
-  unsigned char *hard_constraints, eval;
+  unsigned char eval;
   char          *ptype;
   short         *S1, **SS, **S5, **S3;
   unsigned int  **a2s;
@@ -396,7 +638,6 @@ postprocess_circular(vrna_fold_compound_t *fc,
   scs               = (fc->type == VRNA_FC_TYPE_SINGLE) ? NULL : fc->scs;
   dangle_model      = md->dangles;
   turn              = md->min_loop_size;
-  hard_constraints  = hc->mx;
   my_c              = fc->matrices->c;
   my_fML            = fc->matrices->fML;
   fM2               = fc->matrices->fM2;
@@ -447,7 +688,7 @@ postprocess_circular(vrna_fold_compound_t *fc,
 
       ij = indx[j] + i;
 
-      if (!hard_constraints[length * i + j])
+      if (!vrna_hc_mx_get(hc, i, j))
         continue;
 
       /* exterior hairpin case */
@@ -710,7 +951,7 @@ postprocess_circular(vrna_fold_compound_t *fc,
       for (i = 2 * turn + 1; i < length - turn; i++) {
         if (c_tmp[i + 1] != INF) {
           /* obey internal hard constraints */
-          if (hard_constraints[length * length + i + 1] & VRNA_CONSTRAINT_CONTEXT_MB_LOOP) {
+          if (vrna_hc_mx_get(hc, length, i + 1) & VRNA_CONSTRAINT_CONTEXT_MB_LOOP) {
             tmp = 0;
             switch (fc->type) {
               case VRNA_FC_TYPE_SINGLE:
@@ -810,7 +1051,7 @@ postprocess_circular(vrna_fold_compound_t *fc,
       for (i = 2 * turn + 1; i < length - turn; i++) {
         if (c_tmp[i + 1] != INF) {
           /* obey internal hard constraints */
-          if ((hard_constraints[length * length + i + 1] & VRNA_CONSTRAINT_CONTEXT_MB_LOOP) &&
+          if ((vrna_hc_mx_get(hc, length, i + 1) & VRNA_CONSTRAINT_CONTEXT_MB_LOOP) &&
               (hc->up_ml[i])) {
             tmp = 0;
             switch (fc->type) {
@@ -900,7 +1141,7 @@ postprocess_circular(vrna_fold_compound_t *fc,
       /* add contributions for enclosing pair */
       for (i = turn + 1; i < length - turn; i++) {
         if (fmd5_tmp[i + 1] != INF) {
-          if (hard_constraints[length + i] & VRNA_CONSTRAINT_CONTEXT_MB_LOOP) {
+          if (vrna_hc_mx_get(hc, 1, i) & VRNA_CONSTRAINT_CONTEXT_MB_LOOP) {
             tmp = 0;
             switch (fc->type) {
               case VRNA_FC_TYPE_SINGLE:
@@ -998,7 +1239,7 @@ postprocess_circular(vrna_fold_compound_t *fc,
       for (i = turn + 1; i < length - turn; i++) {
         if (fmd5_tmp[i + 2] != INF) {
           /* obey internal hard constraints */
-          if ((hard_constraints[length + i] & VRNA_CONSTRAINT_CONTEXT_MB_LOOP) &&
+          if ((vrna_hc_mx_get(hc, 1, i) & VRNA_CONSTRAINT_CONTEXT_MB_LOOP) &&
               (hc->up_ml[i + 1])) {
             tmp = 0;
             switch (fc->type) {
@@ -1733,15 +1974,13 @@ decompose_pair(vrna_fold_compound_t *fc,
                struct aux_arrays    *aux)
 {
   unsigned char hc_decompose;
-  unsigned int  n;
   int           e, new_c, energy, stackEnergy, ij, dangle_model, noLP,
                 *DMLi1, *DMLi2, *cc, *cc1;
 
-  n             = fc->length;
   ij            = fc->jindx[j] + i;
   dangle_model  = fc->params->model_details.dangles;
   noLP          = fc->params->model_details.noLP;
-  hc_decompose  = fc->hc->mx[n * i + j];
+  hc_decompose  = vrna_hc_mx_get(fc->hc, i, j);
   DMLi1         = aux->DMLi1;
   DMLi2         = aux->DMLi2;
   cc            = aux->cc;
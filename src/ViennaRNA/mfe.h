@@ -99,6 +99,34 @@ vrna_mfe_dimer(vrna_fold_compound_t *vc,
                char                 *structure);
 
 
+/**
+ *  @brief  Fill a single column of the minimum free energy matrices
+ *
+ *  Computes the entries @f$ C_{ij} @f$, @f$ M_{ij} @f$, and @f$ M^1_{ij} @f$ (if present)
+ *  for all @f$ i < j @f$ from the columns left of @p j, which must be available already.
+ *  Since the multibranch loop decomposition relies on the minima of all splits
+ *  @f$ M_{ik} + M_{k+1,j} @f$ of the two previous columns, these minima are passed
+ *  as columns @p DML[1] (@f$ j - 1 @f$) and @p DML[2] (@f$ j - 2 @f$), indexed by @f$ i @f$,
+ *  and those of column @p j are written to @p DML[0]. Likewise, lonely pair restrictions
+ *  (see #vrna_md_t.noLP) require the canonical helper values of column @f$ j - 1 @f$ in
+ *  @p cc[1] and write those of column @p j to @p cc[0]. The exterior loop array
+ *  is not altered, see vrna_E_ext_loop_5().
+ *
+ *  @see  vrna_mfe(), vrna_cotrans_append()
+ *
+ *  @param  vc  The fold compound data structure with minimum free energy matrices
+ *  @param  j   The column to fill
+ *  @param  DML The multibranch loop split minima of the columns @f$ j, j - 1, j - 2 @f$
+ *  @param  cc  The canonical helper values of the columns @f$ j, j - 1 @f$ (may be @em NULL without lonely pair restrictions)
+ *  @return     1 on success, 0 upon any failure
+ */
+int
+vrna_mfe_fill_column(vrna_fold_compound_t *vc,
+                     unsigned int         j,
+                     int                  **DML,
+                     int                  **cc);
+
+
 /**
  * End basic MFE interface
  * @}
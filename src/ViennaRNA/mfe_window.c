@@ -65,6 +65,71 @@ typedef struct {
 } zscoring_dat;
 #endif
 
+/*
+ *  Minimum number of rows a single chunk is responsible for in the chunked
+ *  (parallel) and the streaming sliding window scan. The actual length also
+ *  scales with the window size to keep the re-computation in the overlapping
+ *  regions small.
+ */
+#define WINDOW_CHUNK_MIN_LENGTH     8192
+#define WINDOW_CHUNK_WINDOW_FACTOR  32
+
+/*
+ *  A single locally optimal structure that has been reported by a chunk of
+ *  the parallel sliding window scan but still awaits its hand-over to the
+ *  user-defined callback
+ */
+typedef struct {
+  int   start;
+  int   end;
+  char  *structure;
+  float en;
+  float zscore;
+} window_hit;
+
+/*
+ *  The state of the 3' -> 5' scan at a particular row, i.e. the last
+ *  backtraced structure that has not been reported yet, and the 3' free
+ *  energies f3 of the following window_size + 2 rows relative to the first
+ *  one, i.e. all rows the exterior loop decompositions may refer to. All
+ *  positions are given in coordinates of the full sequence
+ */
+typedef struct {
+  char    *prev;
+  int     prev_i;
+  int     prev_j;
+  int     prev_end;
+  int     prev_en;
+  double  prevz;
+  int     *f3;
+  int     num_f3;
+} window_state;
+
+/*
+ *  A chunk of the parallel sliding window scan. It covers rows lo to hi of
+ *  its own sub-sequence and has an overlap of (at least) 2 * window_size
+ *  nucleotides to the 3' end. The state of the scan at row hi + 1 is either
+ *  recorded (and later compared to the actual state provided by the
+ *  downstream chunk), or enforced (forced != 0) to reproduce the serial scan
+ */
+typedef struct {
+  int           offset;
+  int           length;
+  int           lo;
+  int           hi;
+  int           forced;
+  int           f3_bnd;
+  int           underflow_bnd;
+  int           en;
+  window_state  bnd;
+  window_state  end;
+  window_hit    *hits;
+  unsigned int  num_hits;
+  unsigned int  max_hits;
+} window_chunk;
+
+#include "ViennaRNA/sequence_stream.inc"
+
 /*
  #################################
  # GLOBAL VARIABLES              #
@@ -101,7 +166,128 @@ fill_arrays(vrna_fold_compound_t            *vc,
             zscoring_dat                    *z_dat,
             vrna_mfe_window_zscore_callback *cb_z,
 #endif
-            void                            *data);
+            void                            *data,
+            window_chunk                    *chunk);
+
+
+PRIVATE int
+chunk_length(int maxdist);
+
+
+PRIVATE void
+store_hit(int         start,
+          int         end,
+          const char  *structure,
+          float       en,
+          void        *data);
+
+
+#ifdef VRNA_WITH_SVM
+PRIVATE void
+store_hit_z(int         start,
+            int         end,
+            const char  *structure,
+            float       en,
+            float       zscore,
+            void        *data);
+
+
+#endif
+
+
+PRIVATE void
+chunk_setup(window_chunk  *chunk,
+            int           a,
+            int           b,
+            int           start,
+            int           end,
+            int           maxdist);
+
+
+PRIVATE void
+chunk_reset(window_chunk  *chunk,
+            int           maxdist);
+
+
+PRIVATE void
+chunk_enforce(window_chunk  *chunk,
+              window_state  *state,
+              int           maxdist);
+
+
+PRIVATE void
+chunk_free(window_chunk *chunk);
+
+
+PRIVATE int
+chunk_state_equal(window_state  *s1,
+                  window_state  *s2);
+
+
+PRIVATE void
+chunk_fold(const char   *sequence,
+           vrna_md_t    *md,
+           vrna_param_t *params,
+#ifdef VRNA_WITH_SVM
+           zscoring_dat *zsc_data,
+#endif
+           window_chunk *chunk);
+
+
+PRIVATE int
+chunk_verify(window_chunk *chunk,
+             window_state *state,
+             const char   *sequence,
+             vrna_param_t *params,
+#ifdef VRNA_WITH_SVM
+             zscoring_dat *zsc_data,
+#endif
+             int          maxdist);
+
+
+PRIVATE void
+chunk_report(window_chunk                    *chunk,
+             int                             *energy,
+             int                             *underflow,
+             vrna_mfe_window_callback        *cb,
+#ifdef VRNA_WITH_SVM
+             zscoring_dat                    *zsc_data,
+             vrna_mfe_window_zscore_callback *cb_z,
+#endif
+             void                            *data);
+
+
+PRIVATE vrna_param_t *
+chunk_params(const char *sequence,
+             int        length,
+             vrna_md_t  *md);
+
+
+#ifdef _OPENMP
+
+PRIVATE int
+chunked_scan_possible(vrna_fold_compound_t *fc);
+
+
+PRIVATE void
+chunk_init(window_chunk *chunk,
+           int          length,
+           int          maxdist,
+           int          num);
+
+
+PRIVATE int
+fill_arrays_chunked(vrna_fold_compound_t            *fc,
+                    int                             *underflow,
+                    vrna_mfe_window_callback        *cb,
+#ifdef VRNA_WITH_SVM
+                    zscoring_dat                    *zsc_data,
+                    vrna_mfe_window_zscore_callback *cb_z,
+#endif
+                    void                            *data);
+
+
+#endif
 
 
 PRIVATE void
@@ -145,7 +331,8 @@ allocate_dp_matrices(vrna_fold_compound_t *fc);
 
 
 PRIVATE INLINE void
-free_dp_matrices(vrna_fold_compound_t *fc);
+free_dp_matrices(vrna_fold_compound_t *fc,
+                 int                  i_min);
 
 
 PRIVATE INLINE void
@@ -236,10 +423,20 @@ vrna_mfe_window_cb(vrna_fold_compound_t     *vc,
     mfe_local += (float)energy / (100. * n_seq);
   } else {
 #ifdef VRNA_WITH_SVM
-    z_dat.with_zsc  = 0;
-    energy          = fill_arrays(vc, &underflow, cb, &z_dat, NULL, data);
+    z_dat.with_zsc = 0;
+#ifdef _OPENMP
+    if (chunked_scan_possible(vc))
+      energy = fill_arrays_chunked(vc, &underflow, cb, &z_dat, NULL, data);
+    else
+#endif
+    energy = fill_arrays(vc, &underflow, cb, &z_dat, NULL, data, NULL);
 #else
-    energy = fill_arrays(vc, &underflow, cb, data);
+#ifdef _OPENMP
+    if (chunked_scan_possible(vc))
+      energy = fill_arrays_chunked(vc, &underflow, cb, data);
+    else
+#endif
+    energy = fill_arrays(vc, &underflow, cb, data, NULL);
 #endif
     mfe_local = (underflow > 0) ? ((float)underflow * (float)(UNDERFLOW_CORRECTION)) / 100. : 0.;
     mfe_local += (float)energy / 100.;
@@ -249,6 +446,201 @@ vrna_mfe_window_cb(vrna_fold_compound_t     *vc,
 }
 
 
+/*
+ *  Streaming variant of the chunked scan. Chunks are read and folded from
+ *  5' to 3', and each chunk is kept until its downstream neighbor has been
+ *  folded. Only then, the state at its 3' boundary can be verified, and the
+ *  chunk is re-computed with the actual state enforced if necessary. Since
+ *  this may change the state at its 5' end, the verified chunk upstream is
+ *  held back as well and only reported once the next chunk is verified
+ */
+PUBLIC float
+vrna_mfe_window_stream(vrna_md_t                      *md_p,
+                       vrna_sequence_stream_callback  *read,
+                       void                           *read_data,
+                       vrna_mfe_window_callback       *cb,
+                       void                           *data)
+{
+  int             t, a, b, n, cnt, done, failed, pending, maxdist, body, num_threads, energy,
+                  underflow;
+  float           mfe_local;
+  window_chunk    *chunks, *chunk, prev, last;
+  vrna_md_t       md;
+  vrna_param_t    *P;
+  sequence_stream stream;
+
+#ifdef VRNA_WITH_SVM
+  zscoring_dat    z_dat;
+
+  z_dat.with_zsc = 0;
+#endif
+
+  if ((!read) || (!cb))
+    return (float)(INF / 100.);
+
+  if (md_p)
+    vrna_md_copy(&md, md_p);
+  else
+    vrna_md_set_default(&md);
+
+  if (md.window_size <= 0) {
+    vrna_message_warning("vrna_mfe_window_stream: "
+                         "Window size must be set in the model details");
+    return (float)(INF / 100.);
+  }
+
+  sequence_stream_init(&stream, read, read_data);
+
+  if (sequence_stream_fill(&stream, 1) == 0) {
+    /* empty sequence */
+    sequence_stream_free(&stream);
+    return 0.;
+  }
+
+#ifdef _OPENMP
+  num_threads = MAX2(1, md.num_threads);
+#else
+  num_threads = 1;
+#endif
+
+  maxdist   = md.window_size;
+  body      = chunk_length(maxdist);
+  chunks    = (window_chunk *)vrna_alloc(sizeof(window_chunk) * num_threads);
+  P         = NULL;
+  a         = 1;
+  done      = 0;
+  failed    = 0;
+  pending   = 0;
+  energy    = 0;
+  underflow = 0;
+
+  while ((!done) && (!failed)) {
+    /* release all nucleotides upstream of the chunks that await verification */
+    if (pending > 1)
+      sequence_stream_discard(&stream, prev.offset + 1);
+    else
+      sequence_stream_discard(&stream, (pending) ? last.offset + 1 : MAX2(1, a - 1));
+
+    /* read the next batch of chunks, each with a look-ahead of 2 * window_size */
+    for (cnt = 0; (cnt < num_threads) && (!done); cnt++) {
+      b = a + body - 1;
+      n = sequence_stream_fill(&stream, b + 2 * maxdist + 1);
+
+      /* let the last chunk finish the scan */
+      if (n <= b + 2 * maxdist) {
+        b     = n;
+        done  = 1;
+      }
+
+      chunk_setup(&(chunks[cnt]), a, b, MAX2(1, a - 1), MIN2(n, b + 2 * maxdist), maxdist);
+      a = b + 1;
+    }
+
+    if (!P)
+      P = chunk_params(stream.string + chunks[0].offset - stream.offset,
+                       chunks[0].length,
+                       &md);
+
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(num_threads) schedule(dynamic, 1)
+#endif
+    for (t = 0; t < cnt; t++) {
+#ifdef VRNA_WITH_SVM
+      chunk_fold(stream.string + chunks[t].offset - stream.offset,
+                 &(P->model_details),
+                 P,
+                 &z_dat,
+                 &(chunks[t]));
+#else
+      chunk_fold(stream.string + chunks[t].offset - stream.offset,
+                 &(P->model_details),
+                 P,
+                 &(chunks[t]));
+#endif
+    }
+
+    for (t = 0; t < cnt; t++) {
+      chunk = &(chunks[t]);
+
+      if (pending) {
+#ifdef VRNA_WITH_SVM
+        if ((!chunk_verify(&last, &(chunk->end), stream.string + last.offset - stream.offset,
+                           P, &z_dat, maxdist)) &&
+            (pending > 1) &&
+            (!chunk_verify(&prev, &(last.end), stream.string + prev.offset - stream.offset,
+                           P, &z_dat, maxdist))) {
+#else
+        if ((!chunk_verify(&last, &(chunk->end), stream.string + last.offset - stream.offset,
+                           P, maxdist)) &&
+            (pending > 1) &&
+            (!chunk_verify(&prev, &(last.end), stream.string + prev.offset - stream.offset,
+                           P, maxdist))) {
+#endif
+          /* the chunk upstream of prev has already been reported, so we can't fix it anymore */
+          vrna_message_warning("vrna_mfe_window_stream: "
+                               "Scan did not converge upstream of position %d",
+                               prev.offset + prev.lo);
+          failed = 1;
+          break;
+        }
+
+        /* the chunk upstream of last is verified for good now */
+        if (pending > 1) {
+#ifdef VRNA_WITH_SVM
+          chunk_report(&prev, &energy, &underflow, cb, &z_dat, NULL, data);
+#else
+          chunk_report(&prev, &energy, &underflow, cb, data);
+#endif
+          chunk_free(&prev);
+        }
+
+        prev    = last;
+        pending = 2;
+      } else {
+        pending = 1;
+      }
+
+      last = *chunk;
+    }
+  }
+
+  if (failed) {
+    for (; t < cnt; t++)
+      chunk_free(&(chunks[t]));
+  } else {
+    /* the 3' most chunk is exact by construction, and so is its verified upstream neighbor */
+#ifdef VRNA_WITH_SVM
+    if (pending > 1)
+      chunk_report(&prev, &energy, &underflow, cb, &z_dat, NULL, data);
+
+    chunk_report(&last, &energy, &underflow, cb, &z_dat, NULL, data);
+#else
+    if (pending > 1)
+      chunk_report(&prev, &energy, &underflow, cb, data);
+
+    chunk_report(&last, &energy, &underflow, cb, data);
+#endif
+  }
+
+  if (pending > 1)
+    chunk_free(&prev);
+
+  chunk_free(&last);
+
+  free(chunks);
+  free(P);
+  sequence_stream_free(&stream);
+
+  if (failed)
+    return (float)(INF / 100.);
+
+  mfe_local = (underflow > 0) ? ((float)underflow * (float)(UNDERFLOW_CORRECTION)) / 100. : 0.;
+  mfe_local += (float)energy / 100.;
+
+  return mfe_local;
+}
+
+
 #ifdef VRNA_WITH_SVM
 
 PUBLIC float
@@ -294,7 +686,13 @@ vrna_mfe_window_zscore_cb(vrna_fold_compound_t            *vc,
   /* keep track of how many times we were close to an integer underflow */
   underflow = 0;
 
-  energy = fill_arrays(vc, &underflow, NULL, &zsc_data, cb_z, data);
+#ifdef _OPENMP
+  if (chunked_scan_possible(vc))
+    energy = fill_arrays_chunked(vc, &underflow, NULL, &zsc_data, cb_z, data);
+  else
+#endif
+  energy = fill_arrays(vc, &underflow, NULL, &zsc_data, cb_z, data, NULL);
+
   svm_free_model_content(zsc_data.avg_model);
   svm_free_model_content(zsc_data.sd_model);
 
@@ -380,7 +778,8 @@ allocate_dp_matrices(vrna_fold_compound_t *fc)
 
 
 PRIVATE INLINE void
-free_dp_matrices(vrna_fold_compound_t *fc)
+free_dp_matrices(vrna_fold_compound_t *fc,
+                 int                  i_min)
 {
   int       i, length, maxdist, **c, **fML, **ggg, with_gquad;
   vrna_hc_t *hc;
@@ -395,8 +794,8 @@ free_dp_matrices(vrna_fold_compound_t *fc)
   with_gquad  = fc->params->model_details.gquad;
 
 
-  /* free additional memory for j-dimension */
-  for (i = 0; (i < maxdist + 5) && (i <= length); i++) {
+  /* free additional memory for j-dimension, rows start at i_min - 1 after the last rotation */
+  for (i = i_min - 1; (i < i_min + maxdist + 4) && (i <= length); i++) {
     if (fc->type == VRNA_FC_TYPE_SINGLE) {
       free(fc->ptype_local[i]);
       fc->ptype_local[i] = NULL;
@@ -418,14 +817,14 @@ free_dp_matrices(vrna_fold_compound_t *fc)
       sc = fc->sc;
       if (sc) {
         if (sc->energy_up) {
-          for (i = 0; (i < maxdist + 5) && (i <= length); i++) {
+          for (i = i_min - 1; (i < i_min + maxdist + 4) && (i <= length); i++) {
             free(sc->energy_up[i]);
             sc->energy_up[i] = NULL;
           }
         }
 
         if (sc->energy_bp_local) {
-          for (i = 0; (i < maxdist + 5) && (i <= length); i++) {
+          for (i = i_min - 1; (i < i_min + maxdist + 4) && (i <= length); i++) {
             free(sc->energy_bp_local[i]);
             sc->energy_bp_local[i] = NULL;
           }
@@ -439,7 +838,7 @@ free_dp_matrices(vrna_fold_compound_t *fc)
   }
 
   if (with_gquad) {
-    for (i = 0; (i <= maxdist + 5) && (i <= length); i++)
+    for (i = i_min - 1; (i <= i_min + maxdist + 4) && (i <= length); i++)
       free(ggg[i]);
     free(ggg);
     fc->matrices->ggg_local = NULL;
@@ -588,7 +987,8 @@ fill_arrays(vrna_fold_compound_t            *vc,
             zscoring_dat                    *zsc_data,
             vrna_mfe_window_zscore_callback *cb_z,
 #endif
-            void                            *data)
+            void                            *data,
+            window_chunk                    *chunk)
 {
   /* fill "c", "fML" and "f3" arrays and return  optimal energy */
 
@@ -597,7 +997,7 @@ fill_arrays(vrna_fold_compound_t            *vc,
   int           i, j, length, energy, maxdist, **c, **fML, *f3, no_close,
                 type, with_gquad, dangle_model, noLP, noGUclosure, turn,
                 *cc, *cc1, *Fmi, *DMLi, *DMLi1, *DMLi2, prev_i, prev_j,
-                prev_end, prev_en, new_c, stackEnergy;
+                prev_end, prev_en, new_c, stackEnergy, lo, seeded;
 
 #ifdef VRNA_WITH_SVM
   double        prevz;
@@ -623,6 +1023,7 @@ fill_arrays(vrna_fold_compound_t            *vc,
   prev_end      = 0;
   prev          = NULL;
   prev_en       = 0;
+  lo            = (chunk) ? chunk->lo : 1;
 #ifdef VRNA_WITH_SVM
   prevz = 0.;
 #endif
@@ -649,7 +1050,7 @@ fill_arrays(vrna_fold_compound_t            *vc,
   if (with_gquad)
     vrna_gquad_mx_local_update(vc, length - maxdist - 4);
 
-  for (i = length - turn - 1; i >= 1; i--) {
+  for (i = length - turn - 1; i >= lo; i--) {
     /* i,j in [1..length] */
     for (j = i + turn + 1; j <= length && j <= i + maxdist; j++) {
       hc_decompose  = hc->matrix_local[i][j - i];
@@ -705,10 +1106,19 @@ fill_arrays(vrna_fold_compound_t            *vc,
 
     /* calculate energies of 5' and 3' fragments */
     f3[i] = vrna_E_ext_loop_3(vc, i);
+
+    /*
+     *  in the chunked scan, rows beyond the boundary to the downstream chunk may
+     *  be replaced by their actual energies. No structures are backtraced there
+     */
+    seeded = ((chunk) && (chunk->forced) && (i > chunk->hi)) ? 1 : 0;
+    if ((seeded) && (i - chunk->hi - 1 < chunk->bnd.num_f3))
+      f3[i] = chunk->bnd.f3[i - chunk->hi - 1] - *underflow * UNDERFLOW_CORRECTION;
+
     {
       char *ss = NULL;
 
-      if (f3[i] < f3[i + 1]) {
+      if ((!seeded) && (f3[i] < f3[i + 1])) {
         /*
          * instead of backtracing in the next iteration, we backtrack now
          * already. This is necessary to accomodate for change in free
@@ -814,6 +1224,44 @@ fill_arrays(vrna_fold_compound_t            *vc,
         (*underflow)++;
       }
 
+      /* boundary to the downstream chunk reached */
+      if ((chunk) && (i == chunk->hi + 1)) {
+        window_state *bnd = &(chunk->bnd);
+
+        if (chunk->forced) {
+          /* continue with the actual state of the scan */
+          free(prev);
+          prev      = (bnd->prev) ? strdup(bnd->prev) : NULL;
+          prev_i    = bnd->prev_i - chunk->offset;
+          prev_j    = bnd->prev_j - chunk->offset;
+          prev_end  = bnd->prev_end - chunk->offset;
+          prev_en   = bnd->prev_en;
+#ifdef VRNA_WITH_SVM
+          prevz = bnd->prevz;
+#endif
+        } else {
+          bnd->prev     = (prev) ? strdup(prev) : NULL;
+          bnd->prev_i   = prev_i + chunk->offset;
+          bnd->prev_j   = prev_j + chunk->offset;
+          bnd->prev_end = prev_end + chunk->offset;
+          bnd->prev_en  = prev_en;
+#ifdef VRNA_WITH_SVM
+          bnd->prevz = prevz;
+#endif
+          for (j = 0; (j < bnd->num_f3) && (i + j <= length); j++)
+            bnd->f3[j] = f3[i + j] - f3[i];
+          bnd->num_f3 = j;
+        }
+
+        chunk->f3_bnd         = f3[i];
+        chunk->underflow_bnd  = *underflow;
+
+        /* structures reported so far belong to the downstream chunk */
+        for (j = 0; j < (int)chunk->num_hits; j++)
+          free(chunk->hits[j].structure);
+        chunk->num_hits = 0;
+      }
+
       FF    = DMLi2;
       DMLi2 = DMLi1;
       DMLi1 = DMLi;
@@ -836,12 +1284,480 @@ fill_arrays(vrna_fold_compound_t            *vc,
   free(DMLi1);
   free(DMLi2);
 
-  free_dp_matrices(vc);
+  free_dp_matrices(vc, lo);
+
+  if (chunk) {
+    window_state *end = &(chunk->end);
 
-  return f3[1];
+    /* hand over the state at the 5' end of the chunk to the upstream chunk */
+    end->prev     = prev;
+    end->prev_i   = prev_i + chunk->offset;
+    end->prev_j   = prev_j + chunk->offset;
+    end->prev_end = prev_end + chunk->offset;
+    end->prev_en  = prev_en;
+#ifdef VRNA_WITH_SVM
+    end->prevz = prevz;
+#endif
+    for (j = 0; (j < end->num_f3) && (lo + j <= length); j++)
+      end->f3[j] = f3[lo + j] - f3[lo];
+    end->num_f3 = j;
+
+    chunk->en = f3[lo] - chunk->f3_bnd +
+                (*underflow - chunk->underflow_bnd) * UNDERFLOW_CORRECTION;
+  }
+
+  return f3[lo];
 }
 
 
+PRIVATE int
+chunk_length(int maxdist)
+{
+  return MAX2(WINDOW_CHUNK_MIN_LENGTH, WINDOW_CHUNK_WINDOW_FACTOR * maxdist);
+}
+
+
+PRIVATE void
+store_hit(int         start,
+          int         end,
+          const char  *structure,
+          float       en,
+          void        *data)
+{
+  window_chunk  *chunk;
+  window_hit    *hit;
+
+  chunk = (window_chunk *)data;
+
+  if (chunk->num_hits == chunk->max_hits) {
+    chunk->max_hits = (chunk->max_hits) ? 2 * chunk->max_hits : 64;
+    chunk->hits     = (window_hit *)vrna_realloc(chunk->hits,
+                                                 sizeof(window_hit) * chunk->max_hits);
+  }
+
+  hit             = chunk->hits + chunk->num_hits++;
+  hit->start      = start + chunk->offset;
+  hit->end        = end + chunk->offset;
+  hit->structure  = strdup(structure);
+  hit->en         = en;
+  hit->zscore     = 0.;
+}
+
+
+#ifdef VRNA_WITH_SVM
+PRIVATE void
+store_hit_z(int         start,
+            int         end,
+            const char  *structure,
+            float       en,
+            float       zscore,
+            void        *data)
+{
+  window_chunk *chunk = (window_chunk *)data;
+
+  store_hit(start, end, structure, en, data);
+  chunk->hits[chunk->num_hits - 1].zscore = zscore;
+}
+
+
+#endif
+
+
+/*
+ *  Prepare a chunk that covers rows a to b of the sequence, using the
+ *  subsequence from position start to end
+ */
+PRIVATE void
+chunk_setup(window_chunk  *chunk,
+            int           a,
+            int           b,
+            int           start,
+            int           end,
+            int           maxdist)
+{
+  memset(chunk, 0, sizeof(window_chunk));
+
+  chunk->offset     = start - 1;
+  chunk->length     = end - start + 1;
+  chunk->lo         = a - chunk->offset;
+  chunk->hi         = b - chunk->offset;
+  chunk->bnd.f3     = (int *)vrna_alloc(sizeof(int) * (maxdist + 2));
+  chunk->bnd.num_f3 = maxdist + 2;
+  chunk->end.f3     = (int *)vrna_alloc(sizeof(int) * (maxdist + 2));
+  chunk->end.num_f3 = maxdist + 2;
+}
+
+
+PRIVATE void
+chunk_reset(window_chunk  *chunk,
+            int           maxdist)
+{
+  unsigned int k;
+
+  for (k = 0; k < chunk->num_hits; k++)
+    free(chunk->hits[k].structure);
+
+  free(chunk->bnd.prev);
+  free(chunk->end.prev);
+
+  chunk->num_hits       = 0;
+  chunk->bnd.prev       = NULL;
+  chunk->end.prev       = NULL;
+  chunk->end.num_f3     = maxdist + 2;
+  chunk->f3_bnd         = 0;
+  chunk->underflow_bnd  = 0;
+  chunk->en             = 0;
+}
+
+
+/* prepare a chunk for re-computation with the state at its 3' boundary enforced */
+PRIVATE void
+chunk_enforce(window_chunk  *chunk,
+              window_state  *state,
+              int           maxdist)
+{
+  chunk_reset(chunk, maxdist);
+
+  chunk->forced         = 1;
+  chunk->bnd.prev       = (state->prev) ? strdup(state->prev) : NULL;
+  chunk->bnd.prev_i     = state->prev_i;
+  chunk->bnd.prev_j     = state->prev_j;
+  chunk->bnd.prev_end   = state->prev_end;
+  chunk->bnd.prev_en    = state->prev_en;
+  chunk->bnd.prevz      = state->prevz;
+  chunk->bnd.num_f3     = state->num_f3;
+  memcpy(chunk->bnd.f3, state->f3, sizeof(int) * state->num_f3);
+}
+
+
+PRIVATE void
+chunk_free(window_chunk *chunk)
+{
+  chunk_reset(chunk, 0);
+  free(chunk->hits);
+  free(chunk->bnd.f3);
+  free(chunk->end.f3);
+}
+
+
+PRIVATE int
+chunk_state_equal(window_state  *s1,
+                  window_state  *s2)
+{
+  if ((s1->prev == NULL) != (s2->prev == NULL))
+    return 0;
+
+  if ((s1->prev) &&
+      ((s1->prev_i != s2->prev_i) ||
+       (s1->prev_j != s2->prev_j) ||
+       (s1->prev_end != s2->prev_end) ||
+       (s1->prev_en != s2->prev_en) ||
+       (s1->prevz != s2->prevz) ||
+       (strcmp(s1->prev, s2->prev))))
+    return 0;
+
+  if (s1->num_f3 != s2->num_f3)
+    return 0;
+
+  return (memcmp(s1->f3, s2->f3, sizeof(int) * s1->num_f3)) ? 0 : 1;
+}
+
+
+/*
+ *  Scan the subsequence of a chunk, where sequence points to its first
+ *  nucleotide. If params is not NULL, the chunk uses exactly these energy
+ *  parameters. Otherwise, they are derived from the model settings md
+ */
+PRIVATE void
+chunk_fold(const char   *sequence,
+           vrna_md_t    *md,
+           vrna_param_t *params,
+#ifdef VRNA_WITH_SVM
+           zscoring_dat *zsc_data,
+#endif
+           window_chunk *chunk)
+{
+  char                  *subsequence;
+  int                   underflow;
+  vrna_md_t             md_chunk;
+  vrna_fold_compound_t  *sub;
+
+  subsequence = (char *)vrna_alloc(sizeof(char) * (chunk->length + 1));
+  memcpy(subsequence, sequence, sizeof(char) * chunk->length);
+
+  vrna_md_copy(&md_chunk, md);
+  md_chunk.num_threads = 1;
+
+  sub = vrna_fold_compound(subsequence, &md_chunk, VRNA_OPTION_MFE | VRNA_OPTION_WINDOW);
+
+  /* use exactly the same energy parameters as the parent fold compound */
+  if (params)
+    vrna_params_subst(sub, params);
+
+  vrna_fold_compound_prepare(sub, VRNA_OPTION_MFE | VRNA_OPTION_WINDOW);
+
+  underflow = 0;
+
+#ifdef VRNA_WITH_SVM
+  (void)fill_arrays(sub, &underflow, &store_hit, zsc_data, &store_hit_z, (void *)chunk, chunk);
+#else
+  (void)fill_arrays(sub, &underflow, &store_hit, (void *)chunk, chunk);
+#endif
+
+  vrna_fold_compound_free(sub);
+  free(subsequence);
+}
+
+
+/*
+ *  Verify the state at the 3' boundary of a chunk against the actual state
+ *  provided by its downstream neighbor, and re-compute the chunk with the
+ *  actual state enforced if they differ. Returns 0 if this changed the state
+ *  at the 5' end of the chunk, i.e. the chunk upstream needs verification as
+ *  well, and 1 otherwise
+ */
+PRIVATE int
+chunk_verify(window_chunk *chunk,
+             window_state *state,
+             const char   *sequence,
+             vrna_param_t *params,
+#ifdef VRNA_WITH_SVM
+             zscoring_dat *zsc_data,
+#endif
+             int          maxdist)
+{
+  int           ret;
+  window_state  used;
+
+  if (chunk_state_equal(&(chunk->bnd), state))
+    return 1;
+
+  /* keep the state at the 5' end that has been used to verify the upstream chunk */
+  used              = chunk->end;
+  chunk->end.prev   = NULL;
+  chunk->end.f3     = (int *)vrna_alloc(sizeof(int) * (maxdist + 2));
+
+  chunk_enforce(chunk, state, maxdist);
+#ifdef VRNA_WITH_SVM
+  chunk_fold(sequence, &(params->model_details), params, zsc_data, chunk);
+#else
+  chunk_fold(sequence, &(params->model_details), params, chunk);
+#endif
+
+  ret = ((chunk->offset == 0) || (chunk_state_equal(&used, &(chunk->end)))) ? 1 : 0;
+
+  free(used.prev);
+  free(used.f3);
+
+  return ret;
+}
+
+
+/*
+ *  Pass the structures of a chunk to the callback(s) and accumulate the 3'
+ *  free energy while keeping track of integer underflows as in the serial scan
+ */
+PRIVATE void
+chunk_report(window_chunk                    *chunk,
+             int                             *energy,
+             int                             *underflow,
+             vrna_mfe_window_callback        *cb,
+#ifdef VRNA_WITH_SVM
+             zscoring_dat                    *zsc_data,
+             vrna_mfe_window_zscore_callback *cb_z,
+#endif
+             void                            *data)
+{
+  unsigned int  k;
+  window_hit    *hit;
+
+  for (k = 0; k < chunk->num_hits; k++) {
+    hit = chunk->hits + k;
+#ifdef VRNA_WITH_SVM
+    if (zsc_data->with_zsc)
+      cb_z(hit->start, hit->end, hit->structure, hit->en, hit->zscore, data);
+    else
+#endif
+    cb(hit->start, hit->end, hit->structure, hit->en, data);
+  }
+
+  *energy += chunk->en;
+  while (INT_CLOSE_TO_UNDERFLOW(*energy)) {
+    *energy -= UNDERFLOW_CORRECTION;
+    (*underflow)++;
+  }
+}
+
+
+/*
+ *  Energy parameters shared by all chunks of a streaming scan, with the model
+ *  settings sanitized in the same way as for the fold compound of a chunk
+ */
+PRIVATE vrna_param_t *
+chunk_params(const char *sequence,
+             int        length,
+             vrna_md_t  *md)
+{
+  char                  *subsequence;
+  vrna_param_t          *P;
+  vrna_fold_compound_t  *sub;
+
+  subsequence = (char *)vrna_alloc(sizeof(char) * (length + 1));
+  memcpy(subsequence, sequence, sizeof(char) * length);
+
+  sub = vrna_fold_compound(subsequence, md, VRNA_OPTION_MFE | VRNA_OPTION_WINDOW);
+  P   = vrna_params_copy(sub->params);
+
+  vrna_fold_compound_free(sub);
+  free(subsequence);
+
+  return P;
+}
+
+
+#ifdef _OPENMP
+
+PRIVATE int
+chunked_scan_possible(vrna_fold_compound_t *fc)
+{
+  int       maxdist;
+  vrna_md_t *md;
+  vrna_hc_t *hc;
+
+  md      = &(fc->params->model_details);
+  hc      = fc->hc;
+  maxdist = fc->window_size;
+
+  /*
+   *  Splitting the scan into independent chunks only reproduces the serial
+   *  results if all energy contributions solely depend on the sequence. Thus,
+   *  we refuse to do so in the presence of soft constraints, user-defined
+   *  hard constraints, or extensions of the grammar
+   */
+  if ((md->num_threads < 2) ||
+      (fc->type != VRNA_FC_TYPE_SINGLE) ||
+      (fc->sc) ||
+      (hc->up_storage) ||
+      (hc->bp_storage) ||
+      (hc->f) ||
+      (fc->domains_up) ||
+      (fc->aux_grammar) ||
+      (2 * maxdist <= md->min_loop_size + 2))
+    return 0;
+
+  return ((int)fc->length >= 2 * chunk_length(maxdist)) ? 1 : 0;
+}
+
+
+PRIVATE void
+chunk_init(window_chunk *chunk,
+           int          length,
+           int          maxdist,
+           int          num)
+{
+  int a, b, body;
+
+  /* the num-th chunk from the 3' end covers rows a to b of the sequence */
+  body  = chunk_length(maxdist);
+  b     = length - num * body;
+  a     = MAX2(1, b - body + 1);
+
+  /* one additional nucleotide 5' of row a is required for dangling ends */
+  chunk_setup(chunk, a, b, MAX2(1, a - 1), MIN2(length, b + 2 * maxdist), maxdist);
+}
+
+
+/*
+ *  Chunked variant of fill_arrays() for long single sequences. The sequence
+ *  is split into chunks that are folded in parallel. Each chunk overlaps the
+ *  downstream one by 2 * window_size nucleotides, which usually suffices to
+ *  reproduce the state of the serial 3' -> 5' scan at the chunk boundary.
+ *  This is verified for each chunk, from 3' to 5', and chunks whose boundary
+ *  state does not match are re-computed with the state enforced. Locally
+ *  optimal structures are passed to the callback(s) in the same order as in
+ *  the serial scan.
+ */
+PRIVATE int
+fill_arrays_chunked(vrna_fold_compound_t            *fc,
+                    int                             *underflow,
+                    vrna_mfe_window_callback        *cb,
+#ifdef VRNA_WITH_SVM
+                    zscoring_dat                    *zsc_data,
+                    vrna_mfe_window_zscore_callback *cb_z,
+#endif
+                    void                            *data)
+{
+  int           t, m, cnt, length, maxdist, num_chunks, num_threads, energy;
+  window_state  exact;
+  window_chunk  *chunks, *chunk;
+  vrna_md_t     *md;
+
+  length      = (int)fc->length;
+  maxdist     = fc->window_size;
+  md          = &(fc->params->model_details);
+  num_threads = md->num_threads;
+  num_chunks  = (length + chunk_length(maxdist) - 1) / chunk_length(maxdist);
+  chunks      = (window_chunk *)vrna_alloc(sizeof(window_chunk) * num_threads);
+  energy      = 0;
+  *underflow  = 0;
+
+  memset(&exact, 0, sizeof(window_state));
+
+  for (m = 0; m < num_chunks; m += num_threads) {
+    cnt = MIN2(num_threads, num_chunks - m);
+
+#pragma omp parallel for num_threads(num_threads) schedule(dynamic, 1)
+    for (t = 0; t < cnt; t++) {
+      chunk_init(&(chunks[t]), length, maxdist, m + t);
+#ifdef VRNA_WITH_SVM
+      chunk_fold(fc->sequence + chunks[t].offset, md, fc->params, zsc_data, &(chunks[t]));
+#else
+      chunk_fold(fc->sequence + chunks[t].offset, md, fc->params, &(chunks[t]));
+#endif
+    }
+
+    for (t = 0; t < cnt; t++) {
+      chunk = &(chunks[t]);
+
+      if ((m + t > 0) &&
+          (!chunk_state_equal(&(chunk->bnd), &exact))) {
+        /* overlap too short to converge, repeat with the actual state at the boundary */
+        chunk_enforce(chunk, &exact, maxdist);
+#ifdef VRNA_WITH_SVM
+        chunk_fold(fc->sequence + chunk->offset, md, fc->params, zsc_data, chunk);
+#else
+        chunk_fold(fc->sequence + chunk->offset, md, fc->params, chunk);
+#endif
+      }
+
+#ifdef VRNA_WITH_SVM
+      chunk_report(chunk, &energy, underflow, cb, zsc_data, cb_z, data);
+#else
+      chunk_report(chunk, &energy, underflow, cb, data);
+#endif
+
+      /* the state at the 5' end of this chunk is the actual state for the next one */
+      free(exact.prev);
+      free(exact.f3);
+      exact             = chunk->end;
+      chunk->end.prev   = NULL;
+      chunk->end.f3     = NULL;
+
+      chunk_free(chunk);
+    }
+  }
+
+  free(exact.prev);
+  free(exact.f3);
+  free(chunks);
+
+  return energy;
+}
+
+
+#endif
+
+
 #ifdef VRNA_WITH_SVM
 PRIVATE int
 want_backtrack(vrna_fold_compound_t *vc,
@@ -1341,7 +2257,7 @@ fill_arrays_comparative(vrna_fold_compound_t      *fc,
     free(dm[i]);
   free(dm);
 
-  free_dp_matrices(fc);
+  free_dp_matrices(fc, 1);
 
   return matrices->f3[1];
 }
@@ -96,6 +96,12 @@ typedef void (vrna_mfe_window_zscore_callback)(int        start,
  *  stdout, if a NULL pointer is passed as file parameter, or to
  *  the corresponding filehandle.
  *
+ *  @note If #vrna_md_t.num_threads is larger than 1, long single sequences
+ *        without soft constraints or non-default hard constraints are split
+ *        into overlapping chunks that are scanned concurrently. Predictions
+ *        are reported in the same order and are identical to those of the
+ *        sequential scan.
+ *
  *  @see  vrna_fold_compound(), vrna_mfe_window_zscore(), vrna_mfe(),
  *        vrna_Lfold(), vrna_Lfoldz(),
  *        #VRNA_OPTION_WINDOW, #vrna_md_t.max_bp_span, #vrna_md_t.window_size
@@ -114,6 +120,53 @@ vrna_mfe_window_cb(vrna_fold_compound_t     *vc,
                    void                     *data);
 
 
+/**
+ *  @brief Local MFE prediction for a sequence that is read piece by piece
+ *
+ *  This function is a streaming variant of vrna_mfe_window_cb() for single sequences that are
+ *  too long to be kept in memory. The sequence is retrieved through the callback @p read and
+ *  split into consecutive blocks that each overlap their downstream neighbor by
+ *  2 * #vrna_md_t.window_size nucleotides. At any time, only a few blocks of the sequence and
+ *  the corresponding sliding window DP matrices are kept in memory, i.e. the memory requirement
+ *  is independent of the sequence length. If #vrna_md_t.num_threads is larger than 1, several
+ *  blocks are scanned concurrently.
+ *
+ *  The scan of each block is verified against the scan of its downstream neighbor and, if
+ *  necessary, repeated with the actual state at the block boundary. Predictions of a block
+ *  are only passed to the callback once the block and its downstream neighbor have been
+ *  verified. Thus, the predictions are identical to those of vrna_mfe_window_cb(). Should
+ *  the repeated scan of a block change a block that has already been reported, i.e. the
+ *  scan did not converge within two blocks, the prediction is aborted with a warning and
+ *  (float)(INF / 100.) is returned. In this case, the predictions passed to @p cb so far
+ *  must be discarded, and the sequence has to be re-scanned entirely, e.g. by means of
+ *  vrna_mfe_window_cb(). Callers that must not emit incomplete results should therefore
+ *  buffer the predictions until this function returns, as done by @p RNALfold.
+ *
+ *  @note Predictions are passed to the callback @p cb block-wise from the 5' to the 3' end,
+ *        and from the 3' to the 5' end within each block. This differs from the order of
+ *        vrna_mfe_window_cb(), where all predictions are reported from the 3' to the 5' end.
+ *
+ *  @note Soft constraints, non-default hard constraints, and extensions of the grammar are
+ *        not available for streaming predictions.
+ *
+ *  @see  vrna_mfe_window_cb(), vrna_probs_window_stream(), #vrna_sequence_stream_callback,
+ *        vrna_file_fasta_read_sequence()
+ *
+ *  @param  md        The model details (maybe NULL for default settings), #vrna_md_t.window_size must be set
+ *  @param  read      The callback that provides the sequence
+ *  @param  read_data Some arbitrary data pointer passed through to the callback @p read
+ *  @param  cb        The callback that receives the predictions
+ *  @param  data      Some arbitrary data pointer passed through to the callback @p cb
+ *  @return           The free energy of the entire sequence in kcal/mol, or (float)(INF / 100.) on error
+ */
+float
+vrna_mfe_window_stream(vrna_md_t                      *md,
+                       vrna_sequence_stream_callback  *read,
+                       void                           *read_data,
+                       vrna_mfe_window_callback       *cb,
+                       void                           *data);
+
+
 #ifdef VRNA_WITH_SVM
 /**
  *  @brief Local MFE prediction using a sliding window approach (with z-score cut-off)
@@ -134,7 +134,10 @@ PRIVATE vrna_md_t defaults = {
     { 0,                            0,  0, 0, 0, 0, 2, 0 },
     { 0,                            0,  0, 0, 0, 1, 0, 0 },
     { 0,                            6,  0, 0, 5, 0, 0, 0 }
-  }
+  },
+  VRNA_MODEL_DEFAULT_NUM_THREADS,
+  VRNA_MODEL_DEFAULT_PF_FLOAT,
+  NULL
 };
 
 /*
@@ -335,6 +338,9 @@ vrna_md_defaults_reset(vrna_md_t *md_p)
   defaults.betaScale        = VRNA_MODEL_DEFAULT_BETA_SCALE;
   defaults.pf_smooth        = VRNA_MODEL_DEFAULT_PF_SMOOTH;
   defaults.sfact            = 1.07;
+  defaults.num_threads      = VRNA_MODEL_DEFAULT_NUM_THREADS;
+  defaults.pf_float         = VRNA_MODEL_DEFAULT_PF_FLOAT;
+  defaults.param_set        = NULL;
   defaults.nonstandards[0]  = '\0';
 
   if (md_p) {
@@ -369,6 +375,8 @@ vrna_md_defaults_reset(vrna_md_t *md_p)
     vrna_md_defaults_betaScale(md_p->betaScale);
     vrna_md_defaults_pf_smooth(md_p->pf_smooth);
     vrna_md_defaults_sfact(md_p->sfact);
+    vrna_md_defaults_num_threads(md_p->num_threads);
+    vrna_md_defaults_pf_float(md_p->pf_float);
     copy_nonstandards(&defaults, &(md_p->nonstandards[0]));
   }
 
@@ -824,6 +832,34 @@ vrna_md_defaults_sfact_get(void)
 }
 
 
+PUBLIC void
+vrna_md_defaults_num_threads(int num_threads)
+{
+  defaults.num_threads = (num_threads < 1) ? 1 : num_threads;
+}
+
+
+PUBLIC int
+vrna_md_defaults_num_threads_get(void)
+{
+  return defaults.num_threads;
+}
+
+
+PUBLIC void
+vrna_md_defaults_pf_float(int flag)
+{
+  defaults.pf_float = (flag) ? 1 : 0;
+}
+
+
+PUBLIC int
+vrna_md_defaults_pf_float_get(void)
+{
+  return defaults.pf_float;
+}
+
+
 PUBLIC void
 vrna_md_update(vrna_md_t *md)
 {
@@ -993,6 +1029,9 @@ set_model_details(vrna_md_t *md)
     md->betaScale       = VRNA_MODEL_DEFAULT_BETA_SCALE;
     md->pf_smooth       = VRNA_MODEL_DEFAULT_PF_SMOOTH;
     md->sfact           = 1.07;
+    md->num_threads     = VRNA_MODEL_DEFAULT_NUM_THREADS;
+    md->pf_float        = VRNA_MODEL_DEFAULT_PF_FLOAT;
+    md->param_set       = NULL;
 
     if (nonstandards)
       copy_nonstandards(md, nonstandards);
@@ -21,6 +21,9 @@
 /** @brief Typename for the model details data structure #vrna_md_s */
 typedef struct vrna_md_s vrna_md_t;
 
+/** @brief Typename for the raw energy parameter set data structure #vrna_param_set_s */
+typedef struct vrna_param_set_s vrna_param_set_t;
+
 /**
  *  @brief
  *  @htmlonly Default temperature for structure prediction and free energy evaluation in &#176C @endhtmlonly
@@ -156,6 +159,18 @@ typedef struct vrna_md_s vrna_md_t;
 
 #define VRNA_MODEL_DEFAULT_PF_SMOOTH      1
 
+/**
+ *  @brief  Default number of threads used to fill the dynamic programming matrices of a single sequence
+ *  @see    #vrna_md_t.num_threads, vrna_md_defaults_reset(), vrna_md_set_default()
+ */
+#define VRNA_MODEL_DEFAULT_NUM_THREADS    1
+
+/**
+ *  @brief  Default setting for single precision partition function matrices
+ *  @see    #vrna_md_t.pf_float, vrna_md_defaults_reset(), vrna_md_set_default()
+ */
+#define VRNA_MODEL_DEFAULT_PF_FLOAT       0
+
 
 #ifndef VRNA_DISABLE_BACKWARD_COMPATIBILITY
 
@@ -233,6 +248,58 @@ struct vrna_md_s {
   int     rtype[8];                         /**<  @brief  Reverse base pair type array */
   short   alias[MAXALPHA + 1];              /**<  @brief  alias of an integer nucleotide representation */
   int     pair[MAXALPHA + 1][MAXALPHA + 1]; /**<  @brief  Integer representation of a base pair */
+  int     num_threads;                      /**<  @brief  Number of threads used to fill the dynamic programming matrices
+                                             *
+                                             *    Values larger than 1 activate a parallel fill of the global (non-window)
+                                             *    dynamic programming matrices by at most @p num_threads OpenMP threads.
+                                             *    The MFE matrices are filled in wavefront (anti-diagonal) order, where
+                                             *    all sub-segments of equal span @f$ j - i @f$ are processed concurrently.
+                                             *    The partition function matrices are filled column-wise, where all
+                                             *    sub-segments @f$ [i,j] @f$ with equal @f$ j @f$ are processed concurrently.
+                                             *    A value of 1 (default) results in the classic, sequential recursions.
+                                             *    For sliding window predictions, i.e. vrna_mfe_window() and
+                                             *    vrna_probs_window(), long sequences are instead split into
+                                             *    overlapping chunks that are processed concurrently, with results
+                                             *    identical to the sequential scan. Suboptimal structures from
+                                             *    vrna_subopt_cb() and stochastic backtracking samples are likewise
+                                             *    generated by concurrent threads.
+                                             *    @note   This setting has no effect if RNAlib was compiled without
+                                             *            OpenMP support. Any user-defined hard or soft constraint
+                                             *            callback must be thread-safe when this option is active.
+                                             *            Unstructured domain energy callbacks are never called
+                                             *            concurrently, their presence results in the sequential
+                                             *            recursions instead.
+                                             */
+  int     pf_float;                         /**<  @brief  Fill the partition function matrices in single precision
+                                             *
+                                             *    If non-zero, vrna_pf() fills the default (global) partition function
+                                             *    matrices with single precision floating point arithmetic and a double
+                                             *    precision accumulation of the exterior loop, i.e. the ensemble partition
+                                             *    function @f$ Q @f$. If neither base pair probabilities nor stochastic
+                                             *    backtracking (#vrna_md_t.uniq_ML) are requested, the matrices are
+                                             *    stored in single precision only, which halves their memory footprint.
+                                             *    Otherwise, they are converted to double precision after the fill, so
+                                             *    base pair probabilities and stochastic backtracking work as usual. Base
+                                             *    pair probabilities usually deviate by less than @f$ 10^{-4} @f$ from
+                                             *    those of the double precision fill.
+                                             *    @note   Single precision is only used for single sequences without
+                                             *            soft constraints, hard constraint callbacks, unstructured
+                                             *            domains, G-Quadruplexes and circular RNAs. If any of these
+                                             *            is present, or if any (scaled) partition function exceeds the
+                                             *            range of single precision, i.e. overflows or becomes subnormal,
+                                             *            a warning is issued and the matrices are filled in double
+                                             *            precision instead.
+                                             */
+  vrna_param_set_t  *param_set;             /**<  @brief  The raw energy parameters the thermodynamic parameters are derived from
+                                             *
+                                             *    If @p NULL (default), the energy parameters currently loaded into
+                                             *    the global energy parameter tables are used. Otherwise, the energy
+                                             *    parameters are derived from this independent set, see e.g.
+                                             *    vrna_param_set_load().
+                                             *    @note   The parameter set must not be released as long as
+                                             *            energy parameters may still be derived from any model
+                                             *            details that refer to it.
+                                             */
 };
 
 
@@ -742,6 +809,42 @@ double
 vrna_md_defaults_sfact_get(void);
 
 
+/**
+ *  @brief  Set the default number of threads used to fill the dynamic programming matrices
+ *  @see vrna_md_defaults_reset(), vrna_md_set_default(), #vrna_md_t, #VRNA_MODEL_DEFAULT_NUM_THREADS
+ *  @param  num_threads  The number of threads (values < 2 result in sequential recursions)
+ */
+void
+vrna_md_defaults_num_threads(int num_threads);
+
+
+/**
+ *  @brief  Get the default number of threads used to fill the dynamic programming matrices
+ *  @see vrna_md_defaults_num_threads(), vrna_md_defaults_reset(), vrna_md_set_default(), #vrna_md_t, #VRNA_MODEL_DEFAULT_NUM_THREADS
+ *  @return The global default settings of the number of threads
+ */
+int
+vrna_md_defaults_num_threads_get(void);
+
+
+/**
+ *  @brief  Set default behavior for single precision partition function matrices
+ *  @see vrna_md_defaults_reset(), vrna_md_set_default(), #vrna_md_t, #VRNA_MODEL_DEFAULT_PF_FLOAT
+ *  @param  flag  Fill partition function matrices in single precision (0 = off, 1 = on)
+ */
+void
+vrna_md_defaults_pf_float(int flag);
+
+
+/**
+ *  @brief  Get default behavior for single precision partition function matrices
+ *  @see vrna_md_defaults_pf_float(), vrna_md_defaults_reset(), vrna_md_set_default(), #vrna_md_t, #VRNA_MODEL_DEFAULT_PF_FLOAT
+ *  @return The global default settings for single precision partition function matrices
+ */
+int
+vrna_md_defaults_pf_float_get(void);
+
+
 #ifndef VRNA_DISABLE_BACKWARD_COMPATIBILITY
 
 #define model_detailsT        vrna_md_t               /* restore compatibility of struct rename */
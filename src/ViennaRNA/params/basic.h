@@ -156,13 +156,108 @@ struct vrna_exp_param_s {
 };
 
 
+/**
+ *  @brief  The datastructure that contains a set of raw energy parameters
+ *
+ *  In contrast to the global energy parameter tables, this data structure holds
+ *  an independent copy of free energies at 37&deg;C and the corresponding
+ *  enthalpies, e.g. as obtained from vrna_param_set_load(). It is not modified
+ *  after creation, such that the same set can be attached to the model details
+ *  (#vrna_md_t.param_set) of any number of fold compounds in any number of
+ *  threads.
+ *
+ *  @see  vrna_param_set_load(), vrna_param_set_current(), vrna_param_set_free(),
+ *        #vrna_md_t.param_set
+ */
+struct vrna_param_set_s {
+  unsigned int  id;         /**<  @brief  A unique identifier of this parameter set */
+  char          *name;      /**<  @brief  The name of the parameter set, or @p NULL */
+
+  int           stack37[NBPAIRS + 1][NBPAIRS + 1];
+  int           stackdH[NBPAIRS + 1][NBPAIRS + 1];
+  int           hairpin37[31];
+  int           hairpindH[31];
+  int           bulge37[31];
+  int           bulgedH[31];
+  int           internal_loop37[31];
+  int           internal_loopdH[31];
+  int           mismatchI37[NBPAIRS + 1][5][5];
+  int           mismatchIdH[NBPAIRS + 1][5][5];
+  int           mismatch1nI37[NBPAIRS + 1][5][5];
+  int           mismatch1nIdH[NBPAIRS + 1][5][5];
+  int           mismatch23I37[NBPAIRS + 1][5][5];
+  int           mismatch23IdH[NBPAIRS + 1][5][5];
+  int           mismatchH37[NBPAIRS + 1][5][5];
+  int           mismatchHdH[NBPAIRS + 1][5][5];
+  int           mismatchM37[NBPAIRS + 1][5][5];
+  int           mismatchMdH[NBPAIRS + 1][5][5];
+  int           mismatchExt37[NBPAIRS + 1][5][5];
+  int           mismatchExtdH[NBPAIRS + 1][5][5];
+  int           dangle5_37[NBPAIRS + 1][5];
+  int           dangle5_dH[NBPAIRS + 1][5];
+  int           dangle3_37[NBPAIRS + 1][5];
+  int           dangle3_dH[NBPAIRS + 1][5];
+  int           int11_37[NBPAIRS + 1][NBPAIRS + 1][5][5];
+  int           int11_dH[NBPAIRS + 1][NBPAIRS + 1][5][5];
+  int           int21_37[NBPAIRS + 1][NBPAIRS + 1][5][5][5];
+  int           int21_dH[NBPAIRS + 1][NBPAIRS + 1][5][5][5];
+  int           int22_37[NBPAIRS + 1][NBPAIRS + 1][5][5][5][5];
+  int           int22_dH[NBPAIRS + 1][NBPAIRS + 1][5][5][5][5];
+
+  double        lxc37;
+  int           ML_BASE37;
+  int           ML_BASEdH;
+  int           ML_closing37;
+  int           ML_closingdH;
+  int           ML_intern37;
+  int           ML_interndH;
+  int           TripleC37;
+  int           TripleCdH;
+  int           MultipleCA37;
+  int           MultipleCAdH;
+  int           MultipleCB37;
+  int           MultipleCBdH;
+  int           MAX_NINIO;
+  int           ninio37;
+  int           niniodH;
+  int           TerminalAU37;
+  int           TerminalAUdH;
+  int           DuplexInit37;
+  int           DuplexInitdH;
+
+  char          Tetraloops[281];
+  int           Tetraloop37[40];
+  int           TetraloopdH[40];
+  char          Triloops[241];
+  int           Triloop37[40];
+  int           TriloopdH[40];
+  char          Hexaloops[361];
+  int           Hexaloop37[40];
+  int           HexaloopdH[40];
+
+  int           GQuadAlpha37;
+  int           GQuadAlphadH;
+  int           GQuadBeta37;
+  int           GQuadBetadH;
+  int           GQuadLayerMismatch37;
+  int           GQuadLayerMismatchH;
+  int           GQuadLayerMismatchMax;
+
+  double        Tmeasure;   /**<  @brief  The temperature the parameters were measured at in K */
+};
+
+
 /**
  *  @brief  Get a data structure containing prescaled free energy parameters
  *
  *  If a NULL pointer is passed for the model details parameter, the default
  *  model parameters are stored within the requested #vrna_param_t structure.
  *
- *  @see #vrna_md_t, vrna_md_set_default(), vrna_exp_params()
+ *  @note Energy parameters are cached for the most recently used models, such
+ *        that subsequent requests for the same model only copy the already
+ *        scaled parameters. See vrna_params_cache_clear() for details.
+ *
+ *  @see #vrna_md_t, vrna_md_set_default(), vrna_exp_params(), vrna_params_cache_clear()
  *
  *  @param  md  A pointer to the model details to store inside the structure (Maybe NULL)
  *  @return     A pointer to the memory location where the requested parameters are stored
@@ -203,7 +298,12 @@ vrna_params_copy(vrna_param_t *par);
  *  If a NULL pointer is passed for the model details parameter, the default
  *  model parameters are stored within the requested #vrna_exp_param_t structure.
  *
- *  @see #vrna_md_t, vrna_md_set_default(), vrna_params(), vrna_rescale_pf_params()
+ *  @note Boltzmann factors are cached for the most recently used models, such
+ *        that subsequent requests for the same model only copy the already
+ *        computed factors. See vrna_params_cache_clear() for details.
+ *
+ *  @see #vrna_md_t, vrna_md_set_default(), vrna_params(), vrna_rescale_pf_params(),
+ *       vrna_params_cache_clear()
  *
  *  @param  md  A pointer to the model details to store inside the structure (Maybe NULL)
  *  @return     A pointer to the memory location where the requested parameters are stored
@@ -212,6 +312,24 @@ vrna_exp_param_t *
 vrna_exp_params(vrna_md_t *md);
 
 
+/**
+ *  @brief  Get a data structure containing prescaled free energy parameters
+ *          already transformed to Boltzmann factors, bypassing the cache
+ *
+ *  Same as vrna_exp_params(), but the Boltzmann factors are always computed
+ *  from scratch and never enter the cache. Use this function for one-time
+ *  requests of many different models, e.g. dense temperature scans, which
+ *  would otherwise evict the cached parameters of all other models.
+ *
+ *  @see vrna_exp_params(), vrna_params_cache_clear()
+ *
+ *  @param  md  A pointer to the model details to store inside the structure (Maybe NULL)
+ *  @return     A pointer to the memory location where the requested parameters are stored
+ */
+vrna_exp_param_t *
+vrna_exp_params_uncached(vrna_md_t *md);
+
+
 /**
  *  @brief  Get a data structure containing prescaled free energy parameters
  *          already transformed to Boltzmann factors (alifold version)
@@ -368,6 +486,25 @@ vrna_params_prepare(vrna_fold_compound_t  *vc,
                     unsigned int          options);
 
 
+/**
+ *  @brief  Remove all energy parameter sets from the cache
+ *
+ *  Energy parameters and Boltzmann factors obtained from vrna_params(),
+ *  vrna_exp_params(), and vrna_exp_params_comparative() are computed only once
+ *  for each model and kept in a cache that is shared by all threads. Subsequent
+ *  requests for the same model, i.e. temperature, Boltzmann scaling factor,
+ *  dangle model, and smoothing, receive a copy of the cached data instead.
+ *
+ *  The cache is cleared automatically whenever a new energy parameter set is
+ *  loaded, e.g. through vrna_params_load(). Programs that modify the global
+ *  energy parameter tables directly must call this function afterwards.
+ *
+ *  @see vrna_params(), vrna_exp_params(), vrna_params_load()
+ */
+void
+vrna_params_cache_clear(void);
+
+
 #ifndef VRNA_DISABLE_BACKWARD_COMPATIBILITY
 
 /**
@@ -15,10 +15,16 @@
 #include <string.h>
 #include <math.h>
 #include <stdarg.h>
+
+#if VRNA_WITH_PTHREADS
+# include <pthread.h>
+#endif
+
 #include "ViennaRNA/utils/basic.h"
 #include "ViennaRNA/io/utils.h"
 #include "ViennaRNA/params/constants.h"
 #include "ViennaRNA/params/default.h"
+#include "ViennaRNA/params/basic.h"
 #include "ViennaRNA/params/io.h"
 #include "ViennaRNA/static/energy_parameter_sets.h"
 
@@ -34,6 +40,17 @@
 
 PRIVATE char  *last_param_file = NULL;
 
+/* unique identifiers of parameter sets */
+PRIVATE unsigned int param_set_id = 0;
+
+/* the compiled-in energy parameters, new parameter sets start from these */
+PRIVATE vrna_param_set_t *param_set_builtin = NULL;
+
+#if VRNA_WITH_PTHREADS
+PRIVATE pthread_mutex_t  param_set_id_mtx = PTHREAD_MUTEX_INITIALIZER;
+PRIVATE pthread_mutex_t  param_set_builtin_mtx = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
 PRIVATE int   stack_dim[2] = {
   NBPAIRS + 1, NBPAIRS + 1
 };
@@ -99,11 +116,12 @@ ignore_comment(char *line);
 
 
 PRIVATE void
-check_symmetry(void);
+check_symmetry(vrna_param_set_t *set);
 
 
 PRIVATE void
-update_nst(int array[NBPAIRS + 1][NBPAIRS + 1][5][5][5][5]);
+update_nst(int    *data,
+           size_t size);
 
 
 /**
@@ -215,18 +233,21 @@ rd_6dim_slice(char    **content,
 
 
 PRIVATE void
-rd_Tetraloop37(char   **content,
-               size_t *line_no);
+rd_Tetraloop37(vrna_param_set_t *set,
+               char             **content,
+               size_t           *line_no);
 
 
 PRIVATE void
-rd_Triloop37(char   **content,
-             size_t *line_no);
+rd_Triloop37(vrna_param_set_t *set,
+             char             **content,
+             size_t           *line_no);
 
 
 PRIVATE void
-rd_Hexaloop37(char    **content,
-              size_t  *line_no);
+rd_Hexaloop37(vrna_param_set_t *set,
+              char             **content,
+              size_t           *line_no);
 
 
 PRIVATE int
@@ -234,6 +255,38 @@ set_parameters_from_string(char       **file_content,
                            const char *name);
 
 
+PRIVATE void
+parse_parameters(vrna_param_set_t *set,
+                 char             **file_content);
+
+
+PRIVATE vrna_param_set_t *
+param_set_from_array(char       **file_content,
+                     const char *name,
+                     int        from_global);
+
+
+PRIVATE void
+param_set_exchange(vrna_param_set_t *set,
+                   int              to_global);
+
+
+PRIVATE void
+param_set_store_builtin(void);
+
+
+PRIVATE unsigned int
+param_set_new_id(void);
+
+
+PRIVATE char **
+string2array(const char *string);
+
+
+PRIVATE void
+free_array(char **content);
+
+
 PRIVATE char **
 file2array(const char fname[]);
 
@@ -252,7 +305,7 @@ PUBLIC int
 vrna_params_load(const char   fname[],
                  unsigned int options)
 {
-  char  *name, **file_content, **ptr;
+  char  *name, **file_content;
   int   ret;
 
   ret           = 0;
@@ -265,10 +318,7 @@ vrna_params_load(const char   fname[],
                                      (const char *)name);
 
     free(name);
-    for (ptr = file_content; *ptr != NULL; ptr++)
-      free(*ptr);
-
-    free(file_content);
+    free_array(file_content);
   }
 
   return ret;
@@ -291,43 +341,14 @@ vrna_params_load_from_string(const char   *string,
   int ret = 0;
 
   if (string) {
-    char    **params_array, **ptr, *tmp_string, *token, *rest;
-    size_t  lines, lines_mem;
-
-    lines         = lines_mem = 0;
-    params_array  = NULL;
-
-    /* convert string into array of lines */
-    tmp_string = strdup(string);
-
-    token = strtok_r(tmp_string, "\n", &rest);
-
-    while (token != NULL) {
-      if (lines == lines_mem) {
-        lines_mem     += 32768;
-        params_array  = (char **)vrna_realloc(params_array, sizeof(char *) * lines_mem);
-      }
-
-      params_array[lines++] = strdup(token);
-
-      token = strtok_r(NULL, "\n", &rest);
-    }
-
-    /* reallocate to actual requirements */
-    params_array        = (char **)vrna_realloc(params_array, sizeof(char *) * (lines + 1));
-    params_array[lines] = NULL;
+    char **params_array = string2array(string);
 
     /* actually apply parameters */
     ret = set_parameters_from_string(params_array,
                                      name);
 
     /* cleanup memory */
-    free(tmp_string);
-
-    for (ptr = params_array; *ptr != NULL; ptr++)
-      free(*ptr);
-
-    free(params_array);
+    free_array(params_array);
   }
 
   return ret;
@@ -404,6 +425,138 @@ vrna_params_load_DNA_Mathews1999(void)
 }
 
 
+PUBLIC vrna_param_set_t *
+vrna_param_set_current(void)
+{
+  vrna_param_set_t *set;
+
+  set = (vrna_param_set_t *)vrna_alloc(sizeof(vrna_param_set_t));
+
+  param_set_exchange(set, 0);
+
+  set->name = (last_param_file) ? strdup(last_param_file) : NULL;
+  set->id   = param_set_new_id();
+
+  return set;
+}
+
+
+PUBLIC vrna_param_set_t *
+vrna_param_set_load(const char    fname[],
+                    unsigned int  options)
+{
+  char              *name, **file_content;
+  vrna_param_set_t  *set;
+
+  set           = NULL;
+  file_content  = file2array(fname);
+
+  if (file_content) {
+    name = vrna_basename(fname);
+    set  = param_set_from_array(file_content, (const char *)name, 0);
+
+    free(name);
+    free_array(file_content);
+  }
+
+  return set;
+}
+
+
+PUBLIC vrna_param_set_t *
+vrna_param_set_load_from_string(const char    *string,
+                                const char    *name,
+                                unsigned int  options)
+{
+  char              **params_array;
+  vrna_param_set_t  *set;
+
+  set = NULL;
+
+  if (string) {
+    params_array  = string2array(string);
+    set           = param_set_from_array(params_array, name, 0);
+
+    free_array(params_array);
+  }
+
+  return set;
+}
+
+
+PUBLIC vrna_param_set_t *
+vrna_param_set_load_RNA_Turner2004(void)
+{
+  return vrna_param_set_load_from_string(parameter_set_rna_turner2004,
+                                         "RNA - Turner 2004",
+                                         0);
+}
+
+
+PUBLIC vrna_param_set_t *
+vrna_param_set_load_RNA_Turner1999(void)
+{
+  return vrna_param_set_load_from_string(parameter_set_rna_turner1999,
+                                         "RNA - Turner 1999",
+                                         0);
+}
+
+
+PUBLIC vrna_param_set_t *
+vrna_param_set_load_RNA_Andronescu2007(void)
+{
+  return vrna_param_set_load_from_string(parameter_set_rna_andronescu2007,
+                                         "RNA - Andronescu 2007",
+                                         0);
+}
+
+
+PUBLIC vrna_param_set_t *
+vrna_param_set_load_RNA_Langdon2018(void)
+{
+  return vrna_param_set_load_from_string(parameter_set_rna_langdon2018,
+                                         "RNA - Langdon 2018",
+                                         0);
+}
+
+
+PUBLIC vrna_param_set_t *
+vrna_param_set_load_RNA_misc_special_hairpins(void)
+{
+  return vrna_param_set_load_from_string(parameter_set_rna_misc_special_hairpins,
+                                         "RNA - Misc. Special Hairpins",
+                                         0);
+}
+
+
+PUBLIC vrna_param_set_t *
+vrna_param_set_load_DNA_Mathews2004(void)
+{
+  return vrna_param_set_load_from_string(parameter_set_dna_mathews2004,
+                                         "DNA - Mathews 2004",
+                                         0);
+}
+
+
+PUBLIC vrna_param_set_t *
+vrna_param_set_load_DNA_Mathews1999(void)
+{
+  return vrna_param_set_load_from_string(parameter_set_dna_mathews1999,
+                                         "DNA - Mathews 1999",
+                                         0);
+}
+
+
+PUBLIC void
+vrna_param_set_free(vrna_param_set_t *set)
+{
+  if (set) {
+    free(set->name);
+    free(set);
+  }
+}
+
+
 /*
  #####################################
  # BEGIN OF STATIC HELPER FUNCTIONS  #
@@ -450,25 +603,95 @@ file2array(const char fname[])
 }
 
 
+PRIVATE char **
+string2array(const char *string)
+{
+  char    **content, *tmp_string, *token, *rest;
+  size_t  lines, lines_mem;
+
+  lines   = lines_mem = 0;
+  content = NULL;
+
+  /* convert string into array of lines */
+  tmp_string = strdup(string);
+
+  token = strtok_r(tmp_string, "\n", &rest);
+
+  while (token != NULL) {
+    if (lines == lines_mem) {
+      lines_mem += 32768;
+      content   = (char **)vrna_realloc(content, sizeof(char *) * lines_mem);
+    }
+
+    content[lines++] = strdup(token);
+
+    token = strtok_r(NULL, "\n", &rest);
+  }
+
+  /* reallocate to actual requirements */
+  content         = (char **)vrna_realloc(content, sizeof(char *) * (lines + 1));
+  content[lines]  = NULL;
+
+  free(tmp_string);
+
+  return content;
+}
+
+
+PRIVATE void
+free_array(char **content)
+{
+  char **ptr;
+
+  if (content) {
+    for (ptr = content; *ptr != NULL; ptr++)
+      free(*ptr);
+
+    free(content);
+  }
+}
+
+
 PRIVATE int
 set_parameters_from_string(char       **file_content,
                            const char *name)
 {
-  size_t      line_no;
-  char        *line, ident[256];
-  enum parset type;
-  int         r;
-
-  line_no = 0;
+  vrna_param_set_t *set;
 
   if ((!file_content) ||
-      (!file_content[line_no]))
+      (!file_content[0]))
     return 0;
 
+  /* keep the compiled-in parameters for parameter sets loaded later on */
+  param_set_store_builtin();
+
   /* store file name of parameter data set */
   free(last_param_file);
   last_param_file = (name) ? strdup(name) : NULL;
 
+  /* read the new parameters on top of the current ones, then make them the current ones */
+  set = param_set_from_array(file_content, name, 1);
+  param_set_exchange(set, 1);
+  vrna_param_set_free(set);
+
+  /* energy parameters computed from the previous data set are out of date now */
+  vrna_params_cache_clear();
+
+  return 1;
+}
+
+
+PRIVATE void
+parse_parameters(vrna_param_set_t *set,
+                 char             **file_content)
+{
+  size_t      line_no;
+  char        *line, ident[256];
+  enum parset type;
+  int         r;
+
+  line_no = 0;
+
   if (strncmp(file_content[line_no++], "## RNAfold parameter file v2.0", 30) != 0) {
     vrna_message_warning("Missing header line in file.\n"
                          "May be this file has not v2.0 format.\n"
@@ -483,140 +706,142 @@ set_parameters_from_string(char       **file_content,
         case QUIT:
           break;
         case S:
-          rd_2dim(file_content, &line_no, &(stack37[0][0]), stack_dim, stack_shift);
+          rd_2dim(file_content, &line_no, &(set->stack37[0][0]), stack_dim, stack_shift);
           break;
         case S_H:
-          rd_2dim(file_content, &line_no, &(stackdH[0][0]), stack_dim, stack_shift);
+          rd_2dim(file_content, &line_no, &(set->stackdH[0][0]), stack_dim, stack_shift);
           break;
         case HP:
-          rd_1dim(file_content, &line_no, &(hairpin37[0]), 31, 0);
+          rd_1dim(file_content, &line_no, &(set->hairpin37[0]), 31, 0);
           break;
         case HP_H:
-          rd_1dim(file_content, &line_no, &(hairpindH[0]), 31, 0);
+          rd_1dim(file_content, &line_no, &(set->hairpindH[0]), 31, 0);
           break;
         case B:
-          rd_1dim(file_content, &line_no, &(bulge37[0]), 31, 0);
+          rd_1dim(file_content, &line_no, &(set->bulge37[0]), 31, 0);
           break;
         case B_H:
-          rd_1dim(file_content, &line_no, &(bulgedH[0]), 31, 0);
+          rd_1dim(file_content, &line_no, &(set->bulgedH[0]), 31, 0);
           break;
         case IL:
-          rd_1dim(file_content, &line_no, &(internal_loop37[0]), 31, 0);
+          rd_1dim(file_content, &line_no, &(set->internal_loop37[0]), 31, 0);
           break;
         case IL_H:
-          rd_1dim(file_content, &line_no, &(internal_loopdH[0]), 31, 0);
+          rd_1dim(file_content, &line_no, &(set->internal_loopdH[0]), 31, 0);
           break;
         case MME:
-          rd_3dim(file_content, &line_no, &(mismatchExt37[0][0][0]),
+          rd_3dim(file_content, &line_no, &(set->mismatchExt37[0][0][0]),
                   mismatch_dim,
                   mismatch_shift);
           break;
         case MME_H:
-          rd_3dim(file_content, &line_no, &(mismatchExtdH[0][0][0]),
+          rd_3dim(file_content, &line_no, &(set->mismatchExtdH[0][0][0]),
                   mismatch_dim,
                   mismatch_shift);
           break;
         case MMH:
-          rd_3dim(file_content, &line_no, &(mismatchH37[0][0][0]),
+          rd_3dim(file_content, &line_no, &(set->mismatchH37[0][0][0]),
                   mismatch_dim,
                   mismatch_shift);
           break;
         case MMH_H:
-          rd_3dim(file_content, &line_no, &(mismatchHdH[0][0][0]),
+          rd_3dim(file_content, &line_no, &(set->mismatchHdH[0][0][0]),
                   mismatch_dim,
                   mismatch_shift);
           break;
         case MMI:
-          rd_3dim(file_content, &line_no, &(mismatchI37[0][0][0]),
+          rd_3dim(file_content, &line_no, &(set->mismatchI37[0][0][0]),
                   mismatch_dim,
                   mismatch_shift);
           break;
         case MMI_H:
-          rd_3dim(file_content, &line_no, &(mismatchIdH[0][0][0]),
+          rd_3dim(file_content, &line_no, &(set->mismatchIdH[0][0][0]),
                   mismatch_dim,
                   mismatch_shift);
           break;
         case MMI1N:
-          rd_3dim(file_content, &line_no, &(mismatch1nI37[0][0][0]),
+          rd_3dim(file_content, &line_no, &(set->mismatch1nI37[0][0][0]),
                   mismatch_dim,
                   mismatch_shift);
           break;
         case MMI1N_H:
-          rd_3dim(file_content, &line_no, &(mismatch1nIdH[0][0][0]),
+          rd_3dim(file_content, &line_no, &(set->mismatch1nIdH[0][0][0]),
                   mismatch_dim,
                   mismatch_shift);
           break;
         case MMI23:
-          rd_3dim(file_content, &line_no, &(mismatch23I37[0][0][0]),
+          rd_3dim(file_content, &line_no, &(set->mismatch23I37[0][0][0]),
                   mismatch_dim,
                   mismatch_shift);
           break;
         case MMI23_H:
-          rd_3dim(file_content, &line_no, &(mismatch23IdH[0][0][0]),
+          rd_3dim(file_content, &line_no, &(set->mismatch23IdH[0][0][0]),
                   mismatch_dim,
                   mismatch_shift);
           break;
         case MMM:
-          rd_3dim(file_content, &line_no, &(mismatchM37[0][0][0]),
+          rd_3dim(file_content, &line_no, &(set->mismatchM37[0][0][0]),
                   mismatch_dim,
                   mismatch_shift);
           break;
         case MMM_H:
-          rd_3dim(file_content, &line_no, &(mismatchMdH[0][0][0]),
+          rd_3dim(file_content, &line_no, &(set->mismatchMdH[0][0][0]),
                   mismatch_dim,
                   mismatch_shift);
           break;
         case INT11:
-          rd_4dim(file_content, &line_no, &(int11_37[0][0][0][0]),
+          rd_4dim(file_content, &line_no, &(set->int11_37[0][0][0][0]),
                   int11_dim,
                   int11_shift);
           break;
         case INT11_H:
-          rd_4dim(file_content, &line_no, &(int11_dH[0][0][0][0]),
+          rd_4dim(file_content, &line_no, &(set->int11_dH[0][0][0][0]),
                   int11_dim,
                   int11_shift);
           break;
         case INT21:
-          rd_5dim(file_content, &line_no, &(int21_37[0][0][0][0][0]),
+          rd_5dim(file_content, &line_no, &(set->int21_37[0][0][0][0][0]),
                   int21_dim,
                   int21_shift);
           break;
         case INT21_H:
-          rd_5dim(file_content, &line_no, &(int21_dH[0][0][0][0][0]),
+          rd_5dim(file_content, &line_no, &(set->int21_dH[0][0][0][0][0]),
                   int21_dim,
                   int21_shift);
           break;
         case INT22:
-          rd_6dim_slice(file_content, &line_no, &(int22_37[0][0][0][0][0][0]),
+          rd_6dim_slice(file_content, &line_no, &(set->int22_37[0][0][0][0][0][0]),
                         int22_dim,
                         int22_shift,
                         int22_post);
-          update_nst(int22_37);
+          update_nst(&(set->int22_37[0][0][0][0][0][0]),
+                     sizeof(set->int22_37) / sizeof(int));
           break;
         case INT22_H:
-          rd_6dim_slice(file_content, &line_no, &(int22_dH[0][0][0][0][0][0]),
+          rd_6dim_slice(file_content, &line_no, &(set->int22_dH[0][0][0][0][0][0]),
                         int22_dim,
                         int22_shift,
                         int22_post);
-          update_nst(int22_dH);
+          update_nst(&(set->int22_dH[0][0][0][0][0][0]),
+                     sizeof(set->int22_dH) / sizeof(int));
           break;
         case D5:
-          rd_2dim(file_content, &line_no, &(dangle5_37[0][0]),
+          rd_2dim(file_content, &line_no, &(set->dangle5_37[0][0]),
                   dangle_dim,
                   dangle_shift);
           break;
         case D5_H:
-          rd_2dim(file_content, &line_no, &(dangle5_dH[0][0]),
+          rd_2dim(file_content, &line_no, &(set->dangle5_dH[0][0]),
                   dangle_dim,
                   dangle_shift);
           break;
         case D3:
-          rd_2dim(file_content, &line_no, &(dangle3_37[0][0]),
+          rd_2dim(file_content, &line_no, &(set->dangle3_37[0][0]),
                   dangle_dim,
                   dangle_shift);
           break;
         case D3_H:
-          rd_2dim(file_content, &line_no, &(dangle3_dH[0][0]),
+          rd_2dim(file_content, &line_no, &(set->dangle3_dH[0][0]),
                   dangle_dim,
                   dangle_shift);
           break;
@@ -624,41 +849,41 @@ set_parameters_from_string(char       **file_content,
         {
           int values[6];
           rd_1dim(file_content, &line_no, &values[0], 6, 0);
-          ML_BASE37     = values[0];
-          ML_BASEdH     = values[1];
-          ML_closing37  = values[2];
-          ML_closingdH  = values[3];
-          ML_intern37   = values[4];
-          ML_interndH   = values[5];
+          set->ML_BASE37    = values[0];
+          set->ML_BASEdH    = values[1];
+          set->ML_closing37 = values[2];
+          set->ML_closingdH = values[3];
+          set->ML_intern37  = values[4];
+          set->ML_interndH  = values[5];
         }
         break;
         case NIN:
         {
           int values[3];
           rd_1dim(file_content, &line_no, &values[0], 3, 0);
-          ninio37   = values[0];
-          niniodH   = values[1];
-          MAX_NINIO = values[2];
+          set->ninio37    = values[0];
+          set->niniodH    = values[1];
+          set->MAX_NINIO  = values[2];
         }
         break;
         case MISC:
         {
           int values[4];
           rd_1dim(file_content, &line_no, &values[0], 4, 0);
-          DuplexInit37  = values[0];
-          DuplexInitdH  = values[1];
-          TerminalAU37  = values[2];
-          TerminalAUdH  = values[3];
+          set->DuplexInit37 = values[0];
+          set->DuplexInitdH = values[1];
+          set->TerminalAU37 = values[2];
+          set->TerminalAUdH = values[3];
         }
         break;
         case TL:
-          rd_Tetraloop37(file_content, &line_no);
+          rd_Tetraloop37(set, file_content, &line_no);
           break;
         case TRI:
-          rd_Triloop37(file_content, &line_no);
+          rd_Triloop37(set, file_content, &line_no);
           break;
         case HEX:
-          rd_Hexaloop37(file_content, &line_no);
+          rd_Hexaloop37(set, file_content, &line_no);
           break;
         default:      /* do nothing but complain */
           vrna_message_warning("read_epars: Unknown field identifier in `%s'", line);
@@ -666,8 +891,180 @@ set_parameters_from_string(char       **file_content,
     } /* else ignore line */
   }
 
-  check_symmetry();
-  return 1;
+  check_symmetry(set);
+}
+
+
+/*
+ *  Parameter files only list the fields they change, so new parameter sets
+ *  start from the compiled-in parameters, and the global ones from the
+ *  current global parameters (from_global != 0)
+ */
+PRIVATE vrna_param_set_t *
+param_set_from_array(char       **file_content,
+                     const char *name,
+                     int        from_global)
+{
+  vrna_param_set_t *set;
+
+  if ((!file_content) ||
+      (!file_content[0]))
+    return NULL;
+
+  if (from_global) {
+    set = vrna_param_set_current();
+  } else {
+    param_set_store_builtin();
+
+    set = (vrna_param_set_t *)vrna_alloc(sizeof(vrna_param_set_t));
+    memcpy(set, param_set_builtin, sizeof(vrna_param_set_t));
+    set->name = NULL;
+    set->id   = param_set_new_id();
+  }
+
+  parse_parameters(set, file_content);
+
+  free(set->name);
+  set->name = (name) ? strdup(name) : NULL;
+
+  return set;
+}
+
+
+/*
+ *  Copy all raw energy parameters from the global tables into a parameter
+ *  set (to_global == 0), or vice versa (to_global != 0)
+ */
+PRIVATE void
+param_set_exchange(vrna_param_set_t *set,
+                   int              to_global)
+{
+#define EXCHANGE(field)                                       \
+  if (to_global)                                              \
+    memcpy(&(field), &(set->field), sizeof(set->field));      \
+  else                                                        \
+    memcpy(&(set->field), &(field), sizeof(set->field));
+
+  EXCHANGE(stack37);
+  EXCHANGE(stackdH);
+  EXCHANGE(hairpin37);
+  EXCHANGE(hairpindH);
+  EXCHANGE(bulge37);
+  EXCHANGE(bulgedH);
+  EXCHANGE(internal_loop37);
+  EXCHANGE(internal_loopdH);
+  EXCHANGE(mismatchI37);
+  EXCHANGE(mismatchIdH);
+  EXCHANGE(mismatch1nI37);
+  EXCHANGE(mismatch1nIdH);
+  EXCHANGE(mismatch23I37);
+  EXCHANGE(mismatch23IdH);
+  EXCHANGE(mismatchH37);
+  EXCHANGE(mismatchHdH);
+  EXCHANGE(mismatchM37);
+  EXCHANGE(mismatchMdH);
+  EXCHANGE(mismatchExt37);
+  EXCHANGE(mismatchExtdH);
+  EXCHANGE(dangle5_37);
+  EXCHANGE(dangle5_dH);
+  EXCHANGE(dangle3_37);
+  EXCHANGE(dangle3_dH);
+  EXCHANGE(int11_37);
+  EXCHANGE(int11_dH);
+  EXCHANGE(int21_37);
+  EXCHANGE(int21_dH);
+  EXCHANGE(int22_37);
+  EXCHANGE(int22_dH);
+
+  EXCHANGE(lxc37);
+  EXCHANGE(ML_BASE37);
+  EXCHANGE(ML_BASEdH);
+  EXCHANGE(ML_closing37);
+  EXCHANGE(ML_closingdH);
+  EXCHANGE(ML_intern37);
+  EXCHANGE(ML_interndH);
+  EXCHANGE(TripleC37);
+  EXCHANGE(TripleCdH);
+  EXCHANGE(MultipleCA37);
+  EXCHANGE(MultipleCAdH);
+  EXCHANGE(MultipleCB37);
+  EXCHANGE(MultipleCBdH);
+  EXCHANGE(MAX_NINIO);
+  EXCHANGE(ninio37);
+  EXCHANGE(niniodH);
+  EXCHANGE(TerminalAU37);
+  EXCHANGE(TerminalAUdH);
+  EXCHANGE(DuplexInit37);
+  EXCHANGE(DuplexInitdH);
+
+  EXCHANGE(Tetraloops);
+  EXCHANGE(Tetraloop37);
+  EXCHANGE(TetraloopdH);
+  EXCHANGE(Triloops);
+  EXCHANGE(Triloop37);
+  EXCHANGE(TriloopdH);
+  EXCHANGE(Hexaloops);
+  EXCHANGE(Hexaloop37);
+  EXCHANGE(HexaloopdH);
+
+  EXCHANGE(GQuadAlpha37);
+  EXCHANGE(GQuadAlphadH);
+  EXCHANGE(GQuadBeta37);
+  EXCHANGE(GQuadBetadH);
+  EXCHANGE(GQuadLayerMismatch37);
+  EXCHANGE(GQuadLayerMismatchH);
+  EXCHANGE(GQuadLayerMismatchMax);
+
+  EXCHANGE(Tmeasure);
+
+#undef EXCHANGE
+}
+
+
+/*
+ *  Keep a copy of the compiled-in energy parameters. This must happen before
+ *  the global parameters are replaced for the first time.
+ */
+PRIVATE void
+param_set_store_builtin(void)
+{
+#if VRNA_WITH_PTHREADS
+  pthread_mutex_lock(&param_set_builtin_mtx);
+#elif defined(_OPENMP)
+#pragma omp critical (param_set_builtin)
+#endif
+  {
+    if (!param_set_builtin) {
+      param_set_builtin = (vrna_param_set_t *)vrna_alloc(sizeof(vrna_param_set_t));
+      param_set_exchange(param_set_builtin, 0);
+    }
+  }
+
+#if VRNA_WITH_PTHREADS
+  pthread_mutex_unlock(&param_set_builtin_mtx);
+#endif
+}
+
+
+PRIVATE unsigned int
+param_set_new_id(void)
+{
+  unsigned int id;
+
+#if VRNA_WITH_PTHREADS
+  pthread_mutex_lock(&param_set_id_mtx);
+#elif defined(_OPENMP)
+#pragma omp critical (param_set_id)
+#endif
+  {
+    id = ++param_set_id;
+  }
+
+#if VRNA_WITH_PTHREADS
+  pthread_mutex_unlock(&param_set_id_mtx);
+#endif
+
+  return id;
 }
 
 
@@ -1016,24 +1413,25 @@ rd_6dim_slice(char    **content,
 
 /*------------------------------------------------------------*/
 PRIVATE void
-rd_Tetraloop37(char   **content,
-               size_t *line_no)
+rd_Tetraloop37(vrna_param_set_t *set,
+               char             **content,
+               size_t           *line_no)
 {
   int   i, r;
   char  *buf;
 
   i = 0;
   /* erase old tetraloop entries */
-  memset(&Tetraloops, 0, 281);
-  memset(&Tetraloop37, 0, sizeof(int) * 40);
-  memset(&TetraloopdH, 0, sizeof(int) * 40);
+  memset(set->Tetraloops, 0, 281);
+  memset(set->Tetraloop37, 0, sizeof(int) * 40);
+  memset(set->TetraloopdH, 0, sizeof(int) * 40);
   do {
     buf = content[(*line_no)++];
     if (buf == NULL)
       break;
 
-    r = sscanf(buf, "%6s %d %d", &Tetraloops[7 * i], &Tetraloop37[i], &TetraloopdH[i]);
-    strcat(Tetraloops, " ");
+    r = sscanf(buf, "%6s %d %d", &set->Tetraloops[7 * i], &set->Tetraloop37[i], &set->TetraloopdH[i]);
+    strcat(set->Tetraloops, " ");
     i++;
   } while ((r == 3) && (i < 40));
   return;
@@ -1042,24 +1440,25 @@ rd_Tetraloop37(char   **content,
 
 /*------------------------------------------------------------*/
 PRIVATE void
-rd_Hexaloop37(char    **content,
-              size_t  *line_no)
+rd_Hexaloop37(vrna_param_set_t *set,
+              char             **content,
+              size_t           *line_no)
 {
   int   i, r;
   char  *buf;
 
   i = 0;
   /* erase old hexaloop entries */
-  memset(&Hexaloops, 0, 361);
-  memset(&Hexaloop37, 0, sizeof(int) * 40);
-  memset(&HexaloopdH, 0, sizeof(int) * 40);
+  memset(set->Hexaloops, 0, 361);
+  memset(set->Hexaloop37, 0, sizeof(int) * 40);
+  memset(set->HexaloopdH, 0, sizeof(int) * 40);
   do {
     buf = content[(*line_no)++];
     if (buf == NULL)
       break;
 
-    r = sscanf(buf, "%8s %d %d", &Hexaloops[9 * i], &Hexaloop37[i], &HexaloopdH[i]);
-    strcat(Hexaloops, " ");
+    r = sscanf(buf, "%8s %d %d", &set->Hexaloops[9 * i], &set->Hexaloop37[i], &set->HexaloopdH[i]);
+    strcat(set->Hexaloops, " ");
     i++;
   } while ((r == 3) && (i < 40));
   return;
@@ -1068,24 +1467,25 @@ rd_Hexaloop37(char    **content,
 
 /*------------------------------------------------------------*/
 PRIVATE void
-rd_Triloop37(char   **content,
-             size_t *line_no)
+rd_Triloop37(vrna_param_set_t *set,
+             char             **content,
+             size_t           *line_no)
 {
   int   i, r;
   char  *buf;
 
   i = 0;
   /* erase old hexaloop entries */
-  memset(&Triloops, 0, 241);
-  memset(&Triloop37, 0, sizeof(int) * 40);
-  memset(&TriloopdH, 0, sizeof(int) * 40);
+  memset(set->Triloops, 0, 241);
+  memset(set->Triloop37, 0, sizeof(int) * 40);
+  memset(set->TriloopdH, 0, sizeof(int) * 40);
   do {
     buf = content[(*line_no)++];
     if (buf == NULL)
       break;
 
-    r = sscanf(buf, "%5s %d %d", &Triloops[6 * i], &Triloop37[i], &TriloopdH[i]);
-    strcat(Triloops, " ");
+    r = sscanf(buf, "%5s %d %d", &set->Triloops[6 * i], &set->Triloop37[i], &set->TriloopdH[i]);
+    strcat(set->Triloops, " ");
     i++;
   } while ((r == 3) && (i < 40));
   return;
@@ -1122,18 +1522,18 @@ ignore_comment(char *line)
 /*------------------------------------------------------------*/
 
 PRIVATE void
-check_symmetry(void)
+check_symmetry(vrna_param_set_t *set)
 {
   int i, j, k, l;
 
   for (i = 0; i <= NBPAIRS; i++)
     for (j = 0; j <= NBPAIRS; j++)
-      if (stack37[i][j] != stack37[j][i])
+      if (set->stack37[i][j] != set->stack37[j][i])
         vrna_message_warning("stacking energies not symmetric");
 
   for (i = 0; i <= NBPAIRS; i++)
     for (j = 0; j <= NBPAIRS; j++)
-      if (stackdH[i][j] != stackdH[j][i])
+      if (set->stackdH[i][j] != set->stackdH[j][i])
         vrna_message_warning("stacking enthalpies not symmetric");
 
   /* interior 1x1 loops */
@@ -1141,15 +1541,15 @@ check_symmetry(void)
     for (j = 0; j <= NBPAIRS; j++)
       for (k = 0; k < 5; k++)
         for (l = 0; l < 5; l++)
-          if (int11_37[i][j][k][l] != int11_37[j][i][l][k])
+          if (set->int11_37[i][j][k][l] != set->int11_37[j][i][l][k])
             vrna_message_warning("int11 energies not symmetric (%d,%d,%d,%d) (%d vs. %d)",
-                                 i, j, k, l, int11_37[i][j][k][l], int11_37[j][i][l][k]);
+                                 i, j, k, l, set->int11_37[i][j][k][l], set->int11_37[j][i][l][k]);
 
   for (i = 0; i <= NBPAIRS; i++)
     for (j = 0; j <= NBPAIRS; j++)
       for (k = 0; k < 5; k++)
         for (l = 0; l < 5; l++)
-          if (int11_dH[i][j][k][l] != int11_dH[j][i][l][k])
+          if (set->int11_dH[i][j][k][l] != set->int11_dH[j][i][l][k])
             vrna_message_warning("int11 enthalpies not symmetric");
 
   /* interior 2x2 loops */
@@ -1160,7 +1560,7 @@ check_symmetry(void)
           int m, n;
           for (m = 0; m < 5; m++)
             for (n = 0; n < 5; n++)
-              if (int22_37[i][j][k][l][m][n] != int22_37[j][i][m][n][k][l])
+              if (set->int22_37[i][j][k][l][m][n] != set->int22_37[j][i][m][n][k][l])
                 vrna_message_warning("int22 energies not symmetric");
         }
 
@@ -1171,19 +1571,31 @@ check_symmetry(void)
           int m, n;
           for (m = 0; m < 5; m++)
             for (n = 0; n < 5; n++)
-              if (int22_dH[i][j][k][l][m][n] != int22_dH[j][i][m][n][k][l])
+              if (set->int22_dH[i][j][k][l][m][n] != set->int22_dH[j][i][m][n][k][l])
                 vrna_message_warning("int22 enthalpies not symmetric: %d %d %d %d %d %d",
                                      i, j, k, l, m, n);
         }
 }
 
 
-/* update nonstandard nucleotide/basepair involved contributions for int22 */
+/*
+ *  update nonstandard nucleotide/basepair involved contributions for int22,
+ *  data points to the first of size elements of the flattened table
+ */
 PRIVATE void
-update_nst(int array[NBPAIRS + 1][NBPAIRS + 1][5][5][5][5])
+update_nst(int    *data,
+           size_t size)
 {
   int i, j, k, l, m, n;
   int max, max2, max3, max4, max5, max6;
+  int (*array)[NBPAIRS + 1][5][5][5][5];
+
+  if (size != (size_t)(NBPAIRS + 1) * (NBPAIRS + 1) * 5 * 5 * 5 * 5) {
+    vrna_message_warning("update_nst: unexpected size of int22 table");
+    return;
+  }
+
+  array = (int (*)[NBPAIRS + 1][5][5][5][5])data;
 
   /* get maxima for one nonstandard nucleotide */
   for (i = 1; i < NBPAIRS; i++) {
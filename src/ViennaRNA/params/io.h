@@ -13,6 +13,8 @@
 # define DEPRECATED(func, msg) func
 #endif
 
+#include <ViennaRNA/model.h>
+
 /**
  *  @file     ViennaRNA/params/io.h
  *  @ingroup  energy_parameters
@@ -223,6 +225,203 @@ int
 vrna_params_load_DNA_Mathews1999(void);
 
 
+/**
+ *  @brief  Get a copy of the current (global) energy parameters as parameter set
+ *
+ *  The functions of the vrna_params_load() family modify the global energy
+ *  parameter tables that all subsequently created fold compounds rely on.
+ *  Parameter sets, on the other hand, are independent of these global tables.
+ *  They can be attached to the model details (#vrna_md_t.param_set) to create
+ *  fold compounds with different energy parameters, even in concurrent threads.
+ *  For instance:
+ *  @code
+ *  vrna_md_t             md;
+ *  vrna_param_set_t      *set  = vrna_param_set_load_RNA_Andronescu2007();
+ *
+ *  vrna_md_set_default(&md);
+ *  md.param_set = set;
+ *
+ *  vrna_fold_compound_t  *fc   = vrna_fold_compound(sequence, &md, VRNA_OPTION_DEFAULT);
+ *  ...
+ *  vrna_fold_compound_free(fc);
+ *  vrna_param_set_free(set);
+ *  @endcode
+ *
+ *  @note All functions that load parameter sets start from the compiled-in
+ *        default energy parameters (Turner 2004), and only replace those
+ *        parameters present in the file or string. Thus, in contrast to the
+ *        vrna_params_load() family, the result does not depend on any
+ *        parameters loaded into the global tables before.
+ *
+ *  @see  vrna_param_set_load(), vrna_param_set_load_from_string(), vrna_param_set_free(),
+ *        vrna_param_set_load_RNA_Turner2004(), vrna_param_set_load_RNA_Turner1999(),
+ *        vrna_param_set_load_RNA_Andronescu2007(), vrna_param_set_load_RNA_Langdon2018(),
+ *        vrna_param_set_load_RNA_misc_special_hairpins(), vrna_param_set_load_DNA_Mathews2004(),
+ *        vrna_param_set_load_DNA_Mathews1999()
+ *
+ *  @return A new parameter set that holds a copy of the current global energy parameters
+ */
+vrna_param_set_t *
+vrna_param_set_current(void);
+
+
+/**
+ *  @brief  Load energy parameters from a file into a new parameter set
+ *
+ *  In contrast to vrna_params_load(), this function leaves the global energy
+ *  parameters untouched.
+ *
+ *  @see  vrna_param_set_current(), vrna_param_set_load_from_string(), vrna_param_set_free(),
+ *        vrna_params_load()
+ *
+ *  @param  fname   The path to the file containing the energy parameters
+ *  @param  options File format bit-mask (usually #VRNA_PARAMETER_FORMAT_DEFAULT)
+ *  @return         A new parameter set, or @p NULL on failure
+ */
+vrna_param_set_t *
+vrna_param_set_load(const char    fname[],
+                    unsigned int  options);
+
+
+/**
+ *  @brief  Load energy parameters from string into a new parameter set
+ *
+ *  In contrast to vrna_params_load_from_string(), this function leaves the
+ *  global energy parameters untouched.
+ *
+ *  @see  vrna_param_set_current(), vrna_param_set_load(), vrna_param_set_free(),
+ *        vrna_params_load_from_string()
+ *
+ *  @param  string  A 0-terminated string containing energy parameters
+ *  @param  name    A name for the parameter set in @p string (Maybe @p NULL)
+ *  @param  options File format bit-mask (usually #VRNA_PARAMETER_FORMAT_DEFAULT)
+ *  @return         A new parameter set, or @p NULL on failure
+ */
+vrna_param_set_t *
+vrna_param_set_load_from_string(const char    *string,
+                                const char    *name,
+                                unsigned int  options);
+
+
+/**
+ *  @brief  Load the Turner 2004 RNA energy parameter set into a new parameter set
+ *
+ *  @see  vrna_param_set_load(), vrna_param_set_load_from_string(), vrna_param_set_free(),
+ *        vrna_param_set_load_RNA_Turner2004(), vrna_param_set_load_RNA_Turner1999(),
+ *        vrna_param_set_load_RNA_Andronescu2007(), vrna_param_set_load_RNA_Langdon2018(),
+ *        vrna_param_set_load_RNA_misc_special_hairpins(), vrna_param_set_load_DNA_Mathews2004(),
+ *        vrna_param_set_load_DNA_Mathews1999()
+ *
+ *  @return A new parameter set, or @p NULL on failure
+ */
+vrna_param_set_t *
+vrna_param_set_load_RNA_Turner2004(void);
+
+
+/**
+ *  @brief  Load the Turner 1999 RNA energy parameter set into a new parameter set
+ *
+ *  @see  vrna_param_set_load(), vrna_param_set_load_from_string(), vrna_param_set_free(),
+ *        vrna_param_set_load_RNA_Turner2004(), vrna_param_set_load_RNA_Turner1999(),
+ *        vrna_param_set_load_RNA_Andronescu2007(), vrna_param_set_load_RNA_Langdon2018(),
+ *        vrna_param_set_load_RNA_misc_special_hairpins(), vrna_param_set_load_DNA_Mathews2004(),
+ *        vrna_param_set_load_DNA_Mathews1999()
+ *
+ *  @return A new parameter set, or @p NULL on failure
+ */
+vrna_param_set_t *
+vrna_param_set_load_RNA_Turner1999(void);
+
+
+/**
+ *  @brief  Load the Andronescu 2007 RNA energy parameter set into a new parameter set
+ *
+ *  @see  vrna_param_set_load(), vrna_param_set_load_from_string(), vrna_param_set_free(),
+ *        vrna_param_set_load_RNA_Turner2004(), vrna_param_set_load_RNA_Turner1999(),
+ *        vrna_param_set_load_RNA_Andronescu2007(), vrna_param_set_load_RNA_Langdon2018(),
+ *        vrna_param_set_load_RNA_misc_special_hairpins(), vrna_param_set_load_DNA_Mathews2004(),
+ *        vrna_param_set_load_DNA_Mathews1999()
+ *
+ *  @return A new parameter set, or @p NULL on failure
+ */
+vrna_param_set_t *
+vrna_param_set_load_RNA_Andronescu2007(void);
+
+
+/**
+ *  @brief  Load the Langdon 2018 RNA energy parameter set into a new parameter set
+ *
+ *  @see  vrna_param_set_load(), vrna_param_set_load_from_string(), vrna_param_set_free(),
+ *        vrna_param_set_load_RNA_Turner2004(), vrna_param_set_load_RNA_Turner1999(),
+ *        vrna_param_set_load_RNA_Andronescu2007(), vrna_param_set_load_RNA_Langdon2018(),
+ *        vrna_param_set_load_RNA_misc_special_hairpins(), vrna_param_set_load_DNA_Mathews2004(),
+ *        vrna_param_set_load_DNA_Mathews1999()
+ *
+ *  @return A new parameter set, or @p NULL on failure
+ */
+vrna_param_set_t *
+vrna_param_set_load_RNA_Langdon2018(void);
+
+
+/**
+ *  @brief  Load the RNA energy parameter set with additional special hairpins into a new parameter set
+ *
+ *  @see  vrna_param_set_load(), vrna_param_set_load_from_string(), vrna_param_set_free(),
+ *        vrna_param_set_load_RNA_Turner2004(), vrna_param_set_load_RNA_Turner1999(),
+ *        vrna_param_set_load_RNA_Andronescu2007(), vrna_param_set_load_RNA_Langdon2018(),
+ *        vrna_param_set_load_RNA_misc_special_hairpins(), vrna_param_set_load_DNA_Mathews2004(),
+ *        vrna_param_set_load_DNA_Mathews1999()
+ *
+ *  @return A new parameter set, or @p NULL on failure
+ */
+vrna_param_set_t *
+vrna_param_set_load_RNA_misc_special_hairpins(void);
+
+
+/**
+ *  @brief  Load the Mathews 2004 DNA energy parameter set into a new parameter set
+ *
+ *  @see  vrna_param_set_load(), vrna_param_set_load_from_string(), vrna_param_set_free(),
+ *        vrna_param_set_load_RNA_Turner2004(), vrna_param_set_load_RNA_Turner1999(),
+ *        vrna_param_set_load_RNA_Andronescu2007(), vrna_param_set_load_RNA_Langdon2018(),
+ *        vrna_param_set_load_RNA_misc_special_hairpins(), vrna_param_set_load_DNA_Mathews2004(),
+ *        vrna_param_set_load_DNA_Mathews1999()
+ *
+ *  @return A new parameter set, or @p NULL on failure
+ */
+vrna_param_set_t *
+vrna_param_set_load_DNA_Mathews2004(void);
+
+
+/**
+ *  @brief  Load the Mathews 1999 DNA energy parameter set into a new parameter set
+ *
+ *  @see  vrna_param_set_load(), vrna_param_set_load_from_string(), vrna_param_set_free(),
+ *        vrna_param_set_load_RNA_Turner2004(), vrna_param_set_load_RNA_Turner1999(),
+ *        vrna_param_set_load_RNA_Andronescu2007(), vrna_param_set_load_RNA_Langdon2018(),
+ *        vrna_param_set_load_RNA_misc_special_hairpins(), vrna_param_set_load_DNA_Mathews2004(),
+ *        vrna_param_set_load_DNA_Mathews1999()
+ *
+ *  @return A new parameter set, or @p NULL on failure
+ */
+vrna_param_set_t *
+vrna_param_set_load_DNA_Mathews1999(void);
+
+
+/**
+ *  @brief  Release memory occupied by a parameter set
+ *
+ *  @warning  The parameter set must not be released while any fold compound or
+ *            energy parameter data structure created from it is still in use.
+ *
+ *  @see  vrna_param_set_current(), vrna_param_set_load()
+ *
+ *  @param  set   The parameter set to release
+ */
+void
+vrna_param_set_free(vrna_param_set_t *set);
+
+
 #ifndef VRNA_DISABLE_BACKWARD_COMPATIBILITY
 
 /**
@@ -13,12 +13,27 @@
 #include <stdlib.h>
 #include <math.h>
 #include <string.h>
+
+#if VRNA_WITH_PTHREADS
+# include <pthread.h>
+#elif defined(_OPENMP)
+# include <omp.h>
+#endif
+
 #include "ViennaRNA/params/default.h"
 #include "ViennaRNA/fold_vars.h"
 #include "ViennaRNA/utils/basic.h"
 #include "ViennaRNA/params/io.h"
 #include "ViennaRNA/params/basic.h"
 
+#ifndef INLINE
+#ifdef __GNUC__
+# define INLINE inline
+#else
+# define INLINE
+#endif
+#endif
+
 /**
  *** \file ViennaRNA/params/basic.c
  *** <P>
@@ -81,6 +96,53 @@
       ) \
     )
 
+/*
+ *  Maximum number of distinct energy parameter sets kept in the cache
+ */
+#define PARAMS_CACHE_SIZE     8
+
+#define PARAMS_CACHE_MFE      1U
+#define PARAMS_CACHE_EXP      2U
+#define PARAMS_CACHE_EXP_ALI  3U
+
+/*
+ *  A snapshot of the global energy parameter tables, shared by all parameter
+ *  computations that do not use a parameter set of their own. The snapshot is
+ *  replaced whenever the cache is cleared, and released by its last user.
+ */
+typedef struct {
+  vrna_param_set_t  *set;
+  unsigned int      refs;
+  unsigned int      current;
+} params_globals;
+
+
+/*
+ *  An entry of the energy parameter cache. Each entry holds an immutable
+ *  master copy of the parameters for one particular model, which is copied
+ *  whenever the same model is requested again, instead of re-computing all
+ *  tables. Entries are reference counted, such that the master can be copied
+ *  without holding the cache lock. An entry that is removed from the cache
+ *  while it is still in use is released by its last user. Each entry is tagged
+ *  with the cache generation it was computed in, which changes whenever the
+ *  cache is cleared, e.g. due to new global energy parameters.
+ */
+typedef struct params_cache_entry {
+  unsigned int              type;
+  unsigned int              n_seq;
+  double                    temperature;
+  double                    betaScale;
+  int                       dangles;
+  int                       pf_smooth;
+  int                       james_rule;
+  unsigned int              param_set;
+  unsigned int              generation;
+  void                      *master;
+  unsigned int              refs;
+  unsigned int              cached;
+  struct params_cache_entry *next;
+} params_cache_entry;
+
 /*
  #################################
  # PRIVATE VARIABLES             #
@@ -96,6 +158,19 @@ PRIVATE int               pf_id = -1;
 #pragma omp threadprivate(id, pf_id)
 #endif
 
+/* the energy parameter cache is shared among all threads */
+PRIVATE params_cache_entry  *params_cache = NULL;
+PRIVATE unsigned int        params_cache_generation = 0;
+PRIVATE params_globals      *params_globals_current = NULL;
+
+#if VRNA_WITH_PTHREADS
+PRIVATE pthread_mutex_t     params_cache_mtx = PTHREAD_MUTEX_INITIALIZER;
+#elif defined(_OPENMP)
+/* without pthreads, the cache is still shared among OpenMP threads */
+PRIVATE omp_lock_t          params_cache_omp_lock;
+PRIVATE int                 params_cache_omp_lock_init = 0;
+#endif
+
 /*
  #################################
  # PRIVATE FUNCTION DECLARATIONS #
@@ -121,6 +196,41 @@ PRIVATE void
 rescale_params(vrna_fold_compound_t *vc);
 
 
+PRIVATE void *
+get_params_cached(unsigned int  type,
+                  vrna_md_t     *md,
+                  unsigned int  n_seq);
+
+
+PRIVATE void *
+compute_params(unsigned int type,
+               vrna_md_t    *md,
+               unsigned int n_seq);
+
+
+PRIVATE params_cache_entry *
+params_cache_find(unsigned int  type,
+                  vrna_md_t     *md,
+                  unsigned int  n_seq,
+                  unsigned int  param_set);
+
+
+PRIVATE vrna_param_set_t *
+params_globals_acquire(params_globals **globals);
+
+
+PRIVATE void
+params_globals_release(params_globals *globals);
+
+
+PRIVATE INLINE void
+params_cache_lock(void);
+
+
+PRIVATE INLINE void
+params_cache_unlock(void);
+
+
 /*
  #################################
  # BEGIN OF FUNCTION DEFINITIONS #
@@ -130,17 +240,30 @@ PUBLIC vrna_param_t *
 vrna_params(vrna_md_t *md)
 {
   if (md) {
-    return get_scaled_params(md);
+    return (vrna_param_t *)get_params_cached(PARAMS_CACHE_MFE, md, 1);
   } else {
     vrna_md_t md;
     vrna_md_set_default(&md);
-    return get_scaled_params(&md);
+    return (vrna_param_t *)get_params_cached(PARAMS_CACHE_MFE, &md, 1);
   }
 }
 
 
 PUBLIC vrna_exp_param_t *
 vrna_exp_params(vrna_md_t *md)
+{
+  if (md) {
+    return (vrna_exp_param_t *)get_params_cached(PARAMS_CACHE_EXP, md, 1);
+  } else {
+    vrna_md_t md;
+    vrna_md_set_default(&md);
+    return (vrna_exp_param_t *)get_params_cached(PARAMS_CACHE_EXP, &md, 1);
+  }
+}
+
+
+PUBLIC vrna_exp_param_t *
+vrna_exp_params_uncached(vrna_md_t *md)
 {
   if (md) {
     return get_scaled_exp_params(md, -1.);
@@ -157,11 +280,11 @@ vrna_exp_params_comparative(unsigned int  n_seq,
                             vrna_md_t     *md)
 {
   if (md) {
-    return get_exp_params_ali(md, n_seq, -1.);
+    return (vrna_exp_param_t *)get_params_cached(PARAMS_CACHE_EXP_ALI, md, n_seq);
   } else {
     vrna_md_t md;
     vrna_md_set_default(&md);
-    return get_exp_params_ali(&md, n_seq, -1.);
+    return (vrna_exp_param_t *)get_params_cached(PARAMS_CACHE_EXP_ALI, &md, n_seq);
   }
 }
 
@@ -391,53 +514,322 @@ vrna_params_prepare(vrna_fold_compound_t  *fc,
 }
 
 
+PUBLIC void
+vrna_params_cache_clear(void)
+{
+  params_cache_entry *e, *next;
+
+  params_cache_lock();
+
+  /* parameters that are currently computed must not enter the cache anymore */
+  params_cache_generation++;
+
+  for (e = params_cache; e; e = next) {
+    next      = e->next;
+    e->cached = 0;
+    e->next   = NULL;
+    if (e->refs == 0) {
+      free(e->master);
+      free(e);
+    }
+  }
+
+  params_cache = NULL;
+
+  /* the global energy parameters may have changed as well */
+  if (params_globals_current) {
+    params_globals_current->current = 0;
+    if (params_globals_current->refs == 0) {
+      vrna_param_set_free(params_globals_current->set);
+      free(params_globals_current);
+    }
+
+    params_globals_current = NULL;
+  }
+
+  params_cache_unlock();
+}
+
+
 /*
  #####################################
  # BEGIN OF STATIC HELPER FUNCTIONS  #
  #####################################
  */
+PRIVATE INLINE void
+params_cache_lock(void)
+{
+#if VRNA_WITH_PTHREADS
+  pthread_mutex_lock(&params_cache_mtx);
+#elif defined(_OPENMP)
+#pragma omp critical (params_cache_lock_init)
+  {
+    if (!params_cache_omp_lock_init) {
+      omp_init_lock(&params_cache_omp_lock);
+      params_cache_omp_lock_init = 1;
+    }
+  }
+  omp_set_lock(&params_cache_omp_lock);
+#endif
+}
+
+
+PRIVATE INLINE void
+params_cache_unlock(void)
+{
+#if VRNA_WITH_PTHREADS
+  pthread_mutex_unlock(&params_cache_mtx);
+#elif defined(_OPENMP)
+  omp_unset_lock(&params_cache_omp_lock);
+#endif
+}
+
+
+PRIVATE void *
+compute_params(unsigned int type,
+               vrna_md_t    *md,
+               unsigned int n_seq)
+{
+  switch (type) {
+    case PARAMS_CACHE_MFE:
+      return (void *)get_scaled_params(md);
+
+    case PARAMS_CACHE_EXP:
+      return (void *)get_scaled_exp_params(md, -1.);
+
+    case PARAMS_CACHE_EXP_ALI:
+      return (void *)get_exp_params_ali(md, n_seq, -1.);
+
+    default:
+      return NULL;
+  }
+}
+
+
+PRIVATE vrna_param_set_t *
+params_globals_acquire(params_globals **globals)
+{
+  params_cache_lock();
+
+  if (!params_globals_current) {
+    params_globals_current          = (params_globals *)vrna_alloc(sizeof(params_globals));
+    params_globals_current->set     = vrna_param_set_current();
+    params_globals_current->refs    = 0;
+    params_globals_current->current = 1;
+  }
+
+  *globals = params_globals_current;
+  (*globals)->refs++;
+
+  params_cache_unlock();
+
+  return (*globals)->set;
+}
+
+
+PRIVATE void
+params_globals_release(params_globals *globals)
+{
+  if (globals) {
+    params_cache_lock();
+
+    globals->refs--;
+    if ((!globals->current) && (globals->refs == 0)) {
+      vrna_param_set_free(globals->set);
+      free(globals);
+    }
+
+    params_cache_unlock();
+  }
+}
+
+
+/* find a cache entry of the current generation, the cache lock must be held */
+PRIVATE params_cache_entry *
+params_cache_find(unsigned int  type,
+                  vrna_md_t     *md,
+                  unsigned int  n_seq,
+                  unsigned int  param_set)
+{
+  params_cache_entry *e, *prev;
+
+  for (prev = NULL, e = params_cache; e; prev = e, e = e->next)
+    if ((e->generation == params_cache_generation) &&
+        (e->type == type) &&
+        (e->n_seq == n_seq) &&
+        (e->temperature == md->temperature) &&
+        (e->betaScale == md->betaScale) &&
+        (e->dangles == md->dangles) &&
+        (e->pf_smooth == md->pf_smooth) &&
+        (e->james_rule == james_rule) &&
+        (e->param_set == param_set))
+      break;
+
+  /* move entry to the front, such that least recently used entries are evicted first */
+  if ((e) && (prev)) {
+    prev->next    = e->next;
+    e->next       = params_cache;
+    params_cache  = e;
+  }
+
+  return e;
+}
+
+
+/*
+ *  Retrieve a new copy of the energy parameters (or Boltzmann factors) for
+ *  model md. Only the model details that actually affect the parameter tables,
+ *  together with the global james_rule switch read by the parameter builders,
+ *  are used to identify a cache entry. Hence, the copy receives the complete
+ *  model details of the request afterwards.
+ */
+PRIVATE void *
+get_params_cached(unsigned int  type,
+                  vrna_md_t     *md,
+                  unsigned int  n_seq)
+{
+  unsigned int        num, param_set, generation;
+  size_t              size;
+  void                *p;
+  params_cache_entry  *e, *prev, *last;
+
+  size      = (type == PARAMS_CACHE_MFE) ? sizeof(vrna_param_t) : sizeof(vrna_exp_param_t);
+  param_set = (md->param_set) ? md->param_set->id : 0;
+
+  params_cache_lock();
+
+  generation  = params_cache_generation;
+  e           = params_cache_find(type, md, n_seq, param_set);
+
+  if (e)
+    e->refs++;
+
+  params_cache_unlock();
+
+  if (e) {
+    p = vrna_alloc(size);
+    memcpy(p, e->master, size);
+
+    params_cache_lock();
+
+    e->refs--;
+    if ((!e->cached) && (e->refs == 0)) {
+      free(e->master);
+      free(e);
+    }
+
+    params_cache_unlock();
+
+    if (type == PARAMS_CACHE_MFE) {
+      ((vrna_param_t *)p)->model_details  = *md;
+      ((vrna_param_t *)p)->id             = ++id;
+    } else {
+      ((vrna_exp_param_t *)p)->model_details = *md;
+    }
+
+    return p;
+  }
+
+  /* cache miss, compute the parameters and store a master copy */
+  p = compute_params(type, md, n_seq);
+
+  params_cache_lock();
+
+  /*
+   *  do not store the parameters if the cache has been cleared in the meantime,
+   *  or if another thread already stored parameters for the same model
+   */
+  if ((generation != params_cache_generation) ||
+      (params_cache_find(type, md, n_seq, param_set))) {
+    params_cache_unlock();
+    return p;
+  }
+
+  e               = (params_cache_entry *)vrna_alloc(sizeof(params_cache_entry));
+  e->type         = type;
+  e->n_seq        = n_seq;
+  e->temperature  = md->temperature;
+  e->betaScale    = md->betaScale;
+  e->dangles      = md->dangles;
+  e->pf_smooth    = md->pf_smooth;
+  e->james_rule   = james_rule;
+  e->param_set    = param_set;
+  e->generation   = generation;
+  e->master       = vrna_alloc(size);
+  e->refs         = 0;
+  e->cached       = 1;
+  memcpy(e->master, p, size);
+
+  e->next       = params_cache;
+  params_cache  = e;
+
+  /* evict least recently used entries */
+  for (num = 1, last = e; (last->next) && (num < PARAMS_CACHE_SIZE); num++)
+    last = last->next;
+
+  while (last->next) {
+    prev          = last->next;
+    last->next    = prev->next;
+    prev->cached  = 0;
+    prev->next    = NULL;
+    if (prev->refs == 0) {
+      free(prev->master);
+      free(prev);
+    }
+  }
+
+  params_cache_unlock();
+
+  return p;
+}
+
+
 PRIVATE vrna_param_t *
 get_scaled_params(vrna_md_t *md)
 {
-  unsigned int  i, j, k, l;
-  double        tempf;
-  vrna_param_t  *params;
+  unsigned int      i, j, k, l;
+  double            tempf;
+  vrna_param_t      *params;
+  vrna_param_set_t  *ps;
+  params_globals    *globals;
 
-  params = (vrna_param_t *)vrna_alloc(sizeof(vrna_param_t));
+  globals = NULL;
+  ps      = (md->param_set) ? md->param_set : params_globals_acquire(&globals);
+  params  = (vrna_param_t *)vrna_alloc(sizeof(vrna_param_t));
 
   memset(params->param_file, '\0', 256);
-  if (last_parameter_file() != NULL)
-    strncpy(params->param_file, last_parameter_file(), 255);
+  if (ps->name != NULL)
+    strncpy(params->param_file, ps->name, 255);
 
   params->model_details = *md;  /* copy over the model details */
   params->temperature   = md->temperature;
-  tempf                 = ((params->temperature + K0) / Tmeasure);
-
-  params->ninio[2]              = RESCALE_dG(ninio37, niniodH, tempf);
-  params->lxc                   = lxc37 * tempf;
-  params->TripleC               = RESCALE_dG(TripleC37, TripleCdH, tempf);
-  params->MultipleCA            = RESCALE_dG(MultipleCA37, MultipleCAdH, tempf);
-  params->MultipleCB            = RESCALE_dG(MultipleCB37, MultipleCBdH, tempf);
-  params->TerminalAU            = RESCALE_dG(TerminalAU37, TerminalAUdH, tempf);
-  params->DuplexInit            = RESCALE_dG(DuplexInit37, DuplexInitdH, tempf);
-  params->MLbase                = RESCALE_dG(ML_BASE37, ML_BASEdH, tempf);
-  params->MLclosing             = RESCALE_dG(ML_closing37, ML_closingdH, tempf);
-  params->gquadLayerMismatch    = RESCALE_dG(GQuadLayerMismatch37, GQuadLayerMismatchH, tempf);
-  params->gquadLayerMismatchMax = GQuadLayerMismatchMax;
+  tempf                 = ((params->temperature + K0) / ps->Tmeasure);
+
+  params->ninio[2]              = RESCALE_dG(ps->ninio37, ps->niniodH, tempf);
+  params->lxc                   = ps->lxc37 * tempf;
+  params->TripleC               = RESCALE_dG(ps->TripleC37, ps->TripleCdH, tempf);
+  params->MultipleCA            = RESCALE_dG(ps->MultipleCA37, ps->MultipleCAdH, tempf);
+  params->MultipleCB            = RESCALE_dG(ps->MultipleCB37, ps->MultipleCBdH, tempf);
+  params->TerminalAU            = RESCALE_dG(ps->TerminalAU37, ps->TerminalAUdH, tempf);
+  params->DuplexInit            = RESCALE_dG(ps->DuplexInit37, ps->DuplexInitdH, tempf);
+  params->MLbase                = RESCALE_dG(ps->ML_BASE37, ps->ML_BASEdH, tempf);
+  params->MLclosing             = RESCALE_dG(ps->ML_closing37, ps->ML_closingdH, tempf);
+  params->gquadLayerMismatch    = RESCALE_dG(ps->GQuadLayerMismatch37, ps->GQuadLayerMismatchH, tempf);
+  params->gquadLayerMismatchMax = ps->GQuadLayerMismatchMax;
 
   for (i = VRNA_GQUAD_MIN_STACK_SIZE; i <= VRNA_GQUAD_MAX_STACK_SIZE; i++)
     for (j = 3 * VRNA_GQUAD_MIN_LINKER_LENGTH; j <= 3 * VRNA_GQUAD_MAX_LINKER_LENGTH; j++) {
-      double  GQuadAlpha_T  = RESCALE_dG(GQuadAlpha37, GQuadAlphadH, tempf);
-      double  GQuadBeta_T   = RESCALE_dG(GQuadBeta37, GQuadBetadH, tempf);
+      double  GQuadAlpha_T  = RESCALE_dG(ps->GQuadAlpha37, ps->GQuadAlphadH, tempf);
+      double  GQuadBeta_T   = RESCALE_dG(ps->GQuadBeta37, ps->GQuadBetadH, tempf);
       params->gquad[i][j] = (int)GQuadAlpha_T * (i - 1) + (int)(((double)GQuadBeta_T) * log(j - 2));
     }
 
   for (i = 0; i < 31; i++)
-    params->hairpin[i] = RESCALE_dG(hairpin37[i], hairpindH[i], tempf);
+    params->hairpin[i] = RESCALE_dG(ps->hairpin37[i], ps->hairpindH[i], tempf);
 
   for (i = 0; i <= MIN2(30, MAXLOOP); i++) {
-    params->bulge[i]          = RESCALE_dG(bulge37[i], bulgedH[i], tempf);
-    params->internal_loop[i]  = RESCALE_dG(internal_loop37[i], internal_loopdH[i], tempf);
+    params->bulge[i]          = RESCALE_dG(ps->bulge37[i], ps->bulgedH[i], tempf);
+    params->internal_loop[i]  = RESCALE_dG(ps->internal_loop37[i], ps->internal_loopdH[i], tempf);
   }
 
   for (; i <= MAXLOOP; i++) {
@@ -447,23 +839,23 @@ get_scaled_params(vrna_md_t *md)
                                (int)(params->lxc * log((double)(i) / 30.));
   }
 
-  for (i = 0; (i * 7) < strlen(Tetraloops); i++)
-    params->Tetraloop_E[i] = RESCALE_dG(Tetraloop37[i], TetraloopdH[i], tempf);
+  for (i = 0; (i * 7) < strlen(ps->Tetraloops); i++)
+    params->Tetraloop_E[i] = RESCALE_dG(ps->Tetraloop37[i], ps->TetraloopdH[i], tempf);
 
-  for (i = 0; (i * 5) < strlen(Triloops); i++)
-    params->Triloop_E[i] = RESCALE_dG(Triloop37[i], TriloopdH[i], tempf);
+  for (i = 0; (i * 5) < strlen(ps->Triloops); i++)
+    params->Triloop_E[i] = RESCALE_dG(ps->Triloop37[i], ps->TriloopdH[i], tempf);
 
-  for (i = 0; (i * 9) < strlen(Hexaloops); i++)
-    params->Hexaloop_E[i] = RESCALE_dG(Hexaloop37[i], HexaloopdH[i], tempf);
+  for (i = 0; (i * 9) < strlen(ps->Hexaloops); i++)
+    params->Hexaloop_E[i] = RESCALE_dG(ps->Hexaloop37[i], ps->HexaloopdH[i], tempf);
 
   for (i = 0; i <= NBPAIRS; i++)
-    params->MLintern[i] = RESCALE_dG(ML_intern37, ML_interndH, tempf);
+    params->MLintern[i] = RESCALE_dG(ps->ML_intern37, ps->ML_interndH, tempf);
 
   /* stacks    G(T) = H - [H - G(T0)]*T/T0 */
   for (i = 0; i <= NBPAIRS; i++)
     for (j = 0; j <= NBPAIRS; j++)
-      params->stack[i][j] = RESCALE_dG(stack37[i][j],
-                                       stackdH[i][j],
+      params->stack[i][j] = RESCALE_dG(ps->stack37[i][j],
+                                       ps->stackdH[i][j],
                                        tempf);
 
   /* mismatches */
@@ -471,25 +863,25 @@ get_scaled_params(vrna_md_t *md)
     for (j = 0; j < 5; j++)
       for (k = 0; k < 5; k++) {
         int mm;
-        params->mismatchI[i][j][k] = RESCALE_dG(mismatchI37[i][j][k],
-                                                mismatchIdH[i][j][k],
+        params->mismatchI[i][j][k] = RESCALE_dG(ps->mismatchI37[i][j][k],
+                                                ps->mismatchIdH[i][j][k],
                                                 tempf);
-        params->mismatchH[i][j][k] = RESCALE_dG(mismatchH37[i][j][k],
-                                                mismatchHdH[i][j][k],
+        params->mismatchH[i][j][k] = RESCALE_dG(ps->mismatchH37[i][j][k],
+                                                ps->mismatchHdH[i][j][k],
                                                 tempf);
-        params->mismatch1nI[i][j][k] = RESCALE_dG(mismatch1nI37[i][j][k],
-                                                  mismatch1nIdH[i][j][k],
+        params->mismatch1nI[i][j][k] = RESCALE_dG(ps->mismatch1nI37[i][j][k],
+                                                  ps->mismatch1nIdH[i][j][k],
                                                   tempf);
-        params->mismatch23I[i][j][k] = RESCALE_dG(mismatch23I37[i][j][k],
-                                                  mismatch23IdH[i][j][k],
+        params->mismatch23I[i][j][k] = RESCALE_dG(ps->mismatch23I37[i][j][k],
+                                                  ps->mismatch23IdH[i][j][k],
                                                   tempf);
         if (md->dangles) {
-          mm = RESCALE_dG(mismatchM37[i][j][k],
-                          mismatchMdH[i][j][k],
+          mm = RESCALE_dG(ps->mismatchM37[i][j][k],
+                          ps->mismatchMdH[i][j][k],
                           tempf);
           params->mismatchM[i][j][k]  = (mm > 0) ? 0 : mm;
-          mm                          = RESCALE_dG(mismatchExt37[i][j][k],
-                                                   mismatchExtdH[i][j][k],
+          mm                          = RESCALE_dG(ps->mismatchExt37[i][j][k],
+                                                   ps->mismatchExtdH[i][j][k],
                                                    tempf);
           params->mismatchExt[i][j][k] = (mm > 0) ? 0 : mm;
         } else {
@@ -501,12 +893,12 @@ get_scaled_params(vrna_md_t *md)
   for (i = 0; i <= NBPAIRS; i++)
     for (j = 0; j < 5; j++) {
       int dd;
-      dd = RESCALE_dG(dangle5_37[i][j],
-                      dangle5_dH[i][j],
+      dd = RESCALE_dG(ps->dangle5_37[i][j],
+                      ps->dangle5_dH[i][j],
                       tempf);
       params->dangle5[i][j] = (dd > 0) ? 0 : dd;  /* must be <= 0 */
-      dd                    = RESCALE_dG(dangle3_37[i][j],
-                                         dangle3_dH[i][j],
+      dd                    = RESCALE_dG(ps->dangle3_37[i][j],
+                                         ps->dangle3_dH[i][j],
                                          tempf);
       params->dangle3[i][j] = (dd > 0) ? 0 : dd;  /* must be <= 0 */
     }
@@ -516,8 +908,8 @@ get_scaled_params(vrna_md_t *md)
     for (j = 0; j <= NBPAIRS; j++)
       for (k = 0; k < 5; k++)
         for (l = 0; l < 5; l++)
-          params->int11[i][j][k][l] = RESCALE_dG(int11_37[i][j][k][l],
-                                                 int11_dH[i][j][k][l],
+          params->int11[i][j][k][l] = RESCALE_dG(ps->int11_37[i][j][k][l],
+                                                 ps->int11_dH[i][j][k][l],
                                                  tempf);
 
   /* interior 2x1 loops */
@@ -527,8 +919,8 @@ get_scaled_params(vrna_md_t *md)
         for (l = 0; l < 5; l++) {
           int m;
           for (m = 0; m < 5; m++)
-            params->int21[i][j][k][l][m] = RESCALE_dG(int21_37[i][j][k][l][m],
-                                                      int21_dH[i][j][k][l][m],
+            params->int21[i][j][k][l][m] = RESCALE_dG(ps->int21_37[i][j][k][l][m],
+                                                      ps->int21_dH[i][j][k][l][m],
                                                       tempf);
         }
 
@@ -540,14 +932,16 @@ get_scaled_params(vrna_md_t *md)
           int m, n;
           for (m = 0; m < 5; m++)
             for (n = 0; n < 5; n++)
-              params->int22[i][j][k][l][m][n] = RESCALE_dG(int22_37[i][j][k][l][m][n],
-                                                           int22_dH[i][j][k][l][m][n],
+              params->int22[i][j][k][l][m][n] = RESCALE_dG(ps->int22_37[i][j][k][l][m][n],
+                                                           ps->int22_dH[i][j][k][l][m][n],
                                                            tempf);
         }
 
-  strncpy(params->Tetraloops, Tetraloops, 281);
-  strncpy(params->Triloops, Triloops, 241);
-  strncpy(params->Hexaloops, Hexaloops, 361);
+  strncpy(params->Tetraloops, ps->Tetraloops, 281);
+  strncpy(params->Triloops, ps->Triloops, 241);
+  strncpy(params->Hexaloops, ps->Hexaloops, 361);
+
+  params_globals_release(globals);
 
   params->id = ++id;
   return params;
@@ -563,12 +957,16 @@ get_scaled_exp_params(vrna_md_t *md,
   double            kT, TT;
   double            GT;
   vrna_exp_param_t  *pf;
+  vrna_param_set_t  *ps;
+  params_globals    *globals;
 
-  pf = (vrna_exp_param_t *)vrna_alloc(sizeof(vrna_exp_param_t));
+  globals = NULL;
+  ps      = (md->param_set) ? md->param_set : params_globals_acquire(&globals);
+  pf  = (vrna_exp_param_t *)vrna_alloc(sizeof(vrna_exp_param_t));
 
   memset(pf->param_file, '\0', 256);
-  if (last_parameter_file() != NULL)
-    strncpy(pf->param_file, last_parameter_file(), 255);
+  if (ps->name != NULL)
+    strncpy(pf->param_file, ps->name, 255);
 
   pf->model_details = *md;
   pf->temperature   = md->temperature;
@@ -576,20 +974,20 @@ get_scaled_exp_params(vrna_md_t *md,
   pf->kT            = kT = md->betaScale * (md->temperature + K0) * GASCONST; /* kT in cal/mol  */
   pf->pf_scale      = pfs;
   pf_smooth         = md->pf_smooth;
-  TT                = (md->temperature + K0) / (Tmeasure);
+  TT                = (md->temperature + K0) / (ps->Tmeasure);
 
-  pf->lxc                   = lxc37 * TT;
-  pf->expDuplexInit         = RESCALE_BF(DuplexInit37, DuplexInitdH, TT, kT);
-  pf->expTermAU             = RESCALE_BF(TerminalAU37, TerminalAUdH, TT, kT);
-  pf->expMLbase             = RESCALE_BF(ML_BASE37, ML_BASEdH, TT, kT);
-  pf->expMLclosing          = RESCALE_BF(ML_closing37, ML_closingdH, TT, kT);
-  pf->expgquadLayerMismatch = RESCALE_BF(GQuadLayerMismatch37, GQuadLayerMismatchH, TT, kT);
-  pf->gquadLayerMismatchMax = GQuadLayerMismatchMax;
+  pf->lxc                   = ps->lxc37 * TT;
+  pf->expDuplexInit         = RESCALE_BF(ps->DuplexInit37, ps->DuplexInitdH, TT, kT);
+  pf->expTermAU             = RESCALE_BF(ps->TerminalAU37, ps->TerminalAUdH, TT, kT);
+  pf->expMLbase             = RESCALE_BF(ps->ML_BASE37, ps->ML_BASEdH, TT, kT);
+  pf->expMLclosing          = RESCALE_BF(ps->ML_closing37, ps->ML_closingdH, TT, kT);
+  pf->expgquadLayerMismatch = RESCALE_BF(ps->GQuadLayerMismatch37, ps->GQuadLayerMismatchH, TT, kT);
+  pf->gquadLayerMismatchMax = ps->GQuadLayerMismatchMax;
 
   for (i = VRNA_GQUAD_MIN_STACK_SIZE; i <= VRNA_GQUAD_MAX_STACK_SIZE; i++)
     for (j = 3 * VRNA_GQUAD_MIN_LINKER_LENGTH; j <= 3 * VRNA_GQUAD_MAX_LINKER_LENGTH; j++) {
-      double  GQuadAlpha_T  = RESCALE_dG(GQuadAlpha37, GQuadAlphadH, TT);
-      double  GQuadBeta_T   = RESCALE_dG(GQuadBeta37, GQuadBetadH, TT);
+      double  GQuadAlpha_T  = RESCALE_dG(ps->GQuadAlpha37, ps->GQuadAlphadH, TT);
+      double  GQuadBeta_T   = RESCALE_dG(ps->GQuadBeta37, ps->GQuadBetadH, TT);
       GT = ((double)GQuadAlpha_T) * ((double)(i - 1)) + ((double)GQuadBeta_T) *
            log(((double)j) - 2.);
       pf->expgquad[i][j] = exp(-TRUNC_MAYBE(GT) * 10. / kT);
@@ -597,44 +995,44 @@ get_scaled_exp_params(vrna_md_t *md,
 
   /* loop energies: hairpins, bulges, interior, mulit-loops */
   for (i = 0; i < 31; i++)
-    pf->exphairpin[i] = RESCALE_BF(hairpin37[i], hairpindH[i], TT, kT);
+    pf->exphairpin[i] = RESCALE_BF(ps->hairpin37[i], ps->hairpindH[i], TT, kT);
 
   for (i = 0; i <= MIN2(30, MAXLOOP); i++) {
-    pf->expbulge[i]     = RESCALE_BF(bulge37[i], bulgedH[i], TT, kT);
-    pf->expinternal[i]  = RESCALE_BF(internal_loop37[i], internal_loopdH[i], TT, kT);
+    pf->expbulge[i]     = RESCALE_BF(ps->bulge37[i], ps->bulgedH[i], TT, kT);
+    pf->expinternal[i]  = RESCALE_BF(ps->internal_loop37[i], ps->internal_loopdH[i], TT, kT);
   }
 
   /* special case of size 2 interior loops (single mismatch) */
   if (james_rule)
     pf->expinternal[2] = exp(-80 * 10. / kT);
 
-  GT = RESCALE_dG(bulge37[30],
-                  bulgedH[30],
+  GT = RESCALE_dG(ps->bulge37[30],
+                  ps->bulgedH[30],
                   TT);
   for (i = 31; i <= MAXLOOP; i++)
     pf->expbulge[i] = exp(-TRUNC_MAYBE(GT + (pf->lxc * log(i / 30.))) * 10. / kT);
 
-  GT = RESCALE_dG(internal_loop37[30],
-                  internal_loopdH[30],
+  GT = RESCALE_dG(ps->internal_loop37[30],
+                  ps->internal_loopdH[30],
                   TT);
   for (i = 31; i <= MAXLOOP; i++)
     pf->expinternal[i] = exp(-TRUNC_MAYBE(GT + (pf->lxc * log(i / 30.))) * 10. / kT);
 
-  GT = RESCALE_dG(ninio37, niniodH, TT);
+  GT = RESCALE_dG(ps->ninio37, ps->niniodH, TT);
   for (j = 0; j <= MAXLOOP; j++)
-    pf->expninio[2][j] = exp(-MIN2(MAX_NINIO, j * TRUNC_MAYBE(GT)) * 10. / kT);
+    pf->expninio[2][j] = exp(-MIN2(ps->MAX_NINIO, j * TRUNC_MAYBE(GT)) * 10. / kT);
 
-  for (i = 0; (i * 7) < strlen(Tetraloops); i++)
-    pf->exptetra[i] = RESCALE_BF(Tetraloop37[i], TetraloopdH[i], TT, kT);
+  for (i = 0; (i * 7) < strlen(ps->Tetraloops); i++)
+    pf->exptetra[i] = RESCALE_BF(ps->Tetraloop37[i], ps->TetraloopdH[i], TT, kT);
 
-  for (i = 0; (i * 5) < strlen(Triloops); i++)
-    pf->exptri[i] = RESCALE_BF(Triloop37[i], TriloopdH[i], TT, kT);
+  for (i = 0; (i * 5) < strlen(ps->Triloops); i++)
+    pf->exptri[i] = RESCALE_BF(ps->Triloop37[i], ps->TriloopdH[i], TT, kT);
 
-  for (i = 0; (i * 9) < strlen(Hexaloops); i++)
-    pf->exphex[i] = RESCALE_BF(Hexaloop37[i], HexaloopdH[i], TT, kT);
+  for (i = 0; (i * 9) < strlen(ps->Hexaloops); i++)
+    pf->exphex[i] = RESCALE_BF(ps->Hexaloop37[i], ps->HexaloopdH[i], TT, kT);
 
   for (i = 0; i <= NBPAIRS; i++)
-    pf->expMLintern[i] = RESCALE_BF(ML_intern37, ML_interndH, TT, kT);
+    pf->expMLintern[i] = RESCALE_BF(ps->ML_intern37, ps->ML_interndH, TT, kT);
 
   /* if dangles==0 just set their energy to 0,
    * don't let dangle energies become > 0 (at large temps),
@@ -642,8 +1040,8 @@ get_scaled_exp_params(vrna_md_t *md,
   for (i = 0; i <= NBPAIRS; i++)
     for (j = 0; j <= 4; j++) {
       if (md->dangles) {
-        pf->expdangle5[i][j]  = RESCALE_BF_SMOOTH(dangle5_37[i][j], dangle5_dH[i][j], TT, kT);
-        pf->expdangle3[i][j]  = RESCALE_BF_SMOOTH(dangle3_37[i][j], dangle3_dH[i][j], TT, kT);
+        pf->expdangle5[i][j]  = RESCALE_BF_SMOOTH(ps->dangle5_37[i][j], ps->dangle5_dH[i][j], TT, kT);
+        pf->expdangle3[i][j]  = RESCALE_BF_SMOOTH(ps->dangle3_37[i][j], ps->dangle3_dH[i][j], TT, kT);
       } else {
         pf->expdangle3[i][j] = pf->expdangle5[i][j] = 1;
       }
@@ -652,36 +1050,36 @@ get_scaled_exp_params(vrna_md_t *md,
   /* stacking energies */
   for (i = 0; i <= NBPAIRS; i++)
     for (j = 0; j <= NBPAIRS; j++)
-      pf->expstack[i][j] = RESCALE_BF(stack37[i][j], stackdH[i][j], TT, kT);
+      pf->expstack[i][j] = RESCALE_BF(ps->stack37[i][j], ps->stackdH[i][j], TT, kT);
 
   /* mismatch energies */
   for (i = 0; i <= NBPAIRS; i++)
     for (j = 0; j < 5; j++)
       for (k = 0; k < 5; k++) {
-        pf->expmismatchI[i][j][k] = RESCALE_BF(mismatchI37[i][j][k],
-                                               mismatchIdH[i][j][k],
+        pf->expmismatchI[i][j][k] = RESCALE_BF(ps->mismatchI37[i][j][k],
+                                               ps->mismatchIdH[i][j][k],
                                                TT,
                                                kT);
-        pf->expmismatch1nI[i][j][k] = RESCALE_BF(mismatch1nI37[i][j][k],
-                                                 mismatch1nIdH[i][j][k],
+        pf->expmismatch1nI[i][j][k] = RESCALE_BF(ps->mismatch1nI37[i][j][k],
+                                                 ps->mismatch1nIdH[i][j][k],
                                                  TT,
                                                  kT);
-        pf->expmismatchH[i][j][k] = RESCALE_BF(mismatchH37[i][j][k],
-                                               mismatchHdH[i][j][k],
+        pf->expmismatchH[i][j][k] = RESCALE_BF(ps->mismatchH37[i][j][k],
+                                               ps->mismatchHdH[i][j][k],
                                                TT,
                                                kT);
-        pf->expmismatch23I[i][j][k] = RESCALE_BF(mismatch23I37[i][j][k],
-                                                 mismatch23IdH[i][j][k],
+        pf->expmismatch23I[i][j][k] = RESCALE_BF(ps->mismatch23I37[i][j][k],
+                                                 ps->mismatch23IdH[i][j][k],
                                                  TT,
                                                  kT);
 
         if (md->dangles) {
-          pf->expmismatchM[i][j][k] = RESCALE_BF_SMOOTH(mismatchM37[i][j][k],
-                                                        mismatchMdH[i][j][k],
+          pf->expmismatchM[i][j][k] = RESCALE_BF_SMOOTH(ps->mismatchM37[i][j][k],
+                                                        ps->mismatchMdH[i][j][k],
                                                         TT,
                                                         kT);
-          pf->expmismatchExt[i][j][k] = RESCALE_BF_SMOOTH(mismatchExt37[i][j][k],
-                                                          mismatchExtdH[i][j][k],
+          pf->expmismatchExt[i][j][k] = RESCALE_BF_SMOOTH(ps->mismatchExt37[i][j][k],
+                                                          ps->mismatchExtdH[i][j][k],
                                                           TT,
                                                           kT);
         } else {
@@ -694,8 +1092,8 @@ get_scaled_exp_params(vrna_md_t *md,
     for (j = 0; j <= NBPAIRS; j++)
       for (k = 0; k < 5; k++)
         for (l = 0; l < 5; l++) {
-          pf->expint11[i][j][k][l] = RESCALE_BF(int11_37[i][j][k][l],
-                                                int11_dH[i][j][k][l],
+          pf->expint11[i][j][k][l] = RESCALE_BF(ps->int11_37[i][j][k][l],
+                                                ps->int11_dH[i][j][k][l],
                                                 TT,
                                                 kT);
         }
@@ -707,8 +1105,8 @@ get_scaled_exp_params(vrna_md_t *md,
         for (l = 0; l < 5; l++) {
           int m;
           for (m = 0; m < 5; m++) {
-            pf->expint21[i][j][k][l][m] = RESCALE_BF(int21_37[i][j][k][l][m],
-                                                     int21_dH[i][j][k][l][m],
+            pf->expint21[i][j][k][l][m] = RESCALE_BF(ps->int21_37[i][j][k][l][m],
+                                                     ps->int21_dH[i][j][k][l][m],
                                                      TT,
                                                      kT);
           }
@@ -722,16 +1120,18 @@ get_scaled_exp_params(vrna_md_t *md,
           int m, n;
           for (m = 0; m < 5; m++)
             for (n = 0; n < 5; n++) {
-              pf->expint22[i][j][k][l][m][n] = RESCALE_BF(int22_37[i][j][k][l][m][n],
-                                                          int22_dH[i][j][k][l][m][n],
+              pf->expint22[i][j][k][l][m][n] = RESCALE_BF(ps->int22_37[i][j][k][l][m][n],
+                                                          ps->int22_dH[i][j][k][l][m][n],
                                                           TT,
                                                           kT);
             }
         }
 
-  strncpy(pf->Tetraloops, Tetraloops, 281);
-  strncpy(pf->Triloops, Triloops, 241);
-  strncpy(pf->Hexaloops, Hexaloops, 361);
+  strncpy(pf->Tetraloops, ps->Tetraloops, 281);
+  strncpy(pf->Triloops, ps->Triloops, 241);
+  strncpy(pf->Hexaloops, ps->Hexaloops, 361);
+
+  params_globals_release(globals);
 
   return pf;
 }
@@ -748,7 +1148,11 @@ get_exp_params_ali(vrna_md_t    *md,
   double            kTn, TT;
   double            GT;
   vrna_exp_param_t  *pf;
+  vrna_param_set_t  *ps;
+  params_globals    *globals;
 
+  globals           = NULL;
+  ps                = (md->param_set) ? md->param_set : params_globals_acquire(&globals);
   pf                = (vrna_exp_param_t *)vrna_alloc(sizeof(vrna_exp_param_t));
   pf->model_details = *md;
   pf->alpha         = md->betaScale;
@@ -756,20 +1160,20 @@ get_exp_params_ali(vrna_md_t    *md,
   pf->pf_scale      = pfs;
   pf->kT            = kTn = ((double)n_seq) * md->betaScale * (md->temperature + K0) * GASCONST; /* kT in cal/mol  */
   pf_smooth         = md->pf_smooth;
-  TT                = (md->temperature + K0) / (Tmeasure);
+  TT                = (md->temperature + K0) / (ps->Tmeasure);
 
-  pf->lxc                   = lxc37 * TT;
-  pf->expDuplexInit         = RESCALE_BF(DuplexInit37, DuplexInitdH, TT, kTn);
-  pf->expTermAU             = RESCALE_BF(TerminalAU37, TerminalAUdH, TT, kTn);
-  pf->expMLbase             = RESCALE_BF(ML_BASE37, ML_BASEdH, TT, kTn / n_seq);
-  pf->expMLclosing          = RESCALE_BF(ML_closing37, ML_closingdH, TT, kTn);
-  pf->expgquadLayerMismatch = RESCALE_BF(GQuadLayerMismatch37, GQuadLayerMismatchH, TT, kTn);
-  pf->gquadLayerMismatchMax = GQuadLayerMismatchMax;
+  pf->lxc                   = ps->lxc37 * TT;
+  pf->expDuplexInit         = RESCALE_BF(ps->DuplexInit37, ps->DuplexInitdH, TT, kTn);
+  pf->expTermAU             = RESCALE_BF(ps->TerminalAU37, ps->TerminalAUdH, TT, kTn);
+  pf->expMLbase             = RESCALE_BF(ps->ML_BASE37, ps->ML_BASEdH, TT, kTn / n_seq);
+  pf->expMLclosing          = RESCALE_BF(ps->ML_closing37, ps->ML_closingdH, TT, kTn);
+  pf->expgquadLayerMismatch = RESCALE_BF(ps->GQuadLayerMismatch37, ps->GQuadLayerMismatchH, TT, kTn);
+  pf->gquadLayerMismatchMax = ps->GQuadLayerMismatchMax;
 
   for (i = VRNA_GQUAD_MIN_STACK_SIZE; i <= VRNA_GQUAD_MAX_STACK_SIZE; i++)
     for (j = 3 * VRNA_GQUAD_MIN_LINKER_LENGTH; j <= 3 * VRNA_GQUAD_MAX_LINKER_LENGTH; j++) {
-      double  GQuadAlpha_T  = RESCALE_dG(GQuadAlpha37, GQuadAlphadH, TT);
-      double  GQuadBeta_T   = RESCALE_dG(GQuadBeta37, GQuadBetadH, TT);
+      double  GQuadAlpha_T  = RESCALE_dG(ps->GQuadAlpha37, ps->GQuadAlphadH, TT);
+      double  GQuadBeta_T   = RESCALE_dG(ps->GQuadBeta37, ps->GQuadBetadH, TT);
       GT = ((double)GQuadAlpha_T) * ((double)(i - 1)) + ((double)GQuadBeta_T) *
            log(((double)j) - 2.);
       pf->expgquad[i][j] = exp(-TRUNC_MAYBE(GT) * 10. / kTn);
@@ -777,7 +1181,7 @@ get_exp_params_ali(vrna_md_t    *md,
 
   /* loop energies: hairpins, bulges, interior, mulit-loops */
   for (i = 0; i < 31; i++)
-    pf->exphairpin[i] = RESCALE_BF(hairpin37[i], hairpindH[i], TT, kTn);
+    pf->exphairpin[i] = RESCALE_BF(ps->hairpin37[i], ps->hairpindH[i], TT, kTn);
   /*add penalty for too short hairpins*/
   for (i = 0; i < 3; i++) {
     GT                = 600 /*Penalty*/ * TT;
@@ -785,38 +1189,38 @@ get_exp_params_ali(vrna_md_t    *md,
   }
 
   for (i = 0; i <= MIN2(30, MAXLOOP); i++) {
-    pf->expbulge[i]     = RESCALE_BF(bulge37[i], bulgedH[i], TT, kTn);
-    pf->expinternal[i]  = RESCALE_BF(internal_loop37[i], internal_loopdH[i], TT, kTn);
+    pf->expbulge[i]     = RESCALE_BF(ps->bulge37[i], ps->bulgedH[i], TT, kTn);
+    pf->expinternal[i]  = RESCALE_BF(ps->internal_loop37[i], ps->internal_loopdH[i], TT, kTn);
   }
 
   /* special case of size 2 interior loops (single mismatch) */
   if (james_rule)
     pf->expinternal[2] = exp(-80 * 10. / kTn);
 
-  GT = RESCALE_dG(bulge37[30], bulgedH[30], TT);
+  GT = RESCALE_dG(ps->bulge37[30], ps->bulgedH[30], TT);
   for (i = 31; i <= MAXLOOP; i++)
     pf->expbulge[i] = exp(-(GT + (pf->lxc * log(i / 30.))) * 10. / kTn);
 
-  GT = RESCALE_dG(internal_loop37[30], internal_loopdH[30], TT);
+  GT = RESCALE_dG(ps->internal_loop37[30], ps->internal_loopdH[30], TT);
   for (i = 31; i <= MAXLOOP; i++)
     pf->expinternal[i] = exp(-(GT + (pf->lxc * log(i / 30.))) * 10. / kTn);
 
-  GT = RESCALE_dG(ninio37, niniodH, TT);
+  GT = RESCALE_dG(ps->ninio37, ps->niniodH, TT);
   for (j = 0; j <= MAXLOOP; j++)
-    pf->expninio[2][j] = exp(-MIN2(MAX_NINIO, j * GT) * 10. / kTn);
+    pf->expninio[2][j] = exp(-MIN2(ps->MAX_NINIO, j * GT) * 10. / kTn);
 
-  for (i = 0; (i * 7) < strlen(Tetraloops); i++)
-    pf->exptetra[i] = RESCALE_BF(Tetraloop37[i], TetraloopdH[i], TT, kTn);
+  for (i = 0; (i * 7) < strlen(ps->Tetraloops); i++)
+    pf->exptetra[i] = RESCALE_BF(ps->Tetraloop37[i], ps->TetraloopdH[i], TT, kTn);
 
-  for (i = 0; (i * 5) < strlen(Triloops); i++)
-    pf->exptri[i] = RESCALE_BF(Triloop37[i], TriloopdH[i], TT, kTn);
+  for (i = 0; (i * 5) < strlen(ps->Triloops); i++)
+    pf->exptri[i] = RESCALE_BF(ps->Triloop37[i], ps->TriloopdH[i], TT, kTn);
 
-  for (i = 0; (i * 9) < strlen(Hexaloops); i++)
-    pf->exphex[i] = RESCALE_BF(Hexaloop37[i], HexaloopdH[i], TT, kTn);
+  for (i = 0; (i * 9) < strlen(ps->Hexaloops); i++)
+    pf->exphex[i] = RESCALE_BF(ps->Hexaloop37[i], ps->HexaloopdH[i], TT, kTn);
 
   for (i = 0; i <= NBPAIRS; i++)
     /* includes AU penalty */
-    pf->expMLintern[i] = RESCALE_BF(ML_intern37, ML_interndH, TT, kTn);
+    pf->expMLintern[i] = RESCALE_BF(ps->ML_intern37, ps->ML_interndH, TT, kTn);
 
   /* if dangle_model==0 just set their energy to 0,
    * don't let dangle energies become > 0 (at large temps),
@@ -824,12 +1228,12 @@ get_exp_params_ali(vrna_md_t    *md,
   for (i = 0; i <= NBPAIRS; i++)
     for (j = 0; j <= 4; j++) {
       if (md->dangles) {
-        pf->expdangle5[i][j] = RESCALE_BF_SMOOTH(dangle5_37[i][j],
-                                                 dangle5_dH[i][j],
+        pf->expdangle5[i][j] = RESCALE_BF_SMOOTH(ps->dangle5_37[i][j],
+                                                 ps->dangle5_dH[i][j],
                                                  TT,
                                                  kTn);
-        pf->expdangle3[i][j] = RESCALE_BF_SMOOTH(dangle3_37[i][j],
-                                                 dangle3_dH[i][j],
+        pf->expdangle3[i][j] = RESCALE_BF_SMOOTH(ps->dangle3_37[i][j],
+                                                 ps->dangle3_dH[i][j],
                                                  TT,
                                                  kTn);
       } else {
@@ -840,8 +1244,8 @@ get_exp_params_ali(vrna_md_t    *md,
   /* stacking energies */
   for (i = 0; i <= NBPAIRS; i++)
     for (j = 0; j <= NBPAIRS; j++) {
-      pf->expstack[i][j] = RESCALE_BF(stack37[i][j],
-                                      stackdH[i][j],
+      pf->expstack[i][j] = RESCALE_BF(ps->stack37[i][j],
+                                      ps->stackdH[i][j],
                                       TT,
                                       kTn);
     }
@@ -850,30 +1254,30 @@ get_exp_params_ali(vrna_md_t    *md,
   for (i = 0; i <= NBPAIRS; i++)
     for (j = 0; j < 5; j++)
       for (k = 0; k < 5; k++) {
-        pf->expmismatchI[i][j][k] = RESCALE_BF(mismatchI37[i][j][k],
-                                               mismatchIdH[i][j][k],
+        pf->expmismatchI[i][j][k] = RESCALE_BF(ps->mismatchI37[i][j][k],
+                                               ps->mismatchIdH[i][j][k],
                                                TT,
                                                kTn);
-        pf->expmismatch1nI[i][j][k] = RESCALE_BF(mismatch1nI37[i][j][k],
-                                                 mismatch1nIdH[i][j][k],
+        pf->expmismatch1nI[i][j][k] = RESCALE_BF(ps->mismatch1nI37[i][j][k],
+                                                 ps->mismatch1nIdH[i][j][k],
                                                  TT,
                                                  kTn);
-        pf->expmismatchH[i][j][k] = RESCALE_BF(mismatchH37[i][j][k],
-                                               mismatchHdH[i][j][k],
+        pf->expmismatchH[i][j][k] = RESCALE_BF(ps->mismatchH37[i][j][k],
+                                               ps->mismatchHdH[i][j][k],
                                                TT,
                                                kTn);
-        pf->expmismatch23I[i][j][k] = RESCALE_BF(mismatch23I37[i][j][k],
-                                                 mismatch23IdH[i][j][k],
+        pf->expmismatch23I[i][j][k] = RESCALE_BF(ps->mismatch23I37[i][j][k],
+                                                 ps->mismatch23IdH[i][j][k],
                                                  TT,
                                                  kTn);
 
         if (md->dangles) {
-          pf->expmismatchM[i][j][k] = RESCALE_BF_SMOOTH(mismatchM37[i][j][k],
-                                                        mismatchMdH[i][j][k],
+          pf->expmismatchM[i][j][k] = RESCALE_BF_SMOOTH(ps->mismatchM37[i][j][k],
+                                                        ps->mismatchMdH[i][j][k],
                                                         TT,
                                                         kTn);
-          pf->expmismatchExt[i][j][k] = RESCALE_BF_SMOOTH(mismatchExt37[i][j][k],
-                                                          mismatchExtdH[i][j][k],
+          pf->expmismatchExt[i][j][k] = RESCALE_BF_SMOOTH(ps->mismatchExt37[i][j][k],
+                                                          ps->mismatchExtdH[i][j][k],
                                                           TT,
                                                           kTn);
         } else {
@@ -886,8 +1290,8 @@ get_exp_params_ali(vrna_md_t    *md,
     for (j = 0; j <= NBPAIRS; j++)
       for (k = 0; k < 5; k++)
         for (l = 0; l < 5; l++) {
-          pf->expint11[i][j][k][l] = RESCALE_BF(int11_37[i][j][k][l],
-                                                int11_dH[i][j][k][l],
+          pf->expint11[i][j][k][l] = RESCALE_BF(ps->int11_37[i][j][k][l],
+                                                ps->int11_dH[i][j][k][l],
                                                 TT,
                                                 kTn);
         }
@@ -899,8 +1303,8 @@ get_exp_params_ali(vrna_md_t    *md,
         for (l = 0; l < 5; l++) {
           int m;
           for (m = 0; m < 5; m++) {
-            pf->expint21[i][j][k][l][m] = RESCALE_BF(int21_37[i][j][k][l][m],
-                                                     int21_dH[i][j][k][l][m],
+            pf->expint21[i][j][k][l][m] = RESCALE_BF(ps->int21_37[i][j][k][l][m],
+                                                     ps->int21_dH[i][j][k][l][m],
                                                      TT,
                                                      kTn);
           }
@@ -914,16 +1318,18 @@ get_exp_params_ali(vrna_md_t    *md,
           int m, n;
           for (m = 0; m < 5; m++)
             for (n = 0; n < 5; n++) {
-              pf->expint22[i][j][k][l][m][n] = RESCALE_BF(int22_37[i][j][k][l][m][n],
-                                                          int22_dH[i][j][k][l][m][n],
+              pf->expint22[i][j][k][l][m][n] = RESCALE_BF(ps->int22_37[i][j][k][l][m][n],
+                                                          ps->int22_dH[i][j][k][l][m][n],
                                                           TT,
                                                           kTn);
             }
         }
 
-  strncpy(pf->Tetraloops, Tetraloops, 281);
-  strncpy(pf->Triloops, Triloops, 241);
-  strncpy(pf->Hexaloops, Hexaloops, 361);
+  strncpy(pf->Tetraloops, ps->Tetraloops, 281);
+  strncpy(pf->Triloops, ps->Triloops, 241);
+  strncpy(pf->Hexaloops, ps->Hexaloops, 361);
+
+  params_globals_release(globals);
 
   return pf;
 }
@@ -17,8 +17,10 @@
 #include <limits.h>
 
 #include "ViennaRNA/utils/basic.h"
+#include "ViennaRNA/utils/higher_order_functions.h"
 #include "ViennaRNA/params/default.h"
 #include "ViennaRNA/fold_vars.h"
+#include "ViennaRNA/alphabet.h"
 #include "ViennaRNA/loops/all.h"
 #include "ViennaRNA/gquad.h"
 #include "ViennaRNA/constraints/hard.h"
@@ -51,6 +53,38 @@ PRIVATE int
 fill_arrays(vrna_fold_compound_t *fc);
 
 
+PRIVATE int
+fill_column(vrna_fold_compound_t  *fc,
+            int                   j,
+            vrna_mx_pf_aux_el_t   aux_mx_el,
+            vrna_mx_pf_aux_ml_t   aux_mx_ml,
+            FLT_OR_DBL            *Qmax);
+
+
+PRIVATE int
+fill_arrays_single_supported(vrna_fold_compound_t *fc);
+
+
+PRIVATE int
+fill_arrays_single(vrna_fold_compound_t *fc);
+
+
+PRIVATE void
+pf_storage_double(vrna_fold_compound_t *fc);
+
+
+PRIVATE int
+fill_exterior_banded(vrna_fold_compound_t *fc);
+
+
+#ifdef _OPENMP
+PRIVATE int
+fill_arrays_parallel(vrna_fold_compound_t *fc,
+                     int                  num_threads);
+
+
+#endif
+
 PRIVATE void
 postprocess_circular(vrna_fold_compound_t *fc);
 
@@ -158,7 +192,13 @@ vrna_pf(vrna_fold_compound_t  *fc,
         break;
 
       default:
-        Q = (md->circ) ? matrices->qo : matrices->q[fc->iindx[1] - n];
+        if (md->circ)
+          Q = matrices->qo;
+        else if ((matrices->q) && (!fc->jindx_span))
+          Q = matrices->q[fc->iindx[1] - n];
+        else  /* single precision storage, see vrna_md_t.pf_float, or banded matrices */
+          Q = matrices->q1k[n];
+
         break;
     }
 
@@ -252,8 +292,10 @@ vrna_pf_dimer(vrna_fold_compound_t  *fc,
     Q = matrices->qb[fc->iindx[1] - n];
   else if (md->backtrack_type == 'M')
     Q = matrices->qm[fc->iindx[1] - n];
-  else
+  else if ((matrices->q) && (!fc->jindx_span))
     Q = matrices->q[fc->iindx[1] - n];
+  else  /* single precision storage, see vrna_md_t.pf_float, or banded matrices */
+    Q = matrices->q1k[n];
 
   /* ensemble free energy in Kcal/mol */
   if (Q <= FLT_MIN)
@@ -333,6 +375,24 @@ vrna_pf_float_precision(void)
 }
 
 
+PUBLIC int
+vrna_pf_fill_column(vrna_fold_compound_t  *fc,
+                    unsigned int          j,
+                    vrna_mx_pf_aux_el_t   aux_mx_el,
+                    vrna_mx_pf_aux_ml_t   aux_mx_ml)
+{
+  FLT_OR_DBL Qmax = 0.;
+
+  if ((!fc) || (!aux_mx_el) || (!aux_mx_ml) ||
+      (!fc->exp_matrices) || (!fc->exp_matrices->q) ||
+      (fc->hc->type == VRNA_HC_WINDOW) ||
+      (j < 1) || (j > fc->length))
+    return 0;
+
+  return fill_column(fc, (int)j, aux_mx_el, aux_mx_ml, &Qmax);
+}
+
+
 /*
  #################################
  # STATIC helper functions below #
@@ -341,10 +401,8 @@ vrna_pf_float_precision(void)
 PRIVATE int
 fill_arrays(vrna_fold_compound_t *fc)
 {
-  int                 n, i, j, k, ij, d, *my_iindx, *jindx, with_gquad, turn,
-                      with_ud;
-  FLT_OR_DBL          temp, Qmax, *q, *qb, *qm, *qm1, *q1k, *qln;
-  double              max_real;
+  int                 n, i, j, k, ij, d, *my_iindx, with_gquad, turn, with_ud;
+  FLT_OR_DBL          Qmax, *q, *qb, *q1k, *qln;
   vrna_ud_t           *domains_up;
   vrna_md_t           *md;
   vrna_mx_pf_t        *matrices;
@@ -354,14 +412,11 @@ fill_arrays(vrna_fold_compound_t *fc)
 
   n           = fc->length;
   my_iindx    = fc->iindx;
-  jindx       = fc->jindx;
   matrices    = fc->exp_matrices;
   pf_params   = fc->exp_params;
   domains_up  = fc->domains_up;
   q           = matrices->q;
   qb          = matrices->qb;
-  qm          = matrices->qm;
-  qm1         = matrices->qm1;
   q1k         = matrices->q1k;
   qln         = matrices->qln;
   md          = &(pf_params->model_details);
@@ -371,8 +426,6 @@ fill_arrays(vrna_fold_compound_t *fc)
   with_ud = (domains_up && domains_up->exp_energy_cb && (!(fc->type == VRNA_FC_TYPE_COMPARATIVE)));
   Qmax    = 0;
 
-  max_real = (sizeof(FLT_OR_DBL) == sizeof(float)) ? FLT_MAX : DBL_MAX;
-
   if (with_ud && domains_up->exp_prod_cb)
     domains_up->exp_prod_cb(fc, domains_up->data);
 
@@ -399,6 +452,37 @@ fill_arrays(vrna_fold_compound_t *fc)
     }
   }
 
+  /* single precision fill, see vrna_md_t.pf_float */
+  if (md->pf_float) {
+    if (fill_arrays_single_supported(fc)) {
+      if (fill_arrays_single(fc))
+        return 1;
+
+      vrna_message_warning("vrna_pf@part_func.c: "
+                           "partition function exceeds single precision range, "
+                           "falling back to double precision");
+    } else {
+      vrna_message_warning("vrna_pf@part_func.c: "
+                           "single precision partition function not available for this "
+                           "fold compound, falling back to double precision");
+    }
+  }
+
+  /* the recursions below require double precision matrices */
+  if ((matrices->q_flt) || (matrices->qb_flt) || (matrices->qm_flt)) {
+    pf_storage_double(fc);
+    q   = matrices->q;
+    qb  = matrices->qb;
+  }
+
+#ifdef _OPENMP
+  if ((md->num_threads > 1) &&
+      (!fc->aux_grammar) &&
+      (!(domains_up && domains_up->exp_energy_cb)))
+    return fill_arrays_parallel(fc, md->num_threads);
+
+#endif
+
   /* init auxiliary arrays for fast exterior/multibranch loops */
   aux_mx_el = vrna_exp_E_ext_fast_init(fc);
   aux_mx_ml = vrna_exp_E_ml_fast_init(fc);
@@ -413,30 +497,418 @@ fill_arrays(vrna_fold_compound_t *fc)
     }
 
   for (j = turn + 2; j <= n; j++) {
-    for (i = j - turn - 1; i >= 1; i--) {
-      ij = my_iindx[i] - j;
+    if (!fill_column(fc, j, aux_mx_el, aux_mx_ml, &Qmax)) {
+      vrna_exp_E_ml_fast_free(aux_mx_ml);
+      vrna_exp_E_ext_fast_free(aux_mx_el);
 
-      qb[ij] = decompose_pair(fc, i, j, aux_mx_ml);
+      return 0; /* failure */
+    }
 
-      /* Multibranch loop */
-      qm[ij] = vrna_exp_E_ml_fast(fc, i, j, aux_mx_ml);
+    /* rotate auxiliary arrays */
+    vrna_exp_E_ext_fast_rotate(aux_mx_el);
+    vrna_exp_E_ml_fast_rotate(aux_mx_ml);
+  }
 
-      if (qm1) {
-        temp = vrna_exp_E_ml_fast_qqm(aux_mx_ml)[i]; /* for stochastic backtracking and circfold */
+  /* free memory occupied by auxiliary arrays for fast exterior/multibranch loops */
+  vrna_exp_E_ml_fast_free(aux_mx_ml);
+  vrna_exp_E_ext_fast_free(aux_mx_el);
 
-        /* apply auxiliary grammar rule for multibranch loop (M1) case */
-        if ((fc->aux_grammar) && (fc->aux_grammar->cb_aux_exp_m1))
-          temp += fc->aux_grammar->cb_aux_exp_m1(fc, i, j, fc->aux_grammar->data);
+  if (fc->jindx_span)
+    return fill_exterior_banded(fc);
 
-        qm1[jindx[j] + i] = temp;
+  /* prefill linear qln, q1k arrays */
+  if (q1k && qln) {
+    for (k = 1; k <= n; k++) {
+      q1k[k]  = q[my_iindx[1] - k];
+      qln[k]  = q[my_iindx[k] - n];
+    }
+    q1k[0]      = 1.0;
+    qln[n + 1]  = 1.0;
+  }
+
+  return 1;
+}
+
+
+/*
+ *  Fill column j of the matrices, i.e. all segments [i, j] that may be
+ *  enclosed by a base pair, given the auxiliary arrays of column j - 1
+ */
+PRIVATE int
+fill_column(vrna_fold_compound_t  *fc,
+            int                   j,
+            vrna_mx_pf_aux_el_t   aux_mx_el,
+            vrna_mx_pf_aux_ml_t   aux_mx_ml,
+            FLT_OR_DBL            *Qmax)
+{
+  int           i, ij, turn, max_d, *my_iindx, *jindx;
+  FLT_OR_DBL    temp, *q, *qb, *qm, *qm1;
+  double        max_real;
+  vrna_mx_pf_t  *matrices;
+
+  my_iindx  = fc->iindx;
+  jindx     = fc->jindx;
+  matrices  = fc->exp_matrices;
+  q         = matrices->q;
+  qb        = matrices->qb;
+  qm        = matrices->qm;
+  qm1       = matrices->qm1;
+  turn      = fc->exp_params->model_details.min_loop_size;
+  max_d     = (fc->jindx_span) ? (int)fc->jindx_span + 1 : (int)fc->length;
+  max_real  = (sizeof(FLT_OR_DBL) == sizeof(float)) ? FLT_MAX : DBL_MAX;
+
+  for (i = j - turn - 1; i >= MAX2(1, j - max_d); i--) {
+    ij = my_iindx[i] - j;
+
+    qb[ij] = decompose_pair(fc, i, j, aux_mx_ml);
+
+    /* Multibranch loop */
+    qm[ij] = vrna_exp_E_ml_fast(fc, i, j, aux_mx_ml);
+
+    if ((qm1) && (j - i <= max_d)) {
+      temp = vrna_exp_E_ml_fast_qqm(aux_mx_ml)[i]; /* for stochastic backtracking and circfold */
+
+      /* apply auxiliary grammar rule for multibranch loop (M1) case */
+      if ((fc->aux_grammar) && (fc->aux_grammar->cb_aux_exp_m1))
+        temp += fc->aux_grammar->cb_aux_exp_m1(fc, i, j, fc->aux_grammar->data);
+
+      qm1[jindx[j] + i] = temp;
+    }
+
+    /* Exterior loop */
+    q[ij] = vrna_exp_E_ext_fast(fc, i, j, aux_mx_el);
+
+    /* apply auxiliary grammar rule (storage takes place in user-defined data structure */
+    if ((fc->aux_grammar) && (fc->aux_grammar->cb_aux_exp))
+      fc->aux_grammar->cb_aux_exp(fc, i, j, fc->aux_grammar->data);
+
+    if (q[ij] > *Qmax) {
+      *Qmax = q[ij];
+      if (*Qmax > max_real / 10.)
+        vrna_message_warning("Q close to overflow: %d %d %g", i, j, q[ij]);
+    }
+
+    if (q[ij] >= max_real) {
+      vrna_message_warning("overflow while computing partition function for segment q[%d,%d]\n"
+                           "use larger pf_scale", i, j);
+      return 0; /* failure */
+    }
+  }
+
+  return 1;
+}
+
+
+/*
+ *  Check whether the plain single sequence fill of part_func_fill.inc
+ *  covers the fold compound, see vrna_md_t.pf_float
+ */
+PRIVATE int
+fill_arrays_single_supported(vrna_fold_compound_t *fc)
+{
+  vrna_md_t     *md;
+  vrna_mx_pf_t  *matrices;
+
+  md        = &(fc->exp_params->model_details);
+  matrices  = fc->exp_matrices;
+
+  if ((sizeof(FLT_OR_DBL) != sizeof(double)) ||
+      (fc->type != VRNA_FC_TYPE_SINGLE) ||
+      (fc->strands != 1) ||
+      (fc->hc->type == VRNA_HC_WINDOW) ||
+      (fc->hc->f) ||
+      (fc->sc) ||
+      ((fc->domains_up) && (fc->domains_up->exp_energy_cb)) ||
+      (fc->aux_grammar) ||
+      (md->gquad) ||
+      (md->circ) ||
+      ((!matrices->q) && (!matrices->q_flt)) ||
+      ((!matrices->qb) && (!matrices->qb_flt)) ||
+      ((!matrices->qm) && (!matrices->qm_flt)))
+    return 0;
+
+  return 1;
+}
+
+
+#define PF_FILL_FUN     fill_arrays_single_flt
+#define PF_FILL_T       float
+#define PF_FILL_LANES   1
+#define PF_FILL_MAX     FLT_MAX
+#define PF_FILL_MIN     FLT_MIN
+#define PF_FILL_ZIP     vrna_fun_zip_mul_add_sum_flt
+#define PF_FILL_ZIP_REV vrna_fun_zip_mul_add_sum_rev_flt
+#include "part_func_fill.inc"
+
+
+/*
+ *  Single precision fill, see vrna_md_t.pf_float. If the fold compound
+ *  provides single precision storage, the matrices remain in single
+ *  precision. Otherwise, they are filled in temporary single precision
+ *  matrices first, and converted into the regular matrices afterwards.
+ *  The partition functions of the prefixes [1, j] are kept in double
+ *  precision in either case, as are those of the suffixes [i, n] for
+ *  banded matrices. Returns 0 if the single precision range is exceeded
+ */
+PRIVATE int
+fill_arrays_single(vrna_fold_compound_t *fc)
+{
+  int               n, k, ret, narrow, *my_iindx;
+  size_t            size, size_qm1, idx;
+  float             *q, *qb, *qm, *qm1, *scale, *expMLbase;
+  double            *q5, *q3;
+  vrna_exp_param_t  *P[1];
+  vrna_mx_pf_t      *matrices;
+
+  n         = (int)fc->length;
+  my_iindx  = fc->iindx;
+  matrices  = fc->exp_matrices;
+  P[0]      = fc->exp_params;
+  narrow    = (matrices->q_flt) ? 1 : 0;
+
+  if (fc->jindx_span) {
+    size      = ((size_t)n + 2) * ((size_t)fc->jindx_span + 3);
+    size_qm1  = ((size_t)n + 1) * ((size_t)fc->jindx_span + 3);
+  } else {
+    size      = (((size_t)n + 1) * ((size_t)n + 2)) / 2;
+    size_qm1  = size;
+  }
+
+  if (narrow) {
+    q   = matrices->q_flt;
+    qb  = matrices->qb_flt;
+    qm  = matrices->qm_flt;
+    qm1 = NULL;
+    memset(q, 0, sizeof(float) * size);
+    memset(qb, 0, sizeof(float) * size);
+    memset(qm, 0, sizeof(float) * size);
+  } else {
+    q   = (float *)vrna_alloc(sizeof(float) * size);
+    qb  = (float *)vrna_alloc(sizeof(float) * size);
+    qm  = (float *)vrna_alloc(sizeof(float) * size);
+    qm1 = (matrices->qm1) ? (float *)vrna_alloc(sizeof(float) * size_qm1) : NULL;
+  }
+
+  scale     = (float *)vrna_alloc(sizeof(float) * (n + 2));
+  expMLbase = (float *)vrna_alloc(sizeof(float) * (n + 2));
+  q5        = (double *)vrna_alloc(sizeof(double) * (n + 2));
+  /* banded matrices lack the suffixes [i, n] */
+  q3        = (fc->jindx_span) ? (double *)vrna_alloc(sizeof(double) * (n + 2)) : NULL;
+
+  for (k = 0; k <= n; k++) {
+    scale[k]      = (float)matrices->scale[k];
+    expMLbase[k]  = (float)matrices->expMLbase[k];
+  }
+
+  ret = fill_arrays_single_flt(fc, P, scale, expMLbase, q, qb, qm, qm1, q5, q3);
+
+  if (ret) {
+    /* banded matrices lack the prefixes [1, j] as well */
+    if (!q3)
+      for (k = 1; k <= n; k++)
+        q[my_iindx[1] - k] = (float)q5[k];
+
+    if (!narrow) {
+      for (idx = 0; idx < size; idx++) {
+        matrices->q[idx]  = (FLT_OR_DBL)q[idx];
+        matrices->qb[idx] = (FLT_OR_DBL)qb[idx];
+        matrices->qm[idx] = (FLT_OR_DBL)qm[idx];
       }
 
-      /* Exterior loop */
-      q[ij] = vrna_exp_E_ext_fast(fc, i, j, aux_mx_el);
+      if (qm1)
+        for (idx = 0; idx < size_qm1; idx++)
+          matrices->qm1[idx] = (FLT_OR_DBL)qm1[idx];
+
+      if (!q3)
+        for (k = 1; k <= n; k++)
+          matrices->q[my_iindx[1] - k] = (FLT_OR_DBL)q5[k];
+    }
+
+    /* prefill linear qln, q1k arrays */
+    if (matrices->q1k && matrices->qln) {
+      for (k = 1; k <= n; k++) {
+        matrices->q1k[k] = (FLT_OR_DBL)q5[k];
+        if (q3)
+          matrices->qln[k] = (FLT_OR_DBL)q3[k];
+        else
+          matrices->qln[k] = (k > 1) ? (FLT_OR_DBL)q[my_iindx[k] - n] : (FLT_OR_DBL)q5[n];
+      }
+      matrices->q1k[0]      = 1.0;
+      matrices->qln[n + 1]  = 1.0;
+    }
+  }
+
+  if (!narrow) {
+    free(q);
+    free(qb);
+    free(qm);
+    free(qm1);
+  }
+
+  free(scale);
+  free(expMLbase);
+  free(q5);
+  free(q3);
+
+  return ret;
+}
+
+
+/*
+ *  Replace single precision storage by regular matrices, e.g. to fall
+ *  back to double precision recursions
+ */
+PRIVATE void
+pf_storage_double(vrna_fold_compound_t *fc)
+{
+  size_t        size;
+  vrna_mx_pf_t  *matrices;
+
+  matrices = fc->exp_matrices;
+
+  if (fc->jindx_span)
+    size = ((size_t)matrices->length + 2) * ((size_t)fc->jindx_span + 3);
+  else
+    size = (((size_t)matrices->length + 1) * ((size_t)matrices->length + 2)) / 2;
+
+  free(matrices->q_flt);
+  free(matrices->qb_flt);
+  free(matrices->qm_flt);
+  matrices->q_flt   = NULL;
+  matrices->qb_flt  = NULL;
+  matrices->qm_flt  = NULL;
+
+  matrices->q   = (FLT_OR_DBL *)vrna_alloc(sizeof(FLT_OR_DBL) * size);
+  matrices->qb  = (FLT_OR_DBL *)vrna_alloc(sizeof(FLT_OR_DBL) * size);
+  matrices->qm  = (FLT_OR_DBL *)vrna_alloc(sizeof(FLT_OR_DBL) * size);
+}
+
+
+/*
+ *  Banded matrices lack the exterior loop segments [1, j] and [i, n], so
+ *  the linear arrays q1k and qln are obtained from separate prefix and
+ *  suffix recursions instead, see vrna_exp_E_ext_loop_5()
+ */
+PRIVATE int
+fill_exterior_banded(vrna_fold_compound_t *fc)
+{
+  int           n, k;
+  FLT_OR_DBL    *q1k, *qln;
+  double        max_real;
+
+  n         = (int)fc->length;
+  q1k       = fc->exp_matrices->q1k;
+  qln       = fc->exp_matrices->qln;
+  max_real  = (sizeof(FLT_OR_DBL) == sizeof(float)) ? FLT_MAX : DBL_MAX;
+
+  (void)vrna_exp_E_ext_loop_5(fc);
+  (void)vrna_exp_E_ext_loop_3(fc);
+
+  for (k = 1; k <= n; k++)
+    if ((q1k[k] >= max_real) || (qln[k] >= max_real)) {
+      vrna_message_warning("overflow while computing partition function for segment q[1,%d] or q[%d,%d]\n"
+                           "use larger pf_scale", k, k, n);
+      return 0; /* failure */
+    }
+
+  return 1;
+}
+
+
+#ifdef _OPENMP
+
+/*
+ *  Multi-threaded variant of fill_arrays()
+ *
+ *  The matrices are filled column by column, as in the sequential
+ *  fill. Since a base pair (i, j) only encloses segments that end
+ *  before j, all pair contributions of column j, and the auxiliary
+ *  array entries for multibranch and exterior loop parts with leftmost
+ *  stem starting at i, can be computed concurrently. Once the entire
+ *  column of auxiliary array entries is available, the multibranch and
+ *  exterior loop decompositions of all segments [i, j] only read from
+ *  the auxiliary arrays and are again distributed among the threads.
+ *  Each cell is evaluated by exactly the same code and in the same
+ *  summation order as in the sequential fill, so the results are
+ *  bitwise identical, regardless of the number of threads used. All
+ *  threads share the two rotating columns of the auxiliary arrays,
+ *  so no additional memory is required.
+ */
+PRIVATE int
+fill_arrays_parallel(vrna_fold_compound_t *fc,
+                     int                  num_threads)
+{
+  int                 n, i, j, k, d, ij, *my_iindx, *jindx, turn, max_d;
+  FLT_OR_DBL          Qmax, *q, *qb, *qm, *qm1, *q1k, *qln;
+  double              max_real;
+  vrna_mx_pf_t        *matrices;
+  vrna_mx_pf_aux_el_t aux_mx_el;
+  vrna_mx_pf_aux_ml_t aux_mx_ml;
+
+  n         = fc->length;
+  my_iindx  = fc->iindx;
+  jindx     = fc->jindx;
+  matrices  = fc->exp_matrices;
+  q         = matrices->q;
+  qb        = matrices->qb;
+  qm        = matrices->qm;
+  qm1       = matrices->qm1;
+  q1k       = matrices->q1k;
+  qln       = matrices->qln;
+  turn      = fc->exp_params->model_details.min_loop_size;
+  max_d     = (fc->jindx_span) ? (int)fc->jindx_span + 1 : n;
+  Qmax      = 0;
+  max_real  = (sizeof(FLT_OR_DBL) == sizeof(float)) ? FLT_MAX : DBL_MAX;
 
-      /* apply auxiliary grammar rule (storage takes place in user-defined data structure */
-      if ((fc->aux_grammar) && (fc->aux_grammar->cb_aux_exp))
-        fc->aux_grammar->cb_aux_exp(fc, i, j, fc->aux_grammar->data);
+  /* init auxiliary arrays for fast exterior/multibranch loops */
+  aux_mx_el = vrna_exp_E_ext_fast_init(fc);
+  aux_mx_ml = vrna_exp_E_ml_fast_init(fc);
+
+  for (d = 0; d <= turn; d++)
+    for (i = 1; i <= n - d; i++) {
+      j       = i + d;
+      ij      = my_iindx[i] - j;
+      qb[ij]  = 0.0;
+    }
+
+#pragma omp parallel num_threads(num_threads) private(i, j, ij)
+  for (j = turn + 2; j <= n; j++) {
+    /* pair contributions of column j only depend on previous columns */
+#pragma omp for schedule(dynamic, 8)
+    for (i = j - turn - 1; i >= MAX2(1, j - max_d); i--) {
+      ij      = my_iindx[i] - j;
+      qb[ij]  = decompose_pair(fc, i, j, aux_mx_ml);
+
+      vrna_exp_E_ml_fast_aux(fc, i, j, aux_mx_ml);
+      vrna_exp_E_ext_fast_aux(fc, i, j, aux_mx_el);
+
+      if ((qm1) && (j - i <= max_d))
+        qm1[jindx[j] + i] = vrna_exp_E_ml_fast_qqm(aux_mx_ml)[i];
+    }
+
+    /* decompositions of column j only read the complete auxiliary column */
+#pragma omp for schedule(dynamic, 8)
+    for (i = j - turn - 1; i >= MAX2(1, j - max_d); i--) {
+      ij      = my_iindx[i] - j;
+      qm[ij]  = vrna_exp_E_ml_fast_split(fc, i, j, aux_mx_ml);
+      q[ij]   = vrna_exp_E_ext_fast_split(fc, i, j, aux_mx_el);
+    }
+
+    /* rotate auxiliary arrays */
+#pragma omp single
+    {
+      vrna_exp_E_ext_fast_rotate(aux_mx_el);
+      vrna_exp_E_ml_fast_rotate(aux_mx_ml);
+    }
+  }
+
+  vrna_exp_E_ml_fast_free(aux_mx_ml);
+  vrna_exp_E_ext_fast_free(aux_mx_el);
+
+  /* check for overflows in the same order as the sequential fill */
+  for (j = turn + 2; j <= n; j++) {
+    for (i = j - turn - 1; i >= MAX2(1, j - max_d); i--) {
+      ij = my_iindx[i] - j;
 
       if (q[ij] > Qmax) {
         Qmax = q[ij];
@@ -447,19 +919,14 @@ fill_arrays(vrna_fold_compound_t *fc)
       if (q[ij] >= max_real) {
         vrna_message_warning("overflow while computing partition function for segment q[%d,%d]\n"
                              "use larger pf_scale", i, j);
-
-        vrna_exp_E_ml_fast_free(aux_mx_ml);
-        vrna_exp_E_ext_fast_free(aux_mx_el);
-
         return 0; /* failure */
       }
     }
-
-    /* rotate auxiliary arrays */
-    vrna_exp_E_ext_fast_rotate(aux_mx_el);
-    vrna_exp_E_ml_fast_rotate(aux_mx_ml);
   }
 
+  if (fc->jindx_span)
+    return fill_exterior_banded(fc);
+
   /* prefill linear qln, q1k arrays */
   if (q1k && qln) {
     for (k = 1; k <= n; k++) {
@@ -470,34 +937,31 @@ fill_arrays(vrna_fold_compound_t *fc)
     qln[n + 1]  = 1.0;
   }
 
-  /* free memory occupied by auxiliary arrays for fast exterior/multibranch loops */
-  vrna_exp_E_ml_fast_free(aux_mx_ml);
-  vrna_exp_E_ext_fast_free(aux_mx_el);
-
   return 1;
 }
 
 
+#endif
+
+
 PRIVATE FLT_OR_DBL
 decompose_pair(vrna_fold_compound_t *fc,
                int                  i,
                int                  j,
                vrna_mx_pf_aux_ml_t  aux_mx_ml)
 {
-  unsigned int  n;
   int           *jindx, *pscore;
   FLT_OR_DBL    contribution;
   double        kTn;
   vrna_hc_t     *hc;
 
   contribution  = 0.;
-  n             = fc->length;
   pscore        = (fc->type == VRNA_FC_TYPE_COMPARATIVE) ? fc->pscore : NULL;
   jindx         = fc->jindx;
   kTn           = fc->exp_params->kT / 10.;  /* kT in cal/mol */
   hc            = fc->hc;
 
-  if (hc->mx[j * n + i]) {
+  if (vrna_hc_mx_get(hc, j, i)) {
     /* process hairpin loop(s) */
     contribution += vrna_exp_E_hp_loop(fc, i, j);
     /* process interior loop(s) */
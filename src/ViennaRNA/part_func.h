@@ -26,6 +26,8 @@ typedef struct vrna_dimer_pf_s cofoldF;
 #include <ViennaRNA/centroid.h>
 #include <ViennaRNA/equilibrium_probs.h>
 #include <ViennaRNA/boltzmann_sampling.h>
+#include <ViennaRNA/loops/external.h>
+#include <ViennaRNA/loops/multibranch.h>
 
 #ifdef VRNA_WARN_DEPRECATED
 # if defined(__clang__)
@@ -164,6 +166,31 @@ vrna_pf_dimer(vrna_fold_compound_t  *vc,
               char                  *structure);
 
 
+/**
+ *  @brief  Fill a single column of the partition function matrices
+ *
+ *  Computes the entries @f$ Q^b_{ij} @f$, @f$ Q^m_{ij} @f$, @f$ Q^1_{ij} @f$ (if present),
+ *  and @f$ Q_{ij} @f$ for all @f$ i < j @f$, just as vrna_pf() does when it reaches column
+ *  @f$ j @f$. All columns left of @p j, the auxiliary arrays @p aux_mx_el and @p aux_mx_ml
+ *  of column @f$ j - 1 @f$, and the G-Quadruplex matrix (if required) must be available.
+ *  Before proceeding to column @f$ j + 1 @f$, the auxiliary arrays must be rotated with
+ *  vrna_exp_E_ext_fast_rotate() and vrna_exp_E_ml_fast_rotate().
+ *
+ *  @see  vrna_exp_E_ext_fast_init(), vrna_exp_E_ml_fast_init(), vrna_cotrans_append()
+ *
+ *  @param  vc        The fold compound data structure with partition function matrices
+ *  @param  j         The column to fill
+ *  @param  aux_mx_el The auxiliary arrays for exterior loops
+ *  @param  aux_mx_ml The auxiliary arrays for multibranch loops
+ *  @return           1 on success, 0 upon any failure, e.g. a numeric overflow
+ */
+int
+vrna_pf_fill_column(vrna_fold_compound_t  *vc,
+                    unsigned int          j,
+                    vrna_mx_pf_aux_el_t   aux_mx_el,
+                    vrna_mx_pf_aux_ml_t   aux_mx_ml);
+
+
 /* End basic global interface */
 /**@}*/
 
@@ -65,7 +65,8 @@
 #include "ViennaRNA/utils/basic.h"
 #include "ViennaRNA/params/default.h"
 #include "ViennaRNA/fold_vars.h"
-#include "ViennaRNA/pair_mat.h"
+#include "ViennaRNA/model.h"
+#include "ViennaRNA/alphabet.h"
 #include "ViennaRNA/params/basic.h"
 #include "ViennaRNA/part_func.h"
 #include "ViennaRNA/loops/all.h"
@@ -90,18 +91,26 @@
  # PRIVATE VARIABLES             #
  #################################
  */
-PRIVATE short             *S = NULL, *S1 = NULL, *SS = NULL, *SS2 = NULL;
-PRIVATE vrna_exp_param_t  *Pf = NULL;                           /* use this structure for all the exp-arrays*/
-PRIVATE FLT_OR_DBL        *qb = NULL, *qm = NULL, *prpr = NULL; /* add arrays for pf_unpaired()*/
-PRIVATE FLT_OR_DBL        *probs = NULL;
-PRIVATE FLT_OR_DBL        *q1k = NULL, *qln = NULL;
-PRIVATE double            *qqm2 = NULL, *qq_1m2 = NULL, *qqm = NULL, *qqm1 = NULL;
-PRIVATE FLT_OR_DBL        *scale = NULL, *expMLbase = NULL;
-PRIVATE char              *ptype = NULL;  /* precomputed array of pair types */
-PRIVATE int               init_length;    /* length in last call to init_pf_fold()*/
-PRIVATE double            init_temp;      /* temperature in last call to scale_pf_params */
-PRIVATE int               *my_iindx = NULL;
-/* make iptypes array for intermolecular constrains (ipidx for indexing)*/
+
+/*
+ *  all data required to compute the probabilities of unpaired
+ *  regions for a single sequence, i.e. the results of a preceding
+ *  partition function and base pair probability computation
+ */
+struct up_data {
+  int               n;
+  vrna_exp_param_t  *Pf;        /* Boltzmann weights, also provides the model details */
+  short             *S1;        /* alias encoded sequence */
+  char              *ptype;     /* pair types, indexed by my_iindx */
+  int               *my_iindx;
+  FLT_OR_DBL        *qb;
+  FLT_OR_DBL        *qm;
+  FLT_OR_DBL        *probs;
+  FLT_OR_DBL        *q1k;
+  FLT_OR_DBL        *qln;
+  FLT_OR_DBL        *scale;
+  FLT_OR_DBL        *expMLbase;
+};
 
 
 /*
@@ -123,41 +132,50 @@ plot_free_pu_out(pu_out   *res,
 
 
 PRIVATE void
-scale_stru_pf_params(unsigned int length);
-
-
-PRIVATE void
-init_pf_two(int length);
+scale_stru_pf_params(vrna_exp_param_t *Pf,
+                     double           pfs,
+                     unsigned int     length,
+                     FLT_OR_DBL       **scale,
+                     FLT_OR_DBL       **expMLbase);
 
 
-PRIVATE void
+PRIVATE double
 scale_int(const char  *s,
           const char  *sl,
-          double      *sc_int);
-
-
-PRIVATE void
-encode_seq(const char *s1,
-           const char *s2);
+          vrna_md_t   *md,
+          double      kT);
 
 
 PRIVATE constrain *
 get_ptypes_up(char        *S,
-              const char  *structure);
+              const char  *structure,
+              vrna_md_t   *md);
 
 
 PRIVATE void
-get_up_arrays(unsigned int length);
+set_encoded_seq(const char  *sequence,
+                short       **S,
+                short       **S1,
+                vrna_md_t   *md);
 
 
-PRIVATE void
-free_up_arrays(void);
+PRIVATE pu_contrib *
+unstru_fill(const char      *sequence,
+            int             w,
+            struct up_data  *d);
 
 
-PRIVATE void
-set_encoded_seq(const char  *sequence,
-                short       **S,
-                short       **S1);
+PRIVATE interact *
+interact_fill(const char  *s1,
+              const char  *s2,
+              pu_contrib  *p_c,
+              pu_contrib  *p_c2,
+              int         w,
+              const char  *cstruc,
+              int         incr3,
+              int         incr5,
+              double      int_scale,
+              vrna_md_t   *md);
 
 
 PRIVATE void
@@ -239,31 +257,156 @@ PUBLIC pu_contrib *
 pf_unstru(char  *sequence,
           int   w)
 {
-  int           n, i, j, v, k, l, o, p, ij, kl, po, u, u1, d, type, type_2, tt;
-  unsigned int  size;
-  double        temp, tqm2;
-  double        qbt1, *tmp, sum_l, *sum_M;
-  double        *store_H, *store_Io, **store_I2o; /* hairp., interior contribs */
-  double        *store_M_qm_o, *store_M_mlbase;   /* multiloop contributions */
-  pu_contrib    *pu_test;
+  short           *S, *S1;
+  char            *ptype;
+  unsigned int    n;
+  FLT_OR_DBL      *qb, *qm, *q1k, *qln;
+  vrna_md_t       md;
+  pu_contrib      *pu;
+  struct up_data  d;
+
+  n = (unsigned int)strlen(sequence);
+
+  /* gets the arrays, that we need, from part_func.c */
+  if (!get_pf_arrays(&S, &S1, &ptype, &qb, &qm, &q1k, &qln))
+    vrna_message_error("init_pf_two: pf_fold() has to be called before calling pf_unstru()\n");
+
+  set_model_details(&md);
+
+  d.n         = (int)n;
+  d.Pf        = vrna_exp_params(&md);
+  d.S1        = S1;
+  d.ptype     = ptype;
+  d.my_iindx  = vrna_idx_row_wise(n);
+  d.qb        = qb;
+  d.qm        = qm;
+  d.probs     = export_bppm(); /* get a pointer to the base pair probs */
+  d.q1k       = q1k;
+  d.qln       = qln;
+
+  /* scaling factors (to avoid overflows) */
+  if (pf_scale == -1) {
+    /* mean energy for random sequences: 184.3*length cal */
+    pf_scale = exp(-(-185 + (d.Pf->temperature - 37.) * 7.27) / d.Pf->kT);
+    if (pf_scale < 1)
+      pf_scale = 1;
+  }
+
+  scale_stru_pf_params(d.Pf, pf_scale, n, &(d.scale), &(d.expMLbase));
+
+  pu = unstru_fill(sequence, w, &d);
+
+  free(d.scale);
+  free(d.expMLbase);
+  free(d.my_iindx);
+  free(d.Pf);
+
+  return pu;
+}
+
+
+PUBLIC pu_contrib *
+vrna_pf_unstru(vrna_fold_compound_t *fc,
+               int                  w)
+{
+  pu_contrib        *pu;
+  struct up_data    d;
+  vrna_mx_pf_t      *matrices;
+
+  if ((!fc) ||
+      (fc->type != VRNA_FC_TYPE_SINGLE)) {
+    vrna_message_warning("vrna_pf_unstru: single sequence fold compound required");
+    return NULL;
+  }
+
+  if (fc->jindx_span) {
+    vrna_message_warning("vrna_pf_unstru: "
+                         "banded fold compounds are not supported");
+    return NULL;
+  }
+
+  matrices = fc->exp_matrices;
+
+  if ((!matrices) ||
+      (!matrices->probs) ||
+      (!fc->exp_params)) {
+    vrna_message_warning("vrna_pf_unstru: "
+                         "vrna_pf() with base pair probabilities has to be called first");
+    return NULL;
+  }
+
+  if (!fc->ptype_pf_compat)
+    vrna_ptypes_prepare(fc, VRNA_OPTION_PF);
+
+  d.n         = (int)fc->length;
+  d.Pf        = fc->exp_params;
+  d.S1        = fc->sequence_encoding;
+  d.ptype     = fc->ptype_pf_compat;
+  d.my_iindx  = fc->iindx;
+  d.qb        = matrices->qb;
+  d.qm        = matrices->qm;
+  d.probs     = matrices->probs;
+  d.q1k       = matrices->q1k;
+  d.qln       = matrices->qln;
+  d.scale     = matrices->scale;
+  d.expMLbase = matrices->expMLbase;
+
+  pu = unstru_fill(fc->sequence, w, &d);
+
+  return pu;
+}
+
+
+PRIVATE pu_contrib *
+unstru_fill(const char      *sequence,
+            int             w,
+            struct up_data  *d)
+{
+  int               n, i, j, v, k, l, o, p, ij, kl, po, u, u1, type, type_2, tt;
+  int               *my_iindx, *rtype;
+  short             *S1;
+  char              *ptype;
+  unsigned int      size;
+  double            temp, tqm2;
+  double            qbt1, *tmp, sum_l, *sum_M;
+  double            *store_H, *store_Io, **store_I2o; /* hairp., interior contribs */
+  double            *store_M_qm_o, *store_M_mlbase;   /* multiloop contributions */
+  double            *qqm2, *qq_1m2, *qqm, *qqm1;
+  FLT_OR_DBL        *qb, *qm, *prpr, *probs, *q1k, *qln, *scale, *expMLbase;
+  vrna_exp_param_t  *Pf;
+  pu_contrib        *pu_test;
+
+  n         = d->n;
+  Pf        = d->Pf;
+  S1        = d->S1;
+  ptype     = d->ptype;
+  my_iindx  = d->my_iindx;
+  qb        = d->qb;
+  qm        = d->qm;
+  probs     = d->probs;
+  q1k       = d->q1k;
+  qln       = d->qln;
+  scale     = d->scale;
+  expMLbase = d->expMLbase;
+  rtype     = &(Pf->model_details.rtype[0]);
 
   sum_l   = 0.0;
   temp    = 0;
-  n       = (int)strlen(sequence);
   sum_M   = (double *)vrna_alloc((n + 1) * sizeof(double));
   pu_test = get_pu_contrib_struct((unsigned)n, (unsigned)w);
   size    = ((n + 1) * (n + 2)) >> 1;
 
-  get_up_arrays((unsigned)n);
-  init_pf_two(n);
+  prpr    = (FLT_OR_DBL *)vrna_alloc(sizeof(FLT_OR_DBL) * size);
+  qqm2    = (double *)vrna_alloc(sizeof(double) * (n + 2));
+  qq_1m2  = (double *)vrna_alloc(sizeof(double) * (n + 2));
+  qqm     = (double *)vrna_alloc(sizeof(double) * (n + 2));
+  qqm1    = (double *)vrna_alloc(sizeof(double) * (n + 2));
 
   /* init everything */
-  for (d = 0; d <= TURN; d++)
-    for (i = 1; i <= n - d; i++) {
-      j   = i + d;
-      ij  = my_iindx[i] - j;
-      if (d < w)
-        pu_test->H[i][d] = pu_test->I[i][d] = pu_test->M[i][d] = pu_test->E[i][d] = 0.;
+  for (u = 0; u <= TURN; u++)
+    for (i = 1; i <= n - u; i++) {
+      if (u < w)
+        pu_test->H[i][u] = pu_test->I[i][u] = pu_test->M[i][u] = pu_test->E[i][u] = 0.;
     }
 
 
@@ -308,7 +451,7 @@ pf_unstru(char  *sequence,
       type  = ptype[po];
       if (type) {
         /*hairpin contribution*/
-        if (((type == 3) || (type == 4)) && no_closingGU)
+        if (((type == 3) || (type == 4)) && Pf->model_details.noGUclosure)
           temp = 0.;
         else
           temp = prpr[po] *
@@ -538,7 +681,12 @@ pf_unstru(char  *sequence,
 
   free(sum_M);
   free(store_M_mlbase);
-  free_up_arrays();
+  free(prpr);
+  free(qqm);
+  free(qqm1);
+  free(qqm2);
+  free(qq_1m2);
+
   return pu_test;
 }
 
@@ -590,18 +738,104 @@ pf_interact(const char  *s1,
             int         incr3,
             int         incr5)
 {
-  int         i, j, k, l, n1, n2, add_i5, add_i3, pc_size;
-  double      temp, Z, rev_d, E, Z2, **p_c_S, **p_c2_S, int_scale;
-  FLT_OR_DBL  ****qint_4, **qint_ik;
+  double    temppfs, int_scale;
+  vrna_md_t md;
+  interact  *Int;
+
+  if (fold_constrained && cstruc == NULL)
+    vrna_message_error("option -C selected, but no constrained structure given\n");
+
+  set_model_details(&md);
+
+  /* use a different scaling for pf_interact */
+  int_scale = scale_int(s2, s1, &md, md.betaScale * (md.temperature + K0) * GASCONST / 1000.0);
+
+  /* set the global variable pf_scale to the value used to
+   * scale the interaction, keep its former value !! */
+  temppfs   = pf_scale;
+  pf_scale  = int_scale;
+
+  Int = interact_fill(s1,
+                      s2,
+                      p_c,
+                      p_c2,
+                      w,
+                      (fold_constrained) ? cstruc : NULL,
+                      incr3,
+                      incr5,
+                      int_scale,
+                      &md);
+
+  pf_scale = temppfs; /* reset pf_scale */
+
+  free_pf_arrays(); /* for arrays for pf_fold(...) */
+
+  return Int;
+}
+
+
+PUBLIC interact *
+vrna_pf_interact(const char       *s1,
+                 const char       *s2,
+                 pu_contrib       *p_c,
+                 pu_contrib       *p_c2,
+                 int              w,
+                 const char       *cstruc,
+                 int              incr3,
+                 int              incr5,
+                 const vrna_md_t  *md_p)
+{
+  vrna_md_t md;
+
+  if ((!s1) || (!s2) || (!p_c)) {
+    vrna_message_warning("vrna_pf_interact: sequences and unpaired probabilities required");
+    return NULL;
+  }
+
+  if (md_p)
+    md = *md_p;
+  else
+    vrna_md_set_default(&md);
+
+  return interact_fill(s1,
+                       s2,
+                       p_c,
+                       p_c2,
+                       w,
+                       cstruc,
+                       incr3,
+                       incr5,
+                       scale_int(s2, s1, &md, md.betaScale * (md.temperature + K0) * GASCONST / 1000.0),
+                       &md);
+}
+
+
+PRIVATE interact *
+interact_fill(const char  *s1,
+              const char  *s2,
+              pu_contrib  *p_c,
+              pu_contrib  *p_c2,
+              int         w,
+              const char  *cstruc,
+              int         incr3,
+              int         incr5,
+              double      int_scale,
+              vrna_md_t   *md)
+{
+  int               i, j, k, l, n1, n2, add_i5, add_i3, pc_size, *rtype;
+  short             *S1, *SS2;
+  double            temp, Z, rev_d, E, Z2, **p_c_S, **p_c2_S;
+  FLT_OR_DBL        ****qint_4, **qint_ik, *scale, *expMLbase;
+  vrna_exp_param_t  *Pf;
   /* PRIVATE double **pint; array for pf_up() output */
-  interact    *Int;
-  double      G_min, G_is, Gi_min;
-  int         gi, gj, gk, gl, ci, cj, ck, cl, prev_k, prev_l;
-  FLT_OR_DBL  **int_ik;
-  double      Z_int, temp_int, temppfs;
-  double      const_scale, const_T;
-  constrain   *cc = NULL;                           /* constrains for cofolding */
-  char        *Seq, *i_long, *i_short, *pos = NULL; /* short seq appended to long one */
+  interact          *Int;
+  double            G_min, G_is, Gi_min;
+  int               gi, gj, gk, gl, ci, cj, ck, cl, prev_k, prev_l;
+  FLT_OR_DBL        **int_ik;
+  double            Z_int, temp_int;
+  double            const_scale, const_T;
+  constrain         *cc = NULL;                           /* constrains for cofolding */
+  char              *Seq, *i_long, *i_short, *pos = NULL; /* short seq appended to long one */
 
   /* int ***pu_jl; */ /* positions of interaction in the short RNA */
 
@@ -620,10 +854,13 @@ pf_interact(const char  *s1,
   strcpy(Seq, s1);
   strcat(Seq, s2);
 
-  set_encoded_seq(s1, &S, &S1);
-  set_encoded_seq(s2, &SS, &SS2);
+  set_encoded_seq(s1, NULL, &S1, md);
+  set_encoded_seq(s2, NULL, &SS2, md);
+
+  cc = get_ptypes_up(Seq, cstruc, md);
 
-  cc = get_ptypes_up(Seq, cstruc);
+  Pf    = vrna_exp_params(md);
+  rtype = &(Pf->model_details.rtype[0]);
 
   get_interact_arrays(n1, n2, p_c, p_c2, w, incr5, incr3, &p_c_S, &p_c2_S);
 
@@ -632,17 +869,9 @@ pf_interact(const char  *s1,
   Int->Pi = (double *)vrna_alloc(sizeof(double) * (n1 + 2));
   Int->Gi = (double *)vrna_alloc(sizeof(double) * (n1 + 2));
 
-  /* use a different scaling for pf_interact*/
-  scale_int(s2, s1, &int_scale);
-
-  /* set the global scale array and the global variable pf_scale to the
-   * values used to scale the interaction, keep their former values !! */
-  temppfs   = pf_scale;
-  pf_scale  = int_scale;
-
   /* in order to scale expLoopEnergy correctly call*/
   /* we also pass twice the seq-length to avoid bogus access to scale[] array */
-  scale_stru_pf_params((unsigned)2 * n1);
+  scale_stru_pf_params(Pf, int_scale, (unsigned)2 * n1, &scale, &expMLbase);
 
   qint_ik = (FLT_OR_DBL **)vrna_alloc(sizeof(FLT_OR_DBL *) * (n1 + 1));
   for (i = 1; i <= n1; i++)
@@ -652,17 +881,15 @@ pf_interact(const char  *s1,
   for (i = 1; i <= n1; i++)
     int_ik[i] = (FLT_OR_DBL *)vrna_alloc(sizeof(FLT_OR_DBL) * (n1 + 1));
   Z_int = 0.;
-  /*  Gint = ( -log(int_ik[gk][gi])-( ((int) w/2)*log(pf_scale)) )*((Pf->temperature+K0)*GASCONST/1000.0); */
-  const_scale = ((int)w / 2) * log(pf_scale);
+  /*  Gint = ( -log(int_ik[gk][gi])-( ((int) w/2)*log(int_scale)) )*((Pf->temperature+K0)*GASCONST/1000.0); */
+  const_scale = ((int)w / 2) * log(int_scale);
   const_T     = (Pf->kT / 1000.0);
-  encode_seq(s1, s2);
-  /* static  short *S~S1, *S1~SS1, *SS~S2, *SS2; */
   for (i = 0; i <= n1; i++)
     Int->Pi[i] = Int->Gi[i] = 0.;
   E = 0.;
   Z = 0.;
 
-  if (fold_constrained && cstruc != NULL) {
+  if (cstruc != NULL) {
     pos = strchr(cstruc, '|');
     if (pos) {
       ci = ck = cl = cj = 0;
@@ -703,11 +930,9 @@ pf_interact(const char  *s1,
         vrna_message_error("pf_interact: could not satisfy all constraints");
       }
     }
-  } else if (fold_constrained && cstruc == NULL) {
-    vrna_message_error("option -C selected, but no constrained structure given\n");
   }
 
-  if (fold_constrained)
+  if (cstruc != NULL)
     pos = strchr(cstruc, '|');
 
   /*  qint_4[i][j][k][l] contribution that region (k-i) in seq1 (l=n1)
@@ -719,16 +944,16 @@ pf_interact(const char  *s1,
   for (i = 1; i <= n1; i++) {
     int end_k;
     end_k = i - w;
-    if (fold_constrained && pos && ci)
+    if (pos && ci)
       end_k = MAX2(i - w, ci - w);
 
     /* '|' constrains for long sequence: index i from 1 to n1 (5' to 3')*/
     /* interaction has to include 3' most '|' constrain, ci */
-    if (fold_constrained && pos && ci && i == 1 && i < ci)
+    if (pos && ci && i == 1 && i < ci)
       i = ci - w + 1 > 1 ? ci - w + 1 : 1;
 
     /* interaction has to include 5' most '|' constrain, ck*/
-    if (fold_constrained && pos && ck && i > ck + w - 1)
+    if (pos && ck && i > ck + w - 1)
       break;
 
     /* note: qint_4[i] will be freed before we allocate qint_4[i+1] */
@@ -743,16 +968,16 @@ pf_interact(const char  *s1,
     for (j = n2; j > 0; j--) {
       int type, type2, end_l;
       end_l = j + w;
-      if (fold_constrained && pos && ci)
+      if (pos && ci)
         end_l = MIN2(cj + w, j + w);
 
       /* '|' constrains for short sequence: index j from n2 to 1 (3' to 5')*/
       /* interaction has to include 5' most '|' constrain, cj */
-      if (fold_constrained && pos && cj && j == n2 && j > cj)
+      if (pos && cj && j == n2 && j > cj)
         j = cj + w - 1 > n2 ? n2 : cj + w - 1;
 
       /* interaction has to include 3' most '|' constrain, cl*/
-      if (fold_constrained && pos && cl && j < cl - w + 1)
+      if (pos && cl && j < cl - w + 1)
         break;
 
       type                = cc->ptype[cc->indx[i] - (n1 + j)];
@@ -803,7 +1028,7 @@ pf_interact(const char  *s1,
       temp    = 0.;
       prev_l  = n2;
       for (k = i - 1; k > end_k && k > 0; k--) {
-        if (fold_constrained && pos && cstruc[k - 1] == '|' && k > prev_k)
+        if (pos && cstruc[k - 1] == '|' && k > prev_k)
           prev_k = k;
 
         for (l = j + 1; l < end_l && l <= n2; l++) {
@@ -812,13 +1037,13 @@ pf_interact(const char  *s1,
 
           type2 = cc->ptype[cc->indx[k] - (n1 + l)];
           /* '|' : l HAS TO be paired: not pair (k,x) where x>l allowed */
-          if (fold_constrained && pos && cstruc[n1 + l - 1] == '|' && l < prev_l)
+          if (pos && cstruc[n1 + l - 1] == '|' && l < prev_l)
             prev_l = l; /*break*/
 
-          if (fold_constrained && pos && (k <= ck || i >= ci) && !type2)
+          if (pos && (k <= ck || i >= ci) && !type2)
             continue;
 
-          if (fold_constrained && pos && ((cstruc[k - 1] == '|') || (cstruc[n1 + l - 1] == '|')) &&
+          if (pos && ((cstruc[k - 1] == '|') || (cstruc[n1 + l - 1] == '|')) &&
               !type2)
             break;
 
@@ -874,20 +1099,20 @@ pf_interact(const char  *s1,
 
           /* '|' constrain in long sequence */
           /* collect interactions starting before 5' most '|' constrain */
-          if (fold_constrained && pos && ci && i < ci)
+          if (pos && ci && i < ci)
             continue;
 
           /* collect interactions ending after 3' most '|' constrain*/
-          if (fold_constrained && pos && ck && k > ck)
+          if (pos && ck && k > ck)
             continue;
 
           /* '|' constrain in short sequence */
           /* collect interactions starting before 5' most '|' constrain */
-          if (fold_constrained && pos && cj && j > cj)
+          if (pos && cj && j > cj)
             continue;
 
           /* collect interactions ending after 3' most '|' constrain*/
-          if (fold_constrained && pos && cl && l < cl)
+          if (pos && cl && l < cl)
             continue;
 
           /* scale everything to w/2*/
@@ -937,10 +1162,10 @@ pf_interact(const char  *s1,
     if (i > w) {
       int bla;
       bla = i - w;
-      if (fold_constrained && pos && ci && i - w < ci - w + 1)
+      if (pos && ci && i - w < ci - w + 1)
         continue;
 
-      if (fold_constrained && pos && ci)
+      if (pos && ci)
         bla = MAX2(ci - w + 1, i - w);
 
       for (j = n2; j > 0; j--) {
@@ -964,7 +1189,7 @@ pf_interact(const char  *s1,
         Int->Pi[l] += qint_ik[i][k] / Z;
         /* Int->Gi[l]: minimal delta G at position [l] */
         Int->Gi[l] = MIN2(Int->Gi[l],
-                          (-log(qint_ik[i][k]) - (((int)w / 2) * log(pf_scale))) *
+                          (-log(qint_ik[i][k]) - (((int)w / 2) * log(int_scale))) *
                           (Pf->kT / 1000.0));
       }
     }
@@ -973,7 +1198,7 @@ pf_interact(const char  *s1,
     int start_i, end_i;
     start_i = n1 - w + 1;
     end_i   = n1;
-    if (fold_constrained && pos && ci) {
+    if (pos && ci) {
       /* a break in the k loop might result in unfreed values */
       start_i = ci - w + 1 < n1 - w + 1 ? ci - w + 1 : n1 - w + 1;
       start_i = start_i > 0 ? start_i : 1;
@@ -997,7 +1222,7 @@ pf_interact(const char  *s1,
     int start_i, end_i;
     start_i = 1;
     end_i   = n1;
-    if (fold_constrained && pos) {
+    if (pos) {
       start_i = ci - w + 1 > 0 ? ci - w + 1 : 1;
       end_i   = ck + w - 1 > n1 ? n1 : ck + w - 1;
     }
@@ -1013,7 +1238,7 @@ pf_interact(const char  *s1,
     free(qint_4);
   }
 
-  if (fold_constrained && (gi == 0 || gk == 0 || gl == 0 || gj == 0))
+  if (cstruc && (gi == 0 || gk == 0 || gl == 0 || gj == 0))
     vrna_message_error("pf_interact: could not satisfy all constraints");
 
   /* fill structure interact */
@@ -1035,20 +1260,9 @@ pf_interact(const char  *s1,
     free(qint_ik[i]);
   free(qint_ik);
 
-  /* reset the global variables pf_scale and scale to their original values */
-  pf_scale = temppfs;                 /* reset pf_scale */
-  scale_stru_pf_params((unsigned)n1); /* reset the scale array */
-  free_pf_arrays();                   /* for arrays for pf_fold(...) */
-
-  if (expMLbase != NULL) {
-    free(expMLbase);
-    expMLbase = NULL;
-  }
-
-  if (scale != NULL) {
-    free(scale);
-    scale = NULL;
-  }
+  free(expMLbase);
+  free(scale);
+  free(Pf);
 
   for (i = 1; i <= n1; i++)
     free(p_c_S[i]);
@@ -1060,6 +1274,8 @@ pf_interact(const char  *s1,
   }
 
   free(Seq);
+  free(S1);
+  free(SS2);
   free(cc->indx);
   free(cc->ptype);
   free(cc);
@@ -1069,144 +1285,35 @@ pf_interact(const char  *s1,
 
 /*------------------------------------------------------------------------*/
 /* use an extra scale for pf_interact, here sl is the longer sequence */
-PRIVATE void
+PRIVATE double
 scale_int(const char  *s,
           const char  *sl,
-          double      *sc_int)
+          vrna_md_t   *md,
+          double      kT)
 {
-  int     n, nl;
-  duplexT mfe;
-  double  kT;
-
-  n   = strlen(s);
-  nl  = strlen(sl);
-
-  free(expMLbase);
-  free(scale);
+  int                   n;
+  duplexT               mfe;
+  vrna_duplex_context_t ctx;
 
-  expMLbase = (FLT_OR_DBL *)vrna_alloc(sizeof(FLT_OR_DBL) * ((nl + 1) * 2));
-  scale     = (FLT_OR_DBL *)vrna_alloc(sizeof(FLT_OR_DBL) * ((nl + 1) * 2));
+  n = strlen(s);
 
   /* use RNA duplex to get a realistic estimate for the best possible
    * interaction energy between the short RNA s and its target sl */
-  mfe = duplexfold(s, sl);
-
-  kT = Pf->kT / 1000.0; /* in Kcal */
-
-  /* sc_int is similar to pf_scale: i.e. one time the scale */
-  *sc_int = exp(-(mfe.energy) / kT / n);
+  ctx = vrna_duplex_context_init(md);
+  mfe = vrna_duplexfold(ctx, s, sl);
+  vrna_duplex_context_free(ctx);
 
   /* free the structure returned by duplexfold */
   free(mfe.structure);
-}
-
-
-/*----------------------------------------------------------------------*/
-/* init_pf_two(n) :gets the arrays, that you need, from part_func.c */
-/* get_pf_arrays(&S, &S1, &ptype, &qb, &qm, &q1k, &qln);*/
-/* init_pf_fold(), update_pf_params, encode_char(), make_ptypes() are called by pf_fold() */
-PRIVATE void
-init_pf_two(int length)
-{
-#ifdef SUN4
-  nonstandard_arithmetic();
-#else
-#ifdef HP9
-  fpsetfastmode(1);
-#endif
-#endif
-  make_pair_matrix();
-
-  /* gets the arrays, that we need, from part_func.c */
-  if (!get_pf_arrays(&S, &S1, &ptype, &qb, &qm, &q1k, &qln))
-    vrna_message_error("init_pf_two: pf_fold() has to be called before calling pf_unstru()\n");
-
-  /* get a pointer to the base pair probs */
-  probs = export_bppm();
-
-  scale_stru_pf_params((unsigned)length);
-
-  init_length = length;
-  if (init_temp != Pf->temperature)
-    vrna_message_error("init_pf_two: inconsistency with temperature");
-}
-
-
-PRIVATE void
-get_up_arrays(unsigned int length)
-{
-  unsigned int  l1  = length + 1;
-  unsigned int  l2  = length + 2;
-
-  prpr      = (FLT_OR_DBL *)vrna_alloc(sizeof(FLT_OR_DBL) * ((l1 * l2) >> 1));
-  expMLbase = (FLT_OR_DBL *)vrna_alloc(sizeof(FLT_OR_DBL) * l2);
-  scale     = (FLT_OR_DBL *)vrna_alloc(sizeof(FLT_OR_DBL) * l2);
-  qqm2      = (double *)vrna_alloc(sizeof(double) * l2);
-  qq_1m2    = (double *)vrna_alloc(sizeof(double) * l2);
-  qqm       = (double *)vrna_alloc(sizeof(double) * l2);
-  qqm1      = (double *)vrna_alloc(sizeof(double) * l2);
-  my_iindx  = vrna_idx_row_wise(length);
-}
-
-
-PRIVATE void
-free_up_arrays(void)
-{
-  if (prpr != NULL) {
-    free(prpr);
-    prpr = NULL;
-  }
-
-  if (expMLbase != NULL) {
-    free(expMLbase);
-    expMLbase = NULL;
-  }
 
-  if (scale != NULL) {
-    free(scale);
-    scale = NULL;
-  }
-
-  if (qqm != NULL) {
-    free(qqm);
-    qqm = NULL;
-  }
-
-  if (qqm1 != NULL) {
-    free(qqm1);
-    qqm1 = NULL;
-  }
-
-  if (qqm2 != NULL) {
-    free(qqm2);
-    qqm2 = NULL;
-  }
-
-  if (qq_1m2 != NULL) {
-    free(qq_1m2);
-    qq_1m2 = NULL;
-  }
-
-  if (my_iindx != NULL) {
-    free(my_iindx);
-    my_iindx = NULL;
-  }
+  /* sc_int is similar to pf_scale: i.e. one time the scale */
+  return exp(-(mfe.energy) / kT / n);
 }
 
 
 PUBLIC void
 free_interact(interact *pin)
 {
-  if (S != NULL && pin != NULL) {
-    free(S);
-    S = NULL;
-  }
-
-  if (S1 != NULL && pin != NULL) {
-    free(S1);
-    S1 = NULL;
-  }
-
   if (pin != NULL) {
     free(pin->Pi);
     free(pin->Gi);
@@ -1216,81 +1323,35 @@ free_interact(interact *pin)
 }
 
 
-/*---------------------------------------------------------------------------*/
-
-PRIVATE void
-encode_seq(const char *s1,
-           const char *s2)
-{
-  unsigned int i, l;
-
-  l = strlen(s1);
-  /* S and S1 are freed by free_pf_arrays(); ! */
-  S   = (short *)vrna_alloc(sizeof(short) * (l + 1));
-  S1  = (short *)vrna_alloc(sizeof(short) * (l + 1));
-  /* S1 exists only for the special X K and I bases and energy_set!=0 */
-  S[0] = l;
-  for (i = 1; i <= l; i++) {
-    /* make numerical encoding of sequence */
-    S[i]  = (short)encode_char(toupper(s1[i - 1]));
-    S1[i] = alias[S[i]]; /* for mismatches of nostandard bases */
-  }
-  if (s2 != NULL) {
-    l = strlen(s2);
-    /* SS2 exists only for the special X K and I bases and energy_set!=0 */
-    SS[0] = l;
-    for (i = 1; i <= l; i++) {
-      /* make numerical encoding of sequence */
-      SS[i]   = (short)encode_char(toupper(s2[i - 1]));
-      SS2[i]  = alias[SS[i]]; /* for mismatches of nostandard bases */
-    }
-  }
-}
-
-
 /*-------------------------------------------------------------------------*/
 /* scale energy parameters and pre-calculate Boltzmann weights:
  * most of this is done in structure Pf see params.c,h (function:
  * get_scaled_pf_parameters(), only arrays scale and expMLbase are handled here*/
 PRIVATE void
-scale_stru_pf_params(unsigned int length)
+scale_stru_pf_params(vrna_exp_param_t *Pf,
+                     double           pfs,
+                     unsigned int     length,
+                     FLT_OR_DBL       **scale,
+                     FLT_OR_DBL       **expMLbase)
 {
   unsigned int  i;
-  double        kT;
-
-
-  /* Do this only at the first call for get_scaled_pf_parameters()
-   * and/or if temperature has changed*/
-  if (init_temp != temperature) {
-    if (Pf)
-      free(Pf);
-
-    vrna_md_t md;
-    set_model_details(&md);
-    Pf = vrna_exp_params(&md);
-  }
+  FLT_OR_DBL    *sc, *ml;
 
-  init_temp = Pf->temperature;
+  sc  = (FLT_OR_DBL *)vrna_alloc(sizeof(FLT_OR_DBL) * (length + 2));
+  ml  = (FLT_OR_DBL *)vrna_alloc(sizeof(FLT_OR_DBL) * (length + 2));
 
-  kT = Pf->kT; /* kT in cal/mol  */
-
-  /* scaling factors (to avoid overflows) */
-  if (pf_scale == -1) {
-    /* mean energy for random sequences: 184.3*length cal */
-    pf_scale = exp(-(-185 + (Pf->temperature - 37.) * 7.27) / kT);
-    if (pf_scale < 1)
-      pf_scale = 1;
-  }
-
-  Pf->pf_scale  = pf_scale;
-  scale[0]      = 1.;
-  scale[1]      = 1. / pf_scale;
-  expMLbase[0]  = 1;
-  expMLbase[1]  = Pf->expMLbase / pf_scale;
+  Pf->pf_scale  = pfs;
+  sc[0]         = 1.;
+  sc[1]         = 1. / pfs;
+  ml[0]         = 1;
+  ml[1]         = Pf->expMLbase / pfs;
   for (i = 2; i <= length + 1; i++) {
-    scale[i]      = scale[i / 2] * scale[i - (i / 2)];
-    expMLbase[i]  = pow(Pf->expMLbase, (double)i) * scale[i];
+    sc[i] = sc[i / 2] * sc[i - (i / 2)];
+    ml[i] = pow(Pf->expMLbase, (double)i) * sc[i];
   }
+
+  *scale      = sc;
+  *expMLbase  = ml;
 }
 
 
@@ -1484,8 +1545,12 @@ plot_free_pu_out(pu_out   *res,
   int     size, s, i, len;
   double  dG_u;
   char    nan[4], *time, dg[11];
-  FILE    *wastl;
-  double  kT = Pf->kT;
+  FILE      *wastl;
+  double    kT;
+  vrna_md_t md;
+
+  set_model_details(&md);
+  kT = md.betaScale * (md.temperature + K0) * GASCONST; /* in cal/mol */
 
   wastl = fopen(ofile, "a");
   if (wastl == NULL) {
@@ -1620,21 +1685,21 @@ Up_plot(pu_contrib    *p_c,
 /* copy from part_func_co.c */
 PRIVATE constrain *
 get_ptypes_up(char        *Seq,
-              const char  *structure)
+              const char  *structure,
+              vrna_md_t   *md)
 {
   int       n, i, j, k, l, length;
   constrain *con;
   short     *s, *s1;
 
   length = strlen(Seq);
-  make_pair_matrix();
   con       = (constrain *)vrna_alloc(sizeof(constrain));
   con->indx = (int *)vrna_alloc(sizeof(int) * (length + 1));
   for (i = 1; i <= length; i++)
     con->indx[i] = ((length + 1 - i) * (length - i)) / 2 + length + 1;
   con->ptype = (char *)vrna_alloc(sizeof(char) * ((length + 1) * (length + 2) / 2));
 
-  set_encoded_seq((const char *)Seq, &s, &s1);
+  set_encoded_seq((const char *)Seq, &s, &s1, md);
 
   n = s[0];
   for (k = 1; k <= n - CO_TURN - 1; k++)
@@ -1645,12 +1710,12 @@ get_ptypes_up(char        *Seq,
       if (j > n)
         continue;
 
-      type = pair[s[i]][s[j]];
+      type = md->pair[s[i]][s[j]];
       while ((i >= 1) && (j <= n)) {
         if ((i > 1) && (j < n))
-          ntype = pair[s[i - 1]][s[j + 1]];
+          ntype = md->pair[s[i - 1]][s[j + 1]];
 
-        if (noLonelyPairs && (!otype) && (!ntype))
+        if (md->noLP && (!otype) && (!ntype))
           type = 0; /* i.j can only form isolated pairs */
 
         con->ptype[con->indx[i] - j]  = (char)type;
@@ -1661,7 +1726,7 @@ get_ptypes_up(char        *Seq,
       }
     }
 
-  if (fold_constrained && (structure != NULL)) {
+  if (structure != NULL) {
     int   hx, *stack;
     char  type;
     stack = (int *)vrna_alloc(sizeof(int) * (n + 1));
@@ -1712,7 +1777,8 @@ get_ptypes_up(char        *Seq,
 PRIVATE void
 set_encoded_seq(const char  *sequence,
                 short       **S,
-                short       **S1)
+                short       **S1,
+                vrna_md_t   *md)
 {
   unsigned int i, l;
 
@@ -1720,7 +1786,7 @@ set_encoded_seq(const char  *sequence,
   if (S != NULL) {
     *S = (short *)vrna_alloc(sizeof(short) * (l + 2));
     for (i = 1; i <= l; i++) /* make numerical encoding of sequence */
-      (*S)[i] = (short)encode_char(toupper(sequence[i - 1]));
+      (*S)[i] = (short)vrna_nucleotide_encode(sequence[i - 1], md);
     (*S)[l + 1] = (*S)[1];
     (*S)[0]     = (short)l;
   }
@@ -1728,8 +1794,8 @@ set_encoded_seq(const char  *sequence,
   /* S1 exists only for the special X K and I bases and energy_set!=0 */
   if (S1 != NULL) {
     *S1 = (short *)vrna_alloc(sizeof(short) * (l + 2));
-    for (i = 1; i <= l; i++)                                            /* make numerical encoding of sequence */
-      (*S1)[i] = alias[(short)encode_char(toupper(sequence[i - 1]))];   /* for mismatches of nostandard bases */
+    for (i = 1; i <= l; i++)                                                    /* make numerical encoding of sequence */
+      (*S1)[i] = md->alias[(short)vrna_nucleotide_encode(sequence[i - 1], md)]; /* for mismatches of nostandard bases */
     /* for circular folding add first base at position n+1 and last base at position 0 in S1 */
     (*S1)[l + 1]  = (*S1)[1];
     (*S1)[0]      = (*S1)[l];
@@ -2,8 +2,8 @@
 #define VIENNA_RNA_PACKAGE_PART_FUNC_UP_H
 
 #include <ViennaRNA/datastructures/basic.h>
-
-#ifndef VRNA_DISABLE_BACKWARD_COMPATIBILITY
+#include <ViennaRNA/model.h>
+#include <ViennaRNA/fold_compound.h>
 
 #define   RNA_UP_MODE_1   1U
 #define   RNA_UP_MODE_2   2U
@@ -32,6 +32,8 @@
  *  we compute the free energy of an interaction for every possible binding site.
  */
 
+#ifndef VRNA_DISABLE_BACKWARD_COMPATIBILITY
+
 /**
  *  @brief Calculate the partition function over all unpaired regions
  *  of a maximal length.
@@ -112,6 +114,65 @@ interact *pf_interact(const char *s1,
                       int incr3,
                       int incr5);
 
+#endif
+
+
+/**
+ *  @brief Calculate the partition function over all unpaired regions
+ *  of a maximal length for a fold compound
+ *
+ *  This is the reentrant variant of pf_unstru(). Instead of relying on the
+ *  global partition function arrays of the last call to pf_fold(), all data
+ *  is taken from the fold compound @p fc, i.e. its Boltzmann weights and the
+ *  partition function and base pair probability matrices. Hence, vrna_pf()
+ *  with base pair probability computation turned on has to be called for
+ *  @p fc before calling this function. Since no global state is touched,
+ *  different fold compounds can be processed in parallel.
+ *
+ *  @see pf_unstru(), vrna_pf_interact(), free_pu_contrib()
+ *
+ *  @param  fc    The fold compound with base pair probabilities already computed
+ *  @param  max_w The maximal length of an unpaired region
+ *  @return       The contributions to the probability of being unpaired, or NULL on error
+ */
+pu_contrib *vrna_pf_unstru(vrna_fold_compound_t *fc,
+                           int                  max_w);
+
+
+/**
+ *  @brief Calculates the probability of a local interaction between two sequences
+ *  with explicit model details
+ *
+ *  This is the reentrant variant of pf_interact(). All energy parameters are
+ *  derived from the model details @p md (or the defaults if @p md is NULL)
+ *  rather than from global variables, and the global partition function arrays
+ *  are left untouched. Constrained interactions are computed whenever
+ *  @p cstruc is not NULL.
+ *
+ *  @see pf_interact(), vrna_pf_unstru(), free_interact()
+ *
+ *  @param  s1      The longer sequence
+ *  @param  s2      The shorter sequence
+ *  @param  p_c     Probabilities of being unpaired for @p s1
+ *  @param  p_c2    Probabilities of being unpaired for @p s2 (may be NULL)
+ *  @param  max_w   The maximal length of the interaction
+ *  @param  cstruc  Intermolecular constraints or NULL
+ *  @param  incr3   Unpaired residues 3' of the interaction site in @p s1
+ *  @param  incr5   Unpaired residues 5' of the interaction site in @p s1
+ *  @param  md      Model details to use (may be NULL)
+ *  @return         The interaction probabilities and energies, or NULL on error
+ */
+interact *vrna_pf_interact(const char       *s1,
+                           const char       *s2,
+                           pu_contrib       *p_c,
+                           pu_contrib       *p_c2,
+                           int              max_w,
+                           const char       *cstruc,
+                           int              incr3,
+                           int              incr5,
+                           const vrna_md_t  *md);
+
+
 /**
  *  @brief Frees the output of function pf_interact().
  */
@@ -148,5 +209,3 @@ free_pu_contrib(pu_contrib *pu);
  */
 
 #endif
-
-#endif
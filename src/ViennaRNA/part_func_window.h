@@ -188,6 +188,12 @@ typedef void (vrna_probs_window_callback)(FLT_OR_DBL    *pr,
  *  @note   The parameter @p ulength only affects computation and resulting data if unpaired
  *          probability computations are requested through the @p options flag.
  *
+ *  @note   If #vrna_md_t.num_threads is larger than 1, the scan of long single sequences
+ *          without soft constraints or non-default hard constraints is split into consecutive
+ *          blocks that are computed concurrently. The callback @p cb is still executed from
+ *          the calling thread only, in the same order and with the same data as in the
+ *          sequential scan.
+ *
  *  #### Options: ####
  *  * #VRNA_PROBS_WINDOW_BPP      - @copybrief #VRNA_PROBS_WINDOW_BPP
  *  * #VRNA_PROBS_WINDOW_UP       - @copybrief #VRNA_PROBS_WINDOW_UP
@@ -211,6 +217,45 @@ vrna_probs_window(vrna_fold_compound_t        *fc,
                   vrna_probs_window_callback  *cb,
                   void                        *data);
 
+
+/**
+ *  @brief  Compute various equilibrium probabilities for a sequence that is read piece by piece
+ *
+ *  This function is a streaming variant of vrna_probs_window() for single sequences that
+ *  are too long to be kept in memory. The sequence is retrieved through the callback @p read
+ *  and the sliding window scan is split into consecutive blocks, where each block is computed
+ *  for a subsequence that extends far enough up- and downstream to reproduce the probabilities
+ *  of the full scan. At any time, only a few blocks of the sequence and the output of the
+ *  blocks that await their hand-over to the callback @p cb are kept in memory, i.e. the memory
+ *  requirement is independent of the sequence length. If #vrna_md_t.num_threads is larger
+ *  than 1, several blocks are computed concurrently.
+ *
+ *  The callback @p cb receives the same data in the same order as for vrna_probs_window().
+ *
+ *  @note Soft constraints, non-default hard constraints, and extensions of the grammar are
+ *        not available for streaming computations.
+ *
+ *  @see  vrna_probs_window(), vrna_mfe_window_stream(), #vrna_sequence_stream_callback,
+ *        vrna_file_fasta_read_sequence()
+ *
+ *  @param  md            The model details (maybe NULL for default settings), #vrna_md_t.window_size must be set
+ *  @param  ulength       The maximal length of an unpaired segment (only for unpaired probability computations)
+ *  @param  options       Option flags to control the behavior of this function
+ *  @param  read          The callback that provides the sequence
+ *  @param  read_data     Some arbitrary data pointer passed through to the callback @p read
+ *  @param  cb            The callback function which collects the pair probability data for further processing
+ *  @param  data          Some arbitrary data structure that is passed to the callback @p cb
+ *  @return               0 on failure, non-zero on success
+ */
+int
+vrna_probs_window_stream(vrna_md_t                      *md,
+                         int                            ulength,
+                         unsigned int                   options,
+                         vrna_sequence_stream_callback  *read,
+                         void                           *read_data,
+                         vrna_probs_window_callback     *cb,
+                         void                           *data);
+
 /* End basic interface */
 /**@}*/
 
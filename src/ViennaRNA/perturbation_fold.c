@@ -29,13 +29,14 @@ calculate_probability_unpaired(vrna_fold_compound_t *vc,
   int         length = vc->length;
   FLT_OR_DBL  *probs = vc->exp_matrices->probs;
   int         *iidx = vc->iindx;
+  int         max_d = (vc->jindx_span) ? (int)vc->jindx_span + 1 : length;
   int         i, j;
 
   for (i = 0; i <= length; ++i)
     probability[i] = 1;
 
   for (i = 1; i <= length; ++i)
-    for (j = i + 1; j <= length; ++j) {
+    for (j = i + 1; j <= MIN2(length, i + max_d); ++j) {
       probability[i]  -= probs[iidx[i] - j];
       probability[j]  -= probs[iidx[i] - j];
     }
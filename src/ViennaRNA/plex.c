@@ -37,6 +37,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdarg.h>
 #include <math.h>
 #include <ctype.h>
 #include <string.h>
@@ -44,7 +45,8 @@
 #include "ViennaRNA/params/default.h"
 #include "ViennaRNA/fold_vars.h"
 #include "ViennaRNA/fold.h"
-#include "ViennaRNA/pair_mat.h"
+#include "ViennaRNA/model.h"
+#include "ViennaRNA/alphabet.h"
 #include "ViennaRNA/params/basic.h"
 #include "ViennaRNA/plex.h"
 #include "ViennaRNA/ali_plex.h"
@@ -78,16 +80,14 @@
 #define LINIY(i, j, l)    ((i + 25) * l + j)
 
 PRIVATE void
-encode_seqs(const char  *s1,
-            const char  *s2);
+encode_seqs(vrna_plex_context_t ctx,
+            const char          *s1,
+            const char          *s2);
 
 
 PRIVATE short *
-encode_seq(const char *seq);
-
-
-PRIVATE void
-update_dfold_params(void);
+encode_seq(vrna_plex_context_t ctx,
+           const char          *seq);
 
 
 /**
@@ -96,154 +96,166 @@ update_dfold_params(void);
 *** fduplexfold(_XS) computes duplex in a plex way
 **/
 PRIVATE duplexT
-duplexfold(const char *s1,
-           const char *s2,
-           const int  extension_cost);
+duplexfold(vrna_plex_context_t ctx,
+           const char          *s1,
+           const char          *s2,
+           const int           extension_cost);
 
 
 PRIVATE char *
-backtrack(int       i,
-          int       j,
-          const int extension_cost);
+backtrack(vrna_plex_context_t ctx,
+          int                 i,
+          int                 j,
+          const int           extension_cost);
 
 
 PRIVATE void
-find_max(const int  *position,
-         const int  *position_j,
-         const int  delta,
-         const int  threshold,
-         const int  length,
-         const char *s1,
-         const char *s2,
-         const int  extension_cost,
-         const int  fast,
-         const int  il_a,
-         const int  il_b,
-         const int  b_a,
-         const int  b_b);
+find_max(vrna_plex_context_t ctx,
+         const int           *position,
+         const int           *position_j,
+         const int           delta,
+         const int           threshold,
+         const int           length,
+         const char          *s1,
+         const char          *s2,
+         const int           extension_cost,
+         const int           fast,
+         const int           il_a,
+         const int           il_b,
+         const int           b_a,
+         const int           b_b);
 
 
 PRIVATE void
-plot_max(const int  max,
-         const int  max_pos,
-         const int  max_pos_j,
-         const int  alignment_length,
-         const char *s1,
-         const char *s2,
-         const int  extension_cost,
-         const int  fast,
-         const int  il_a,
-         const int  il_b,
-         const int  b_a,
-         const int  b_b);
+plot_max(vrna_plex_context_t ctx,
+         const int           max,
+         const int           max_pos,
+         const int           max_pos_j,
+         const int           alignment_length,
+         const char          *s1,
+         const char          *s2,
+         const int           extension_cost,
+         const int           fast,
+         const int           il_a,
+         const int           il_b,
+         const int           b_a,
+         const int           b_b);
 
 
 /* PRIVATE duplexT duplexfold_XS(const char *s1, const char *s2,const int **access_s1, const int **access_s2, const int i_pos, const int j_pos, const int threshold); */
 PRIVATE duplexT
-duplexfold_XS(const char  *s1,
-              const char  *s2,
-              const int   **access_s1,
-              const int   **access_s2,
-              const int   i_pos,
-              const int   j_pos,
-              const int   threshold,
-              const int   i_flag,
-              const int   j_flag);
+duplexfold_XS(vrna_plex_context_t ctx,
+              const char          *s1,
+              const char          *s2,
+              const int           **access_s1,
+              const int           **access_s2,
+              const int           i_pos,
+              const int           j_pos,
+              const int           threshold,
+              const int           i_flag,
+              const int           j_flag);
 
 
 /* PRIVATE char *   backtrack_XS(int i, int j, const int** access_s1, const int** access_s2); */
 PRIVATE char *
-backtrack_XS(int        i,
-             int        j,
-             const int  **access_s1,
-             const int  **access_s2,
-             const int  i_flag,
-             const int  j_flag);
+backtrack_XS(vrna_plex_context_t ctx,
+             int                 i,
+             int                 j,
+             const int           **access_s1,
+             const int           **access_s2,
+             const int           i_flag,
+             const int           j_flag);
 
 
 PRIVATE void
-find_max_XS(const int   *position,
-            const int   *position_j,
-            const int   delta,
-            const int   threshold,
-            const int   alignment_length,
-            const char  *s1,
-            const char  *s2,
-            const int   **access_s1,
-            const int   **access_s2,
-            const int   fast,
-            const int   il_a,
-            const int   il_b,
-            const int   b_a,
-            const int   b_b);
+find_max_XS(vrna_plex_context_t ctx,
+            const int           *position,
+            const int           *position_j,
+            const int           delta,
+            const int           threshold,
+            const int           alignment_length,
+            const char          *s1,
+            const char          *s2,
+            const int           **access_s1,
+            const int           **access_s2,
+            const int           fast,
+            const int           il_a,
+            const int           il_b,
+            const int           b_a,
+            const int           b_b);
 
 
 PRIVATE void
-plot_max_XS(const int   max,
-            const int   max_pos,
-            const int   max_pos_j,
-            const int   alignment_length,
-            const char  *s1,
-            const char  *s2,
-            const int   **access_s1,
-            const int   **access_s2,
-            const int   fast,
-            const int   il_a,
-            const int   il_b,
-            const int   b_a,
-            const int   b_b);
+plot_max_XS(vrna_plex_context_t ctx,
+            const int           max,
+            const int           max_pos,
+            const int           max_pos_j,
+            const int           alignment_length,
+            const char          *s1,
+            const char          *s2,
+            const int           **access_s1,
+            const int           **access_s2,
+            const int           fast,
+            const int           il_a,
+            const int           il_b,
+            const int           b_a,
+            const int           b_b);
 
 
 PRIVATE duplexT
-fduplexfold(const char  *s1,
-            const char  *s2,
-            const int   extension_cost,
-            const int   il_a,
-            const int   il_b,
-            const int   b_a,
-            const int   b_b);
+fduplexfold(vrna_plex_context_t ctx,
+            const char          *s1,
+            const char          *s2,
+            const int           extension_cost,
+            const int           il_a,
+            const int           il_b,
+            const int           b_a,
+            const int           b_b);
 
 
 PRIVATE char *
-fbacktrack(int        i,
-           int        j,
-           const int  extension_cost,
-           const int  il_a,
-           const int  il_b,
-           const int  b_a,
-           const int  b_b,
-           int        *dG);
+fbacktrack(vrna_plex_context_t ctx,
+           int                 i,
+           int                 j,
+           const int           extension_cost,
+           const int           il_a,
+           const int           il_b,
+           const int           b_a,
+           const int           b_b,
+           int                 *dG);
 
 
 PRIVATE duplexT
-fduplexfold_XS(const char *s1,
-               const char *s2,
-               const int  **access_s1,
-               const int  **access_s2,
-               const int  i_pos,
-               const int  j_pos,
-               const int  threshold,
-               const int  il_a,
-               const int  il_b,
-               const int  b_a,
-               const int  b_b);
+fduplexfold_XS(vrna_plex_context_t ctx,
+               const char          *s1,
+               const char          *s2,
+               const int           **access_s1,
+               const int           **access_s2,
+               const int           i_pos,
+               const int           j_pos,
+               const int           threshold,
+               const int           il_a,
+               const int           il_b,
+               const int           b_a,
+               const int           b_b);
 
 
 PRIVATE char *
-fbacktrack_XS(int       i,
-              int       j,
-              const int **access_s1,
-              const int **access_s2,
-              const int i_pos,
-              const int j_pos,
-              const int il_a,
-              const int il_b,
-              const int b_a,
-              const int b_b,
-              int       *dGe,
-              int       *dGeplex,
-              int       *dGx,
-              int       *dGy);
+fbacktrack_XS(vrna_plex_context_t ctx,
+              int                 i,
+              int                 j,
+              const int           **access_s1,
+              const int           **access_s2,
+              const int           i_pos,
+              const int           j_pos,
+              const int           il_a,
+              const int           il_b,
+              const int           b_a,
+              const int           b_b,
+              int                 *dGe,
+              int                 *dGeplex,
+              int                 *dGx,
+              int                 *dGy);
 
 
 /*@unused@*/
@@ -251,25 +263,62 @@ fbacktrack_XS(int       i,
 #define MAXSECTORS      500     /* dimension for a backtrack array */
 #define LOCALITY        0.      /* locality parameter for base-pairs */
 
-PRIVATE vrna_param_t *P = NULL;
+struct vrna_plex_context_s {
+  vrna_param_t  *P;
+  int           (*pair)[MAXALPHA + 1];
+  int           *rtype;
+  short         *alias;
 
-/**
-*** energy array used in fduplexfold and fduplexfold_XS
-*** We do not use the 1D array here as it is not time critical
-*** It also makes the code more readable
-*** c -> stack;in -> interior loop;bx/by->bulge;inx/iny->1xn loops
-**/
+  /**
+  *** energy array used in fduplexfold and fduplexfold_XS
+  *** We do not use the 1D array here as it is not time critical
+  *** It also makes the code more readable
+  *** c -> stack;in -> interior loop;bx/by->bulge;inx/iny->1xn loops
+  **/
+  int           **c, **in, **bx, **by, **inx, **iny;
+
+  /**
+  *** S1, SS1, ... contains the encoded sequence for target and query
+  *** n1, n2, n3, n4 contains target and query length
+  **/
+  short         *S1, *SS1, *S2, *SS2;
+  int           n1, n2;               /* sequence lengths */
+  int           n3, n4;               /* sequence length for the duplex */
 
-PRIVATE int **c = NULL, **in = NULL, **bx = NULL, **by = NULL, **inx = NULL, **iny = NULL;
+  vrna_cstr_t   output;               /* output buffer, print to stdout if NULL */
+};
 
-/**
-*** S1, SS1, ... contains the encoded sequence for target and query
-*** n1, n2, n3, n4 contains target and query length
-**/
+#ifndef VRNA_DISABLE_BACKWARD_COMPATIBILITY
+
+/* context used by the old API, re-created whenever the global model settings change */
+PRIVATE vrna_plex_context_t backward_compat_ctx = NULL;
+PRIVATE vrna_md_t           backward_compat_md;
+
+#ifdef _OPENMP
+
+#pragma omp threadprivate(backward_compat_ctx, backward_compat_md)
+
+#endif
+
+#endif
 
-PRIVATE short *S1 = NULL, *SS1 = NULL, *S2 = NULL, *SS2 = NULL; /*contains the sequences*/
-PRIVATE int   n1, n2;                                           /* sequence lengths */
-PRIVATE int   n3, n4; /*sequence length for the duplex*/;
+
+PRIVATE void
+plex_printf(vrna_plex_context_t ctx,
+            const char          *format,
+            ...)
+{
+  va_list args;
+
+  va_start(args, format);
+
+  if (ctx->output)
+    vrna_cstr_vprintf(ctx->output, format, args);
+  else
+    vprintf(format, args);
+
+  va_end(args);
+}
 
 
 /*-----------------------------------------------------------------------duplexfold_XS---------------------------------------------------------------------------*/
@@ -282,49 +331,49 @@ PRIVATE int   n3, n4; /*sequence length for the duplex*/;
 *** profiles, i_pos, j_pos are the coordinates of the closing pair.
 **/
 PRIVATE duplexT
-duplexfold_XS(const char  *s1,
-              const char  *s2,
-              const int   **access_s1,
-              const int   **access_s2,
-              const int   i_pos,
-              const int   j_pos,
-              const int   threshold,
-              const int   i_flag,
-              const int   j_flag)
+duplexfold_XS(vrna_plex_context_t ctx,
+              const char          *s1,
+              const char          *s2,
+              const int           **access_s1,
+              const int           **access_s2,
+              const int           i_pos,
+              const int           j_pos,
+              const int           threshold,
+              const int           i_flag,
+              const int           j_flag)
 {
-  int       i, j, p, q, Emin = INF, l_min = 0, k_min = 0;
-  char      *struc;
-  vrna_md_t md;
+  vrna_param_t  *P;
+  int           **c, (*pair)[MAXALPHA + 1], *rtype, n3, n4;
+  short         *S1, *SS1, *S2, *SS2;
+  int           i, j, p, q, Emin = INF, l_min = 0, k_min = 0;
+  char          *struc;
 
-  struc = NULL;
-  duplexT   mfe;
-  n3  = (int)strlen(s1);
-  n4  = (int)strlen(s2);
-
-  set_model_details(&md);
-
-  if ((!P) || (fabs(P->temperature - temperature) > 1e-6)) {
-    update_fold_params();
-    if (P)
-      free(P);
+  P     = ctx->P;
+  pair  = ctx->pair;
+  rtype = ctx->rtype;
 
-    P = vrna_params(&md);
-    make_pair_matrix();
-  }
+  struc = NULL;
+  duplexT mfe;
+  n3  = ctx->n3 = (int)strlen(s1);
+  n4  = ctx->n4 = (int)strlen(s2);
 
-  c = (int **)vrna_alloc(sizeof(int *) * (n3 + 1));
+  c = ctx->c = (int **)vrna_alloc(sizeof(int *) * (n3 + 1));
   for (i = 0; i <= n3; i++)
     c[i] = (int *)vrna_alloc(sizeof(int) * (n4 + 1));
   for (i = 0; i <= n3; i++)
     for (j = 0; j <= n4; j++)
       c[i][j] = INF;
-  encode_seqs(s1, s2);
+  encode_seqs(ctx, s1, s2);
+  S1  = ctx->S1;
+  SS1 = ctx->SS1;
+  S2  = ctx->S2;
+  SS2 = ctx->SS2;
   int type, type2, type3, E, k, l;
   i     = n3 - i_flag;
   j     = 1 + j_flag;
   type  = pair[S1[i]][S2[j]];
   if (!type) {
-    printf("Error during initialization of the duplex in duplexfold_XS\n");
+    plex_printf(ctx, "Error during initialization of the duplex in duplexfold_XS\n");
     mfe.structure = NULL;
     mfe.energy    = INF;
     return mfe;
@@ -417,7 +466,7 @@ duplexfold_XS(const char  *s1,
     free(SS2);
     return mfe;
   } else {
-    struc = backtrack_XS(k_min, l_min, access_s1, access_s2, i_flag, j_flag);
+    struc = backtrack_XS(ctx, k_min, l_min, access_s1, access_s2, i_flag, j_flag);
   }
 
   /**
@@ -463,17 +512,32 @@ duplexfold_XS(const char  *s1,
 
 
 PRIVATE char *
-backtrack_XS(int        i,
-             int        j,
-             const int  **access_s1,
-             const int  **access_s2,
-             const int  i_flag,
-             const int  j_flag)
+backtrack_XS(vrna_plex_context_t ctx,
+             int                 i,
+             int                 j,
+             const int           **access_s1,
+             const int           **access_s2,
+             const int           i_flag,
+             const int           j_flag)
 {
+  vrna_param_t  *P;
+  int           **c, (*pair)[MAXALPHA + 1], *rtype, n3, n4;
+  short         *S1, *SS1, *S2, *SS2;
   /* backtrack structure going backwards from i, and forwards from j
    * return structure in bracket notation with & as separator */
-  int   k, l, type, type2, E, traced, i0, j0;
-  char  *st1, *st2, *struc;
+  int           k, l, type, type2, E, traced, i0, j0;
+  char          *st1, *st2, *struc;
+
+  P     = ctx->P;
+  c     = ctx->c;
+  pair  = ctx->pair;
+  rtype = ctx->rtype;
+  S1    = ctx->S1;
+  SS1   = ctx->SS1;
+  S2    = ctx->S2;
+  SS2   = ctx->SS2;
+  n3    = ctx->n3;
+  n4    = ctx->n4;
 
   st1 = (char *)vrna_alloc(sizeof(char) * (n3 + 1));
   st2 = (char *)vrna_alloc(sizeof(char) * (n4 + 1));
@@ -562,26 +626,30 @@ backtrack_XS(int        i,
 *** We use the standard matrix (c, in, etc..., because we backtrack)
 **/
 PRIVATE duplexT
-fduplexfold_XS(const char *s1,
-               const char *s2,
-               const int  **access_s1,
-               const int  **access_s2,
-               const int  i_pos,
-               const int  j_pos,
-               const int  threshold,
-               const int  il_a,
-               const int  il_b,
-               const int  b_a,
-               const int  b_b)
+fduplexfold_XS(vrna_plex_context_t ctx,
+               const char          *s1,
+               const char          *s2,
+               const int           **access_s1,
+               const int           **access_s2,
+               const int           i_pos,
+               const int           j_pos,
+               const int           threshold,
+               const int           il_a,
+               const int           il_b,
+               const int           b_a,
+               const int           b_b)
 {
+  vrna_param_t  *P;
+  int           **c, **in, **bx, **by, **inx, **iny, (*pair)[MAXALPHA + 1], *rtype, n3, n4;
+  short         *S1, *SS1, *S2, *SS2;
   /**
   *** i,j recursion index
   *** Emin, i_min, j_min MFE position and energy
   *** mfe struc duplex structure
   **/
-  int     i, j, Emin, i_min, j_min, l1;
-  duplexT mfe;
-  char    *struc;
+  int           i, j, Emin, i_min, j_min, l1;
+  duplexT       mfe;
+  char          *struc;
   /**
   *** bext=b_a bulge extension parameter for linear model
   *** iopen=il_b interior opening for linear model
@@ -598,47 +666,41 @@ fduplexfold_XS(const char *s1,
   *** DJ contains the accessibility penalty for the query sequence
   *** maxPenalty contains the maximum penalty
   **/
-  int       bopen       = b_b;
-  int       bext        = b_a;
-  int       iopen       = il_b;
-  int       iext_s      = 2 * il_a;   /* iext_s 2 nt nucleotide extension of interior loop, on i and j side */
-  int       iext_ass    = 50 + il_a;  /* iext_ass assymetric extension of interior loop, either on i or on j side. */
-  int       min_colonne = INF;        /* enthaelt das maximum einer kolonne */
-  int       i_length;
-  int       max_pos;                  /* get position of the best hit */
-  int       max_pos_j;
-  int       temp = INF;
-  int       min_j_colonne;
-  int       max = INF;
-  int       **DJ;
-  int       maxPenalty[4];
-  vrna_md_t md;
+  int           bopen       = b_b;
+  int           bext        = b_a;
+  int           iopen       = il_b;
+  int           iext_s      = 2 * il_a;   /* iext_s 2 nt nucleotide extension of interior loop, on i and j side */
+  int           iext_ass    = 50 + il_a;  /* iext_ass assymetric extension of interior loop, either on i or on j side. */
+  int           min_colonne = INF;        /* enthaelt das maximum einer kolonne */
+  int           i_length;
+  int           max_pos;                  /* get position of the best hit */
+  int           max_pos_j;
+  int           temp = INF;
+  int           min_j_colonne;
+  int           max = INF;
+  int           **DJ;
+  int           maxPenalty[4];
 
   /**
   *** variable initialization
   **/
-  n3  = (int)strlen(s1);
-  n4  = (int)strlen(s2);
 
-  set_model_details(&md);
-  if ((!P) || (fabs(P->temperature - temperature) > 1e-6)) {
-    update_fold_params();
-    if (P)
-      free(P);
+  P     = ctx->P;
+  pair  = ctx->pair;
+  rtype = ctx->rtype;
 
-    P = vrna_params(&md);
-    make_pair_matrix();
-  }
+  n3  = ctx->n3 = (int)strlen(s1);
+  n4  = ctx->n4 = (int)strlen(s2);
 
   /**
   *** array initialization
   **/
-  c   = (int **)vrna_alloc(sizeof(int *) * (n3 + 1));
-  in  = (int **)vrna_alloc(sizeof(int *) * (n3 + 1));
-  bx  = (int **)vrna_alloc(sizeof(int *) * (n3 + 1));
-  by  = (int **)vrna_alloc(sizeof(int *) * (n3 + 1));
-  inx = (int **)vrna_alloc(sizeof(int *) * (n3 + 1));
-  iny = (int **)vrna_alloc(sizeof(int *) * (n3 + 1));
+  c   = ctx->c = (int **)vrna_alloc(sizeof(int *) * (n3 + 1));
+  in  = ctx->in = (int **)vrna_alloc(sizeof(int *) * (n3 + 1));
+  bx  = ctx->bx = (int **)vrna_alloc(sizeof(int *) * (n3 + 1));
+  by  = ctx->by = (int **)vrna_alloc(sizeof(int *) * (n3 + 1));
+  inx = ctx->inx = (int **)vrna_alloc(sizeof(int *) * (n3 + 1));
+  iny = ctx->iny = (int **)vrna_alloc(sizeof(int *) * (n3 + 1));
   /* #pragma omp parallel for */
   for (i = 0; i <= n3; i++) {
     c[i]    = (int *)vrna_alloc(sizeof(int) * (n4 + 1));
@@ -661,7 +723,11 @@ fduplexfold_XS(const char *s1,
   /**
   *** sequence encoding
   **/
-  encode_seqs(s1, s2);
+  encode_seqs(ctx, s1, s2);
+  S1  = ctx->S1;
+  SS1 = ctx->SS1;
+  S2  = ctx->S2;
+  SS2 = ctx->SS2;
   /**
   *** Compute max accessibility penalty for the query only once
   **/
@@ -973,7 +1039,8 @@ fduplexfold_XS(const char *s1,
   int dGe, dGeplex, dGx, dGy;
   dGe = dGeplex = dGx = dGy = 0;
   /* printf("MAX fduplexfold_XS %d\n",Emin); */
-  struc = fbacktrack_XS(i_min,
+  struc = fbacktrack_XS(ctx,
+                        i_min,
                         j_min,
                         access_s1,
                         access_s2,
@@ -1045,30 +1112,50 @@ fduplexfold_XS(const char *s1,
 
 
 PRIVATE char *
-fbacktrack_XS(int       i,
-              int       j,
-              const int **access_s1,
-              const int **access_s2,
-              const int i_pos,
-              const int j_pos,
-              const int il_a,
-              const int il_b,
-              const int b_a,
-              const int b_b,
-              int       *dG,
-              int       *dGplex,
-              int       *dGx,
-              int       *dGy)
+fbacktrack_XS(vrna_plex_context_t ctx,
+              int                 i,
+              int                 j,
+              const int           **access_s1,
+              const int           **access_s2,
+              const int           i_pos,
+              const int           j_pos,
+              const int           il_a,
+              const int           il_b,
+              const int           b_a,
+              const int           b_b,
+              int                 *dG,
+              int                 *dGplex,
+              int                 *dGx,
+              int                 *dGy)
 {
+  vrna_param_t  *P;
+  int           **c, **in, **bx, **by, **inx, **iny, (*pair)[MAXALPHA + 1], *rtype, n3, n4;
+  short         *S1, *SS1, *S2, *SS2;
   /* backtrack structure going backwards from i, and forwards from j
    * return structure in bracket notation with & as separator */
-  int   k, l, type, type2, E, traced, i0, j0;
-  char  *st1, *st2, *struc;
-  int   bopen     = b_b;
-  int   bext      = b_a;
-  int   iopen     = il_b;
-  int   iext_s    = 2 * il_a;   /* iext_s 2 nt nucleotide extension of interior loop, on i and j side */
-  int   iext_ass  = 50 + il_a;  /* iext_ass assymetric extension of interior loop, either on i or on j side. */
+  int           k, l, type, type2, E, traced, i0, j0;
+  char          *st1, *st2, *struc;
+  int           bopen     = b_b;
+  int           bext      = b_a;
+  int           iopen     = il_b;
+  int           iext_s    = 2 * il_a;   /* iext_s 2 nt nucleotide extension of interior loop, on i and j side */
+  int           iext_ass  = 50 + il_a;  /* iext_ass assymetric extension of interior loop, either on i or on j side. */
+
+  P     = ctx->P;
+  c     = ctx->c;
+  in    = ctx->in;
+  bx    = ctx->bx;
+  by    = ctx->by;
+  inx   = ctx->inx;
+  iny   = ctx->iny;
+  pair  = ctx->pair;
+  rtype = ctx->rtype;
+  S1    = ctx->S1;
+  SS1   = ctx->SS1;
+  S2    = ctx->S2;
+  SS2   = ctx->SS2;
+  n3    = ctx->n3;
+  n4    = ctx->n4;
 
   st1 = (char *)vrna_alloc(sizeof(char) * (n3 + 1));
   st2 = (char *)vrna_alloc(sizeof(char) * (n4 + 1));
@@ -1084,24 +1171,12 @@ fbacktrack_XS(int       i,
   traced  = 1;
   k       = i;
   l       = j; /* stores the i,j information for subsequence usage see * */
-  int       idiff, jdiff;
+  int idiff, jdiff;
   /**
   *** (type>2?P->TerminalAU:0)+P->dangle3[rtype[type]][SS1[i+1]]+P->dangle5[rtype[type]][SS2[j-1]];
   **/
 
-  int       maxPenalty[4];
-  vrna_md_t md;
-
-  set_model_details(&md);
-
-  if ((!P) || (fabs(P->temperature - temperature) > 1e-6)) {
-    update_dfold_params();
-    if (P)
-      free(P);
-
-    P = vrna_params(&md);
-    make_pair_matrix();
-  }
+  int maxPenalty[4];
 
   maxPenalty[0] = (int)-1 * P->stack[2][2] / 2;
   maxPenalty[1] = (int)-1 * P->stack[2][2];
@@ -1889,67 +1964,68 @@ fbacktrack_XS(int       i,
 }
 
 
-duplexT **
-Lduplexfold_XS(const char *s1,
-               const char *s2,
-               const int  **access_s1,
-               const int  **access_s2,
-               const int  threshold,
-               const int  alignment_length,
-               const int  delta,
-               const int  fast,
-               const int  il_a,
-               const int  il_b,
-               const int  b_a,
-               const int  b_b)
+PRIVATE void
+plex_scan_XS(vrna_plex_context_t ctx,
+             const char          *s1,
+             const char          *s2,
+             const int           **access_s1,
+             const int           **access_s2,
+             const int           threshold,
+             const int           alignment_length,
+             const int           delta,
+             const int           fast,
+             const int           il_a,
+             const int           il_b,
+             const int           b_a,
+             const int           b_b)
 {
+  vrna_param_t  *P;
+  int           (*pair)[MAXALPHA + 1], *rtype, n1, n2;
+  short         *S1, *SS1, *S2, *SS2;
   /**
   *** See variable definition in fduplexfold_XS
   **/
-  int       i, j;
-  int       bopen       = b_b;
-  int       bext        = b_a;
-  int       iopen       = il_b;
-  int       iext_s      = 2 * il_a;
-  int       iext_ass    = 50 + il_a;
-  int       min_colonne = INF;
-  int       i_length;
-  int       max_pos;
-  int       max_pos_j;
-  int       min_j_colonne;
-  int       max = INF;
-  int       *position;
-  int       *position_j;
-  int       maxPenalty[4];
-  int       **DJ;
+  int           i, j;
+  int           bopen       = b_b;
+  int           bext        = b_a;
+  int           iopen       = il_b;
+  int           iext_s      = 2 * il_a;
+  int           iext_ass    = 50 + il_a;
+  int           min_colonne = INF;
+  int           i_length;
+  int           max_pos;
+  int           max_pos_j;
+  int           min_j_colonne;
+  int           max = INF;
+  int           *position;
+  int           *position_j;
+  int           maxPenalty[4];
+  int           **DJ;
   /**
   *** 1D array corresponding to the standard 2d recursion matrix
   *** Makes the computation 20% faster
   **/
-  int       *SA;
-  vrna_md_t md;
+  int           *SA;
 
   /**
   *** variable initialization
   **/
-  n1  = (int)strlen(s1);
-  n2  = (int)strlen(s2);
+
+  P     = ctx->P;
+  pair  = ctx->pair;
+  rtype = ctx->rtype;
+
+  n1  = ctx->n1 = (int)strlen(s1);
+  n2  = ctx->n2 = (int)strlen(s2);
   /**
   *** Sequence encoding
   **/
 
-  set_model_details(&md);
-
-  if ((!P) || (fabs(P->temperature - temperature) > 1e-6)) {
-    update_dfold_params();
-    if (P)
-      free(P);
-
-    P = vrna_params(&md);
-    make_pair_matrix();
-  }
-
-  encode_seqs(s1, s2);
+  encode_seqs(ctx, s1, s2);
+  S1  = ctx->S1;
+  SS1 = ctx->SS1;
+  S2  = ctx->S2;
+  SS2 = ctx->SS2;
   /**
   *** Position of the high score on the target and query sequence
   **/
@@ -2307,7 +2383,8 @@ Lduplexfold_XS(const char *s1,
   free(SS2);
   free(SA);
   if (max < threshold) {
-    find_max_XS(position,
+    find_max_XS(ctx,
+                position,
                 position_j,
                 delta,
                 threshold,
@@ -2324,7 +2401,8 @@ Lduplexfold_XS(const char *s1,
   }
 
   if (max < INF) {
-    plot_max_XS(max,
+    plot_max_XS(ctx,
+                max,
                 max_pos,
                 max_pos_j,
                 alignment_length,
@@ -2344,27 +2422,31 @@ Lduplexfold_XS(const char *s1,
   free(DJ);
   free(position);
   free(position_j);
-  return NULL;
 }
 
 
 PRIVATE void
-find_max_XS(const int   *position,
-            const int   *position_j,
-            const int   delta,
-            const int   threshold,
-            const int   alignment_length,
-            const char  *s1,
-            const char  *s2,
-            const int   **access_s1,
-            const int   **access_s2,
-            const int   fast,
-            const int   il_a,
-            const int   il_b,
-            const int   b_a,
-            const int   b_b)
+find_max_XS(vrna_plex_context_t ctx,
+            const int           *position,
+            const int           *position_j,
+            const int           delta,
+            const int           threshold,
+            const int           alignment_length,
+            const char          *s1,
+            const char          *s2,
+            const int           **access_s1,
+            const int           **access_s2,
+            const int           fast,
+            const int           il_a,
+            const int           il_b,
+            const int           b_a,
+            const int           b_b)
 {
-  int pos = n1 - 9;
+  int n1, n2, pos;
+
+  n1  = ctx->n1;
+  n2  = ctx->n2;
+  pos = n1 - 9;
 
   if (fast == 1) {
     while (10 < pos--) {
@@ -2381,10 +2463,10 @@ find_max_XS(const int   *position,
         max_pos_j = position_j[pos + delta];
         int max;
         max = position[pos + delta];
-        printf("target upper bound %d: query lower bound %d  (%5.2f) \n",
-               pos - 10,
-               max_pos_j - 10,
-               ((double)max) / 100);
+        plex_printf(ctx, "target upper bound %d: query lower bound %d  (%5.2f) \n",
+                    pos - 10,
+                    max_pos_j - 10,
+                    ((double)max) / 100);
         pos = MAX2(10, pos + temp_min - delta);
       }
     }
@@ -2424,7 +2506,8 @@ find_max_XS(const int   *position,
         s3[end_t - begin_t + 1 + 20]  = '\0';
         s4[end_q - begin_q + 1 + 20]  = '\0';
         duplexT test;
-        test = fduplexfold_XS(s3,
+        test = fduplexfold_XS(ctx,
+                              s3,
                               s4,
                               access_s1,
                               access_s2,
@@ -2437,7 +2520,7 @@ find_max_XS(const int   *position,
                               b_b);
         if (test.energy * 100 < threshold) {
           int l1 = strchr(test.structure, '&') - test.structure;
-          printf(
+          plex_printf(ctx,
             " %s %3d,%-3d : %3d,%-3d (%5.2f = %5.2f + %5.2f + %5.2f) [%5.2f] i:%d,j:%d <%5.2f>\n",
             test.structure,
             begin_t - 10 + test.i - l1 - 10,
@@ -2490,21 +2573,21 @@ find_max_XS(const int   *position,
         s4[end_q - begin_q + 1] = '\0';
         duplexT test;
         test =
-          duplexfold_XS(s3, s4, access_s1, access_s2, pos, max_pos_j, threshold, i_flag, j_flag);
+          duplexfold_XS(ctx, s3, s4, access_s1, access_s2, pos, max_pos_j, threshold, i_flag, j_flag);
         if (test.energy * 100 < threshold) {
-          printf("%s %3d,%-3d : %3d,%-3d (%5.2f = %5.2f + %5.2f + %5.2f) i:%d,j:%d <%5.2f>\n",
-                 test.structure,
-                 test.tb,
-                 test.te,
-                 test.qb,
-                 test.qe,
-                 test.ddG,
-                 test.energy,
-                 test.dG1,
-                 test.dG2,
-                 pos - 10,
-                 max_pos_j - 10,
-                 ((double)position[pos + delta]) / 100);
+          plex_printf(ctx, "%s %3d,%-3d : %3d,%-3d (%5.2f = %5.2f + %5.2f + %5.2f) i:%d,j:%d <%5.2f>\n",
+                      test.structure,
+                      test.tb,
+                      test.te,
+                      test.qb,
+                      test.qe,
+                      test.ddG,
+                      test.energy,
+                      test.dG1,
+                      test.dG2,
+                      pos - 10,
+                      max_pos_j - 10,
+                      ((double)position[pos + delta]) / 100);
           pos = MAX2(10, pos + temp_min - delta);
         }
 
@@ -2541,23 +2624,29 @@ compare(const void  *sub1,
 #endif
 
 PRIVATE void
-plot_max_XS(const int   max,
-            const int   max_pos,
-            const int   max_pos_j,
-            const int   alignment_length,
-            const char  *s1,
-            const char  *s2,
-            const int   **access_s1,
-            const int   **access_s2,
-            const int   fast,
-            const int   il_a,
-            const int   il_b,
-            const int   b_a,
-            const int   b_b)
+plot_max_XS(vrna_plex_context_t ctx,
+            const int           max,
+            const int           max_pos,
+            const int           max_pos_j,
+            const int           alignment_length,
+            const char          *s1,
+            const char          *s2,
+            const int           **access_s1,
+            const int           **access_s2,
+            const int           fast,
+            const int           il_a,
+            const int           il_b,
+            const int           b_a,
+            const int           b_b)
 {
+  int n1, n2;
+
+  n1 = ctx->n1;
+  n2 = ctx->n2;
+
   if (fast == 1) {
-    printf("target upper bound %d: query lower bound %d (%5.2f)\n", max_pos - 3, max_pos_j,
-           ((double)max) / 100);
+    plex_printf(ctx, "target upper bound %d: query lower bound %d (%5.2f)\n", max_pos - 3, max_pos_j,
+                ((double)max) / 100);
   } else if (fast == 2) {
     int   alignment_length2;
     alignment_length2 = MIN2(n1, n2);
@@ -2576,22 +2665,22 @@ plot_max_XS(const int   max,
     s3[end_t - begin_t + 1 + 20]  = '\0';
     s4[end_q - begin_q + 1 + 20]  = '\0';
     duplexT test;
-    test = fduplexfold_XS(s3, s4, access_s1, access_s2, end_t, begin_q, INF, il_a, il_b, b_a, b_b);
+    test = fduplexfold_XS(ctx, s3, s4, access_s1, access_s2, end_t, begin_q, INF, il_a, il_b, b_a, b_b);
     int     l1 = strchr(test.structure, '&') - test.structure;
-    printf("%s %3d,%-3d : %3d,%-3d (%5.2f = %5.2f + %5.2f + %5.2f) [%5.2f] i:%d,j:%d <%5.2f>\n",
-           test.structure,
-           begin_t - 10 + test.i - l1 - 10,
-           begin_t - 10 + test.i - 1 - 10,
-           begin_q - 10 + test.j - 1 - 10,
-           (begin_q - 11) + test.j + (int)strlen(test.structure) - l1 - 2 - 10,
-           test.ddG,
-           test.energy,
-           test.opening_backtrack_x,
-           test.opening_backtrack_y,
-           test.energy_backtrack,
-           max_pos - 10,
-           max_pos_j - 10,
-           (double)max / 100);
+    plex_printf(ctx, "%s %3d,%-3d : %3d,%-3d (%5.2f = %5.2f + %5.2f + %5.2f) [%5.2f] i:%d,j:%d <%5.2f>\n",
+                test.structure,
+                begin_t - 10 + test.i - l1 - 10,
+                begin_t - 10 + test.i - 1 - 10,
+                begin_q - 10 + test.j - 1 - 10,
+                (begin_q - 11) + test.j + (int)strlen(test.structure) - l1 - 2 - 10,
+                test.ddG,
+                test.energy,
+                test.opening_backtrack_x,
+                test.opening_backtrack_y,
+                test.energy_backtrack,
+                max_pos - 10,
+                max_pos_j - 10,
+                (double)max / 100);
 
     free(s3);
     free(s4);
@@ -2613,20 +2702,20 @@ plot_max_XS(const int   max,
     s3[end_t - begin_t + 1] = '\0';                       /*  */
     s4[end_q - begin_q + 1] = '\0';
     duplexT test;
-    test = duplexfold_XS(s3, s4, access_s1, access_s2, max_pos, max_pos_j, INF, i_flag, j_flag);
-    printf("%s %3d,%-3d : %3d,%-3d (%5.2f = %5.2f + %5.2f + %5.2f) i:%d,j:%d <%5.2f>\n",
-           test.structure,
-           test.tb,
-           test.te,
-           test.qb,
-           test.qe,
-           test.ddG,
-           test.energy,
-           test.dG1,
-           test.dG2,
-           max_pos - 10,
-           max_pos_j - 10,
-           (double)max / 100);
+    test = duplexfold_XS(ctx, s3, s4, access_s1, access_s2, max_pos, max_pos_j, INF, i_flag, j_flag);
+    plex_printf(ctx, "%s %3d,%-3d : %3d,%-3d (%5.2f = %5.2f + %5.2f + %5.2f) i:%d,j:%d <%5.2f>\n",
+                test.structure,
+                test.tb,
+                test.te,
+                test.qb,
+                test.qe,
+                test.ddG,
+                test.energy,
+                test.dG1,
+                test.dG2,
+                max_pos - 10,
+                max_pos_j - 10,
+                (double)max / 100);
     free(s3);
     free(s4);
     free(test.structure);
@@ -2638,32 +2727,33 @@ plot_max_XS(const int   max,
 
 
 PRIVATE duplexT
-duplexfold(const char *s1,
-           const char *s2,
-           const int  extension_cost)
+duplexfold(vrna_plex_context_t ctx,
+           const char          *s1,
+           const char          *s2,
+           const int           extension_cost)
 {
-  int       i, j, l1, Emin = INF, i_min = 0, j_min = 0;
-  char      *struc;
-  duplexT   mfe;
-  vrna_md_t md;
-
-  n3  = (int)strlen(s1);
-  n4  = (int)strlen(s2);
+  vrna_param_t  *P;
+  int           **c, (*pair)[MAXALPHA + 1], *rtype, n3, n4;
+  short         *S1, *SS1, *S2, *SS2;
+  int           i, j, l1, Emin = INF, i_min = 0, j_min = 0;
+  char          *struc;
+  duplexT       mfe;
 
-  set_model_details(&md);
-  if ((!P) || (fabs(P->temperature - temperature) > 1e-6)) {
-    update_fold_params();
-    if (P)
-      free(P);
+  P     = ctx->P;
+  pair  = ctx->pair;
+  rtype = ctx->rtype;
 
-    P = vrna_params(&md);
-    make_pair_matrix();
-  }
+  n3  = ctx->n3 = (int)strlen(s1);
+  n4  = ctx->n4 = (int)strlen(s2);
 
-  c = (int **)vrna_alloc(sizeof(int *) * (n3 + 1));
+  c = ctx->c = (int **)vrna_alloc(sizeof(int *) * (n3 + 1));
   for (i = 0; i <= n3; i++)
     c[i] = (int *)vrna_alloc(sizeof(int) * (n4 + 1));
-  encode_seqs(s1, s2);
+  encode_seqs(ctx, s1, s2);
+  S1  = ctx->S1;
+  SS1 = ctx->SS1;
+  S2  = ctx->S2;
+  SS2 = ctx->SS2;
   for (i = 1; i <= n3; i++) {
     for (j = n4; j > 0; j--) {
       int type, type2, E, k, l;
@@ -2708,7 +2798,7 @@ duplexfold(const char *s1,
       }
     }
   }
-  struc = backtrack(i_min, j_min, extension_cost);
+  struc = backtrack(ctx, i_min, j_min, extension_cost);
   if (i_min < n3)
     i_min++;
 
@@ -2735,14 +2825,29 @@ duplexfold(const char *s1,
 
 
 PRIVATE char *
-backtrack(int       i,
-          int       j,
-          const int extension_cost)
+backtrack(vrna_plex_context_t ctx,
+          int                 i,
+          int                 j,
+          const int           extension_cost)
 {
+  vrna_param_t  *P;
+  int           **c, (*pair)[MAXALPHA + 1], *rtype, n3, n4;
+  short         *S1, *SS1, *S2, *SS2;
   /* backtrack structure going backwards from i, and forwards from j
    * return structure in bracket notation with & as separator */
-  int   k, l, type, type2, E, traced, i0, j0;
-  char  *st1, *st2, *struc;
+  int           k, l, type, type2, E, traced, i0, j0;
+  char          *st1, *st2, *struc;
+
+  P     = ctx->P;
+  c     = ctx->c;
+  pair  = ctx->pair;
+  rtype = ctx->rtype;
+  S1    = ctx->S1;
+  SS1   = ctx->SS1;
+  S2    = ctx->S2;
+  SS2   = ctx->SS2;
+  n3    = ctx->n3;
+  n4    = ctx->n4;
 
   st1 = (char *)vrna_alloc(sizeof(char) * (n3 + 1));
   st2 = (char *)vrna_alloc(sizeof(char) * (n4 + 1));
@@ -2821,58 +2926,55 @@ backtrack(int       i,
 
 
 PRIVATE duplexT
-fduplexfold(const char  *s1,
-            const char  *s2,
-            const int   extension_cost,
-            const int   il_a,
-            const int   il_b,
-            const int   b_a,
-            const int   b_b)
+fduplexfold(vrna_plex_context_t ctx,
+            const char          *s1,
+            const char          *s2,
+            const int           extension_cost,
+            const int           il_a,
+            const int           il_b,
+            const int           b_a,
+            const int           b_b)
 {
-  int       i, j, Emin, i_min, j_min, l1;
-  duplexT   mfe;
-  char      *struc;
-  int       bopen       = b_b;
-  int       bext        = b_a + extension_cost;
-  int       iopen       = il_b;
-  int       iext_s      = 2 * (il_a + extension_cost);  /* iext_s 2 nt nucleotide extension of interior loop, on i and j side */
-  int       iext_ass    = 50 + il_a + extension_cost;   /* iext_ass assymetric extension of interior loop, either on i or on j side. */
-  int       min_colonne = INF;                          /* enthaelt das maximum einer kolonne */
-  int       i_length;
-  int       max_pos;                                    /* get position of the best hit */
-  int       max_pos_j;
-  int       temp = INF;
-  int       min_j_colonne;
-  int       max = INF;
-  vrna_md_t md;
+  vrna_param_t  *P;
+  int           **c, **in, **bx, **by, **inx, **iny, (*pair)[MAXALPHA + 1], *rtype, n3, n4;
+  short         *S1, *SS1, *S2, *SS2;
+  int           i, j, Emin, i_min, j_min, l1;
+  duplexT       mfe;
+  char          *struc;
+  int           bopen       = b_b;
+  int           bext        = b_a + extension_cost;
+  int           iopen       = il_b;
+  int           iext_s      = 2 * (il_a + extension_cost);  /* iext_s 2 nt nucleotide extension of interior loop, on i and j side */
+  int           iext_ass    = 50 + il_a + extension_cost;   /* iext_ass assymetric extension of interior loop, either on i or on j side. */
+  int           min_colonne = INF;                          /* enthaelt das maximum einer kolonne */
+  int           i_length;
+  int           max_pos;                                    /* get position of the best hit */
+  int           max_pos_j;
+  int           temp = INF;
+  int           min_j_colonne;
+  int           max = INF;
 
   /* FOLLOWING NEXT 4 LINE DEFINES AN ARRAY CONTAINING POSITION OF THE SUBOPT IN S1 */
 
-  n3  = (int)strlen(s1);
-  n4  = (int)strlen(s2);
+  P     = ctx->P;
+  pair  = ctx->pair;
+  rtype = ctx->rtype;
+
+  n3  = ctx->n3 = (int)strlen(s1);
+  n4  = ctx->n4 = (int)strlen(s2);
   /* delta_check is the minimal distance allowed for two hits to be accepted */
   /* if both hits are closer, reject the smaller ( in term of position)  hits  */
   /* i want to implement a function that, given a position in a long sequence and a small sequence, */
   /* duplexfold them at this position and report the result at the command line */
   /* for this i first need to rewrite backtrack in order to remove the printf functio */
   /* END OF DEFINITION FOR NEEDED SUBOPT DATA  */
-  set_model_details(&md);
-  if ((!P) || (fabs(P->temperature - temperature) > 1e-6)) {
-    update_fold_params();
-    if (P)
-      free(P);
-
-    P = vrna_params(&md);
-    make_pair_matrix();
-  }
-
   /*local c array initialization---------------------------------------------*/
-  c   = (int **)vrna_alloc(sizeof(int *) * (n3 + 1));
-  in  = (int **)vrna_alloc(sizeof(int *) * (n3 + 1));
-  bx  = (int **)vrna_alloc(sizeof(int *) * (n3 + 1));
-  by  = (int **)vrna_alloc(sizeof(int *) * (n3 + 1));
-  inx = (int **)vrna_alloc(sizeof(int *) * (n3 + 1));
-  iny = (int **)vrna_alloc(sizeof(int *) * (n3 + 1));
+  c   = ctx->c = (int **)vrna_alloc(sizeof(int *) * (n3 + 1));
+  in  = ctx->in = (int **)vrna_alloc(sizeof(int *) * (n3 + 1));
+  bx  = ctx->bx = (int **)vrna_alloc(sizeof(int *) * (n3 + 1));
+  by  = ctx->by = (int **)vrna_alloc(sizeof(int *) * (n3 + 1));
+  inx = ctx->inx = (int **)vrna_alloc(sizeof(int *) * (n3 + 1));
+  iny = ctx->iny = (int **)vrna_alloc(sizeof(int *) * (n3 + 1));
   for (i = 0; i <= n3; i++) {
     c[i]    = (int *)vrna_alloc(sizeof(int) * (n4 + 1));
     in[i]   = (int *)vrna_alloc(sizeof(int) * (n4 + 1));
@@ -2884,7 +2986,11 @@ fduplexfold(const char  *s1,
   /*-------------------------------------------------------------------------*/
   /*end of array initialisation----------------------------------*/
   /*maybe int *** would be better*/
-  encode_seqs(s1, s2);
+  encode_seqs(ctx, s1, s2);
+  S1  = ctx->S1;
+  SS1 = ctx->SS1;
+  S2  = ctx->S2;
+  SS2 = ctx->SS2;
   /* ------------------------------------------matrix initialisierung */
   for (i = 0; i < n3; i++) {
     for (j = 0; j < n4; j++) {
@@ -3088,7 +3194,7 @@ fduplexfold(const char  *s1,
   j_min = max_pos_j;
   int dGe;
   dGe   = 0;
-  struc = fbacktrack(i_min, j_min, extension_cost, il_a, il_b, b_a, b_b, &dGe);
+  struc = fbacktrack(ctx, i_min, j_min, extension_cost, il_a, il_b, b_a, b_b, &dGe);
   if (i_min < n3 - 10)
     i_min++;
 
@@ -3127,24 +3233,44 @@ fduplexfold(const char  *s1,
 
 
 PRIVATE char *
-fbacktrack(int        i,
-           int        j,
-           const int  extension_cost,
-           const int  il_a,
-           const int  il_b,
-           const int  b_a,
-           const int  b_b,
-           int        *dG)
+fbacktrack(vrna_plex_context_t ctx,
+           int                 i,
+           int                 j,
+           const int           extension_cost,
+           const int           il_a,
+           const int           il_b,
+           const int           b_a,
+           const int           b_b,
+           int                 *dG)
 {
+  vrna_param_t  *P;
+  int           **c, **in, **bx, **by, **inx, **iny, (*pair)[MAXALPHA + 1], *rtype, n3, n4;
+  short         *S1, *SS1, *S2, *SS2;
   /* backtrack structure going backwards from i, and forwards from j
    * return structure in bracket notation with & as separator */
-  int   k, l, type, type2, E, traced, i0, j0;
-  char  *st1, *st2, *struc;
-  int   bopen     = b_b;
-  int   bext      = b_a + extension_cost;
-  int   iopen     = il_b;
-  int   iext_s    = 2 * (il_a + extension_cost);  /* iext_s 2 nt nucleotide extension of interior loop, on i and j side */
-  int   iext_ass  = 50 + il_a + extension_cost;   /* iext_ass assymetric extension of interior loop, either on i or on j side. */
+  int           k, l, type, type2, E, traced, i0, j0;
+  char          *st1, *st2, *struc;
+  int           bopen     = b_b;
+  int           bext      = b_a + extension_cost;
+  int           iopen     = il_b;
+  int           iext_s    = 2 * (il_a + extension_cost);  /* iext_s 2 nt nucleotide extension of interior loop, on i and j side */
+  int           iext_ass  = 50 + il_a + extension_cost;   /* iext_ass assymetric extension of interior loop, either on i or on j side. */
+
+  P     = ctx->P;
+  c     = ctx->c;
+  in    = ctx->in;
+  bx    = ctx->bx;
+  by    = ctx->by;
+  inx   = ctx->inx;
+  iny   = ctx->iny;
+  pair  = ctx->pair;
+  rtype = ctx->rtype;
+  S1    = ctx->S1;
+  SS1   = ctx->SS1;
+  S2    = ctx->S2;
+  SS2   = ctx->SS2;
+  n3    = ctx->n3;
+  n4    = ctx->n4;
 
   st1 = (char *)vrna_alloc(sizeof(char) * (n3 + 1));
   st2 = (char *)vrna_alloc(sizeof(char) * (n4 + 1));
@@ -3730,63 +3856,65 @@ fbacktrack(int        i,
 }
 
 
-duplexT **
-Lduplexfold(const char  *s1,
-            const char  *s2,
-            const int   threshold,
-            const int   extension_cost,
-            const int   alignment_length,
-            const int   delta,
-            const int   fast,
-            const int   il_a,
-            const int   il_b,
-            const int   b_a,
-            const int   b_b)
+PRIVATE void
+plex_scan(vrna_plex_context_t ctx,
+          const char          *s1,
+          const char          *s2,
+          const int           threshold,
+          const int           extension_cost,
+          const int           alignment_length,
+          const int           delta,
+          const int           fast,
+          const int           il_a,
+          const int           il_b,
+          const int           b_a,
+          const int           b_b)
 {
+  vrna_param_t  *P;
+  int           (*pair)[MAXALPHA + 1], *rtype, n1, n2;
+  short         *S1, *SS1, *S2, *SS2;
   /**
   *** See variable definition in fduplexfold_XS
   **/
-  int       i, j;
-  int       bopen       = b_b;
-  int       bext        = b_a + extension_cost;
-  int       iopen       = il_b;
-  int       iext_s      = 2 * (il_a + extension_cost);  /* iext_s 2 nt nucleotide extension of interior loop, on i and j side */
-  int       iext_ass    = 50 + il_a + extension_cost;   /* iext_ass assymetric extension of interior loop, either on i or on j side. */
-  int       min_colonne = INF;                          /* enthaelt das maximum einer kolonne */
-  int       i_length;
-  int       max_pos;                                    /* get position of the best hit */
-  int       max_pos_j;
-  int       temp = INF;
-  int       min_j_colonne;
-  int       max = INF;
-  int       *position; /* contains the position of the hits with energy > E */
-  int       *position_j;
+  int           i, j;
+  int           bopen       = b_b;
+  int           bext        = b_a + extension_cost;
+  int           iopen       = il_b;
+  int           iext_s      = 2 * (il_a + extension_cost);  /* iext_s 2 nt nucleotide extension of interior loop, on i and j side */
+  int           iext_ass    = 50 + il_a + extension_cost;   /* iext_ass assymetric extension of interior loop, either on i or on j side. */
+  int           min_colonne = INF;                          /* enthaelt das maximum einer kolonne */
+  int           i_length;
+  int           max_pos;                                    /* get position of the best hit */
+  int           max_pos_j;
+  int           temp = INF;
+  int           min_j_colonne;
+  int           max = INF;
+  int           *position; /* contains the position of the hits with energy > E */
+  int           *position_j;
   /**
   *** 1D array corresponding to the standard 2d recursion matrix
   *** Makes the computation 20% faster
   **/
-  int       *SA;
-  vrna_md_t md;
+  int           *SA;
 
   /**
   *** variable initialization
   **/
-  n1  = (int)strlen(s1);
-  n2  = (int)strlen(s2);
+
+  P     = ctx->P;
+  pair  = ctx->pair;
+  rtype = ctx->rtype;
+
+  n1  = ctx->n1 = (int)strlen(s1);
+  n2  = ctx->n2 = (int)strlen(s2);
   /**
   *** Sequence encoding
   **/
-  set_model_details(&md);
-  if ((!P) || (fabs(P->temperature - temperature) > 1e-6)) {
-    update_fold_params();
-    if (P)
-      free(P);
-
-    P = vrna_params(&md);
-    make_pair_matrix();
-  }
-
-  encode_seqs(s1, s2);
+  encode_seqs(ctx, s1, s2);
+  S1  = ctx->S1;
+  SS1 = ctx->SS1;
+  S2  = ctx->S2;
+  SS2 = ctx->SS2;
   /**
   *** Position of the high score on the target and query sequence
   **/
@@ -4067,7 +4195,8 @@ Lduplexfold(const char  *s1,
   free(SS1);
   free(SS2);
   if (max < threshold) {
-    find_max(position,
+    find_max(ctx,
+             position,
              position_j,
              delta,
              threshold,
@@ -4083,7 +4212,8 @@ Lduplexfold(const char  *s1,
   }
 
   if (max < INF) {
-    plot_max(max,
+    plot_max(ctx,
+             max,
              max_pos,
              max_pos_j,
              alignment_length,
@@ -4100,26 +4230,30 @@ Lduplexfold(const char  *s1,
   free(SA);
   free(position);
   free(position_j);
-  return NULL;
 }
 
 
 PRIVATE void
-find_max(const int  *position,
-         const int  *position_j,
-         const int  delta,
-         const int  threshold,
-         const int  alignment_length,
-         const char *s1,
-         const char *s2,
-         const int  extension_cost,
-         const int  fast,
-         const int  il_a,
-         const int  il_b,
-         const int  b_a,
-         const int  b_b)
+find_max(vrna_plex_context_t ctx,
+         const int           *position,
+         const int           *position_j,
+         const int           delta,
+         const int           threshold,
+         const int           alignment_length,
+         const char          *s1,
+         const char          *s2,
+         const int           extension_cost,
+         const int           fast,
+         const int           il_a,
+         const int           il_b,
+         const int           b_a,
+         const int           b_b)
 {
-  int pos = n1 - 9;
+  int n1, n2, pos;
+
+  n1  = ctx->n1;
+  n2  = ctx->n2;
+  pos = n1 - 9;
 
   if (fast == 1) {
     while (10 < pos--) {
@@ -4136,10 +4270,10 @@ find_max(const int  *position,
         max_pos_j = position_j[pos + delta];
         int max;
         max = position[pos + delta];
-        printf("target upper bound %d: query lower bound %d  (%5.2f) \n",
-               pos - 10,
-               max_pos_j - 10,
-               ((double)max) / 100);
+        plex_printf(ctx, "target upper bound %d: query lower bound %d  (%5.2f) \n",
+                    pos - 10,
+                    max_pos_j - 10,
+                    ((double)max) / 100);
         pos = MAX2(10, pos + temp_min - delta);
       }
     }
@@ -4179,16 +4313,16 @@ find_max(const int  *position,
         s3[end_t - begin_t + 1 + 20]  = '\0';
         s4[end_q - begin_q + 1 + 20]  = '\0';
         duplexT test;
-        test = fduplexfold(s3, s4, extension_cost, il_a, il_b, b_a, b_b);
+        test = fduplexfold(ctx, s3, s4, extension_cost, il_a, il_b, b_a, b_b);
         if (test.energy * 100 < threshold) {
           int l1 = strchr(test.structure, '&') - test.structure;
-          printf("%s %3d,%-3d : %3d,%-3d (%5.2f) [%5.2f]  i:%d,j:%d <%5.2f>\n", test.structure,
-                 begin_t - 10 + test.i - l1 - 10,
-                 begin_t - 10 + test.i - 1 - 10,
-                 begin_q - 10 + test.j - 1 - 10,
-                 (begin_q - 11) + test.j + (int)strlen(test.structure) - l1 - 2 - 10,
-                 test.energy, test.energy_backtrack, pos - 10, max_pos_j - 10,
-                 ((double)position[pos + delta]) / 100);
+          plex_printf(ctx, "%s %3d,%-3d : %3d,%-3d (%5.2f) [%5.2f]  i:%d,j:%d <%5.2f>\n", test.structure,
+                      begin_t - 10 + test.i - l1 - 10,
+                      begin_t - 10 + test.i - 1 - 10,
+                      begin_q - 10 + test.j - 1 - 10,
+                      (begin_q - 11) + test.j + (int)strlen(test.structure) - l1 - 2 - 10,
+                      test.energy, test.energy_backtrack, pos - 10, max_pos_j - 10,
+                      ((double)position[pos + delta]) / 100);
           pos = MAX2(10, pos + temp_min - delta);
         }
 
@@ -4242,7 +4376,7 @@ find_max(const int  *position,
         s3[end_t - begin_t + 1 + 20]  = '\0';
         s4[end_q - begin_q + 1 + 20]  = '\0';
         duplexT test;
-        test = fduplexfold(s4, s3, extension_cost, il_a, il_b, b_a, b_b);
+        test = fduplexfold(ctx, s4, s3, extension_cost, il_a, il_b, b_a, b_b);
         if (test.energy * 100 < threshold) {
           int   structureLength = strlen(test.structure);
           int   l1 = strchr(test.structure, '&') - test.structure;
@@ -4269,17 +4403,17 @@ find_max(const int  *position,
           //          l1=strchr(reverse.structure, '&')-test.structure;
 
 
-          printf("%s %3d,%-3d : %3d,%-3d (%5.2f) [%5.2f] i:%d,j:%d <%5.2f>\n",
-                 reverseStructure,
-                 begin_t - 10 + test.j - 1 - 10,
-                 (begin_t - 11) + test.j + strlen(test.structure) - l1 - 2 - 10,
-                 begin_q - 10 + test.i - l1 - 10,
-                 begin_q - 10 + test.i - 1 - 10,
-                 test.energy,
-                 test.energy_backtrack,
-                 pos,
-                 max_pos_j,
-                 ((double)position[pos + delta]) / 100);
+          plex_printf(ctx, "%s %3d,%-3d : %3d,%-3d (%5.2f) [%5.2f] i:%d,j:%d <%5.2f>\n",
+                      reverseStructure,
+                      begin_t - 10 + test.j - 1 - 10,
+                      (begin_t - 11) + test.j + strlen(test.structure) - l1 - 2 - 10,
+                      begin_q - 10 + test.i - l1 - 10,
+                      begin_q - 10 + test.i - 1 - 10,
+                      test.energy,
+                      test.energy_backtrack,
+                      pos,
+                      max_pos_j,
+                      ((double)position[pos + delta]) / 100);
           pos = MAX2(10, pos + temp_min - delta);
         }
 
@@ -4322,15 +4456,15 @@ find_max(const int  *position,
         s3[end_t - begin_t + 1] = '\0';
         s4[end_q - begin_q + 1] = '\0';
         duplexT test;
-        test = duplexfold(s3, s4, extension_cost);
+        test = duplexfold(ctx, s3, s4, extension_cost);
         if (test.energy * 100 < threshold) {
           int l1 = strchr(test.structure, '&') - test.structure;
-          printf("%s %3d,%-3d : %3d,%-3d (%5.2f)  i:%d,j:%d <%5.2f>\n", test.structure,
-                 begin_t - 10 + test.i - l1,
-                 begin_t - 10 + test.i - 1,
-                 begin_q - 10 + test.j - 1,
-                 (begin_q - 11) + test.j + (int)strlen(test.structure) - l1 - 2,
-                 test.energy, pos - 10, max_pos_j - 10, ((double)position[pos + delta]) / 100);
+          plex_printf(ctx, "%s %3d,%-3d : %3d,%-3d (%5.2f)  i:%d,j:%d <%5.2f>\n", test.structure,
+                      begin_t - 10 + test.i - l1,
+                      begin_t - 10 + test.i - 1,
+                      begin_q - 10 + test.j - 1,
+                      (begin_q - 11) + test.j + (int)strlen(test.structure) - l1 - 2,
+                      test.energy, pos - 10, max_pos_j - 10, ((double)position[pos + delta]) / 100);
           pos = MAX2(10, pos + temp_min - delta);
         }
 
@@ -4344,22 +4478,28 @@ find_max(const int  *position,
 
 
 PRIVATE void
-plot_max(const int  max,
-         const int  max_pos,
-         const int  max_pos_j,
-         const int  alignment_length,
-         const char *s1,
-         const char *s2,
-         const int  extension_cost,
-         const int  fast,
-         const int  il_a,
-         const int  il_b,
-         const int  b_a,
-         const int  b_b)
+plot_max(vrna_plex_context_t ctx,
+         const int           max,
+         const int           max_pos,
+         const int           max_pos_j,
+         const int           alignment_length,
+         const char          *s1,
+         const char          *s2,
+         const int           extension_cost,
+         const int           fast,
+         const int           il_a,
+         const int           il_b,
+         const int           b_a,
+         const int           b_b)
 {
+  int n1, n2;
+
+  n1 = ctx->n1;
+  n2 = ctx->n2;
+
   if (fast == 1) {
-    printf("target upper bound %d: query lower bound %d (%5.2f)\n", max_pos - 10, max_pos_j - 10,
-           ((double)max) / 100);
+    plex_printf(ctx, "target upper bound %d: query lower bound %d (%5.2f)\n", max_pos - 10, max_pos_j - 10,
+                ((double)max) / 100);
   } else if (fast == 2) {
     int   alignment_length2;
     alignment_length2 = MIN2(n1, n2);
@@ -4378,14 +4518,14 @@ plot_max(const int  max,
     s3[end_t - begin_t + 1 + 20]  = '\0';
     s4[end_q - begin_q + 1 + 20]  = '\0';
     duplexT test;
-    test = fduplexfold(s3, s4, extension_cost, il_a, il_b, b_a, b_b);
+    test = fduplexfold(ctx, s3, s4, extension_cost, il_a, il_b, b_a, b_b);
     int     l1 = strchr(test.structure, '&') - test.structure;
-    printf("%s %3d,%-3d : %3d,%-3d (%5.2f) [%5.2f] i:%d,j:%d <%5.2f>\n", test.structure,
-           begin_t - 10 + test.i - l1 - 10,
-           begin_t - 10 + test.i - 1 - 10,
-           begin_q - 10 + test.j - 1 - 10,
-           (begin_q - 11) + test.j + (int)strlen(test.structure) - l1 - 2 - 10,
-           test.energy, test.energy_backtrack, max_pos - 10, max_pos_j - 10, ((double)max) / 100);
+    plex_printf(ctx, "%s %3d,%-3d : %3d,%-3d (%5.2f) [%5.2f] i:%d,j:%d <%5.2f>\n", test.structure,
+                begin_t - 10 + test.i - l1 - 10,
+                begin_t - 10 + test.i - 1 - 10,
+                begin_q - 10 + test.j - 1 - 10,
+                (begin_q - 11) + test.j + (int)strlen(test.structure) - l1 - 2 - 10,
+                test.energy, test.energy_backtrack, max_pos - 10, max_pos_j - 10, ((double)max) / 100);
     free(s3);
     free(s4);
     free(test.structure);
@@ -4403,14 +4543,14 @@ plot_max(const int  max,
     strncpy(s4, (s2 + begin_q - 1), end_q - begin_q + 1);
     s3[end_t - begin_t + 1] = '\0';
     s4[end_q - begin_q + 1] = '\0';
-    test                    = duplexfold(s3, s4, extension_cost);
+    test                    = duplexfold(ctx, s3, s4, extension_cost);
     int l1 = strchr(test.structure, '&') - test.structure;
-    printf("%s %3d,%-3d : %3d,%-3d (%5.2f) i:%d,j:%d <%5.2f>\n", test.structure,
-           begin_t - 10 + test.i - l1,
-           begin_t - 10 + test.i - 1,
-           begin_q - 10 + test.j - 1,
-           (begin_q - 11) + test.j + (int)strlen(test.structure) - l1 - 2,
-           test.energy, max_pos - 10, max_pos_j - 10, ((double)max) / 100);
+    plex_printf(ctx, "%s %3d,%-3d : %3d,%-3d (%5.2f) i:%d,j:%d <%5.2f>\n", test.structure,
+                begin_t - 10 + test.i - l1,
+                begin_t - 10 + test.i - 1,
+                begin_q - 10 + test.j - 1,
+                (begin_q - 11) + test.j + (int)strlen(test.structure) - l1 - 2,
+                test.energy, max_pos - 10, max_pos_j - 10, ((double)max) / 100);
     free(s3);
     free(s4);
     free(test.structure);
@@ -4419,36 +4559,26 @@ plot_max(const int  max,
 
 
 PRIVATE void
-update_dfold_params(void)
-{
-  vrna_md_t md;
-
-  if (P)
-    free(P);
-
-  set_model_details(&md);
-  P = vrna_params(&md);
-  make_pair_matrix();
-}
-
-
-PRIVATE void
-encode_seqs(const char  *s1,
-            const char  *s2)
+encode_seqs(vrna_plex_context_t ctx,
+            const char          *s1,
+            const char          *s2)
 {
+  short        *alias, *S1, *SS1, *S2, *SS2;
   unsigned int i, l;
 
+  alias = ctx->alias;
+
   l   = strlen(s1);
-  S1  = encode_seq(s1);
-  SS1 = (short *)vrna_alloc(sizeof(short) * (l + 1));
+  S1  = ctx->S1 = encode_seq(ctx, s1);
+  SS1 = ctx->SS1 = (short *)vrna_alloc(sizeof(short) * (l + 1));
   /* SS1 exists only for the special X K and I bases and energy_set!=0 */
 
   for (i = 1; i <= l; i++)  /* make numerical encoding of sequence */
     SS1[i] = alias[S1[i]];  /* for mismatches of nostandard bases */
 
   l   = strlen(s2);
-  S2  = encode_seq(s2);
-  SS2 = (short *)vrna_alloc(sizeof(short) * (l + 1));
+  S2  = ctx->S2 = encode_seq(ctx, s2);
+  SS2 = ctx->SS2 = (short *)vrna_alloc(sizeof(short) * (l + 1));
   /* SS2 exists only for the special X K and I bases and energy_set!=0 */
 
   for (i = 1; i <= l; i++)  /* make numerical encoding of sequence */
@@ -4457,7 +4587,8 @@ encode_seqs(const char  *s1,
 
 
 PRIVATE short *
-encode_seq(const char *sequence)
+encode_seq(vrna_plex_context_t ctx,
+           const char          *sequence)
 {
   unsigned int  i, l;
   short         *S;
@@ -4468,7 +4599,7 @@ encode_seq(const char *sequence)
 
   /* make numerical encoding of sequence */
   for (i = 1; i <= l; i++)
-    S[i] = (short)encode_char(toupper(sequence[i - 1]));
+    S[i] = (short)vrna_nucleotide_encode(sequence[i - 1], &(ctx->P->model_details));
 
   /* for circular folding add first base at position n+1 */
   S[l + 1] = S[1];
@@ -4477,6 +4608,211 @@ encode_seq(const char *sequence)
 }
 
 
+PUBLIC vrna_plex_context_t
+vrna_plex_context_init(const vrna_md_t *md_p)
+{
+  vrna_md_t           md;
+  vrna_plex_context_t ctx;
+
+  if (md_p)
+    md = *md_p;
+  else
+    vrna_md_set_default(&md);
+
+  ctx         = (vrna_plex_context_t)vrna_alloc(sizeof(struct vrna_plex_context_s));
+  ctx->P      = vrna_params(&md);
+  ctx->pair   = ctx->P->model_details.pair;
+  ctx->rtype  = &(ctx->P->model_details.rtype[0]);
+  ctx->alias  = &(ctx->P->model_details.alias[0]);
+  ctx->output = NULL;
+
+  return ctx;
+}
+
+
+PUBLIC void
+vrna_plex_context_free(vrna_plex_context_t ctx)
+{
+  if (ctx) {
+    free(ctx->P);
+    free(ctx);
+  }
+}
+
+
+PUBLIC int
+vrna_Lduplexfold(vrna_plex_context_t  ctx,
+                 vrna_cstr_t          output,
+                 const char           *s1,
+                 const char           *s2,
+                 const int            threshold,
+                 const int            extension_cost,
+                 const int            alignment_length,
+                 const int            delta,
+                 const int            fast,
+                 const int            il_a,
+                 const int            il_b,
+                 const int            b_a,
+                 const int            b_b)
+{
+  if ((!ctx) || (!s1) || (!s2))
+    return 0;
+
+  ctx->output = output;
+
+  plex_scan(ctx,
+            s1,
+            s2,
+            threshold,
+            extension_cost,
+            alignment_length,
+            delta,
+            fast,
+            il_a,
+            il_b,
+            b_a,
+            b_b);
+
+  ctx->output = NULL;
+
+  return 1;
+}
+
+
+PUBLIC int
+vrna_Lduplexfold_XS(vrna_plex_context_t ctx,
+                    vrna_cstr_t         output,
+                    const char          *s1,
+                    const char          *s2,
+                    const int           **access_s1,
+                    const int           **access_s2,
+                    const int           threshold,
+                    const int           alignment_length,
+                    const int           delta,
+                    const int           fast,
+                    const int           il_a,
+                    const int           il_b,
+                    const int           b_a,
+                    const int           b_b)
+{
+  if ((!ctx) || (!s1) || (!s2) || (!access_s1) || (!access_s2))
+    return 0;
+
+  ctx->output = output;
+
+  plex_scan_XS(ctx,
+               s1,
+               s2,
+               access_s1,
+               access_s2,
+               threshold,
+               alignment_length,
+               delta,
+               fast,
+               il_a,
+               il_b,
+               b_a,
+               b_b);
+
+  ctx->output = NULL;
+
+  return 1;
+}
+
+
+/*
+ *###########################################
+ *# deprecated functions below              #
+ *###########################################
+ */
+
+#ifndef VRNA_DISABLE_BACKWARD_COMPATIBILITY
+
+PRIVATE vrna_plex_context_t
+get_backward_compat_ctx(void)
+{
+  vrna_md_t md;
+
+  set_model_details(&md);
+
+  if ((!backward_compat_ctx) ||
+      (memcmp(&md, &backward_compat_md, sizeof(vrna_md_t)))) {
+    vrna_plex_context_free(backward_compat_ctx);
+    backward_compat_ctx = vrna_plex_context_init(&md);
+    memcpy(&backward_compat_md, &md, sizeof(vrna_md_t));
+  }
+
+  return backward_compat_ctx;
+}
+
+
+PUBLIC duplexT **
+Lduplexfold(const char  *s1,
+            const char  *s2,
+            const int   threshold,
+            const int   extension_cost,
+            const int   alignment_length,
+            const int   delta,
+            const int   fast,
+            const int   il_a,
+            const int   il_b,
+            const int   b_a,
+            const int   b_b)
+{
+  vrna_Lduplexfold(get_backward_compat_ctx(),
+                   NULL,
+                   s1,
+                   s2,
+                   threshold,
+                   extension_cost,
+                   alignment_length,
+                   delta,
+                   fast,
+                   il_a,
+                   il_b,
+                   b_a,
+                   b_b);
+
+  return NULL;
+}
+
+
+PUBLIC duplexT **
+Lduplexfold_XS(const char *s1,
+               const char *s2,
+               const int  **access_s1,
+               const int  **access_s2,
+               const int  threshold,
+               const int  alignment_length,
+               const int  delta,
+               const int  fast,
+               const int  il_a,
+               const int  il_b,
+               const int  b_a,
+               const int  b_b)
+{
+  vrna_Lduplexfold_XS(get_backward_compat_ctx(),
+                      NULL,
+                      s1,
+                      s2,
+                      access_s1,
+                      access_s2,
+                      threshold,
+                      alignment_length,
+                      delta,
+                      fast,
+                      il_a,
+                      il_b,
+                      b_a,
+                      b_b);
+
+  return NULL;
+}
+
+
+#endif
+
+
 int
 arraySize(duplexT **array)
 {
@@ -2,6 +2,123 @@
 #define VIENNA_RNA_PACKAGE_PLEX_H
 
 #include <ViennaRNA/datastructures/basic.h>
+#include <ViennaRNA/datastructures/char_stream.h>
+#include <ViennaRNA/model.h>
+
+/**
+ *  @file     plex.h
+ *  @ingroup  cofold
+ *  @brief    Fast scanning for RNA-RNA interactions between a long target and a short query
+ */
+
+
+/**
+ *  @brief  A reentrant context for RNAplex interaction scans
+ *
+ *  The context holds the energy parameters and the dynamic programming
+ *  matrices of an interaction scan. Different contexts may be used
+ *  concurrently from different threads, while a single context must
+ *  not be shared between threads at the same time.
+ *
+ *  @see  vrna_plex_context_init(), vrna_plex_context_free(),
+ *        vrna_Lduplexfold(), vrna_Lduplexfold_XS()
+ */
+typedef struct vrna_plex_context_s *vrna_plex_context_t;
+
+
+/**
+ *  @brief  Create a new RNAplex interaction scan context
+ *
+ *  @param  md  The model details to use, or NULL to use default settings
+ *  @return     A new interaction scan context
+ */
+vrna_plex_context_t
+vrna_plex_context_init(const vrna_md_t *md);
+
+
+/**
+ *  @brief  Release all memory occupied by an RNAplex interaction scan context
+ *
+ *  @param  ctx The interaction scan context to free
+ */
+void
+vrna_plex_context_free(vrna_plex_context_t ctx);
+
+
+/**
+ *  @brief  Scan a target sequence for high scoring duplexes with a query sequence
+ *
+ *  All hits are written to @p output in the order they are found. If @p output
+ *  is NULL, the hits are printed to @p stdout directly.
+ *
+ *  @param  ctx               The interaction scan context
+ *  @param  output            The output buffer (may be NULL)
+ *  @param  s1                The target sequence
+ *  @param  s2                The query sequence
+ *  @param  threshold         The energy threshold for reported hits
+ *  @param  extension_cost    The extension cost of the duplex
+ *  @param  alignment_length  The maximum length of an interaction
+ *  @param  delta             The minimal distance between two reported hits
+ *  @param  fast              Report hits without backtracking the full structure
+ *  @param  il_a              Interior loop extension penalty
+ *  @param  il_b              Interior loop opening penalty
+ *  @param  b_a               Bulge loop extension penalty
+ *  @param  b_b               Bulge loop opening penalty
+ *  @return                   1 on success, 0 otherwise
+ */
+int
+vrna_Lduplexfold(vrna_plex_context_t  ctx,
+                 vrna_cstr_t          output,
+                 const char           *s1,
+                 const char           *s2,
+                 const int            threshold,
+                 const int            extension_cost,
+                 const int            alignment_length,
+                 const int            delta,
+                 const int            fast,
+                 const int            il_a,
+                 const int            il_b,
+                 const int            b_a,
+                 const int            b_b);
+
+
+/**
+ *  @brief  Scan a target sequence for high scoring duplexes with a query sequence taking accessibilities into account
+ *
+ *  @see  vrna_Lduplexfold()
+ *
+ *  @param  ctx               The interaction scan context
+ *  @param  output            The output buffer (may be NULL)
+ *  @param  s1                The target sequence
+ *  @param  s2                The query sequence
+ *  @param  access_s1         The opening energies of the target sequence
+ *  @param  access_s2         The opening energies of the query sequence
+ *  @param  threshold         The energy threshold for reported hits
+ *  @param  alignment_length  The maximum length of an interaction
+ *  @param  delta             The minimal distance between two reported hits
+ *  @param  fast              Report hits without backtracking the full structure
+ *  @param  il_a              Interior loop extension penalty
+ *  @param  il_b              Interior loop opening penalty
+ *  @param  b_a               Bulge loop extension penalty
+ *  @param  b_b               Bulge loop opening penalty
+ *  @return                   1 on success, 0 otherwise
+ */
+int
+vrna_Lduplexfold_XS(vrna_plex_context_t ctx,
+                    vrna_cstr_t         output,
+                    const char          *s1,
+                    const char          *s2,
+                    const int           **access_s1,
+                    const int           **access_s2,
+                    const int           threshold,
+                    const int           alignment_length,
+                    const int           delta,
+                    const int           fast,
+                    const int           il_a,
+                    const int           il_b,
+                    const int           b_a,
+                    const int           b_b);
+
 
 #ifndef VRNA_DISABLE_BACKWARD_COMPATIBILITY
 
@@ -30,8 +147,8 @@ duplexT** Lduplexfold_XS( const char*s1,
                           const int **access_s1,
                           const int **access_s2,
                           const int threshold,
-                          const int delta,
                           const int alignment_length,
+                          const int delta,
                           const int fast,
                           const int il_a,
                           const int il_b,
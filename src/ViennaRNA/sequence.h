@@ -18,6 +18,29 @@ typedef struct vrna_sequence_s vrna_seq_t;
 
 typedef struct vrna_alignment_s vrna_msa_t;
 
+/**
+ *  @brief  Callback to retrieve a nucleotide sequence piece by piece
+ *
+ *  @callback
+ *  @parblock
+ *  This function is called whenever a streaming algorithm, such as vrna_mfe_window_stream()
+ *  or vrna_probs_window_stream(), requires the next part of the sequence. It must write at
+ *  most @p size nucleotides, without any whitespace or terminating '\0' character, to
+ *  @p buffer and return the number of nucleotides actually written. Returning 0 indicates
+ *  the end of the sequence.
+ *  @endparblock
+ *
+ *  @see vrna_mfe_window_stream(), vrna_probs_window_stream(), vrna_file_fasta_read_sequence()
+ *
+ *  @param  buffer  The memory the next part of the sequence is written to
+ *  @param  size    The maximum number of nucleotides that may be written to @p buffer
+ *  @param  data    Some arbitrary data pointer passed through by the function executing the callback
+ *  @return         The number of nucleotides written to @p buffer, or 0 at the end of the sequence
+ */
+typedef unsigned int (vrna_sequence_stream_callback)(char         *buffer,
+                                                     unsigned int size,
+                                                     void         *data);
+
 #include <ViennaRNA/fold_compound.h>
 
 
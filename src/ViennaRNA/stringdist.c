@@ -40,10 +40,11 @@ sprint_aligned_swStrings(swString *T1,
 
 
 PRIVATE float
-StrEditCost(int       i,
-            int       j,
-            swString  *T1,
-            swString  *T2);
+StrEditCost(int         i,
+            int         j,
+            swString    *T1,
+            swString    *T2,
+            CostMatrix  *cost);
 
 
 PRIVATE void
@@ -62,6 +63,10 @@ encode(int  type,
        char label[]);
 
 
+/*
+ *  The alignment is only computed with edit_backtrack set. Like aligned_line,
+ *  it is shared among all callers, so backtracking is not thread-safe.
+ */
 PRIVATE int *alignment[2];       /* contains information from backtracking
                                   *  alignment[0][n] is the node in tree2
                                   *  matching node n in tree1               */
@@ -74,16 +79,17 @@ string_edit_distance(swString *T1,
                      swString *T2)
 
 {
-  float **distance;
-  short **i_point, **j_point;
+  float       **distance;
+  short       **i_point, **j_point;
 
-  int   i, j, i1, j1, pos, length1, length2;
-  float minus, plus, change, temp;
+  int         i, j, i1, j1, pos, length1, length2;
+  float       minus, plus, change, temp;
+  CostMatrix  *cost;
 
   if (cost_matrix == 0)
-    EditCost = &UsualCost;
+    cost = &UsualCost;
   else
-    EditCost = &ShapiroCost;
+    cost = &ShapiroCost;
 
   i_point = NULL;
   j_point = NULL;
@@ -110,7 +116,7 @@ string_edit_distance(swString *T1,
       j_point[i][0] = 0;
     }
 
-    distance[i][0] = distance[i - 1][0] + StrEditCost(i, 0, T1, T2);
+    distance[i][0] = distance[i - 1][0] + StrEditCost(i, 0, T1, T2, cost);
   }
   for (j = 1; j <= length2; j++) {
     if (edit_backtrack) {
@@ -118,14 +124,14 @@ string_edit_distance(swString *T1,
       i_point[0][j] = 0;
     }
 
-    distance[0][j] = distance[0][j - 1] + StrEditCost(0, j, T1, T2);
+    distance[0][j] = distance[0][j - 1] + StrEditCost(0, j, T1, T2, cost);
   }
 
   for (i = 1; i <= length1; i++) {
     for (j = 1; j <= length2; j++) {
-      minus   = distance[i - 1][j] + StrEditCost(i, 0, T1, T2);
-      plus    = distance[i][j - 1] + StrEditCost(0, j, T1, T2);
-      change  = distance[i - 1][j - 1] + StrEditCost(i, j, T1, T2);
+      minus   = distance[i - 1][j] + StrEditCost(i, 0, T1, T2, cost);
+      plus    = distance[i][j - 1] + StrEditCost(0, j, T1, T2, cost);
+      change  = distance[i - 1][j - 1] + StrEditCost(i, j, T1, T2, cost);
 
       distance[i][j] = MIN3(minus, plus, change);
       /* printf("%g ", distance[i][j]); */
@@ -211,31 +217,32 @@ string_edit_distance(swString *T1,
 /*---------------------------------------------------------------------------*/
 
 PRIVATE float
-StrEditCost(int       i,
-            int       j,
-            swString  *T1,
-            swString  *T2)
+StrEditCost(int         i,
+            int         j,
+            swString    *T1,
+            swString    *T2,
+            CostMatrix  *cost)
 {
   float c, diff, cd, min, a, b, dist;
 
   if (i == 0) {
-    cd    = (float)(*EditCost)[0][T2[j].type];
+    cd    = (float)(*cost)[0][T2[j].type];
     diff  = T2[j].weight;
     dist  = cd * diff;
   } else
   if (j == 0) {
-    cd    = (float)(*EditCost)[T1[i].type][0];
+    cd    = (float)(*cost)[T1[i].type][0];
     diff  = T1[i].weight;
     dist  = cd * diff;
   } else
   if (((T1[i].sign) * (T2[j].sign)) > 0) {
-    c     = (float)(*EditCost)[T1[i].type][T2[j].type];
+    c     = (float)(*cost)[T1[i].type][T2[j].type];
     diff  = (float)fabs((a = T1[i].weight) - (b = T2[j].weight));
     min   = MIN2(a, b);
     if (min == a)
-      cd = (float)(*EditCost)[0][T2[j].type];
+      cd = (float)(*cost)[0][T2[j].type];
     else
-      cd = (float)(*EditCost)[T1[i].type][0];
+      cd = (float)(*cost)[T1[i].type][0];
 
     dist = c * min + cd * diff;
   } else {
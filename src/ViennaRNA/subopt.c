@@ -21,7 +21,6 @@
 #include "ViennaRNA/utils/strings.h"
 #include "ViennaRNA/params/default.h"
 #include "ViennaRNA/fold_vars.h"
-#include "ViennaRNA/datastructures/lists.h"
 #include "ViennaRNA/eval.h"
 #include "ViennaRNA/params/basic.h"
 #include "ViennaRNA/loops/all.h"
@@ -35,6 +34,7 @@
 
 #ifdef _OPENMP
 #include <omp.h>
+#include <sched.h>
 #endif
 
 #define true              1
@@ -44,30 +44,104 @@
 #define ON_SAME_STRAND(I, J, C)  (((I) >= (C)) || ((J) < (C)))
 #endif
 
+/*
+ *  Maximum number of solutions a thread of the concurrent enumeration
+ *  keeps before it passes them to the callback
+ */
+#define SUBOPT_BATCH_SIZE 256
+
 /**
  *  @brief  Sequence interval stack element used in subopt.c
+ *
+ *  Interval stacks are persistent, i.e. a pushed interval is never modified
+ *  but refers to the remainder of the stack it was pushed on. This allows
+ *  states to share their interval stacks after forking. Each interval keeps
+ *  track of the number of references from states and other intervals.
  */
 typedef struct INTERVAL {
-  int i;
-  int j;
-  int array_flag;
+  int             i;
+  int             j;
+  int             array_flag;
+  unsigned int    refs;
+  struct INTERVAL *next;
 } INTERVAL;
 
 typedef struct {
-  char  *structure;
-  LIST  *Intervals;
-  int   partial_energy;
-  int   is_duplex;
+  char      *structure;
+  INTERVAL  *Intervals;       /* top of (shared) interval stack, NULL if empty */
+  int       partial_energy;
+  int       is_duplex;
   /* int best_energy;   */ /* best attainable energy */
 } STATE;
 
+/*
+ *  Pool of fixed-size memory chunks that are carved from large blocks and
+ *  recycled through a free list, to avoid calls to malloc()/free() for each
+ *  state, interval, and structure string
+ */
+typedef struct {
+  size_t        chunk_size;
+  unsigned int  chunks_per_block;
+  unsigned int  used;           /* number of chunks used in current block */
+  char          **blocks;
+  unsigned int  num_blocks;
+  void          *free_chunks;   /* linked list of released chunks */
+} subopt_pool;
+
+/* a solution collected during concurrent enumeration with sorted output */
+typedef struct {
+  char    *structure;
+  int     partial_energy;
+  double  energy;
+} subopt_sol;
+
+
+/*
+ *  Per-thread environment of the enumeration. In parallel mode, the stack of
+ *  pending states acts as a work-stealing deque: The owner pushes and pops
+ *  states at the top, while idle threads take states from the bottom
+ */
 typedef struct {
-  LIST  *Intervals;
-  LIST  *Stack;
-  int   nopush;
+  STATE         **Stack;
+  unsigned int  stack_first;    /* bottom of the stack, slots below were stolen */
+  unsigned int  stack_num;
+  unsigned int  stack_size;
+  int           nopush;
+  int           length;
+  int           concurrent;     /* states and intervals are shared among threads */
+#ifdef _OPENMP
+  omp_lock_t    lock;           /* protects the stack in concurrent mode */
+#endif
+  subopt_pool   state_pool;
+  subopt_pool   interval_pool;
+  subopt_pool           structure_pool;
+  subopt_sol            *solutions;       /* solutions collected in concurrent mode for sorted output */
+  size_t                solutions_num;
+  size_t                solutions_size;
+  char                  *batch;           /* solutions awaiting output in concurrent mode */
+  double                *batch_energies;
+  unsigned int          batch_num;
+  vrna_fold_compound_t  *fc_eval;         /* private fold compound for energy re-evaluation */
 } subopt_env;
 
 
+/* everything required to report a solution */
+struct subopt_out {
+  vrna_subopt_callback  *cb;
+  void                  *data;
+  double                min_en;
+  double                eprint;
+  float                 correction;
+  int                   recalc_energy;
+  int                   logML;
+  int                   cut_point;
+  int                   sorted;
+#ifdef _OPENMP
+  omp_lock_t            lock;     /* serializes callback executions in concurrent mode */
+#endif
+};
+
+
 struct old_subopt_dat {
   unsigned long max_sol;
   unsigned long n_sol;
@@ -134,22 +208,56 @@ make_gquad(int    i,
            STATE  *state);
 
 
-PRIVATE INTERVAL *
-make_interval(int i,
-              int j,
-              int ml);
+PRIVATE void
+pool_init(subopt_pool   *pool,
+          size_t        chunk_size,
+          unsigned int  chunks_per_block);
+
+
+PRIVATE void
+pool_clear(subopt_pool *pool);
+
+
+PRIVATE INLINE void *
+pool_get(subopt_pool *pool);
+
+
+PRIVATE INLINE void
+pool_release(subopt_pool  *pool,
+             void         *chunk);
+
+
+PRIVATE INLINE void
+push_interval(STATE       *state,
+              int         i,
+              int         j,
+              int         array_flag,
+              subopt_env  *env);
+
+
+PRIVATE INLINE INTERVAL *
+pop_interval(STATE      *state,
+             subopt_env *env);
+
+
+PRIVATE INLINE void
+retain_interval(INTERVAL    *interval,
+                subopt_env  *env);
+
+
+PRIVATE INLINE void
+release_interval(INTERVAL   *interval,
+                 subopt_env *env);
 
 
 PRIVATE STATE *
-make_state(LIST *Intervals,
-           char *structure,
-           int  partial_energy,
-           int  is_duplex,
-           int  length);
+make_state(int        partial_energy,
+           subopt_env *env);
 
 
 PRIVATE STATE *
-copy_state(STATE *state);
+copy_state(STATE      *state,
+           subopt_env *env);
 
 
 PRIVATE void
@@ -157,20 +265,88 @@ print_state(STATE *state);
 
 
 PRIVATE void
-UNUSED print_stack(LIST *list);
+UNUSED print_stack(subopt_env *env);
+
+
+PRIVATE INLINE void
+push(subopt_env *env,
+     STATE      *state);
+
+
+PRIVATE INLINE STATE *
+pop(subopt_env *env);
+
+
+PRIVATE subopt_env *
+env_init(int  length,
+         int  concurrent);
+
+
+PRIVATE void
+env_free(subopt_env *env);
+
+
+PRIVATE void
+process_state(vrna_fold_compound_t  *vc,
+              STATE                 *state,
+              int                   threshold,
+              struct subopt_out     *out,
+              subopt_env            *env);
+
+
+PRIVATE void
+report_solution(vrna_fold_compound_t  *vc,
+                STATE                 *state,
+                struct subopt_out     *out,
+                subopt_env            *env);
 
 
-PRIVATE LIST *
-make_list(void);
+PRIVATE void
+output_solution(const char        *structure,
+                double            structure_energy,
+                struct subopt_out *out);
 
 
 PRIVATE void
-push(LIST *list,
-     void *data);
+flush_batch(subopt_env        *env,
+            struct subopt_out *out);
+
+
+PRIVATE vrna_fold_compound_t *
+eval_compound_init(vrna_fold_compound_t *vc);
 
 
 PRIVATE void
-*pop(LIST *list);
+eval_compound_free(vrna_fold_compound_t *fc);
+
+
+#ifdef _OPENMP
+
+PRIVATE STATE *
+steal(subopt_env  *victim,
+      int         *idle);
+
+
+PRIVATE STATE *
+steal_state(subopt_env  **envs,
+            int         num_threads,
+            int         thief,
+            int         *idle);
+
+
+PRIVATE void
+subopt_parallel(vrna_fold_compound_t  *vc,
+                int                   threshold,
+                struct subopt_out     *out,
+                int                   num_threads);
+
+
+PRIVATE int
+compare_collected(const void  *solution1,
+                  const void  *solution2);
+
+
+#endif
 
 
 PRIVATE int
@@ -189,20 +365,13 @@ scan_interval(vrna_fold_compound_t  *vc,
 
 
 PRIVATE void
-free_interval_node(INTERVAL *node);
-
-
-PRIVATE void
-free_state_node(STATE *node);
+free_state_node(STATE       *node,
+                subopt_env  *env);
 
 
 PRIVATE void
-push_back(LIST  *Stack,
-          STATE *state);
-
-
-PRIVATE char *
-get_structure(STATE *state);
+push_back(subopt_env  *env,
+          STATE       *state);
 
 
 PRIVATE int
@@ -292,71 +461,195 @@ make_gquad(int    i,
 
 /*---------------------------------------------------------------------------*/
 
-PRIVATE INTERVAL *
-make_interval(int i,
-              int j,
-              int array_flag)
+PRIVATE void
+pool_init(subopt_pool   *pool,
+          size_t        chunk_size,
+          unsigned int  chunks_per_block)
+{
+  /* each chunk must be able to hold the free list pointer and keep pointers aligned */
+  if (chunk_size < sizeof(void *))
+    chunk_size = sizeof(void *);
+
+  chunk_size = (chunk_size + sizeof(void *) - 1) / sizeof(void *) * sizeof(void *);
+
+  pool->chunk_size        = chunk_size;
+  pool->chunks_per_block  = chunks_per_block;
+  pool->used              = chunks_per_block;
+  pool->blocks            = NULL;
+  pool->num_blocks        = 0;
+  pool->free_chunks       = NULL;
+}
+
+
+PRIVATE void
+pool_clear(subopt_pool *pool)
+{
+  unsigned int i;
+
+  for (i = 0; i < pool->num_blocks; i++)
+    free(pool->blocks[i]);
+
+  free(pool->blocks);
+
+  pool->blocks      = NULL;
+  pool->num_blocks  = 0;
+  pool->used        = pool->chunks_per_block;
+  pool->free_chunks = NULL;
+}
+
+
+PRIVATE INLINE void *
+pool_get(subopt_pool *pool)
+{
+  void *chunk;
+
+  if (pool->free_chunks) {
+    chunk             = pool->free_chunks;
+    pool->free_chunks = *((void **)chunk);
+    return chunk;
+  }
+
+  if (pool->used == pool->chunks_per_block) {
+    pool->blocks = (char **)vrna_realloc(pool->blocks,
+                                         sizeof(char *) * (pool->num_blocks + 1));
+    pool->blocks[pool->num_blocks++] =
+      (char *)vrna_alloc(pool->chunk_size * pool->chunks_per_block);
+    pool->used = 0;
+  }
+
+  return pool->blocks[pool->num_blocks - 1] + pool->chunk_size * (pool->used++);
+}
+
+
+PRIVATE INLINE void
+pool_release(subopt_pool  *pool,
+             void         *chunk)
+{
+  *((void **)chunk) = pool->free_chunks;
+  pool->free_chunks = chunk;
+}
+
+
+/*---------------------------------------------------------------------------*/
+
+PRIVATE INLINE void
+push_interval(STATE       *state,
+              int         i,
+              int         j,
+              int         array_flag,
+              subopt_env  *env)
 {
   INTERVAL *interval;
 
-  interval              = lst_newnode(sizeof(INTERVAL));
+  interval              = (INTERVAL *)pool_get(&(env->interval_pool));
   interval->i           = i;
   interval->j           = j;
   interval->array_flag  = array_flag;
+  interval->refs        = 1;
+  /* the new interval takes over the state's reference to the remaining stack */
+  interval->next    = state->Intervals;
+  state->Intervals  = interval;
+}
+
+
+/*
+ *  Remove the top interval from the interval stack of a state. The caller
+ *  takes over the reference and must release it with release_interval()
+ */
+PRIVATE INLINE INTERVAL *
+pop_interval(STATE      *state,
+             subopt_env *env)
+{
+  INTERVAL *interval = state->Intervals;
+
+  state->Intervals = interval->next;
+  retain_interval(state->Intervals, env);
+
   return interval;
 }
 
 
-/*---------------------------------------------------------------------------*/
+/*
+ *  Reference counts of intervals are modified atomically in parallel mode,
+ *  since interval stacks may be shared by states processed in different threads
+ */
+PRIVATE INLINE void
+retain_interval(INTERVAL    *interval,
+                subopt_env  *env)
+{
+  if (!interval)
+    return;
 
-PRIVATE void
-free_interval_node(INTERVAL *node)
+#ifdef _OPENMP
+  if (env->concurrent) {
+#pragma omp atomic
+    interval->refs++;
+    return;
+  }
+
+#endif
+
+  interval->refs++;
+}
+
+
+PRIVATE INLINE void
+release_interval(INTERVAL   *interval,
+                 subopt_env *env)
 {
-  lst_freenode(node);
+  unsigned int  refs;
+  INTERVAL      *next;
+
+  while (interval) {
+#ifdef _OPENMP
+    if (env->concurrent) {
+#pragma omp atomic capture
+      refs = --interval->refs;
+    } else {
+      refs = --interval->refs;
+    }
+
+#else
+    refs = --interval->refs;
+#endif
+
+    if (refs > 0)
+      break;
+
+    next = interval->next;
+    pool_release(&(env->interval_pool), (void *)interval);
+    interval = next;
+  }
 }
 
 
 /*---------------------------------------------------------------------------*/
 
 PRIVATE void
-free_state_node(STATE *node)
+free_state_node(STATE       *node,
+                subopt_env  *env)
 {
-  free(node->structure);
-  if (node->Intervals)
-    lst_kill(node->Intervals, lst_freenode);
-
-  lst_freenode(node);
+  release_interval(node->Intervals, env);
+  pool_release(&(env->structure_pool), (void *)node->structure);
+  pool_release(&(env->state_pool), (void *)node);
 }
 
 
 /*---------------------------------------------------------------------------*/
 
 PRIVATE STATE *
-make_state(LIST *Intervals,
-           char *structure,
-           int  partial_energy,
-           int  is_duplex,
-           int  length)
+make_state(int        partial_energy,
+           subopt_env *env)
 {
   STATE *state;
 
-  state = lst_newnode(sizeof(STATE));
-
-  if (Intervals)
-    state->Intervals = Intervals;
-  else
-    state->Intervals = lst_init();
-
-  if (structure) {
-    state->structure = structure;
-  } else {
-    int i;
-    state->structure = (char *)vrna_alloc(length + 1);
-    for (i = 0; i < length; i++)
-      state->structure[i] = '.';
-  }
-
-  state->partial_energy = partial_energy;
+  state             = (STATE *)pool_get(&(env->state_pool));
+  state->Intervals  = NULL;
+  state->structure  = (char *)pool_get(&(env->structure_pool));
+  memset(state->structure, '.', sizeof(char) * env->length);
+  state->structure[env->length] = '\0';
+  state->partial_energy         = partial_energy;
+  state->is_duplex              = 0;
 
   return state;
 }
@@ -365,30 +658,22 @@ make_state(LIST *Intervals,
 /*---------------------------------------------------------------------------*/
 
 PRIVATE STATE *
-copy_state(STATE *state)
+copy_state(STATE      *state,
+           subopt_env *env)
 {
-  STATE     *new_state;
-  void      *after;
-  INTERVAL  *new_interval, *next;
+  STATE *new_state;
 
-  new_state                 = lst_newnode(sizeof(STATE));
-  new_state->Intervals      = lst_init();
+  new_state                 = (STATE *)pool_get(&(env->state_pool));
   new_state->partial_energy = state->partial_energy;
+  new_state->is_duplex      = state->is_duplex;
   /* new_state->best_energy = state->best_energy; */
 
-  if (state->Intervals->count) {
-    after = LST_HEAD(new_state->Intervals);
-    for (next = lst_first(state->Intervals); next; next = lst_next(next)) {
-      new_interval  = lst_newnode(sizeof(INTERVAL));
-      *new_interval = *next;
-      lst_insertafter(new_state->Intervals, new_interval, after);
-      after = new_interval;
-    }
-  }
+  /* share the interval stack */
+  new_state->Intervals = state->Intervals;
+  retain_interval(new_state->Intervals, env);
 
-  new_state->structure = strdup(state->structure);
-  if (!new_state->structure)
-    vrna_message_error("out of memory");
+  new_state->structure = (char *)pool_get(&(env->structure_pool));
+  memcpy(new_state->structure, state->structure, sizeof(char) * (env->length + 1));
 
   return new_state;
 }
@@ -399,11 +684,15 @@ copy_state(STATE *state)
 /*@unused @*/ PRIVATE void
 print_state(STATE *state)
 {
-  INTERVAL *next;
+  INTERVAL  *next;
+  int       count;
+
+  for (count = 0, next = state->Intervals; next; next = next->next)
+    count++;
 
-  if (state->Intervals->count) {
-    printf("%d intervals:\n", state->Intervals->count);
-    for (next = lst_first(state->Intervals); next; next = lst_next(next))
+  if (count) {
+    printf("%d intervals:\n", count);
+    for (next = state->Intervals; next; next = next->next)
       printf("[%d,%d],%d ", next->i, next->j, next->array_flag);
     printf("\n");
   }
@@ -419,15 +708,15 @@ print_state(STATE *state)
 /*---------------------------------------------------------------------------*/
 
 /*@unused @*/ PRIVATE void
-print_stack(LIST *list)
+print_stack(subopt_env *env)
 {
-  void *rec;
+  unsigned int s;
 
   printf("================\n");
-  printf("%d states\n", list->count);
-  for (rec = lst_first(list); rec; rec = lst_next(rec)) {
+  printf("%u states\n", env->stack_num - env->stack_first);
+  for (s = env->stack_num; s > env->stack_first; s--) {
     printf("state-----------\n");
-    print_state(rec);
+    print_state(env->Stack[s - 1]);
   }
   printf("================\n");
 }
@@ -435,20 +724,35 @@ print_stack(LIST *list)
 
 /*---------------------------------------------------------------------------*/
 
-PRIVATE LIST *
-make_list(void)
+PRIVATE INLINE void
+push(subopt_env *env,
+     STATE      *state)
 {
-  return lst_init();
-}
+#ifdef _OPENMP
+  if (env->concurrent)
+    omp_set_lock(&(env->lock));
 
+#endif
 
-/*---------------------------------------------------------------------------*/
+  if (env->stack_num == env->stack_size) {
+    if ((env->stack_first > 0) && (env->stack_first >= env->stack_size / 2)) {
+      /* re-use the slots of states that have been stolen from the bottom */
+      env->stack_num -= env->stack_first;
+      memmove(env->Stack, env->Stack + env->stack_first, sizeof(STATE *) * env->stack_num);
+      env->stack_first = 0;
+    } else {
+      env->stack_size = (env->stack_size) ? 2 * env->stack_size : 1024;
+      env->Stack      = (STATE **)vrna_realloc(env->Stack, sizeof(STATE *) * env->stack_size);
+    }
+  }
 
-PRIVATE void
-push(LIST *list,
-     void *data)
-{
-  lst_insertafter(list, data, LST_HEAD(list));
+  env->Stack[env->stack_num++] = state;
+
+#ifdef _OPENMP
+  if (env->concurrent)
+    omp_unset_lock(&(env->lock));
+
+#endif
 }
 
 
@@ -466,13 +770,86 @@ push(LIST *list,
 
 /*---------------------------------------------------------------------------*/
 
-PRIVATE void *
-pop(LIST *list)
+/* returns NULL if the stack is empty */
+PRIVATE INLINE STATE *
+pop(subopt_env *env)
+{
+  STATE *state = NULL;
+
+#ifdef _OPENMP
+  if (env->concurrent)
+    omp_set_lock(&(env->lock));
+
+#endif
+
+  if (env->stack_num > env->stack_first) {
+    state = env->Stack[--env->stack_num];
+    if (env->stack_num == env->stack_first)
+      env->stack_num = env->stack_first = 0;
+  }
+
+#ifdef _OPENMP
+  if (env->concurrent)
+    omp_unset_lock(&(env->lock));
+
+#endif
+
+  return state;
+}
+
+
+/*---------------------------------------------------------------------------*/
+
+PRIVATE subopt_env *
+env_init(int  length,
+         int  concurrent)
 {
-  void *data;
+  subopt_env *env;
+
+  env               = (subopt_env *)vrna_alloc(sizeof(subopt_env));
+  env->Stack        = NULL;
+  env->stack_first  = 0;
+  env->stack_num    = 0;
+  env->stack_size   = 0;
+  env->nopush       = true;
+  env->length         = length;
+  env->concurrent     = concurrent;
+  env->solutions      = NULL;
+  env->solutions_num  = 0;
+  env->solutions_size = 0;
+  env->batch          = NULL;
+  env->batch_energies = NULL;
+  env->batch_num      = 0;
+  env->fc_eval        = NULL;
+#ifdef _OPENMP
+  if (concurrent)
+    omp_init_lock(&(env->lock));
+
+#endif
+  pool_init(&(env->state_pool), sizeof(STATE), 1024);
+  pool_init(&(env->interval_pool), sizeof(INTERVAL), 4096);
+  pool_init(&(env->structure_pool), sizeof(char) * (length + 1), 1024);
 
-  data = lst_deletenext(list, LST_HEAD(list));
-  return data;
+  return env;
+}
+
+
+PRIVATE void
+env_free(subopt_env *env)
+{
+#ifdef _OPENMP
+  if (env->concurrent)
+    omp_destroy_lock(&(env->lock));
+
+#endif
+  pool_clear(&(env->state_pool));
+  pool_clear(&(env->interval_pool));
+  pool_clear(&(env->structure_pool));
+  free(env->Stack);
+  free(env->solutions);
+  free(env->batch);
+  free(env->batch_energies);
+  free(env);
 }
 
 
@@ -498,7 +875,7 @@ best_attainable_energy(vrna_fold_compound_t *vc,
 
   sum = state->partial_energy;  /* energy of already found elements */
 
-  for (next = lst_first(state->Intervals); next; next = lst_next(next)) {
+  for (next = state->Intervals; next; next = next->next) {
     if (next->array_flag == 0)
       sum += (md->circ) ? matrices->Fc : matrices->f5[next->j];
     else if (next->array_flag == 1)
@@ -522,26 +899,14 @@ best_attainable_energy(vrna_fold_compound_t *vc,
 /*---------------------------------------------------------------------------*/
 
 PRIVATE void
-push_back(LIST  *Stack,
-          STATE *state)
+push_back(subopt_env  *env,
+          STATE       *state)
 {
-  push(Stack, copy_state(state));
+  push(env, copy_state(state, env));
   return;
 }
 
 
-/*---------------------------------------------------------------------------*/
-
-PRIVATE char *
-get_structure(STATE *state)
-{
-  char *structure;
-
-  structure = strdup(state->structure);
-  return structure;
-}
-
-
 /*---------------------------------------------------------------------------*/
 PRIVATE int
 compare(const void  *solution1,
@@ -576,16 +941,16 @@ make_output(SOLUTION  *SL,
 
 
 PRIVATE STATE *
-derive_new_state(int    i,
-                 int    j,
-                 STATE  *s,
-                 int    e,
-                 int    flag)
+derive_new_state(int        i,
+                 int        j,
+                 STATE      *s,
+                 int        e,
+                 int        flag,
+                 subopt_env *env)
 {
-  STATE     *s_new  = copy_state(s);
-  INTERVAL  *ival   = make_interval(i, j, flag);
+  STATE *s_new = copy_state(s, env);
 
-  push(s_new->Intervals, ival);
+  push_interval(s_new, i, j, flag, env);
 
   s_new->partial_energy += e;
 
@@ -601,9 +966,9 @@ fork_state(int        i,
            int        flag,
            subopt_env *env)
 {
-  STATE *s_new = derive_new_state(i, j, s, e, flag);
+  STATE *s_new = derive_new_state(i, j, s, e, flag, env);
 
-  push(env->Stack, s_new);
+  push(env, s_new);
   env->nopush = false;
 }
 
@@ -617,11 +982,11 @@ fork_int_state(int        i,
                int        e,
                subopt_env *env)
 {
-  STATE *s_new = derive_new_state(p, q, s, e, 2);
+  STATE *s_new = derive_new_state(p, q, s, e, 2, env);
 
   make_pair(i, j, s_new);
   make_pair(p, q, s_new);
-  push(env->Stack, s_new);
+  push(env, s_new);
   env->nopush = false;
 }
 
@@ -635,10 +1000,10 @@ fork_state_pair(int         i,
 {
   STATE *new_state;
 
-  new_state = copy_state(s);
+  new_state = copy_state(s, env);
   make_pair(i, j, new_state);
   new_state->partial_energy += e;
-  push(env->Stack, new_state);
+  push(env, new_state);
   env->nopush = false;
 }
 
@@ -653,25 +1018,22 @@ fork_two_states_pair(int        i,
                      int        flag2,
                      subopt_env *env)
 {
-  INTERVAL  *interval1, *interval2;
-  STATE     *new_state;
+  STATE *new_state;
 
-  new_state = copy_state(s);
-  interval1 = make_interval(i + 1, k - 1, flag1);
-  interval2 = make_interval(k, j - 1, flag2);
+  new_state = copy_state(s, env);
   if (k - i < j - k) {
     /* push larger interval first */
-    push(new_state->Intervals, interval1);
-    push(new_state->Intervals, interval2);
+    push_interval(new_state, i + 1, k - 1, flag1, env);
+    push_interval(new_state, k, j - 1, flag2, env);
   } else {
-    push(new_state->Intervals, interval2);
-    push(new_state->Intervals, interval1);
+    push_interval(new_state, k, j - 1, flag2, env);
+    push_interval(new_state, i + 1, k - 1, flag1, env);
   }
 
   make_pair(i, j, new_state);
   new_state->partial_energy += e;
 
-  push(env->Stack, new_state);
+  push(env, new_state);
   env->nopush = false;
 }
 
@@ -687,24 +1049,21 @@ fork_two_states(int         i,
                 int         flag2,
                 subopt_env  *env)
 {
-  INTERVAL  *interval1, *interval2;
-  STATE     *new_state;
+  STATE *new_state;
 
-  new_state = copy_state(s);
-  interval1 = make_interval(i, j, flag1);
-  interval2 = make_interval(p, q, flag2);
+  new_state = copy_state(s, env);
 
   if ((j - i) < (q - p)) {
-    push(new_state->Intervals, interval1);
-    push(new_state->Intervals, interval2);
+    push_interval(new_state, i, j, flag1, env);
+    push_interval(new_state, p, q, flag2, env);
   } else {
-    push(new_state->Intervals, interval2);
-    push(new_state->Intervals, interval1);
+    push_interval(new_state, p, q, flag2, env);
+    push_interval(new_state, i, j, flag1, env);
   }
 
   new_state->partial_energy += e;
 
-  push(env->Stack, new_state);
+  push(env, new_state);
   env->nopush = false;
 }
 
@@ -783,27 +1142,25 @@ vrna_subopt_cb(vrna_fold_compound_t *vc,
                vrna_subopt_callback *cb,
                void                 *data)
 {
-  subopt_env    *env;
-  STATE         *state;
-  INTERVAL      *interval;
-  unsigned int  *so, *ss, *se;
-  int           maxlevel, count, partial_energy, old_dangles, logML, dangle_model, length, circular,
-                threshold;
-  double        structure_energy, min_en, eprint;
-  char          *struc, *structure;
-  float         correction;
-  vrna_param_t  *P;
-  vrna_md_t     *md;
-  int           minimal_energy;
-  int           Fc;
-  int           *f5;
+  subopt_env        *env;
+  STATE             *state;
+  unsigned int      *so, *ss;
+  int               partial_energy, old_dangles, logML, dangle_model, length, circular,
+                    threshold;
+  double            min_en;
+  char              *struc;
+  vrna_param_t      *P;
+  vrna_md_t         *md;
+  int               minimal_energy;
+  int               Fc;
+  int               *f5;
+  struct subopt_out out;
 
   vrna_fold_compound_prepare(vc, VRNA_OPTION_MFE | VRNA_OPTION_HYBRID);
 
   length  = vc->length;
   so      = vc->strand_order;
   ss      = vc->strand_start;
-  se      = vc->strand_end;
   P       = vc->params;
   md      = &(P->model_details);
 
@@ -844,17 +1201,20 @@ vrna_subopt_cb(vrna_fold_compound_t *vc,
   }
 
   free(struc);
-  eprint = print_energy + min_en;
 
-  correction = (min_en < 0) ? -0.1 : 0.1;
+  out.cb            = cb;
+  out.data          = data;
+  out.min_en        = min_en;
+  out.eprint        = print_energy + min_en;
+  out.correction    = (min_en < 0) ? -0.1 : 0.1;
+  out.recalc_energy = (logML || (dangle_model == 1) || (dangle_model == 3)) ? 1 : 0;
+  out.logML         = logML;
+  out.cut_point     = (vc->strands > 1) ? (int)ss[so[1]] : -1;
+  out.sorted        = subopt_sorted;
 
   /* Initialize ------------------------------------------------------------ */
 
-  maxlevel        = 0;
-  count           = 0;
-  partial_energy  = 0;
-
-  /* Initialize the stack ------------------------------------------------- */
+  partial_energy = 0;
 
   minimal_energy  = (circular) ? Fc : f5[length];
   threshold       = minimal_energy + delta;
@@ -863,96 +1223,385 @@ vrna_subopt_cb(vrna_fold_compound_t *vc,
     threshold = INF - EMAX;
   }
 
-  /* init env data structure */
-  env             = (subopt_env *)vrna_alloc(sizeof(subopt_env));
-  env->Stack      = NULL;
-  env->nopush     = true;
-  env->Stack      = make_list();                      /* anchor */
-  env->Intervals  = make_list();                      /* initial state: */
-  interval        = make_interval(1, length, 0);      /* interval [1,length,0] */
-  push(env->Intervals, interval);
+#ifdef _OPENMP
+  if (md->num_threads > 1) {
+    subopt_parallel(vc, threshold, &out, md->num_threads);
+    cb(NULL, 0, data);   /* NULL (last time to call callback function */
+    return;
+  }
+
+#endif
+
+  /* Initialize the stack ------------------------------------------------- */
+
+  env = env_init(length, 0);
+
+  state = make_state(partial_energy, env);            /* initial state: */
+  push_interval(state, 1, length, 0, env);            /* interval [1,length,0] */
   env->nopush = false;
-  state       = make_state(env->Intervals, NULL, partial_energy, 0, length);
   /* state->best_energy = minimal_energy; */
-  push(env->Stack, state);
+  push(env, state);
   env->nopush = false;
 
   /* end initialize ------------------------------------------------------- */
 
+  /* forever, til nothing remains on stack */
+  while ((state = pop(env)))
+    process_state(vc, state, threshold, &out, env);
 
-  while (1) {
-    /* forever, til nothing remains on stack */
+  /* we are done! */
+  cb(NULL, 0, data);   /* NULL (last time to call callback function */
 
-    maxlevel = (env->Stack->count > maxlevel ? env->Stack->count : maxlevel);
+  /* cleanup memory */
+  env_free(env);
+}
 
-    if (LST_EMPTY(env->Stack)) {
-      /* we are done! clean up and quit */
-      /* fprintf(stderr, "maxlevel: %d\n", maxlevel); */
 
-      lst_kill(env->Stack, free_state_node);
+/*
+ *  Process a single state, i.e. either report it as solution or derive new
+ *  states from its topmost interval
+ */
+PRIVATE void
+process_state(vrna_fold_compound_t  *vc,
+              STATE                 *state,
+              int                   threshold,
+              struct subopt_out     *out,
+              subopt_env            *env)
+{
+  INTERVAL *interval;
 
-      cb(NULL, 0, data);   /* NULL (last time to call callback function */
+  if (state->Intervals == NULL) {
+    /* state has no intervals left: we got a solution */
+    report_solution(vc, state, out, env);
+  } else {
+    /* get (and remove) next interval of state to analyze */
+    interval = pop_interval(state, env);
+    scan_interval(vc, interval->i, interval->j, interval->array_flag, threshold, state, env);
 
-      break;
-    }
+    release_interval(interval, env);        /* release the current interval */
+  }
 
-    /* pop the last element ---------------------------------------------- */
+  free_state_node(state, env);              /* free the current state */
+}
 
-    state = pop(env->Stack);                       /* current state to work with */
 
-    if (LST_EMPTY(state->Intervals)) {
-      int e;
-      /* state has no intervals left: we got a solution */
+PRIVATE void
+report_solution(vrna_fold_compound_t  *vc,
+                STATE                 *state,
+                struct subopt_out     *out,
+                subopt_env            *env)
+{
+  char    *structure;
+  double  structure_energy;
 
-      count++;
-      structure         = get_structure(state);
-      structure_energy  = state->partial_energy / 100.;
+  structure         = state->structure;
+  structure_energy  = state->partial_energy / 100.;
 
 #ifdef CHECK_ENERGY
-      structure_energy = vrna_eval_structure(vc, structure);
-
-      if (!logML)
-        if ((double)(state->partial_energy / 100.) != structure_energy) {
-          vrna_message_error("%s %6.2f %6.2f",
-                             structure,
-                             state->partial_energy / 100.,
-                             structure_energy);
-          exit(1);
-        }
+  structure_energy = vrna_eval_structure(vc, structure);
+
+  if (!out->logML)
+    if ((double)(state->partial_energy / 100.) != structure_energy) {
+      vrna_message_error("%s %6.2f %6.2f",
+                         structure,
+                         state->partial_energy / 100.,
+                         structure_energy);
+      exit(1);
+    }
 
 #endif
-      if (logML || (dangle_model == 1) || (dangle_model == 3)) /* recalc energy */
-        structure_energy = vrna_eval_structure(vc, structure);
-
-      e = (int)((structure_energy - min_en) * 10. - correction); /* avoid rounding errors */
-      if (e > MAXDOS)
-        e = MAXDOS;
-
-      density_of_states[e]++;
-      if (structure_energy <= eprint) {
-        char *outstruct = vrna_cut_point_insert(structure, (vc->strands > 1) ? ss[so[1]] : -1);
-        cb((const char *)outstruct, structure_energy, data);
-        free(outstruct);
+  if (out->recalc_energy) /* recalc energy */
+    structure_energy = vrna_eval_structure((env->fc_eval) ? env->fc_eval : vc, structure);
+
+  if (env->concurrent) {
+    if (out->sorted) {
+      /* keep the solution until all threads have finished */
+      if (env->solutions_num == env->solutions_size) {
+        env->solutions_size = (env->solutions_size) ? 2 * env->solutions_size : 1024;
+        env->solutions      = (subopt_sol *)vrna_realloc(env->solutions,
+                                                         sizeof(subopt_sol) * env->solutions_size);
       }
 
-      free(structure);
+      env->solutions[env->solutions_num].structure      = strdup(structure);
+      env->solutions[env->solutions_num].partial_energy = state->partial_energy;
+      env->solutions[env->solutions_num].energy         = structure_energy;
+      env->solutions_num++;
     } else {
-      /* get (and remove) next interval of state to analyze */
+      /* pass the solution to the callback along with a batch of others */
+      memcpy(env->batch + env->batch_num * (env->length + 1),
+             structure,
+             sizeof(char) * (env->length + 1));
+      env->batch_energies[env->batch_num++] = structure_energy;
+
+      if (env->batch_num == SUBOPT_BATCH_SIZE)
+        flush_batch(env, out);
+    }
+
+    return;
+  }
+
+  output_solution(structure, structure_energy, out);
+}
+
+
+PRIVATE void
+output_solution(const char        *structure,
+                double            structure_energy,
+                struct subopt_out *out)
+{
+  int   e;
+  char  *outstruct;
+
+  e = (int)((structure_energy - out->min_en) * 10. - out->correction); /* avoid rounding errors */
+  if (e > MAXDOS)
+    e = MAXDOS;
+
+  density_of_states[e]++;
+
+  if (structure_energy <= out->eprint) {
+    outstruct = vrna_cut_point_insert(structure, out->cut_point);
+    out->cb((const char *)outstruct, structure_energy, out->data);
+    free(outstruct);
+  }
+}
+
 
-      interval = pop(state->Intervals);
-      scan_interval(vc, interval->i, interval->j, interval->array_flag, threshold, state, env);
+/*
+ *  Pass the solutions a thread of the concurrent enumeration has
+ *  collected so far to the callback, one thread at a time
+ */
+PRIVATE void
+flush_batch(subopt_env        *env,
+            struct subopt_out *out)
+{
+  unsigned int s;
 
-      free_interval_node(interval);        /* free the current interval */
+#ifdef _OPENMP
+  omp_set_lock(&(out->lock));
+#endif
+
+  for (s = 0; s < env->batch_num; s++)
+    output_solution(env->batch + s * (env->length + 1), env->batch_energies[s], out);
+
+#ifdef _OPENMP
+  omp_unset_lock(&(out->lock));
+#endif
+
+  env->batch_num = 0;
+}
+
+
+/*
+ *  Energy evaluation temporarily modifies the model details of the energy
+ *  parameters. Threads that re-evaluate their solutions therefore use a
+ *  shallow copy of the fold compound with a private copy of the parameters
+ */
+PRIVATE vrna_fold_compound_t *
+eval_compound_init(vrna_fold_compound_t *vc)
+{
+  vrna_fold_compound_t *fc;
+
+  fc = (vrna_fold_compound_t *)vrna_alloc(sizeof(vrna_fold_compound_t));
+  memcpy(fc, vc, sizeof(vrna_fold_compound_t));
+  fc->params = vrna_params_copy(vc->params);
+
+  return fc;
+}
+
+
+PRIVATE void
+eval_compound_free(vrna_fold_compound_t *fc)
+{
+  if (fc) {
+    free(fc->params);
+    free(fc);
+  }
+}
+
+
+#ifdef _OPENMP
+
+/*
+ *  Take the bottom-most state from the stack of another thread. Leaving
+ *  the idle mode while still holding the victim's lock guarantees that
+ *  the number of idle threads never reaches the total number of threads
+ *  as long as there are states left for processing
+ */
+PRIVATE STATE *
+steal(subopt_env  *victim,
+      int         *idle)
+{
+  STATE *state = NULL;
+
+  omp_set_lock(&(victim->lock));
+
+  if (victim->stack_num > victim->stack_first) {
+#pragma omp atomic
+    (*idle)--;
+
+    state = victim->Stack[victim->stack_first++];
+    if (victim->stack_num == victim->stack_first)
+      victim->stack_num = victim->stack_first = 0;
+  }
+
+  omp_unset_lock(&(victim->lock));
+
+  return state;
+}
+
+
+/* returns NULL once all threads are idle, i.e. the enumeration is complete */
+PRIVATE STATE *
+steal_state(subopt_env  **envs,
+            int         num_threads,
+            int         thief,
+            int         *idle)
+{
+  int   k, num_idle;
+  STATE *state;
+
+#pragma omp atomic
+  (*idle)++;
+
+  while (1) {
+    for (k = 1; k < num_threads; k++) {
+      state = steal(envs[(thief + k) % num_threads], idle);
+      if (state)
+        return state;
     }
 
-    free_state_node(state);                     /* free the current state */
-  } /* end of while (1) */
+#pragma omp atomic read
+    num_idle = *idle;
 
-  /* cleanup memory */
-  free(env);
+    if (num_idle == num_threads)
+      return NULL;
+
+    sched_yield();
+  }
 }
 
 
+/*
+ *  Parallel enumeration. Each thread processes the states of its own
+ *  stack in depth-first order and steals pending states of other threads
+ *  whenever its stack runs empty
+ */
+PRIVATE void
+subopt_parallel(vrna_fold_compound_t  *vc,
+                int                   threshold,
+                struct subopt_out     *out,
+                int                   num_threads)
+{
+  int           t, idle;
+  size_t        s, num_sol;
+  STATE         *state;
+  subopt_env    **envs;
+  subopt_sol    *solutions;
+
+  envs = (subopt_env **)vrna_alloc(sizeof(subopt_env *) * num_threads);
+  for (t = 0; t < num_threads; t++) {
+    envs[t] = env_init((int)vc->length, 1);
+
+    if (!out->sorted) {
+      envs[t]->batch = (char *)vrna_alloc(sizeof(char) *
+                                          (vc->length + 1) *
+                                          SUBOPT_BATCH_SIZE);
+      envs[t]->batch_energies = (double *)vrna_alloc(sizeof(double) * SUBOPT_BATCH_SIZE);
+    }
+
+    if (out->recalc_energy)
+      envs[t]->fc_eval = eval_compound_init(vc);
+  }
+
+  omp_init_lock(&(out->lock));
+
+  /* the initial state is put onto the stack of the first thread */
+  state = make_state(0, envs[0]);
+  push_interval(state, 1, (int)vc->length, 0, envs[0]);
+  push(envs[0], state);
+  envs[0]->nopush = false;
+
+  idle = 0;
+
+#pragma omp parallel num_threads(num_threads) private(state)
+  {
+    int         thread_id = omp_get_thread_num();
+    subopt_env  *env      = envs[thread_id];
+
+    while (1) {
+      state = pop(env);
+      if (!state) {
+        state = steal_state(envs, omp_get_num_threads(), thread_id, &idle);
+        if (!state)
+          break;
+      }
+
+      process_state(vc, state, threshold, out, env);
+    }
+
+    flush_batch(env, out);
+  }
+
+  omp_destroy_lock(&(out->lock));
+
+  for (t = 0; t < num_threads; t++)
+    eval_compound_free(envs[t]->fc_eval);
+
+  /*
+   *  For sorted output, merge the solutions of all threads, and report
+   *  them in order of increasing energy and lexicographically ordered
+   *  structures. This makes the output independent of the scheduling
+   */
+  for (num_sol = 0, t = 0; t < num_threads; t++)
+    num_sol += envs[t]->solutions_num;
+
+  solutions = (subopt_sol *)vrna_alloc(sizeof(subopt_sol) * (num_sol + 1));
+
+  for (num_sol = 0, t = 0; t < num_threads; t++) {
+    memcpy(solutions + num_sol, envs[t]->solutions, sizeof(subopt_sol) * envs[t]->solutions_num);
+    num_sol += envs[t]->solutions_num;
+  }
+
+  /*
+   *  states and intervals may have been released into the pool of another
+   *  thread, so memory can only be freed after all threads are done
+   */
+  for (t = 0; t < num_threads; t++)
+    env_free(envs[t]);
+
+  free(envs);
+
+  qsort(solutions, num_sol, sizeof(subopt_sol), compare_collected);
+
+  for (s = 0; s < num_sol; s++) {
+    output_solution(solutions[s].structure, solutions[s].energy, out);
+    free(solutions[s].structure);
+  }
+
+  free(solutions);
+}
+
+
+PRIVATE int
+compare_collected(const void  *solution1,
+                  const void  *solution2)
+{
+  const subopt_sol  *s1 = (const subopt_sol *)solution1;
+  const subopt_sol  *s2 = (const subopt_sol *)solution2;
+
+  if (s1->energy > s2->energy)
+    return 1;
+
+  if (s1->energy < s2->energy)
+    return -1;
+
+  return strcmp(s1->structure, s2->structure);
+}
+
+
+#endif
+
+
 PRIVATE void
 scan_interval(vrna_fold_compound_t  *vc,
               int                   i,
@@ -970,7 +1619,6 @@ scan_interval(vrna_fold_compound_t  *vc,
   /* array_flag = 3:  trace back in fM1-array */
 
   STATE         *new_state, *temp_state;
-  INTERVAL      *new_interval;
   vrna_param_t  *P;
   vrna_md_t     *md;
   register int  k, fi, cij, ij;
@@ -984,7 +1632,7 @@ scan_interval(vrna_fold_compound_t  *vc,
   int           length, *indx, *rtype, circular, with_gquad, turn;
   char          *ptype;
   short         *S1;
-  unsigned char *hard_constraints, hc_decompose;
+  unsigned char hc_decompose;
   vrna_hc_t     *hc;
   vrna_sc_t     *sc;
 
@@ -1018,7 +1666,6 @@ scan_interval(vrna_fold_compound_t  *vc,
   fM2 = vc->matrices->fM2;
 
   hc                = vc->hc;
-  hard_constraints  = hc->mx;
 
   sc = vc->sc;
 
@@ -1035,7 +1682,7 @@ scan_interval(vrna_fold_compound_t  *vc,
       state->partial_energy += f5[j];
 
     if (env->nopush) {
-      push_back(env->Stack, state);
+      push_back(env, state);
       env->nopush = false;
     }
 
@@ -1076,7 +1723,7 @@ scan_interval(vrna_fold_compound_t  *vc,
         fork_state(i, j - 1, state, P->MLbase, array_flag, env);
     }
 
-    hc_decompose = hard_constraints[length * i + j];
+    hc_decompose = vrna_hc_mx_get(hc, i, j);
 
     if (hc_decompose & VRNA_CONSTRAINT_CONTEXT_MB_LOOP_ENC) {
       /* i,j may pair */
@@ -1135,7 +1782,7 @@ scan_interval(vrna_fold_compound_t  *vc,
           element_energy = E_MLstem(0, -1, -1, P);
 
           if (fML[indx[k] + i] + ggg[indx[j] + k + 1] + element_energy + best_energy <= threshold) {
-            temp_state  = derive_new_state(i, k, state, 0, array_flag);
+            temp_state  = derive_new_state(i, k, state, 0, array_flag, env);
             env->nopush = false;
             repeat_gquad(vc,
                          k + 1,
@@ -1146,13 +1793,13 @@ scan_interval(vrna_fold_compound_t  *vc,
                          best_energy,
                          threshold,
                          env);
-            free_state_node(temp_state);
+            free_state_node(temp_state, env);
           }
         }
 
         k1j = indx[j] + k + 1;
 
-        if ((hard_constraints[length * j + k + 1] & VRNA_CONSTRAINT_CONTEXT_MB_LOOP_ENC) &&
+        if ((vrna_hc_mx_get(hc, j, k + 1) & VRNA_CONSTRAINT_CONTEXT_MB_LOOP_ENC) &&
             (fML[indx[k] + i] != INF) &&
             (c[k1j] != INF)) {
           short s5, s3;
@@ -1178,7 +1825,7 @@ scan_interval(vrna_fold_compound_t  *vc,
 
           if (sn[k] == sn[k + 1]) {
             if (fML[indx[k] + i] + c[k1j] + element_energy + best_energy <= threshold) {
-              temp_state  = derive_new_state(i, k, state, 0, array_flag);
+              temp_state  = derive_new_state(i, k, state, 0, array_flag, env);
               env->nopush = false;
               repeat(vc,
                      k + 1,
@@ -1189,7 +1836,7 @@ scan_interval(vrna_fold_compound_t  *vc,
                      best_energy,
                      threshold,
                      env);
-              free_state_node(temp_state);
+              free_state_node(temp_state, env);
             }
           }
         }
@@ -1223,7 +1870,7 @@ scan_interval(vrna_fold_compound_t  *vc,
             repeat_gquad(vc, k + 1, j, state, element_energy, 0, best_energy, threshold, env);
         }
 
-        if ((hard_constraints[length * j + k + 1] & VRNA_CONSTRAINT_CONTEXT_MB_LOOP_ENC) &&
+        if ((vrna_hc_mx_get(hc, j, k + 1) & VRNA_CONSTRAINT_CONTEXT_MB_LOOP_ENC) &&
             (c[k1j] != INF)) {
           int s5, s3;
 
@@ -1311,7 +1958,7 @@ scan_interval(vrna_fold_compound_t  *vc,
         element_energy = 0;
 
         if (f5[k - 1] + ggg[kj] + element_energy + best_energy <= threshold) {
-          temp_state  = derive_new_state(1, k - 1, state, 0, 0);
+          temp_state  = derive_new_state(1, k - 1, state, 0, 0, env);
           env->nopush = false;
           /* backtrace the quadruplex */
           repeat_gquad(vc,
@@ -1323,11 +1970,11 @@ scan_interval(vrna_fold_compound_t  *vc,
                        best_energy,
                        threshold,
                        env);
-          free_state_node(temp_state);
+          free_state_node(temp_state, env);
         }
       }
 
-      if ((hard_constraints[length * j + k] & VRNA_CONSTRAINT_CONTEXT_EXT_LOOP) &&
+      if ((vrna_hc_mx_get(hc, j, k) & VRNA_CONSTRAINT_CONTEXT_EXT_LOOP) &&
           (f5[k - 1] != INF) &&
           (c[kj] != INF)) {
         type = vrna_get_ptype(kj, ptype);
@@ -1355,10 +2002,10 @@ scan_interval(vrna_fold_compound_t  *vc,
         }
 
         if (f5[k - 1] + c[kj] + element_energy + best_energy <= threshold) {
-          temp_state  = derive_new_state(1, k - 1, state, 0, 0);
+          temp_state  = derive_new_state(1, k - 1, state, 0, 0, env);
           env->nopush = false;
           repeat(vc, k, j, temp_state, element_energy, f5[k - 1], best_energy, threshold, env);
-          free_state_node(temp_state);
+          free_state_node(temp_state, env);
         }
       }
     }
@@ -1375,7 +2022,7 @@ scan_interval(vrna_fold_compound_t  *vc,
         repeat_gquad(vc, 1, j, state, element_energy, 0, best_energy, threshold, env);
     }
 
-    if ((hard_constraints[length + j] & VRNA_CONSTRAINT_CONTEXT_EXT_LOOP) &&
+    if ((vrna_hc_mx_get(hc, 1, j) & VRNA_CONSTRAINT_CONTEXT_EXT_LOOP) &&
         (c[kj] != INF)) {
       type  = vrna_get_ptype(kj, ptype);
       s5    = -1;
@@ -1423,9 +2070,9 @@ scan_interval(vrna_fold_compound_t  *vc,
       }
 
       if (tmp_en <= threshold) {
-        new_state                 = derive_new_state(1, 2, state, 0, 0);
+        new_state                 = derive_new_state(1, 2, state, 0, 0, env);
         new_state->partial_energy = 0;
-        push(env->Stack, new_state);
+        push(env, new_state);
         env->nopush = false;
       }
     }
@@ -1470,7 +2117,7 @@ scan_interval(vrna_fold_compound_t  *vc,
 
           kl = indx[l] + k;         /* just confusing these indices ;-) */
 
-          if ((hard_constraints[length * k + l] & VRNA_CONSTRAINT_CONTEXT_INT_LOOP) &&
+          if ((vrna_hc_mx_get(hc, k, l) & VRNA_CONSTRAINT_CONTEXT_INT_LOOP) &&
               (c[kl] != INF)) {
             type = rtype[vrna_get_ptype(kl, ptype)];
 
@@ -1493,7 +2140,7 @@ scan_interval(vrna_fold_compound_t  *vc,
                 if (hc->up_int[q + 1] < (j - q + k - 1))
                   break;
 
-                if ((hard_constraints[length * p + q] & VRNA_CONSTRAINT_CONTEXT_INT_LOOP) &&
+                if ((vrna_hc_mx_get(hc, p, q) & VRNA_CONSTRAINT_CONTEXT_INT_LOOP) &&
                     (c[indx[q] + p] != INF)) {
                   type_2 = rtype[vrna_get_ptype(indx[q] + p, ptype)];
 
@@ -1560,27 +2207,24 @@ scan_interval(vrna_fold_compound_t  *vc,
               if (tmpE2 + fML[indx[k] + 1] + P->MLclosing <= threshold) {
                 /* we've (hopefully) found a valid decomposition of fM2 and therefor we have all */
                 /* three intervals for our new state to be pushed on stack R */
-                new_state = copy_state(state);
+                new_state = copy_state(state, env);
 
                 /* first interval leads for search in fML array */
-                new_interval = make_interval(1, k, 1);
-                push(new_state->Intervals, new_interval);
+                push_interval(new_state, 1, k, 1, env);
                 env->nopush = false;
 
                 /* next, we have the first interval that has to be traced in fM1 */
-                new_interval = make_interval(k + 1, l, 3);
-                push(new_state->Intervals, new_interval);
+                push_interval(new_state, k + 1, l, 3, env);
                 env->nopush = false;
 
                 /* and the last of our three intervals is also one to be traced within fM1 array... */
-                new_interval = make_interval(l + 1, j, 3);
-                push(new_state->Intervals, new_interval);
+                push_interval(new_state, l + 1, j, 3, env);
                 env->nopush = false;
 
                 /* mmh, we add the energy for closing the multiloop now... */
                 new_state->partial_energy += P->MLclosing;
                 /* next we push our state onto the R stack */
-                push(env->Stack, new_state);
+                push(env, new_state);
                 env->nopush = false;
               }
 
@@ -1628,14 +2272,14 @@ scan_interval(vrna_fold_compound_t  *vc,
           (fc[k + 1] != INF) &&
           (ggg[ik] != INF)) {
         if (fc[k + 1] + ggg[ik] + best_energy <= threshold) {
-          temp_state  = derive_new_state(k + 1, j, state, 0, 4);
+          temp_state  = derive_new_state(k + 1, j, state, 0, 4, env);
           env->nopush = false;
           repeat_gquad(vc, i, k, temp_state, 0, fc[k + 1], best_energy, threshold, env);
-          free_state_node(temp_state);
+          free_state_node(temp_state, env);
         }
       }
 
-      if ((hard_constraints[length * i + k] & VRNA_CONSTRAINT_CONTEXT_EXT_LOOP) &&
+      if ((vrna_hc_mx_get(hc, i, k) & VRNA_CONSTRAINT_CONTEXT_EXT_LOOP) &&
           (fc[k + 1] != INF) &&
           (c[ik] != INF)) {
         type = vrna_get_ptype(ik, ptype);
@@ -1658,10 +2302,10 @@ scan_interval(vrna_fold_compound_t  *vc,
         }
 
         if (fc[k + 1] + c[ik] + element_energy + best_energy <= threshold) {
-          temp_state  = derive_new_state(k + 1, j, state, 0, 4);
+          temp_state  = derive_new_state(k + 1, j, state, 0, 4, env);
           env->nopush = false;
           repeat(vc, i, k, temp_state, element_energy, fc[k + 1], best_energy, threshold, env);
-          free_state_node(temp_state);
+          free_state_node(temp_state, env);
         }
       }
     }
@@ -1672,7 +2316,7 @@ scan_interval(vrna_fold_compound_t  *vc,
       if (ggg[ik] + best_energy <= threshold)
         repeat_gquad(vc, i, se[so[0]], state, 0, 0, best_energy, threshold, env);
 
-    if ((hard_constraints[length * i + se[so[0]]] & VRNA_CONSTRAINT_CONTEXT_EXT_LOOP) &&
+    if ((vrna_hc_mx_get(hc, i, se[so[0]]) & VRNA_CONSTRAINT_CONTEXT_EXT_LOOP) &&
         (c[ik] != INF)) {
       type  = vrna_get_ptype(ik, ptype);
       s3    = -1;
@@ -1732,14 +2376,14 @@ scan_interval(vrna_fold_compound_t  *vc,
           (fc[k - 1] != INF) &&
           (ggg[kj] != INF)) {
         if (fc[k - 1] + ggg[kj] + best_energy <= threshold) {
-          temp_state  = derive_new_state(i, k - 1, state, 0, 5);
+          temp_state  = derive_new_state(i, k - 1, state, 0, 5, env);
           env->nopush = false;
           repeat_gquad(vc, k, j, temp_state, 0, fc[k - 1], best_energy, threshold, env);
-          free_state_node(temp_state);
+          free_state_node(temp_state, env);
         }
       }
 
-      if ((hard_constraints[length * j + k] & VRNA_CONSTRAINT_CONTEXT_EXT_LOOP) &&
+      if ((vrna_hc_mx_get(hc, j, k) & VRNA_CONSTRAINT_CONTEXT_EXT_LOOP) &&
           (fc[k - 1] != INF) &&
           (c[kj] != INF)) {
         type            = vrna_get_ptype(kj, ptype);
@@ -1763,10 +2407,10 @@ scan_interval(vrna_fold_compound_t  *vc,
         }
 
         if (fc[k - 1] + c[kj] + element_energy + best_energy <= threshold) {
-          temp_state  = derive_new_state(i, k - 1, state, 0, 5);
+          temp_state  = derive_new_state(i, k - 1, state, 0, 5, env);
           env->nopush = false;
           repeat(vc, k, j, temp_state, element_energy, fc[k - 1], best_energy, threshold, env);
-          free_state_node(temp_state);
+          free_state_node(temp_state, env);
         }
       }
     }
@@ -1777,7 +2421,7 @@ scan_interval(vrna_fold_compound_t  *vc,
       if (ggg[kj] + best_energy <= threshold)
         repeat_gquad(vc, ss[so[1]], j, state, 0, 0, best_energy, threshold, env);
 
-    if ((hard_constraints[length * ss[so[1]] + j] & VRNA_CONSTRAINT_CONTEXT_EXT_LOOP) &&
+    if ((vrna_hc_mx_get(hc, ss[so[1]], j) & VRNA_CONSTRAINT_CONTEXT_EXT_LOOP) &&
         (c[kj] != INF)) {
       type  = vrna_get_ptype(kj, ptype);
       s5    = -1;
@@ -1813,7 +2457,7 @@ scan_interval(vrna_fold_compound_t  *vc,
   }
 
   if (env->nopush) {
-    push_back(env->Stack, state);
+    push_back(env, state);
     env->nopush = false;
   }
 
@@ -1867,14 +2511,14 @@ repeat_gquad(vrna_fold_compound_t *vc,
       get_gquad_pattern_exhaustive(S1, i, j, P, L, l, threshold - best_energy);
 
       for (cnt = 0; L[cnt] != -1; cnt++) {
-        new_state = copy_state(state);
+        new_state = copy_state(state, env);
 
         make_gquad(i, L[cnt], &(l[3 * cnt]), new_state);
         new_state->partial_energy += part_energy;
         new_state->partial_energy += element_energy;
         /* new_state->best_energy =
          * hairpin[unpaired] + element_energy + best_energy; */
-        push(env->Stack, new_state);
+        push(env, new_state);
         env->nopush = false;
       }
       free(L);
@@ -1910,7 +2554,7 @@ repeat(vrna_fold_compound_t *vc,
   register int  mm;
   register int  no_close, type, type_2;
   char          *ptype;
-  unsigned int  n, *sn, *so, *ss, *se;
+  unsigned int  *sn, *so, *ss, *se;
   int           element_energy;
   int           *fc, *c, *fML, *fM1, *ggg;
   int           rt, *indx, *rtype, noGUclosure, noLP, with_gquad, dangle_model, turn;
@@ -1918,7 +2562,6 @@ repeat(vrna_fold_compound_t *vc,
   vrna_hc_t     *hc;
   vrna_sc_t     *sc;
 
-  n     = vc->length;
   S1    = vc->sequence_encoding;
   ptype = vc->ptype;
   indx  = vc->jindx;
@@ -1954,11 +2597,11 @@ repeat(vrna_fold_compound_t *vc,
 
   no_close = (((type == 3) || (type == 4)) && noGUclosure);
 
-  if (hc->mx[n * i + j] & VRNA_CONSTRAINT_CONTEXT_INT_LOOP) {
+  if (vrna_hc_mx_get(hc, i, j) & VRNA_CONSTRAINT_CONTEXT_INT_LOOP) {
     if (noLP) {
       /* always consider the structure with additional stack */
       if (i + turn + 2 < j) {
-        if (hc->mx[n * (i + 1) + j - 1] & VRNA_CONSTRAINT_CONTEXT_INT_LOOP_ENC) {
+        if (vrna_hc_mx_get(hc, i + 1, j - 1) & VRNA_CONSTRAINT_CONTEXT_INT_LOOP_ENC) {
           type_2  = rtype[vrna_get_ptype(indx[j - 1] + i + 1, ptype)];
           energy  = 0;
 
@@ -1980,12 +2623,12 @@ repeat(vrna_fold_compound_t *vc,
                 energy += sc->f(i, j, i + 1, j - 1, VRNA_DECOMP_PAIR_IL, sc->data);
             }
 
-            new_state = derive_new_state(i + 1, j - 1, state, part_energy + energy, 2);
+            new_state = derive_new_state(i + 1, j - 1, state, part_energy + energy, 2, env);
             make_pair(i, j, new_state);
             make_pair(i + 1, j - 1, new_state);
 
             /* new_state->best_energy = new + best_energy; */
-            push(env->Stack, new_state);
+            push(env, new_state);
             env->nopush = false;
             if (i == 1 || state->structure[i - 2] != '(' || state->structure[j] != ')')
               /* adding a stack is the only possible structure */
@@ -1999,7 +2642,7 @@ repeat(vrna_fold_compound_t *vc,
   best_energy += part_energy; /* energy of current structural element */
   best_energy += temp_energy; /* energy from unpushed interval */
 
-  if (hc->mx[n * i + j] & VRNA_CONSTRAINT_CONTEXT_INT_LOOP) {
+  if (vrna_hc_mx_get(hc, i, j) & VRNA_CONSTRAINT_CONTEXT_INT_LOOP) {
     for (p = i + 1; p <= MIN2(j - 2 - turn, i + MAXLOOP + 1); p++) {
       int minq = j - i + p - MAXLOOP - 2;
       if (minq < p + 1 + turn)
@@ -2016,7 +2659,7 @@ repeat(vrna_fold_compound_t *vc,
         if ((noLP) && (p == i + 1) && (q == j - 1))
           continue;
 
-        if (!(hc->mx[n * p + q] & VRNA_CONSTRAINT_CONTEXT_INT_LOOP_ENC))
+        if (!(vrna_hc_mx_get(hc, p, q) & VRNA_CONSTRAINT_CONTEXT_INT_LOOP_ENC))
           continue;
 
         if (c[indx[q] + p] == INF)
@@ -2070,7 +2713,7 @@ repeat(vrna_fold_compound_t *vc,
 
   if (sn[i] != sn[j]) {
     /*look in fc*/
-    if ((hc->mx[n * i + j] & VRNA_CONSTRAINT_CONTEXT_EXT_LOOP) &&
+    if ((vrna_hc_mx_get(hc, i, j) & VRNA_CONSTRAINT_CONTEXT_EXT_LOOP) &&
         (fc[i + 1] != INF) &&
         (fc[j - 1] != INF)) {
       rt = rtype[type];
@@ -2101,7 +2744,7 @@ repeat(vrna_fold_compound_t *vc,
   mm  = P->MLclosing;
   rt  = rtype[type];
 
-  if ((hc->mx[n * i + j] & VRNA_CONSTRAINT_CONTEXT_MB_LOOP) &&
+  if ((vrna_hc_mx_get(hc, i, j) & VRNA_CONSTRAINT_CONTEXT_MB_LOOP) &&
       ((vc->strands < 2) || ((i != se[so[0]]) && (j != ss[so[1]])))) {
     element_energy = mm;
     switch (dangle_model) {
@@ -2150,7 +2793,7 @@ repeat(vrna_fold_compound_t *vc,
   }
 
   if (sn[i] == sn[j]) {
-    if ((hc->mx[n * i + j] & VRNA_CONSTRAINT_CONTEXT_HP_LOOP) &&
+    if ((vrna_hc_mx_get(hc, i, j) & VRNA_CONSTRAINT_CONTEXT_HP_LOOP) &&
         (!no_close)) {
 
       element_energy = vrna_E_hp_loop(vc, i, j);
@@ -2181,12 +2824,12 @@ repeat(vrna_fold_compound_t *vc,
                         + sc->energy_up[q[cnt] + 1][j - q[cnt] - 1];
           }
 
-          new_state = derive_new_state(p[cnt], q[cnt], state, tmp_en + part_energy, 6);
+          new_state = derive_new_state(p[cnt], q[cnt], state, tmp_en + part_energy, 6, env);
 
           make_pair(i, j, new_state);
 
           /* new_state->best_energy = new + best_energy; */
-          push(env->Stack, new_state);
+          push(env, new_state);
           env->nopush = false;
         }
       }
@@ -148,6 +148,16 @@ vrna_subopt(vrna_fold_compound_t *vc,
   vrna_fold_compound_t *vc=vrna_fold_compound("GGGGGGAAAAAACCCCCC", &md, VRNA_OPTION_DEFAULT);
  *        @endcode
  *
+ *  @note If OpenMP support is available and #vrna_md_t.num_threads of the fold compound's model
+ *        details is larger than 1, the enumeration is distributed among as many threads. Threads
+ *        that run out of work steal pending partial structures from other threads. Solutions
+ *        are passed to the callback in small batches as they are found. The callback is never
+ *        executed by more than one thread at a time, but the order of the structures varies
+ *        between runs. If #subopt_sorted is set, all solutions are kept until the enumeration
+ *        is complete instead, and are then passed to the callback in order of increasing free
+ *        energy and lexicographically ordered structures. As for the parallel fill of the
+ *        DP matrices, any soft constraint callback must be thread-safe in this case.
+ *
  *  @see vrna_subopt_callback, vrna_subopt(), vrna_subopt_zuker()
  *  @param  vc      fold compount with the sequence data
  *  @param  delta   Energy band arround the MFE in 10cal/mol, i.e. deka-calories
@@ -21,6 +21,22 @@
 
 #define MNODES    4000    /* Maximal number of nodes for alignment    */
 
+/*
+ *  The working memory of a single tree edit distance computation. It is kept
+ *  on the stack of tree_edit_distance(), such that concurrent computations
+ *  do not interfere with each other.
+ */
+typedef struct {
+  CostMatrix  *cost;          /* points to UsualCost or ShapiroCost */
+  Tree        *tree1, *tree2;
+  int         **tdist;        /* contains distances between subtrees */
+  int         **fdist;        /* contains distances between forests */
+  int         *alignment[2];  /* contains numeric information on the alignment:
+                               * alignment[0][p], aligment[1][p] are aligned postions.
+                               * INDELs have one 0.
+                               * alignment[0][0] contains the length of the alignment. */
+} tree_edit_data;
+
 PUBLIC Tree *
 make_tree(char *struc);
 
@@ -39,13 +55,15 @@ free_tree(Tree *t);
 
 
 PRIVATE void
-tree_dist(int i,
-          int j);
+tree_dist(tree_edit_data  *d,
+          int             i,
+          int             j);
 
 
 PRIVATE int
-edit_cost(int i,
-          int j);
+edit_cost(tree_edit_data  *d,
+          int             i,
+          int             j);
 
 
 PRIVATE int *
@@ -83,20 +101,11 @@ print_postorder_list(Postorder_list *pl);
 
 
 PRIVATE void
-backtracking(void);
+backtracking(tree_edit_data *d);
 
 
 PRIVATE void
-sprint_aligned_trees(void);
-
-
-PRIVATE Tree  *tree1, *tree2;
-PRIVATE int   **tdist;        /* contains distances between subtrees */
-PRIVATE int   **fdist;        /* contains distances between forests */
-PRIVATE int   *alignment[2];  /* contains numeric information on the alignment:
-                               * alignment[0][p], aligment[1][p] are aligned postions.
-                               * INDELs have one 0.
-                               * alignment[0][0] contains the length of the alignment. */
+sprint_aligned_trees(tree_edit_data *d);
 
 /*---------------------------------------------------------------------------*/
 
@@ -104,33 +113,36 @@ PUBLIC float
 tree_edit_distance(Tree *T1,
                    Tree *T2)
 {
-  int i1, j1, i, j, dist;
-  int n1, n2;
+  int             i1, j1, i, j, dist;
+  int             n1, n2;
+  tree_edit_data  data, *d;
+
+  d = &data;
 
   if (cost_matrix == 0)
-    EditCost = &UsualCost;
+    d->cost = &UsualCost;
   else
-    EditCost = &ShapiroCost;
+    d->cost = &ShapiroCost;
 
   n1  = T1->postorder_list[0].sons;
   n2  = T2->postorder_list[0].sons;
 
-  tdist = (int **)vrna_alloc(sizeof(int *) * (n1 + 1));
-  fdist = (int **)vrna_alloc(sizeof(int *) * (n1 + 1));
+  d->tdist  = (int **)vrna_alloc(sizeof(int *) * (n1 + 1));
+  d->fdist  = (int **)vrna_alloc(sizeof(int *) * (n1 + 1));
   for (i = 0; i <= n1; i++) {
-    tdist[i]  = (int *)vrna_alloc(sizeof(int) * (n2 + 1));
-    fdist[i]  = (int *)vrna_alloc(sizeof(int) * (n2 + 1));
+    d->tdist[i] = (int *)vrna_alloc(sizeof(int) * (n2 + 1));
+    d->fdist[i] = (int *)vrna_alloc(sizeof(int) * (n2 + 1));
   }
 
-  tree1 = T1;
-  tree2 = T2;
+  d->tree1  = T1;
+  d->tree2  = T2;
 
   for (i1 = 1; i1 <= T1->keyroots[0]; i1++) {
     i = T1->keyroots[i1];
     for (j1 = 1; j1 <= T2->keyroots[0]; j1++) {
       j = T2->keyroots[j1];
 
-      tree_dist(i, j);
+      tree_dist(d, i, j);
     }
   }
 
@@ -138,22 +150,22 @@ tree_edit_distance(Tree *T1,
     if ((n1 > MNODES) || (n2 > MNODES))
       vrna_message_error("tree too large for alignment");
 
-    alignment[0]  = (int *)vrna_alloc((n1 + 1) * sizeof(int));
-    alignment[1]  = (int *)vrna_alloc((n2 + 1) * sizeof(int));
+    d->alignment[0] = (int *)vrna_alloc((n1 + 1) * sizeof(int));
+    d->alignment[1] = (int *)vrna_alloc((n2 + 1) * sizeof(int));
 
-    backtracking();
-    sprint_aligned_trees();
-    free(alignment[0]);
-    free(alignment[1]);
+    backtracking(d);
+    sprint_aligned_trees(d);
+    free(d->alignment[0]);
+    free(d->alignment[1]);
   }
 
-  dist = tdist[n1][n2];
+  dist = d->tdist[n1][n2];
   for (i = 0; i <= n1; i++) {
-    free(tdist[i]);
-    free(fdist[i]);
+    free(d->tdist[i]);
+    free(d->fdist[i]);
   }
-  free(tdist);
-  free(fdist);
+  free(d->tdist);
+  free(d->fdist);
 
   return (float)dist;
 }
@@ -162,54 +174,55 @@ tree_edit_distance(Tree *T1,
 /*---------------------------------------------------------------------------*/
 
 PRIVATE void
-tree_dist(int i,
-          int j)
+tree_dist(tree_edit_data  *d,
+          int             i,
+          int             j)
 {
   int li, lj, i1, j1, i1_1, j1_1, li1_1, lj1_1, f1, f2, f3, f;
   int cost, lleaf_i1, lleaf_j1;
 
-  fdist[0][0] = 0;
+  d->fdist[0][0] = 0;
 
-  li  = tree1->postorder_list[i].leftmostleaf;
-  lj  = tree2->postorder_list[j].leftmostleaf;
+  li  = d->tree1->postorder_list[i].leftmostleaf;
+  lj  = d->tree2->postorder_list[j].leftmostleaf;
 
   for (i1 = li; i1 <= i; i1++) {
-    i1_1          = (li == i1 ? 0 : i1 - 1);
-    fdist[i1][0]  = fdist[i1_1][0] + edit_cost(i1, 0);
+    i1_1            = (li == i1 ? 0 : i1 - 1);
+    d->fdist[i1][0] = d->fdist[i1_1][0] + edit_cost(d, i1, 0);
   }
 
   for (j1 = lj; j1 <= j; j1++) {
-    j1_1          = (lj == j1 ? 0 : j1 - 1);
-    fdist[0][j1]  = fdist[0][j1_1] + edit_cost(0, j1);
+    j1_1            = (lj == j1 ? 0 : j1 - 1);
+    d->fdist[0][j1] = d->fdist[0][j1_1] + edit_cost(d, 0, j1);
   }
 
   for (i1 = li; i1 <= i; i1++) {
-    lleaf_i1  = tree1->postorder_list[i1].leftmostleaf;
+    lleaf_i1  = d->tree1->postorder_list[i1].leftmostleaf;
     li1_1     = (li > lleaf_i1 - 1 ? 0 : lleaf_i1 - 1);
     i1_1      = (i1 == li ? 0 : i1 - 1);
-    cost      = edit_cost(i1, 0);
+    cost      = edit_cost(d, i1, 0);
 
     for (j1 = lj; j1 <= j; j1++) {
-      lleaf_j1  = tree2->postorder_list[j1].leftmostleaf;
+      lleaf_j1  = d->tree2->postorder_list[j1].leftmostleaf;
       j1_1      = (j1 == lj ? 0 : j1 - 1);
 
-      f1  = fdist[i1_1][j1] + cost;
-      f2  = fdist[i1][j1_1] + edit_cost(0, j1);
+      f1  = d->fdist[i1_1][j1] + cost;
+      f2  = d->fdist[i1][j1_1] + edit_cost(d, 0, j1);
 
       f = f1 < f2 ? f1 : f2;
 
       if (lleaf_i1 == li && lleaf_j1 == lj) {
-        f3 = fdist[i1_1][j1_1] + edit_cost(i1, j1);
+        f3 = d->fdist[i1_1][j1_1] + edit_cost(d, i1, j1);
 
-        fdist[i1][j1] = f3 < f ? f3 : f;
+        d->fdist[i1][j1] = f3 < f ? f3 : f;
 
-        tdist[i1][j1] = fdist[i1][j1]; /* store in array permanently */
+        d->tdist[i1][j1] = d->fdist[i1][j1]; /* store in array permanently */
       } else {
         lj1_1 = (lj > lleaf_j1 - 1 ? 0 : lleaf_j1 - 1);
 
-        f3 = fdist[li1_1][lj1_1] + tdist[i1][j1];
+        f3 = d->fdist[li1_1][lj1_1] + d->tdist[i1][j1];
 
-        fdist[i1][j1] = f3 < f ? f3 : f;
+        d->fdist[i1][j1] = f3 < f ? f3 : f;
       }
     }
   }
@@ -219,20 +232,21 @@ tree_dist(int i,
 /*---------------------------------------------------------------------------*/
 
 PRIVATE int
-edit_cost(int i,
-          int j)
+edit_cost(tree_edit_data  *d,
+          int             i,
+          int             j)
 {
   int c, diff, cd, min, a, b;
 
-  c = (*EditCost)[tree1->postorder_list[i].type][tree2->postorder_list[j].type];
+  c = (*d->cost)[d->tree1->postorder_list[i].type][d->tree2->postorder_list[j].type];
 
-  diff = abs((a = tree1->postorder_list[i].weight) - (b = tree2->postorder_list[j].weight));
+  diff = abs((a = d->tree1->postorder_list[i].weight) - (b = d->tree2->postorder_list[j].weight));
 
   min = (a < b ? a : b);
   if (min == a)
-    cd = (*EditCost)[0][tree2->postorder_list[j].type];
+    cd = (*d->cost)[0][d->tree2->postorder_list[j].type];
   else
-    cd = (*EditCost)[0][tree1->postorder_list[i].type];
+    cd = (*d->cost)[0][d->tree1->postorder_list[i].type];
 
   return c * min + cd * diff;
 }
@@ -582,7 +596,7 @@ free_tree(Tree *t)
 
 
 PRIVATE void
-backtracking(void)
+backtracking(tree_edit_data *d)
 {
   int li, lj, i1, j1, i1_1, j1_1, li1_1, lj1_1, f;
   int cost, lleaf_i1, lleaf_j1, ss, i, j, k;
@@ -593,37 +607,37 @@ backtracking(void)
 
   ss = 0;
 
-  i = i1 = tree1->postorder_list[0].sons;
-  j = j1 = tree2->postorder_list[0].sons;
+  i = i1 = d->tree1->postorder_list[0].sons;
+  j = j1 = d->tree2->postorder_list[0].sons;
 
 start:
-  li  = tree1->postorder_list[i].leftmostleaf;
-  lj  = tree2->postorder_list[j].leftmostleaf;
+  li  = d->tree1->postorder_list[i].leftmostleaf;
+  lj  = d->tree2->postorder_list[j].leftmostleaf;
 
 
   while ((i1 >= li) && (j1 >= lj)) {
-    lleaf_i1  = tree1->postorder_list[i1].leftmostleaf;
+    lleaf_i1  = d->tree1->postorder_list[i1].leftmostleaf;
     li1_1     = (li > lleaf_i1 - 1 ? 0 : lleaf_i1 - 1);
     i1_1      = (i1 == li ? 0 : i1 - 1);
-    lleaf_j1  = tree2->postorder_list[j1].leftmostleaf;
+    lleaf_j1  = d->tree2->postorder_list[j1].leftmostleaf;
     lj1_1     = (lj > lleaf_j1 - 1 ? 0 : lleaf_j1 - 1);
     j1_1      = (j1 == lj ? 0 : j1 - 1);
 
-    f = fdist[i1][j1];
+    f = d->fdist[i1][j1];
 
-    cost = edit_cost(i1, 0);
-    if (f == fdist[i1_1][j1] + cost) {
-      alignment[0][i1]  = 0;
-      i1                = i1_1;
+    cost = edit_cost(d, i1, 0);
+    if (f == d->fdist[i1_1][j1] + cost) {
+      d->alignment[0][i1] = 0;
+      i1                  = i1_1;
     } else {
-      if (f == fdist[i1][j1_1] + edit_cost(0, j1)) {
-        alignment[1][j1]  = 0;
-        j1                = j1_1;
+      if (f == d->fdist[i1][j1_1] + edit_cost(d, 0, j1)) {
+        d->alignment[1][j1] = 0;
+        j1                  = j1_1;
       } else if (lleaf_i1 == li && lleaf_j1 == lj) {
-        alignment[0][i1]  = j1;
-        alignment[1][j1]  = i1;
-        i1                = i1_1;
-        j1                = j1_1;
+        d->alignment[0][i1]  = j1;
+        d->alignment[1][j1]  = i1;
+        i1                   = i1_1;
+        j1                   = j1_1;
       } else {
         sector[ss].i    = i1;
         sector[ss++].j  = j1;
@@ -633,29 +647,29 @@ start:
     }
   }
   for (; i1 >= li; ) {
-    alignment[0][i1]  = 0;
-    i1                = (i1 == li ? 0 : i1 - 1);
+    d->alignment[0][i1] = 0;
+    i1                  = (i1 == li ? 0 : i1 - 1);
   }
   for (; j1 >= lj; ) {
-    alignment[1][j1]  = 0;
-    j1                = (j1 == lj ? 0 : j1 - 1);
+    d->alignment[1][j1] = 0;
+    j1                  = (j1 == lj ? 0 : j1 - 1);
   }
   while (ss > 0) {
     i1  = sector[--ss].i;
     j1  = sector[ss].j;
     for (k = 1; 1; k++) {
-      i = tree1->keyroots[k];
-      if (tree1->postorder_list[i].leftmostleaf ==
-          tree1->postorder_list[i1].leftmostleaf)
+      i = d->tree1->keyroots[k];
+      if (d->tree1->postorder_list[i].leftmostleaf ==
+          d->tree1->postorder_list[i1].leftmostleaf)
         break;
     }
     for (k = 1; 1; k++) {
-      j = tree2->keyroots[k];
-      if (tree2->postorder_list[j].leftmostleaf ==
-          tree2->postorder_list[j1].leftmostleaf)
+      j = d->tree2->keyroots[k];
+      if (d->tree2->postorder_list[j].leftmostleaf ==
+          d->tree2->postorder_list[j1].leftmostleaf)
         break;
     }
-    tree_dist(i, j);
+    tree_dist(d, i, j);
     goto start;
   }
 }
@@ -664,50 +678,50 @@ start:
 /*---------------------------------------------------------------------------*/
 
 PRIVATE void
-sprint_aligned_trees(void)
+sprint_aligned_trees(tree_edit_data *d)
 {
   int   i, j, n1, n2, k, l, p, ni, nj, weights;
   char  t1[2 * MNODES + 1], t2[2 * MNODES + 1], a1[8 * MNODES], a2[8 * MNODES], ll[20], ll1[20];
 
   weights = 0;
-  n1      = tree1->postorder_list[0].sons;
-  n2      = tree2->postorder_list[0].sons;
+  n1      = d->tree1->postorder_list[0].sons;
+  n2      = d->tree2->postorder_list[0].sons;
   for (i = 1; i <= n1; i++)
-    weights |= (tree1->postorder_list[i].weight != 1);
+    weights |= (d->tree1->postorder_list[i].weight != 1);
   for (i = 1; i <= n2; i++)
-    weights |= (tree2->postorder_list[i].weight != 1);
+    weights |= (d->tree2->postorder_list[i].weight != 1);
 
   for (i = n1, l = 2 * n1 - 1; i > 0; i--) {
-    if (alignment[0][i] != 0)
+    if (d->alignment[0][i] != 0)
       t1[l--] = ']';
     else
       t1[l--] = ')';
 
     p = i;
-    while (i == tree1->postorder_list[p].leftmostleaf) {
-      if (alignment[0][p] != 0)
+    while (i == d->tree1->postorder_list[p].leftmostleaf) {
+      if (d->alignment[0][p] != 0)
         t1[l--] = '[';
       else
         t1[l--] = '(';
 
-      p = tree1->postorder_list[p].father;
+      p = d->tree1->postorder_list[p].father;
     }
   }
   t1[2 * n1] = '\0';
   for (j = n2, l = 2 * n2 - 1; j > 0; j--) {
-    if (alignment[1][j] != 0)
+    if (d->alignment[1][j] != 0)
       t2[l--] = ']';
     else
       t2[l--] = ')';
 
     p = j;
-    while (j == tree2->postorder_list[p].leftmostleaf) {
-      if (alignment[1][p] != 0)
+    while (j == d->tree2->postorder_list[p].leftmostleaf) {
+      if (d->alignment[1][p] != 0)
         t2[l--] = '[';
       else
         t2[l--] = '(';
 
-      p = tree2->postorder_list[p].father;
+      p = d->tree2->postorder_list[p].father;
     }
   }
   t2[2 * n2] = '\0';
@@ -717,9 +731,9 @@ sprint_aligned_trees(void)
     while ((t1[i] == '(') || (t1[i] == ')')) {
       if (t1[i] == ')') {
         ni++;
-        encode(tree1->postorder_list[ni].type, ll);
+        encode(d->tree1->postorder_list[ni].type, ll);
         if (weights)
-          sprintf(ll + strlen(ll), "%d", tree1->postorder_list[ni].weight);
+          sprintf(ll + strlen(ll), "%d", d->tree1->postorder_list[ni].weight);
 
         for (k = 0; k < strlen(ll); k++) {
           a1[l]   = ll[k];
@@ -738,9 +752,9 @@ sprint_aligned_trees(void)
     while ((t2[j] == '(') || (t2[j] == ')')) {
       if (t2[j] == ')') {
         nj++;
-        encode(tree2->postorder_list[nj].type, ll);
+        encode(d->tree2->postorder_list[nj].type, ll);
         if (weights)
-          sprintf(ll + strlen(ll), "%d", tree2->postorder_list[nj].weight);
+          sprintf(ll + strlen(ll), "%d", d->tree2->postorder_list[nj].weight);
 
         for (k = 0; k < strlen(ll); k++) {
           a2[l]   = ll[k];
@@ -759,13 +773,13 @@ sprint_aligned_trees(void)
     if (t2[j] == ']') {
       ni++;
       nj++;
-      encode(tree2->postorder_list[nj].type, ll);
+      encode(d->tree2->postorder_list[nj].type, ll);
       if (weights)
-        sprintf(ll + strlen(ll), "%d", tree2->postorder_list[nj].weight);
+        sprintf(ll + strlen(ll), "%d", d->tree2->postorder_list[nj].weight);
 
-      encode(tree1->postorder_list[ni].type, ll1);
+      encode(d->tree1->postorder_list[ni].type, ll1);
       if (weights)
-        sprintf(ll1 + strlen(ll1), "%d", tree1->postorder_list[ni].weight);
+        sprintf(ll1 + strlen(ll1), "%d", d->tree1->postorder_list[ni].weight);
 
       if (strlen(ll) > strlen(ll1))
         for (k = 0; k < strlen(ll) - strlen(ll1); k++)
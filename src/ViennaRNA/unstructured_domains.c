@@ -90,6 +90,7 @@ struct ligands_up_data_default {
    * the production rule results
    **********************************
    */
+  int         *idx;           /* column-wise index for the energies_* matrices */
   int         *energies_ext;
   int         *energies_hp;
   int         *energies_int;
@@ -1732,6 +1733,9 @@ free_default_data_matrices(struct ligands_up_data_default *data)
 
   free(data->energies_mb);
   data->energies_mb = NULL;
+
+  free(data->idx);
+  data->idx = NULL;
 }
 
 
@@ -1927,6 +1931,12 @@ prepare_matrices(vrna_fold_compound_t           *vc,
 
   free_default_data_matrices(data);
 
+  /*
+   *  unpaired stretches may be longer than the maximum base pair span,
+   *  so we can not rely on the (possibly banded) jindx of the fold compound
+   */
+  data->idx = vrna_idx_col_wise(n);
+
   /* here we save memory by re-using DP matrices */
   unsigned int  lt[4] = {
     VRNA_UNSTRUCTURED_DOMAIN_EXT_LOOP,
@@ -2102,12 +2112,13 @@ default_prod_rule(vrna_fold_compound_t  *vc,
   int                             *energies_mb;
 
   n     = (int)vc->length;
-  idx   = vc->jindx;
   data  = (struct ligands_up_data_default *)d;
 
   prepare_default_data(vc, data);
   prepare_matrices(vc, data);
 
+  idx = data->idx;
+
   energies_ext  = data->energies_ext;
   energies_hp   = data->energies_hp;
   energies_int  = data->energies_int;
@@ -2321,11 +2332,12 @@ default_energy(vrna_fold_compound_t *vc,
                unsigned int         loop_type,
                void                 *d)
 {
-  int                             en, ij, *idx = vc->jindx;
+  int                             en, ij, *idx;
   struct ligands_up_data_default  *data = (struct ligands_up_data_default *)d;
 
-  en  = INF;
-  ij  = idx[j] + i;
+  idx = data->idx;
+
+  en = INF;
 
   if (j < i)
     return INF;
@@ -2339,7 +2351,9 @@ default_energy(vrna_fold_compound_t *vc,
       en = default_energy_int_motif(i, j, data);
     else if (loop_type & VRNA_UNSTRUCTURED_DOMAIN_MB_LOOP)
       en = default_energy_mb_motif(i, j, data);
-  } else {
+  } else if (idx) {
+    ij = idx[j] + i;
+
     if (loop_type & VRNA_UNSTRUCTURED_DOMAIN_EXT_LOOP) {
       if (data->energies_ext)
         en = data->energies_ext[ij];
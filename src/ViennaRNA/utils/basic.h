@@ -252,6 +252,26 @@ int *
 vrna_idx_row_wise(unsigned int length);
 
 
+/**
+ *  @brief Get a banded index mapper array (iindx) for accessing the partition function matrices of span-limited predictions
+ *
+ *  Access of a position "(i,j)" is accomplished by using @verbatim (i,j) ~ iindx[i]-j @endverbatim
+ *  just as for the index obtained from vrna_idx_row_wise(). However, each row @f$ i @f$ only stores
+ *  the entries for @f$ i - 1 \leq j \leq i + span + 1 @f$, such that the corresponding matrices
+ *  only require @f$ (length + 2) \cdot (span + 3) @f$ entries instead of a full triangle.
+ *
+ *  @warning Entries @f$ (i,j) @f$ outside of the band are mapped onto entries of other rows!
+ *
+ *  @see vrna_idx_row_wise(), vrna_idx_col_wise_banded()
+ *  @param length The length of the RNA sequence
+ *  @param span   The maximum distance @f$ j - i @f$ between two positions that needs to be addressable
+ *  @return       The mapper array
+ */
+int *
+vrna_idx_row_wise_banded(unsigned int length,
+                         unsigned int span);
+
+
 /**
  *  @brief Get an index mapper array (indx) for accessing the energy matrices, e.g. in MFE related functions.
  *
@@ -270,6 +290,26 @@ int *
 vrna_idx_col_wise(unsigned int length);
 
 
+/**
+ *  @brief Get a banded index mapper array (indx) for accessing the energy matrices of span-limited predictions
+ *
+ *  Access of a position "(i,j)" is accomplished by using @verbatim (i,j) ~ indx[j]+i @endverbatim
+ *  just as for the index obtained from vrna_idx_col_wise(). However, each column @f$ j @f$ only stores
+ *  the entries for @f$ j - span - 1 \leq i \leq j + 1 @f$, such that the corresponding matrices
+ *  only require @f$ (length + 1) \cdot (span + 3) @f$ entries instead of a full triangle.
+ *
+ *  @warning Entries @f$ (i,j) @f$ outside of the band are mapped onto entries of other columns!
+ *
+ *  @see vrna_idx_col_wise()
+ *  @param length The length of the RNA sequence
+ *  @param span   The maximum distance @f$ j - i @f$ between two positions that needs to be addressable
+ *  @return       The mapper array
+ */
+int *
+vrna_idx_col_wise_banded(unsigned int length,
+                         unsigned int span);
+
+
 /**
  *  @}
  */
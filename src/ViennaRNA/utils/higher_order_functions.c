@@ -15,6 +15,22 @@ typedef int (proto_fun_zip_reduce)(const int  *a,
                                    int        size);
 
 
+typedef int (proto_fun_zip3_reduce)(const int *a,
+                                    const int *b,
+                                    const int *c,
+                                    int       size);
+
+
+typedef FLT_OR_DBL (proto_fun_zip_reduce_fp)(const FLT_OR_DBL *a,
+                                             const FLT_OR_DBL *b,
+                                             int              size);
+
+
+typedef float (proto_fun_zip_reduce_flt)(const float  *a,
+                                         const float  *b,
+                                         int          size);
+
+
 /*
  #################################
  # PRIVATE FUNCTION DECLARATIONS #
@@ -25,12 +41,69 @@ static int zip_add_min_dispatcher(const int *a,
                                   int       size);
 
 
+static int zip3_add_min_dispatcher(const int  *a,
+                                   const int  *b,
+                                   const int  *c,
+                                   int        size);
+
+
+static FLT_OR_DBL zip_mul_add_sum_dispatcher(const FLT_OR_DBL *a,
+                                             const FLT_OR_DBL *b,
+                                             int              size);
+
+
+static FLT_OR_DBL zip_mul_add_sum_rev_dispatcher(const FLT_OR_DBL  *a,
+                                                 const FLT_OR_DBL  *b,
+                                                 int               size);
+
+
+static float zip_mul_add_sum_flt_dispatcher(const float *a,
+                                            const float *b,
+                                            int         size);
+
+
+static float zip_mul_add_sum_rev_flt_dispatcher(const float *a,
+                                                const float *b,
+                                                int         size);
+
+
 static int
 fun_zip_add_min_default(const int *e1,
                         const int *e2,
                         int       count);
 
 
+static int
+fun_zip3_add_min_default(const int  *e1,
+                         const int  *e2,
+                         const int  *e3,
+                         int        count);
+
+
+static FLT_OR_DBL
+fun_zip_mul_add_sum_default(const FLT_OR_DBL  *e1,
+                            const FLT_OR_DBL  *e2,
+                            int               count);
+
+
+static FLT_OR_DBL
+fun_zip_mul_add_sum_rev_default(const FLT_OR_DBL  *e1,
+                                const FLT_OR_DBL  *e2,
+                                int               count);
+
+
+static float
+fun_zip_mul_add_sum_flt_default(const float *e1,
+                                const float *e2,
+                                int         count);
+
+
+static float
+fun_zip_mul_add_sum_rev_flt_default(const float *e1,
+                                    const float *e2,
+                                    int         count);
+
+
 #if VRNA_WITH_SIMD_AVX512
 int
 vrna_fun_zip_add_min_avx512(const int *e1,
@@ -38,19 +111,135 @@ vrna_fun_zip_add_min_avx512(const int *e1,
                             int       count);
 
 
+int
+vrna_fun_zip3_add_min_avx512(const int *e1,
+                             const int *e2,
+                             const int *e3,
+                             int       count);
+
+
+#ifndef USE_FLOAT_PF
+double
+vrna_fun_zip_mul_add_sum_avx512(const double  *e1,
+                                const double  *e2,
+                                int           count);
+
+
+double
+vrna_fun_zip_mul_add_sum_rev_avx512(const double  *e1,
+                                    const double  *e2,
+                                    int           count);
+
+
+#endif
+
+float
+vrna_fun_zip_mul_add_sum_flt_avx512(const float *e1,
+                                    const float *e2,
+                                    int         count);
+
+
+float
+vrna_fun_zip_mul_add_sum_rev_flt_avx512(const float *e1,
+                                        const float *e2,
+                                        int         count);
+
+
+#endif
+
+#if VRNA_WITH_SIMD_AVX2
+int
+vrna_fun_zip_add_min_avx2(const int *e1,
+                          const int *e2,
+                          int       count);
+
+
+int
+vrna_fun_zip3_add_min_avx2(const int *e1,
+                           const int *e2,
+                           const int *e3,
+                           int       count);
+
+
+#ifndef USE_FLOAT_PF
+double
+vrna_fun_zip_mul_add_sum_avx2(const double  *e1,
+                              const double  *e2,
+                              int           count);
+
+
+double
+vrna_fun_zip_mul_add_sum_rev_avx2(const double  *e1,
+                                  const double  *e2,
+                                  int           count);
+
+
+#endif
+
+float
+vrna_fun_zip_mul_add_sum_flt_avx2(const float *e1,
+                                  const float *e2,
+                                  int         count);
+
+
+float
+vrna_fun_zip_mul_add_sum_rev_flt_avx2(const float *e1,
+                                      const float *e2,
+                                      int         count);
+
+
 #endif
 
 #if VRNA_WITH_SIMD_SSE41
 int
-vrna_fun_zip_add_min_sse41(const int  *e1,
-                           const int  *e2,
-                           int        count);
+vrna_fun_zip_add_min_sse41(const int *e1,
+                           const int *e2,
+                           int       count);
+
+
+int
+vrna_fun_zip3_add_min_sse41(const int *e1,
+                            const int *e2,
+                            const int *e3,
+                            int       count);
+
+
+#ifndef USE_FLOAT_PF
+double
+vrna_fun_zip_mul_add_sum_sse41(const double  *e1,
+                               const double  *e2,
+                               int           count);
+
+
+double
+vrna_fun_zip_mul_add_sum_rev_sse41(const double  *e1,
+                                   const double  *e2,
+                                   int           count);
 
 
 #endif
 
+float
+vrna_fun_zip_mul_add_sum_flt_sse41(const float *e1,
+                                   const float *e2,
+                                   int         count);
 
-static proto_fun_zip_reduce *fun_zip_add_min = &zip_add_min_dispatcher;
+
+float
+vrna_fun_zip_mul_add_sum_rev_flt_sse41(const float *e1,
+                                       const float *e2,
+                                       int         count);
+
+
+#endif
+
+
+static proto_fun_zip_reduce      *fun_zip_add_min             = &zip_add_min_dispatcher;
+static proto_fun_zip3_reduce     *fun_zip3_add_min            = &zip3_add_min_dispatcher;
+static proto_fun_zip_reduce_fp   *fun_zip_mul_add_sum         = &zip_mul_add_sum_dispatcher;
+static proto_fun_zip_reduce_fp   *fun_zip_mul_add_sum_rev     = &zip_mul_add_sum_rev_dispatcher;
+static proto_fun_zip_reduce_flt  *fun_zip_mul_add_sum_flt     = &zip_mul_add_sum_flt_dispatcher;
+static proto_fun_zip_reduce_flt  *fun_zip_mul_add_sum_rev_flt = &zip_mul_add_sum_rev_flt_dispatcher;
 
 
 /*
@@ -61,14 +250,24 @@ static proto_fun_zip_reduce *fun_zip_add_min = &zip_add_min_dispatcher;
 PUBLIC void
 vrna_fun_dispatch_disable(void)
 {
-  fun_zip_add_min = &fun_zip_add_min_default;
+  fun_zip_add_min             = &fun_zip_add_min_default;
+  fun_zip3_add_min            = &fun_zip3_add_min_default;
+  fun_zip_mul_add_sum         = &fun_zip_mul_add_sum_default;
+  fun_zip_mul_add_sum_rev     = &fun_zip_mul_add_sum_rev_default;
+  fun_zip_mul_add_sum_flt     = &fun_zip_mul_add_sum_flt_default;
+  fun_zip_mul_add_sum_rev_flt = &fun_zip_mul_add_sum_rev_flt_default;
 }
 
 
 PUBLIC void
 vrna_fun_dispatch_enable(void)
 {
-  fun_zip_add_min = &zip_add_min_dispatcher;
+  fun_zip_add_min             = &zip_add_min_dispatcher;
+  fun_zip3_add_min            = &zip3_add_min_dispatcher;
+  fun_zip_mul_add_sum         = &zip_mul_add_sum_dispatcher;
+  fun_zip_mul_add_sum_rev     = &zip_mul_add_sum_rev_dispatcher;
+  fun_zip_mul_add_sum_flt     = &zip_mul_add_sum_flt_dispatcher;
+  fun_zip_mul_add_sum_rev_flt = &zip_mul_add_sum_rev_flt_dispatcher;
 }
 
 
@@ -81,6 +280,52 @@ vrna_fun_zip_add_min(const int  *e1,
 }
 
 
+PUBLIC int
+vrna_fun_zip3_add_min(const int *e1,
+                      const int *e2,
+                      const int *e3,
+                      int       count)
+{
+  return (*fun_zip3_add_min)(e1, e2, e3, count);
+}
+
+
+PUBLIC FLT_OR_DBL
+vrna_fun_zip_mul_add_sum(const FLT_OR_DBL *e1,
+                         const FLT_OR_DBL *e2,
+                         int              count)
+{
+  return (*fun_zip_mul_add_sum)(e1, e2, count);
+}
+
+
+PUBLIC FLT_OR_DBL
+vrna_fun_zip_mul_add_sum_rev(const FLT_OR_DBL *e1,
+                             const FLT_OR_DBL *e2,
+                             int              count)
+{
+  return (*fun_zip_mul_add_sum_rev)(e1, e2, count);
+}
+
+
+PUBLIC float
+vrna_fun_zip_mul_add_sum_flt(const float  *e1,
+                             const float  *e2,
+                             int          count)
+{
+  return (*fun_zip_mul_add_sum_flt)(e1, e2, count);
+}
+
+
+PUBLIC float
+vrna_fun_zip_mul_add_sum_rev_flt(const float  *e1,
+                                 const float  *e2,
+                                 int          count)
+{
+  return (*fun_zip_mul_add_sum_rev_flt)(e1, e2, count);
+}
+
+
 /*
  #################################
  # STATIC helper functions below #
@@ -103,6 +348,14 @@ zip_add_min_dispatcher(const int  *a,
 
 #endif
 
+#if VRNA_WITH_SIMD_AVX2
+  if (features & VRNA_CPU_SIMD_AVX2) {
+    fun_zip_add_min = &vrna_fun_zip_add_min_avx2;
+    goto exec_fun_zip_add_min;
+  }
+
+#endif
+
 #if VRNA_WITH_SIMD_SSE41
   if (features & VRNA_CPU_SIMD_SSE41) {
     fun_zip_add_min = &vrna_fun_zip_add_min_sse41;
@@ -119,6 +372,215 @@ exec_fun_zip_add_min:
 }
 
 
+/* zip3_add_min() dispatcher */
+static int
+zip3_add_min_dispatcher(const int *a,
+                        const int *b,
+                        const int *c,
+                        int       size)
+{
+  unsigned int features = vrna_cpu_simd_capabilities();
+
+#if VRNA_WITH_SIMD_AVX512
+  if (features & VRNA_CPU_SIMD_AVX512F) {
+    fun_zip3_add_min = &vrna_fun_zip3_add_min_avx512;
+    goto exec_fun_zip3_add_min;
+  }
+
+#endif
+
+#if VRNA_WITH_SIMD_AVX2
+  if (features & VRNA_CPU_SIMD_AVX2) {
+    fun_zip3_add_min = &vrna_fun_zip3_add_min_avx2;
+    goto exec_fun_zip3_add_min;
+  }
+
+#endif
+
+#if VRNA_WITH_SIMD_SSE41
+  if (features & VRNA_CPU_SIMD_SSE41) {
+    fun_zip3_add_min = &vrna_fun_zip3_add_min_sse41;
+    goto exec_fun_zip3_add_min;
+  }
+
+#endif
+
+  fun_zip3_add_min = &fun_zip3_add_min_default;
+
+exec_fun_zip3_add_min:
+
+  return (*fun_zip3_add_min)(a, b, c, size);
+}
+
+
+/* zip_mul_add_sum() dispatcher */
+static FLT_OR_DBL
+zip_mul_add_sum_dispatcher(const FLT_OR_DBL *a,
+                           const FLT_OR_DBL *b,
+                           int              size)
+{
+#ifndef USE_FLOAT_PF
+  unsigned int features = vrna_cpu_simd_capabilities();
+
+#if VRNA_WITH_SIMD_AVX512
+  if (features & VRNA_CPU_SIMD_AVX512F) {
+    fun_zip_mul_add_sum = &vrna_fun_zip_mul_add_sum_avx512;
+    goto exec_fun_zip_mul_add_sum;
+  }
+
+#endif
+
+#if VRNA_WITH_SIMD_AVX2
+  if (features & VRNA_CPU_SIMD_AVX2) {
+    fun_zip_mul_add_sum = &vrna_fun_zip_mul_add_sum_avx2;
+    goto exec_fun_zip_mul_add_sum;
+  }
+
+#endif
+
+#if VRNA_WITH_SIMD_SSE41
+  if (features & VRNA_CPU_SIMD_SSE41) {
+    fun_zip_mul_add_sum = &vrna_fun_zip_mul_add_sum_sse41;
+    goto exec_fun_zip_mul_add_sum;
+  }
+
+#endif
+#endif
+
+  fun_zip_mul_add_sum = &fun_zip_mul_add_sum_default;
+
+#ifndef USE_FLOAT_PF
+exec_fun_zip_mul_add_sum:
+#endif
+
+  return (*fun_zip_mul_add_sum)(a, b, size);
+}
+
+
+/* zip_mul_add_sum_rev() dispatcher */
+static FLT_OR_DBL
+zip_mul_add_sum_rev_dispatcher(const FLT_OR_DBL *a,
+                               const FLT_OR_DBL *b,
+                               int              size)
+{
+#ifndef USE_FLOAT_PF
+  unsigned int features = vrna_cpu_simd_capabilities();
+
+#if VRNA_WITH_SIMD_AVX512
+  if (features & VRNA_CPU_SIMD_AVX512F) {
+    fun_zip_mul_add_sum_rev = &vrna_fun_zip_mul_add_sum_rev_avx512;
+    goto exec_fun_zip_mul_add_sum_rev;
+  }
+
+#endif
+
+#if VRNA_WITH_SIMD_AVX2
+  if (features & VRNA_CPU_SIMD_AVX2) {
+    fun_zip_mul_add_sum_rev = &vrna_fun_zip_mul_add_sum_rev_avx2;
+    goto exec_fun_zip_mul_add_sum_rev;
+  }
+
+#endif
+
+#if VRNA_WITH_SIMD_SSE41
+  if (features & VRNA_CPU_SIMD_SSE41) {
+    fun_zip_mul_add_sum_rev = &vrna_fun_zip_mul_add_sum_rev_sse41;
+    goto exec_fun_zip_mul_add_sum_rev;
+  }
+
+#endif
+#endif
+
+  fun_zip_mul_add_sum_rev = &fun_zip_mul_add_sum_rev_default;
+
+#ifndef USE_FLOAT_PF
+exec_fun_zip_mul_add_sum_rev:
+#endif
+
+  return (*fun_zip_mul_add_sum_rev)(a, b, size);
+}
+
+
+/* zip_mul_add_sum_flt() dispatcher */
+static float
+zip_mul_add_sum_flt_dispatcher(const float *a,
+                               const float *b,
+                               int         size)
+{
+  unsigned int features = vrna_cpu_simd_capabilities();
+
+#if VRNA_WITH_SIMD_AVX512
+  if (features & VRNA_CPU_SIMD_AVX512F) {
+    fun_zip_mul_add_sum_flt = &vrna_fun_zip_mul_add_sum_flt_avx512;
+    goto exec_fun_zip_mul_add_sum_flt;
+  }
+
+#endif
+
+#if VRNA_WITH_SIMD_AVX2
+  if (features & VRNA_CPU_SIMD_AVX2) {
+    fun_zip_mul_add_sum_flt = &vrna_fun_zip_mul_add_sum_flt_avx2;
+    goto exec_fun_zip_mul_add_sum_flt;
+  }
+
+#endif
+
+#if VRNA_WITH_SIMD_SSE41
+  if (features & VRNA_CPU_SIMD_SSE41) {
+    fun_zip_mul_add_sum_flt = &vrna_fun_zip_mul_add_sum_flt_sse41;
+    goto exec_fun_zip_mul_add_sum_flt;
+  }
+
+#endif
+
+  fun_zip_mul_add_sum_flt = &fun_zip_mul_add_sum_flt_default;
+
+exec_fun_zip_mul_add_sum_flt:
+
+  return (*fun_zip_mul_add_sum_flt)(a, b, size);
+}
+
+
+/* zip_mul_add_sum_rev_flt() dispatcher */
+static float
+zip_mul_add_sum_rev_flt_dispatcher(const float *a,
+                                   const float *b,
+                                   int         size)
+{
+  unsigned int features = vrna_cpu_simd_capabilities();
+
+#if VRNA_WITH_SIMD_AVX512
+  if (features & VRNA_CPU_SIMD_AVX512F) {
+    fun_zip_mul_add_sum_rev_flt = &vrna_fun_zip_mul_add_sum_rev_flt_avx512;
+    goto exec_fun_zip_mul_add_sum_rev_flt;
+  }
+
+#endif
+
+#if VRNA_WITH_SIMD_AVX2
+  if (features & VRNA_CPU_SIMD_AVX2) {
+    fun_zip_mul_add_sum_rev_flt = &vrna_fun_zip_mul_add_sum_rev_flt_avx2;
+    goto exec_fun_zip_mul_add_sum_rev_flt;
+  }
+
+#endif
+
+#if VRNA_WITH_SIMD_SSE41
+  if (features & VRNA_CPU_SIMD_SSE41) {
+    fun_zip_mul_add_sum_rev_flt = &vrna_fun_zip_mul_add_sum_rev_flt_sse41;
+    goto exec_fun_zip_mul_add_sum_rev_flt;
+  }
+
+#endif
+
+  fun_zip_mul_add_sum_rev_flt = &fun_zip_mul_add_sum_rev_flt_default;
+
+exec_fun_zip_mul_add_sum_rev_flt:
+
+  return (*fun_zip_mul_add_sum_rev_flt)(a, b, size);
+}
+
+
 static int
 fun_zip_add_min_default(const int *e1,
                         const int *e2,
@@ -136,3 +598,132 @@ fun_zip_add_min_default(const int *e1,
 
   return decomp;
 }
+
+
+static int
+fun_zip3_add_min_default(const int  *e1,
+                         const int  *e2,
+                         const int  *e3,
+                         int        count)
+{
+  int i;
+  int decomp = INF;
+
+  for (i = 0; i < count; i++) {
+    if ((e1[i] != INF) && (e2[i] != INF) && (e3[i] != INF)) {
+      const int en = e1[i] + e2[i] + e3[i];
+      decomp = MIN2(decomp, en);
+    }
+  }
+
+  return decomp;
+}
+
+
+/*
+ *  Accumulate into 8 independent partial sums that are combined in a
+ *  fixed order afterwards. The SIMD implementations follow the exact
+ *  same scheme, so all of them return bitwise identical results.
+ */
+static FLT_OR_DBL
+fun_zip_mul_add_sum_default(const FLT_OR_DBL  *e1,
+                            const FLT_OR_DBL  *e2,
+                            int               count)
+{
+  int         i, l;
+  FLT_OR_DBL  acc[8], sum;
+
+  for (l = 0; l < 8; l++)
+    acc[l] = 0.;
+
+  for (i = 0; i < count - 7; i += 8)
+    for (l = 0; l < 8; l++)
+      acc[l] += e1[i + l] * e2[i + l];
+
+  sum = ((acc[0] + acc[4]) + (acc[2] + acc[6])) +
+        ((acc[1] + acc[5]) + (acc[3] + acc[7]));
+
+  for (; i < count; i++)
+    sum += e1[i] * e2[i];
+
+  return sum;
+}
+
+
+static FLT_OR_DBL
+fun_zip_mul_add_sum_rev_default(const FLT_OR_DBL  *e1,
+                                const FLT_OR_DBL  *e2,
+                                int               count)
+{
+  int         i, l;
+  FLT_OR_DBL  acc[8], sum;
+
+  for (l = 0; l < 8; l++)
+    acc[l] = 0.;
+
+  for (i = 0; i < count - 7; i += 8)
+    for (l = 0; l < 8; l++)
+      acc[l] += e1[i + l] * e2[count - 1 - i - l];
+
+  sum = ((acc[0] + acc[4]) + (acc[2] + acc[6])) +
+        ((acc[1] + acc[5]) + (acc[3] + acc[7]));
+
+  for (; i < count; i++)
+    sum += e1[i] * e2[count - 1 - i];
+
+  return sum;
+}
+
+
+/*
+ *  Single precision variant of fun_zip_mul_add_sum_default() with
+ *  16 independent partial sums, i.e. twice the number of lanes
+ */
+static float
+fun_zip_mul_add_sum_flt_default(const float *e1,
+                                const float *e2,
+                                int         count)
+{
+  int   i, l;
+  float acc[16], sum;
+
+  for (l = 0; l < 16; l++)
+    acc[l] = 0.;
+
+  for (i = 0; i < count - 15; i += 16)
+    for (l = 0; l < 16; l++)
+      acc[l] += e1[i + l] * e2[i + l];
+
+  sum = (((acc[0] + acc[8]) + (acc[4] + acc[12])) + ((acc[2] + acc[10]) + (acc[6] + acc[14]))) +
+        (((acc[1] + acc[9]) + (acc[5] + acc[13])) + ((acc[3] + acc[11]) + (acc[7] + acc[15])));
+
+  for (; i < count; i++)
+    sum += e1[i] * e2[i];
+
+  return sum;
+}
+
+
+static float
+fun_zip_mul_add_sum_rev_flt_default(const float *e1,
+                                    const float *e2,
+                                    int         count)
+{
+  int   i, l;
+  float acc[16], sum;
+
+  for (l = 0; l < 16; l++)
+    acc[l] = 0.;
+
+  for (i = 0; i < count - 15; i += 16)
+    for (l = 0; l < 16; l++)
+      acc[l] += e1[i + l] * e2[count - 1 - i - l];
+
+  sum = (((acc[0] + acc[8]) + (acc[4] + acc[12])) + ((acc[2] + acc[10]) + (acc[6] + acc[14]))) +
+        (((acc[1] + acc[9]) + (acc[5] + acc[13])) + ((acc[3] + acc[11]) + (acc[7] + acc[15])));
+
+  for (; i < count; i++)
+    sum += e1[i] * e2[count - 1 - i];
+
+  return sum;
+}
@@ -1,6 +1,8 @@
 #ifndef VIENNA_RNA_PACKAGE_UTILS_FUN_H
 #define VIENNA_RNA_PACKAGE_UTILS_FUN_H
 
+#include <ViennaRNA/datastructures/basic.h>
+
 void
 vrna_fun_dispatch_disable(void);
 
@@ -15,4 +17,54 @@ vrna_fun_zip_add_min(const int  *e1,
                      int        count);
 
 
+/*
+ *  Minimum of e1[i] + e2[i] + e3[i], skipping all i where any
+ *  operand is INF. Useful for decompositions with per-split
+ *  bonus terms, e.g. soft constraints
+ */
+int
+vrna_fun_zip3_add_min(const int *e1,
+                      const int *e2,
+                      const int *e3,
+                      int       count);
+
+
+/*
+ *  Sum of products e1[i] * e2[i]. The summation order is fixed
+ *  and identical for all implementations, i.e. the result does not
+ *  depend on the SIMD extensions available at runtime
+ */
+FLT_OR_DBL
+vrna_fun_zip_mul_add_sum(const FLT_OR_DBL *e1,
+                         const FLT_OR_DBL *e2,
+                         int              count);
+
+
+/*
+ *  Same as vrna_fun_zip_mul_add_sum() but with e2 traversed in
+ *  reverse order, i.e. the sum of products e1[i] * e2[count - 1 - i]
+ */
+FLT_OR_DBL
+vrna_fun_zip_mul_add_sum_rev(const FLT_OR_DBL *e1,
+                             const FLT_OR_DBL *e2,
+                             int              count);
+
+
+/*
+ *  Single precision variants of vrna_fun_zip_mul_add_sum() and
+ *  vrna_fun_zip_mul_add_sum_rev(). These use 16 partial sums, i.e.
+ *  twice as many SIMD lanes as their double precision counterparts
+ */
+float
+vrna_fun_zip_mul_add_sum_flt(const float  *e1,
+                             const float  *e2,
+                             int          count);
+
+
+float
+vrna_fun_zip_mul_add_sum_rev_flt(const float  *e1,
+                                 const float  *e2,
+                                 int          count);
+
+
 #endif
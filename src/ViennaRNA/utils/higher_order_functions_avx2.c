@@ -0,0 +1,254 @@
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "ViennaRNA/utils/basic.h"
+
+#include <immintrin.h>
+
+static int
+horizontal_min_Vec8i(__m256i x);
+
+
+PUBLIC int
+vrna_fun_zip_add_min_avx2(const int *e1,
+                          const int *e2,
+                          int       count)
+{
+  int     i       = 0;
+  int     decomp  = INF;
+
+  __m256i inf = _mm256_set1_epi32(INF);
+  __m256i res = inf;
+
+  for (i = 0; i < count - 7; i += 8) {
+    __m256i a = _mm256_loadu_si256((__m256i *)&e1[i]);
+    __m256i b = _mm256_loadu_si256((__m256i *)&e2[i]);
+
+    /* create mask for non-INF values */
+    __m256i mask = _mm256_and_si256(_mm256_cmpgt_epi32(inf, a),
+                                    _mm256_cmpgt_epi32(inf, b));
+
+    /* replace sums with INF where a or b has been INF before */
+    __m256i c = _mm256_blendv_epi8(inf, _mm256_add_epi32(a, b), mask);
+
+    res = _mm256_min_epi32(res, c);
+  }
+
+  decomp = horizontal_min_Vec8i(res);
+
+  for (; i < count; i++) {
+    if ((e1[i] != INF) && (e2[i] != INF)) {
+      const int en = e1[i] + e2[i];
+      decomp = MIN2(decomp, en);
+    }
+  }
+
+  return decomp;
+}
+
+
+PUBLIC int
+vrna_fun_zip3_add_min_avx2(const int  *e1,
+                           const int  *e2,
+                           const int  *e3,
+                           int        count)
+{
+  int     i       = 0;
+  int     decomp  = INF;
+
+  __m256i inf = _mm256_set1_epi32(INF);
+  __m256i res = inf;
+
+  for (i = 0; i < count - 7; i += 8) {
+    __m256i a = _mm256_loadu_si256((__m256i *)&e1[i]);
+    __m256i b = _mm256_loadu_si256((__m256i *)&e2[i]);
+    __m256i c = _mm256_loadu_si256((__m256i *)&e3[i]);
+
+    __m256i mask = _mm256_and_si256(_mm256_and_si256(_mm256_cmpgt_epi32(inf, a),
+                                                     _mm256_cmpgt_epi32(inf, b)),
+                                    _mm256_cmpgt_epi32(inf, c));
+
+    __m256i d = _mm256_blendv_epi8(inf,
+                                   _mm256_add_epi32(_mm256_add_epi32(a, b), c),
+                                   mask);
+
+    res = _mm256_min_epi32(res, d);
+  }
+
+  decomp = horizontal_min_Vec8i(res);
+
+  for (; i < count; i++) {
+    if ((e1[i] != INF) && (e2[i] != INF) && (e3[i] != INF)) {
+      const int en = e1[i] + e2[i] + e3[i];
+      decomp = MIN2(decomp, en);
+    }
+  }
+
+  return decomp;
+}
+
+
+#ifndef USE_FLOAT_PF
+
+/*
+ *  The summation order corresponds to 8 independent partial sums
+ *  that are combined in a fixed order. This is exactly what the
+ *  default, SSE4.1, and AVX512 implementations do, so all of them
+ *  yield identical results
+ */
+PUBLIC double
+vrna_fun_zip_mul_add_sum_avx2(const double  *e1,
+                              const double  *e2,
+                              int           count)
+{
+  int     i = 0;
+  double  acc[8], sum;
+
+  __m256d acc0  = _mm256_setzero_pd();
+  __m256d acc1  = _mm256_setzero_pd();
+
+  for (i = 0; i < count - 7; i += 8) {
+    acc0  = _mm256_add_pd(acc0,
+                          _mm256_mul_pd(_mm256_loadu_pd(&e1[i]),
+                                        _mm256_loadu_pd(&e2[i])));
+    acc1 = _mm256_add_pd(acc1,
+                         _mm256_mul_pd(_mm256_loadu_pd(&e1[i + 4]),
+                                       _mm256_loadu_pd(&e2[i + 4])));
+  }
+
+  _mm256_storeu_pd(&acc[0], acc0);
+  _mm256_storeu_pd(&acc[4], acc1);
+
+  sum = ((acc[0] + acc[4]) + (acc[2] + acc[6])) +
+        ((acc[1] + acc[5]) + (acc[3] + acc[7]));
+
+  for (; i < count; i++)
+    sum += e1[i] * e2[i];
+
+  return sum;
+}
+
+
+PUBLIC double
+vrna_fun_zip_mul_add_sum_rev_avx2(const double  *e1,
+                                  const double  *e2,
+                                  int           count)
+{
+  int     i = 0;
+  double  acc[8], sum;
+
+  __m256d acc0  = _mm256_setzero_pd();
+  __m256d acc1  = _mm256_setzero_pd();
+
+  for (i = 0; i < count - 7; i += 8) {
+    /* load e2 in reverse order */
+    __m256d b0  = _mm256_permute4x64_pd(_mm256_loadu_pd(&e2[count - i - 4]), 0x1B);
+    __m256d b1  = _mm256_permute4x64_pd(_mm256_loadu_pd(&e2[count - i - 8]), 0x1B);
+
+    acc0  = _mm256_add_pd(acc0, _mm256_mul_pd(_mm256_loadu_pd(&e1[i]), b0));
+    acc1  = _mm256_add_pd(acc1, _mm256_mul_pd(_mm256_loadu_pd(&e1[i + 4]), b1));
+  }
+
+  _mm256_storeu_pd(&acc[0], acc0);
+  _mm256_storeu_pd(&acc[4], acc1);
+
+  sum = ((acc[0] + acc[4]) + (acc[2] + acc[6])) +
+        ((acc[1] + acc[5]) + (acc[3] + acc[7]));
+
+  for (; i < count; i++)
+    sum += e1[i] * e2[count - 1 - i];
+
+  return sum;
+}
+
+
+#endif
+
+
+/*
+ *  16 independent partial sums combined in a fixed order,
+ *  see vrna_fun_zip_mul_add_sum_flt()
+ */
+PUBLIC float
+vrna_fun_zip_mul_add_sum_flt_avx2(const float *e1,
+                                  const float *e2,
+                                  int         count)
+{
+  int   i = 0;
+  float acc[16], sum;
+
+  __m256  acc0  = _mm256_setzero_ps();
+  __m256  acc1  = _mm256_setzero_ps();
+
+  for (i = 0; i < count - 15; i += 16) {
+    acc0  = _mm256_add_ps(acc0,
+                          _mm256_mul_ps(_mm256_loadu_ps(&e1[i]),
+                                        _mm256_loadu_ps(&e2[i])));
+    acc1 = _mm256_add_ps(acc1,
+                         _mm256_mul_ps(_mm256_loadu_ps(&e1[i + 8]),
+                                       _mm256_loadu_ps(&e2[i + 8])));
+  }
+
+  _mm256_storeu_ps(&acc[0], acc0);
+  _mm256_storeu_ps(&acc[8], acc1);
+
+  sum = (((acc[0] + acc[8]) + (acc[4] + acc[12])) + ((acc[2] + acc[10]) + (acc[6] + acc[14]))) +
+        (((acc[1] + acc[9]) + (acc[5] + acc[13])) + ((acc[3] + acc[11]) + (acc[7] + acc[15])));
+
+  for (; i < count; i++)
+    sum += e1[i] * e2[i];
+
+  return sum;
+}
+
+
+PUBLIC float
+vrna_fun_zip_mul_add_sum_rev_flt_avx2(const float *e1,
+                                      const float *e2,
+                                      int         count)
+{
+  int   i = 0;
+  float acc[16], sum;
+
+  __m256  acc0  = _mm256_setzero_ps();
+  __m256  acc1  = _mm256_setzero_ps();
+  __m256i rev   = _mm256_set_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+
+  for (i = 0; i < count - 15; i += 16) {
+    /* load e2 in reverse order */
+    __m256  b0  = _mm256_permutevar8x32_ps(_mm256_loadu_ps(&e2[count - i - 8]), rev);
+    __m256  b1  = _mm256_permutevar8x32_ps(_mm256_loadu_ps(&e2[count - i - 16]), rev);
+
+    acc0  = _mm256_add_ps(acc0, _mm256_mul_ps(_mm256_loadu_ps(&e1[i]), b0));
+    acc1  = _mm256_add_ps(acc1, _mm256_mul_ps(_mm256_loadu_ps(&e1[i + 8]), b1));
+  }
+
+  _mm256_storeu_ps(&acc[0], acc0);
+  _mm256_storeu_ps(&acc[8], acc1);
+
+  sum = (((acc[0] + acc[8]) + (acc[4] + acc[12])) + ((acc[2] + acc[10]) + (acc[6] + acc[14]))) +
+        (((acc[1] + acc[9]) + (acc[5] + acc[13])) + ((acc[3] + acc[11]) + (acc[7] + acc[15])));
+
+  for (; i < count; i++)
+    sum += e1[i] * e2[count - 1 - i];
+
+  return sum;
+}
+
+
+/* AVX2 minimum of 8 packed 32bit integers */
+static int
+horizontal_min_Vec8i(__m256i x)
+{
+  __m128i min1  = _mm_min_epi32(_mm256_castsi256_si128(x),
+                                _mm256_extracti128_si256(x, 1));
+  __m128i min2  = _mm_min_epi32(min1, _mm_shuffle_epi32(min1, _MM_SHUFFLE(0, 0, 3, 2)));
+  __m128i min3  = _mm_min_epi32(min2, _mm_shuffle_epi32(min2, _MM_SHUFFLE(0, 0, 0, 1)));
+
+  return _mm_cvtsi128_si32(min3);
+}
@@ -48,3 +48,169 @@ vrna_fun_zip_add_min_avx512(const int *e1,
 
   return decomp;
 }
+
+
+PUBLIC int
+vrna_fun_zip3_add_min_avx512(const int  *e1,
+                             const int  *e2,
+                             const int  *e3,
+                             int        count)
+{
+  int     i       = 0;
+  int     decomp  = INF;
+
+  __m512i inf = _mm512_set1_epi32(INF);
+  __m512i res = inf;
+
+  for (i = 0; i < count - 15; i += 16) {
+    __m512i   a = _mm512_loadu_si512((__m512i *)&e1[i]);
+    __m512i   b = _mm512_loadu_si512((__m512i *)&e2[i]);
+    __m512i   c = _mm512_loadu_si512((__m512i *)&e3[i]);
+
+    /* compute mask for entries where a, b, and c are less than INF */
+    __mmask16 mask = _kand_mask16(_kand_mask16(_mm512_cmplt_epi32_mask(a, inf),
+                                               _mm512_cmplt_epi32_mask(b, inf)),
+                                  _mm512_cmplt_epi32_mask(c, inf));
+
+    /* add values and keep the minimum (only where none of the source values was INF) */
+    res = _mm512_mask_min_epi32(res, mask, res, _mm512_add_epi32(_mm512_add_epi32(a, b), c));
+  }
+
+  decomp = _mm512_reduce_min_epi32(res);
+
+  for (; i < count; i++) {
+    if ((e1[i] != INF) && (e2[i] != INF) && (e3[i] != INF)) {
+      const int en = e1[i] + e2[i] + e3[i];
+      decomp = MIN2(decomp, en);
+    }
+  }
+
+  return decomp;
+}
+
+
+#ifndef USE_FLOAT_PF
+
+/*
+ *  8 independent partial sums combined in a fixed order,
+ *  see vrna_fun_zip_mul_add_sum()
+ */
+PUBLIC double
+vrna_fun_zip_mul_add_sum_avx512(const double  *e1,
+                                const double  *e2,
+                                int           count)
+{
+  int     i = 0;
+  double  acc[8], sum;
+
+  __m512d acc0 = _mm512_setzero_pd();
+
+  for (i = 0; i < count - 7; i += 8)
+    acc0 = _mm512_add_pd(acc0,
+                         _mm512_mul_pd(_mm512_loadu_pd(&e1[i]),
+                                       _mm512_loadu_pd(&e2[i])));
+
+  _mm512_storeu_pd(&acc[0], acc0);
+
+  sum = ((acc[0] + acc[4]) + (acc[2] + acc[6])) +
+        ((acc[1] + acc[5]) + (acc[3] + acc[7]));
+
+  for (; i < count; i++)
+    sum += e1[i] * e2[i];
+
+  return sum;
+}
+
+
+PUBLIC double
+vrna_fun_zip_mul_add_sum_rev_avx512(const double  *e1,
+                                    const double  *e2,
+                                    int           count)
+{
+  int     i = 0;
+  double  acc[8], sum;
+
+  __m512d acc0  = _mm512_setzero_pd();
+  __m512i rev   = _mm512_set_epi64(0, 1, 2, 3, 4, 5, 6, 7);
+
+  for (i = 0; i < count - 7; i += 8) {
+    /* load e2 in reverse order */
+    __m512d b = _mm512_permutexvar_pd(rev, _mm512_loadu_pd(&e2[count - i - 8]));
+
+    acc0 = _mm512_add_pd(acc0, _mm512_mul_pd(_mm512_loadu_pd(&e1[i]), b));
+  }
+
+  _mm512_storeu_pd(&acc[0], acc0);
+
+  sum = ((acc[0] + acc[4]) + (acc[2] + acc[6])) +
+        ((acc[1] + acc[5]) + (acc[3] + acc[7]));
+
+  for (; i < count; i++)
+    sum += e1[i] * e2[count - 1 - i];
+
+  return sum;
+}
+
+
+#endif
+
+
+/*
+ *  16 independent partial sums combined in a fixed order,
+ *  see vrna_fun_zip_mul_add_sum_flt()
+ */
+PUBLIC float
+vrna_fun_zip_mul_add_sum_flt_avx512(const float *e1,
+                                    const float *e2,
+                                    int         count)
+{
+  int   i = 0;
+  float acc[16], sum;
+
+  __m512 acc0 = _mm512_setzero_ps();
+
+  for (i = 0; i < count - 15; i += 16)
+    acc0 = _mm512_add_ps(acc0,
+                         _mm512_mul_ps(_mm512_loadu_ps(&e1[i]),
+                                       _mm512_loadu_ps(&e2[i])));
+
+  _mm512_storeu_ps(&acc[0], acc0);
+
+  sum = (((acc[0] + acc[8]) + (acc[4] + acc[12])) + ((acc[2] + acc[10]) + (acc[6] + acc[14]))) +
+        (((acc[1] + acc[9]) + (acc[5] + acc[13])) + ((acc[3] + acc[11]) + (acc[7] + acc[15])));
+
+  for (; i < count; i++)
+    sum += e1[i] * e2[i];
+
+  return sum;
+}
+
+
+PUBLIC float
+vrna_fun_zip_mul_add_sum_rev_flt_avx512(const float *e1,
+                                        const float *e2,
+                                        int         count)
+{
+  int   i = 0;
+  float acc[16], sum;
+
+  __m512  acc0  = _mm512_setzero_ps();
+  __m512i rev   = _mm512_set_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+
+  for (i = 0; i < count - 15; i += 16) {
+    /* load e2 in reverse order */
+    __m512 b = _mm512_permutexvar_ps(rev, _mm512_loadu_ps(&e2[count - i - 16]));
+
+    acc0 = _mm512_add_ps(acc0, _mm512_mul_ps(_mm512_loadu_ps(&e1[i]), b));
+  }
+
+  _mm512_storeu_ps(&acc[0], acc0);
+
+  sum = (((acc[0] + acc[8]) + (acc[4] + acc[12])) + ((acc[2] + acc[10]) + (acc[6] + acc[14]))) +
+        (((acc[1] + acc[9]) + (acc[5] + acc[13])) + ((acc[3] + acc[11]) + (acc[7] + acc[15])));
+
+  for (; i < count; i++)
+    sum += e1[i] * e2[count - 1 - i];
+
+  return sum;
+}
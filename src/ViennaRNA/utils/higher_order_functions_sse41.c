@@ -55,6 +55,214 @@ vrna_fun_zip_add_min_sse41(const int  *e1,
 }
 
 
+PUBLIC int
+vrna_fun_zip3_add_min_sse41(const int *e1,
+                            const int *e2,
+                            const int *e3,
+                            int       count)
+{
+  int     i       = 0;
+  int     decomp  = INF;
+
+  __m128i inf = _mm_set1_epi32(INF);
+  __m128i res = inf;
+
+  for (i = 0; i < count - 3; i += 4) {
+    __m128i a = _mm_loadu_si128((__m128i *)&e1[i]);
+    __m128i b = _mm_loadu_si128((__m128i *)&e2[i]);
+    __m128i c = _mm_loadu_si128((__m128i *)&e3[i]);
+
+    /* create mask for non-INF values */
+    __m128i mask = _mm_and_si128(_mm_and_si128(_mm_cmplt_epi32(a, inf),
+                                               _mm_cmplt_epi32(b, inf)),
+                                 _mm_cmplt_epi32(c, inf));
+
+    /* fill all values with INF if they've been INF in a, b, or c before */
+    __m128i d = _mm_blendv_epi8(inf,
+                                _mm_add_epi32(_mm_add_epi32(a, b), c),
+                                mask);
+
+    res = _mm_min_epi32(res, d);
+  }
+
+  decomp = horizontal_min_Vec4i(res);
+
+  for (; i < count; i++) {
+    if ((e1[i] != INF) && (e2[i] != INF) && (e3[i] != INF)) {
+      const int en = e1[i] + e2[i] + e3[i];
+      decomp = MIN2(decomp, en);
+    }
+  }
+
+  return decomp;
+}
+
+
+#ifndef USE_FLOAT_PF
+
+/*
+ *  8 independent partial sums combined in a fixed order,
+ *  see vrna_fun_zip_mul_add_sum()
+ */
+PUBLIC double
+vrna_fun_zip_mul_add_sum_sse41(const double *e1,
+                               const double *e2,
+                               int          count)
+{
+  int     i = 0;
+  double  acc[8], sum;
+
+  __m128d acc0  = _mm_setzero_pd();
+  __m128d acc1  = _mm_setzero_pd();
+  __m128d acc2  = _mm_setzero_pd();
+  __m128d acc3  = _mm_setzero_pd();
+
+  for (i = 0; i < count - 7; i += 8) {
+    acc0  = _mm_add_pd(acc0, _mm_mul_pd(_mm_loadu_pd(&e1[i]), _mm_loadu_pd(&e2[i])));
+    acc1  = _mm_add_pd(acc1, _mm_mul_pd(_mm_loadu_pd(&e1[i + 2]), _mm_loadu_pd(&e2[i + 2])));
+    acc2  = _mm_add_pd(acc2, _mm_mul_pd(_mm_loadu_pd(&e1[i + 4]), _mm_loadu_pd(&e2[i + 4])));
+    acc3  = _mm_add_pd(acc3, _mm_mul_pd(_mm_loadu_pd(&e1[i + 6]), _mm_loadu_pd(&e2[i + 6])));
+  }
+
+  _mm_storeu_pd(&acc[0], acc0);
+  _mm_storeu_pd(&acc[2], acc1);
+  _mm_storeu_pd(&acc[4], acc2);
+  _mm_storeu_pd(&acc[6], acc3);
+
+  sum = ((acc[0] + acc[4]) + (acc[2] + acc[6])) +
+        ((acc[1] + acc[5]) + (acc[3] + acc[7]));
+
+  for (; i < count; i++)
+    sum += e1[i] * e2[i];
+
+  return sum;
+}
+
+
+PUBLIC double
+vrna_fun_zip_mul_add_sum_rev_sse41(const double *e1,
+                                   const double *e2,
+                                   int          count)
+{
+  int     i = 0;
+  double  acc[8], sum;
+
+  __m128d acc0  = _mm_setzero_pd();
+  __m128d acc1  = _mm_setzero_pd();
+  __m128d acc2  = _mm_setzero_pd();
+  __m128d acc3  = _mm_setzero_pd();
+
+  for (i = 0; i < count - 7; i += 8) {
+    /* load e2 in reverse order */
+    __m128d b0  = _mm_loadu_pd(&e2[count - i - 2]);
+    __m128d b1  = _mm_loadu_pd(&e2[count - i - 4]);
+    __m128d b2  = _mm_loadu_pd(&e2[count - i - 6]);
+    __m128d b3  = _mm_loadu_pd(&e2[count - i - 8]);
+
+    acc0  = _mm_add_pd(acc0, _mm_mul_pd(_mm_loadu_pd(&e1[i]), _mm_shuffle_pd(b0, b0, 1)));
+    acc1  = _mm_add_pd(acc1, _mm_mul_pd(_mm_loadu_pd(&e1[i + 2]), _mm_shuffle_pd(b1, b1, 1)));
+    acc2  = _mm_add_pd(acc2, _mm_mul_pd(_mm_loadu_pd(&e1[i + 4]), _mm_shuffle_pd(b2, b2, 1)));
+    acc3  = _mm_add_pd(acc3, _mm_mul_pd(_mm_loadu_pd(&e1[i + 6]), _mm_shuffle_pd(b3, b3, 1)));
+  }
+
+  _mm_storeu_pd(&acc[0], acc0);
+  _mm_storeu_pd(&acc[2], acc1);
+  _mm_storeu_pd(&acc[4], acc2);
+  _mm_storeu_pd(&acc[6], acc3);
+
+  sum = ((acc[0] + acc[4]) + (acc[2] + acc[6])) +
+        ((acc[1] + acc[5]) + (acc[3] + acc[7]));
+
+  for (; i < count; i++)
+    sum += e1[i] * e2[count - 1 - i];
+
+  return sum;
+}
+
+
+#endif
+
+
+/*
+ *  16 independent partial sums combined in a fixed order,
+ *  see vrna_fun_zip_mul_add_sum_flt()
+ */
+PUBLIC float
+vrna_fun_zip_mul_add_sum_flt_sse41(const float  *e1,
+                                   const float  *e2,
+                                   int          count)
+{
+  int   i = 0;
+  float acc[16], sum;
+
+  __m128  acc0  = _mm_setzero_ps();
+  __m128  acc1  = _mm_setzero_ps();
+  __m128  acc2  = _mm_setzero_ps();
+  __m128  acc3  = _mm_setzero_ps();
+
+  for (i = 0; i < count - 15; i += 16) {
+    acc0  = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(&e1[i]), _mm_loadu_ps(&e2[i])));
+    acc1  = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(&e1[i + 4]), _mm_loadu_ps(&e2[i + 4])));
+    acc2  = _mm_add_ps(acc2, _mm_mul_ps(_mm_loadu_ps(&e1[i + 8]), _mm_loadu_ps(&e2[i + 8])));
+    acc3  = _mm_add_ps(acc3, _mm_mul_ps(_mm_loadu_ps(&e1[i + 12]), _mm_loadu_ps(&e2[i + 12])));
+  }
+
+  _mm_storeu_ps(&acc[0], acc0);
+  _mm_storeu_ps(&acc[4], acc1);
+  _mm_storeu_ps(&acc[8], acc2);
+  _mm_storeu_ps(&acc[12], acc3);
+
+  sum = (((acc[0] + acc[8]) + (acc[4] + acc[12])) + ((acc[2] + acc[10]) + (acc[6] + acc[14]))) +
+        (((acc[1] + acc[9]) + (acc[5] + acc[13])) + ((acc[3] + acc[11]) + (acc[7] + acc[15])));
+
+  for (; i < count; i++)
+    sum += e1[i] * e2[i];
+
+  return sum;
+}
+
+
+PUBLIC float
+vrna_fun_zip_mul_add_sum_rev_flt_sse41(const float  *e1,
+                                       const float  *e2,
+                                       int          count)
+{
+  int   i = 0;
+  float acc[16], sum;
+
+  __m128  acc0  = _mm_setzero_ps();
+  __m128  acc1  = _mm_setzero_ps();
+  __m128  acc2  = _mm_setzero_ps();
+  __m128  acc3  = _mm_setzero_ps();
+
+  for (i = 0; i < count - 15; i += 16) {
+    /* load e2 in reverse order */
+    __m128  b0  = _mm_loadu_ps(&e2[count - i - 4]);
+    __m128  b1  = _mm_loadu_ps(&e2[count - i - 8]);
+    __m128  b2  = _mm_loadu_ps(&e2[count - i - 12]);
+    __m128  b3  = _mm_loadu_ps(&e2[count - i - 16]);
+
+    acc0  = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(&e1[i]), _mm_shuffle_ps(b0, b0, 0x1B)));
+    acc1  = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(&e1[i + 4]), _mm_shuffle_ps(b1, b1, 0x1B)));
+    acc2  = _mm_add_ps(acc2, _mm_mul_ps(_mm_loadu_ps(&e1[i + 8]), _mm_shuffle_ps(b2, b2, 0x1B)));
+    acc3  = _mm_add_ps(acc3, _mm_mul_ps(_mm_loadu_ps(&e1[i + 12]), _mm_shuffle_ps(b3, b3, 0x1B)));
+  }
+
+  _mm_storeu_ps(&acc[0], acc0);
+  _mm_storeu_ps(&acc[4], acc1);
+  _mm_storeu_ps(&acc[8], acc2);
+  _mm_storeu_ps(&acc[12], acc3);
+
+  sum = (((acc[0] + acc[8]) + (acc[4] + acc[12])) + ((acc[2] + acc[10]) + (acc[6] + acc[14]))) +
+        (((acc[1] + acc[9]) + (acc[5] + acc[13])) + ((acc[3] + acc[11]) + (acc[7] + acc[15])));
+
+  for (; i < count; i++)
+    sum += e1[i] * e2[count - 1 - i];
+
+  return sum;
+}
+
+
 /*
  *  SSE minimum
  *  see also: http://stackoverflow.com/questions/9877700/getting-max-value-in-a-m128i-vector-with-sse
@@ -132,6 +132,7 @@ vrna_aln_pinfo(vrna_fold_compound_t *vc,
   FLT_OR_DBL    *probs    = vc->exp_matrices->probs;
   vrna_md_t     *md       = &(vc->exp_params->model_details);
   int           turn      = md->min_loop_size;
+  int           max_d     = (vc->jindx_span) ? (int)vc->jindx_span + 1 : n;
 
   max_p = 64;
   pi    = vrna_alloc(max_p * sizeof(vrna_pinfo_t));
@@ -140,7 +141,7 @@ vrna_aln_pinfo(vrna_fold_compound_t *vc,
     ptable = vrna_ptable(structure);
 
   for (i = 1; i < n; i++)
-    for (j = i + turn + 1; j <= n; j++) {
+    for (j = i + turn + 1; j <= MIN2(n, i + max_d); j++) {
       if ((p = probs[my_iindx[i] - j]) >= threshold) {
         duck[i] -= p * log(p);
         duck[j] -= p * log(p);
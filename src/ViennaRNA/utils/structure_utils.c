@@ -809,14 +809,38 @@ vrna_plist(const char *struc,
            float      pr)
 {
   /* convert bracket string to plist */
-  short     *pt;
-  int       i, k = 0, size, n;
+  int       *pt, *stack;
+  int       i, j, k = 0, sp, size, n;
   vrna_ep_t *gpl, *ptr, *pl;
 
   size  = strlen(struc);
   n     = 2;
 
-  pt  = vrna_ptable(struc);
+  /*
+   *  pair the brackets on an int stack rather than through vrna_ptable(),
+   *  since the latter is limited to structures of length SHRT_MAX
+   */
+  pt    = (int *)vrna_alloc(sizeof(int) * (size + 2));
+  stack = (int *)vrna_alloc(sizeof(int) * (size + 1));
+  for (sp = 0, i = 1; i <= size; i++) {
+    if (struc[i - 1] == '(') {
+      stack[sp++] = i;
+    } else if (struc[i - 1] == ')') {
+      if (sp == 0)
+        break;
+
+      j     = stack[--sp];
+      pt[i] = j;
+      pt[j] = i;
+    }
+  }
+  free(stack);
+
+  if ((sp != 0) || (i <= size))
+    vrna_message_warning("vrna_plist: "
+                         "unbalanced brackets in structure\n%s",
+                         struc);
+
   pl  = (vrna_ep_t *)vrna_alloc(n * size * sizeof(vrna_ep_t));
   for (i = 1; i < size; i++) {
     if (pt[i] > i) {
@@ -1223,7 +1247,7 @@ wrap_plist(vrna_fold_compound_t *vc,
            double               cut_off)
 {
   short             *S;
-  int               i, j, k, n, m, count, gquad, length, *index;
+  int               i, j, k, n, m, count, gquad, length, max_d, *index;
   FLT_OR_DBL        *probs;
   vrna_ep_t         *pl;
   vrna_mx_pf_t      *matrices;
@@ -1236,6 +1260,7 @@ wrap_plist(vrna_fold_compound_t *vc,
   matrices  = vc->exp_matrices;
   probs     = matrices->probs;
   gquad     = pf_params->model_details.gquad;
+  max_d     = (vc->jindx_span) ? (int)vc->jindx_span + 1 : length;
 
   count = 0;
   n     = 2;
@@ -1244,7 +1269,7 @@ wrap_plist(vrna_fold_compound_t *vc,
   pl = (vrna_ep_t *)vrna_alloc(n * length * sizeof(vrna_ep_t));
 
   for (i = 1; i < length; i++) {
-    for (j = i + 1; j <= length; j++) {
+    for (j = i + 1; j <= MIN2(length, i + max_d); j++) {
       /* skip all entries below the cutoff */
       if (probs[index[i] - j] < (FLT_OR_DBL)cut_off)
         continue;
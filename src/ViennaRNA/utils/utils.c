@@ -439,6 +439,40 @@ vrna_idx_col_wise(unsigned int length)
 }
 
 
+PUBLIC int *
+vrna_idx_row_wise_banded(unsigned int length,
+                         unsigned int span)
+{
+  unsigned int  i;
+  int           *idx = (int *)vrna_alloc(sizeof(int) * (length + 2));
+
+  /*
+   *  row i stores the entries (i, i + span + 1) ... (i, i - 1),
+   *  i.e. each row consists of exactly span + 3 entries
+   */
+  for (i = 0; i <= length + 1; i++)
+    idx[i] = (int)(i * (span + 4) + span + 1);
+  return idx;
+}
+
+
+PUBLIC int *
+vrna_idx_col_wise_banded(unsigned int length,
+                         unsigned int span)
+{
+  unsigned int  j;
+  int           *idx = (int *)vrna_alloc(sizeof(int) * (length + 1));
+
+  /*
+   *  column j stores the entries (j - span - 1, j) ... (j + 1, j),
+   *  i.e. each column consists of exactly span + 3 entries
+   */
+  for (j = 0; j <= length; j++)
+    idx[j] = (int)(j * (span + 2) + span + 1);
+  return idx;
+}
+
+
 /*
  #################################
  # STATIC helper functions below #
@@ -617,8 +617,11 @@ main(int  argc,
 
   first_alignment_number = get_current_id(opt.id_control);
 
-  if (opt.keep_order)
+  if (opt.keep_order) {
     opt.output_queue = vrna_ostream_init(&flush_cstr_callback, NULL);
+    /* limit the number of buffered results that wait for preceding records */
+    vrna_ostream_set_window(opt.output_queue, MAX_JOBS_IN_FLIGHT(opt.jobs));
+  }
 
   /*
    ################################################
@@ -900,7 +903,7 @@ process_record(struct record_data *record)
 
   vc = vrna_fold_compound_comparative((const char **)alignment,
                                       &(opt->md),
-                                      VRNA_OPTION_DEFAULT);
+                                      (opt->md.max_bp_span > 0) ? VRNA_OPTION_BANDED : VRNA_OPTION_DEFAULT);
   n = vc->length;
 
   if (fold_constrained)
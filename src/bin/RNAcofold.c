@@ -44,6 +44,12 @@
 #include "ViennaRNA/color_output.inc"
 #include "parallel_helpers.h"
 
+/*
+ *  Maximum sequence length for which the fold compound of a record is kept
+ *  for the next record processed by the same thread
+ */
+#define WORKER_FC_LENGTH_MAX  2000
+
 
 struct options {
   int             filename_full;
@@ -109,6 +115,15 @@ static void
 process_record(struct record_data *record);
 
 
+static vrna_fold_compound_t *
+get_fold_compound(const char  *sequence,
+                  vrna_md_t   *md);
+
+
+static void
+release_fold_compound(vrna_fold_compound_t *fc);
+
+
 PRIVATE vrna_dimer_pf_t
 do_partfunc(char            *string,
             int             length,
@@ -460,14 +475,18 @@ main(int  argc,
   if ((opt.verbose) && (opt.jobs > 1))
     vrna_message_info(stderr, "Preparing %d parallel computation slots", opt.jobs);
 
-  if (opt.keep_order)
+  if (opt.keep_order) {
     opt.output_queue = vrna_ostream_init(&flush_cstr_callback, NULL);
+    /* limit the number of buffered results that wait for preceding records */
+    vrna_ostream_set_window(opt.output_queue, MAX_JOBS_IN_FLIGHT(opt.jobs));
+  }
 
   /*
    ################################################
    # process input files or handle input from stdin
    ################################################
    */
+  INIT_WORKER_DATA(&vrna_fold_compound_free);
   INIT_PARALLELIZATION(opt.jobs);
 
   if (num_input > 0) {
@@ -500,6 +519,7 @@ main(int  argc,
   }
 
   UNINIT_PARALLELIZATION
+  UNINIT_WORKER_DATA
   /*
    ################################################
    # post processing
@@ -663,9 +683,7 @@ process_record(struct record_data *record)
   /* convert sequence to uppercase letters only */
   vrna_seq_toupper(sequence);
 
-  vrna_fold_compound_t *vc = vrna_fold_compound(sequence,
-                                                &(opt->md),
-                                                VRNA_OPTION_DEFAULT | VRNA_OPTION_HYBRID);
+  vrna_fold_compound_t *vc = get_fold_compound(sequence, &(opt->md));
   n = vc->length;
 
   /* retrieve string stream bound to stdout, 6*length should be enough memory to start with */
@@ -1149,12 +1167,56 @@ cleanup_record:
     free(record->rest);
   }
 
-  vrna_fold_compound_free(vc);
+  release_fold_compound(vc);
 
   free(record);
 }
 
 
+/*
+ *  Retrieve a fold compound for the current record. For single strands, the
+ *  fold compound of the previous record processed by the same thread is
+ *  re-used to avoid re-computing energy parameters and re-allocating DP
+ *  matrices. Dimers always obtain a new fold compound
+ */
+static vrna_fold_compound_t *
+get_fold_compound(const char  *sequence,
+                  vrna_md_t   *md)
+{
+  vrna_fold_compound_t *fc;
+
+  if (strchr(sequence, '&'))
+    return vrna_fold_compound(sequence, md, VRNA_OPTION_DEFAULT | VRNA_OPTION_HYBRID);
+
+  fc = (vrna_fold_compound_t *)GET_WORKER_DATA();
+
+  /* the dangle model may change after the first dimer record, see process_record() */
+  if ((fc) &&
+      (fc->params->model_details.dangles == md->dangles) &&
+      (vrna_fold_compound_reset_sequence(fc, sequence)))
+    return fc;
+
+  vrna_fold_compound_free(fc);
+  fc = vrna_fold_compound(sequence, md, VRNA_OPTION_DEFAULT | VRNA_OPTION_HYBRID);
+  SET_WORKER_DATA(fc);
+
+  return fc;
+}
+
+
+static void
+release_fold_compound(vrna_fold_compound_t *fc)
+{
+  if (fc != (vrna_fold_compound_t *)GET_WORKER_DATA()) {
+    vrna_fold_compound_free(fc);
+  } else if (fc->length > WORKER_FC_LENGTH_MAX) {
+    /* do not keep the memory occupied by long sequences */
+    vrna_fold_compound_free(fc);
+    SET_WORKER_DATA(NULL);
+  }
+}
+
+
 static void
 write_csv_header(FILE           *output,
                  struct options *opt)
@@ -23,18 +23,50 @@
 #include "ViennaRNA/utils/structures.h"
 #include "ViennaRNA/io/utils.h"
 #include "ViennaRNA/datastructures/basic.h"
+#include "ViennaRNA/datastructures/char_stream.h"
+#include "ViennaRNA/datastructures/stream_output.h"
 #include "RNAdistance_cmdl.h"
+#include "parallel_helpers.h"
 
 #define MAXNUM      1000    /* max number of structs for distance matrix */
 
 #define PUBLIC
 #define PRIVATE     static
 
+/* tree and string representations of a single input structure */
+struct structure_data {
+  Tree      *T[10];
+  swString  *S[10];
+  char      *P;   /* structure for base pair distances */
+  int       tree_types;
+  int       string_types;
+  int       refs;
+};
+
+/* the structures of a single distance matrix */
+struct matrix_data {
+  struct structure_data *list[MAXNUM];
+  int                   n;
+  int                   refs;
+};
+
+/* a single comparison job, i.e. a pair of structures or a matrix row */
+struct job_data {
+  unsigned int          number;
+  struct structure_data *first;
+  struct structure_data *second;
+  struct matrix_data    *matrix;
+  int                   tt;       /* distance representation of the matrix row */
+  int                   row;
+  vrna_cstr_t           output;
+};
+
 PRIVATE void command_line(int   argc,
                           char  *argv[]);
 
 
-PRIVATE int parse_input(char *line);
+PRIVATE int parse_input(char        *line,
+                        vrna_cstr_t output);
 
 
 PRIVATE int check_tree(char *line,
@@ -44,32 +76,55 @@ PRIVATE int check_tree(char *line,
 PRIVATE int check_brackets(char *line);
 
 
-PRIVATE void print_aligned_lines(FILE *somewhere);
+PRIVATE void print_aligned_lines(vrna_cstr_t output);
+
+
+PRIVATE struct structure_data *prepare_structure(char  *line,
+                                                 int   type);
+
+
+PRIVATE void release_structure(struct structure_data *s);
+
+
+PRIVATE void release_matrix(struct matrix_data *m);
+
+
+PRIVATE void submit_job(struct job_data *job,
+                        vrna_cstr_t     *output);
+
+
+PRIVATE void process_job(struct job_data *job);
 
 
-PRIVATE char  ruler[] = "....,....1....,....2....,....3....,....4"
-                        "....,....5....,....6....,....7....,....8";
-PRIVATE int   types = 1;
-PRIVATE int   task;
-PRIVATE int   taxa_list;
-PRIVATE char  outfile[FILENAME_MAX_LENGTH], *list_title;
+PRIVATE void flush_output(void         *auxdata,
+                          unsigned int i,
+                          void         *data);
 
-PRIVATE char  ttype[10] = "f";
-PRIVATE int   n         = 0;
+
+PRIVATE char            ruler[] = "....,....1....,....2....,....3....,....4"
+                                  "....,....5....,....6....,....7....,....8";
+PRIVATE int             types = 1;
+PRIVATE int             task;
+PRIVATE int             taxa_list;
+PRIVATE char            outfile[FILENAME_MAX_LENGTH], *list_title;
+
+PRIVATE char            ttype[10] = "f";
+PRIVATE int             n         = 0;
+PRIVATE int             jobs      = 1;
+PRIVATE FILE            *somewhere = NULL;
+PRIVATE vrna_ostream_t  output_queue;
+PRIVATE unsigned int    next_job_number = 0;
 
 int
 main(int  argc,
      char *argv[])
 {
-  char      *line = NULL, *xstruc, *cc;
-  Tree      *T[10][MAXNUM];
-  int       tree_types = 0, ttree;
-  swString  *S[10][MAXNUM];
-  char      *P[MAXNUM];  /* structures for base pair distances */
-  int       string_types = 0, tstr;
-  int       i, j, tt, istty, type;
-  int       it, is;
-  FILE      *somewhere = NULL;
+  char                  *line = NULL, *xstruc;
+  struct structure_data *pending[2];
+  struct matrix_data    *matrix;
+  struct job_data       *job;
+  int                   i, tt, istty, type;
+  vrna_cstr_t           output;
 
   command_line(argc, argv);
 
@@ -84,6 +139,19 @@ main(int  argc,
 
   istty = isatty(fileno(stdin)) && isatty(fileno(stdout));
 
+  /*
+   *  Distances are computed in parallel jobs, each of which collects its
+   *  output in a char stream that is printed in the order of submission
+   */
+  output_queue = vrna_ostream_init(&flush_output, NULL);
+  vrna_ostream_set_window(output_queue, MAX_JOBS_IN_FLIGHT(jobs));
+
+  INIT_PARALLELIZATION(jobs);
+
+  output  = vrna_cstr(0, stdout);
+  matrix  = (struct matrix_data *)vrna_alloc(sizeof(struct matrix_data));
+  matrix->refs = 1;
+
   do {
     if ((istty) && (n == 0)) {
       printf("\nInput structure;  @ to quit\n");
@@ -95,71 +163,39 @@ main(int  argc,
         free(line);
 
       line = vrna_read_line(stdin);
-    } while ((type = parse_input(line)) == 0);
+    } while ((type = parse_input(line, output)) == 0);
 
     if (((type == 999) || (type == 888)) && (task == 2)) {
       /* do matrices */
       if (taxa_list)
-        printf("* END of taxa list\n");
+        vrna_cstr_printf(output, "* END of taxa list\n");
+
+      matrix->n = n;
 
-      ttree = 0;
-      tstr  = 0;
       for (tt = 0; tt < types; tt++) {
-        printf("> %c   %d\n", ttype[tt], n);
-        if (islower(ttype[tt])) {
-          for (i = 1; i < n; i++) {
-            for (j = 0; j < i; j++) {
-              printf("%g ", tree_edit_distance(T[ttree][i], T[ttree][j]));
-              if (edit_backtrack) {
-                fprintf(somewhere, "%d %d", i + 1, j + 1);
-                if (ttype[tt] == 'f')
-                  unexpand_aligned_F(aligned_line);
-
-                print_aligned_lines(somewhere);
-              }
-            }
-            printf("\n");
-          }
-          printf("\n");
-          for (i = 0; i < n; i++)
-            free_tree(T[ttree][i]);
-          ttree++;
-        }
+        vrna_cstr_printf(output, "> %c   %d\n", ttype[tt], n);
+        /* each row of the matrix is computed in a separate job */
+        for (i = 1; i < n; i++) {
+          job         = (struct job_data *)vrna_alloc(sizeof(struct job_data));
+          job->matrix = matrix;
+          job->tt     = tt;
+          job->row    = i;
+
+          ATOMIC_BLOCK(matrix->refs++);
 
-        if (ttype[tt] == 'P') {
-          for (i = 1; i < n; i++) {
-            for (j = 0; j < i; j++)
-              printf("%g ", (float)vrna_bp_distance(P[i], P[j]));
-            printf("\n");
-          }
-          printf("\n");
-          for (i = 0; i < n; i++)
-            free(P[i]);
-        } else if (isupper(ttype[tt])) {
-          for (i = 1; i < n; i++) {
-            for (j = 0; j < i; j++) {
-              printf("%g ", string_edit_distance(S[tstr][i], S[tstr][j]));
-              if (edit_backtrack) {
-                fprintf(somewhere, "%d %d", i + 1, j + 1);
-                if (ttype[tt] == 'F')
-                  unexpand_aligned_F(aligned_line);
-
-                print_aligned_lines(somewhere);
-              }
-            }
-            printf("\n");
-          }
-          printf("\n");
-          for (i = 0; i < n; i++)
-            free(S[tstr][i]);
-          tstr++;
+          submit_job(job, &output);
         }
+        vrna_cstr_printf(output, "\n");
       }
-      fflush(stdout);
+
+      release_matrix(matrix);
+      matrix        = (struct matrix_data *)vrna_alloc(sizeof(struct matrix_data));
+      matrix->refs  = 1;
+
       if (type == 888) {
         /* do another distance matrix */
         n = 0;
-        printf("%s\n", list_title);
+        vrna_cstr_printf(output, "%s\n", list_title);
         free(list_title);
         continue;
       }
@@ -167,10 +203,7 @@ main(int  argc,
 
     if (type == 999) {
       /* finito */
-      if (outfile[0] != '\0')
-        fclose(somewhere);
-
-      return 0;
+      break;
     }
 
     if (type < 0) {
@@ -187,209 +220,344 @@ main(int  argc,
       type  = 1;
     }
 
-    tree_types    = 0;
-    string_types  = 0;
-    for (tt = 0; tt < types; tt++) {
-      switch (ttype[tt]) {
-        case 'f':
-        case 'F':
-          if (type != 1)
-            vrna_message_error("Can't convert back to full structure");
-
-          xstruc = expand_Full(line);
-          if (islower(ttype[tt])) /* tree_edit */
-            T[tree_types++][n] = make_tree(xstruc);
-
-          if (isupper(ttype[tt])) /* string edit */
-            S[string_types++][n] = Make_swString(xstruc);
-
-          free(xstruc);
-          break;
-        case 'P':
-          if (type != 1)
-            vrna_message_error("Can't convert back to full structure");
-
-          P[n] = strdup(line);
-          break;
-        case 'h':
-        case 'H':
-          switch (type) {
-            case 1:
-              xstruc = b2HIT(line);
-              if (islower(ttype[tt]))
-                T[tree_types++][n] = make_tree(xstruc);
-
-              if (isupper(ttype[tt]))
-                S[string_types++][n] = Make_swString(xstruc);
-
-              free(xstruc);
-              break;
-            default:
-              vrna_message_error("Can't convert to HIT structure");
-          }
-          break;
-        case 'c':
-        case 'C':
-          switch (type) {
-            case 1:
-              cc      = b2C(line);
-              xstruc  = expand_Shapiro(cc);
-              free(cc);
-              break;
-            case 4:
-              cc      = expand_Shapiro(line);
-              xstruc  = unweight(cc);
-              free(cc);
-              break;
-            case 3:
-              xstruc = unweight(line);
-              break;
-            default:
-              vrna_message_error("Unknown structure representation");
-              exit(0);
-          }
-          if (islower(ttype[tt]))
-            T[tree_types++][n] = make_tree(xstruc);
-
-          if (isupper(ttype[tt]))
-            S[string_types++][n] = Make_swString(xstruc);
-
-          free(xstruc);
-          break;
-        case 'w':
-        case 'W':
-          if (type == 1) {
-            xstruc = b2Shapiro(line);
-            if (islower(ttype[tt]))
-              T[tree_types++][n] = make_tree(xstruc);
-
-            if (isupper(ttype[tt]))
-              S[string_types++][n] = Make_swString(xstruc);
+    if (task == 2) {
+      matrix->list[n++] = prepare_structure(line, type);
+      continue;
+    }
 
-            free(xstruc);
-          } else {
-            if (islower(ttype[tt]))
-              T[tree_types++][n] = make_tree(line);
+    pending[n++] = prepare_structure(line, type);
 
-            if (isupper(ttype[tt]))
-              S[string_types++][n] = Make_swString(line);
-          }
-
-          break;
-        default:
-          vrna_message_error("Unknown distance type");
-      }
-    }
-    n++;
     switch (task) {
-      float dist;
       case 1:
         if (n == 2) {
-          for (it = 0, is = 0, i = 0; i < types; i++) {
-            if (islower(ttype[i])) {
-              dist = tree_edit_distance(T[it][0], T[it][1]);
-              free_tree(T[it][0]);
-              free_tree(T[it][1]);
-              it++;
-            } else if (ttype[i] == 'P') {
-              dist = (float)vrna_bp_distance(P[0], P[1]);
-              free(P[0]);
-              free(P[1]);
-            } else {
-              /* isupper(ttype[i]) */
-              dist = string_edit_distance(S[is][0], S[is][1]);
-              free(S[is][0]);
-              free(S[is][1]);
-              is++;
-            }
-
-            printf("%c: %g  ", ttype[i], dist);
-            if ((edit_backtrack) && (ttype[i] != 'P')) {
-              if (ttype[i] == 'f')
-                unexpand_aligned_F(aligned_line);
-
-              print_aligned_lines(somewhere);
-            }
-          }
-          printf("\n");
+          job         = (struct job_data *)vrna_alloc(sizeof(struct job_data));
+          job->first  = pending[0];
+          job->second = pending[1];
+          submit_job(job, &output);
           n = 0;
         }
 
         break;
       case 3:
         if (n > 1) {
-          for (it = 0, is = 0, i = 0; i < types; i++) {
-            if (islower(ttype[i])) {
-              dist = tree_edit_distance(T[it][1], T[it][0]);
-              free_tree(T[it][1]);
-              it++;
-            } else if (ttype[i] == 'P') {
-              dist = (float)vrna_bp_distance(P[0], P[1]);
-              free(P[1]);
-            } else {
-              /* if(isupper(ttype[i])) */
-              dist = string_edit_distance(S[is][0], S[is][1]);
-              free(S[is][1]);
-              is++;
-            }
-
-            printf("%c: %g  ", ttype[i], dist);
-            if ((edit_backtrack) && (ttype[i] != 'P')) {
-              if (ttype[i] == 'f')
-                unexpand_aligned_F(aligned_line);
-
-              print_aligned_lines(somewhere);
-            }
-          }
-          printf("\n");
+          job         = (struct job_data *)vrna_alloc(sizeof(struct job_data));
+          job->first  = pending[0];
+          job->second = pending[1];
+          ATOMIC_BLOCK(pending[0]->refs++);
+          submit_job(job, &output);
           n = 1;
         }
 
         break;
       case 4:
         if (n > 1) {
-          for (it = 0, is = 0, i = 0; i < types; i++) {
-            if (islower(ttype[i])) {
-              dist = tree_edit_distance(T[it][1], T[it][0]);
-              free_tree(T[it][0]);
-              T[it][0] = T[it][1];
-              it++;
-            } else if (ttype[i] == 'P') {
-              dist = (float)vrna_bp_distance(P[0], P[1]);
-              free(P[0]);
-              P[0] = P[1];
-            } else {
-              /* if(isupper(ttype[i])) */
-              dist = string_edit_distance(S[is][0], S[is][1]);
-              free(S[is][0]);
-              S[is][0] = S[is][1];
-              is++;
-            }
-
-            printf("%c: %g  ", ttype[i], dist);
-            if ((edit_backtrack) && (ttype[i] != 'P')) {
-              if (ttype[i] == 'f')
-                unexpand_aligned_F(aligned_line);
-
-              print_aligned_lines(somewhere);
-            }
-          }
-          printf("\n");
-          n = 1;
+          job         = (struct job_data *)vrna_alloc(sizeof(struct job_data));
+          job->first  = pending[0];
+          job->second = pending[1];
+          ATOMIC_BLOCK(pending[1]->refs++);
+          submit_job(job, &output);
+          pending[0]  = pending[1];
+          n     = 1;
         }
 
         break;
     }
-    fflush(stdout);
   } while (type != 999);
+
+  /* print remaining output */
+  vrna_ostream_request(output_queue, next_job_number);
+  vrna_ostream_provide(output_queue, next_job_number++, (void *)output);
+
+  UNINIT_PARALLELIZATION
+
+  vrna_ostream_free(output_queue);
+
+  if ((task != 2) && (n > 0))
+    release_structure(pending[0]);
+
+  release_matrix(matrix);
+
+  if (outfile[0] != '\0')
+    fclose(somewhere);
+
   return 0;
 }
 
 
+/*--------------------------------------------------------------------------*/
+
+/* compute the tree and string representations of a structure */
+PRIVATE struct structure_data *
+prepare_structure(char  *line,
+                  int   type)
+{
+  char                  *xstruc, *cc;
+  int                   tt, tree_types, string_types;
+  Tree                  **T;
+  swString              **S;
+  struct structure_data *s;
+
+  s       = (struct structure_data *)vrna_alloc(sizeof(struct structure_data));
+  s->refs = 1;
+  T       = s->T;
+  S       = s->S;
+
+  tree_types    = 0;
+  string_types  = 0;
+  for (tt = 0; tt < types; tt++) {
+    switch (ttype[tt]) {
+      case 'f':
+      case 'F':
+        if (type != 1)
+          vrna_message_error("Can't convert back to full structure");
+
+        xstruc = expand_Full(line);
+        if (islower(ttype[tt])) /* tree_edit */
+          T[tree_types++] = make_tree(xstruc);
+
+        if (isupper(ttype[tt])) /* string edit */
+          S[string_types++] = Make_swString(xstruc);
+
+        free(xstruc);
+        break;
+      case 'P':
+        if (type != 1)
+          vrna_message_error("Can't convert back to full structure");
+
+        s->P = strdup(line);
+        break;
+      case 'h':
+      case 'H':
+        switch (type) {
+          case 1:
+            xstruc = b2HIT(line);
+            if (islower(ttype[tt]))
+              T[tree_types++] = make_tree(xstruc);
+
+            if (isupper(ttype[tt]))
+              S[string_types++] = Make_swString(xstruc);
+
+            free(xstruc);
+            break;
+          default:
+            vrna_message_error("Can't convert to HIT structure");
+        }
+        break;
+      case 'c':
+      case 'C':
+        switch (type) {
+          case 1:
+            cc      = b2C(line);
+            xstruc  = expand_Shapiro(cc);
+            free(cc);
+            break;
+          case 4:
+            cc      = expand_Shapiro(line);
+            xstruc  = unweight(cc);
+            free(cc);
+            break;
+          case 3:
+            xstruc = unweight(line);
+            break;
+          default:
+            vrna_message_error("Unknown structure representation");
+            exit(0);
+        }
+        if (islower(ttype[tt]))
+          T[tree_types++] = make_tree(xstruc);
+
+        if (isupper(ttype[tt]))
+          S[string_types++] = Make_swString(xstruc);
+
+        free(xstruc);
+        break;
+      case 'w':
+      case 'W':
+        if (type == 1) {
+          xstruc = b2Shapiro(line);
+          if (islower(ttype[tt]))
+            T[tree_types++] = make_tree(xstruc);
+
+          if (isupper(ttype[tt]))
+            S[string_types++] = Make_swString(xstruc);
+
+          free(xstruc);
+        } else {
+          if (islower(ttype[tt]))
+            T[tree_types++] = make_tree(line);
+
+          if (isupper(ttype[tt]))
+            S[string_types++] = Make_swString(line);
+        }
+
+        break;
+      default:
+        vrna_message_error("Unknown distance type");
+    }
+  }
+
+  s->tree_types   = tree_types;
+  s->string_types = string_types;
+
+  return s;
+}
+
+
+PRIVATE void
+release_structure(struct structure_data *s)
+{
+  int i, refs;
+
+  ATOMIC_BLOCK(refs = --(s->refs));
+
+  if (refs == 0) {
+    for (i = 0; i < s->tree_types; i++)
+      free_tree(s->T[i]);
+
+    for (i = 0; i < s->string_types; i++)
+      free(s->S[i]);
+
+    free(s->P);
+    free(s);
+  }
+}
+
+
+PRIVATE void
+release_matrix(struct matrix_data *m)
+{
+  int i, refs;
+
+  ATOMIC_BLOCK(refs = --(m->refs));
+
+  if (refs == 0) {
+    for (i = 0; i < m->n; i++)
+      release_structure(m->list[i]);
+
+    free(m);
+  }
+}
+
+
+/*
+ *  Submit a comparison job. Any output that has been collected so far,
+ *  e.g. FASTA headers, is printed in front of the output of the job.
+ */
+PRIVATE void
+submit_job(struct job_data  *job,
+           vrna_cstr_t      *output)
+{
+  job->number = next_job_number++;
+  job->output = *output;
+
+  *output = vrna_cstr(0, stdout);
+
+  vrna_ostream_request(output_queue, job->number);
+
+  RUN_IN_PARALLEL(process_job, job);
+}
+
+
+PRIVATE void
+process_job(struct job_data *job)
+{
+  int                   i, j, it, is, tt, ttree, tstr;
+  float                 dist;
+  vrna_cstr_t           output, bt;
+  struct structure_data **list, *first, *second;
+
+  output = job->output;
+  /* backtracking is only available in serial mode, so we may write to the file directly */
+  bt = (somewhere == stdout) ? output : vrna_cstr(0, somewhere);
+
+  if (job->matrix) {
+    list  = job->matrix->list;
+    tt    = job->tt;
+    i     = job->row;
+
+    /* determine the index of the representation */
+    for (ttree = tstr = 0, j = 0; j < tt; j++) {
+      if (islower(ttype[j]))
+        ttree++;
+      else if (ttype[j] != 'P')
+        tstr++;
+    }
+
+    for (j = 0; j < i; j++) {
+      if (islower(ttype[tt]))
+        dist = tree_edit_distance(list[i]->T[ttree], list[j]->T[ttree]);
+      else if (ttype[tt] == 'P')
+        dist = (float)vrna_bp_distance(list[i]->P, list[j]->P);
+      else
+        dist = string_edit_distance(list[i]->S[tstr], list[j]->S[tstr]);
+
+      vrna_cstr_printf(output, "%g ", dist);
+      if ((edit_backtrack) && (ttype[tt] != 'P')) {
+        vrna_cstr_printf(bt, "%d %d", i + 1, j + 1);
+        if ((ttype[tt] == 'f') || (ttype[tt] == 'F'))
+          unexpand_aligned_F(aligned_line);
+
+        print_aligned_lines(bt);
+      }
+    }
+    vrna_cstr_printf(output, "\n");
+
+    release_matrix(job->matrix);
+  } else {
+    first   = job->first;
+    second  = job->second;
+
+    for (it = 0, is = 0, i = 0; i < types; i++) {
+      if (islower(ttype[i])) {
+        dist = (task == 1) ?
+               tree_edit_distance(first->T[it], second->T[it]) :
+               tree_edit_distance(second->T[it], first->T[it]);
+        it++;
+      } else if (ttype[i] == 'P') {
+        dist = (float)vrna_bp_distance(first->P, second->P);
+      } else {
+        /* isupper(ttype[i]) */
+        dist = string_edit_distance(first->S[is], second->S[is]);
+        is++;
+      }
+
+      vrna_cstr_printf(output, "%c: %g  ", ttype[i], dist);
+      if ((edit_backtrack) && (ttype[i] != 'P')) {
+        if (ttype[i] == 'f')
+          unexpand_aligned_F(aligned_line);
+
+        print_aligned_lines(bt);
+      }
+    }
+    vrna_cstr_printf(output, "\n");
+
+    release_structure(first);
+    release_structure(second);
+  }
+
+  if (bt != output)
+    vrna_cstr_free(bt);
+
+  vrna_ostream_provide(output_queue, job->number, (void *)output);
+
+  free(job);
+}
+
+
+PRIVATE void
+flush_output(void         *auxdata,
+             unsigned int i,
+             void         *data)
+{
+  vrna_cstr_free((vrna_cstr_t)data);
+}
+
+
 /*--------------------------------------------------------------------------*/
 
 PRIVATE int
-parse_input(char *line)
+parse_input(char        *line,
+            vrna_cstr_t output)
 {
   int   type, rooted = 0, i, xx;
   char  *cp;
@@ -402,7 +570,7 @@ parse_input(char *line)
       if (task == 2)
         taxa_list = 1;
 
-      printf("%s\n", line);
+      vrna_cstr_printf(output, "%s\n", line);
       return 0;
     } else {
       list_title = strdup(line);
@@ -412,9 +580,9 @@ parse_input(char *line)
 
   if (line[0] == '>') {
     if (taxa_list)
-      printf("%d :%s\n", n + 1, line + 1);
+      vrna_cstr_printf(output, "%d :%s\n", n + 1, line + 1);
     else
-      printf("%s\n", line);
+      vrna_cstr_printf(output, "%s\n", line);
 
     return 0;
   }
@@ -655,6 +823,37 @@ command_line(int  argc,
     edit_backtrack = 1;
   }
 
+  if (args_info.jobs_given) {
+#if VRNA_WITH_PTHREADS
+    int thread_max = max_user_threads();
+    if (args_info.jobs_arg == 0) {
+      /* use maximum of concurrent threads */
+      int proc_cores, proc_cores_conf;
+      if (num_proc_cores(&proc_cores, &proc_cores_conf)) {
+        jobs = MIN2(thread_max, proc_cores_conf);
+      } else {
+        vrna_message_warning("Could not determine number of available processor cores!\n"
+                             "Defaulting to serial computation");
+        jobs = 1;
+      }
+    } else {
+      jobs = MIN2(thread_max, args_info.jobs_arg);
+    }
+
+    jobs = MAX2(1, jobs);
+#else
+    vrna_message_warning(
+      "This version of RNAdistance has been built without parallel input processing capabilities");
+#endif
+  }
+
+  /* the alignment of the edit distance backtracking is stored in global memory */
+  if ((edit_backtrack) && (jobs > 1)) {
+    vrna_message_warning("Backtracking (-B) is not available for parallel processing, "
+                         "falling back to serial computation");
+    jobs = 1;
+  }
+
   /* free allocated memory of command line data structure */
   RNAdistance_cmdline_parser_free(&args_info);
 }
@@ -663,10 +862,8 @@ command_line(int  argc,
 /*--------------------------------------------------------------------------*/
 
 PRIVATE void
-print_aligned_lines(FILE *somewhere)
+print_aligned_lines(vrna_cstr_t output)
 {
-  if (edit_backtrack) {
-    fprintf(somewhere, "\n%s\n%s\n", aligned_line[0], aligned_line[1]);
-    fflush(somewhere);
-  }
+  if (edit_backtrack)
+    vrna_cstr_printf(output, "\n%s\n%s\n", aligned_line[0], aligned_line[1]);
 }
@@ -116,6 +116,15 @@ static void
 process_alignment_record(struct record_data_msa *record);
 
 
+static vrna_fold_compound_t *
+get_fold_compound(const char  *sequence,
+                  vrna_md_t   *md);
+
+
+static void
+release_fold_compound(vrna_fold_compound_t *fc);
+
+
 void
 init_default_options(struct options *opt)
 {
@@ -316,8 +325,11 @@ main(int  argc,
   if (opt.md.circ && opt.md.gquad)
     vrna_message_error("G-Quadruplex support is currently not available for circular RNA structures");
 
-  if (opt.keep_order)
+  if (opt.keep_order) {
     opt.output_queue = vrna_ostream_init(&flush_cstr_callback, NULL);
+    /* limit the number of buffered results that wait for preceding records */
+    vrna_ostream_set_window(opt.output_queue, MAX_JOBS_IN_FLIGHT(opt.jobs));
+  }
 
   int (*processing_func)(FILE           *stream,
                          const char     *filename,
@@ -333,6 +345,7 @@ main(int  argc,
    # process input files or handle input from stdin
    ################################################
    */
+  INIT_WORKER_DATA(&vrna_fold_compound_free);
   INIT_PARALLELIZATION(opt.jobs);
 
   if (num_input > 0) {
@@ -358,6 +371,7 @@ main(int  argc,
   }
 
   UNINIT_PARALLELIZATION
+  UNINIT_WORKER_DATA
 
   /*
    ################################################
@@ -627,9 +641,7 @@ process_record(struct record_data *record)
   /* convert sequence to uppercase letters only */
   vrna_seq_toupper(rec_sequence);
 
-  vc = vrna_fold_compound(rec_sequence,
-                          &(opt->md),
-                          VRNA_OPTION_MFE | VRNA_OPTION_EVAL_ONLY);
+  vc = get_fold_compound(rec_sequence, &(opt->md));
 
   n = (int)vc->length;
 
@@ -703,7 +715,7 @@ process_record(struct record_data *record)
     flush_cstr_callback(NULL, 0, (void *)o_stream);
 
   /* clean up */
-  vrna_fold_compound_free(vc);
+  release_fold_compound(vc);
   free(record->id);
   free(record->SEQ_ID);
   free(record->sequence);
@@ -723,6 +735,41 @@ process_record(struct record_data *record)
 }
 
 
+/*
+ *  Retrieve a fold compound for the current record. For single strands, the
+ *  fold compound of the previous record processed by the same thread is
+ *  re-used to avoid re-computing the energy parameters
+ */
+static vrna_fold_compound_t *
+get_fold_compound(const char  *sequence,
+                  vrna_md_t   *md)
+{
+  vrna_fold_compound_t *fc;
+
+  if (strchr(sequence, '&'))
+    return vrna_fold_compound(sequence, md, VRNA_OPTION_MFE | VRNA_OPTION_EVAL_ONLY);
+
+  fc = (vrna_fold_compound_t *)GET_WORKER_DATA();
+
+  if ((fc) && (vrna_fold_compound_reset_sequence(fc, sequence)))
+    return fc;
+
+  vrna_fold_compound_free(fc);
+  fc = vrna_fold_compound(sequence, md, VRNA_OPTION_MFE | VRNA_OPTION_EVAL_ONLY);
+  SET_WORKER_DATA(fc);
+
+  return fc;
+}
+
+
+static void
+release_fold_compound(vrna_fold_compound_t *fc)
+{
+  if (fc != (vrna_fold_compound_t *)GET_WORKER_DATA())
+    vrna_fold_compound_free(fc);
+}
+
+
 static void
 process_alignment_record(struct record_data_msa *record)
 {
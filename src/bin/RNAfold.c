@@ -54,6 +54,12 @@
 #include "input_id_helpers.h"
 #include "parallel_helpers.h"
 
+/*
+ *  Maximum sequence length for which the fold compound of a record is kept
+ *  for the next record processed by the same thread
+ */
+#define WORKER_FC_LENGTH_MAX  2000
+
 
 struct options {
   int             filename_full;
@@ -194,6 +200,15 @@ static void
 process_record(struct record_data *record);
 
 
+static vrna_fold_compound_t *
+get_fold_compound(const char  *sequence,
+                  vrna_md_t   *md);
+
+
+static void
+release_fold_compound(vrna_fold_compound_t *fc);
+
+
 /*--------------------------------------------------------------------------*/
 void
 flush_cstr_callback(void          *auxdata,
@@ -565,14 +580,18 @@ main(int  argc,
   if ((opt.verbose) && (opt.jobs > 1))
     vrna_message_info(stderr, "Preparing %d parallel computation slots", opt.jobs);
 
-  if (opt.keep_order)
+  if (opt.keep_order) {
     opt.output_queue = vrna_ostream_init(&flush_cstr_callback, NULL);
+    /* limit the number of buffered results that wait for preceding records */
+    vrna_ostream_set_window(opt.output_queue, MAX_JOBS_IN_FLIGHT(opt.jobs));
+  }
 
   /*
    ################################################
    # process input files or handle input from stdin
    ################################################
    */
+  INIT_WORKER_DATA(&vrna_fold_compound_free);
   INIT_PARALLELIZATION(opt.jobs);
 
   if (num_input > 0) {
@@ -605,6 +624,7 @@ main(int  argc,
   }
 
   UNINIT_PARALLELIZATION
+  UNINIT_WORKER_DATA
 
   /*
    ################################################
@@ -825,7 +845,7 @@ process_record(struct record_data *record)
   /* convert sequence to uppercase letters only */
   vrna_seq_toupper(rec_sequence);
 
-  vc = vrna_fold_compound(rec_sequence, &(opt->md), VRNA_OPTION_DEFAULT);
+  vc = get_fold_compound(rec_sequence, &(opt->md));
 
   length = vc->length;
 
@@ -1065,7 +1085,7 @@ process_record(struct record_data *record)
   }
 
   /* clean up */
-  vrna_fold_compound_free(vc);
+  release_fold_compound(vc);
   free(record->id);
   free(record->SEQ_ID);
   free(record->sequence);
@@ -1085,6 +1105,50 @@ process_record(struct record_data *record)
 }
 
 
+/*
+ *  Retrieve a fold compound for the current record. For single strands, the
+ *  fold compound of the previous record processed by the same thread is
+ *  re-used to avoid re-computing energy parameters and re-allocating DP
+ *  matrices
+ */
+static vrna_fold_compound_t *
+get_fold_compound(const char  *sequence,
+                  vrna_md_t   *md)
+{
+  vrna_fold_compound_t *fc;
+
+  if (strchr(sequence, '&'))
+    return vrna_fold_compound(sequence, md, VRNA_OPTION_DEFAULT);
+
+  fc = (vrna_fold_compound_t *)GET_WORKER_DATA();
+
+  if ((fc) && (vrna_fold_compound_reset_sequence(fc, sequence)))
+    return fc;
+
+  vrna_fold_compound_free(fc);
+  /* a limited base pair span allows for banded DP matrices */
+  fc = vrna_fold_compound(sequence,
+                          md,
+                          (md->max_bp_span > 0) ? VRNA_OPTION_BANDED : VRNA_OPTION_DEFAULT);
+  SET_WORKER_DATA(fc);
+
+  return fc;
+}
+
+
+static void
+release_fold_compound(vrna_fold_compound_t *fc)
+{
+  if (fc != (vrna_fold_compound_t *)GET_WORKER_DATA()) {
+    vrna_fold_compound_free(fc);
+  } else if (fc->length > WORKER_FC_LENGTH_MAX) {
+    /* do not keep the memory occupied by long sequences */
+    vrna_fold_compound_free(fc);
+    SET_WORKER_DATA(NULL);
+  }
+}
+
+
 static void
 apply_constraints(vrna_fold_compound_t  *fc,
                   const char            *constraints_file,
@@ -24,6 +24,7 @@
 #include "ViennaRNA/params/basic.h"
 #include "ViennaRNA/fold.h"
 #include "ViennaRNA/part_func.h"
+#include "ViennaRNA/heat_capacity.h"
 #include "ViennaRNA/params/io.h"
 #include "ViennaRNA/io/file_formats.h"
 #include "ViennaRNA/datastructures/char_stream.h"
@@ -35,8 +36,12 @@
 #include "input_id_helpers.h"
 #include "parallel_helpers.h"
 
+/*
+ *  Maximum sequence length for which the fold compound of a record is kept
+ *  for the next record processed by the same thread
+ */
+#define WORKER_FC_LENGTH_MAX  2000
 
-#define MAXWIDTH  201
 
 struct options {
   int             filename_full;
@@ -73,10 +78,10 @@ struct output_stream {
 };
 
 
-PRIVATE float
-ddiff(float f[],
-      float h,
-      int   m);
+PRIVATE void
+print_heat_capacity(float temp,
+                    float heat_capacity,
+                    void  *data);
 
 
 static int
@@ -89,6 +94,15 @@ static void
 process_record(struct record_data *record);
 
 
+static vrna_fold_compound_t *
+get_fold_compound(const char  *sequence,
+                  vrna_md_t   *md);
+
+
+static void
+release_fold_compound(vrna_fold_compound_t *fc);
+
+
 void
 init_default_options(struct options *opt)
 {
@@ -264,6 +278,9 @@ main(int  argc,
       opt.keep_order = 0;
   }
 
+  if (args_info.numThreads_given)
+    opt.md.num_threads = (args_info.numThreads_arg > 1) ? args_info.numThreads_arg : 1;
+
   input_files = collect_unnamed_options(&args_info, &num_input);
   input_files = append_input_files(&args_info, input_files, &num_input);
 
@@ -281,14 +298,18 @@ main(int  argc,
   if (opt.md.circ && opt.md.gquad)
     vrna_message_error("G-Quadruplex support is currently not available for circular RNA structures");
 
-  if (opt.keep_order)
+  if (opt.keep_order) {
     opt.output_queue = vrna_ostream_init(&flush_cstr_callback, NULL);
+    /* limit the number of buffered results that wait for preceding records */
+    vrna_ostream_set_window(opt.output_queue, MAX_JOBS_IN_FLIGHT(opt.jobs));
+  }
 
   /*
    #############################################
    # main loop: continue until end of file
    #############################################
    */
+  INIT_WORKER_DATA(&vrna_fold_compound_free);
   INIT_PARALLELIZATION(opt.jobs);
 
   if (num_input > 0) {
@@ -314,6 +335,7 @@ main(int  argc,
   }
 
   UNINIT_PARALLELIZATION
+  UNINIT_WORKER_DATA
   /*
    ################################################
    # post processing
@@ -413,11 +435,8 @@ static void
 process_record(struct record_data *record)
 {
   char                  *rec_sequence;
-  int                   i, n, m;
-  float                 hc, F[MAXWIDTH], T_min, T_max, h;
-  double                min_en;
+  int                   n;
   vrna_fold_compound_t  *fc;
-  vrna_md_t             md;
 
   struct options        *opt;
   struct output_stream  *o_stream;
@@ -426,11 +445,6 @@ process_record(struct record_data *record)
   o_stream      = (struct output_stream *)vrna_alloc(sizeof(struct output_stream));
   rec_sequence  = strdup(record->sequence);
 
-  T_min = opt->T_min;
-  T_max = opt->T_max;
-  h     = opt->h;
-  m     = opt->mpoints;
-
   /* convert DNA alphabet to RNA if not explicitely switched off */
   if (!opt->noconv) {
     vrna_seq_toRNA(rec_sequence);
@@ -440,9 +454,7 @@ process_record(struct record_data *record)
   /* convert sequence to uppercase letters only */
   vrna_seq_toupper(rec_sequence);
 
-  fc = vrna_fold_compound(rec_sequence,
-                          &(opt->md),
-                          VRNA_OPTION_DEFAULT);
+  fc = get_fold_compound(rec_sequence, &(opt->md));
 
   n = (int)fc->length;
 
@@ -461,54 +473,13 @@ process_record(struct record_data *record)
    */
   vrna_cstr_print_fasta_header(o_stream->data, record->id);
 
-  md = fc->params->model_details;
-
-  /* required for vrna_exp_param_rescale() in subsequent calls */
-  md.sfact = 1.;
-
-  md.temperature = T_min - m * h;
-  vrna_params_reset(fc, &md);
-
-  /* initialize_fold(length); <- obsolete */
-  min_en  = (double)vrna_mfe(fc, NULL);
-  min_en  *= md.sfact;
-
-  vrna_exp_params_rescale(fc, &min_en);
-
-  for (i = 0; i < 2 * m + 1; i++) {
-    F[i] = vrna_pf(fc, NULL);
-    /* increase temperature */
-    md.temperature += h;
-    /* reset all energy parameters according to temperature changes */
-    vrna_params_reset(fc, &md);
-
-    min_en = F[i] + h * 0.00727 * n;
-
-    vrna_exp_params_rescale(fc, &min_en);
-  }
-
-  while (md.temperature <= (T_max + m * h + h)) {
-    hc = -ddiff(F, h, m) * (md.temperature + K0 - m * h - h);
-
-    vrna_cstr_printf_tbody(o_stream->data,
-                           "%g\t%g",
-                           (md.temperature - m * h - h),
-                           hc);
-
-    for (i = 0; i < 2 * m; i++)
-      F[i] = F[i + 1];
-
-    F[2 * m] = vrna_pf(fc, NULL);
-
-    /*       printf("%g\n", F[2*m]);*/
-    md.temperature += h;
-
-    vrna_params_reset(fc, &md);
-
-    min_en = F[i] + h * 0.00727 * n;
-
-    vrna_exp_params_rescale(fc, &min_en);
-  }
+  vrna_heat_capacity_cb(fc,
+                        opt->T_min,
+                        opt->T_max,
+                        opt->h,
+                        (unsigned int)opt->mpoints,
+                        &print_heat_capacity,
+                        (void *)o_stream->data);
 
   if (opt->output_queue)
     vrna_ostream_provide(opt->output_queue, record->number, (void *)o_stream);
@@ -516,7 +487,7 @@ process_record(struct record_data *record)
     flush_cstr_callback(NULL, 0, (void *)o_stream);
 
   /* clean up */
-  vrna_fold_compound_free(fc);
+  release_fold_compound(fc);
   free(record->id);
   free(record->SEQ_ID);
   free(record->sequence);
@@ -526,23 +497,58 @@ process_record(struct record_data *record)
 }
 
 
-/* ------------------------------------------------------------------------- */
+/*
+ *  Retrieve a fold compound for the current record. For single strands, the
+ *  fold compound of the previous record processed by the same thread is
+ *  re-used to avoid re-computing energy parameters and re-allocating DP
+ *  matrices
+ */
+static vrna_fold_compound_t *
+get_fold_compound(const char  *sequence,
+                  vrna_md_t   *md)
+{
+  vrna_fold_compound_t *fc;
+
+  if (strchr(sequence, '&'))
+    return vrna_fold_compound(sequence, md, VRNA_OPTION_DEFAULT);
+
+  fc = (vrna_fold_compound_t *)GET_WORKER_DATA();
+
+  if ((fc) && (vrna_fold_compound_reset_sequence(fc, sequence)))
+    return fc;
 
-PRIVATE float
-ddiff(float f[],
-      float h,
-      int   m)
+  vrna_fold_compound_free(fc);
+  fc = vrna_fold_compound(sequence, md, VRNA_OPTION_DEFAULT);
+  SET_WORKER_DATA(fc);
+
+  return fc;
+}
+
+
+static void
+release_fold_compound(vrna_fold_compound_t *fc)
 {
-  int   i;
-  float fp, A, B;
+  if (fc != (vrna_fold_compound_t *)GET_WORKER_DATA()) {
+    vrna_fold_compound_free(fc);
+  } else if (fc->length > WORKER_FC_LENGTH_MAX) {
+    /* do not keep the memory occupied by long sequences */
+    vrna_fold_compound_free(fc);
+    SET_WORKER_DATA(NULL);
+  }
+}
 
-  A = (float)(m * (m + 1) * (2 * m + 1) / 3);                                     /* 2*sum(x^2) */
-  B = (float)(m * (m + 1) * (2 * m + 1)) * (float)(3 * m * m + 3 * m - 1) / 15.;  /* 2*sum(x^4) */
 
-  fp = 0.;
-  for (i = 0; i < 2 * m + 1; i++)
-    fp += f[i] * (A - (float)((2 * m + 1) * (i - m) * (i - m)));
+/* ------------------------------------------------------------------------- */
+
+PRIVATE void
+print_heat_capacity(float temp,
+                    float heat_capacity,
+                    void  *data)
+{
+  vrna_cstr_t stream = (vrna_cstr_t)data;
 
-  fp /= ((A * A - B * ((float)(2 * m + 1))) * h * h / 2.);
-  return (float)fp;
+  vrna_cstr_printf_tbody(stream,
+                         "%g\t%g",
+                         temp,
+                         heat_capacity);
 }
@@ -24,12 +24,41 @@
 #include "ViennaRNA/io/utils.h"
 #include "ViennaRNA/params/io.h"
 #include "ViennaRNA/profiledist.h"
+#include "ViennaRNA/datastructures/char_stream.h"
+#include "ViennaRNA/datastructures/stream_output.h"
 #include "RNApdist_cmdl.h"
+#include "parallel_helpers.h"
 
 
 #define MAXLENGTH  10000
 #define MAXSEQ      1000
 
+/* data of a single input record, i.e. a sequence or the end of a taxa list */
+struct record_data {
+  unsigned int    number;
+  int             type;         /* 1 = sequence, 888 = end of taxa list, 999 = end of input */
+  char            *sequence;
+  char            fname[FILENAME_MAX_LENGTH];
+  vrna_cstr_t     prefix;       /* output that precedes the record, e.g. FASTA headers */
+  char            *list_title;
+  int             taxa_list;
+  int             tty;
+  vrna_md_t       *md;
+  vrna_ostream_t  output_queue;
+
+  /* results of the partition function computations */
+  float           *profile;
+  char            *structure;
+  plist           *pr_pl;
+};
+
+/* state of the distance computations that are performed in input order */
+struct distance_data {
+  float *T[MAXSEQ];
+  int   n;
+  FILE  *somewhere;
+};
+
 PRIVATE void command_line(int       argc,
                           char      *argv[],
                           vrna_md_t *md);
@@ -38,45 +67,67 @@ PRIVATE void command_line(int       argc,
 PRIVATE void print_aligned_lines(FILE *somewhere);
 
 
+PRIVATE void process_record(struct record_data *record);
+
+
+PRIVATE void compute_distances(void         *auxdata,
+                               unsigned int i,
+                               void         *data);
+
+
 PRIVATE char  task;
 PRIVATE char  outfile[FILENAME_MAX_LENGTH];
 PRIVATE char  ruler[] = "....,....1....,....2....,....3....,....4"
                         "....,....5....,....6....,....7....,....8";
-static int    noconv = 0;
+static int    noconv  = 0;
+static int    jobs    = 1;
 
 int
 main(int  argc,
      char *argv[])
 
 {
-  float     *T[MAXSEQ];
-  int       i, j, istty, n = 0;
-  int       type, taxa_list = 0;
-  float     dist;
-  FILE      *somewhere = NULL;
-  char      *structure;
-  char      *line = NULL, fname[FILENAME_MAX_LENGTH], *list_title = NULL;
-  plist     *pr_pl, *mfe_pl;
-  vrna_md_t md;
+  int                   istty, n = 0;
+  int                   type, taxa_list = 0;
+  unsigned int          record_number = 0;
+  char                  *line = NULL, fname[FILENAME_MAX_LENGTH], *list_title = NULL;
+  vrna_cstr_t           prefix;
+  vrna_md_t             md;
+  vrna_ostream_t        output_queue;
+  struct distance_data  distances;
+  struct record_data    *record;
 
   /* assign globally stored model details */
   set_model_details(&md);
 
-  pr_pl = mfe_pl = NULL;
-
   command_line(argc, argv, &md);
 
+  distances.n         = 0;
+  distances.somewhere = NULL;
+
   if ((outfile[0] == '\0') && (task == 'm') && edit_backtrack)
     strcpy(outfile, "backtrack.file");
 
   if (outfile[0] != '\0')
-    somewhere = fopen(outfile, "w");
+    distances.somewhere = fopen(outfile, "w");
 
-  if (somewhere == NULL)
-    somewhere = stdout;
+  if (distances.somewhere == NULL)
+    distances.somewhere = stdout;
 
   istty = (isatty(fileno(stdout)) && isatty(fileno(stdin)));
 
+  /*
+   *  Partition functions of the sequences are computed in parallel, while
+   *  the distances are computed and printed in input order once the
+   *  respective partition functions are available
+   */
+  output_queue = vrna_ostream_init(&compute_distances, (void *)&distances);
+  vrna_ostream_set_window(output_queue, MAX_JOBS_IN_FLIGHT(jobs));
+
+  INIT_PARALLELIZATION(jobs);
+
+  prefix = vrna_cstr(0, stdout);
+
   while (1) {
     if ((istty) && (n == 0)) {
       printf("\nInput sequence;  @ to quit\n");
@@ -106,7 +157,7 @@ main(int  argc,
           if (task == 'm')
             taxa_list = 1;
 
-          printf("%s\n", line);
+          vrna_cstr_printf(prefix, "%s\n", line);
           type = 0;
         } else {
           list_title  = strdup(line);
@@ -120,9 +171,9 @@ main(int  argc,
           strcat(fname, "_dp.ps");
 
         if (taxa_list)
-          printf("%d : %s\n", n + 1, line + 1);
+          vrna_cstr_printf(prefix, "%d : %s\n", n + 1, line + 1);
         else
-          printf("%s\n", line);
+          vrna_cstr_printf(prefix, "%s\n", line);
 
         type = 0;
       }
@@ -138,121 +189,79 @@ main(int  argc,
       }
     } while (type == 0);
 
-    if ((task == 'm') && (type > 800)) {
-      if (taxa_list)
-        printf("* END of taxa list\n");
+    record = (struct record_data *)vrna_alloc(sizeof(struct record_data));
 
-      printf("> p %d (pdist)\n", n);
-      for (i = 1; i < n; i++) {
-        for (j = 0; j < i; j++) {
-          printf("%g ", profile_edit_distance(T[i], T[j]));
-          if (edit_backtrack)
-            fprintf(somewhere, "> %d %d\n", i + 1, j + 1);
+    record->number        = record_number++;
+    record->type          = type;
+    record->prefix        = prefix;
+    record->taxa_list     = taxa_list;
+    record->tty           = istty;
+    record->md            = &md;
+    record->list_title    = NULL;
+    record->output_queue  = output_queue;
 
-          print_aligned_lines(somewhere);
-        }
-        printf("\n");
-      }
-      if (type == 888) {
+    prefix = vrna_cstr(0, stdout);
+
+    vrna_ostream_request(output_queue, record->number);
+
+    if (type > 800) {
+      if ((task == 'm') && (type == 888)) {
         /* do another distance matrix */
-        n = 0;
-        printf("%s\n", list_title);
+        n                   = 0;
+        record->list_title  = list_title;
+      } else {
         free(list_title);
       }
-    }
 
-    if (type > 800) {
-      for (i = 0; i < n; i++)
-        free_profile(T[i]);
-      if (type == 888)
-        continue;
+      list_title = NULL;
 
-      if (outfile[0] != '\0')
-        (void)fclose(somewhere);
+      vrna_ostream_provide(output_queue, record->number, (void *)record);
 
-      if (line != NULL)
-        free(line);
+      if (type == 888)
+        continue;
 
-      return 0; /* finito */
+      break; /* finito */
     }
 
-    /* convert DNA alphabet to RNA if not explicitely switched off */
-    if (!noconv)
-      vrna_seq_toRNA(line);
-
-    /* convert sequence to uppercase letters only */
-    vrna_seq_toupper(line);
-
     if (*fname == '\0')
       sprintf(fname, "%d_dp.ps", n + 1);
 
-    vrna_fold_compound_t *vc = vrna_fold_compound(line, &md, VRNA_OPTION_MFE | VRNA_OPTION_PF);
-
-    structure = (char *)vrna_alloc((vc->length + 1) * sizeof(char));
-
-    (void)vrna_pf(vc, structure);
-
-    pr_pl = vrna_plist_from_probs(vc, 1e-5);
-    /* fake plist for lower part, since it stays empty */
-    mfe_pl      = (plist *)vrna_alloc(sizeof(plist));
-    mfe_pl[0].i = mfe_pl[0].j = 0;
-
-    /* call threadsafe dot plot printing function */
-    PS_dot_plot_list(line, fname, pr_pl, mfe_pl, "");
+    strcpy(record->fname, fname);
+    record->sequence = line;
+    line             = NULL;
 
-    T[n] = Make_bp_profile_bppm(vc->exp_matrices->probs, vc->length);
-
-    if ((istty) && (task == 'm'))
-      printf("%s\n", structure);
-
-    free(structure);
-    free(mfe_pl);
-    free(pr_pl);
-    vrna_fold_compound_free(vc);
+    RUN_IN_PARALLEL(process_record, record);
 
+    /* keep track of the number of sequences in the current comparison */
     n++;
     switch (task) {
       case 'p':
-        if (n == 2) {
-          dist = profile_edit_distance(T[0], T[1]);
-          printf("%g\n", dist);
-          print_aligned_lines(somewhere);
-          free_profile(T[0]);
-          free_profile(T[1]);
+        if (n == 2)
           n = 0;
-        }
 
         break;
       case 'f':
-        if (n > 1) {
-          dist = profile_edit_distance(T[1], T[0]);
-          printf("%g\n", dist);
-          print_aligned_lines(somewhere);
-          free_profile(T[1]);
-          n = 1;
-        }
-
-        break;
       case 'c':
-        if (n > 1) {
-          dist = profile_edit_distance(T[1], T[0]);
-          printf("%g\n", dist);
-          print_aligned_lines(somewhere);
-          free_profile(T[0]);
-          T[0]  = T[1];
-          n     = 1;
-        }
+        if (n > 1)
+          n = 1;
 
         break;
-
       case 'm':
         break;
 
       default:
         vrna_message_error("This can't happen.");
     }   /* END switch task */
-    (void)fflush(stdout);
   }     /* END while */
+
+  UNINIT_PARALLELIZATION
+
+  vrna_ostream_free(output_queue);
+  vrna_cstr_free(prefix);
+
+  if (outfile[0] != '\0')
+    (void)fclose(distances.somewhere);
+
   if (line != NULL)
     free(line);
 
@@ -260,6 +269,168 @@ main(int  argc,
 }
 
 
+PRIVATE void
+process_record(struct record_data *record)
+{
+  char                  *sequence, *structure;
+  vrna_fold_compound_t  *vc;
+
+  sequence = record->sequence;
+
+  /* convert DNA alphabet to RNA if not explicitely switched off */
+  if (!noconv)
+    vrna_seq_toRNA(sequence);
+
+  /* convert sequence to uppercase letters only */
+  vrna_seq_toupper(sequence);
+
+  vc = vrna_fold_compound(sequence, record->md, VRNA_OPTION_MFE | VRNA_OPTION_PF);
+
+  structure = (char *)vrna_alloc((vc->length + 1) * sizeof(char));
+
+  (void)vrna_pf(vc, structure);
+
+  record->pr_pl   = vrna_plist_from_probs(vc, 1e-5);
+  record->profile = Make_bp_profile_bppm(vc->exp_matrices->probs, vc->length);
+
+  if ((record->tty) && (task == 'm'))
+    record->structure = structure;
+  else
+    free(structure);
+
+  vrna_fold_compound_free(vc);
+
+  vrna_ostream_provide(record->output_queue, record->number, (void *)record);
+}
+
+
+/*
+ *  Callback of the ordered output stream, i.e. records arrive here in
+ *  the same order as in the input. Profile distances are not computed
+ *  in parallel since the edit distance backtracking uses global memory.
+ */
+PRIVATE void
+compute_distances(void          *auxdata,
+                  unsigned int  i,
+                  void          *data)
+{
+  int                   k, j, n;
+  float                 dist, **T;
+  FILE                  *somewhere;
+  plist                 *mfe_pl;
+  struct distance_data  *d;
+  struct record_data    *record;
+
+  d         = (struct distance_data *)auxdata;
+  record    = (struct record_data *)data;
+  T         = d->T;
+  somewhere = d->somewhere;
+
+  /* print any output that precedes this record */
+  vrna_cstr_free(record->prefix);
+
+  if (record->type > 800) {
+    n = d->n;
+
+    if (task == 'm') {
+      if (record->taxa_list)
+        printf("* END of taxa list\n");
+
+      printf("> p %d (pdist)\n", n);
+      for (k = 1; k < n; k++) {
+        for (j = 0; j < k; j++) {
+          printf("%g ", profile_edit_distance(T[k], T[j]));
+          if (edit_backtrack)
+            fprintf(somewhere, "> %d %d\n", k + 1, j + 1);
+
+          print_aligned_lines(somewhere);
+        }
+        printf("\n");
+      }
+      if (record->type == 888) {
+        /* do another distance matrix */
+        d->n = 0;
+        printf("%s\n", record->list_title);
+      }
+    }
+
+    for (k = 0; k < n; k++)
+      free_profile(T[k]);
+
+    (void)fflush(stdout);
+
+    free(record->list_title);
+    free(record);
+    return;
+  }
+
+  /* fake plist for lower part, since it stays empty */
+  mfe_pl      = (plist *)vrna_alloc(sizeof(plist));
+  mfe_pl[0].i = mfe_pl[0].j = 0;
+
+  /*
+   *  dot plots are created in input order such that files of records
+   *  with identical names are overwritten just as in serial mode
+   */
+  PS_dot_plot_list(record->sequence, record->fname, record->pr_pl, mfe_pl, "");
+
+  if (record->structure)
+    printf("%s\n", record->structure);
+
+  free(mfe_pl);
+  free(record->pr_pl);
+  free(record->structure);
+  free(record->sequence);
+
+  T[d->n] = record->profile;
+
+  free(record);
+
+  d->n++;
+  switch (task) {
+    case 'p':
+      if (d->n == 2) {
+        dist = profile_edit_distance(T[0], T[1]);
+        printf("%g\n", dist);
+        print_aligned_lines(somewhere);
+        free_profile(T[0]);
+        free_profile(T[1]);
+        d->n = 0;
+      }
+
+      break;
+    case 'f':
+      if (d->n > 1) {
+        dist = profile_edit_distance(T[1], T[0]);
+        printf("%g\n", dist);
+        print_aligned_lines(somewhere);
+        free_profile(T[1]);
+        d->n = 1;
+      }
+
+      break;
+    case 'c':
+      if (d->n > 1) {
+        dist = profile_edit_distance(T[1], T[0]);
+        printf("%g\n", dist);
+        print_aligned_lines(somewhere);
+        free_profile(T[0]);
+        T[0]  = T[1];
+        d->n  = 1;
+      }
+
+      break;
+
+    case 'm':
+      break;
+
+    default:
+      vrna_message_error("This can't happen.");
+  }   /* END switch task */
+  (void)fflush(stdout);
+}
+
+
 /* ----------------------------------------------------------------- */
 
 PRIVATE void
@@ -345,6 +516,30 @@ command_line(int        argc,
     edit_backtrack = 1;
   }
 
+  if (args_info.jobs_given) {
+#if VRNA_WITH_PTHREADS
+    int thread_max = max_user_threads();
+    if (args_info.jobs_arg == 0) {
+      /* use maximum of concurrent threads */
+      int proc_cores, proc_cores_conf;
+      if (num_proc_cores(&proc_cores, &proc_cores_conf)) {
+        jobs = MIN2(thread_max, proc_cores_conf);
+      } else {
+        vrna_message_warning("Could not determine number of available processor cores!\n"
+                             "Defaulting to serial computation");
+        jobs = 1;
+      }
+    } else {
+      jobs = MIN2(thread_max, args_info.jobs_arg);
+    }
+
+    jobs = MAX2(1, jobs);
+#else
+    vrna_message_warning(
+      "This version of RNApdist has been built without parallel input processing capabilities");
+#endif
+  }
+
   /* free allocated memory of command line data structure */
   RNApdist_cmdline_parser_free(&args_info);
 
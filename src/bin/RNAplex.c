@@ -14,6 +14,7 @@
 #include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdarg.h>
 #include <string.h>
 #include <time.h>
 #include <sys/types.h>
@@ -33,7 +34,10 @@
 #include "ViennaRNA/plotting/alignments.h"
 #include "ViennaRNA/params/io.h"
 #include "ViennaRNA/io/utils.h"
+#include "ViennaRNA/datastructures/char_stream.h"
+#include "ViennaRNA/datastructures/stream_output.h"
 #include "RNAplex_cmdl.h"
+#include "parallel_helpers.h"
 
 
 clock_t
@@ -154,10 +158,252 @@ double probcompute_newparameters(char   *s1,
 static int convert_plfold_i(char *fname);/* convert test accessibility into bin accessibility. */
 
 
+struct plex_options {
+  int                 jobs;
+  int                 keep_order;
+  unsigned int        next_record_number;
+  vrna_ostream_t      output_queue;
+  vrna_plex_context_t ctx;                /* context re-used for all jobs in serial mode */
+  vrna_md_t           md;
+
+  int                 threshold;
+  int                 extension_cost;
+  int                 alignment_length;
+  int                 delta;
+  int                 fast;
+  int                 il_a, il_b, b_a, b_b;
+};
+
+/* target sequence data shared by all jobs of the same target */
+struct plex_target {
+  char          *id;
+  char          *sequence;
+  int           **access;
+  unsigned int  ref_count;
+};
+
+/* a single target/query pair */
+struct plex_job {
+  unsigned int        number;
+  struct plex_target  *target;
+  char                *id;
+  char                *sequence;
+  int                 **access;
+  struct plex_options *options;
+};
+
+
+static struct plex_target *plex_target_init(char  *id,
+                                            char  *sequence,
+                                            int   **access);
+
+
+static void plex_target_release(struct plex_target *target);
+
+
+static void schedule_plex_job(struct plex_options *opt,
+                              struct plex_target  *target,
+                              char                *id,
+                              char                *sequence,
+                              int                 **access);
+
+
+static void process_plex_job(struct plex_job *job);
+
+
+static void print_plex_message(struct plex_options  *opt,
+                               const char           *format,
+                               ...);
+
+
+static void free_accessibility(int **access);
+
+
 static char scale[] = "....,....1....,....2....,....3....,....4"
                       "....,....5....,....6....,....7....,....8";
 
 /*--------------------------------------------------------------------------*/
+static void
+flush_cstr_callback(void          *auxdata,
+                    unsigned int  i,
+                    void          *data)
+{
+  vrna_cstr_t s = (vrna_cstr_t)data;
+
+  /* flush and free the output of a single job */
+  vrna_cstr_free(s);
+}
+
+
+static struct plex_target *
+plex_target_init(char *id,
+                 char *sequence,
+                 int  **access)
+{
+  struct plex_target *target;
+
+  target            = (struct plex_target *)vrna_alloc(sizeof(struct plex_target));
+  target->id        = id;
+  target->sequence  = sequence;
+  target->access    = access;
+  target->ref_count = 1;
+
+  return target;
+}
+
+
+static void
+plex_target_release(struct plex_target *target)
+{
+  unsigned int remaining;
+
+  ATOMIC_BLOCK(remaining = --target->ref_count);
+
+  if (remaining == 0) {
+    free(target->id);
+    free(target->sequence);
+    free_accessibility(target->access);
+    free(target);
+  }
+}
+
+
+static void
+free_accessibility(int **access)
+{
+  int i;
+
+  if (access) {
+    i = access[0][0];
+    while (--i > -1)
+      free(access[i]);
+    free(access);
+  }
+}
+
+
+static void
+schedule_plex_job(struct plex_options *opt,
+                  struct plex_target  *target,
+                  char                *id,
+                  char                *sequence,
+                  int                 **access)
+{
+  struct plex_job *job;
+
+  job           = (struct plex_job *)vrna_alloc(sizeof(struct plex_job));
+  job->number   = opt->next_record_number;
+  job->target   = target;
+  job->id       = id;
+  job->sequence = sequence;
+  job->access   = access;
+  job->options  = opt;
+
+  ATOMIC_BLOCK(target->ref_count++);
+
+  if (opt->output_queue)
+    vrna_ostream_request(opt->output_queue, opt->next_record_number++);
+
+  RUN_IN_PARALLEL(process_plex_job, job);
+}
+
+
+static void
+process_plex_job(struct plex_job *job)
+{
+  struct plex_options *opt;
+  struct plex_target  *target;
+  vrna_plex_context_t ctx;
+  vrna_cstr_t         output;
+
+  opt     = job->options;
+  target  = job->target;
+  ctx     = (opt->ctx) ? opt->ctx : vrna_plex_context_init(&(opt->md));
+
+  /* in serial mode, results are printed to stdout directly */
+  if (opt->jobs > 1) {
+    output = vrna_cstr(4096, stdout);
+    vrna_cstr_printf(output, ">%s\n>%s\n", target->id, job->id);
+  } else {
+    output = NULL;
+    printf(">%s\n>%s\n", target->id, job->id);
+  }
+
+  if (target->access) {
+    vrna_Lduplexfold_XS(ctx,
+                        output,
+                        target->sequence,
+                        job->sequence,
+                        (const int **)target->access,
+                        (const int **)job->access,
+                        opt->threshold,
+                        opt->alignment_length,
+                        opt->delta,
+                        opt->fast,
+                        opt->il_a,
+                        opt->il_b,
+                        opt->b_a,
+                        opt->b_b);
+  } else {
+    vrna_Lduplexfold(ctx,
+                     output,
+                     target->sequence,
+                     job->sequence,
+                     opt->threshold,
+                     opt->extension_cost,
+                     opt->alignment_length,
+                     opt->delta,
+                     opt->fast,
+                     opt->il_a,
+                     opt->il_b,
+                     opt->b_a,
+                     opt->b_b);
+  }
+
+  if (opt->output_queue)
+    vrna_ostream_provide(opt->output_queue, job->number, (void *)output);
+  else if (output)
+    ATOMIC_BLOCK(flush_cstr_callback(NULL, job->number, (void *)output));
+
+  if (ctx != opt->ctx)
+    vrna_plex_context_free(ctx);
+
+  free(job->id);
+  free(job->sequence);
+  free_accessibility(job->access);
+  plex_target_release(target);
+  free(job);
+}
+
+
+static void
+print_plex_message(struct plex_options  *opt,
+                   const char           *format,
+                   ...)
+{
+  va_list     args;
+  vrna_cstr_t output;
+
+  va_start(args, format);
+
+  if (opt->jobs > 1) {
+    /* keep messages in order with the output of the jobs */
+    output = vrna_cstr(256, stdout);
+    vrna_cstr_vprintf(output, format, args);
+
+    if (opt->output_queue) {
+      vrna_ostream_request(opt->output_queue, opt->next_record_number);
+      vrna_ostream_provide(opt->output_queue, opt->next_record_number++, (void *)output);
+    } else {
+      ATOMIC_BLOCK(flush_cstr_callback(NULL, 0, (void *)output));
+    }
+  } else {
+    vprintf(format, args);
+  }
+
+  va_end(args);
+}
+
 
 int
 main(int  argc,
@@ -211,6 +457,8 @@ main(int  argc,
   double                          k_concentration     = 0;
   double                          tris_concentration  = 0;
   int                             probe_mode          = 0;
+  struct plex_options             opt;
+
   /*
    #############################################
    # check the command line parameters
@@ -219,6 +467,12 @@ main(int  argc,
   if (RNAplex_cmdline_parser(argc, argv, &args_info) != 0)
     exit(1);
 
+  opt.jobs                = 1;
+  opt.keep_order          = 1;
+  opt.next_record_number  = 0;
+  opt.output_queue        = NULL;
+  opt.ctx                 = NULL;
+
   /*temperature*/
   if (args_info.temp_given)
     temperature = args_info.temp_arg;
@@ -279,6 +533,45 @@ main(int  argc,
   if (args_info.probe_mode_given)
     probe_mode = 1;
 
+  /*parallel processing of target/query pairs*/
+  if (args_info.jobs_given) {
+#if VRNA_WITH_PTHREADS
+    int thread_max = max_user_threads();
+    if (args_info.jobs_arg == 0) {
+      /* use maximum of concurrent threads */
+      int proc_cores, proc_cores_conf;
+      if (num_proc_cores(&proc_cores, &proc_cores_conf)) {
+        opt.jobs = MIN2(thread_max, proc_cores_conf);
+      } else {
+        vrna_message_warning("Could not determine number of available processor cores!\n"
+                             "Defaulting to serial computation");
+        opt.jobs = 1;
+      }
+    } else {
+      opt.jobs = MIN2(thread_max, args_info.jobs_arg);
+    }
+
+    opt.jobs = MAX2(1, opt.jobs);
+#else
+    vrna_message_warning(
+      "This version of RNAplex has been built without parallel input processing capabilities");
+#endif
+
+    if (args_info.unordered_given)
+      opt.keep_order = 0;
+
+    if ((opt.jobs > 1) &&
+        ((!(args_info.query_given && args_info.target_given)) ||
+         (fold_constrained) ||
+         (alignment_mode) ||
+         (probe_mode))) {
+      vrna_message_warning("Parallel processing is only available for target and query files "
+                           "without constraints or alignments\n"
+                           "Defaulting to serial computation");
+      opt.jobs = 1;
+    }
+  }
+
   /*sodium concentration*/
   na_concentration = args_info.na_concentration_arg;
   /*magnesium concentration*/
@@ -323,6 +616,18 @@ main(int  argc,
 
   int il_a, il_b, b_a, b_b;
   linear_fit(&il_a, &il_b, &b_a, &b_b);
+
+  set_model_details(&(opt.md));
+  opt.threshold         = delta;
+  opt.extension_cost    = extension_cost;
+  opt.alignment_length  = alignment_length;
+  opt.delta             = deltaz;
+  opt.fast              = fast;
+  opt.il_a              = il_a;
+  opt.il_b              = il_b;
+  opt.b_a               = b_a;
+  opt.b_b               = b_b;
+
   /**
    * check if we have two input files
    */
@@ -548,8 +853,18 @@ main(int  argc,
     RNAplex_cmdline_parser_free(&args_info);
 
     if (!fold_constrained) {
+      if (opt.jobs > 1) {
+        if (opt.keep_order) {
+          opt.output_queue = vrna_ostream_init(&flush_cstr_callback, NULL);
+          vrna_ostream_set_window(opt.output_queue, MAX_JOBS_IN_FLIGHT(opt.jobs));
+        }
+      } else {
+        opt.ctx = vrna_plex_context_init(&(opt.md));
+      }
+
       if (access) {
-        char *id_s1 = NULL;
+        char                *id_s1 = NULL;
+        struct plex_target  *target;
         mRNA = fopen(tname, "r");
         if (mRNA == NULL) {
           printf("%s: Wrong target file name\n", tname);
@@ -564,6 +879,8 @@ main(int  argc,
           return 0;
         }
 
+        INIT_PARALLELIZATION(opt.jobs);
+
         do {
           /* main loop: continue until end of file */
           if ((line_t = vrna_read_line(mRNA)) == NULL)
@@ -629,7 +946,7 @@ main(int  argc,
           }
 
           if (access_s1 == NULL) {
-            printf("Accessibility file %s not found or corrupt, look at next target RNA\n", file_s1);
+            print_plex_message(&opt, "Accessibility file %s not found or corrupt, look at next target RNA\n", file_s1);
             free(file_s1);
             free(s1);
             free(id_s1);
@@ -637,6 +954,10 @@ main(int  argc,
             continue;
           }
 
+          /* the target data is released by the last job that uses it */
+          target  = plex_target_init(id_s1, s1, access_s1);
+          id_s1   = NULL;
+
           do {
             char *id_s2 = NULL;
             if ((line_q = vrna_read_line(sRNA)) == NULL)
@@ -703,7 +1024,7 @@ main(int  argc,
             }
 
             if (access_s2 == NULL) {
-              printf("Accessibility file %s not found, look at next target RNA\n", file_s2);
+              print_plex_message(&opt, "Accessibility file %s not found, look at next target RNA\n", file_s2);
               free(file_s2);
               free(s2);
               free(id_s2);
@@ -711,33 +1032,16 @@ main(int  argc,
               continue;
             }
 
-            printf(">%s\n>%s\n", id_s1, id_s2);
-            double  begin = BeginTimer();
-            Lduplexfold_XS(s1, s2, (const int **)access_s1, (const int **)access_s2, delta, alignment_length, deltaz, fast, il_a, il_b, b_a, b_b);
-            float   elapTicks;
-            float   elapMilli;
-            elapTicks = (EndTimer(begin) - begin);
-            elapMilli = elapTicks / 1000;
-            /*             printf("Millisecond %.2f\n",elapMilli); */
-            free(id_s2);
+            schedule_plex_job(&opt, target, id_s2, s2, access_s2);
             free(file_s2);
-            free(s2);
             id_s2 = NULL;
-            i     = access_s2[0][0];
-            while (--i > -1)
-              free(access_s2[i]);
-            free(access_s2);
           } while (1);
-          free(id_s1);
-          id_s1 = NULL;
+          plex_target_release(target);
           free(file_s1);
-          free(s1);
           rewind(sRNA);
-          i = access_s1[0][0];
-          while (--i > -1)
-            free(access_s1[i]);
-          free(access_s1);
         } while (1);
+
+        UNINIT_PARALLELIZATION
         fclose(mRNA);
         fclose(sRNA);
       } else if (access == NULL) {
@@ -756,9 +1060,12 @@ main(int  argc,
           return 0;
         }
 
+        INIT_PARALLELIZATION(opt.jobs);
+
         do {
           /* main loop: continue until end of file */
-          char *id_s1 = NULL; /* header of the target file  */
+          char                *id_s1 = NULL; /* header of the target file  */
+          struct plex_target  *target;
           if ((line_t = vrna_read_line(mRNA)) == NULL)
             break;
 
@@ -806,6 +1113,9 @@ main(int  argc,
             if (!noconv && s1[l] == 'T')
               s1[l] = 'U';
           }
+
+          /* the target data is released by the last job that uses it */
+          target = plex_target_init(id_s1, s1, NULL);
           do {
             /*read sRNA files*/
             char *id_s2 = NULL;
@@ -856,27 +1166,20 @@ main(int  argc,
               if (!noconv && s2[l] == 'T')
                 s2[l] = 'U';
             }
-            printf(">%s\n>%s\n", id_s1, id_s2);
-            /*             double begin = BeginTimer(); */
-            Lduplexfold(s1, s2, delta, extension_cost, alignment_length, deltaz, fast, il_a, il_b, b_a, b_b);
-            /* float elapTicks; */
-            /* float elapMilli; */
-            /* elapTicks = (EndTimer(begin) - begin); */
-            /* elapMilli = elapTicks/1000; */
-            /* printf("Millisecond %.2f\n",elapMilli); */
-            /* printf("\n"); */
-            free(id_s2);
+            schedule_plex_job(&opt, target, id_s2, s2, NULL);
             id_s2 = NULL;
-            free(s2);
           } while (1);
-          free(id_s1);
-          id_s1 = NULL;
-          free(s1);
+          plex_target_release(target);
           rewind(sRNA);
         } while (1);
+
+        UNINIT_PARALLELIZATION
         fclose(mRNA);
         fclose(sRNA);
       }
+
+      vrna_ostream_free(opt.output_queue);
+      vrna_plex_context_free(opt.ctx);
     } else {
       if (access) {
         char *id_s1 = NULL;
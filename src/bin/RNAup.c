@@ -14,6 +14,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdarg.h>
 #include <math.h>
 #include <ctype.h>
 #include <unistd.h>
@@ -33,7 +34,10 @@
 #include "ViennaRNA/constraints/basic.h"
 #include "ViennaRNA/constraints/hard.h"
 #include "ViennaRNA/constraints/soft.h"
+#include "ViennaRNA/datastructures/char_stream.h"
+#include "ViennaRNA/datastructures/stream_output.h"
 #include "RNAup_cmdl.h"
+#include "parallel_helpers.h"
 
 #define MIN(x, y) (((x) < (y)) ? (x) : (y))
 #define MAX(x, y) (((x) > (y)) ? (x) : (y))
@@ -50,18 +54,21 @@ PRIVATE void    seperate_bp(char  **inter,
                             char  **intra_s);
 
 
-PRIVATE void    print_interaction(interact    *Int,
-                                  char        *s1,
-                                  char        *s2,
-                                  pu_contrib  *p_c,
-                                  pu_contrib  *p_c2,
-                                  int         w,
-                                  int         incr3,
-                                  int         incr5);
+PRIVATE void    print_interaction(vrna_cstr_t           output,
+                                  vrna_duplex_context_t ctx,
+                                  interact              *Int,
+                                  char                  *s1,
+                                  char                  *s2,
+                                  pu_contrib            *p_c,
+                                  pu_contrib            *p_c2,
+                                  int                   w,
+                                  int                   incr3,
+                                  int                   incr5);
 
 
-PRIVATE void    print_unstru(pu_contrib *p_c,
-                             int        w);
+PRIVATE void    print_unstru(vrna_cstr_t  output,
+                             pu_contrib   *p_c,
+                             int          w);
 
 
 PRIVATE int     compare_unpaired_values(const void  *p1,
@@ -79,6 +86,335 @@ PRIVATE void    adjustUnpairedValues(int ***unpaired_values); /* this function s
 PRIVATE int     default_u; /* -u options for plotting: plot pr_unpaired for 4 nucleotides */
 PRIVATE double  RT;
 
+
+struct up_options {
+  int               jobs;
+  int               keep_order;
+  unsigned int      next_record_number;
+  vrna_ostream_t    output_queue;
+  vrna_md_t         md;
+
+  int               w;
+  int               incr3;
+  int               incr5;
+  double            sfact;
+  int               **unpaired_values;
+  char              *my_contrib;
+
+  /* target of the interaction_first mode, shared read-only by all jobs */
+  char              *s_target;
+  char              *orig_target;
+  int               length_target;
+  pu_contrib        *unstr_target;
+};
+
+/* output of a single input record */
+struct up_result {
+  unsigned int  up_mode;
+  vrna_cstr_t   output;
+  char          *name;
+  char          *head;
+  pu_contrib    *contrib1;
+  pu_contrib    *contrib2;
+  interact      *inter_out;
+};
+
+/* a single input record */
+struct up_job {
+  unsigned int      number;
+  unsigned int      up_mode;
+  char              *s1;
+  char              *s2;
+  char              *orig_s1;
+  char              *orig_s2;
+  char              *cstruc1;
+  char              *cstruc_combined;
+  int               length1;
+  int               wplus;
+  struct up_result  *result;
+  struct up_options *options;
+};
+
+
+PRIVATE pu_contrib *compute_unstru(struct up_options  *opt,
+                                   const char         *sequence,
+                                   const char         *constraint,
+                                   int                wplus);
+
+
+PRIVATE void        schedule_up_job(struct up_options *opt,
+                                    struct up_job     *job);
+
+
+PRIVATE void        process_up_job(struct up_job *job);
+
+
+PRIVATE void        submit_up_result(struct up_options  *opt,
+                                     unsigned int       number,
+                                     struct up_result   *result);
+
+
+PRIVATE void        up_printf(vrna_cstr_t output,
+                              const char  *format,
+                              ...);
+
+
+/*--------------------------------------------------------------------------*/
+void
+flush_up_result(void          *auxdata,
+                unsigned int  i,
+                void          *data)
+{
+  struct up_options *opt    = (struct up_options *)auxdata;
+  struct up_result  *result = (struct up_result *)data;
+
+  /* create additional output */
+  if (result->name)
+    up_printf(result->output, "RNAup output in file: %s\n", result->name);
+
+  /* flush and free the output of a single record */
+  vrna_cstr_free(result->output);
+
+  if (result->name) {
+    Up_plot(result->contrib1,
+            result->contrib2,
+            result->inter_out,
+            result->name,
+            opt->unpaired_values,
+            opt->my_contrib,
+            result->head,
+            result->up_mode);
+  }
+
+  /* the pu contribution structure of the target sequence is re-used for all records */
+  if (result->contrib1 != opt->unstr_target)
+    free_pu_contrib_struct(result->contrib1);
+
+  if (result->contrib2 != opt->unstr_target)
+    free_pu_contrib_struct(result->contrib2);
+
+  if (result->inter_out != NULL)
+    free_interact(result->inter_out);
+
+  free(result->name);
+  free(result->head);
+  free(result);
+}
+
+
+PRIVATE void
+up_printf(vrna_cstr_t output,
+          const char  *format,
+          ...)
+{
+  va_list args;
+
+  va_start(args, format);
+
+  /* in serial mode, results are printed to stdout directly */
+  if (output)
+    vrna_cstr_vprintf(output, format, args);
+  else
+    vprintf(format, args);
+
+  va_end(args);
+}
+
+
+PRIVATE pu_contrib *
+compute_unstru(struct up_options  *opt,
+               const char         *sequence,
+               const char         *constraint,
+               int                wplus)
+{
+  int                   length;
+  double                min_en;
+  vrna_exp_param_t      *pf_params;
+  vrna_fold_compound_t  *fc;
+  pu_contrib            *unstr;
+
+  length  = (int)strlen(sequence);
+  fc      = vrna_fold_compound(sequence, &(opt->md), VRNA_OPTION_DEFAULT);
+
+  if (constraint != NULL) {
+    vrna_constraints_add(fc,
+                         constraint,
+                         VRNA_CONSTRAINT_DB
+                         | VRNA_CONSTRAINT_DB_PIPE
+                         | VRNA_CONSTRAINT_DB_DOT
+                         | VRNA_CONSTRAINT_DB_X
+                         | VRNA_CONSTRAINT_DB_ANG_BRACK
+                         | VRNA_CONSTRAINT_DB_RND_BRACK);
+  }
+
+  /* calc mfe to determine a reasonable scaling factor */
+  min_en = (double)vrna_mfe(fc, NULL);
+
+  pf_params           = vrna_exp_params(&(opt->md));
+  pf_params->pf_scale = exp(-(opt->sfact * min_en) / RT / length);
+  if (length > 2000)
+    vrna_message_info(stderr, "scaling factor %f", pf_params->pf_scale);
+
+  vrna_exp_params_subst(fc, pf_params);
+  free(pf_params);
+
+  (void)vrna_pf(fc, NULL);
+  unstr = vrna_pf_unstru(fc, wplus);
+
+  vrna_fold_compound_free(fc);
+
+  return unstr;
+}
+
+
+PRIVATE void
+schedule_up_job(struct up_options *opt,
+                struct up_job     *job)
+{
+  job->number   = opt->next_record_number;
+  job->options  = opt;
+
+  if (opt->output_queue)
+    vrna_ostream_request(opt->output_queue, opt->next_record_number++);
+
+  RUN_IN_PARALLEL(process_up_job, job);
+}
+
+
+PRIVATE void
+process_up_job(struct up_job *job)
+{
+  int                   i, j, w, incr3, incr5;
+  struct up_options     *opt;
+  struct up_result      *result;
+  vrna_duplex_context_t ctx;
+  pu_contrib            *unstr_out;
+  interact              *inter_out;
+
+  opt       = job->options;
+  result    = job->result;
+  w         = opt->w;
+  incr3     = opt->incr3;
+  incr5     = opt->incr5;
+  inter_out = NULL;
+  ctx       = NULL;
+
+  /* calc probability to be unstructured for 1st sequence (in upmode=3 this is not the target!) */
+  unstr_out = compute_unstru(opt, job->s1, job->cstruc1, job->wplus);
+
+  if (!(job->up_mode & RNA_UP_MODE_1))
+    ctx = vrna_duplex_context_init(&(opt->md));
+
+  switch (job->up_mode) {
+    case RNA_UP_MODE_1:
+      for (i = 1; i <= opt->unpaired_values[0][0]; i++) {
+        j = opt->unpaired_values[i][0];
+        do
+          print_unstru(result->output, unstr_out, j);
+        while (++j <= opt->unpaired_values[i][1]);
+      }
+      result->contrib1 = unstr_out;
+      break;
+    case RNA_UP_MODE_2:
+      inter_out = vrna_pf_interact(job->s1,
+                                   job->s2,
+                                   unstr_out,
+                                   NULL,
+                                   w,
+                                   job->cstruc_combined,
+                                   incr3,
+                                   incr5,
+                                   &(opt->md));
+      print_interaction(result->output,
+                        ctx,
+                        inter_out,
+                        job->orig_s1,
+                        job->orig_s2,
+                        unstr_out,
+                        NULL,
+                        w,
+                        incr3,
+                        incr5);
+      result->contrib1 = unstr_out;
+      break;
+    case RNA_UP_MODE_3:
+      /* check if target sequence is actually longer than query, if not rotate both sequences */
+      if (opt->length_target < job->length1) {
+        inter_out = vrna_pf_interact(job->s1,
+                                     opt->s_target,
+                                     unstr_out,
+                                     opt->unstr_target,
+                                     w,
+                                     job->cstruc_combined,
+                                     incr3,
+                                     incr5,
+                                     &(opt->md));
+        print_interaction(result->output,
+                          ctx,
+                          inter_out,
+                          job->orig_s1,
+                          opt->orig_target,
+                          unstr_out,
+                          opt->unstr_target,
+                          w,
+                          incr3,
+                          incr5);
+        result->contrib1  = unstr_out;
+        result->contrib2  = opt->unstr_target;
+      } else {
+        inter_out = vrna_pf_interact(opt->s_target,
+                                     job->s1,
+                                     opt->unstr_target,
+                                     unstr_out,
+                                     w,
+                                     job->cstruc_combined,
+                                     incr3,
+                                     incr5,
+                                     &(opt->md));
+        print_interaction(result->output,
+                          ctx,
+                          inter_out,
+                          opt->orig_target,
+                          job->orig_s1,
+                          opt->unstr_target,
+                          unstr_out,
+                          w,
+                          incr3,
+                          incr5);
+        result->contrib1  = opt->unstr_target;
+        result->contrib2  = unstr_out;
+      }
+
+      break;
+  }
+
+  result->inter_out = inter_out;
+
+  submit_up_result(opt, job->number, result);
+
+  vrna_duplex_context_free(ctx);
+
+  free(job->s1);
+  free(job->s2);
+  free(job->orig_s1);
+  free(job->orig_s2);
+  free(job->cstruc1);
+  free(job->cstruc_combined);
+  free(job);
+}
+
+
+PRIVATE void
+submit_up_result(struct up_options  *opt,
+                 unsigned int       number,
+                 struct up_result   *result)
+{
+  if (opt->output_queue)
+    vrna_ostream_provide(opt->output_queue, number, (void *)result);
+  else
+    ATOMIC_BLOCK(flush_up_result((void *)opt, number, (void *)result));
+}
+
 /*--------------------------------------------------------------------------*/
 int
 main(int  argc,
@@ -88,17 +424,16 @@ main(int  argc,
   unsigned int            input_type, up_mode;
   char                    my_contrib[10], *up_out, *name, fname1[FILENAME_MAX_LENGTH],
                           fname2[FILENAME_MAX_LENGTH], fname_target[FILENAME_MAX_LENGTH], *ParamFile,
-                          *ns_bases, *c, *structure, *head, *input_string, *s1, *s2, *s3, *s_target, *cstruc1,
+                          *ns_bases, *c, *head, *input_string, *s1, *s2, *s3, *s_target, *cstruc1,
                           *cstruc2, *cstruc_target, *cstruc_combined, *cmdl_parameters, *orig_s1, *orig_s2,
                           *orig_target;
-  int                     i, j, length1, length2, length_target, sym, istty,
+  int                     i, length1, length2, length_target, sym, istty,
                           rotated, noconv, max_u, **unpaired_values, ulength_num;
-  double                  min_en, sfact;
-
-  /* variables for output */
-  pu_contrib              *unstr_out, *unstr_short, *unstr_target, *contrib1, *contrib2;
-  interact                *inter_out;
-  /* pu_out *longer; */
+  double                  sfact;
+  struct up_options       opt;
+  struct up_job           *job;
+  struct up_result        *result;
+  vrna_cstr_t             o_stream;
 
   /* commandline parameters */
   int                     w       = 25; /* length of region of interaction */
@@ -124,11 +459,14 @@ main(int  argc,
   rotated         = 0;
   input_string    = s1 = s2 = s3 = s_target = cstruc1 = cstruc2 = cstruc_target = cstruc_combined = NULL;
   length1         = length2 = length_target = 0;
-  inter_out       = NULL;
-  unstr_out       = unstr_short = unstr_target = contrib1 = contrib2 = NULL;
-  structure       = ParamFile = ns_bases = head = orig_s1 = orig_s2 = orig_target = NULL;
-  up_out          = NULL;
+  ParamFile       = ns_bases = head = orig_s1 = orig_s2 = orig_target = NULL;
+  up_out          = name = NULL;
+  o_stream        = NULL;
   fname_target[0] = '\0';
+
+  memset(&opt, 0, sizeof(struct up_options));
+  opt.jobs        = 1;
+  opt.keep_order  = 1;
   /* allocate init length for commandline parameter string */
 
   cmdl_parameters = NULL;
@@ -348,6 +686,34 @@ main(int  argc,
    * WARNING: after this step ulength_num may not reflect actual number of ulength values anymore */
   adjustUnpairedValues(&unpaired_values);
 
+  /* parallel processing of input records */
+  if (args_info.jobs_given) {
+#if VRNA_WITH_PTHREADS
+    int thread_max = max_user_threads();
+    if (args_info.jobs_arg == 0) {
+      /* use maximum of concurrent threads */
+      int proc_cores, proc_cores_conf;
+      if (num_proc_cores(&proc_cores, &proc_cores_conf)) {
+        opt.jobs = MIN2(thread_max, proc_cores_conf);
+      } else {
+        vrna_message_warning("Could not determine number of available processor cores!\n"
+                             "Defaulting to serial computation");
+        opt.jobs = 1;
+      }
+    } else {
+      opt.jobs = MIN2(thread_max, args_info.jobs_arg);
+    }
+
+    opt.jobs = MAX2(1, opt.jobs);
+#else
+    vrna_message_warning(
+      "This version of RNAup has been built without parallel input processing capabilities");
+#endif
+
+    if (args_info.unordered_given)
+      opt.keep_order = 0;
+  }
+
   /* free allocated memory of command line data structure */
   RNAup_cmdline_parser_free(&args_info);
 
@@ -397,6 +763,22 @@ main(int  argc,
   }
 
   RT = ((temperature + K0) * GASCONST / 1000.0);
+
+  set_model_details(&(opt.md));
+  opt.w               = w;
+  opt.incr3           = incr3;
+  opt.incr5           = incr5;
+  opt.sfact           = sfact;
+  opt.unpaired_values = unpaired_values;
+  opt.my_contrib      = my_contrib;
+
+  if ((opt.jobs > 1) && (opt.keep_order)) {
+    opt.output_queue = vrna_ostream_init(&flush_up_result, (void *)&opt);
+    vrna_ostream_set_window(opt.output_queue, MAX_JOBS_IN_FLIGHT(opt.jobs));
+  }
+
+  INIT_PARALLELIZATION(opt.jobs);
+
   /*
    #############################################
    # main loop: continue until end of file
@@ -407,6 +789,10 @@ main(int  argc,
     cut_point = -1;
     fname1[0] = '\0';
     fname2[0] = '\0';
+
+    /* in parallel mode, output of this record is buffered */
+    if ((opt.jobs > 1) && (o_stream == NULL))
+      o_stream = vrna_cstr(4096, stdout);
     /*
      ########################################################
      # handle user input from 'stdin'
@@ -439,7 +825,7 @@ main(int  argc,
     /* extract filename from fasta header if available */
     while ((input_type = get_input_line(&input_string, 0)) & VRNA_INPUT_FASTA_HEADER) {
       (void)sscanf(input_string, "%" XSTR(FILENAME_ID_LENGTH) "s", fname1);
-      printf(">%s\n", input_string); /* print fasta header if available */
+      up_printf(o_stream, ">%s\n", input_string); /* print fasta header if available */
       free(input_string);
     }
 
@@ -490,7 +876,7 @@ main(int  argc,
       /* extract filename from fasta header if available */
       while ((input_type = get_input_line(&input_string, 0)) & VRNA_INPUT_FASTA_HEADER) {
         (void)sscanf(input_string, "%" XSTR(FILENAME_ID_LENGTH) "s", fname2);
-        printf(">%s\n", input_string); /* print fasta header if available */
+        up_printf(o_stream, ">%s\n", input_string); /* print fasta header if available */
         free(input_string);
       }
       /* break on any error, EOF or quit request */
@@ -668,20 +1054,6 @@ main(int  argc,
     if (!(up_mode & RNA_UP_MODE_1))
       vrna_strcat_printf(&up_out, "_w%d", w);
 
-    structure = (char *)vrna_alloc(sizeof(char) * (MAX2(length_target, MAX2(length1, length2)) + 1));
-
-
-    /* begin actual computations */
-    update_fold_params();
-
-    /* calc mfe of first sequence */
-    if (cstruc1 != NULL)
-      strncpy(structure, cstruc1, length1 + 1);
-
-    min_en = fold(s1, structure);
-
-    (void)fflush(stdout);
-
     /* calc probability to be unstructured for 1st sequence (in upmode=3 this is not the target!) */
 
     int wplus = w;
@@ -696,150 +1068,99 @@ main(int  argc,
     if (length1 < wplus)
       wplus = length1;
 
-    /* calc mfe for first sequence (2nd if upmode = 3) */
-    if (cstruc1 != NULL)
-      strncpy(structure, cstruc1, length1 + 1);
-
-    min_en    = fold(s1, structure);
-    pf_scale  = exp(-(sfact * min_en) / RT / length1);
-    if (length1 > 2000)
-      vrna_message_info(stderr, "scaling factor %f", pf_scale);
-
-    if (cstruc1 != NULL)
-      strncpy(structure, cstruc1, length1 + 1);
-
-    (void) pf_fold(s1, structure);
-    unstr_out = pf_unstru(s1, wplus);
-    free_pf_arrays();
-
     if (fold_constrained && !(up_mode & RNA_UP_MODE_1)) {
       cstruc_combined = (char *)vrna_alloc(sizeof(char) * (length1 + length2 + 1));
       strncpy(cstruc_combined, cstruc1, length1 + 1);
       strcat(cstruc_combined, cstruc2);
     }
 
-    contrib1  = contrib2 = NULL;
-    inter_out = NULL;
+    /* calc prob. unstruct. for target seq only once, it is shared by all jobs */
+    if ((up_mode & RNA_UP_MODE_3) && (opt.unstr_target == NULL)) {
+      int wplus_target = w + incr3 + incr5;
+      if (max_u > wplus_target)
+        wplus_target = max_u;
 
-    switch (up_mode) {
-      case RNA_UP_MODE_1:
-        for (i = 1; i <= unpaired_values[0][0]; i++) {
-          j = unpaired_values[i][0];
-          do
-            print_unstru(unstr_out, j);
-          while (++j <= unpaired_values[i][1]);
-        }
-        if (output && header)
-          head = vrna_strdup_printf("# %s\n# %d %s\n# %s", cmdl_parameters, length1, fname1, orig_s1);
+      if (length_target < wplus_target)
+        wplus_target = length_target;
 
-        contrib1 = unstr_out;
-        break;
-      case RNA_UP_MODE_2:
-        inter_out = pf_interact(s1, s2, unstr_out, NULL, w, cstruc_combined, incr3, incr5);
-        print_interaction(inter_out, orig_s1, orig_s2, unstr_out, NULL, w, incr3, incr5);
-        if (output && header)
-          head = vrna_strdup_printf("# %s\n# %d %s\n# %s\n# %d %s\n# %s", cmdl_parameters, length1, fname1, orig_s1, length2, fname2, orig_s2);
-
-        contrib1 = unstr_out;
-        break;
-      case RNA_UP_MODE_3:   /* calculate prob. unstruct. for target seq */
-        if (unstr_target == NULL) {
-          wplus = w + incr3 + incr5;
-          if (max_u > wplus)
-            wplus = max_u;
-
-          if (length_target < wplus)
-            wplus = length_target;
-
-          if (cstruc_target != NULL)
-            strncpy(structure, cstruc_target, length_target + 1);
-
-          min_en    = fold(s_target, structure);
-          pf_scale  = exp(-(sfact * min_en) / RT / length_target);
-          if (length_target > 2000)
-            vrna_message_info(stderr, "scaling factor %f", pf_scale);
-
-          if (cstruc_target != NULL)
-            strncpy(structure, cstruc_target, length_target + 1);
-
-          (void) pf_fold(s_target, structure);
-          unstr_target  = pf_unstru(s_target, wplus);
-          free_pf_arrays();                     /* for arrays for pf_fold(...) */
-        }
-
-        /* check if target sequence is actually longer than query, if not rotate both sequences */
-        if (length_target < length1) {
-          inter_out = pf_interact(s1, s_target, unstr_out, unstr_target, w, cstruc_combined, incr3, incr5);
-          print_interaction(inter_out, orig_s1, orig_target, unstr_out, unstr_target, w, incr3, incr5);
-          contrib1  = unstr_out;
-          contrib2  = unstr_target;
-        } else {
-          inter_out = pf_interact(s_target, s1, unstr_target, unstr_out, w, cstruc_combined, incr3, incr5);
-          print_interaction(inter_out, orig_target, orig_s1, unstr_target, unstr_out, w, incr3, incr5);
-          contrib1  = unstr_target;
-          contrib2  = unstr_out;
-        }
+      opt.s_target      = s_target;
+      opt.orig_target   = orig_target;
+      opt.length_target = length_target;
+      opt.unstr_target  = compute_unstru(&opt, s_target, cstruc_target, wplus_target);
+    }
 
-        if (output && header)
+    if (output && header) {
+      switch (up_mode) {
+        case RNA_UP_MODE_1:
+          head = vrna_strdup_printf("# %s\n# %d %s\n# %s", cmdl_parameters, length1, fname1, orig_s1);
+          break;
+        case RNA_UP_MODE_2:
+          head = vrna_strdup_printf("# %s\n# %d %s\n# %s\n# %d %s\n# %s", cmdl_parameters, length1, fname1, orig_s1, length2, fname2, orig_s2);
+          break;
+        case RNA_UP_MODE_3:
           head = vrna_strdup_printf("# %s\n# %d %s\n# %s\n# %d %s\n# %s", cmdl_parameters, length_target, fname_target, orig_target, length1, fname1, orig_s1);
-
-        break;
+          break;
+      }
     }
 
-    /* create additional output */
-    if (output) {
-      /* how to best compose a reasonable filename */
-      printf("RNAup output in file: ");
-      /* since we do not limit the amount of ulength values anymore we just put
-       * the maximum length into the filename, the actual printed lengths
-       * should be somewhere in the output itself */
+    /* since we do not limit the amount of ulength values anymore we just put
+     * the maximum length into the filename, the actual printed lengths
+     * should be somewhere in the output itself */
+    if (output)
       name = vrna_strdup_printf("%s_u%d.out", up_out, unpaired_values[0][0]);
-      printf("%s\n", name);
 
-      Up_plot(contrib1, contrib2, inter_out, name, unpaired_values, my_contrib, head, up_mode);
-    }
+    /* hand over all data of this record to the actual computations */
+    result          = (struct up_result *)vrna_alloc(sizeof(struct up_result));
+    result->up_mode = up_mode;
+    result->output  = o_stream;
+    result->name    = name;
+    result->head    = head;
+
+    job                   = (struct up_job *)vrna_alloc(sizeof(struct up_job));
+    job->up_mode          = up_mode;
+    job->s1               = s1;
+    job->s2               = s2;
+    job->orig_s1          = orig_s1;
+    job->orig_s2          = orig_s2;
+    job->cstruc1          = cstruc1;
+    job->cstruc_combined  = cstruc_combined;
+    job->length1          = length1;
+    job->wplus            = wplus;
+    job->result           = result;
+
+    schedule_up_job(&opt, job);
 
     /*
      ########################################################
      # clean up
      ########################################################
      */
+    free(cstruc2);
+    free(up_out);
 
-    /* we can save the pu contribution structure of the target sequence for the next run */
-    if (unstr_target != NULL) {
-      if (length_target < length1)
-        free_pu_contrib_struct(contrib1);
-      else
-        free_pu_contrib_struct(contrib2);
-    } else {
-      if (contrib1 != NULL)
-        free_pu_contrib_struct(contrib1);
+    s1        = s2 = orig_s1 = orig_s2 = cstruc1 = cstruc2 = head = cstruc_combined = NULL;
+    up_out    = name = NULL;
+    o_stream  = NULL;
+  } while (1);
 
-      if (contrib2 != NULL)
-        free_pu_contrib_struct(contrib2);
-    }
+  /* flush output of an incomplete record, e.g. its FASTA header */
+  if (o_stream) {
+    result          = (struct up_result *)vrna_alloc(sizeof(struct up_result));
+    result->output  = o_stream;
 
-    if (inter_out != NULL)
-      free_interact(inter_out);
+    if (opt.output_queue)
+      vrna_ostream_request(opt.output_queue, opt.next_record_number);
 
-    /* free all unnecessary character arrays */
-    free(structure);
-    free(s1);
-    free(s2);
-    free(orig_s1);
-    free(orig_s2);
-    free(cstruc1);
-    free(cstruc2);
-    free(head);
-    free(cstruc_combined);
-    free(up_out);
-    free(name);
+    submit_up_result(&opt, opt.next_record_number++, result);
+  }
 
-    structure = s1 = s2 = orig_s1 = orig_s2 = cstruc1 = cstruc2 = head = cstruc_combined = NULL;
-    up_out    = name = NULL;
+  UNINIT_PARALLELIZATION
 
-    free_arrays(); /* for arrays for fold(...) */
-  } while (1);
+  vrna_ostream_free(opt.output_queue);
+  free_pu_contrib_struct(opt.unstr_target);
+  free(s_target);
+  free(orig_target);
+  free(cstruc_target);
   free(cmdl_parameters);
 
   return EXIT_SUCCESS;
@@ -1105,14 +1426,16 @@ seperate_bp(char  **inter,
 
 
 PRIVATE void
-print_interaction(interact    *Int,
-                  char        *s1,
-                  char        *s2,
-                  pu_contrib  *p_c,
-                  pu_contrib  *p_c2,
-                  int         w,
-                  int         incr3,
-                  int         incr5)
+print_interaction(vrna_cstr_t           output,
+                  vrna_duplex_context_t ctx,
+                  interact              *Int,
+                  char                  *s1,
+                  char                  *s2,
+                  pu_contrib            *p_c,
+                  pu_contrib            *p_c2,
+                  int                   w,
+                  int                   incr3,
+                  int                   incr5)
 {
   char    *i_long, *i_short;
   int     i, l_l, l_s, len1, end5, end3, i_min, j_min, l1, add_a, add_b, nix_up;
@@ -1136,7 +1459,7 @@ print_interaction(interact    *Int,
   strncpy(i_short, &s2[Int->j - 1], l_s);
   i_short[l_s] = '\0';
 
-  mfe = duplexfold(i_long, i_short);
+  mfe = vrna_duplexfold(ctx, i_long, i_short);
 
   i_min = mfe.i;
   j_min = mfe.j;
@@ -1189,9 +1512,9 @@ print_interaction(interact    *Int,
     G_sum = Gi_min + Gul;
 
     /* printf("dG = dGint + dGu_l\n"); */
-    printf("%s %3d,%-3d : %3d,%-3d (%.2f = %.2f + %.2f)\n",
-           struc, Int->k, Int->i, Int->j, Int->l, G_min, Gi_min, Gul);
-    printf("%s&%s\n", i_long, i_short);
+    up_printf(output, "%s %3d,%-3d : %3d,%-3d (%.2f = %.2f + %.2f)\n",
+                     struc, Int->k, Int->i, Int->j, Int->l, G_min, Gi_min, Gul);
+    up_printf(output, "%s&%s\n", i_long, i_short);
   } else {
     p_c_S = p_c2->H[Int->j][(Int->l) - (Int->j)] +
             p_c2->I[Int->j][(Int->l) - (Int->j)] +
@@ -1202,15 +1525,15 @@ print_interaction(interact    *Int,
 
     G_sum = Gi_min + Gul + Gus;
     /* printf("dG = dGint + dGu_l + dGu_s\n"); */
-    printf("%s %3d,%-3d : %3d,%-3d (%.2f = %.2f + %.2f + %.2f)\n",
-           struc, Int->k, Int->i, Int->j, Int->l, G_min, Gi_min, Gul, Gus);
-    printf("%s&%s\n", i_long, i_short);
+    up_printf(output, "%s %3d,%-3d : %3d,%-3d (%.2f = %.2f + %.2f + %.2f)\n",
+                     struc, Int->k, Int->i, Int->j, Int->l, G_min, Gi_min, Gul, Gus);
+    up_printf(output, "%s&%s\n", i_long, i_short);
   }
 
   if (!EQUAL(G_min, G_sum)) {
-    printf("ERROR\n");
+    up_printf(output, "ERROR\n");
     diff = fabs((G_min) - (G_sum));
-    printf("diff %.18f\n", diff);
+    up_printf(output, "diff %.18f\n", diff);
   }
 
   if (nix_up)
@@ -1225,8 +1548,9 @@ print_interaction(interact    *Int,
 
 /* print coordinates and free energy for the region of highest accessibility */
 PRIVATE void
-print_unstru(pu_contrib *p_c,
-             int        w)
+print_unstru(vrna_cstr_t  output,
+             pu_contrib   *p_c,
+             int          w)
 {
   int     i, j, len, min_i, min_j;
   double  dG_u, min_gu;
@@ -1251,7 +1575,7 @@ print_unstru(pu_contrib *p_c,
         }
       }
     }
-    printf("%4d,%4d \t (%.3f) \t for u=%3d\n", min_i, min_j, min_gu, w);
+    up_printf(output, "%4d,%4d \t (%.3f) \t for u=%3d\n", min_i, min_j, min_gu, w);
   } else {
     vrna_message_error("error with prob unpaired");
   }
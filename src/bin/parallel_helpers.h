@@ -3,14 +3,63 @@
 
 #if VRNA_WITH_PTHREADS
 
+#include <stdlib.h>
 #include <pthread.h>
+#include "ViennaRNA/utils/basic.h"
 #include "thpool.h"
 
+/*
+ *  Maximum number of jobs (input records) that may be in flight per
+ *  computation thread, i.e. scheduled but not yet finished. Once this
+ *  limit is reached, the input reader is blocked until a job finishes.
+ *  The same value is used to cap the reorder window of ordered output
+ *  streams, such that memory consumption scales with the number of
+ *  threads rather than with the size of the input.
+ */
+#define JOBS_PER_THREAD   4
+
+#define MAX_JOBS_IN_FLIGHT(n) (JOBS_PER_THREAD * (((n) > 1) ? (unsigned int)(n) : 1))
+
 pthread_mutex_t output_mutex;
 pthread_mutex_t output_file_mutex;
+pthread_mutex_t job_slots_mutex;
+pthread_cond_t  job_slots_cond;
+unsigned int    job_slots_used;
+unsigned int    job_slots_max;
 unsigned int    max_threads;
 threadpool      worker_pool;
 
+/*
+ *  Worker-local data, e.g. a fold compound, that persists across all jobs
+ *  processed by the same thread. The destructor passed to INIT_WORKER_DATA()
+ *  releases the data once a worker thread terminates, while the data of the
+ *  main thread is released by UNINIT_WORKER_DATA()
+ */
+pthread_key_t   worker_data_key;
+void            (*worker_data_free)(void *);
+
+struct parallel_job {
+  void  (*job_fun)(void *);
+  void  *job_data;
+};
+
+
+/* execute a job and release its slot afterwards */
+static void
+run_parallel_job(void *arg)
+{
+  struct parallel_job *job = (struct parallel_job *)arg;
+
+  job->job_fun(job->job_data);
+  free(job);
+
+  pthread_mutex_lock(&job_slots_mutex);
+  job_slots_used--;
+  pthread_cond_broadcast(&job_slots_cond);
+  pthread_mutex_unlock(&job_slots_mutex);
+}
+
+
 #define ATOMIC_BLOCK(a) { \
     if (max_threads > 1) { \
       pthread_mutex_lock(&output_file_mutex); \
@@ -47,7 +96,11 @@ threadpool      worker_pool;
     if (max_threads > 1) { \
       pthread_mutex_init(&output_mutex, NULL); \
       pthread_mutex_init(&output_file_mutex, NULL); \
-      worker_pool = thpool_init(max_threads); \
+      pthread_mutex_init(&job_slots_mutex, NULL); \
+      pthread_cond_init(&job_slots_cond, NULL); \
+      job_slots_used  = 0; \
+      job_slots_max   = MAX_JOBS_IN_FLIGHT(max_threads); \
+      worker_pool     = thpool_init(max_threads); \
     } \
 }
 
@@ -56,24 +109,58 @@ threadpool      worker_pool;
       thpool_wait(worker_pool); \
     pthread_mutex_destroy(&output_mutex); \
     pthread_mutex_destroy(&output_file_mutex); \
-    if (max_threads > 1) \
+    if (max_threads > 1) { \
       thpool_destroy(worker_pool); \
+      pthread_mutex_destroy(&job_slots_mutex); \
+      pthread_cond_destroy(&job_slots_cond); \
+    } \
 }
 
-#define RUN_IN_PARALLEL(fun, data)  { \
-    if (max_threads > 1) { thpool_add_work(worker_pool, (void *)&fun, (void *)data); } \
-    else { fun(data); } \
-}
-
+/*
+ *  Block the calling (producer) thread until less than a jobs are in flight
+ */
 #define WAIT_FOR_FREE_SLOT(a) { \
     if (max_threads > 1) { \
-      while (thpool_num_threads_working(worker_pool) == (a)) \
-        sleep(1); \
+      pthread_mutex_lock(&job_slots_mutex); \
+      while (job_slots_used >= (unsigned int)(a)) \
+        pthread_cond_wait(&job_slots_cond, &job_slots_mutex); \
+      pthread_mutex_unlock(&job_slots_mutex); \
     } \
 }
 
+#define INIT_WORKER_DATA(free_fun) { \
+    worker_data_free = (void (*)(void *))(free_fun); \
+    pthread_key_create(&worker_data_key, worker_data_free); \
+}
+
+#define UNINIT_WORKER_DATA { \
+    void *worker_data_ = pthread_getspecific(worker_data_key); \
+    if (worker_data_) \
+      worker_data_free(worker_data_); \
+    pthread_setspecific(worker_data_key, NULL); \
+}
+
+#define GET_WORKER_DATA()           pthread_getspecific(worker_data_key)
+#define SET_WORKER_DATA(data)       pthread_setspecific(worker_data_key, (void *)(data))
+
+#define RUN_IN_PARALLEL(fun, data)  { \
+    if (max_threads > 1) { \
+      struct parallel_job *parallel_job_ = (struct parallel_job *)vrna_alloc(sizeof(struct parallel_job)); \
+      parallel_job_->job_fun  = (void (*)(void *)) & fun; \
+      parallel_job_->job_data = (void *)data; \
+      pthread_mutex_lock(&job_slots_mutex); \
+      while (job_slots_used >= job_slots_max) \
+        pthread_cond_wait(&job_slots_cond, &job_slots_mutex); \
+      job_slots_used++; \
+      pthread_mutex_unlock(&job_slots_mutex); \
+      thpool_add_work(worker_pool, &run_parallel_job, (void *)parallel_job_); \
+    } else { fun(data); } \
+}
+
 #else
 
+#define MAX_JOBS_IN_FLIGHT(n)       1
+
 #define ATOMIC_BLOCK(a)             { (a); }
 #define THREADSAFE_FILE_OUTPUT(a)   { (a); }
 #define THREADSAFE_STREAM_OUTPUT(a)   { (a); }
@@ -82,6 +169,21 @@ threadpool      worker_pool;
 #define RUN_IN_PARALLEL(fun, data)  { fun(data); }
 #define WAIT_FOR_FREE_SLOT(a)
 
+void  *worker_data;
+void  (*worker_data_free)(void *);
+
+#define INIT_WORKER_DATA(free_fun)  { \
+    worker_data       = NULL; \
+    worker_data_free  = (void (*)(void *))(free_fun); \
+}
+#define UNINIT_WORKER_DATA  { \
+    if (worker_data) \
+      worker_data_free(worker_data); \
+    worker_data = NULL; \
+}
+#define GET_WORKER_DATA()           worker_data
+#define SET_WORKER_DATA(data)       { worker_data = (void *)(data); }
+
 #endif
 
 int
@@ -0,0 +1,86 @@
+#!/bin/bash
+
+echo "Testing Kinfold:"
+
+RETURN=0
+
+function failed {
+    RETURN=1
+    echo " [ NOT OK ]"
+}
+
+function passed {
+    echo " [ OK ]"
+}
+
+function testline {
+  echo -en "...testing $1:\t\t"
+}
+
+# Compare trajectories line by line. Structures, energies and all other
+# columns must be identical, the time (3rd column) may only differ in the
+# last printed digit, since the total rate of all moves is summed up in a
+# different order than before
+function compare_trajectories {
+  awk 'NR == FNR { ref[FNR] = $0; n = FNR; next }
+       {
+         m = FNR
+         k = split(ref[FNR], r)
+         d = (k > 3) ? $3 - r[3] : 0
+         if ((k != NF) || (d > 0.0015) || (d < -0.0015)) { print FNR ": " ref[FNR] " <> " $0; next }
+         for (c = 1; c <= NF; c++)
+           if ((c != 3) && ($c != r[c])) { print FNR ": " ref[FNR] " <> " $0; next }
+       }
+       END { if (m != n) print "number of lines differ: " n " <> " m }' $1 $2
+}
+
+# Kinfold is an optional sub-package
+if ! command -v Kinfold > /dev/null 2>&1 ; then
+  echo "Kinfold executable not found, skipping tests"
+  exit 77
+fi
+
+# The reference trajectories in ${KINFOLD_RESULTSDIR} have been produced by
+# Kinfold 1.3 of ViennaRNA 2.4.14, i.e. before concurrent simulations were
+# introduced, with the same seed and options. For the concurrent runs, each
+# trajectory i > 0 was simulated separately with --num=1 and the seed derived
+# by trajectory_seed() in main.c, i.e. 5213=60300=15049, 32750=35648=15222,
+# 24820=51059=58510, 55696=43014=45714 and 7349=53051=34803 for i = 1, ..., 5
+SEQUENCE="GGGAAAUCCCGCUAGCUAGCAUCGAUCGGGAUUUCGCGAUCG"
+SEED="--seed=123=456=789"
+
+# Trajectories drawn from a single random number stream
+testline "Trajectories (serial)"
+echo ${SEQUENCE} | Kinfold ${SEED} --num=5 --time=500 --log=kinfold_test -v > kinfold_general.out
+diff=$(compare_trajectories ${KINFOLD_RESULTSDIR}/kinfold.serial.gold kinfold_general.out)
+if [ "x${diff}" != "x" ] ; then failed; echo -e "$diff"; else passed; fi
+
+testline "Trajectories (dangles 0, no lonely pairs)"
+echo ${SEQUENCE} | Kinfold ${SEED} -d 0 --noLP --num=3 --time=200 --log=kinfold_test -v > kinfold_general.out
+diff=$(compare_trajectories ${KINFOLD_RESULTSDIR}/kinfold.d0_noLP.gold kinfold_general.out)
+if [ "x${diff}" != "x" ] ; then failed; echo -e "$diff"; else passed; fi
+
+testline "Trajectories (neighborhood cache disabled)"
+echo ${SEQUENCE} | Kinfold ${SEED} --num=5 --time=500 --cacheSize=0 --log=kinfold_test -v > kinfold_general.out
+diff=$(compare_trajectories ${KINFOLD_RESULTSDIR}/kinfold.serial.gold kinfold_general.out)
+if [ "x${diff}" != "x" ] ; then failed; echo -e "$diff"; else passed; fi
+
+testline "Trajectories (growing chain)"
+echo ${SEQUENCE} | Kinfold ${SEED} --num=2 --time=200 --grow=2 --glen=15 --log=kinfold_test -v > kinfold_general.out
+diff=$(compare_trajectories ${KINFOLD_RESULTSDIR}/kinfold.grow.gold kinfold_general.out)
+if [ "x${diff}" != "x" ] ; then failed; echo -e "$diff"; else passed; fi
+
+# Each trajectory draws from its own random number stream, independent of the number of threads
+testline "Trajectories (concurrent, 2 threads)"
+echo ${SEQUENCE} | Kinfold ${SEED} --num=6 --time=500 -j 2 --log=kinfold_test -v > kinfold_general.out
+diff=$(compare_trajectories ${KINFOLD_RESULTSDIR}/kinfold.parallel.gold kinfold_general.out)
+if [ "x${diff}" != "x" ] ; then failed; echo -e "$diff"; else passed; fi
+
+testline "Trajectories (concurrent, 4 threads)"
+echo ${SEQUENCE} | Kinfold ${SEED} --num=6 --time=500 -j 4 --log=kinfold_test -v > kinfold_general.out
+diff=$(compare_trajectories ${KINFOLD_RESULTSDIR}/kinfold.parallel.gold kinfold_general.out)
+if [ "x${diff}" != "x" ] ; then failed; echo -e "$diff"; else passed; fi
+
+rm -f kinfold_general.out kinfold_test.log
+
+exit ${RETURN}
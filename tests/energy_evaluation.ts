@@ -1,6 +1,13 @@
+#include <string.h>
+
 #include <ViennaRNA/params/basic.h>
 #include <ViennaRNA/utils/basic.h>
 #include <ViennaRNA/loops/all.h>
+#include <ViennaRNA/params/io.h>
+#include <ViennaRNA/model.h>
+#include <ViennaRNA/fold_compound.h>
+#include <ViennaRNA/mfe.h>
+#include <ViennaRNA/fold_vars.h>
 
 #suite Energy_Evaluating_Functions
 
@@ -208,3 +215,157 @@
   ck_assert_int_eq(E_IntLoop(3, 5, 1, 2, 1, 2, 3, 4, &param), 235);
   ck_assert_int_eq(E_IntLoop(5, 3, 1, 2, 1, 2, 3, 4, &param), 235);
 }
+
+
+#tcase Parameter_Cache
+
+/*
+ * check that cached energy parameters follow the globally loaded parameter set
+ */
+
+#test test_params_cache_reload
+{
+  vrna_param_t  *p1, *p2, *p3;
+
+  vrna_params_load_RNA_Turner2004();
+  p1 = vrna_params(NULL);
+
+  vrna_params_load_RNA_Turner1999();
+  p2 = vrna_params(NULL);
+
+  ck_assert(memcmp(p1->hairpin, p2->hairpin, sizeof(p1->hairpin)) != 0);
+  ck_assert(memcmp(p1->stack, p2->stack, sizeof(p1->stack)) != 0);
+
+  vrna_params_load_RNA_Turner2004();
+  p3 = vrna_params(NULL);
+
+  ck_assert(memcmp(p1->hairpin, p3->hairpin, sizeof(p1->hairpin)) == 0);
+  ck_assert(memcmp(p1->stack, p3->stack, sizeof(p1->stack)) == 0);
+  ck_assert(memcmp(p1->int22, p3->int22, sizeof(p1->int22)) == 0);
+
+  free(p1);
+  free(p2);
+  free(p3);
+}
+
+/*
+ * check that cached Boltzmann factors follow the global james_rule switch
+ */
+
+#test test_params_cache_james_rule
+{
+  int               james_rule_old;
+  vrna_exp_param_t  *p1, *p2, *p3;
+
+  james_rule_old  = james_rule;
+
+  james_rule  = 1;
+  p1          = vrna_exp_params(NULL);
+
+  james_rule  = 0;
+  p2          = vrna_exp_params(NULL);
+
+  james_rule  = 1;
+  p3          = vrna_exp_params(NULL);
+
+  ck_assert(p1->expinternal[2] != p2->expinternal[2]);
+  ck_assert(p1->expinternal[2] == p3->expinternal[2]);
+
+  james_rule = james_rule_old;
+
+  free(p1);
+  free(p2);
+  free(p3);
+}
+
+/*
+ * check that concurrent requests for the same models yield the same parameters
+ */
+
+#test test_params_cache_concurrent
+{
+  int               i, n = 32;
+  double            temperatures[4] = {
+    37., 25., 55., 37.
+  };
+  vrna_md_t         md;
+  vrna_exp_param_t  *ref[4], *p[32];
+
+  vrna_params_load_RNA_Turner2004();
+
+  for (i = 0; i < 4; i++) {
+    vrna_md_set_default(&md);
+    md.temperature  = temperatures[i];
+    md.dangles      = (i == 3) ? 0 : 2;
+    vrna_params_cache_clear();
+    ref[i] = vrna_exp_params(&md);
+  }
+
+  vrna_params_cache_clear();
+
+#pragma omp parallel for private(md)
+  for (i = 0; i < n; i++) {
+    vrna_md_set_default(&md);
+    md.temperature  = temperatures[i % 4];
+    md.dangles      = (i % 4 == 3) ? 0 : 2;
+    p[i]            = vrna_exp_params(&md);
+  }
+
+  for (i = 0; i < n; i++) {
+    ck_assert(memcmp(p[i]->exphairpin, ref[i % 4]->exphairpin, sizeof(ref[0]->exphairpin)) == 0);
+    ck_assert(memcmp(p[i]->expint22, ref[i % 4]->expint22, sizeof(ref[0]->expint22)) == 0);
+    ck_assert(memcmp(p[i]->expstack, ref[i % 4]->expstack, sizeof(ref[0]->expstack)) == 0);
+    ck_assert(memcmp(&(p[i]->model_details), &(ref[i % 4]->model_details), sizeof(vrna_md_t)) == 0);
+    free(p[i]);
+  }
+
+  for (i = 0; i < 4; i++)
+    free(ref[i]);
+}
+
+
+#tcase Parameter_Sets
+
+/*
+ * check that parameter sets do not depend on the global energy parameters
+ */
+
+#test test_param_set_independent
+{
+  const char            *sequence =
+    "GGGAAUUAUCGCUAGCUAGCUAGCGAUUACGGAUCGAUCGAUUCGAUCGAUUACGCGCUAAUUCGCGCAUCG";
+  float                 mfe_set, mfe_global;
+  vrna_md_t             md;
+  vrna_param_set_t      *s1, *s2;
+  vrna_fold_compound_t  *fc;
+
+  vrna_params_load_RNA_Turner2004();
+  s1 = vrna_param_set_load_RNA_Turner1999();
+
+  vrna_params_load_RNA_Andronescu2007();
+  s2 = vrna_param_set_load_RNA_Turner1999();
+
+  ck_assert(memcmp(s1->stack37, s2->stack37, sizeof(s1->stack37)) == 0);
+  ck_assert(memcmp(s1->int22_37, s2->int22_37, sizeof(s1->int22_37)) == 0);
+  ck_assert(memcmp(s1->mismatchExt37, s2->mismatchExt37, sizeof(s1->mismatchExt37)) == 0);
+
+  /* derived parameters must match those of the same set loaded into the global tables */
+  vrna_md_set_default(&md);
+  md.param_set  = s2;
+  fc            = vrna_fold_compound(sequence, &md, VRNA_OPTION_DEFAULT);
+  mfe_set       = vrna_mfe(fc, NULL);
+  vrna_fold_compound_free(fc);
+
+  vrna_params_load_RNA_Turner1999();
+  vrna_md_set_default(&md);
+  fc          = vrna_fold_compound(sequence, &md, VRNA_OPTION_DEFAULT);
+  mfe_global  = vrna_mfe(fc, NULL);
+  vrna_fold_compound_free(fc);
+
+  ck_assert(mfe_set == mfe_global);
+
+  vrna_params_load_RNA_Turner2004();
+
+  vrna_param_set_free(s1);
+  vrna_param_set_free(s2);
+}
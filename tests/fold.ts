@@ -1,5 +1,11 @@
 #include <stdio.h>      /* printf, scanf, NULL */
 #include <stdlib.h>     /* malloc, free, rand */
+#include <string.h>
+#include <math.h>
+#include <unistd.h>     /* dup, dup2 */
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 #include <ViennaRNA/fold_vars.h>
 #include <ViennaRNA/data_structures.h>
@@ -8,6 +14,332 @@
 #include <ViennaRNA/constraints/basic.h>
 #include <ViennaRNA/fold.h>
 #include <ViennaRNA/part_func.h>
+#include <ViennaRNA/mfe.h>
+#include <ViennaRNA/subopt.h>
+#include <ViennaRNA/boltzmann_sampling.h>
+#include <ViennaRNA/centroid.h>
+#include <ViennaRNA/eval.h>
+#include <ViennaRNA/cotranscriptional.h>
+#include <ViennaRNA/heat_capacity.h>
+#include <ViennaRNA/grammar.h>
+#include <ViennaRNA/mfe_window.h>
+#include <ViennaRNA/part_func_window.h>
+#include <ViennaRNA/duplex.h>
+#include <ViennaRNA/plex.h>
+#include <ViennaRNA/part_func_up.h>
+#include <ViennaRNA/params/basic.h>
+
+/* deterministic pseudo-random sequences for comparisons of different fill strategies */
+static char *
+random_sequence(int           length,
+                unsigned int  seed)
+{
+  int   i;
+  char  *s = (char *)vrna_alloc(sizeof(char) * (length + 1));
+
+  for (i = 0; i < length; i++) {
+    seed  = seed * 1103515245u + 12345u;
+    s[i]  = "ACGU"[(seed >> 16) & 3];
+  }
+  s[length] = '\0';
+
+  return s;
+}
+
+
+/* count releases of user data attached to a fold compound */
+static void
+count_free_calls(void *data)
+{
+  (*((int *)data))++;
+}
+
+
+/* collect suboptimal structures in the order they are reported */
+struct subopt_list {
+  unsigned int  num;
+  unsigned int  size;
+  SOLUTION      *sol;
+};
+
+
+static void
+collect_subopt(const char *structure,
+               float      energy,
+               void       *data)
+{
+  struct subopt_list *l = (struct subopt_list *)data;
+
+  if (!structure)
+    return;
+
+  if (l->num == l->size) {
+    l->size = (l->size) ? 2 * l->size : 128;
+    l->sol  = (SOLUTION *)vrna_realloc(l->sol, sizeof(SOLUTION) * l->size);
+  }
+
+  l->sol[l->num].energy     = energy;
+  l->sol[l->num].structure  = strdup(structure);
+  l->num++;
+}
+
+
+/* order of suboptimal structures as in vrna_subopt() with sorted output */
+static int
+compare_subopt(const void *a,
+               const void *b)
+{
+  const SOLUTION *s1 = (const SOLUTION *)a;
+  const SOLUTION *s2 = (const SOLUTION *)b;
+
+  if (s1->energy != s2->energy)
+    return (s1->energy > s2->energy) ? 1 : -1;
+
+  return strcmp(s1->structure, s2->structure);
+}
+
+/* collect Boltzmann samples in the order they are reported */
+struct sample_list {
+  unsigned int  num;
+  unsigned int  size;
+  char          **structure;
+};
+
+
+static void
+collect_sample(const char *structure,
+               void       *data)
+{
+  struct sample_list *l = (struct sample_list *)data;
+
+  if (!structure)
+    return;
+
+  if (l->num == l->size) {
+    l->size       = (l->size) ? 2 * l->size : 128;
+    l->structure  = (char **)vrna_realloc(l->structure, sizeof(char *) * l->size);
+  }
+
+  l->structure[l->num++] = strdup(structure);
+}
+
+/* collect the output of sliding window predictions in the order it is reported */
+struct window_hits {
+  unsigned int  num;
+  unsigned int  size;
+  char          **hit;
+};
+
+
+static void
+collect_window_hit(int        start,
+                   int        end,
+                   const char *structure,
+                   float      en,
+                   void       *data)
+{
+  struct window_hits  *h = (struct window_hits *)data;
+  char                *hit;
+
+  hit = (char *)vrna_alloc(sizeof(char) * (strlen(structure) + 64));
+  sprintf(hit, "%d %d %s %6.2f", start, end, structure, en);
+
+  if (h->num == h->size) {
+    h->size = (h->size) ? 2 * h->size : 1024;
+    h->hit  = (char **)vrna_realloc(h->hit, sizeof(char *) * h->size);
+  }
+
+  h->hit[h->num++] = hit;
+}
+
+
+static void
+free_window_hits(struct window_hits *h)
+{
+  unsigned int i;
+
+  for (i = 0; i < h->num; i++)
+    free(h->hit[i]);
+
+  free(h->hit);
+}
+
+
+/* fingerprint of sliding window probabilities, i.e. FNV-1a over all reported values */
+struct window_probs {
+  unsigned int        num;
+  unsigned long long  hash;
+};
+
+
+static void
+hash_window_probs(FLT_OR_DBL    *pr,
+                  int           pr_size,
+                  int           i,
+                  int           max,
+                  unsigned int  type,
+                  void          *data)
+{
+  struct window_probs *w = (struct window_probs *)data;
+  unsigned char       *b;
+  unsigned int        k;
+  int                 j, first, val[3];
+
+  if (type & VRNA_PROBS_WINDOW_BPP)
+    first = i + 1;
+  else if (type & VRNA_PROBS_WINDOW_UP)
+    first = 1;
+  else
+    return;
+
+  val[0]  = i;
+  val[1]  = max;
+  val[2]  = (int)type;
+  b       = (unsigned char *)val;
+  for (k = 0; k < sizeof(val); k++)
+    w->hash = (w->hash ^ b[k]) * 1099511628211ULL;
+
+  for (j = first; j <= pr_size; j++) {
+    b = (unsigned char *)&(pr[j]);
+    for (k = 0; k < sizeof(FLT_OR_DBL); k++)
+      w->hash = (w->hash ^ b[k]) * 1099511628211ULL;
+  }
+
+  w->num++;
+}
+
+/* provide a sequence in small pieces, just like reading it line by line from a file */
+struct sequence_stream {
+  const char    *sequence;
+  unsigned int  position;
+  unsigned int  piece;
+};
+
+
+static unsigned int
+read_sequence_piece(char          *buffer,
+                    unsigned int  size,
+                    void          *data)
+{
+  struct sequence_stream  *stream = (struct sequence_stream *)data;
+  unsigned int            num;
+
+  num = strlen(stream->sequence + stream->position);
+  num = MIN2(num, MIN2(size, stream->piece));
+
+  memcpy(buffer, stream->sequence + stream->position, sizeof(char) * num);
+  stream->position += num;
+
+  return num;
+}
+
+
+static int
+compare_hits(const void *a,
+             const void *b)
+{
+  return strcmp(*((char **)a), *((char **)b));
+}
+
+/* read everything written to a temporary file */
+static char *
+read_stream(FILE *fp)
+{
+  char    *s;
+  size_t  n;
+  long    size;
+
+  (void)fflush(fp);
+  (void)fseek(fp, 0L, SEEK_END);
+  size = ftell(fp);
+  rewind(fp);
+
+  s = (char *)vrna_alloc(sizeof(char) * (size + 1));
+  n = fread(s, sizeof(char), (size_t)size, fp);
+  s[n] = '\0';
+
+  return s;
+}
+
+/* unpaired probabilities of a sequence the way RNAup computes them */
+static pu_contrib *
+unpaired_probs(const char *sequence,
+               vrna_md_t  *md,
+               int        w)
+{
+  vrna_fold_compound_t  *fc;
+  vrna_exp_param_t      *P;
+  pu_contrib            *pu;
+  double                mfe, RT;
+
+  RT  = (md->temperature + K0) * GASCONST / 1000.;
+  fc  = vrna_fold_compound(sequence, md, VRNA_OPTION_DEFAULT);
+  mfe = (double)vrna_mfe(fc, NULL);
+
+  P           = vrna_exp_params(md);
+  P->pf_scale = exp(-(1.07 * mfe) / RT / strlen(sequence));
+  vrna_exp_params_subst(fc, P);
+  free(P);
+
+  (void)vrna_pf(fc, NULL);
+  pu = vrna_pf_unstru(fc, w);
+
+  vrna_fold_compound_free(fc);
+
+  return pu;
+}
+
+
+/* the same for the legacy interface, i.e. pf_fold() followed by pf_unstru() */
+static pu_contrib *
+unpaired_probs_legacy(const char  *sequence,
+                      vrna_md_t   *md,
+                      int         w)
+{
+  pu_contrib  *pu;
+  char        *seq, *structure;
+  double      mfe, RT;
+
+  RT        = (md->temperature + K0) * GASCONST / 1000.;
+  seq       = strdup(sequence);
+  structure = (char *)vrna_alloc(sizeof(char) * (strlen(sequence) + 1));
+  mfe       = (double)fold(seq, structure);
+  free_arrays();
+
+  pf_scale = exp(-(1.07 * mfe) / RT / strlen(sequence));
+  (void)pf_fold(seq, structure);
+  pu = pf_unstru(seq, w);
+
+  free(seq);
+  free(structure);
+
+  return pu;
+}
+
+/* only allow base pairs (i,j) with j - i < *(int *)data, just like vrna_md_t.max_bp_span */
+static unsigned char
+hc_max_span(int           i,
+            int           j,
+            int           k,
+            int           l,
+            unsigned char d,
+            void          *data)
+{
+  int span = *((int *)data);
+
+  switch (d) {
+    case VRNA_DECOMP_PAIR_HP:
+    case VRNA_DECOMP_PAIR_ML:
+      return (unsigned char)(j - i < span);
+
+    case VRNA_DECOMP_PAIR_IL:
+      return (unsigned char)((j - i < span) && (l - k < span));
+
+    default:
+      return (unsigned char)1;
+  }
+}
+
 
 #suite  MFE_Prediction
 
@@ -24,8 +356,631 @@
   free(structure);
 }
 
+#tcase  Backtracking
+
+#test test_mfe_odd_dangles
+{
+  /* multibranch loops must be backtracked with the dangle model of the fold compound */
+  vrna_md_t             md;
+  vrna_fold_compound_t  *fc;
+  char                  *seq, *structure;
+  int                   d;
+  float                 mfe;
+
+  for (d = 1; d <= 3; d += 2) {
+    seq       = random_sequence(150, (d == 1) ? 4001 : 4002);
+    structure = (char *)vrna_alloc(sizeof(char) * 151);
+
+    vrna_md_set_default(&md);
+    md.dangles = d;
+
+    fc  = vrna_fold_compound(seq, &md, VRNA_OPTION_DEFAULT);
+    mfe = vrna_mfe(fc, structure);
+
+    ck_assert_int_eq(strlen(structure), 150);
+    ck_assert(vrna_eval_structure(fc, structure) == mfe);
+
+    vrna_fold_compound_free(fc);
+    free(structure);
+    free(seq);
+  }
+}
+
+#tcase  Parallel_Fill
+
+#test test_mfe_parallel_fill
+{
+  /* the wavefront fill must reproduce the sequential matrices exactly */
+  vrna_md_t             md;
+  vrna_fold_compound_t  *fc1, *fc4;
+  char                  *seq, *s1, *s4;
+  int                   v, k, i, j, n, ij, *indx, e1, e4;
+
+  /* model variants: dangles = 0, dangles = 2, dangles = 2 without lonely pairs */
+  for (v = 0; v < 3; v++) {
+    for (k = 0; k < 3; k++) {
+      n   = 120 + 90 * k;
+      seq = random_sequence(n, 4711 + 17 * k + v);
+
+      vrna_md_set_default(&md);
+      md.dangles      = (v == 0) ? 0 : 2;
+      md.noLP         = (v == 2) ? 1 : 0;
+      md.num_threads  = 1;
+      fc1             = vrna_fold_compound(seq, &md, VRNA_OPTION_MFE);
+      md.num_threads  = 4;
+      fc4             = vrna_fold_compound(seq, &md, VRNA_OPTION_MFE);
+
+      s1  = (char *)vrna_alloc(sizeof(char) * (n + 1));
+      s4  = (char *)vrna_alloc(sizeof(char) * (n + 1));
+      e1  = (int)(vrna_mfe(fc1, s1) * 100. + (double)0.5);
+      e4  = (int)(vrna_mfe(fc4, s4) * 100. + (double)0.5);
+
+      ck_assert_int_eq(e1, e4);
+      ck_assert_str_eq(s1, s4);
+
+      indx = fc1->jindx;
+      for (j = 1; j <= n; j++) {
+        ck_assert_int_eq(fc1->matrices->f5[j], fc4->matrices->f5[j]);
+        for (i = 1; i < j; i++) {
+          ij = indx[j] + i;
+          ck_assert_int_eq(fc1->matrices->c[ij], fc4->matrices->c[ij]);
+          ck_assert_int_eq(fc1->matrices->fML[ij], fc4->matrices->fML[ij]);
+        }
+      }
+
+      free(s1);
+      free(s4);
+      free(seq);
+      vrna_fold_compound_free(fc1);
+      vrna_fold_compound_free(fc4);
+    }
+  }
+}
+
+#tcase  Banded_Matrices
+
+#test test_banded_max_bp_span
+{
+  /* span-limited folding with banded matrices must reproduce the full matrices */
+  vrna_md_t             md;
+  vrna_fold_compound_t  *fc_full, *fc_band, *fc_flt;
+  char                  *seq, *s_full, *s_band;
+  int                   k, s, i, j, n, span, e_full, e_band;
+  double                g_full, g_band, d_full, d_band;
+  FLT_OR_DBL            *p_full, *p_band;
+
+  for (k = 0; k < 3; k++) {
+    n     = 250 + 100 * k;
+    span  = 40 + 30 * k;
+    seq   = random_sequence(n, 815 + 13 * k);
+
+    /* reference: full triangle, long base pairs are forbidden through a hard constraint callback */
+    vrna_md_set_default(&md);
+    md.dangles  = (k == 1) ? 0 : 2;
+    md.noGU     = (k == 2) ? 1 : 0;
+    md.uniq_ML  = 1;
+    fc_full     = vrna_fold_compound(seq, &md, VRNA_OPTION_DEFAULT);
+    vrna_hc_add_f(fc_full, &hc_max_span);
+    vrna_hc_add_data(fc_full, (void *)&span, NULL);
+
+    md.max_bp_span  = span;
+    md.num_threads  = (k == 0) ? 4 : 1;
+    fc_band         = vrna_fold_compound(seq, &md, VRNA_OPTION_DEFAULT);
+
+    /* banded matrices must be requested explicitly */
+    ck_assert(fc_band->jindx_span == 0);
+    vrna_fold_compound_free(fc_band);
+    fc_band = vrna_fold_compound(seq, &md, VRNA_OPTION_BANDED);
+
+    ck_assert(fc_full->jindx_span == 0);
+    ck_assert(fc_band->jindx_span > 0);
+    ck_assert(fc_band->hc->mx_span > 0);
+
+    if (k == 2) {
+      /* identical hard constraints, applied to the full and the banded matrix */
+      vrna_hc_add_up(fc_full, 20, VRNA_CONSTRAINT_CONTEXT_ALL_LOOPS);
+      vrna_hc_add_up(fc_band, 20, VRNA_CONSTRAINT_CONTEXT_ALL_LOOPS);
+      vrna_hc_add_bp(fc_full, 40, 40 + span / 2, VRNA_CONSTRAINT_CONTEXT_ALL_LOOPS | VRNA_CONSTRAINT_CONTEXT_ENFORCE);
+      vrna_hc_add_bp(fc_band, 40, 40 + span / 2, VRNA_CONSTRAINT_CONTEXT_ALL_LOOPS | VRNA_CONSTRAINT_CONTEXT_ENFORCE);
+    }
+
+    if (k == 1) {
+      /* a pair at the very edge of the band is still allowed, one beyond it is rejected */
+      vrna_hc_add_bp(fc_full, 60, 60 + span - 1, VRNA_CONSTRAINT_CONTEXT_ALL_LOOPS | VRNA_CONSTRAINT_CONTEXT_ENFORCE);
+      vrna_hc_add_bp(fc_band, 60, 60 + span - 1, VRNA_CONSTRAINT_CONTEXT_ALL_LOOPS | VRNA_CONSTRAINT_CONTEXT_ENFORCE);
+      vrna_hc_add_bp(fc_band, 150, 150 + span, VRNA_CONSTRAINT_CONTEXT_ALL_LOOPS | VRNA_CONSTRAINT_CONTEXT_ENFORCE);
+
+      ck_assert(vrna_hc_mx_index(fc_band->hc, 60, 60 + span - 1) >= 0);
+      ck_assert(vrna_hc_mx_index(fc_band->hc, 60 + span - 1, 60) >= 0);
+      ck_assert(vrna_hc_mx_index(fc_band->hc, 150, 150 + span) < 0);
+      ck_assert(vrna_hc_mx_get(fc_band->hc, 60, 60 + span - 1) != VRNA_CONSTRAINT_CONTEXT_NONE);
+      ck_assert(vrna_hc_mx_get(fc_band->hc, 150, 150 + span) == VRNA_CONSTRAINT_CONTEXT_NONE);
+    }
+
+    for (i = 1; i <= n; i++)
+      for (j = i; j <= n; j++) {
+        if (j - i >= span)
+          ck_assert(vrna_hc_mx_get(fc_band->hc, i, j) == VRNA_CONSTRAINT_CONTEXT_NONE);
+        else
+          ck_assert(vrna_hc_mx_get(fc_full->hc, j, i) == vrna_hc_mx_get(fc_band->hc, i, j));
+      }
+
+    s_full  = (char *)vrna_alloc(sizeof(char) * (n + 1));
+    s_band  = (char *)vrna_alloc(sizeof(char) * (n + 1));
+    e_full  = (int)(vrna_mfe(fc_full, s_full) * 100. + (double)0.5);
+    e_band  = (int)(vrna_mfe(fc_band, s_band) * 100. + (double)0.5);
+
+    ck_assert_int_eq(e_full, e_band);
+    ck_assert_str_eq(s_full, s_band);
+
+    if (k == 1) {
+      ck_assert(s_band[59] == '(');
+      ck_assert(s_band[60 + span - 2] == ')');
+    }
+
+    vrna_exp_params_rescale(fc_full, NULL);
+    vrna_exp_params_rescale(fc_band, NULL);
+    g_full  = vrna_pf(fc_full, NULL);
+    g_band  = vrna_pf(fc_band, NULL);
+
+    ck_assert(fabs(g_full - g_band) < 1e-6);
+
+    /* the partition function matrices are banded as well */
+    ck_assert(vrna_mx_pf_index(fc_band, 1, n) < 0);
+    ck_assert(vrna_mx_pf_index(fc_band, 1, span) >= 0);
+    ck_assert(fabs(fc_full->exp_matrices->q1k[n] - fc_band->exp_matrices->q1k[n]) <=
+              1e-9 * fc_full->exp_matrices->q1k[n]);
+
+    for (i = 1; i <= n; i++)
+      ck_assert(fabs(fc_full->exp_matrices->qln[i] - fc_band->exp_matrices->qln[i]) <=
+                1e-9 * fc_full->exp_matrices->qln[i]);
+
+    p_full  = fc_full->exp_matrices->probs;
+    p_band  = fc_band->exp_matrices->probs;
+    for (i = 1; i < n; i++)
+      for (j = i + 1; j <= n; j++) {
+        if (j - i >= span)
+          ck_assert(vrna_mx_pf_get(fc_band, p_band, i, j) == 0.);
+
+        ck_assert(fabs(p_full[fc_full->iindx[i] - j] - vrna_mx_pf_get(fc_band, p_band, i, j)) < 1e-9);
+      }
+
+    /* derived quantities and stochastic backtracking */
+    free(s_full);
+    free(s_band);
+    s_full  = vrna_centroid(fc_full, &d_full);
+    s_band  = vrna_centroid(fc_band, &d_band);
+    ck_assert_str_eq(s_full, s_band);
+    ck_assert(fabs(d_full - d_band) < 1e-6);
+    free(s_full);
+    free(s_band);
+
+    for (s = 0; s < 10; s++) {
+      xsubi[0]  = xsubi[1] = xsubi[2] = (unsigned short)(4711 + s);
+      s_full    = vrna_pbacktrack(fc_full);
+      xsubi[0]  = xsubi[1] = xsubi[2] = (unsigned short)(4711 + s);
+      s_band    = vrna_pbacktrack(fc_band);
+      ck_assert_str_eq(s_full, s_band);
+      free(s_full);
+      free(s_band);
+    }
+
+    /* single precision fill on banded matrices */
+    md.pf_float = 1;
+    fc_flt      = vrna_fold_compound(seq, &md, VRNA_OPTION_BANDED);
+    ck_assert(fc_flt->jindx_span > 0);
+
+    /* same hard constraints as for the double precision fill */
+    if (k == 2) {
+      vrna_hc_add_up(fc_flt, 20, VRNA_CONSTRAINT_CONTEXT_ALL_LOOPS);
+      vrna_hc_add_bp(fc_flt, 40, 40 + span / 2, VRNA_CONSTRAINT_CONTEXT_ALL_LOOPS | VRNA_CONSTRAINT_CONTEXT_ENFORCE);
+    }
+
+    if (k == 1) {
+      vrna_hc_add_bp(fc_flt, 60, 60 + span - 1, VRNA_CONSTRAINT_CONTEXT_ALL_LOOPS | VRNA_CONSTRAINT_CONTEXT_ENFORCE);
+      vrna_hc_add_bp(fc_flt, 150, 150 + span, VRNA_CONSTRAINT_CONTEXT_ALL_LOOPS | VRNA_CONSTRAINT_CONTEXT_ENFORCE);
+    }
+
+    vrna_exp_params_rescale(fc_flt, NULL);
+    ck_assert(fabs(g_band - vrna_pf(fc_flt, NULL)) < 1e-3);
+    vrna_fold_compound_free(fc_flt);
+
+    free(seq);
+    vrna_fold_compound_free(fc_full);
+    vrna_fold_compound_free(fc_band);
+  }
+}
+
+#test test_banded_length_limit
+{
+  /* banded matrices lift the length limit of the full matrices */
+  vrna_md_t             md;
+  vrna_fold_compound_t  *fc, *fc_reuse;
+  char                  *seq, *structure;
+  int                   n, i, j, d;
+  double                mfe, g;
+
+  n   = 34000;
+  seq = random_sequence(n, 1234);
+
+  vrna_md_set_default(&md);
+  ck_assert(vrna_fold_compound(seq, &md, VRNA_OPTION_DEFAULT) == NULL);
+  ck_assert(vrna_fold_compound(seq, &md, VRNA_OPTION_BANDED) == NULL);
+
+  md.max_bp_span  = 25;
+  md.uniq_ML      = 1;
+  ck_assert(vrna_fold_compound(seq, &md, VRNA_OPTION_DEFAULT) == NULL);
+
+  fc = vrna_fold_compound(seq, &md, VRNA_OPTION_BANDED);
+  ck_assert(fc != NULL);
+  ck_assert(fc->length == (unsigned int)n);
+  ck_assert(fc->jindx_span == 25);
+
+  structure = (char *)vrna_alloc(sizeof(char) * (n + 1));
+  mfe       = (double)vrna_mfe(fc, structure);
+  ck_assert(mfe < 0.);
+  ck_assert(strlen(structure) == (size_t)n);
+
+  /* all pairs respect the maximum span */
+  for (i = 0; i < n; i++) {
+    if (structure[i] == '(') {
+      for (j = i + 1, d = 1; d > 0; j++)
+        d += (structure[j] == '(') ? 1 : ((structure[j] == ')') ? -1 : 0);
+
+      ck_assert(j - 1 - i < 25);
+    }
+  }
+
+  vrna_exp_params_rescale(fc, &mfe);
+  g = vrna_pf(fc, NULL);
+  ck_assert(g <= mfe);
+  ck_assert(fc->exp_matrices->q1k[n] > 0.);
+
+  /* re-used fold compounds follow the same rules */
+  fc_reuse = vrna_fold_compound("GGGGAAAACCCCGGGGAAAACCCCGGGGAAAACCCCGGGGAAAACCCCGGGGAAAACCCCGGGG",
+                                &md,
+                                VRNA_OPTION_BANDED);
+  ck_assert(vrna_fold_compound_reset_sequence(fc_reuse, seq) == 1);
+  ck_assert(fc_reuse->jindx_span == 25);
+  ck_assert(fabs((double)vrna_mfe(fc_reuse, NULL) - mfe) < 1e-6);
+  vrna_fold_compound_free(fc_reuse);
+
+  md.max_bp_span  = -1;
+  fc_reuse        = vrna_fold_compound("GGGGAAAACCCC", &md, VRNA_OPTION_BANDED);
+  ck_assert(vrna_fold_compound_reset_sequence(fc_reuse, seq) == 0);
+  vrna_fold_compound_free(fc_reuse);
+
+  free(structure);
+  free(seq);
+  vrna_fold_compound_free(fc);
+}
+
 #suite  Partition_Function
 
+#tcase  Parallel_Fill
+
+#test test_pf_parallel_fill
+{
+  /* the multi-threaded fill must reproduce the sequential matrices bitwise */
+  vrna_md_t             md;
+  vrna_fold_compound_t  *fc1, *fc4;
+  char                  *seq;
+  int                   v, i, j, n, ij, *iindx;
+  double                e1, e4;
+
+  /* model variants: dangles = 2, dangles = 0 with unique ML decomposition, maximum base pair span */
+  for (v = 0; v < 3; v++) {
+    n   = 150 + 60 * v;
+    seq = random_sequence(n, 815 + v);
+
+    vrna_md_set_default(&md);
+    md.dangles      = (v == 1) ? 0 : 2;
+    md.uniq_ML      = (v == 1) ? 1 : 0;
+    md.max_bp_span  = (v == 2) ? 60 : -1;
+    md.num_threads  = 1;
+    fc1             = vrna_fold_compound(seq, &md, VRNA_OPTION_PF | VRNA_OPTION_BANDED);
+    md.num_threads  = 4;
+    fc4             = vrna_fold_compound(seq, &md, VRNA_OPTION_PF | VRNA_OPTION_BANDED);
+
+    e1  = vrna_pf(fc1, NULL);
+    e4  = vrna_pf(fc4, NULL);
+
+    ck_assert(e1 == e4);
+
+    ck_assert(fc1->exp_matrices->q1k[n] == fc4->exp_matrices->q1k[n]);
+
+    iindx = fc1->iindx;
+    for (i = 1; i <= n; i++)
+      for (j = i; j <= ((fc1->jindx_span) ? MIN2(n, i + (int)fc1->jindx_span + 1) : n); j++) {
+        ij = iindx[i] - j;
+        ck_assert(fc1->exp_matrices->q[ij] == fc4->exp_matrices->q[ij]);
+        ck_assert(fc1->exp_matrices->qb[ij] == fc4->exp_matrices->qb[ij]);
+        ck_assert(fc1->exp_matrices->qm[ij] == fc4->exp_matrices->qm[ij]);
+        ck_assert(fc1->exp_matrices->probs[ij] == fc4->exp_matrices->probs[ij]);
+      }
+
+    if (fc1->exp_matrices->qm1)
+      for (j = 1; j <= n; j++)
+        for (i = (fc1->jindx_span) ? MAX2(1, j - (int)fc1->jindx_span - 1) : 1; i <= j; i++)
+          ck_assert(fc1->exp_matrices->qm1[fc1->jindx[j] + i] ==
+                    fc4->exp_matrices->qm1[fc4->jindx[j] + i]);
+
+    free(seq);
+    vrna_fold_compound_free(fc1);
+    vrna_fold_compound_free(fc4);
+  }
+}
+
+#tcase Single_Precision
+
+#test test_pf_float_accuracy
+{
+  /* the single precision fill must closely reproduce the double precision results */
+  vrna_md_t             md;
+  vrna_fold_compound_t  *fc_dbl, *fc_flt;
+  char                  *seq, *sample;
+  int                   k, i, j, n;
+  double                mfe, g_dbl, g_flt, p_max;
+
+  for (k = 0; k < 3; k++) {
+    n   = 150 + 300 * k;
+    seq = random_sequence(n, 2718 + k);
+
+    vrna_md_set_default(&md);
+    md.uniq_ML    = 1;
+    md.dangles    = (k == 1) ? 0 : 2;
+    fc_dbl        = vrna_fold_compound(seq, &md, VRNA_OPTION_DEFAULT);
+    md.pf_float   = 1;
+    fc_flt        = vrna_fold_compound(seq, &md, VRNA_OPTION_DEFAULT);
+
+    mfe = (double)vrna_mfe(fc_dbl, NULL);
+    vrna_exp_params_rescale(fc_dbl, &mfe);
+    vrna_exp_params_rescale(fc_flt, &mfe);
+
+    g_dbl = vrna_pf(fc_dbl, NULL);
+    g_flt = vrna_pf(fc_flt, NULL);
+
+    ck_assert(fabs(g_dbl - g_flt) < 1e-3);
+
+    p_max = 0.;
+    for (i = 1; i < n; i++)
+      for (j = i + 1; j <= n; j++)
+        p_max = MAX2(p_max,
+                     fabs(fc_dbl->exp_matrices->probs[fc_dbl->iindx[i] - j] -
+                          fc_flt->exp_matrices->probs[fc_flt->iindx[i] - j]));
+
+    ck_assert(p_max < 1e-4);
+
+    /* stochastic backtracking uses the widened matrices */
+    sample = vrna_pbacktrack(fc_flt);
+    ck_assert(sample != NULL);
+    free(sample);
+
+    free(seq);
+    vrna_fold_compound_free(fc_dbl);
+    vrna_fold_compound_free(fc_flt);
+  }
+}
+
+#test test_pf_float_fallback
+{
+  /* without scaling, the partition function of a GC-rich sequence exceeds the float range */
+  const char            *seq = "GGGGCCCCGGGCGCGCCCGGGCGCGGGGCCCCGCGCGCGGGCCCGCGGGCCCCGCGGCCGCGCGGGC"
+                               "GCCCGGGGCGCGCCCCGGGCGCGGCCCCGGGGCGCCCGCGCGGGGCCCGCGGCCCGCGCGCCGGGG";
+  vrna_md_t             md;
+  vrna_fold_compound_t  *fc_dbl, *fc_flt;
+  vrna_exp_param_t      *P;
+  double                g_dbl, g_flt;
+
+  vrna_md_set_default(&md);
+  fc_dbl      = vrna_fold_compound(seq, &md, VRNA_OPTION_DEFAULT);
+  P           = vrna_exp_params(&md);
+  P->pf_scale = 1.;
+  vrna_exp_params_subst(fc_dbl, P);
+  free(P);
+
+  md.pf_float = 1;
+  fc_flt      = vrna_fold_compound(seq, &md, VRNA_OPTION_DEFAULT);
+  P           = vrna_exp_params(&md);
+  P->pf_scale = 1.;
+  vrna_exp_params_subst(fc_flt, P);
+  free(P);
+
+  g_dbl = vrna_pf(fc_dbl, NULL);
+  g_flt = vrna_pf(fc_flt, NULL);
+
+  ck_assert(fc_dbl->exp_params->pf_scale == 1.);
+  ck_assert(fc_flt->exp_params->pf_scale == 1.);
+  ck_assert(fabs(g_dbl - g_flt) < 1e-6);
+
+  vrna_fold_compound_free(fc_dbl);
+  vrna_fold_compound_free(fc_flt);
+}
+
+#test test_pf_float_storage
+{
+  /* without probabilities and sampling, the matrices remain in single precision */
+  vrna_md_t             md;
+  vrna_fold_compound_t  *fc_dbl, *fc_flt;
+  char                  *seq, *s;
+  int                   n;
+  double                mfe, g_dbl, g_flt;
+
+  n   = 400;
+  seq = random_sequence(n, 1618);
+  s   = (char *)vrna_alloc(sizeof(char) * (n + 1));
+
+  vrna_md_set_default(&md);
+  md.compute_bpp  = 0;
+  fc_dbl          = vrna_fold_compound(seq, &md, VRNA_OPTION_DEFAULT);
+  md.pf_float     = 1;
+  fc_flt          = vrna_fold_compound(seq, &md, VRNA_OPTION_DEFAULT);
+
+  mfe = (double)vrna_mfe(fc_dbl, s);
+  vrna_exp_params_rescale(fc_dbl, &mfe);
+  vrna_exp_params_rescale(fc_flt, &mfe);
+
+  g_dbl = vrna_pf(fc_dbl, NULL);
+  g_flt = vrna_pf(fc_flt, NULL);
+
+  ck_assert(fc_flt->exp_matrices->q == NULL);
+  ck_assert(fc_flt->exp_matrices->qb == NULL);
+  ck_assert(fc_flt->exp_matrices->qm == NULL);
+  ck_assert(fc_flt->exp_matrices->q_flt != NULL);
+  ck_assert(fc_flt->exp_matrices->qb_flt != NULL);
+  ck_assert(fc_flt->exp_matrices->qm_flt != NULL);
+  ck_assert(fabs(g_dbl - g_flt) < 1e-3);
+
+  /* the ensemble partition function remains available in double precision */
+  ck_assert(fabs(vrna_pr_structure(fc_dbl, s) - vrna_pr_structure(fc_flt, s)) < 1e-4);
+
+  /* repeated computations re-use the single precision storage */
+  g_flt = vrna_pf(fc_flt, NULL);
+  ck_assert(fc_flt->exp_matrices->q == NULL);
+  ck_assert(fabs(g_dbl - g_flt) < 1e-3);
+
+  /* soft constraints require the double precision recursions */
+  vrna_sc_add_up(fc_dbl, 7, -1.5, VRNA_OPTION_DEFAULT);
+  vrna_sc_add_up(fc_flt, 7, -1.5, VRNA_OPTION_DEFAULT);
+  g_dbl = vrna_pf(fc_dbl, NULL);
+  g_flt = vrna_pf(fc_flt, NULL);
+  ck_assert(fc_flt->exp_matrices->q != NULL);
+  ck_assert(fc_flt->exp_matrices->q_flt == NULL);
+  ck_assert(g_dbl == g_flt);
+
+  free(s);
+  free(seq);
+  vrna_fold_compound_free(fc_dbl);
+  vrna_fold_compound_free(fc_flt);
+}
+
+#tcase Fold_Compound_Reuse
+
+#test test_fold_compound_reset_sequence
+{
+  vrna_md_t             md;
+  vrna_fold_compound_t  *fc, *fc_fresh, *fc_reused[4];
+  char                  *seqs[12], *s, *s_fresh, *s_reused[12];
+  double                mfe, mfe_fresh, mfe_reused[12], G, G_fresh, G_reused[12];
+  int                   i, k, n, v, ok[12], aux_freed, gr_freed;
+  unsigned int          options;
+
+  /* variants: default model, limited base pair span (banded matrices), and G-quadruplexes */
+  for (v = 0; v < 3; v++) {
+    vrna_md_set_default(&md);
+    md.uniq_ML  = 1;
+    options     = VRNA_OPTION_DEFAULT;
+    if (v == 1) {
+      md.max_bp_span  = 60;
+      options         = VRNA_OPTION_BANDED;
+    } else if (v == 2) {
+      md.gquad = 1;
+    }
+
+    /* shrinking and growing sequence lengths */
+    for (i = 0; i < 12; i++) {
+      n       = 40 + ((i * 97 + 31 * v) % 180);
+      seqs[i] = random_sequence(n, 3301 + 17 * v + i);
+      if (v == 2)
+        memcpy(seqs[i] + n / 3, "GGGAGGGAGGGAGGG", 15);
+    }
+
+    /* serial reference, a new fold compound for each sequence */
+    fc = vrna_fold_compound(seqs[0], &md, options);
+    /* soft constraints must not survive the re-targeting */
+    vrna_sc_add_up(fc, 5, -2.5, VRNA_OPTION_DEFAULT);
+    /* neither must grammar extensions and user data of the previous sequence */
+    aux_freed = gr_freed = 0;
+    vrna_fold_compound_add_auxdata(fc, &aux_freed, &count_free_calls);
+    vrna_gr_set_data(fc, &gr_freed, &count_free_calls);
+
+    for (i = 0; i < 12; i++) {
+      fc_fresh  = vrna_fold_compound(seqs[i], &md, options);
+      s_fresh   = (char *)vrna_alloc(sizeof(char) * (strlen(seqs[i]) + 1));
+      mfe_fresh = (double)vrna_mfe(fc_fresh, s_fresh);
+      vrna_exp_params_rescale(fc_fresh, &mfe_fresh);
+      G_fresh = (double)vrna_pf(fc_fresh, NULL);
+
+      /* the same fold compound, re-targeted to each sequence in turn */
+      if (i > 0) {
+        ck_assert_int_eq(vrna_fold_compound_reset_sequence(fc, seqs[i]), 1);
+        ck_assert(fc->sc == NULL);
+        ck_assert(fc->aux_grammar == NULL);
+        ck_assert(fc->auxdata == NULL);
+        ck_assert(fc->free_auxdata == NULL);
+        ck_assert_int_eq(aux_freed, 1);
+        ck_assert_int_eq(gr_freed, 1);
+      }
+
+      ck_assert_int_eq(fc->length, strlen(seqs[i]));
+
+      s   = (char *)vrna_alloc(sizeof(char) * (strlen(seqs[i]) + 1));
+      mfe = (double)vrna_mfe(fc, s);
+      vrna_exp_params_rescale(fc, &mfe);
+      G = (double)vrna_pf(fc, NULL);
+
+      if (i > 0) {
+        ck_assert_str_eq(s, s_fresh);
+        ck_assert(mfe == mfe_fresh);
+        ck_assert(fabs(G - G_fresh) < 1e-9);
+      }
+
+      free(s);
+      free(s_fresh);
+      vrna_fold_compound_free(fc_fresh);
+    }
+
+    vrna_fold_compound_free(fc);
+
+    /* one fold compound per thread, re-used for all sequences processed by that thread */
+    for (k = 0; k < 4; k++)
+      fc_reused[k] = vrna_fold_compound(seqs[k], &md, options);
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 1) num_threads(4)
+#endif
+    for (i = 0; i < 12; i++) {
+      int                   t = 0;
+      double                e;
+      vrna_fold_compound_t  *f;
+
+#ifdef _OPENMP
+      t = omp_get_thread_num();
+#endif
+      f           = fc_reused[t];
+      ok[i]       = vrna_fold_compound_reset_sequence(f, seqs[i]);
+      s_reused[i] = (char *)vrna_alloc(sizeof(char) * (strlen(seqs[i]) + 1));
+      e           = (double)vrna_mfe(f, s_reused[i]);
+      vrna_exp_params_rescale(f, &e);
+      mfe_reused[i] = e;
+      G_reused[i]   = (double)vrna_pf(f, NULL);
+    }
+
+    for (i = 0; i < 12; i++) {
+      fc_fresh  = vrna_fold_compound(seqs[i], &md, options);
+      s_fresh   = (char *)vrna_alloc(sizeof(char) * (strlen(seqs[i]) + 1));
+      mfe_fresh = (double)vrna_mfe(fc_fresh, s_fresh);
+      vrna_exp_params_rescale(fc_fresh, &mfe_fresh);
+      G_fresh = (double)vrna_pf(fc_fresh, NULL);
+
+      ck_assert_int_eq(ok[i], 1);
+      ck_assert_str_eq(s_reused[i], s_fresh);
+      ck_assert(mfe_reused[i] == mfe_fresh);
+      ck_assert(fabs(G_reused[i] - G_fresh) < 1e-9);
+
+      free(s_fresh);
+      free(s_reused[i]);
+      vrna_fold_compound_free(fc_fresh);
+    }
+
+    for (k = 0; k < 4; k++)
+      vrna_fold_compound_free(fc_reused[k]);
+
+    for (i = 0; i < 12; i++)
+      free(seqs[i]);
+  }
+}
+
 #tcase Stochastic_Backtracking
 
 #test test_sample_structure
@@ -55,6 +1010,741 @@
   vrna_fold_compound_free(vc);
 }
 
+#test test_sample_parallel
+{
+  /* the same seed and number of threads must always yield the same samples */
+  vrna_md_t             md;
+  vrna_fold_compound_t  *fc;
+  struct sample_list    s1, s2;
+  char                  *seq;
+  unsigned int          i, num;
+  int                   n;
+  float                 en;
+
+  n   = 150;
+  seq = random_sequence(n, 1337);
+
+  vrna_md_set_default(&md);
+  md.uniq_ML      = 1;
+  md.compute_bpp  = 0;
+  md.num_threads  = 4;
+
+  fc = vrna_fold_compound(seq, &md, VRNA_OPTION_PF);
+  vrna_pf(fc, NULL);
+
+  memset(&s1, 0, sizeof(struct sample_list));
+  memset(&s2, 0, sizeof(struct sample_list));
+
+  num = vrna_pbacktrack5_parallel_cb(fc, 500, n, 42, &collect_sample, (void *)&s1,
+                                     VRNA_PBACKTRACK_DEFAULT);
+  ck_assert_int_eq(num, 500);
+  ck_assert_int_eq(s1.num, 500);
+
+  num = vrna_pbacktrack5_parallel_cb(fc, 500, n, 42, &collect_sample, (void *)&s2,
+                                     VRNA_PBACKTRACK_DEFAULT);
+  ck_assert_int_eq(num, 500);
+  ck_assert_int_eq(s2.num, 500);
+
+  for (i = 0; i < s1.num; i++) {
+    ck_assert_str_eq(s1.structure[i], s2.structure[i]);
+    ck_assert_int_eq(strlen(s1.structure[i]), n);
+
+    en = vrna_eval_structure(fc, s1.structure[i]);
+    ck_assert(isfinite(en));
+    ck_assert(en < (float)(INF / 100.));
+
+    free(s1.structure[i]);
+    free(s2.structure[i]);
+  }
+
+  free(s1.structure);
+  free(s2.structure);
+  free(seq);
+  vrna_fold_compound_free(fc);
+}
+
+#tcase Heat_Capacity
+
+#test test_heat_capacity_lanes
+{
+  /* temperature lanes must reproduce the heat capacities of one partition function per temperature */
+  vrna_md_t             md;
+  vrna_fold_compound_t  *fc_lanes, *fc_seq;
+  vrna_heat_capacity_t  *hc_lanes, *hc_seq;
+  char                  *seq;
+  int                   k, i, n;
+
+  for (k = 0; k < 3; k++) {
+    n   = 80 + 60 * k;
+    seq = random_sequence(n, 4711 + k);
+
+    vrna_md_set_default(&md);
+    md.dangles      = (k == 1) ? 0 : 2;
+    md.num_threads  = (k == 2) ? 2 : 1;
+    fc_lanes        = vrna_fold_compound(seq, &md, VRNA_OPTION_DEFAULT);
+    md.num_threads  = 1;
+    fc_seq          = vrna_fold_compound(seq, &md, VRNA_OPTION_DEFAULT);
+
+    /* (empty) soft constraints prevent the use of temperature lanes */
+    vrna_sc_init(fc_seq);
+
+    if (k == 1) {
+      vrna_hc_add_bp(fc_lanes, 10, 40, VRNA_CONSTRAINT_CONTEXT_ALL_LOOPS | VRNA_CONSTRAINT_CONTEXT_ENFORCE);
+      vrna_hc_add_bp(fc_seq, 10, 40, VRNA_CONSTRAINT_CONTEXT_ALL_LOOPS | VRNA_CONSTRAINT_CONTEXT_ENFORCE);
+    }
+
+    hc_lanes  = vrna_heat_capacity(fc_lanes, 10., 90., 2., 2);
+    hc_seq    = vrna_heat_capacity(fc_seq, 10., 90., 2., 2);
+
+    ck_assert(hc_lanes != NULL);
+    ck_assert(hc_seq != NULL);
+
+    for (i = 0; hc_seq[i].temperature >= 10.; i++) {
+      ck_assert(hc_lanes[i].temperature == hc_seq[i].temperature);
+      ck_assert(fabs(hc_lanes[i].heat_capacity - hc_seq[i].heat_capacity) < 1e-2);
+    }
+
+    ck_assert_int_eq(i, 41);
+    ck_assert(hc_lanes[i].temperature < 10.);
+
+    free(hc_lanes);
+    free(hc_seq);
+    free(seq);
+    vrna_fold_compound_free(fc_lanes);
+    vrna_fold_compound_free(fc_seq);
+  }
+}
+
+#suite  Suboptimal_Structures
+
+#tcase  Parallel_Enumeration
+
+#test test_subopt_parallel
+{
+  vrna_md_t             md;
+  vrna_fold_compound_t  *fc;
+  SOLUTION              *serial, *sol;
+  struct subopt_list    parallel;
+  char                  *seq;
+  unsigned int          i, num;
+  int                   v, sorted;
+
+  /* variants: plain, re-evaluation for dangles = 1, and logML */
+  for (v = 0; v < 3; v++) {
+    seq = random_sequence(70, 1201 + v);
+
+    vrna_md_set_default(&md);
+    md.uniq_ML  = 1;
+    md.dangles  = (v == 1) ? 1 : 2;
+    md.logML    = (v == 2) ? 1 : 0;
+
+    md.num_threads  = 1;
+    fc              = vrna_fold_compound(seq, &md, VRNA_OPTION_MFE);
+    serial          = vrna_subopt(fc, 400, 1, NULL);
+    vrna_fold_compound_free(fc);
+
+    for (num = 0, sol = serial; sol->structure; sol++)
+      num++;
+
+    ck_assert(num > 10);
+
+    for (sorted = 0; sorted < 2; sorted++) {
+      /* the concurrent enumeration reports the same structures, in sorted order if requested */
+      subopt_sorted   = sorted;
+      md.num_threads  = 4;
+      fc              = vrna_fold_compound(seq, &md, VRNA_OPTION_MFE);
+      parallel.num    = 0;
+      parallel.size   = 0;
+      parallel.sol    = NULL;
+      vrna_subopt_cb(fc, 400, &collect_subopt, (void *)&parallel);
+      vrna_fold_compound_free(fc);
+      subopt_sorted = 0;
+
+      ck_assert_int_eq(parallel.num, num);
+
+      if (!sorted)
+        qsort(parallel.sol, parallel.num, sizeof(SOLUTION), &compare_subopt);
+
+      for (i = 0; i < num; i++) {
+        ck_assert_str_eq(parallel.sol[i].structure, serial[i].structure);
+        ck_assert(parallel.sol[i].energy == serial[i].energy);
+        free(parallel.sol[i].structure);
+      }
+
+      free(parallel.sol);
+    }
+
+    for (i = 0; i < num; i++)
+      free(serial[i].structure);
+
+    free(serial);
+    free(seq);
+  }
+}
+
+#suite  Local_Folding
+
+#tcase  Chunked_Scan
+
+#test test_window_chunked
+{
+  /* the chunked scan must reproduce the serial sliding window scan exactly, chunk boundaries included */
+  vrna_md_t             md;
+  vrna_fold_compound_t  *fc;
+  struct window_hits    hits1, hits4;
+  struct window_probs   probs1, probs4;
+  char                  *seq;
+  unsigned int          i;
+  float                 mfe1, mfe4;
+
+  /* three chunks of the MFE scan (8192 nt each) */
+  seq = random_sequence(25000, 4711);
+
+  vrna_md_set_default(&md);
+  md.window_size  = 100;
+  md.max_bp_span  = 100;
+
+  memset(&hits1, 0, sizeof(struct window_hits));
+  memset(&hits4, 0, sizeof(struct window_hits));
+
+  md.num_threads  = 1;
+  fc              = vrna_fold_compound(seq, &md, VRNA_OPTION_MFE | VRNA_OPTION_WINDOW);
+  mfe1            = vrna_mfe_window_cb(fc, &collect_window_hit, (void *)&hits1);
+  vrna_fold_compound_free(fc);
+
+  md.num_threads  = 4;
+  fc              = vrna_fold_compound(seq, &md, VRNA_OPTION_MFE | VRNA_OPTION_WINDOW);
+  mfe4            = vrna_mfe_window_cb(fc, &collect_window_hit, (void *)&hits4);
+  vrna_fold_compound_free(fc);
+
+  ck_assert(mfe1 == mfe4);
+  ck_assert(hits1.num > 100);
+  ck_assert_int_eq(hits4.num, hits1.num);
+
+  for (i = 0; i < hits1.num; i++)
+    ck_assert_str_eq(hits4.hit[i], hits1.hit[i]);
+
+  free_window_hits(&hits1);
+  free_window_hits(&hits4);
+
+  /* three chunks of the probability scan (3808 nt each) */
+  seq[12000] = '\0';
+
+  memset(&probs1, 0, sizeof(struct window_probs));
+  memset(&probs4, 0, sizeof(struct window_probs));
+
+  md.num_threads  = 1;
+  fc              = vrna_fold_compound(seq, &md, VRNA_OPTION_PF | VRNA_OPTION_WINDOW);
+  ck_assert(vrna_probs_window(fc, 10, VRNA_PROBS_WINDOW_BPP | VRNA_PROBS_WINDOW_UP,
+                              &hash_window_probs, (void *)&probs1));
+  vrna_fold_compound_free(fc);
+
+  md.num_threads  = 4;
+  fc              = vrna_fold_compound(seq, &md, VRNA_OPTION_PF | VRNA_OPTION_WINDOW);
+  ck_assert(vrna_probs_window(fc, 10, VRNA_PROBS_WINDOW_BPP | VRNA_PROBS_WINDOW_UP,
+                              &hash_window_probs, (void *)&probs4));
+  vrna_fold_compound_free(fc);
+
+  ck_assert_int_eq(probs1.num, 2 * 12000);
+  ck_assert_int_eq(probs4.num, probs1.num);
+  ck_assert(probs4.hash == probs1.hash);
+
+  free(seq);
+}
+
+#tcase  Streaming
+
+#test test_window_stream
+{
+  /* streaming scans must reproduce the scans of the entire sequence */
+  vrna_md_t               md;
+  vrna_fold_compound_t    *fc;
+  struct window_hits      hits, hits_s;
+  struct window_probs     probs, probs_s;
+  struct sequence_stream  stream;
+  char                    *seq;
+  unsigned int            i;
+  int                     t;
+  float                   mfe, mfe_s;
+
+  seq = random_sequence(25000, 815);
+
+  vrna_md_set_default(&md);
+  md.window_size  = 100;
+  md.max_bp_span  = 100;
+  md.num_threads  = 1;
+
+  memset(&hits, 0, sizeof(struct window_hits));
+  fc  = vrna_fold_compound(seq, &md, VRNA_OPTION_MFE | VRNA_OPTION_WINDOW);
+  mfe = vrna_mfe_window_cb(fc, &collect_window_hit, (void *)&hits);
+  vrna_fold_compound_free(fc);
+
+  /* hits are reported block-wise, so we compare them as sets */
+  qsort(hits.hit, hits.num, sizeof(char *), &compare_hits);
+
+  for (t = 1; t <= 4; t += 3) {
+    md.num_threads  = t;
+    stream.sequence = seq;
+    stream.position = 0;
+    stream.piece    = 97;
+
+    memset(&hits_s, 0, sizeof(struct window_hits));
+    mfe_s = vrna_mfe_window_stream(&md,
+                                   &read_sequence_piece,
+                                   (void *)&stream,
+                                   &collect_window_hit,
+                                   (void *)&hits_s);
+
+    ck_assert(mfe_s == mfe);
+    ck_assert_int_eq(hits_s.num, hits.num);
+
+    qsort(hits_s.hit, hits_s.num, sizeof(char *), &compare_hits);
+    for (i = 0; i < hits.num; i++)
+      ck_assert_str_eq(hits_s.hit[i], hits.hit[i]);
+
+    free_window_hits(&hits_s);
+  }
+
+  free_window_hits(&hits);
+
+  seq[12000]      = '\0';
+  md.num_threads  = 1;
+
+  memset(&probs, 0, sizeof(struct window_probs));
+  fc = vrna_fold_compound(seq, &md, VRNA_OPTION_PF | VRNA_OPTION_WINDOW);
+  ck_assert(vrna_probs_window(fc, 10, VRNA_PROBS_WINDOW_BPP | VRNA_PROBS_WINDOW_UP,
+                              &hash_window_probs, (void *)&probs));
+  vrna_fold_compound_free(fc);
+
+  /* probabilities are reported in the same order */
+  for (t = 1; t <= 4; t += 3) {
+    md.num_threads  = t;
+    stream.sequence = seq;
+    stream.position = 0;
+    stream.piece    = 97;
+
+    memset(&probs_s, 0, sizeof(struct window_probs));
+    ck_assert(vrna_probs_window_stream(&md,
+                                       10,
+                                       VRNA_PROBS_WINDOW_BPP | VRNA_PROBS_WINDOW_UP,
+                                       &read_sequence_piece,
+                                       (void *)&stream,
+                                       &hash_window_probs,
+                                       (void *)&probs_s));
+
+    ck_assert_int_eq(probs_s.num, probs.num);
+    ck_assert(probs_s.hash == probs.hash);
+  }
+
+  free(seq);
+}
+
+#suite  Cotranscriptional_Folding
+
+#tcase  Prefixes
+
+#test test_cotrans_prefixes
+{
+  /* every prefix must yield the same results as a new fold compound for the prefix */
+  vrna_md_t             md;
+  vrna_fold_compound_t  *fc;
+  vrna_cotrans_t        *ct;
+  vrna_ep_t             *pl, *ptr;
+  char                  *seq, *prefix, *s1, *s2;
+  int                   v, i, j, m, n, num, ref;
+  float                 mfe, mfe_ct;
+  double                g, g_ct, p;
+
+  for (v = 0; v < 2; v++) {
+    n       = 300;
+    seq     = random_sequence(n, 3001 + v);
+    prefix  = (char *)vrna_alloc(sizeof(char) * (n + 1));
+    s1      = (char *)vrna_alloc(sizeof(char) * (n + 1));
+    s2      = (char *)vrna_alloc(sizeof(char) * (n + 1));
+
+    vrna_md_set_default(&md);
+    md.dangles = (v == 1) ? 0 : 2;
+
+    ct = vrna_cotrans_init(NULL, &md, VRNA_OPTION_MFE | VRNA_OPTION_PF);
+    ck_assert(ct != NULL);
+
+    for (m = 25; m <= n; m += 25) {
+      /* elongate the sequence in pieces of varying length */
+      strncpy(prefix, seq, m);
+      prefix[m] = '\0';
+      ck_assert_int_eq(vrna_cotrans_append(ct, prefix + vrna_cotrans_length(ct)), m);
+
+      md.compute_bpp  = 1;
+      fc              = vrna_fold_compound(prefix, &md, VRNA_OPTION_DEFAULT);
+      mfe             = vrna_mfe(fc, s1);
+      g               = (double)mfe;
+      vrna_exp_params_rescale(fc, &g);
+      g = vrna_pf(fc, NULL);
+
+      /* MFE structures may differ among degenerate ones, so we compare their energies */
+      mfe_ct = vrna_cotrans_mfe(ct, m, s2);
+      ck_assert(mfe_ct == mfe);
+      ck_assert(vrna_eval_structure(fc, s2) == mfe);
+
+      /* vrna_pf() returns single precision */
+      g_ct = vrna_cotrans_pf(ct, m);
+      ck_assert(fabs(g_ct - g) < 1e-4);
+
+      pl = vrna_cotrans_bpp(ct, m, 1e-4);
+      ck_assert(pl != NULL);
+
+      for (num = 0, ptr = pl; ptr->i; ptr++, num++) {
+        p = fc->exp_matrices->probs[fc->iindx[ptr->i] - ptr->j];
+        ck_assert(fabs(ptr->p - p) < 1e-6);
+      }
+
+      /* no pair above the cut-off must be missing */
+      for (ref = 0, i = 1; i < m; i++)
+        for (j = i + 1; j <= m; j++)
+          if (fc->exp_matrices->probs[fc->iindx[i] - j] >= 1e-4 + 1e-6)
+            ref++;
+
+      ck_assert(ref <= num);
+
+      free(pl);
+      vrna_fold_compound_free(fc);
+    }
+
+    vrna_cotrans_free(ct);
+    free(seq);
+    free(prefix);
+    free(s1);
+    free(s2);
+  }
+}
+
+#test test_cotrans_scaling
+{
+  /* the scaling must adapt to the actual prefixes of long, GC-rich sequences */
+  vrna_md_t             md;
+  vrna_fold_compound_t  *fc;
+  vrna_cotrans_t        *ct;
+  vrna_ep_t             *pl, *ptr;
+  char                  *seq;
+  int                   i, n;
+  double                mfe, g, g_ct;
+
+  n   = 1400;
+  seq = random_sequence(n, 7);
+  for (i = 0; i < n; i++)
+    if (seq[i] == 'A')
+      seq[i] = (i % 2) ? 'G' : 'C';
+
+  vrna_md_set_default(&md);
+  ct = vrna_cotrans_init(seq, &md, VRNA_OPTION_PF);
+
+  g_ct = vrna_cotrans_pf(ct, n);
+  ck_assert(isfinite(g_ct));
+
+  fc  = vrna_fold_compound(seq, &md, VRNA_OPTION_DEFAULT);
+  mfe = (double)vrna_mfe(fc, NULL);
+  vrna_exp_params_rescale(fc, &mfe);
+  g = vrna_pf(fc, NULL);
+
+  ck_assert(fabs(g_ct - g) < 1e-3);
+
+  pl = vrna_cotrans_bpp(ct, n, 1e-3);
+  ck_assert(pl != NULL);
+  ck_assert(pl->i != 0);
+
+  for (ptr = pl; ptr->i; ptr++)
+    ck_assert((ptr->p >= 1e-3) && (ptr->p <= 1.));
+
+  free(pl);
+  free(seq);
+  vrna_fold_compound_free(fc);
+  vrna_cotrans_free(ct);
+}
+
+#test test_cotrans_models
+{
+  /* all model settings but circular RNAs must yield the results of vrna_mfe() and vrna_pf() */
+  vrna_md_t             md;
+  vrna_fold_compound_t  *fc;
+  vrna_cotrans_t        *ct;
+  char                  *seq, *prefix, *s1, *s2;
+  int                   v, m, n;
+  float                 mfe;
+  double                g;
+
+  vrna_md_set_default(&md);
+  md.circ = 1;
+  ck_assert(vrna_cotrans_init("GGGGAAAACCCC", &md, VRNA_OPTION_MFE) == NULL);
+
+  n = 150;
+
+  for (v = 0; v < 5; v++) {
+    seq     = random_sequence(n, 4001 + v);
+    prefix  = (char *)vrna_alloc(sizeof(char) * (n + 1));
+    s1      = (char *)vrna_alloc(sizeof(char) * (n + 1));
+    s2      = (char *)vrna_alloc(sizeof(char) * (n + 1));
+
+    vrna_md_set_default(&md);
+    switch (v) {
+      case 0:
+        md.dangles = 1;
+        break;
+      case 1:
+        md.dangles = 3;
+        break;
+      case 2:
+        md.gquad = 1;
+        memcpy(seq + 40, "GGGAGGGAGGGAGGG", 15);
+        break;
+      case 3:
+        md.noLP = 1;
+        break;
+      case 4:
+        md.noGUclosure = 1;
+        break;
+    }
+
+    ct = vrna_cotrans_init(NULL, &md, VRNA_OPTION_MFE | VRNA_OPTION_PF);
+    ck_assert(ct != NULL);
+
+    /* elongate nucleotide-wise */
+    for (m = 1; m <= n; m++) {
+      strncpy(prefix, seq, m);
+      prefix[m] = '\0';
+      ck_assert_int_eq(vrna_cotrans_append(ct, prefix + m - 1), m);
+    }
+
+    /* query prefixes after the sequence is complete */
+    for (m = 30; m <= n; m += 30) {
+      strncpy(prefix, seq, m);
+      prefix[m] = '\0';
+
+      md.compute_bpp  = 1;
+      fc              = vrna_fold_compound(prefix, &md, VRNA_OPTION_DEFAULT);
+      mfe             = vrna_mfe(fc, s1);
+      g               = (double)mfe;
+      vrna_exp_params_rescale(fc, &g);
+      g = vrna_pf(fc, NULL);
+
+      ck_assert(vrna_cotrans_mfe(ct, m, s2) == mfe);
+      ck_assert_int_eq(strlen(s2), m);
+      ck_assert(vrna_eval_structure(fc, s2) == mfe);
+      ck_assert(fabs(vrna_cotrans_pf(ct, m) - g) < 1e-4);
+
+      vrna_fold_compound_free(fc);
+    }
+
+    vrna_cotrans_free(ct);
+    free(seq);
+    free(prefix);
+    free(s1);
+    free(s2);
+  }
+}
+
+#suite  Duplex_Folding
+
+#tcase  Backward_Compatibility
+
+#test test_duplexfold_context
+{
+  /* the context based interface must reproduce the legacy functions */
+  vrna_md_t             md;
+  vrna_duplex_context_t ctx;
+  duplexT               d, d_old, *sub, *sub_old;
+  const char            *s1, *s2;
+  int                   i;
+
+  s1  = "GCAUCGAUCGAUGCUAGCUAGCUAGGGAUCGAUCGUAGCUAGCUAGCUAGCGAUCGAUCGAUCGUAGCUAGCUAGCUAGCUGAUCG";
+  s2  = "CGAUCGAUCGCUAGCUAGC";
+
+  set_model_details(&md);
+  ctx = vrna_duplex_context_init(&md);
+  ck_assert(ctx != NULL);
+
+  d     = vrna_duplexfold(ctx, s1, s2);
+  d_old = duplexfold(s1, s2);
+
+  ck_assert_str_eq(d.structure, ".(((((((((((((((((((.&)))))))))))))))))))");
+  ck_assert_str_eq(d.structure, d_old.structure);
+  ck_assert(fabs(d.energy - (-37.40)) < 1e-4);
+  ck_assert(d.energy == d_old.energy);
+  ck_assert_int_eq(d.i, 61);
+  ck_assert_int_eq(d.j, 1);
+  ck_assert_int_eq(d.i, d_old.i);
+  ck_assert_int_eq(d.j, d_old.j);
+
+  free(d.structure);
+  free(d_old.structure);
+
+  sub     = vrna_duplex_subopt(ctx, s1, s2, 300, 5);
+  sub_old = duplex_subopt(s1, s2, 300, 5);
+
+  ck_assert(sub != NULL);
+  ck_assert(sub_old != NULL);
+
+  for (i = 0; sub[i].structure && sub_old[i].structure; i++) {
+    ck_assert_str_eq(sub[i].structure, sub_old[i].structure);
+    ck_assert(sub[i].energy == sub_old[i].energy);
+    ck_assert_int_eq(sub[i].i, sub_old[i].i);
+    ck_assert_int_eq(sub[i].j, sub_old[i].j);
+  }
+
+  ck_assert(i > 0);
+  ck_assert(sub[i].structure == NULL);
+  ck_assert(sub_old[i].structure == NULL);
+
+  for (i = 0; sub[i].structure; i++)
+    free(sub[i].structure);
+
+  for (i = 0; sub_old[i].structure; i++)
+    free(sub_old[i].structure);
+
+  free(sub);
+  free(sub_old);
+  vrna_duplex_context_free(ctx);
+}
+
+#test test_Lduplexfold_context
+{
+  /* the hits collected in a char stream must equal what the legacy function prints */
+  vrna_md_t           md;
+  vrna_plex_context_t ctx;
+  vrna_cstr_t         out;
+  FILE                *tmp;
+  char                *hits, *hits_old;
+  const char          *s1, *s2;
+  int                 fast, fd;
+
+  /* both sequences are padded with N, just like RNAplex does to avoid boundary checks */
+  s1 = "NNNNNNNNNN"
+       "AUGCUAGCUAGCAUCGAUCGAUUAGCGCGAUAUAUCGAUCGAUCGGCUAGCUAGCUAGCUAGUCGAUCGAUGCAUGCUAGCUAGC"
+       "UAGCGAUCGAUCGAUCGUAGCUAGCUAGCUAGCUGAUCGAUUAGCGCGAUAUAUCGAUCGGCUAGCUAGCUAUUAGCGCGAUAUA"
+       "UCGAUGCUAGCUAGCUAGCUAUCG"
+       "NNNNNNNNNN";
+  s2 = "NNNNNNNNNNCGAUCGAUCGCUAGCUAGCNNNNNNNNNN";
+
+  set_model_details(&md);
+  ctx = vrna_plex_context_init(&md);
+  ck_assert(ctx != NULL);
+
+  for (fast = 0; fast <= 1; fast++) {
+    tmp = tmpfile();
+    ck_assert(tmp != NULL);
+    out = vrna_cstr(1024, tmp);
+    ck_assert_int_eq(vrna_Lduplexfold(ctx, out, s1, s2, -1000, 0, 40, 10, fast, 10, 220, 20, 300), 1);
+    vrna_cstr_fflush(out);
+    hits = read_stream(tmp);
+    vrna_cstr_close(out);
+
+    /* Lduplexfold() prints to stdout, so temporarily redirect it */
+    tmp = tmpfile();
+    ck_assert(tmp != NULL);
+    (void)fflush(stdout);
+    fd = dup(fileno(stdout));
+    (void)dup2(fileno(tmp), fileno(stdout));
+
+    ck_assert(Lduplexfold(s1, s2, -1000, 0, 40, 10, fast, 10, 220, 20, 300) == NULL);
+
+    (void)fflush(stdout);
+    (void)dup2(fd, fileno(stdout));
+    close(fd);
+
+    hits_old = read_stream(tmp);
+    fclose(tmp);
+
+    /* the fast mode only reports the boundaries of the hits */
+    if (fast)
+      ck_assert(strstr(hits, "target upper bound 98: query lower bound 1 (-38.20)") != NULL);
+    else
+      ck_assert(strstr(hits, " 79,99  :   1,19  (-37.40)") != NULL);
+
+    ck_assert_str_eq(hits, hits_old);
+
+    free(hits);
+    free(hits_old);
+  }
+
+  vrna_plex_context_free(ctx);
+}
+
+#suite  Interaction_Accessibility
+
+#tcase  Backward_Compatibility
+
+#test test_pf_unstru_interact_context
+{
+  /* the fold compound based interface must reproduce the legacy functions */
+  vrna_md_t   md;
+  pu_contrib  *pu1, *pu2, *pu1_old, *pu2_old;
+  interact    *in, *in_old;
+  const char  *s1, *s2;
+  double      scale;
+  int         i, u, w;
+
+  s1  = "GGAGUAGUUGGCAUCGAUCGAUCGAUGCUAGCUAGCUAGGCUAGCAUCGAUCGAUGCUGAUCGAUCGAUAUAUAUGCGAUCGAUCG";
+  s2  = "GCUAGCUAGCUAGCCAUCG";
+  w   = 20;
+
+  /* both interfaces need base pair probabilities */
+  do_backtrack = 1;
+  set_model_details(&md);
+
+  pu1_old = unpaired_probs_legacy(s1, &md, w);
+  pu2_old = unpaired_probs_legacy(s2, &md, w);
+
+  /* pf_interact() temporarily replaces the global scaling factor by its own */
+  pf_scale  = 1.5;
+  scale     = pf_scale;
+  in_old    = pf_interact(s1, s2, pu1_old, pu2_old, w, NULL, 0, 0);
+
+  /* the temporary interaction scaling must not leak into the global setting */
+  ck_assert(pf_scale == scale);
+
+  pu1 = unpaired_probs(s1, &md, w);
+  pu2 = unpaired_probs(s2, &md, w);
+  ck_assert(pu1 != NULL);
+  ck_assert(pu2 != NULL);
+
+  ck_assert_int_eq(pu1->length, pu1_old->length);
+  ck_assert_int_eq(pu1->w, pu1_old->w);
+
+  for (i = 1; i <= pu1->length; i++)
+    for (u = 0; u < w; u++) {
+      ck_assert(fabs(pu1->H[i][u] - pu1_old->H[i][u]) < 1e-10);
+      ck_assert(fabs(pu1->I[i][u] - pu1_old->I[i][u]) < 1e-10);
+      ck_assert(fabs(pu1->M[i][u] - pu1_old->M[i][u]) < 1e-10);
+      ck_assert(fabs(pu1->E[i][u] - pu1_old->E[i][u]) < 1e-10);
+    }
+
+  in = vrna_pf_interact(s1, s2, pu1, pu2, w, NULL, 0, 0, &md);
+  ck_assert(in != NULL);
+
+  /* the reentrant variants leave the global scaling factor alone */
+  ck_assert(pf_scale == scale);
+
+  ck_assert_int_eq(in->length, in_old->length);
+  ck_assert_int_eq(in->i, in_old->i);
+  ck_assert_int_eq(in->k, in_old->k);
+  ck_assert_int_eq(in->j, in_old->j);
+  ck_assert_int_eq(in->l, in_old->l);
+  ck_assert(fabs(in->Gikjl - in_old->Gikjl) < 1e-8);
+  ck_assert(fabs(in->Gikjl_wo - in_old->Gikjl_wo) < 1e-8);
+
+  for (i = 1; i <= in->length; i++) {
+    ck_assert(fabs(in->Pi[i] - in_old->Pi[i]) < 1e-10);
+    ck_assert(fabs(in->Gi[i] - in_old->Gi[i]) < 1e-8);
+  }
+
+  free_interact(in);
+  free_interact(in_old);
+  free_pu_contrib(pu1);
+  free_pu_contrib(pu2);
+  free_pu_contrib(pu1_old);
+  free_pu_contrib(pu2_old);
+  pf_scale = -1;
+}
+
 #suite  Constraints_Implementation
 
 #tcase  Soft_Constraints
@@ -3,6 +3,16 @@
 #include <ViennaRNA/model.h>
 #include <ViennaRNA/utils/basic.h>
 #include <ViennaRNA/alphabet.h>
+#include <ViennaRNA/utils/higher_order_functions.h>
+
+#define ZIP_KERNEL_MAX_COUNT  130
+
+static unsigned int
+zip_kernel_rand(unsigned int *state)
+{
+  *state = *state * 1103515245u + 12345u;
+  return (*state >> 8) & 0xffff;
+}
 
 #suite Utilities
 
@@ -205,3 +215,111 @@
 //@TODO: extend alphabeth
 //@TODO: details.noLP = 1
 //@TODO: idx_type = 1
+
+#tcase Higher_Order_Functions
+
+#test test_vrna_fun_zip_kernels
+{
+  /*
+   *  The SIMD kernels selected at runtime must reproduce the results
+   *  of the default implementations bitwise, in particular for counts
+   *  that are not a multiple of the vector width, for unaligned memory,
+   *  and for INF entries in the (int) minimization kernels
+   */
+  unsigned int  state = 1;
+  int           i, count, offset, res_int[2][2];
+  int           *a, *b, *c;
+  FLT_OR_DBL    *x, *y, res_dbl[2][2];
+  float         *fx, *fy, res_flt[2][2];
+  const int     n = ZIP_KERNEL_MAX_COUNT + 1;
+
+  a   = (int *)vrna_alloc(sizeof(int) * n);
+  b   = (int *)vrna_alloc(sizeof(int) * n);
+  c   = (int *)vrna_alloc(sizeof(int) * n);
+  x   = (FLT_OR_DBL *)vrna_alloc(sizeof(FLT_OR_DBL) * n);
+  y   = (FLT_OR_DBL *)vrna_alloc(sizeof(FLT_OR_DBL) * n);
+  fx  = (float *)vrna_alloc(sizeof(float) * n);
+  fy  = (float *)vrna_alloc(sizeof(float) * n);
+
+  for (count = 0; count <= ZIP_KERNEL_MAX_COUNT; count++) {
+    for (offset = 0; offset < 2; offset++) {
+      if (count + offset > ZIP_KERNEL_MAX_COUNT)
+        break;
+
+      for (i = 0; i < n; i++) {
+        a[i]  = (int)zip_kernel_rand(&state) - 32768;
+        b[i]  = (int)zip_kernel_rand(&state) - 32768;
+        c[i]  = (int)zip_kernel_rand(&state) % 1000 - 500;
+        /* mask some entries with INF, and every entry in some of the rounds */
+        if ((zip_kernel_rand(&state) % 5 == 0) || (count % 7 == 3))
+          a[i] = INF;
+
+        if (zip_kernel_rand(&state) % 7 == 0)
+          b[i] = INF;
+
+        if (zip_kernel_rand(&state) % 11 == 0)
+          c[i] = INF;
+
+        x[i]  = (FLT_OR_DBL)zip_kernel_rand(&state) / 65536. * 1e3;
+        y[i]  = (FLT_OR_DBL)zip_kernel_rand(&state) / 65536. * 1e-3;
+        fx[i] = (float)zip_kernel_rand(&state) / 65536.f * 1e3f;
+        fy[i] = (float)zip_kernel_rand(&state) / 65536.f * 1e-3f;
+      }
+
+      for (i = 0; i < 2; i++) {
+        if (i == 0)
+          vrna_fun_dispatch_disable();
+        else
+          vrna_fun_dispatch_enable();
+
+        res_int[i][0] = vrna_fun_zip_add_min(a + offset, b + offset, count);
+        res_int[i][1] = vrna_fun_zip3_add_min(a + offset, b + offset, c + offset, count);
+        res_dbl[i][0] = vrna_fun_zip_mul_add_sum(x + offset, y + offset, count);
+        res_dbl[i][1] = vrna_fun_zip_mul_add_sum_rev(x + offset, y + offset, count);
+        res_flt[i][0] = vrna_fun_zip_mul_add_sum_flt(fx + offset, fy + offset, count);
+        res_flt[i][1] = vrna_fun_zip_mul_add_sum_rev_flt(fx + offset, fy + offset, count);
+      }
+
+      ck_assert_msg(res_int[0][0] == res_int[1][0],
+                    "vrna_fun_zip_add_min(): %d != %d (count = %d, offset = %d)",
+                    res_int[0][0], res_int[1][0], count, offset);
+      ck_assert_msg(res_int[0][1] == res_int[1][1],
+                    "vrna_fun_zip3_add_min(): %d != %d (count = %d, offset = %d)",
+                    res_int[0][1], res_int[1][1], count, offset);
+      ck_assert_msg(res_dbl[0][0] == res_dbl[1][0],
+                    "vrna_fun_zip_mul_add_sum(): %g != %g (count = %d, offset = %d)",
+                    (double)res_dbl[0][0], (double)res_dbl[1][0], count, offset);
+      ck_assert_msg(res_dbl[0][1] == res_dbl[1][1],
+                    "vrna_fun_zip_mul_add_sum_rev(): %g != %g (count = %d, offset = %d)",
+                    (double)res_dbl[0][1], (double)res_dbl[1][1], count, offset);
+      ck_assert_msg(res_flt[0][0] == res_flt[1][0],
+                    "vrna_fun_zip_mul_add_sum_flt(): %g != %g (count = %d, offset = %d)",
+                    (double)res_flt[0][0], (double)res_flt[1][0], count, offset);
+      ck_assert_msg(res_flt[0][1] == res_flt[1][1],
+                    "vrna_fun_zip_mul_add_sum_rev_flt(): %g != %g (count = %d, offset = %d)",
+                    (double)res_flt[0][1], (double)res_flt[1][1], count, offset);
+    }
+  }
+
+  /* no valid decomposition at all */
+  for (i = 0; i < n; i++)
+    a[i] = INF;
+
+  for (i = 0; i < 2; i++) {
+    if (i == 0)
+      vrna_fun_dispatch_disable();
+    else
+      vrna_fun_dispatch_enable();
+
+    ck_assert_int_eq(vrna_fun_zip_add_min(a, b, ZIP_KERNEL_MAX_COUNT), INF);
+    ck_assert_int_eq(vrna_fun_zip3_add_min(b, c, a, ZIP_KERNEL_MAX_COUNT), INF);
+  }
+
+  free(a);
+  free(b);
+  free(c);
+  free(x);
+  free(y);
+  free(fx);
+  free(fy);
+}
@@ -1,6 +1,10 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <ViennaRNA/landscape/walk.h>
+#include <ViennaRNA/landscape/findpath.h>
+#include <ViennaRNA/subopt.h>
+#include <ViennaRNA/eval.h>
+#include <ViennaRNA/utils/basic.h>
 #include <ViennaRNA/model.h>
 #include <ViennaRNA/utils/structures.h>
 #include <ViennaRNA/data_structures.h>
@@ -48,3 +52,70 @@
   free(resultMoves);
   free(resultStructure);
 }
+
+
+#tcase Findpath_Batch
+
+#test test_findpath_saddle_batch
+{
+  const char            *sequence = "GGGCGCAAGCCUUAAGGCCAACGCGCUAUUGCGCGAGCUAAUCGCUCGAGGUCCAAAGC";
+  const char            **structures;
+  short                 *pt;
+  int                   i, j, n, E, Eub, maxE, *saddles, *saddles_ub;
+  vrna_md_t             md;
+  vrna_fold_compound_t  *fc;
+  vrna_subopt_solution_t  *sol;
+
+  vrna_md_set_default(&md);
+  md.uniq_ML      = 1;
+  md.num_threads  = 4;
+
+  fc  = vrna_fold_compound(sequence, &md, VRNA_OPTION_DEFAULT);
+  sol = vrna_subopt(fc, 300, 1, NULL);
+
+  for (n = 0; (sol[n].structure) && (n < 12); n++);
+
+  ck_assert(n > 2);
+
+  structures = (const char **)vrna_alloc(sizeof(char *) * (n + 1));
+  for (i = 0; i < n; i++)
+    structures[i] = sol[i].structure;
+
+  /* upper bound in the range of the saddle energies, such that some searches are pruned */
+  maxE        = (int)(sol[0].energy * 100.) + 150;
+  saddles     = vrna_path_findpath_saddle_batch(fc, structures, 2);
+  saddles_ub  = vrna_path_findpath_saddle_batch_ub(fc, structures, 2, maxE);
+
+  ck_assert(saddles != NULL);
+  ck_assert(saddles_ub != NULL);
+
+  for (i = 0; i < n; i++) {
+    pt  = vrna_ptable(structures[i]);
+    E   = vrna_eval_structure_pt(fc, pt);
+    free(pt);
+
+    ck_assert_int_eq(saddles[i * n + i], E);
+    ck_assert_int_eq(saddles_ub[i * n + i], MIN2(E, maxE));
+
+    for (j = i + 1; j < n; j++) {
+      /* compare against the serial search for the same pair of structures */
+      E   = vrna_path_findpath_saddle(fc, structures[i], structures[j], 2);
+      Eub = vrna_path_findpath_saddle_ub(fc, structures[i], structures[j], 2, maxE);
+
+      ck_assert_int_eq(saddles[i * n + j], E);
+      ck_assert_int_eq(saddles[j * n + i], E);
+      ck_assert_int_eq(saddles_ub[i * n + j], Eub);
+      ck_assert_int_eq(saddles_ub[j * n + i], Eub);
+    }
+  }
+
+  free(saddles);
+  free(saddles_ub);
+  free(structures);
+
+  for (i = 0; sol[i].structure; i++)
+    free(sol[i].structure);
+  free(sol);
+
+  vrna_fold_compound_free(fc);
+}